@@ -4514,6 +4514,117 @@ invalid_fs:
 GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_zerofill, 3.5.0);
 
 
+ssize_t
+pub_glfs_copy_file_range (struct glfs_fd *glfd_in, off_t *off_in,
+                          struct glfs_fd *glfd_out, off_t *off_out,
+                          size_t len, unsigned int flags,
+                          struct stat *statbuf, struct stat *prestat,
+                          struct stat *poststat)
+{
+        ssize_t           ret             = -1;
+        xlator_t         *subvol          = NULL;
+        fd_t             *fd_in           = NULL;
+        fd_t             *fd_out          = NULL;
+        struct iatt       iattbuf         = {0, };
+        struct iatt       preiatt         = {0, };
+        struct iatt       postiatt        = {0, };
+        dict_t           *fop_attr        = NULL;
+        off_t             pos_in          = 0;
+        off_t             pos_out         = 0;
+
+        DECLARE_OLD_THIS;
+        __GLFS_ENTRY_VALIDATE_FD (glfd_in, invalid_fs);
+
+        if (!glfd_out || !glfd_out->fd || glfd_out->state != GLFD_OPEN) {
+                errno = EBADF;
+                __GLFS_EXIT_FS;
+                goto invalid_fs;
+        }
+
+        /* copying between two volumes has to go through the application */
+        if (glfd_in->fs != glfd_out->fs) {
+                errno = EXDEV;
+                __GLFS_EXIT_FS;
+                goto invalid_fs;
+        }
+
+        GF_REF_GET (glfd_in);
+        GF_REF_GET (glfd_out);
+
+        subvol = glfs_active_subvol (glfd_in->fs);
+        if (!subvol) {
+                errno = EIO;
+                goto out;
+        }
+
+        fd_in = glfs_resolve_fd (glfd_in->fs, subvol, glfd_in);
+        if (!fd_in) {
+                errno = EBADFD;
+                goto out;
+        }
+
+        fd_out = glfs_resolve_fd (glfd_out->fs, subvol, glfd_out);
+        if (!fd_out) {
+                errno = EBADFD;
+                goto out;
+        }
+
+        /* like copy_file_range(2), the file offsets are used and moved when
+         * no offset is passed
+         */
+        pos_in = off_in ? *off_in : glfd_in->offset;
+        pos_out = off_out ? *off_out : glfd_out->offset;
+
+        ret = get_fop_attr_thrd_key (&fop_attr);
+        if (ret)
+                gf_msg_debug ("gfapi", 0, "Getting leaseid from thread failed");
+
+        ret = syncop_copy_file_range (subvol, fd_in, pos_in, fd_out, pos_out,
+                                      len, flags, &iattbuf, &preiatt,
+                                      &postiatt, fop_attr, NULL);
+        DECODE_SYNCOP_ERR (ret);
+
+        if (ret >= 0) {
+                if (off_in)
+                        *off_in = pos_in + ret;
+                else
+                        glfd_in->offset = pos_in + ret;
+
+                if (off_out)
+                        *off_out = pos_out + ret;
+                else
+                        glfd_out->offset = pos_out + ret;
+
+                if (statbuf)
+                        glfs_iatt_to_stat (glfd_in->fs, &iattbuf, statbuf);
+                if (prestat)
+                        glfs_iatt_to_stat (glfd_in->fs, &preiatt, prestat);
+                if (poststat)
+                        glfs_iatt_to_stat (glfd_in->fs, &postiatt, poststat);
+        }
+out:
+        if (fd_in)
+                fd_unref (fd_in);
+        if (fd_out)
+                fd_unref (fd_out);
+        if (glfd_in)
+                GF_REF_PUT (glfd_in);
+        if (glfd_out)
+                GF_REF_PUT (glfd_out);
+        if (fop_attr)
+                dict_unref (fop_attr);
+
+        glfs_subvol_done (glfd_in->fs, subvol);
+
+        __GLFS_EXIT_FS;
+
+invalid_fs:
+        return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_copy_file_range, future);
+
+
 int
 pub_glfs_chdir (struct glfs *fs, const char *path)
 {
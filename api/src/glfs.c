@@ -112,17 +112,6 @@ glusterfs_ctx_defaults_init (glusterfs_ctx_t *ctx)
 		goto err;
 	}
 
-	/* frame_mem_pool size 112 * 4k */
-	pool->frame_mem_pool = mem_pool_new (call_frame_t, 4096);
-	if (!pool->frame_mem_pool) {
-		goto err;
-	}
-	/* stack_mem_pool size 256 * 1024 */
-	pool->stack_mem_pool = mem_pool_new (call_stack_t, 1024);
-	if (!pool->stack_mem_pool) {
-		goto err;
-	}
-
 	ctx->stub_mem_pool = mem_pool_new (call_stub_t, 1024);
 	if (!ctx->stub_mem_pool) {
 		goto err;
@@ -146,20 +135,15 @@ glusterfs_ctx_defaults_init (glusterfs_ctx_t *ctx)
         if (!ctx->logbuf_pool)
                 goto err;
 
-	INIT_LIST_HEAD (&pool->all_frames);
 	INIT_LIST_HEAD (&ctx->cmd_args.xlator_options);
         INIT_LIST_HEAD (&ctx->cmd_args.volfile_servers);
 
-	LOCK_INIT (&pool->lock);
+	call_pool_init (pool);
 	ctx->pool = pool;
 
 	ret = 0;
 err:
 	if (ret && pool) {
-		if (pool->frame_mem_pool)
-			mem_pool_destroy (pool->frame_mem_pool);
-		if (pool->stack_mem_pool)
-			mem_pool_destroy (pool->stack_mem_pool);
 		GF_FREE (pool);
 	}
 
@@ -1210,11 +1194,7 @@ glusterfs_ctx_destroy (glusterfs_ctx_t *ctx)
 
         pool = ctx->pool;
         if (pool) {
-                if (pool->frame_mem_pool)
-                        mem_pool_destroy (pool->frame_mem_pool);
-                if (pool->stack_mem_pool)
-                        mem_pool_destroy (pool->stack_mem_pool);
-                LOCK_DESTROY (&pool->lock);
+                call_pool_fini (pool);
                 GF_FREE (pool);
         }
 
@@ -1280,11 +1260,13 @@ pub_glfs_fini (struct glfs *fs)
                 pthread_mutex_lock (&fs->mutex);
                 {
                         /* Do we need to increase countdown? */
-                        if ((!call_pool->cnt) && (!fs->pin_refcnt)) {
+                        if ((!GF_ATOMIC_GET (call_pool->cnt)) &&
+                            (!fs->pin_refcnt)) {
                                 gf_msg_trace ("glfs", 0,
                                         "call_pool_cnt - %"PRId64","
                                         "pin_refcnt - %d",
-                                        call_pool->cnt, fs->pin_refcnt);
+                                        GF_ATOMIC_GET (call_pool->cnt),
+                                        fs->pin_refcnt);
 
                                 ctx->cleanup_started = 1;
                                 pthread_mutex_unlock (&fs->mutex);
@@ -1299,7 +1281,7 @@ pub_glfs_fini (struct glfs *fs)
 
         /*We deem glfs_fini as successful if there are no pending frames in the call
          *pool*/
-        ret = (call_pool->cnt == 0)? 0: -1;
+        ret = (GF_ATOMIC_GET (call_pool->cnt) == 0)? 0: -1;
 
         pthread_mutex_lock (&fs->mutex);
         {
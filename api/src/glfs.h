@@ -851,6 +851,46 @@ glfs_zerofill_async (glfs_fd_t *fd, off_t length, off_t len, glfs_io_cbk fn,
                      void *data) __THROW
         GFAPI_PUBLIC(glfs_zerofill_async, future);
 
+/*
+  SYNOPSIS
+
+  glfs_copy_file_range: Copy a range of data from one file to another.
+
+  DESCRIPTION
+
+  Like copy_file_range(2), but for two files of the same volume. The copy is
+  done on the bricks, the data is not transferred to the client. When
+  @off_in or @off_out is NULL the file offset of the corresponding fd is
+  used and advanced, else the pointed to offset is advanced.
+
+  The copy may be short. A volume that can not do the copy on its bricks
+  (the two files live on different bricks, or the volume type or the brick
+  file system does not support it) fails with EXDEV or EOPNOTSUPP and the
+  caller is expected to fall back to reading and writing the data.
+
+  PARAMETERS
+
+  @glfd_in: fd of the source file, open for reading.
+  @off_in: offset in the source file, or NULL.
+  @glfd_out: fd of the destination file, open for writing.
+  @off_out: offset in the destination file, or NULL.
+  @len: number of bytes to copy.
+  @flags: reserved, must be 0.
+  @statbuf, @prestat, @poststat: if not NULL, filled with the attributes of
+  the source file, and of the destination file before and after the copy.
+
+  RETURN VALUES
+
+  >=0: the number of bytes copied.
+  -1: failure, errno is set.
+*/
+ssize_t
+glfs_copy_file_range (glfs_fd_t *glfd_in, off_t *off_in,
+                      glfs_fd_t *glfd_out, off_t *off_out, size_t len,
+                      unsigned int flags, struct stat *statbuf,
+                      struct stat *prestat, struct stat *poststat) __THROW
+        GFAPI_PUBLIC(glfs_copy_file_range, future);
+
 char*
 glfs_getcwd (glfs_t *fs, char *buf, size_t size) __THROW
         GFAPI_PUBLIC(glfs_getcwd, 3.4.0);
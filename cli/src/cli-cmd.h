@@ -62,6 +62,9 @@ struct cli_cmd_volume_get_ctx_ {
         int             flags;
 };
 
+/* p50, p90, p99 and p99.9, as sent by io-stats */
+#define CLI_PROFILE_PERCENTILE_MAX 4
+
 typedef struct cli_profile_info_ {
         uint64_t fop_hits;
         double min_latency;
@@ -69,6 +72,7 @@ typedef struct cli_profile_info_ {
         double avg_latency;
         char   *fop_name;
         double percentage_avg_latency;
+        uint64_t percentile_latency[CLI_PROFILE_PERCENTILE_MAX];
 } cli_profile_info_t;
 
 typedef struct cli_cmd_volume_get_ctx_ cli_cmd_volume_get_ctx_t;
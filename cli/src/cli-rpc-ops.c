@@ -6390,6 +6390,10 @@ cmd_profile_volume_brick_out (dict_t *dict, int count, int interval)
         int                     is_header_printed = 0;
         int                     ret = 0;
         double                  total_percentage_latency = 0;
+        int                     j = 0;
+        static const char      *percentile_names[CLI_PROFILE_PERCENTILE_MAX] = {
+                "p50", "p90", "p99", "p999"
+        };
 
         for (i = 0; i < 32; i++) {
                 memset (key, 0, sizeof (key));
@@ -6460,6 +6464,18 @@ cmd_profile_volume_brick_out (dict_t *dict, int count, int interval)
                         gf_log ("cli", GF_LOG_DEBUG,
                                 "failed to get %s from dict", key);
                 }
+
+                /* not sent by older bricks */
+                for (j = 0; j < CLI_PROFILE_PERCENTILE_MAX; j++) {
+                        snprintf (key, sizeof (key), "%d-%d-%d-%slatency",
+                                  count, interval, i, percentile_names[j]);
+                        ret = dict_get_uint64 (dict, key,
+                                        &profile_info[i].percentile_latency[j]);
+                        if (ret) {
+                                gf_log ("cli", GF_LOG_DEBUG,
+                                        "failed to get %s from dict", key);
+                        }
+                }
                 profile_info[i].fop_name = (char *)gf_fop_list[i];
 
                 total_percentage_latency +=
@@ -6586,6 +6602,30 @@ cmd_profile_volume_brick_out (dict_t *dict, int count, int interval)
                 }
         }
 
+        is_header_printed = 0;
+        for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+                if (profile_info[i].fop_hits == 0 ||
+                    profile_info[i].percentile_latency[0] == 0)
+                        continue;
+                if (is_header_printed == 0) {
+                        cli_out (" ");
+                        cli_out ("%13s %13s %13s %13s %11s", "P50-Latency",
+                                 "P90-Latency", "P99-Latency", "P99.9-Latency",
+                                 "Fop");
+                        cli_out ("%13s %13s %13s %13s %11s", "-----------",
+                                 "-----------", "-----------", "-------------",
+                                 "----");
+                        is_header_printed = 1;
+                }
+                cli_out ("%10"PRIu64" us %10"PRIu64" us %10"PRIu64" us "
+                         "%10"PRIu64" us %11s",
+                         profile_info[i].percentile_latency[0],
+                         profile_info[i].percentile_latency[1],
+                         profile_info[i].percentile_latency[2],
+                         profile_info[i].percentile_latency[3],
+                         profile_info[i].fop_name);
+        }
+
         cli_out (" ");
         cli_out ("%12s: %"PRId64" seconds", "Duration", sec);
         cli_out ("%12s: %"PRId64" bytes", "Data Read", r_count);
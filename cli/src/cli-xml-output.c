@@ -9,6 +9,7 @@
 */
 #include <stdlib.h>
 #include "cli.h"
+#include "cli-cmd.h"
 #include "cli1-xdr.h"
 #include "run.h"
 #include "compat.h"
@@ -2101,8 +2102,13 @@ cli_xml_output_vol_profile_stats (xmlTextWriterPtr writer, dict_t *dict,
         uint64_t                duration = 0;
         uint64_t                total_read = 0;
         uint64_t                total_write = 0;
+        uint64_t                percentile = 0;
         char                    key[1024] = {0};
         int                     i = 0;
+        int                     j = 0;
+        static const char      *percentile_names[CLI_PROFILE_PERCENTILE_MAX] = {
+                "p50", "p90", "p99", "p999"
+        };
 
         /* <cumulativeStats> || <intervalStats> */
         if (interval == -1)
@@ -2212,6 +2218,22 @@ cli_xml_output_vol_profile_stats (xmlTextWriterPtr writer, dict_t *dict,
                         (writer, (xmlChar *)"maxLatency", "%f", max_latency);
                 XML_RET_CHECK_AND_GOTO (ret, out);
 
+                /* <p50Latency>, <p90Latency>, ... when the brick sent them */
+                for (j = 0; j < CLI_PROFILE_PERCENTILE_MAX; j++) {
+                        snprintf (key, sizeof (key), "%d-%d-%d-%slatency",
+                                  brick_index, interval, i,
+                                  percentile_names[j]);
+                        if (dict_get_uint64 (dict, key, &percentile))
+                                continue;
+
+                        snprintf (key, sizeof (key), "%sLatency",
+                                  percentile_names[j]);
+                        ret = xmlTextWriterWriteFormatElement
+                                (writer, (xmlChar *)key, "%"PRIu64,
+                                 percentile);
+                        XML_RET_CHECK_AND_GOTO (ret, out);
+                }
+
                 /* </fop> */
                 ret = xmlTextWriterEndElement (writer);
                 XML_RET_CHECK_AND_GOTO (ret, out);
@@ -0,0 +1,511 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "xlator.h"
+#include "stack.h"
+#include "call-stub.h"
+#include "mem-pool.h"
+#include "mem-types.h"
+#include "iobuf.h"
+
+#include "bm-xlator.h"
+
+#define BM_MTIME        1500000000
+
+struct bm_sink bm_sink;
+
+double
+bm_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void
+bm_iatt (struct iatt *buf, uuid_t gfid, ia_type_t type, uint64_t size)
+{
+        memset (buf, 0, sizeof (*buf));
+        gf_uuid_copy (buf->ia_gfid, gfid);
+        buf->ia_type = type;
+        buf->ia_size = size;
+        buf->ia_nlink = 1;
+        buf->ia_mtime = BM_MTIME;
+}
+
+/* {{{ sink */
+
+static void
+bm_sink_spin (void)
+{
+        double until = 0;
+
+        if (!bm_sink.spin_usecs)
+                return;
+
+        until = bm_now () + bm_sink.spin_usecs / 1e6;
+        while (bm_now () < until)
+                ;
+}
+
+static uint64_t
+bm_sink_size (inode_t *inode)
+{
+        return bm_sink.size ? bm_sink.size (inode) : 0;
+}
+
+static void
+bm_sink_iatt (struct iatt *buf, loc_t *loc, ia_type_t type)
+{
+        if (gf_uuid_is_null (loc->gfid) && loc->inode)
+                bm_iatt (buf, loc->inode->gfid, type,
+                         bm_sink_size (loc->inode));
+        else
+                bm_iatt (buf, loc->gfid, type,
+                         loc->inode ? bm_sink_size (loc->inode) : 0);
+}
+
+static int32_t
+bm_sink_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                dict_t *xdata)
+{
+        bm_sink_spin ();
+        STACK_UNWIND_STRICT (lookup, frame, -1, ENOENT, NULL, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+static int32_t
+bm_sink_stat (call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+        struct iatt buf;
+
+        bm_sink_spin ();
+        bm_sink_iatt (&buf, loc, IA_IFREG);
+        STACK_UNWIND_STRICT (stat, frame, 0, 0, &buf, NULL);
+        return 0;
+}
+
+static int32_t
+bm_sink_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+        struct iatt buf;
+
+        bm_sink_spin ();
+        bm_iatt (&buf, fd->inode->gfid, IA_IFREG, bm_sink_size (fd->inode));
+        STACK_UNWIND_STRICT (fstat, frame, 0, 0, &buf, NULL);
+        return 0;
+}
+
+static int32_t
+bm_sink_setattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                 struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+        struct iatt buf;
+
+        bm_sink_spin ();
+        bm_sink_iatt (&buf, loc, IA_IFREG);
+        STACK_UNWIND_STRICT (setattr, frame, 0, 0, &buf, &buf, NULL);
+        return 0;
+}
+
+static int32_t
+bm_sink_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                  off_t offset, dict_t *xdata)
+{
+        struct iatt buf;
+
+        bm_sink_spin ();
+        bm_sink_iatt (&buf, loc, IA_IFREG);
+        STACK_UNWIND_STRICT (truncate, frame, 0, 0, &buf, &buf, NULL);
+        return 0;
+}
+
+static int32_t
+bm_sink_mkdir (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+               mode_t umask, dict_t *xdata)
+{
+        struct iatt buf;
+
+        bm_sink_spin ();
+        bm_sink_iatt (&buf, loc, IA_IFDIR);
+        STACK_UNWIND_STRICT (mkdir, frame, 0, 0, loc->inode, &buf, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+static int32_t
+bm_sink_create (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                int32_t flags, mode_t mode, mode_t umask, fd_t *fd,
+                dict_t *xdata)
+{
+        struct iatt buf;
+
+        bm_sink_spin ();
+        bm_sink_iatt (&buf, loc, IA_IFREG);
+        STACK_UNWIND_STRICT (create, frame, 0, 0, fd, loc->inode, &buf, &buf,
+                             &buf, NULL);
+        return 0;
+}
+
+static int32_t
+bm_sink_link (call_frame_t *frame, xlator_t *this, loc_t *oldloc,
+              loc_t *newloc, dict_t *xdata)
+{
+        struct iatt buf;
+
+        bm_sink_spin ();
+        bm_sink_iatt (&buf, oldloc, IA_IFREG);
+        buf.ia_nlink = 2;
+        STACK_UNWIND_STRICT (link, frame, 0, 0, oldloc->inode, &buf, NULL,
+                             NULL, NULL);
+        return 0;
+}
+
+/* the file always has another name left */
+static int32_t
+bm_sink_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                int32_t flags, dict_t *xdata)
+{
+        dict_t *rsp = NULL;
+
+        bm_sink_spin ();
+        rsp = dict_new ();
+        if (!rsp || dict_set_uint32 (rsp, GET_LINK_COUNT, 2)) {
+                if (rsp)
+                        dict_unref (rsp);
+                STACK_UNWIND_STRICT (unlink, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+        STACK_UNWIND_STRICT (unlink, frame, 0, 0, NULL, NULL, rsp);
+        dict_unref (rsp);
+        return 0;
+}
+
+static int32_t
+bm_sink_rmdir (call_frame_t *frame, xlator_t *this, loc_t *loc,
+               int32_t flags, dict_t *xdata)
+{
+        bm_sink_spin ();
+        STACK_UNWIND_STRICT (rmdir, frame, 0, 0, NULL, NULL, NULL);
+        return 0;
+}
+
+static int32_t
+bm_sink_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+               off_t offset, uint32_t flags, dict_t *xdata)
+{
+        struct iatt    buf;
+        struct iobuf  *iobuf = NULL;
+        struct iobref *iobref = NULL;
+        struct iovec   vec = {0, };
+        uint64_t       fsize = bm_sink_size (fd->inode);
+
+        bm_sink_spin ();
+        bm_iatt (&buf, fd->inode->gfid, IA_IFREG, fsize);
+        if (offset >= fsize)
+                size = 0;
+        else if (offset + size > fsize)
+                size = fsize - offset;
+
+        iobuf = iobuf_get2 (this->ctx->iobuf_pool, size);
+        iobref = iobref_new ();
+        if (!iobuf || !iobref) {
+                if (iobuf)
+                        iobuf_unref (iobuf);
+                if (iobref)
+                        iobref_unref (iobref);
+                STACK_UNWIND_STRICT (readv, frame, -1, ENOMEM, NULL, 0, NULL,
+                                     NULL, NULL);
+                return 0;
+        }
+        iobref_add (iobref, iobuf);
+        vec.iov_base = iobuf->ptr;
+        vec.iov_len = size;
+
+        if (bm_sink.readv)
+                bm_sink.readv (fd);
+
+        STACK_UNWIND_STRICT (readv, frame, size, 0, &vec, 1, &buf, iobref,
+                             NULL);
+
+        iobuf_unref (iobuf);
+        iobref_unref (iobref);
+        return 0;
+}
+
+static struct xlator_fops bm_sink_fops = {
+        .lookup   = bm_sink_lookup,
+        .stat     = bm_sink_stat,
+        .fstat    = bm_sink_fstat,
+        .setattr  = bm_sink_setattr,
+        .truncate = bm_sink_truncate,
+        .mkdir    = bm_sink_mkdir,
+        .create   = bm_sink_create,
+        .link     = bm_sink_link,
+        .unlink   = bm_sink_unlink,
+        .rmdir    = bm_sink_rmdir,
+        .readv    = bm_sink_readv,
+};
+
+/* }}} */
+
+call_frame_t *
+bm_frame (xlator_t *top, struct bm_wait *wait)
+{
+        call_frame_t *frame = NULL;
+
+        frame = create_frame (top, top->ctx->pool);
+        if (!frame) {
+                fprintf (stderr, "failed to create a frame\n");
+                exit (1);
+        }
+        sem_init (&wait->done, 0, 0);
+        wait->op_ret = -1;
+        wait->op_errno = 0;
+        frame->local = wait;
+
+        return frame;
+}
+
+/* called by the callbacks of the fops wound with bm_frame () */
+void
+bm_done (call_frame_t *frame, int32_t op_ret, int32_t op_errno)
+{
+        struct bm_wait *wait = frame->local;
+
+        frame->local = NULL;
+        STACK_DESTROY (frame->root);
+        wait->op_ret = op_ret;
+        wait->op_errno = op_errno;
+        sem_post (&wait->done);
+}
+
+int32_t
+bm_wait (struct bm_wait *wait)
+{
+        sem_wait (&wait->done);
+        sem_destroy (&wait->done);
+
+        return wait->op_ret;
+}
+
+int
+bm_xlator_start (xlator_t *xl, dict_t *options)
+{
+        xlator_t *old_THIS = THIS;
+        int       ret = 0;
+
+        xl->options = options;
+
+        THIS = xl;
+        ret = xl->init (xl);
+        THIS = old_THIS;
+
+        return ret;
+}
+
+void
+bm_xlator_stop (xlator_t *xl)
+{
+        xlator_t *old_THIS = THIS;
+
+        THIS = xl;
+        xl->fini (xl);
+        THIS = old_THIS;
+
+        dict_unref (xl->options);
+        xl->options = NULL;
+}
+
+struct bm_worker {
+        pthread_t           thread;
+        pthread_barrier_t  *barrier;
+        void              (*fn) (void *data, int index);
+        void               *data;
+        int                 index;
+};
+
+static void *
+bm_worker_start (void *arg)
+{
+        struct bm_worker *worker = arg;
+
+        pthread_barrier_wait (worker->barrier);
+        worker->fn (worker->data, worker->index);
+        pthread_barrier_wait (worker->barrier);
+
+        return NULL;
+}
+
+/* runs worker (data, 0..nthreads-1) in nthreads threads started together,
+ * returns the seconds they took */
+double
+bm_run (int nthreads, void (*fn) (void *data, int index), void *data)
+{
+        pthread_barrier_t  barrier;
+        struct bm_worker  *workers = NULL;
+        double             start = 0;
+        double             end = 0;
+        int                i = 0;
+
+        workers = calloc (nthreads, sizeof (*workers));
+        if (!workers) {
+                fprintf (stderr, "failed to allocate the threads\n");
+                exit (1);
+        }
+        pthread_barrier_init (&barrier, NULL, nthreads + 1);
+
+        for (i = 0; i < nthreads; i++) {
+                workers[i].barrier = &barrier;
+                workers[i].fn = fn;
+                workers[i].data = data;
+                workers[i].index = i;
+                pthread_create (&workers[i].thread, NULL, bm_worker_start,
+                                &workers[i]);
+        }
+
+        pthread_barrier_wait (&barrier);
+        start = bm_now ();
+        pthread_barrier_wait (&barrier);
+        end = bm_now ();
+
+        for (i = 0; i < nthreads; i++)
+                pthread_join (workers[i].thread, NULL);
+
+        pthread_barrier_destroy (&barrier);
+        free (workers);
+
+        return end - start;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s %s\n", prog, bm_xlator.usage);
+        exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+        static glusterfs_graph_t  graph;
+        static call_pool_t        pool;
+        static xlator_t           top;
+        static xlator_t           xl;
+        static xlator_t           sink;
+        static xlator_list_t      children;
+        static volume_opt_list_t  vol_opt;
+        glusterfs_ctx_t          *ctx = NULL;
+        int                       opt = 0;
+
+        while ((opt = getopt (argc, argv, bm_xlator.optstring)) != -1) {
+                if (opt == '?' || bm_xlator.opt (opt, optarg))
+                        usage (argv[0]);
+        }
+        if (optind < argc || bm_xlator.opt (-1, NULL))
+                usage (argv[0]);
+
+        mem_pools_init_early ();
+        mem_pools_init_late ();
+
+        ctx = glusterfs_ctx_new ();
+        if (!ctx || glusterfs_globals_init (ctx)) {
+                fprintf (stderr, "failed to initialize glusterfs context\n");
+                return 1;
+        }
+        THIS->ctx = ctx;
+
+        if (xlator_mem_acct_init (THIS, gf_common_mt_end + 1)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        ctx->dict_pool = mem_pool_new (dict_t, 32);
+        ctx->dict_pair_pool = mem_pool_new (data_pair_t, 512);
+        ctx->dict_data_pool = mem_pool_new (data_t, 512);
+        ctx->stub_mem_pool = mem_pool_new (call_stub_t, 1024);
+        ctx->iobuf_pool = iobuf_pool_new ();
+        if (!ctx->dict_pool || !ctx->dict_pair_pool ||
+            !ctx->dict_data_pool || !ctx->stub_mem_pool || !ctx->iobuf_pool) {
+                fprintf (stderr, "failed to initialize the pools\n");
+                return 1;
+        }
+        call_pool_init (&pool);
+        ctx->pool = &pool;
+
+        /* slot 0 of the inode ctx is taken by the global xlator that
+         * creates the inodes */
+        graph.xl_count = 4;
+        graph.top = &top;
+        top.name = (char *)bm_xlator.name;
+        top.ctx = ctx;
+        top.graph = &graph;
+        top.xl_id = 2;
+
+        sink.name = "sink";
+        sink.ctx = ctx;
+        sink.graph = &graph;
+        sink.xl_id = 1;
+        sink.fops = &bm_sink_fops;
+        if (xlator_mem_acct_init (&sink, gf_common_mt_end + 1)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        top.itable = inode_table_new (0, &top);
+        if (!top.itable) {
+                fprintf (stderr, "failed to create the inode table\n");
+                return 1;
+        }
+
+        if (bm_xlator.api) {
+                bm_xlator.fops = bm_xlator.api->fops;
+                bm_xlator.cbks = bm_xlator.api->cbks;
+                bm_xlator.options = bm_xlator.api->options;
+                bm_xlator.init = bm_xlator.api->init;
+                bm_xlator.fini = bm_xlator.api->fini;
+                bm_xlator.mem_acct_init = bm_xlator.api->mem_acct_init;
+        }
+
+        xl.name = "bm-xlator";
+        xl.type = (char *)bm_xlator.type;
+        xl.xl_id = 3;
+        xl.ctx = ctx;
+        xl.graph = &graph;
+        xl.fops = bm_xlator.fops;
+        xl.cbks = bm_xlator.cbks;
+        xl.init = bm_xlator.init;
+        xl.fini = bm_xlator.fini;
+        children.xlator = &sink;
+        xl.children = &children;
+        INIT_LIST_HEAD (&xl.volume_options);
+        INIT_LIST_HEAD (&vol_opt.list);
+        vol_opt.given_opt = bm_xlator.options;
+        list_add_tail (&vol_opt.list, &xl.volume_options);
+        if (bm_xlator.mem_acct_init && bm_xlator.mem_acct_init (&xl)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        return bm_xlator.run (&top, &xl) ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* bm-xlator: the harness of the benchmarks that build one translator into
+ * the program and drive it directly, without a volume. It owns main (): it
+ * parses the options, sets up a glusterfs context and the graph
+ *
+ *      top -> translator under test -> sink
+ *
+ * and calls the run function of the benchmark. The sink answers every fop at
+ * once, from the thread that wound it.
+ */
+
+#ifndef __BM_XLATOR_H__
+#define __BM_XLATOR_H__
+
+#include <semaphore.h>
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "iatt.h"
+
+/* what a benchmark provides, as a global named bm_xlator */
+struct bm_xlator {
+        const char              *name;
+        const char              *type;
+
+        /* the translator under test, either as the symbols of an old style
+         * translator or as its xlator_api */
+        struct xlator_fops      *fops;
+        struct xlator_cbks      *cbks;
+        struct volume_options   *options;
+        int32_t                (*init) (xlator_t *this);
+        void                   (*fini) (xlator_t *this);
+        int32_t                (*mem_acct_init) (xlator_t *this);
+        xlator_api_t            *api;
+
+        /* getopt () string and usage of the options, opt () is called for
+         * each option and once with -1 when all have been parsed; it returns
+         * -1 to print the usage */
+        const char              *optstring;
+        const char              *usage;
+        int                    (*opt) (int opt, char *arg);
+
+        int                    (*run) (xlator_t *top, xlator_t *xl);
+};
+
+extern struct bm_xlator bm_xlator;
+
+/* what the sink answers, set by the benchmark */
+struct bm_sink {
+        /* busy wait before each answer, to stand in for the brick */
+        long                     spin_usecs;
+        /* size of the files, 0 when NULL */
+        uint64_t               (*size) (inode_t *inode);
+        /* called for each readv */
+        void                   (*readv) (fd_t *fd);
+};
+
+extern struct bm_sink bm_sink;
+
+/* a fop wound with bm_frame () and waited for with bm_wait () */
+struct bm_wait {
+        sem_t                    done;
+        int32_t                  op_ret;
+        int32_t                  op_errno;
+};
+
+double
+bm_now (void);
+
+void
+bm_iatt (struct iatt *buf, uuid_t gfid, ia_type_t type, uint64_t size);
+
+call_frame_t *
+bm_frame (xlator_t *top, struct bm_wait *wait);
+
+void
+bm_done (call_frame_t *frame, int32_t op_ret, int32_t op_errno);
+
+int32_t
+bm_wait (struct bm_wait *wait);
+
+int
+bm_xlator_start (xlator_t *xl, dict_t *options);
+
+void
+bm_xlator_stop (xlator_t *xl);
+
+double
+bm_run (int nthreads, void (*worker) (void *data, int index), void *data);
+
+#endif /* __BM_XLATOR_H__ */
@@ -0,0 +1,47 @@
+#!/bin/sh
+
+# client-conn-bm: throughput of one client against a volume with 1, 2, 4
+# and 8 connections per brick (protocol/client option connection-count).
+# Every count is a gfapi-bm run of the large file workload, so nothing is
+# mounted and it does not need root.
+#
+#   ./client-conn-bm.sh server volume [file-mb] [depth] [counts]
+#
+# 'depth' asynchronous requests of 128KB are kept in flight, which is what
+# spreads the load over the connections. Run it on a client that is not a
+# server of the volume, after 'make -C extras/benchmarking gfapi-bm'.
+
+server=$1
+volume=$2
+size=${3:-1024}
+depth=${4:-32}
+counts=${5:-"1 2 4 8"}
+bm=$(dirname $0)/gfapi-bm
+
+if [ -z "$server" ] || [ -z "$volume" ]; then
+    echo "usage: $0 server volume [file-mb] [depth] [counts]" >&2
+    exit 1
+fi
+
+if [ ! -x $bm ]; then
+    echo "$bm not found, run 'make -C extras/benchmarking gfapi-bm'" >&2
+    exit 1
+fi
+
+# prints the MB/s of one phase from gfapi-bm's output
+rate ()
+{
+    echo "$2" | grep "\"phase\": \"$1\"" | \
+        sed 's/.*"mb_per_sec": \([0-9.]*\).*/\1/'
+}
+
+printf "%-12s %12s %12s %12s %12s\n" "connections" "seq-write" \
+       "seq-read" "rand-write" "rand-read"
+
+for conns in $counts; do
+    out=$($bm -s $server -w large -f $size -b 128 -q $depth -c $conns \
+          $volume) || exit 1
+    printf "%-12s %12s %12s %12s %12s\n" $conns \
+           $(rate seq-write "$out") $(rate seq-read "$out") \
+           $(rate rand-write "$out") $(rate rand-read "$out")
+done
@@ -0,0 +1,214 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* dht-layout-bm: time dht_layout_search () for layouts of 2..1024
+ * subvolumes, with and without the sorted range index that dht_layout_set ()
+ * builds, next to the cost of just hashing the name.
+ *
+ *   make -C extras/benchmarking dht-layout-bm
+ *   ./extras/benchmarking/dht-layout-bm -n 100000 -m 1024
+ *
+ * dht-layout.c and dht-hashfn.c are built into the benchmark, the inode
+ * context helpers they reference are stubbed out below.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "xlator.h"
+#include "mem-pool.h"
+#include "mem-types.h"
+#include "dht-common.h"
+
+int
+dht_inode_ctx_layout_get (inode_t *inode, xlator_t *this,
+                          dht_layout_t **layout)
+{
+        return -1;
+}
+
+int
+dht_inode_ctx_layout_set (inode_t *inode, xlator_t *this,
+                          dht_layout_t *layout_int)
+{
+        return -1;
+}
+
+static double
+bm_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static dht_layout_t *
+bm_layout (xlator_t *this, xlator_t *subvols, int cnt)
+{
+        dht_layout_t *layout = NULL;
+        uint32_t      chunk = 0;
+        int           i = 0;
+
+        layout = dht_layout_new (this, cnt);
+
+        chunk = 0xffffffff / cnt;
+        for (i = 0; i < cnt; i++) {
+                layout->list[i].xlator = &subvols[i];
+                layout->list[i].start = i * chunk;
+                layout->list[i].stop = (i == cnt - 1) ? 0xffffffff
+                                                      : (i + 1) * chunk - 1;
+        }
+
+        return layout;
+}
+
+static double
+bm_search (xlator_t *this, dht_layout_t *layout, char **names, long count,
+           xlator_t **found)
+{
+        double start = 0;
+        long   i = 0;
+
+        start = bm_now ();
+        for (i = 0; i < count; i++)
+                found[i] = dht_layout_search (this, layout, names[i]);
+
+        return (bm_now () - start) * 1e9 / count;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-n names] [-m max-subvolumes]\n", prog);
+        exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+        static xlator_t   xl;
+        glusterfs_ctx_t  *ctx = NULL;
+        dht_conf_t        conf;
+        dht_layout_t     *layout = NULL;
+        xlator_t         *subvols = NULL;
+        xlator_t        **linear = NULL;
+        xlator_t        **indexed = NULL;
+        char            **names = NULL;
+        uint32_t          hash = 0;
+        double            start = 0;
+        double            hash_ns = 0;
+        double            linear_ns = 0;
+        double            indexed_ns = 0;
+        long              count = 100000;
+        long              i = 0;
+        int               maxcnt = 1024;
+        int               cnt = 0;
+        int               opt = 0;
+
+        while ((opt = getopt (argc, argv, "n:m:")) != -1) {
+                switch (opt) {
+                case 'n':
+                        count = atol (optarg);
+                        break;
+                case 'm':
+                        maxcnt = atoi (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                }
+        }
+
+        if (count < 1 || maxcnt < 2)
+                usage (argv[0]);
+
+        mem_pools_init_early ();
+        mem_pools_init_late ();
+
+        ctx = glusterfs_ctx_new ();
+        if (!ctx || glusterfs_globals_init (ctx)) {
+                fprintf (stderr, "failed to initialize glusterfs context\n");
+                return 1;
+        }
+        THIS->ctx = ctx;
+
+        if (xlator_mem_acct_init (THIS, gf_dht_mt_end + 1)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        memset (&conf, 0, sizeof (conf));
+        LOCK_INIT (&conf.lock);
+        xl.name = "dht-layout-bm";
+        xl.ctx = ctx;
+        xl.private = &conf;
+        xl.mem_acct = THIS->mem_acct;
+
+        subvols = calloc (maxcnt, sizeof (*subvols));
+        linear = calloc (count, sizeof (*linear));
+        indexed = calloc (count, sizeof (*indexed));
+        names = calloc (count, sizeof (*names));
+        for (i = 0; i < count; i++) {
+                names[i] = malloc (32);
+                snprintf (names[i], 32, "file-%ld.dat", i);
+        }
+
+        start = bm_now ();
+        for (i = 0; i < count; i++)
+                dht_hash_compute (&xl, DHT_HASH_TYPE_DM, names[i], &hash);
+        hash_ns = (bm_now () - start) * 1e9 / count;
+
+        printf ("hash only: %.1f ns/op\n", hash_ns);
+        printf ("%-8s %14s %14s %8s\n", "subvols", "linear ns/op",
+                "indexed ns/op", "speedup");
+
+        for (cnt = 2; cnt <= maxcnt; cnt *= 2) {
+                layout = bm_layout (&xl, subvols, cnt);
+
+                linear_ns = bm_search (&xl, layout, names, count, linear);
+
+                if (dht_layout_index (&xl, layout)) {
+                        printf ("%-8d %14.1f %14s %8s\n", cnt, linear_ns,
+                                "-", "-");
+                        dht_layout_unref (&xl, layout);
+                        continue;
+                }
+
+                indexed_ns = bm_search (&xl, layout, names, count, indexed);
+
+                for (i = 0; i < count; i++) {
+                        if (linear[i] != indexed[i]) {
+                                fprintf (stderr, "%s: linear and indexed "
+                                         "search disagree\n", names[i]);
+                                return 1;
+                        }
+                }
+
+                printf ("%-8d %14.1f %14.1f %8.2f\n", cnt, linear_ns,
+                        indexed_ns, linear_ns / indexed_ns);
+
+                dht_layout_unref (&xl, layout);
+        }
+
+        for (i = 0; i < count; i++)
+                free (names[i]);
+        free (names);
+        free (indexed);
+        free (linear);
+        free (subvols);
+
+        return 0;
+}
@@ -0,0 +1,229 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* dict-bm: the dict churn of a single fop. Every round creates a dict, sets
+ * N keys (gfid-req, a few lock count and xattrop keys, then generated ones),
+ * looks all of them up, serializes it, unserializes it into a second dict
+ * and drops both, like a lookup going from the client to the brick. The
+ * cost of the set/get part and of the serialize/unserialize part is
+ * printed per round for 1..256 keys.
+ *
+ *   make -C extras/benchmarking dict-bm
+ *   ./extras/benchmarking/dict-bm -n 100000
+ *
+ * Build it against two trees to compare dict implementations.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "xlator.h"
+#include "mem-pool.h"
+#include "mem-types.h"
+#include "dict.h"
+
+static const char *bm_well_known[] = {
+        "gfid-req", GLUSTERFS_INODELK_COUNT, GLUSTERFS_ENTRYLK_COUNT,
+        GLUSTERFS_POSIXLK_COUNT, GLUSTERFS_OPEN_FD_COUNT, GF_GFIDLESS_LOOKUP,
+        GLUSTERFS_PARENT_ENTRYLK, GF_XATTROP_INDEX_COUNT, NULL
+};
+
+static const int bm_sizes[] = { 1, 4, 16, 64, 256, 0 };
+
+static double
+bm_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char **
+bm_keys (int cnt)
+{
+        char **keys = NULL;
+        int    i = 0;
+
+        keys = calloc (cnt, sizeof (*keys));
+        for (i = 0; i < cnt; i++) {
+                if (i < 8 && bm_well_known[i] != NULL) {
+                        keys[i] = strdup (bm_well_known[i]);
+                } else {
+                        keys[i] = malloc (48);
+                        snprintf (keys[i], 48, "trusted.bm.xattr-%d", i);
+                }
+        }
+
+        return keys;
+}
+
+static int
+bm_fill (dict_t *dict, char **keys, int cnt)
+{
+        int i = 0;
+
+        for (i = 0; i < cnt; i++) {
+                if (dict_set_uint32 (dict, keys[i], i))
+                        return -1;
+        }
+
+        return 0;
+}
+
+static int
+bm_check (dict_t *dict, char **keys, int cnt)
+{
+        uint32_t value = 0;
+        int      i = 0;
+
+        for (i = 0; i < cnt; i++) {
+                if (dict_get_uint32 (dict, keys[i], &value) || value != i)
+                        return -1;
+        }
+
+        return 0;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-n rounds]\n", prog);
+        exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+        glusterfs_ctx_t  *ctx = NULL;
+        dict_t           *dict = NULL;
+        dict_t           *copy = NULL;
+        char            **keys = NULL;
+        char             *buf = NULL;
+        unsigned int      len = 0;
+        double            start = 0;
+        double            set_ns = 0;
+        double            ser_ns = 0;
+        long              rounds = 100000;
+        long              r = 0;
+        long              n = 0;
+        int               cnt = 0;
+        int               s = 0;
+        int               i = 0;
+        int               opt = 0;
+
+        while ((opt = getopt (argc, argv, "n:")) != -1) {
+                switch (opt) {
+                case 'n':
+                        rounds = atol (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                }
+        }
+
+        if (rounds < 1)
+                usage (argv[0]);
+
+        mem_pools_init_early ();
+        mem_pools_init_late ();
+
+        ctx = glusterfs_ctx_new ();
+        if (!ctx || glusterfs_globals_init (ctx)) {
+                fprintf (stderr, "failed to initialize glusterfs context\n");
+                return 1;
+        }
+        THIS->ctx = ctx;
+
+        if (xlator_mem_acct_init (THIS, gf_common_mt_end + 1)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        /* the pools glusterfsd creates for every process */
+        ctx->dict_pool = mem_pool_new (dict_t, 32);
+        ctx->dict_pair_pool = mem_pool_new (data_pair_t, 512);
+        ctx->dict_data_pool = mem_pool_new (data_t, 512);
+        if (!ctx->dict_pool || !ctx->dict_pair_pool ||
+            !ctx->dict_data_pool) {
+                fprintf (stderr, "failed to create the dict pools\n");
+                return 1;
+        }
+
+        printf ("%-6s %16s %16s %16s\n", "keys", "set+get ns/fop",
+                "ser+unser ns/fop", "total ns/fop");
+
+        for (s = 0; bm_sizes[s] != 0; s++) {
+                cnt = bm_sizes[s];
+                keys = bm_keys (cnt);
+                /* keep the total work per size roughly the same */
+                n = rounds * 4 / (cnt + 3);
+                if (n < 1)
+                        n = 1;
+
+                set_ns = 0;
+                ser_ns = 0;
+                for (r = 0; r < n; r++) {
+                        start = bm_now ();
+                        dict = dict_new ();
+                        if (!dict || bm_fill (dict, keys, cnt) ||
+                            bm_check (dict, keys, cnt)) {
+                                fprintf (stderr, "%d keys: set/get "
+                                         "failed\n", cnt);
+                                return 1;
+                        }
+                        set_ns += bm_now () - start;
+
+                        start = bm_now ();
+                        if (dict_allocate_and_serialize (dict, &buf, &len)) {
+                                fprintf (stderr, "%d keys: serialize "
+                                         "failed\n", cnt);
+                                return 1;
+                        }
+                        copy = dict_new ();
+                        if (!copy || dict_unserialize (buf, len, &copy)) {
+                                fprintf (stderr, "%d keys: unserialize "
+                                         "failed\n", cnt);
+                                return 1;
+                        }
+                        ser_ns += bm_now () - start;
+
+                        if (copy->count != cnt ||
+                            !dict_get (copy, keys[r % cnt])) {
+                                fprintf (stderr, "%d keys: unserialized "
+                                         "dict differs\n", cnt);
+                                return 1;
+                        }
+
+                        start = bm_now ();
+                        dict_unref (copy);
+                        dict_unref (dict);
+                        GF_FREE (buf);
+                        set_ns += bm_now () - start;
+                }
+
+                set_ns = set_ns * 1e9 / n;
+                ser_ns = ser_ns * 1e9 / n;
+                printf ("%-6d %16.1f %16.1f %16.1f\n", cnt, set_ns, ser_ns,
+                        set_ns + ser_ns);
+
+                for (i = 0; i < cnt; i++)
+                        free (keys[i]);
+                free (keys);
+        }
+
+        return 0;
+}
@@ -0,0 +1,235 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* ec-code-bm: encode and decode throughput of the disperse translator for
+ * every code generator the CPU supports (plain C, x64, sse, avx, avx512)
+ * and a few fragments+redundancy configurations. Decoding always uses the
+ * last fragments so that the redundancy is really needed. The output of
+ * every generator is checked against the plain C implementation.
+ *
+ *   make -C extras/benchmarking ec-code-bm
+ *   ./extras/benchmarking/ec-code-bm -s 4 -i 16
+ *
+ * The galois field and code generation sources of the ec translator are
+ * built into the benchmark.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "xlator.h"
+#include "mem-pool.h"
+#include "ec-mem-types.h"
+#include "ec-method.h"
+
+static const char *bm_gens[] = {
+        "none", "x64", "sse", "avx", "avx512", NULL
+};
+
+static const uint32_t bm_configs[][2] = {
+        { 2, 1 }, { 4, 2 }, { 8, 3 }, { 8, 4 }, { 16, 4 }, { 0, 0 }
+};
+
+static double
+bm_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *
+bm_alloc (size_t size)
+{
+        void *ptr = NULL;
+
+        if (posix_memalign (&ptr, 64, size)) {
+                fprintf (stderr, "out of memory\n");
+                exit (1);
+        }
+
+        return ptr;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-s size-mb] [-i iterations]\n", prog);
+        exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+        static xlator_t     xl;
+        glusterfs_ctx_t    *ctx = NULL;
+        ec_matrix_list_t    list;
+        uint8_t            *data = NULL;
+        uint8_t            *frags[EC_METHOD_MAX_FRAGMENTS * 2];
+        uint8_t            *refs[EC_METHOD_MAX_FRAGMENTS * 2];
+        uint8_t            *decoded = NULL;
+        void               *out[EC_METHOD_MAX_FRAGMENTS * 2];
+        void               *in[EC_METHOD_MAX_FRAGMENTS];
+        uint32_t            rows[EC_METHOD_MAX_FRAGMENTS];
+        uintptr_t           mask = 0;
+        size_t              size = 0;
+        size_t              frag_size = 0;
+        double              start = 0;
+        double              enc = 0;
+        double              dec = 0;
+        long                mb = 4;
+        int                 iterations = 16;
+        uint32_t            k = 0;
+        uint32_t            r = 0;
+        uint32_t            n = 0;
+        uint32_t            i = 0;
+        int                 c = 0;
+        int                 g = 0;
+        int                 it = 0;
+        int                 opt = 0;
+
+        while ((opt = getopt (argc, argv, "s:i:")) != -1) {
+                switch (opt) {
+                case 's':
+                        mb = atol (optarg);
+                        break;
+                case 'i':
+                        iterations = atoi (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                }
+        }
+
+        if (mb < 1 || iterations < 1)
+                usage (argv[0]);
+
+        mem_pools_init_early ();
+        mem_pools_init_late ();
+
+        ctx = glusterfs_ctx_new ();
+        if (!ctx || glusterfs_globals_init (ctx)) {
+                fprintf (stderr, "failed to initialize glusterfs context\n");
+                return 1;
+        }
+        THIS->ctx = ctx;
+
+        if (xlator_mem_acct_init (THIS, ec_mt_end + 1)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        xl.name = "ec-code-bm";
+        xl.ctx = ctx;
+        xl.mem_acct = THIS->mem_acct;
+
+        printf ("%-8s %-8s %14s %14s\n", "config", "code", "encode MB/s",
+                "decode MB/s");
+
+        for (c = 0; bm_configs[c][0] != 0; c++) {
+                k = bm_configs[c][0];
+                r = bm_configs[c][1];
+                n = k + r;
+
+                size = mb << 20;
+                size -= size % (EC_METHOD_CHUNK_SIZE * k);
+                frag_size = size / k;
+
+                data = bm_alloc (size);
+                decoded = bm_alloc (size);
+                for (i = 0; i < size; i++)
+                        data[i] = random ();
+                for (i = 0; i < n; i++) {
+                        frags[i] = bm_alloc (frag_size);
+                        refs[i] = NULL;
+                }
+
+                mask = 0;
+                for (i = 0; i < k; i++) {
+                        rows[i] = r + i + 1;
+                        mask |= 1ULL << (r + i);
+                }
+
+                for (g = 0; bm_gens[g] != NULL; g++) {
+                        memset (&list, 0, sizeof (list));
+                        if (ec_method_init (&xl, &list, k, n, n * 2,
+                                            bm_gens[g])) {
+                                fprintf (stderr, "ec_method_init failed\n");
+                                return 1;
+                        }
+
+                        if ((g > 0) && (list.code->gen == NULL ||
+                            strcmp (list.code->gen->name, bm_gens[g]))) {
+                                /* not supported by this CPU */
+                                ec_method_fini (&list);
+                                continue;
+                        }
+
+                        start = bm_now ();
+                        for (it = 0; it < iterations; it++) {
+                                for (i = 0; i < n; i++)
+                                        out[i] = frags[i];
+                                ec_method_encode (&list, size, data, out);
+                        }
+                        enc = size * (double)iterations /
+                              (bm_now () - start) / (1 << 20);
+
+                        for (i = 0; i < k; i++)
+                                in[i] = frags[r + i];
+
+                        start = bm_now ();
+                        for (it = 0; it < iterations; it++) {
+                                ec_method_decode (&list, frag_size, mask,
+                                                  rows, in, decoded);
+                        }
+                        dec = size * (double)iterations /
+                              (bm_now () - start) / (1 << 20);
+
+                        if (memcmp (data, decoded, size)) {
+                                fprintf (stderr, "%u+%u %s: decoded data "
+                                         "differs\n", k, r, bm_gens[g]);
+                                return 1;
+                        }
+                        for (i = 0; i < n; i++) {
+                                if (refs[i] == NULL) {
+                                        refs[i] = bm_alloc (frag_size);
+                                        memcpy (refs[i], frags[i], frag_size);
+                                } else if (memcmp (refs[i], frags[i],
+                                                   frag_size)) {
+                                        fprintf (stderr, "%u+%u %s: fragment "
+                                                 "%u differs from plain C\n",
+                                                 k, r, bm_gens[g], i);
+                                        return 1;
+                                }
+                        }
+
+                        printf ("%2u+%-5u %-8s %14.1f %14.1f\n", k, r,
+                                bm_gens[g], enc, dec);
+
+                        ec_method_fini (&list);
+                }
+
+                for (i = 0; i < n; i++) {
+                        free (frags[i]);
+                        free (refs[i]);
+                }
+                free (decoded);
+                free (data);
+        }
+
+        return 0;
+}
@@ -0,0 +1,296 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* frame-bm: the cost of the call stack machinery alone. Every request
+ * creates a stack, winds a stat through a chain of N translators that do
+ * nothing but STACK_WIND to their child, unwinds from the last one all the
+ * way up and destroys the stack, the way a fop goes through a client graph.
+ * The time per request and per wind/unwind is printed for 1..T threads.
+ *
+ *   make -C extras/benchmarking frame-bm
+ *   ./extras/benchmarking/frame-bm -d 20 -t 16 -n 1000000
+ *
+ * Build it against two trees to compare frame allocators.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "xlator.h"
+#include "stack.h"
+#include "mem-pool.h"
+#include "mem-types.h"
+
+struct bm_state {
+        call_pool_t       *pool;
+        xlator_t          *top;
+        xlator_t          *first;
+        long               ops;
+        pthread_barrier_t  barrier;
+};
+
+struct bm_thread {
+        struct bm_state   *state;
+        pthread_t          thread;
+        long               done;
+};
+
+static double
+bm_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int32_t
+bm_stat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+             int32_t op_ret, int32_t op_errno, struct iatt *buf,
+             dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (stat, frame, op_ret, op_errno, buf, xdata);
+        return 0;
+}
+
+static int32_t
+bm_stat (call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+        struct iatt buf = {0, };
+
+        if (!this->children) {
+                STACK_UNWIND_STRICT (stat, frame, 0, 0, &buf, xdata);
+                return 0;
+        }
+
+        STACK_WIND (frame, bm_stat_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->stat, loc, xdata);
+        return 0;
+}
+
+static int32_t
+bm_top_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+            int32_t op_ret, int32_t op_errno, struct iatt *buf,
+            dict_t *xdata)
+{
+        long *done = frame->local;
+
+        if (op_ret == 0)
+                (*done)++;
+
+        /* not ours to free */
+        frame->local = NULL;
+        return 0;
+}
+
+static struct xlator_fops bm_fops = {
+        .stat = bm_stat,
+};
+
+static void *
+bm_worker (void *data)
+{
+        struct bm_thread *thr = data;
+        struct bm_state  *state = thr->state;
+        call_frame_t     *frame = NULL;
+        loc_t             loc = {0, };
+        long              i = 0;
+
+        pthread_barrier_wait (&state->barrier);
+
+        for (i = 0; i < state->ops; i++) {
+                frame = create_frame (state->top, state->pool);
+                if (!frame)
+                        break;
+                frame->local = &thr->done;
+
+                STACK_WIND (frame, bm_top_cbk, state->first,
+                            state->first->fops->stat, &loc, NULL);
+
+                STACK_DESTROY (frame->root);
+        }
+
+        pthread_barrier_wait (&state->barrier);
+
+        return NULL;
+}
+
+static double
+bm_run (struct bm_state *state, int nthreads)
+{
+        struct bm_thread *thrs = NULL;
+        double            start = 0;
+        double            end = 0;
+        long              done = 0;
+        int               i = 0;
+
+        thrs = calloc (nthreads, sizeof (*thrs));
+        pthread_barrier_init (&state->barrier, NULL, nthreads + 1);
+
+        for (i = 0; i < nthreads; i++) {
+                thrs[i].state = state;
+                pthread_create (&thrs[i].thread, NULL, bm_worker, &thrs[i]);
+        }
+
+        pthread_barrier_wait (&state->barrier);
+        start = bm_now ();
+        pthread_barrier_wait (&state->barrier);
+        end = bm_now ();
+
+        for (i = 0; i < nthreads; i++) {
+                pthread_join (thrs[i].thread, NULL);
+                done += thrs[i].done;
+        }
+
+        pthread_barrier_destroy (&state->barrier);
+        free (thrs);
+
+        if (done != state->ops * nthreads) {
+                fprintf (stderr, "%ld of %ld requests completed\n", done,
+                         state->ops * nthreads);
+                exit (1);
+        }
+
+        return (double)done / (end - start);
+}
+
+static int
+bm_pool_init (call_pool_t *pool)
+{
+#ifdef CALL_POOL_SHARDS
+        call_pool_init (pool);
+#else
+        /* trees without the frame caches */
+        INIT_LIST_HEAD (&pool->all_frames);
+        LOCK_INIT (&pool->lock);
+        pool->frame_mem_pool = mem_pool_new (call_frame_t, 4096);
+        pool->stack_mem_pool = mem_pool_new (call_stack_t, 1024);
+        if (!pool->frame_mem_pool || !pool->stack_mem_pool)
+                return -1;
+#endif
+        return 0;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-d depth] [-t max-threads] "
+                 "[-n requests-per-thread]\n", prog);
+        exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+        static glusterfs_graph_t  graph;
+        static call_pool_t        pool;
+        static xlator_t           top;
+        struct bm_state           state = {0, };
+        glusterfs_ctx_t          *ctx = NULL;
+        xlator_t                 *xls = NULL;
+        xlator_list_t            *children = NULL;
+        double                    base = 0;
+        double                    rate = 0;
+        int                       depth = 20;
+        int                       maxthreads = 8;
+        int                       nthreads = 0;
+        int                       opt = 0;
+        int                       i = 0;
+
+        state.ops = 1000000;
+
+        while ((opt = getopt (argc, argv, "d:t:n:")) != -1) {
+                switch (opt) {
+                case 'd':
+                        depth = atoi (optarg);
+                        break;
+                case 't':
+                        maxthreads = atoi (optarg);
+                        break;
+                case 'n':
+                        state.ops = atol (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                }
+        }
+
+        if (depth < 1 || maxthreads < 1 || state.ops < 1)
+                usage (argv[0]);
+
+        mem_pools_init_early ();
+        mem_pools_init_late ();
+
+        ctx = glusterfs_ctx_new ();
+        if (!ctx || glusterfs_globals_init (ctx)) {
+                fprintf (stderr, "failed to initialize glusterfs context\n");
+                return 1;
+        }
+        THIS->ctx = ctx;
+
+        if (xlator_mem_acct_init (THIS, gf_common_mt_end + 1)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        if (bm_pool_init (&pool)) {
+                fprintf (stderr, "failed to initialize the call pool\n");
+                return 1;
+        }
+        ctx->pool = &pool;
+
+        /* top -> bm-0 -> bm-1 -> ... -> bm-(depth - 1) */
+        xls = calloc (depth, sizeof (*xls));
+        children = calloc (depth, sizeof (*children));
+        graph.xl_count = depth + 1;
+        top.name = "frame-bm";
+        top.ctx = ctx;
+        top.graph = &graph;
+        for (i = 0; i < depth; i++) {
+                xls[i].name = "bm";
+                xls[i].ctx = ctx;
+                xls[i].graph = &graph;
+                xls[i].fops = &bm_fops;
+                if (i + 1 < depth) {
+                        children[i].xlator = &xls[i + 1];
+                        xls[i].children = &children[i];
+                }
+        }
+
+        state.pool = &pool;
+        state.top = &top;
+        state.first = &xls[0];
+
+        printf ("%-8s %14s %12s %12s %8s\n", "threads", "requests/sec",
+                "ns/request", "ns/wind", "scaling");
+        for (nthreads = 1; nthreads <= maxthreads; nthreads *= 2) {
+                rate = bm_run (&state, nthreads);
+                if (nthreads == 1)
+                        base = rate;
+                printf ("%-8d %14.0f %12.1f %12.1f %8.2f\n", nthreads, rate,
+                        1e9 * nthreads / rate,
+                        1e9 * nthreads / rate / (depth + 1),
+                        rate / base);
+                if (nthreads < maxthreads && nthreads * 2 > maxthreads)
+                        nthreads = maxthreads / 2;
+        }
+
+        free (children);
+        free (xls);
+
+        return 0;
+}
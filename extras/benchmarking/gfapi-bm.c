@@ -0,0 +1,689 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* gfapi-bm: end to end benchmark of a volume through libgfapi, without a
+ * mount. Three groups of workloads can be selected with -w:
+ *
+ *   small  create, stat, read and unlink of -n small files (-z bytes)
+ *   large  sequential and random write and read of a -f MB file in -b KB
+ *          blocks, keeping -q requests in flight with glfs_p*_async ()
+ *   meta   -n empty files spread over -d directories, then readdirplus of
+ *          every directory and stat of random names, half of them missing
+ *
+ * -c sets the number of connections per brick (client.connection-count),
+ * by default the volume's setting is used.
+ * Every phase reports its rate and latency percentiles. The output is one
+ * JSON document on stdout, so that runs of two releases against the same
+ * local volume can be compared by a script.
+ *
+ *   make -C extras/benchmarking gfapi-bm
+ *   ./extras/benchmarking/gfapi-bm -s localhost -w small,large,meta \
+ *           -n 10000 -f 1024 -b 128 -q 16 patchy
+ *
+ * Everything is created under a gfapi-bm.<pid> directory of the volume and
+ * removed at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "glfs.h"
+
+#define BM_HIST_SUB_BITS 4
+#define BM_HIST_SUB      (1 << BM_HIST_SUB_BITS)
+#define BM_HIST_BUCKETS  (64 * BM_HIST_SUB)
+
+/* Latencies in nanoseconds, in buckets of 1/16 of a power of two: the
+ * reported percentiles are within ~6% of the real ones. */
+typedef struct {
+        uint64_t count;
+        uint64_t min;
+        uint64_t max;
+        uint64_t buckets[BM_HIST_BUCKETS];
+} bm_hist_t;
+
+typedef struct {
+        glfs_t     *fs;
+        char        dir[64];
+        long        files;
+        long        dirs;
+        size_t      small_size;
+        size_t      block;
+        long        file_mb;
+        int         depth;
+        int         nresults;
+} bm_conf_t;
+
+/* one request of the asynchronous workloads */
+typedef struct bm_slot {
+        struct bm_io    *io;
+        struct timespec  start;
+        char            *buf;
+        int              busy;
+} bm_slot_t;
+
+typedef struct bm_io {
+        pthread_mutex_t  lock;
+        pthread_cond_t   cond;
+        bm_hist_t       *hist;
+        bm_slot_t       *slots;
+        int              inflight;
+        int              errors;
+} bm_io_t;
+
+static uint64_t
+bm_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t
+bm_since (struct timespec *start)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return (ts.tv_sec - start->tv_sec) * 1000000000ULL +
+               ts.tv_nsec - start->tv_nsec;
+}
+
+static int
+bm_hist_index (uint64_t ns)
+{
+        int bits = 0;
+
+        if (ns < BM_HIST_SUB)
+                return ns;
+
+        bits = 63 - __builtin_clzll (ns);
+
+        return (bits - BM_HIST_SUB_BITS + 1) * BM_HIST_SUB +
+               ((ns >> (bits - BM_HIST_SUB_BITS)) & (BM_HIST_SUB - 1));
+}
+
+static uint64_t
+bm_hist_value (int index)
+{
+        int bits = 0;
+
+        if (index < BM_HIST_SUB)
+                return index;
+
+        bits = index / BM_HIST_SUB + BM_HIST_SUB_BITS - 1;
+
+        /* the upper end of the bucket */
+        return ((uint64_t)(BM_HIST_SUB + index % BM_HIST_SUB + 1) <<
+                (bits - BM_HIST_SUB_BITS)) - 1;
+}
+
+static void
+bm_hist_add (bm_hist_t *hist, uint64_t ns)
+{
+        if (!hist->count || ns < hist->min)
+                hist->min = ns;
+        if (ns > hist->max)
+                hist->max = ns;
+        hist->count++;
+        hist->buckets[bm_hist_index (ns)]++;
+}
+
+static double
+bm_hist_percentile (bm_hist_t *hist, double pct)
+{
+        uint64_t want = 0;
+        uint64_t seen = 0;
+        uint64_t value = 0;
+        int      i = 0;
+
+        want = hist->count * pct / 100.0;
+        if (want >= hist->count)
+                want = hist->count - 1;
+
+        for (i = 0; i < BM_HIST_BUCKETS; i++) {
+                seen += hist->buckets[i];
+                if (seen > want)
+                        break;
+        }
+
+        value = bm_hist_value (i);
+        if (value > hist->max)
+                value = hist->max;
+
+        return value / 1000.0;
+}
+
+static void
+bm_report (bm_conf_t *conf, const char *name, bm_hist_t *hist,
+           uint64_t elapsed, uint64_t bytes)
+{
+        double secs = elapsed / 1e9;
+
+        printf ("%s    {\"phase\": \"%s\", \"ops\": %" PRIu64 ", "
+                "\"seconds\": %.3f, \"ops_per_sec\": %.1f, "
+                "\"mb_per_sec\": %.1f,\n"
+                "     \"latency_us\": {\"min\": %.1f, \"p50\": %.1f, "
+                "\"p90\": %.1f, \"p99\": %.1f, \"p99.9\": %.1f, "
+                "\"max\": %.1f}}",
+                conf->nresults++ ? ",\n" : "", name, hist->count, secs,
+                secs > 0 ? hist->count / secs : 0,
+                secs > 0 ? bytes / secs / (1024 * 1024) : 0,
+                hist->count ? hist->min / 1000.0 : 0,
+                hist->count ? bm_hist_percentile (hist, 50) : 0,
+                hist->count ? bm_hist_percentile (hist, 90) : 0,
+                hist->count ? bm_hist_percentile (hist, 99) : 0,
+                hist->count ? bm_hist_percentile (hist, 99.9) : 0,
+                hist->max / 1000.0);
+        fflush (stdout);
+}
+
+static int
+bm_fail (const char *what, const char *path)
+{
+        fprintf (stderr, "gfapi-bm: %s %s: %s\n", what, path,
+                 strerror (errno));
+        return -1;
+}
+
+/* small files */
+
+static int
+bm_small (bm_conf_t *conf)
+{
+        bm_hist_t   hist;
+        glfs_fd_t  *fd = NULL;
+        struct stat st;
+        char        path[256];
+        char       *buf = NULL;
+        uint64_t    start = 0;
+        uint64_t    op = 0;
+        long        i = 0;
+        int         phase = 0;
+        int         ret = -1;
+        static const char *names[] = { "small-create", "small-stat",
+                                       "small-read", "small-unlink" };
+
+        buf = calloc (1, conf->small_size ? conf->small_size : 1);
+        if (!buf)
+                return -1;
+        memset (buf, 'g', conf->small_size);
+
+        snprintf (path, sizeof (path), "%s/small", conf->dir);
+        if (glfs_mkdir (conf->fs, path, 0755)) {
+                bm_fail ("mkdir", path);
+                goto out;
+        }
+
+        for (phase = 0; phase < 4; phase++) {
+                memset (&hist, 0, sizeof (hist));
+                start = bm_now ();
+
+                for (i = 0; i < conf->files; i++) {
+                        snprintf (path, sizeof (path), "%s/small/f.%ld",
+                                  conf->dir, i);
+                        op = bm_now ();
+
+                        switch (phase) {
+                        case 0:
+                                fd = glfs_creat (conf->fs, path, O_WRONLY,
+                                                 0644);
+                                if (!fd) {
+                                        bm_fail ("create", path);
+                                        goto out;
+                                }
+                                if (glfs_write (fd, buf, conf->small_size,
+                                                0) < 0) {
+                                        bm_fail ("write", path);
+                                        glfs_close (fd);
+                                        goto out;
+                                }
+                                glfs_close (fd);
+                                break;
+                        case 1:
+                                if (glfs_stat (conf->fs, path, &st)) {
+                                        bm_fail ("stat", path);
+                                        goto out;
+                                }
+                                break;
+                        case 2:
+                                fd = glfs_open (conf->fs, path, O_RDONLY);
+                                if (!fd) {
+                                        bm_fail ("open", path);
+                                        goto out;
+                                }
+                                if (glfs_read (fd, buf, conf->small_size,
+                                               0) < 0) {
+                                        bm_fail ("read", path);
+                                        glfs_close (fd);
+                                        goto out;
+                                }
+                                glfs_close (fd);
+                                break;
+                        case 3:
+                                if (glfs_unlink (conf->fs, path)) {
+                                        bm_fail ("unlink", path);
+                                        goto out;
+                                }
+                                break;
+                        }
+
+                        bm_hist_add (&hist, bm_now () - op);
+                }
+
+                bm_report (conf, names[phase], &hist, bm_now () - start,
+                           (phase == 0 || phase == 2) ?
+                           conf->files * conf->small_size : 0);
+        }
+
+        snprintf (path, sizeof (path), "%s/small", conf->dir);
+        ret = glfs_rmdir (conf->fs, path);
+out:
+        free (buf);
+        return ret;
+}
+
+/* large file, asynchronous */
+
+static void
+bm_io_cbk (glfs_fd_t *fd, ssize_t ret, struct stat *prestat,
+           struct stat *poststat, void *data)
+{
+        bm_slot_t *slot = data;
+        bm_io_t   *io = slot->io;
+        uint64_t   ns = bm_since (&slot->start);
+
+        pthread_mutex_lock (&io->lock);
+        {
+                bm_hist_add (io->hist, ns);
+                if (ret < 0)
+                        io->errors++;
+                slot->busy = 0;
+                io->inflight--;
+                pthread_cond_signal (&io->cond);
+        }
+        pthread_mutex_unlock (&io->lock);
+}
+
+static int
+bm_large_phase (bm_conf_t *conf, bm_io_t *io, glfs_fd_t *fd,
+                const char *name, int write, int random)
+{
+        bm_hist_t  hist;
+        bm_slot_t *slot = NULL;
+        uint64_t   start = 0;
+        long       blocks = 0;
+        long       i = 0;
+        off_t      offset = 0;
+        int        s = 0;
+        int        ret = 0;
+
+        blocks = conf->file_mb * 1024 * 1024 / conf->block;
+        memset (&hist, 0, sizeof (hist));
+        io->hist = &hist;
+        io->errors = 0;
+        start = bm_now ();
+
+        for (i = 0; i < blocks && !ret; i++) {
+                pthread_mutex_lock (&io->lock);
+                {
+                        while (io->inflight == conf->depth)
+                                pthread_cond_wait (&io->cond, &io->lock);
+                        for (s = 0; io->slots[s].busy; s++)
+                                ;
+                        slot = &io->slots[s];
+                        slot->busy = 1;
+                        io->inflight++;
+                }
+                pthread_mutex_unlock (&io->lock);
+
+                offset = (random ? rand () % blocks : i) * conf->block;
+                clock_gettime (CLOCK_MONOTONIC, &slot->start);
+                if (write)
+                        ret = glfs_pwrite_async (fd, slot->buf, conf->block,
+                                                 offset, 0, bm_io_cbk, slot);
+                else
+                        ret = glfs_pread_async (fd, slot->buf, conf->block,
+                                                offset, 0, bm_io_cbk, slot);
+                if (ret) {
+                        bm_fail (write ? "pwrite_async" : "pread_async",
+                                 name);
+                        pthread_mutex_lock (&io->lock);
+                        slot->busy = 0;
+                        io->inflight--;
+                        pthread_mutex_unlock (&io->lock);
+                }
+        }
+
+        pthread_mutex_lock (&io->lock);
+        {
+                while (io->inflight)
+                        pthread_cond_wait (&io->cond, &io->lock);
+        }
+        pthread_mutex_unlock (&io->lock);
+
+        if (write && !ret && glfs_fsync (fd, NULL, NULL))
+                ret = bm_fail ("fsync", name);
+
+        if (io->errors) {
+                fprintf (stderr, "gfapi-bm: %s: %d requests failed\n", name,
+                         io->errors);
+                ret = -1;
+        }
+
+        if (!ret)
+                bm_report (conf, name, &hist, bm_now () - start,
+                           (uint64_t)hist.count * conf->block);
+
+        return ret;
+}
+
+static int
+bm_large (bm_conf_t *conf)
+{
+        bm_io_t     io;
+        glfs_fd_t  *fd = NULL;
+        char        path[256];
+        int         ret = -1;
+        int         s = 0;
+
+        memset (&io, 0, sizeof (io));
+        pthread_mutex_init (&io.lock, NULL);
+        pthread_cond_init (&io.cond, NULL);
+
+        io.slots = calloc (conf->depth, sizeof (*io.slots));
+        if (!io.slots)
+                goto out;
+        for (s = 0; s < conf->depth; s++) {
+                io.slots[s].io = &io;
+                io.slots[s].buf = malloc (conf->block);
+                if (!io.slots[s].buf)
+                        goto out;
+                memset (io.slots[s].buf, 'g', conf->block);
+        }
+
+        snprintf (path, sizeof (path), "%s/large", conf->dir);
+        fd = glfs_creat (conf->fs, path, O_RDWR, 0644);
+        if (!fd) {
+                bm_fail ("create", path);
+                goto out;
+        }
+
+        ret = bm_large_phase (conf, &io, fd, "seq-write", 1, 0);
+        if (!ret)
+                ret = bm_large_phase (conf, &io, fd, "seq-read", 0, 0);
+        if (!ret)
+                ret = bm_large_phase (conf, &io, fd, "rand-write", 1, 1);
+        if (!ret)
+                ret = bm_large_phase (conf, &io, fd, "rand-read", 0, 1);
+
+        glfs_close (fd);
+        if (glfs_unlink (conf->fs, path))
+                ret = bm_fail ("unlink", path);
+out:
+        if (io.slots) {
+                for (s = 0; s < conf->depth; s++)
+                        free (io.slots[s].buf);
+                free (io.slots);
+        }
+        pthread_cond_destroy (&io.cond);
+        pthread_mutex_destroy (&io.lock);
+        return ret;
+}
+
+/* metadata */
+
+static int
+bm_meta (bm_conf_t *conf)
+{
+        bm_hist_t      hist;
+        glfs_fd_t     *fd = NULL;
+        struct stat    st;
+        struct dirent  de;
+        struct dirent *res = NULL;
+        char           path[256];
+        uint64_t       start = 0;
+        uint64_t       op = 0;
+        long           entries = 0;
+        long           d = 0;
+        long           i = 0;
+
+        memset (&hist, 0, sizeof (hist));
+        start = bm_now ();
+        for (d = 0; d < conf->dirs; d++) {
+                snprintf (path, sizeof (path), "%s/d.%ld", conf->dir, d);
+                op = bm_now ();
+                if (glfs_mkdir (conf->fs, path, 0755))
+                        return bm_fail ("mkdir", path);
+                bm_hist_add (&hist, bm_now () - op);
+        }
+        for (i = 0; i < conf->files; i++) {
+                snprintf (path, sizeof (path), "%s/d.%ld/f.%ld", conf->dir,
+                          i % conf->dirs, i);
+                op = bm_now ();
+                fd = glfs_creat (conf->fs, path, O_WRONLY, 0644);
+                if (!fd)
+                        return bm_fail ("create", path);
+                glfs_close (fd);
+                bm_hist_add (&hist, bm_now () - op);
+        }
+        bm_report (conf, "meta-create", &hist, bm_now () - start, 0);
+
+        /* one latency sample per directory listed */
+        memset (&hist, 0, sizeof (hist));
+        start = bm_now ();
+        for (d = 0; d < conf->dirs; d++) {
+                snprintf (path, sizeof (path), "%s/d.%ld", conf->dir, d);
+                op = bm_now ();
+                fd = glfs_opendir (conf->fs, path);
+                if (!fd)
+                        return bm_fail ("opendir", path);
+                while (glfs_readdirplus_r (fd, &st, &de, &res) == 0 && res)
+                        entries++;
+                glfs_closedir (fd);
+                bm_hist_add (&hist, bm_now () - op);
+        }
+        bm_report (conf, "meta-readdirplus", &hist, bm_now () - start, 0);
+
+        if (entries < conf->files) {
+                fprintf (stderr, "gfapi-bm: readdirplus found %ld of %ld "
+                         "files\n", entries, conf->files);
+                return -1;
+        }
+
+        /* odd lookups are for names that do not exist */
+        memset (&hist, 0, sizeof (hist));
+        start = bm_now ();
+        for (i = 0; i < conf->files; i++) {
+                d = rand () % conf->files;
+                snprintf (path, sizeof (path), "%s/d.%ld/%s.%ld", conf->dir,
+                          d % conf->dirs, (i & 1) ? "missing" : "f", d);
+                op = bm_now ();
+                if (glfs_lstat (conf->fs, path, &st) && !(i & 1))
+                        return bm_fail ("lstat", path);
+                bm_hist_add (&hist, bm_now () - op);
+        }
+        bm_report (conf, "meta-lookup", &hist, bm_now () - start, 0);
+
+        memset (&hist, 0, sizeof (hist));
+        start = bm_now ();
+        for (i = 0; i < conf->files; i++) {
+                snprintf (path, sizeof (path), "%s/d.%ld/f.%ld", conf->dir,
+                          i % conf->dirs, i);
+                op = bm_now ();
+                if (glfs_unlink (conf->fs, path))
+                        return bm_fail ("unlink", path);
+                bm_hist_add (&hist, bm_now () - op);
+        }
+        for (d = 0; d < conf->dirs; d++) {
+                snprintf (path, sizeof (path), "%s/d.%ld", conf->dir, d);
+                op = bm_now ();
+                if (glfs_rmdir (conf->fs, path))
+                        return bm_fail ("rmdir", path);
+                bm_hist_add (&hist, bm_now () - op);
+        }
+        bm_report (conf, "meta-remove", &hist, bm_now () - start, 0);
+
+        return 0;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-s server] [-p port] [-t transport] "
+                 "[-l logfile]\n"
+                 "          [-w small,large,meta] [-n files] [-z small-size] "
+                 "[-d dirs]\n"
+                 "          [-f file-mb] [-b block-kb] [-q depth] "
+                 "[-c connections] volume\n",
+                 prog);
+        exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+        bm_conf_t   conf;
+        const char *server = "localhost";
+        const char *transport = "tcp";
+        const char *logfile = "/dev/null";
+        const char *volume = NULL;
+        char        workloads[64] = "small,large,meta";
+        char        conns[16] = "";
+        char       *w = NULL;
+        char       *saveptr = NULL;
+        int         port = 24007;
+        int         connections = 0;
+        int         opt = 0;
+        int         ret = 1;
+
+        memset (&conf, 0, sizeof (conf));
+        conf.files = 10000;
+        conf.small_size = 4096;
+        conf.dirs = 100;
+        conf.file_mb = 1024;
+        conf.block = 128 * 1024;
+        conf.depth = 16;
+
+        while ((opt = getopt (argc, argv,
+                              "s:p:t:l:w:n:z:d:f:b:q:c:")) != -1) {
+                switch (opt) {
+                case 's':
+                        server = optarg;
+                        break;
+                case 'p':
+                        port = atoi (optarg);
+                        break;
+                case 't':
+                        transport = optarg;
+                        break;
+                case 'l':
+                        logfile = optarg;
+                        break;
+                case 'w':
+                        snprintf (workloads, sizeof (workloads), "%s",
+                                  optarg);
+                        break;
+                case 'n':
+                        conf.files = atol (optarg);
+                        break;
+                case 'z':
+                        conf.small_size = atol (optarg);
+                        break;
+                case 'd':
+                        conf.dirs = atol (optarg);
+                        break;
+                case 'f':
+                        conf.file_mb = atol (optarg);
+                        break;
+                case 'b':
+                        conf.block = atol (optarg) * 1024;
+                        break;
+                case 'q':
+                        conf.depth = atoi (optarg);
+                        break;
+                case 'c':
+                        connections = atoi (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                }
+        }
+
+        if (optind != argc - 1 || conf.files < 1 || conf.dirs < 1 ||
+            conf.file_mb < 1 || conf.block < 1024 || conf.depth < 1 ||
+            connections < 0 || conf.block > conf.file_mb * 1024 * 1024)
+                usage (argv[0]);
+        volume = argv[optind];
+
+        conf.fs = glfs_new (volume);
+        if (!conf.fs) {
+                fprintf (stderr, "gfapi-bm: glfs_new failed\n");
+                return 1;
+        }
+        glfs_set_volfile_server (conf.fs, transport, server, port);
+        if (connections > 0) {
+                snprintf (conns, sizeof (conns), "%d", connections);
+                glfs_set_xlator_option (conf.fs, "*-client-*",
+                                        "connection-count", conns);
+        }
+        glfs_set_logging (conf.fs, logfile, 7);
+        if (glfs_init (conf.fs)) {
+                fprintf (stderr, "gfapi-bm: cannot connect to %s:%s: %s\n",
+                         server, volume, strerror (errno));
+                return 1;
+        }
+
+        snprintf (conf.dir, sizeof (conf.dir), "/gfapi-bm.%d", getpid ());
+        if (glfs_mkdir (conf.fs, conf.dir, 0755)) {
+                bm_fail ("mkdir", conf.dir);
+                goto fini;
+        }
+
+        srand (getpid ());
+        printf ("{\"volume\": \"%s\", \"server\": \"%s\", \"files\": %ld, "
+                "\"small_size\": %zu, \"dirs\": %ld, \"file_mb\": %ld, "
+                "\"block\": %zu, \"depth\": %d, \"connections\": %d,\n"
+                " \"results\": [\n",
+                volume, server, conf.files, conf.small_size, conf.dirs,
+                conf.file_mb, conf.block, conf.depth, connections);
+
+        ret = 0;
+        for (w = strtok_r (workloads, ",", &saveptr); w && !ret;
+             w = strtok_r (NULL, ",", &saveptr)) {
+                if (!strcmp (w, "small")) {
+                        ret = bm_small (&conf);
+                } else if (!strcmp (w, "large")) {
+                        ret = bm_large (&conf);
+                } else if (!strcmp (w, "meta")) {
+                        ret = bm_meta (&conf);
+                } else {
+                        fprintf (stderr, "gfapi-bm: unknown workload %s\n",
+                                 w);
+                        ret = -1;
+                }
+        }
+
+        printf ("\n ]}\n");
+
+        if (glfs_rmdir (conf.fs, conf.dir))
+                bm_fail ("rmdir", conf.dir);
+        ret = ret ? 1 : 0;
+fini:
+        glfs_fini (conf.fs);
+        return ret;
+}
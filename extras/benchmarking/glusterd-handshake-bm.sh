@@ -0,0 +1,66 @@
+#!/bin/sh
+
+# glusterd-handshake-bm: time from a glusterd restart until its peer is back
+# in 'Peer in Cluster (Connected)' state, for a growing number of volumes.
+# The handshake exchanges the volume list with every peer, so this is what
+# a restart costs on a cluster with many volumes.
+#
+#   ./glusterd-handshake-bm.sh peer brick-dir [counts]
+#
+# Run it as root on a node of a two node pool that has no other volumes.
+# Volumes gh-bm-<n> are created (not started) with one brick in brick-dir
+# on this node, timed with and without a volume changed while glusterd was
+# down, and deleted at the end.
+
+peer=$1
+bricks=$2
+counts=${3:-"10 100 500 1000"}
+host=$(hostname)
+created=0
+wb=off
+
+if [ -z "$peer" ] || [ -z "$bricks" ]; then
+    echo "usage: $0 peer brick-dir [counts]" >&2
+    exit 1
+fi
+
+# restarts the local glusterd, prints the seconds until the peer is back
+restart ()
+{
+    pkill -x glusterd
+    while pgrep -x glusterd >/dev/null; do sleep 0.1; done
+    start=$(date +%s.%N)
+    glusterd || exit 1
+    until gluster peer status 2>/dev/null | \
+          grep -q 'Peer in Cluster (Connected)'; do
+        sleep 0.05
+    done
+    end=$(date +%s.%N)
+    echo "$end - $start" | bc
+}
+
+printf "%-8s %16s %16s\n" "volumes" "unchanged s" "one changed s"
+
+for count in $counts; do
+    while [ $created -lt $count ]; do
+        created=$((created + 1))
+        gluster --mode=script volume create gh-bm-$created \
+                $host:$bricks/gh-bm-$created force >/dev/null || exit 1
+    done
+
+    unchanged=$(restart)
+
+    # bump the version of one volume on the peer only
+    pkill -x glusterd
+    while pgrep -x glusterd >/dev/null; do sleep 0.1; done
+    ssh $peer gluster --mode=script volume set gh-bm-1 \
+        performance.write-behind $wb >/dev/null || exit 1
+    [ $wb = off ] && wb=on || wb=off
+    changed=$(restart)
+
+    printf "%-8s %16s %16s\n" $count $unchanged $changed
+done
+
+for i in $(seq 1 $created); do
+    gluster --mode=script volume delete gh-bm-$i >/dev/null
+done
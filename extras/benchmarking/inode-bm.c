@@ -0,0 +1,294 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* inode-bm: hammer inode_grep/inode_find/inode_link/inode_unref on a single
+ * inode table from N threads and print the throughput for 1..N threads, so
+ * that the scaling of the inode table locking can be compared across
+ * changes.
+ *
+ *   make -C extras/benchmarking inode-bm
+ *   ./extras/benchmarking/inode-bm -t 16 -n 100000 -o 1000000
+ *
+ * Workloads (-w):
+ *   hot   - lookups of inodes that stay referenced (active list)
+ *   cold  - lookups of inodes that only sit in the lru list
+ *   link  - every thread links, looks up and unlinks its own entries
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "xlator.h"
+#include "inode.h"
+#include "mem-pool.h"
+#include "mem-types.h"
+
+enum bm_workload {
+        BM_HOT,
+        BM_COLD,
+        BM_LINK,
+};
+
+struct bm_state {
+        inode_table_t     *table;
+        inode_t          **inodes;
+        long               count;
+        long               ops;
+        enum bm_workload   workload;
+        pthread_barrier_t  barrier;
+};
+
+struct bm_thread {
+        struct bm_state   *state;
+        pthread_t          thread;
+        int                id;
+};
+
+static double
+bm_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bm_gfid (uuid_t gfid, long n, int id)
+{
+        memset (gfid, 0, sizeof (uuid_t));
+        memcpy (gfid, &n, sizeof (n));
+        gfid[8] = id + 1;
+        /* hash_gfid() only looks at the last two bytes */
+        gfid[14] = (n >> 8) & 0xff;
+        gfid[15] = n & 0xff;
+        gfid[13] = 0x42;
+}
+
+static inode_t *
+bm_link (inode_table_t *table, const char *name, long n, int id)
+{
+        inode_t     *inode = NULL;
+        inode_t     *linked = NULL;
+        struct iatt  iatt = {0, };
+
+        bm_gfid (iatt.ia_gfid, n, id);
+        iatt.ia_type = IA_IFREG;
+
+        inode = inode_new (table);
+        linked = inode_link (inode, table->root, name, &iatt);
+        inode_lookup (linked);
+        inode_unref (inode);
+
+        return linked;
+}
+
+static void *
+bm_worker (void *data)
+{
+        struct bm_thread *thr = data;
+        struct bm_state  *state = thr->state;
+        unsigned int      seed = thr->id + 1;
+        char              name[64] = {0, };
+        inode_t          *inode = NULL;
+        inode_t          *found = NULL;
+        long              i = 0;
+        long              n = 0;
+
+        pthread_barrier_wait (&state->barrier);
+
+        for (i = 0; i < state->ops; i++) {
+                if (state->workload == BM_LINK) {
+                        n = i % 1024;
+                        snprintf (name, sizeof (name), "t%d-%ld", thr->id, n);
+                        inode = bm_link (state->table, name, n, thr->id);
+                        found = inode_grep (state->table, state->table->root,
+                                            name);
+                        inode_unlink (inode, state->table->root, name);
+                        inode_forget (inode, 0);
+                        inode_unref (found);
+                        inode_unref (inode);
+                        continue;
+                }
+
+                n = rand_r (&seed) % state->count;
+                snprintf (name, sizeof (name), "f%ld", n);
+
+                inode = inode_grep (state->table, state->table->root, name);
+                if (!inode)
+                        continue;
+
+                found = inode_find (state->table, inode->gfid);
+                inode_ref (inode);
+                inode_unref (inode);
+                inode_unref (found);
+                inode_unref (inode);
+        }
+
+        pthread_barrier_wait (&state->barrier);
+
+        return NULL;
+}
+
+static double
+bm_run (struct bm_state *state, int nthreads)
+{
+        struct bm_thread *thrs = NULL;
+        double            start = 0;
+        double            end = 0;
+        int               i = 0;
+
+        thrs = calloc (nthreads, sizeof (*thrs));
+        pthread_barrier_init (&state->barrier, NULL, nthreads + 1);
+
+        for (i = 0; i < nthreads; i++) {
+                thrs[i].state = state;
+                thrs[i].id = i;
+                pthread_create (&thrs[i].thread, NULL, bm_worker, &thrs[i]);
+        }
+
+        pthread_barrier_wait (&state->barrier);
+        start = bm_now ();
+        pthread_barrier_wait (&state->barrier);
+        end = bm_now ();
+
+        for (i = 0; i < nthreads; i++)
+                pthread_join (thrs[i].thread, NULL);
+
+        pthread_barrier_destroy (&state->barrier);
+        free (thrs);
+
+        return (double)state->ops * nthreads / (end - start);
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-t max-threads] [-n inodes] "
+                 "[-o ops-per-thread] [-w hot|cold|link]\n", prog);
+        exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+        static glusterfs_graph_t  graph;
+        static xlator_t           xl;
+        struct bm_state           state = {0, };
+        glusterfs_ctx_t          *ctx = NULL;
+        char                      name[64] = {0, };
+        double                    base = 0;
+        double                    rate = 0;
+        int                       maxthreads = 8;
+        int                       nthreads = 0;
+        int                       opt = 0;
+        long                      i = 0;
+
+        state.count = 100000;
+        state.ops = 1000000;
+        state.workload = BM_HOT;
+
+        while ((opt = getopt (argc, argv, "t:n:o:w:")) != -1) {
+                switch (opt) {
+                case 't':
+                        maxthreads = atoi (optarg);
+                        break;
+                case 'n':
+                        state.count = atol (optarg);
+                        break;
+                case 'o':
+                        state.ops = atol (optarg);
+                        break;
+                case 'w':
+                        if (!strcmp (optarg, "hot"))
+                                state.workload = BM_HOT;
+                        else if (!strcmp (optarg, "cold"))
+                                state.workload = BM_COLD;
+                        else if (!strcmp (optarg, "link"))
+                                state.workload = BM_LINK;
+                        else
+                                usage (argv[0]);
+                        break;
+                default:
+                        usage (argv[0]);
+                }
+        }
+
+        if (maxthreads < 1 || state.count < 1 || state.ops < 1)
+                usage (argv[0]);
+
+        mem_pools_init_early ();
+        mem_pools_init_late ();
+
+        ctx = glusterfs_ctx_new ();
+        if (!ctx || glusterfs_globals_init (ctx)) {
+                fprintf (stderr, "failed to initialize glusterfs context\n");
+                return 1;
+        }
+        THIS->ctx = ctx;
+
+        if (xlator_mem_acct_init (THIS, gf_common_mt_end + 1)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        graph.xl_count = 1;
+        xl.name = "inode-bm";
+        xl.ctx = ctx;
+        xl.graph = &graph;
+
+        /* no lru limit, so that the cold set is never pruned */
+        state.table = inode_table_new (0, &xl);
+        if (!state.table) {
+                fprintf (stderr, "failed to create inode table\n");
+                return 1;
+        }
+        inode_ref (state.table->root);
+
+        state.inodes = calloc (state.count, sizeof (inode_t *));
+        for (i = 0; i < state.count; i++) {
+                snprintf (name, sizeof (name), "f%ld", i);
+                state.inodes[i] = bm_link (state.table, name, i, 255);
+                if (state.workload == BM_COLD) {
+                        inode_unref (state.inodes[i]);
+                        state.inodes[i] = NULL;
+                }
+        }
+
+        printf ("%-8s %14s %8s\n", "threads", "ops/sec", "scaling");
+        for (nthreads = 1; nthreads <= maxthreads; nthreads *= 2) {
+                rate = bm_run (&state, nthreads);
+                if (nthreads == 1)
+                        base = rate;
+                printf ("%-8d %14.0f %8.2f\n", nthreads, rate, rate / base);
+        }
+        /* maxthreads itself when it is not a power of two */
+        if (nthreads / 2 != maxthreads) {
+                rate = bm_run (&state, maxthreads);
+                printf ("%-8d %14.0f %8.2f\n", maxthreads, rate, rate / base);
+        }
+
+        for (i = 0; i < state.count; i++) {
+                if (state.inodes[i])
+                        inode_unref (state.inodes[i]);
+        }
+        free (state.inodes);
+
+        inode_table_destroy (state.table);
+
+        return 0;
+}
@@ -0,0 +1,343 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* ioc-bm: the io-cache translator under a scan, with the LRU policy and with
+ * 2Q (performance.io-cache-policy). -t threads read 4KB at random from a hot
+ * file of -H MB, and between every -r of those reads one 128KB block of a
+ * cold file of -S MB that is scanned sequentially, through io-cache with a
+ * cache of -c MB to a child that answers at once. After a warm-up with the
+ * hot reads alone, prints the hit ratio of the hot reads, the pages the cold
+ * scan faulted in and the reads/sec of both policies.
+ *
+ *   make -C extras/benchmarking ioc-bm
+ *   ./extras/benchmarking/ioc-bm -c 64 -H 16 -S 1024 -r 1 -t 1 -n 200000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "stack.h"
+#include "io-cache.h"
+
+#include "bm-xlator.h"
+
+/* the translator under test, built into this program */
+extern struct xlator_fops fops;
+extern struct xlator_cbks cbks;
+extern struct volume_options options[];
+extern int init (xlator_t *this);
+extern void fini (xlator_t *this);
+extern int32_t mem_acct_init (xlator_t *this);
+
+#define BM_READ_SIZE    4096
+#define BM_SCAN_SIZE    (128 * 1024)
+
+struct bm_file {
+        inode_t           *inode;
+        fd_t              *fd;
+        uint64_t           size;
+};
+
+static struct {
+        xlator_t          *top;
+        xlator_t          *ioc;
+        struct bm_file     hot;
+        struct bm_file     cold;
+        long               ops;
+        long               cache_mb;
+        long               hot_mb;
+        long               scan_mb;
+        int                ratio;
+        int                nthreads;
+        gf_atomic_t        scan_off;
+        gf_atomic_t        faults[2];
+        gf_boolean_t       measure;
+} bm_state = {
+        .ops      = 200000,
+        .cache_mb = 64,
+        .hot_mb   = 16,
+        .scan_mb  = 1024,
+        .ratio    = 1,
+        .nthreads = 1,
+};
+
+static uint64_t
+bm_ioc_size (inode_t *inode)
+{
+        return (inode == bm_state.hot.inode) ? bm_state.hot.size
+                                             : bm_state.cold.size;
+}
+
+static void
+bm_ioc_fault (fd_t *fd)
+{
+        if (bm_state.measure)
+                GF_ATOMIC_INC (bm_state.faults[fd->inode ==
+                                               bm_state.hot.inode]);
+}
+
+static int32_t
+bm_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+               struct iatt *buf, struct iatt *preparent,
+               struct iatt *postparent, dict_t *xdata)
+{
+        bm_done (frame, op_ret, op_errno);
+        return 0;
+}
+
+static int32_t
+bm_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iovec *vector,
+              int32_t count, struct iatt *stbuf, struct iobref *iobref,
+              dict_t *xdata)
+{
+        bm_done (frame, op_ret, op_errno);
+        return 0;
+}
+
+/* the child answers at once, but a read of a page that another thread is
+ * faulting in is answered by that thread */
+static int
+bm_read (fd_t *fd, size_t size, off_t offset)
+{
+        call_frame_t   *frame = NULL;
+        struct bm_wait  wait;
+
+        frame = bm_frame (bm_state.top, &wait);
+        STACK_WIND (frame, bm_readv_cbk, bm_state.ioc,
+                    bm_state.ioc->fops->readv, fd, size, offset, 0, NULL);
+
+        return (bm_wait (&wait) == size) ? 0 : -1;
+}
+
+static int
+bm_file_open (struct bm_file *file, const char *path, uint64_t size)
+{
+        call_frame_t   *frame = NULL;
+        loc_t           loc = {0, };
+        struct bm_wait  wait;
+
+        file->size = size;
+        file->inode = inode_new (bm_state.top->itable);
+        if (!file->inode)
+                return -1;
+        gf_uuid_generate (file->inode->gfid);
+        file->fd = fd_create (file->inode, 0);
+        if (!file->fd)
+                return -1;
+
+        loc.path = path;
+        loc.name = path + 1;
+        loc.inode = file->inode;
+        gf_uuid_copy (loc.gfid, file->inode->gfid);
+
+        frame = bm_frame (bm_state.top, &wait);
+        STACK_WIND (frame, bm_create_cbk, bm_state.ioc,
+                    bm_state.ioc->fops->create, &loc, O_RDWR, 0644, 0,
+                    file->fd, NULL);
+
+        return bm_wait (&wait);
+}
+
+static void
+bm_file_close (struct bm_file *file)
+{
+        /* the last unrefs send release and forget to io-cache, which drops
+         * the pages of the file */
+        fd_unref (file->fd);
+        inode_unref (file->inode);
+}
+
+static void
+bm_reader (void *data, int index)
+{
+        long          ops = *(long *)data;
+        uint64_t      blocks = bm_state.hot.size / BM_READ_SIZE;
+        uint64_t      scan_blocks = bm_state.cold.size / BM_SCAN_SIZE;
+        unsigned int  seed = index + 1;
+        off_t         offset = 0;
+        long          i = 0;
+
+        for (i = 0; i < ops; i++) {
+                if (bm_state.measure && bm_state.ratio &&
+                    (i % (bm_state.ratio + 1)) == bm_state.ratio) {
+                        offset = GF_ATOMIC_INC (bm_state.scan_off) %
+                                 scan_blocks;
+                        if (bm_read (bm_state.cold.fd, BM_SCAN_SIZE,
+                                     offset * BM_SCAN_SIZE))
+                                break;
+                        continue;
+                }
+
+                offset = rand_r (&seed) % blocks;
+                if (bm_read (bm_state.hot.fd, BM_READ_SIZE,
+                             offset * BM_READ_SIZE))
+                        break;
+        }
+        if (i < ops)
+                fprintf (stderr, "read failed\n");
+}
+
+static int
+bm_ioc_start (xlator_t *ioc, const char *policy)
+{
+        dict_t *options = NULL;
+        char    value[32];
+        int     ret = 0;
+
+        options = dict_new ();
+        if (!options)
+                return -1;
+
+        snprintf (value, sizeof (value), "%ldMB", bm_state.cache_mb);
+        ret = dict_set_dynstr_with_alloc (options, "cache-size", value);
+        if (!ret)
+                ret = dict_set_str (options, "cache-timeout", "60");
+        if (!ret)
+                ret = dict_set_str (options, "cache-policy", (char *)policy);
+        if (ret) {
+                dict_unref (options);
+                return ret;
+        }
+
+        return bm_xlator_start (ioc, options);
+}
+
+static int
+bm_ioc (xlator_t *top, xlator_t *ioc)
+{
+        static const char *policies[] = {"lru", "2q"};
+        ioc_inode_t       *ioc_inode = NULL;
+        uint64_t           tmp = 0;
+        uint64_t           hits = 0;
+        uint64_t           misses = 0;
+        double             secs = 0;
+        long               ops = 0;
+        int                mode = 0;
+
+        bm_state.top = top;
+        bm_state.ioc = ioc;
+        top->ctx->page_size = BM_SCAN_SIZE;
+        bm_sink.size = bm_ioc_size;
+        bm_sink.readv = bm_ioc_fault;
+
+        printf ("%-6s %12s %14s %14s %12s\n", "policy", "hot-hit-%",
+                "hot-faults", "scan-faults", "reads/sec");
+
+        for (mode = 0; mode < 2; mode++) {
+                if (bm_ioc_start (ioc, policies[mode])) {
+                        fprintf (stderr, "failed to start io-cache\n");
+                        return -1;
+                }
+
+                if (bm_file_open (&bm_state.hot, "/hot",
+                                  bm_state.hot_mb << 20) ||
+                    bm_file_open (&bm_state.cold, "/cold",
+                                  bm_state.scan_mb << 20)) {
+                        fprintf (stderr, "failed to create the files\n");
+                        return -1;
+                }
+                inode_ctx_get (bm_state.hot.inode, ioc, &tmp);
+                ioc_inode = (ioc_inode_t *)(long)tmp;
+
+                /* warm up: the hot file alone, until it is all cached */
+                bm_state.measure = _gf_false;
+                ops = (bm_state.hot_mb << 20) / BM_READ_SIZE * 4;
+                bm_run (1, bm_reader, &ops);
+
+                GF_ATOMIC_INIT (bm_state.scan_off, 0);
+                GF_ATOMIC_INIT (bm_state.faults[0], 0);
+                GF_ATOMIC_INIT (bm_state.faults[1], 0);
+                ioc_inode_lock (ioc_inode);
+                {
+                        ioc_inode->hits = ioc_inode->misses = 0;
+                }
+                ioc_inode_unlock (ioc_inode);
+                bm_state.measure = _gf_true;
+
+                secs = bm_run (bm_state.nthreads, bm_reader, &bm_state.ops);
+
+                ioc_inode_lock (ioc_inode);
+                {
+                        hits = ioc_inode->hits;
+                        misses = ioc_inode->misses;
+                }
+                ioc_inode_unlock (ioc_inode);
+
+                printf ("%-6s %12.1f %14"PRIu64" %14"PRIu64" %12.0f\n",
+                        policies[mode],
+                        (hits + misses) ? 100.0 * hits / (hits + misses) : 0,
+                        GF_ATOMIC_GET (bm_state.faults[1]),
+                        GF_ATOMIC_GET (bm_state.faults[0]),
+                        bm_state.ops * bm_state.nthreads / secs);
+
+                bm_file_close (&bm_state.hot);
+                bm_file_close (&bm_state.cold);
+                bm_xlator_stop (ioc);
+        }
+
+        return 0;
+}
+
+static int
+bm_ioc_opt (int opt, char *arg)
+{
+        switch (opt) {
+        case 'c':
+                bm_state.cache_mb = atol (arg);
+                break;
+        case 'H':
+                bm_state.hot_mb = atol (arg);
+                break;
+        case 'S':
+                bm_state.scan_mb = atol (arg);
+                break;
+        case 'r':
+                bm_state.ratio = atoi (arg);
+                break;
+        case 't':
+                bm_state.nthreads = atoi (arg);
+                break;
+        case 'n':
+                bm_state.ops = atol (arg);
+                break;
+        case -1:
+                if (bm_state.cache_mb < 4 || bm_state.hot_mb < 1 ||
+                    bm_state.scan_mb < 1 || bm_state.ratio < 0 ||
+                    bm_state.nthreads < 1 || bm_state.ops < 1)
+                        return -1;
+                break;
+        default:
+                return -1;
+        }
+
+        return 0;
+}
+
+struct bm_xlator bm_xlator = {
+        .name          = "ioc-bm",
+        .type          = "performance/io-cache",
+        .fops          = &fops,
+        .cbks          = &cbks,
+        .options       = options,
+        .init          = init,
+        .fini          = fini,
+        .mem_acct_init = mem_acct_init,
+        .optstring     = "c:H:S:r:t:n:",
+        .usage         = "[-c cache-mb] [-H hot-mb] [-S scan-mb] "
+                         "[-r hot-reads-per-scan-read] [-t threads] "
+                         "[-n reads-per-thread]",
+        .opt           = bm_ioc_opt,
+        .run           = bm_ioc,
+};
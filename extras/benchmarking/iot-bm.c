@@ -0,0 +1,336 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* iot-bm: the io-threads translator under load, with the shared queue and
+ * with the work-stealing scheduler (performance.iot-work-stealing). 1..P
+ * producer threads each keep -q requests in flight through io-threads to a
+ * child that answers at once, after spinning -w microseconds to stand in
+ * for the brick. The mix is stat (high priority), setattr (normal) and
+ * truncate (low), 2:1:1. Prints requests/sec and the mean latency of each
+ * priority for both schedulers.
+ *
+ *   make -C extras/benchmarking iot-bm
+ *   ./extras/benchmarking/iot-bm -p 16 -T 16 -q 32 -n 200000 -w 0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <semaphore.h>
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "stack.h"
+#include "timespec.h"
+
+#include "bm-xlator.h"
+
+/* the translator under test, built into this program */
+extern struct xlator_fops fops;
+extern struct xlator_cbks cbks;
+extern struct volume_options options[];
+extern int init (xlator_t *this);
+extern void fini (xlator_t *this);
+extern int32_t mem_acct_init (xlator_t *this);
+
+enum {
+        BM_STAT,
+        BM_SETATTR,
+        BM_TRUNCATE,
+        BM_KINDS,
+};
+
+static const char *bm_kind_names[BM_KINDS] = {
+        "stat(hi)", "setattr(normal)", "truncate(low)",
+};
+
+struct bm_thread {
+        sem_t              slots;
+        int64_t            done[BM_KINDS];
+        int64_t            nsecs[BM_KINDS];
+};
+
+static struct {
+        xlator_t          *top;
+        xlator_t          *iot;
+        struct bm_thread  *thrs;
+        long               ops;
+        int                window;
+        int                maxproducers;
+        int                threads;
+} bm_state = {
+        .ops          = 200000,
+        .window       = 32,
+        .maxproducers = 8,
+        .threads      = 16,
+};
+
+static void
+bm_iot_done (call_frame_t *frame, int kind, int32_t op_ret)
+{
+        struct bm_thread *thr = frame->local;
+        struct timespec   now;
+
+        timespec_now (&now);
+        if (op_ret == 0) {
+                __atomic_add_fetch (&thr->done[kind], 1, __ATOMIC_RELAXED);
+                __atomic_add_fetch (&thr->nsecs[kind],
+                                    (now.tv_sec - frame->root->ctime.tv_sec) *
+                                    1000000000LL + now.tv_nsec -
+                                    frame->root->ctime.tv_nsec,
+                                    __ATOMIC_RELAXED);
+        }
+
+        frame->local = NULL;
+        STACK_DESTROY (frame->root);
+        sem_post (&thr->slots);
+}
+
+static int32_t
+bm_stat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+             int32_t op_ret, int32_t op_errno, struct iatt *buf,
+             dict_t *xdata)
+{
+        bm_iot_done (frame, BM_STAT, op_ret);
+        return 0;
+}
+
+static int32_t
+bm_setattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                struct iatt *post, dict_t *xdata)
+{
+        bm_iot_done (frame, BM_SETATTR, op_ret);
+        return 0;
+}
+
+static int32_t
+bm_truncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                 struct iatt *post, dict_t *xdata)
+{
+        bm_iot_done (frame, BM_TRUNCATE, op_ret);
+        return 0;
+}
+
+static void
+bm_producer (void *data, int index)
+{
+        struct bm_thread *thr = &bm_state.thrs[index];
+        xlator_t         *iot = bm_state.iot;
+        call_frame_t     *frame = NULL;
+        loc_t             loc = {0, };
+        struct iatt       stbuf = {0, };
+        long              i = 0;
+
+        loc.path = "/bm";
+        loc.name = "bm";
+
+        for (i = 0; i < bm_state.ops; i++) {
+                sem_wait (&thr->slots);
+
+                frame = create_frame (bm_state.top, bm_state.top->ctx->pool);
+                if (!frame) {
+                        sem_post (&thr->slots);
+                        break;
+                }
+                frame->local = thr;
+                timespec_now (&frame->root->ctime);
+
+                switch (i & 3) {
+                case 0:
+                case 2:
+                        STACK_WIND (frame, bm_stat_cbk, iot,
+                                    iot->fops->stat, &loc, NULL);
+                        break;
+                case 1:
+                        STACK_WIND (frame, bm_setattr_cbk, iot,
+                                    iot->fops->setattr, &loc, &stbuf,
+                                    GF_SET_ATTR_MODE, NULL);
+                        break;
+                case 3:
+                        STACK_WIND (frame, bm_truncate_cbk, iot,
+                                    iot->fops->truncate, &loc, 0, NULL);
+                        break;
+                }
+        }
+
+        /* wait for our requests still in flight */
+        for (i = 0; i < bm_state.window; i++)
+                sem_wait (&thr->slots);
+}
+
+static double
+bm_iot_run (int nthreads, double *latency)
+{
+        double   secs = 0;
+        int64_t  done[BM_KINDS] = {0, };
+        int64_t  nsecs[BM_KINDS] = {0, };
+        long     total = 0;
+        int      i = 0;
+        int      k = 0;
+
+        bm_state.thrs = calloc (nthreads, sizeof (*bm_state.thrs));
+        if (!bm_state.thrs) {
+                fprintf (stderr, "failed to allocate the producers\n");
+                exit (1);
+        }
+        for (i = 0; i < nthreads; i++)
+                sem_init (&bm_state.thrs[i].slots, 0, bm_state.window);
+
+        secs = bm_run (nthreads, bm_producer, NULL);
+
+        for (i = 0; i < nthreads; i++) {
+                sem_destroy (&bm_state.thrs[i].slots);
+                for (k = 0; k < BM_KINDS; k++) {
+                        done[k] += bm_state.thrs[i].done[k];
+                        nsecs[k] += bm_state.thrs[i].nsecs[k];
+                }
+        }
+        free (bm_state.thrs);
+        bm_state.thrs = NULL;
+
+        for (k = 0; k < BM_KINDS; k++) {
+                total += done[k];
+                latency[k] = done[k] ? (double)nsecs[k] / done[k] / 1000 : 0;
+        }
+
+        if (total != bm_state.ops * nthreads) {
+                fprintf (stderr, "%ld of %ld requests completed\n", total,
+                         bm_state.ops * nthreads);
+                exit (1);
+        }
+
+        return (double)total / secs;
+}
+
+static int
+bm_iot_start (xlator_t *iot, gf_boolean_t work_stealing)
+{
+        dict_t *options = NULL;
+        char    value[16];
+        int     ret = 0;
+
+        options = dict_new ();
+        if (!options)
+                return -1;
+
+        snprintf (value, sizeof (value), "%d", bm_state.threads);
+        ret = dict_set_dynstr_with_alloc (options, "thread-count", value);
+        if (!ret)
+                ret = dict_set_str (options, "work-stealing",
+                                    work_stealing ? "on" : "off");
+        if (ret) {
+                dict_unref (options);
+                return ret;
+        }
+
+        return bm_xlator_start (iot, options);
+}
+
+static void
+bm_iot_report (int mode, int nthreads)
+{
+        double rate = 0;
+        double latency[BM_KINDS];
+        int    k = 0;
+
+        rate = bm_iot_run (nthreads, latency);
+        printf ("%-14s %-9d %14.0f", mode ? "work-stealing" : "shared-queue",
+                nthreads, rate);
+        for (k = 0; k < BM_KINDS; k++)
+                printf (" %16.1f", latency[k]);
+        printf ("\n");
+}
+
+static int
+bm_iot (xlator_t *top, xlator_t *iot)
+{
+        int nthreads = 0;
+        int mode = 0;
+        int k = 0;
+
+        bm_state.top = top;
+        bm_state.iot = iot;
+
+        printf ("%-14s %-9s %14s", "scheduler", "producers", "requests/sec");
+        for (k = 0; k < BM_KINDS; k++)
+                printf (" %16s", bm_kind_names[k]);
+        printf ("\n%-14s %-9s %14s", "", "", "");
+        for (k = 0; k < BM_KINDS; k++)
+                printf (" %16s", "usecs");
+        printf ("\n");
+
+        for (mode = 0; mode < 2; mode++) {
+                if (bm_iot_start (iot, mode)) {
+                        fprintf (stderr, "failed to start io-threads\n");
+                        return -1;
+                }
+
+                for (nthreads = 1; nthreads <= bm_state.maxproducers;
+                     nthreads *= 2)
+                        bm_iot_report (mode, nthreads);
+                if (nthreads / 2 != bm_state.maxproducers)
+                        bm_iot_report (mode, bm_state.maxproducers);
+
+                bm_xlator_stop (iot);
+        }
+
+        return 0;
+}
+
+static int
+bm_iot_opt (int opt, char *arg)
+{
+        switch (opt) {
+        case 'p':
+                bm_state.maxproducers = atoi (arg);
+                break;
+        case 'T':
+                bm_state.threads = atoi (arg);
+                break;
+        case 'q':
+                bm_state.window = atoi (arg);
+                break;
+        case 'n':
+                bm_state.ops = atol (arg);
+                break;
+        case 'w':
+                bm_sink.spin_usecs = atol (arg);
+                break;
+        case -1:
+                if (bm_state.maxproducers < 1 || bm_state.threads < 1 ||
+                    bm_state.window < 1 || bm_state.ops < 1 ||
+                    bm_sink.spin_usecs < 0)
+                        return -1;
+                break;
+        default:
+                return -1;
+        }
+
+        return 0;
+}
+
+struct bm_xlator bm_xlator = {
+        .name          = "iot-bm",
+        .type          = "performance/io-threads",
+        .fops          = &fops,
+        .cbks          = &cbks,
+        .options       = options,
+        .init          = init,
+        .fini          = fini,
+        .mem_acct_init = mem_acct_init,
+        .optstring     = "p:T:q:n:w:",
+        .usage         = "[-p max-producers] [-T iot-threads] "
+                         "[-q requests-in-flight] [-n requests-per-producer] "
+                         "[-w spin-usecs]",
+        .opt           = bm_iot_opt,
+        .run           = bm_iot,
+};
@@ -0,0 +1,374 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* nlc-bm: a create storm through the nl-cache translator, the way a mail
+ * spool delivers: every message is looked up -l times in tmp/ (the first
+ * lookup misses and is cached as a negative entry), created there, linked
+ * into new/ and unlinked from tmp/. tmp/ collects one negative entry and
+ * new/ one named positive entry per message, so the checks of every later
+ * delivery run against directories of that many entries. Runs -n/100, -n/10
+ * and -n messages and prints deliveries/sec, lookups/sec of names not in
+ * the directory once it is full, and the cache bytes per message. The
+ * child answers every fop at once.
+ *
+ *   make -C extras/benchmarking nlc-bm
+ *   ./extras/benchmarking/nlc-bm -n 100000 -l 2 -m 100000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "stack.h"
+#include "nl-cache.h"
+
+#include "bm-xlator.h"
+
+/* the translator under test, built into this program */
+extern xlator_api_t xlator_api;
+
+static struct {
+        xlator_t          *top;
+        xlator_t          *nlc;
+        long               messages;
+        long               lookups;
+        long               misses;
+} bm_state = {
+        .messages = 100000,
+        .lookups  = 2,
+        .misses   = 100000,
+};
+
+static int32_t
+bm_entry_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, inode_t *inode,
+              struct iatt *buf, struct iatt *preparent,
+              struct iatt *postparent, dict_t *xdata)
+{
+        bm_done (frame, op_ret, op_errno);
+        return 0;
+}
+
+static int32_t
+bm_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, inode_t *inode,
+               struct iatt *buf, dict_t *xdata, struct iatt *postparent)
+{
+        bm_done (frame, op_ret, op_errno);
+        return 0;
+}
+
+static int32_t
+bm_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+               struct iatt *buf, struct iatt *preparent,
+               struct iatt *postparent, dict_t *xdata)
+{
+        bm_done (frame, op_ret, op_errno);
+        return 0;
+}
+
+static int32_t
+bm_unlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+               struct iatt *postparent, dict_t *xdata)
+{
+        bm_done (frame, op_ret, op_errno);
+        return 0;
+}
+
+static void
+bm_loc (loc_t *loc, inode_t *parent, const char *name, inode_t *inode)
+{
+        /* no path, the name is used as it is for the whole fop */
+        memset (loc, 0, sizeof (*loc));
+        loc->name = name;
+        loc->parent = parent;
+        loc->inode = inode;
+        gf_uuid_copy (loc->pargfid, parent->gfid);
+        gf_uuid_copy (loc->gfid, inode->gfid);
+}
+
+static int
+bm_lookup (inode_t *parent, const char *name)
+{
+        xlator_t       *nlc = bm_state.nlc;
+        call_frame_t   *frame = NULL;
+        struct bm_wait  wait;
+        inode_t        *inode = NULL;
+        loc_t           loc;
+
+        inode = inode_new (parent->table);
+        bm_loc (&loc, parent, name, inode);
+
+        frame = bm_frame (bm_state.top, &wait);
+        STACK_WIND (frame, bm_lookup_cbk, nlc, nlc->fops->lookup, &loc, NULL);
+        bm_wait (&wait);
+
+        inode_unref (inode);
+
+        return (wait.op_ret < 0 && wait.op_errno == ENOENT) ? 0 : -1;
+}
+
+static inode_t *
+bm_create (inode_t *parent, const char *name, gf_boolean_t dir)
+{
+        xlator_t       *nlc = bm_state.nlc;
+        call_frame_t   *frame = NULL;
+        struct bm_wait  wait;
+        inode_t        *inode = NULL;
+        inode_t        *linked = NULL;
+        fd_t           *fd = NULL;
+        struct iatt     buf;
+        loc_t           loc;
+
+        inode = inode_new (parent->table);
+        gf_uuid_generate (inode->gfid);
+        bm_loc (&loc, parent, name, inode);
+
+        frame = bm_frame (bm_state.top, &wait);
+        if (dir) {
+                STACK_WIND (frame, bm_entry_cbk, nlc, nlc->fops->mkdir, &loc,
+                            0755, 0, NULL);
+        } else {
+                fd = fd_create (inode, 0);
+                STACK_WIND (frame, bm_create_cbk, nlc, nlc->fops->create,
+                            &loc, O_CREAT | O_WRONLY, 0644, 0, fd, NULL);
+                fd_unref (fd);
+        }
+
+        if (bm_wait (&wait) < 0) {
+                inode_unref (inode);
+                return NULL;
+        }
+
+        /* as the mount does once the fop returned */
+        bm_iatt (&buf, loc.gfid, dir ? IA_IFDIR : IA_IFREG, 0);
+        linked = inode_link (inode, parent, name, &buf);
+        inode_unref (inode);
+
+        return linked;
+}
+
+static int
+bm_link (inode_t *inode, inode_t *oldparent, const char *oldname,
+         inode_t *newparent, const char *newname)
+{
+        xlator_t       *nlc = bm_state.nlc;
+        call_frame_t   *frame = NULL;
+        struct bm_wait  wait;
+        struct iatt     buf;
+        loc_t           oldloc;
+        loc_t           newloc;
+
+        bm_loc (&oldloc, oldparent, oldname, inode);
+        bm_loc (&newloc, newparent, newname, inode);
+
+        frame = bm_frame (bm_state.top, &wait);
+        STACK_WIND (frame, bm_entry_cbk, nlc, nlc->fops->link, &oldloc,
+                    &newloc, NULL);
+        if (bm_wait (&wait) < 0)
+                return -1;
+
+        bm_iatt (&buf, inode->gfid, IA_IFREG, 0);
+        inode_unref (inode_link (inode, newparent, newname, &buf));
+
+        return 0;
+}
+
+static int
+bm_unlink (inode_t *inode, inode_t *parent, const char *name,
+           gf_boolean_t dir)
+{
+        xlator_t       *nlc = bm_state.nlc;
+        call_frame_t   *frame = NULL;
+        struct bm_wait  wait;
+        loc_t           loc;
+
+        bm_loc (&loc, parent, name, inode);
+
+        frame = bm_frame (bm_state.top, &wait);
+        if (dir)
+                STACK_WIND (frame, bm_unlink_cbk, nlc, nlc->fops->rmdir,
+                            &loc, 0, NULL);
+        else
+                STACK_WIND (frame, bm_unlink_cbk, nlc, nlc->fops->unlink,
+                            &loc, 0, NULL);
+        if (bm_wait (&wait) < 0)
+                return -1;
+
+        inode_unlink (inode, parent, name);
+
+        return 0;
+}
+
+static void
+bm_fail (const char *what, const char *name)
+{
+        fprintf (stderr, "%s of %s failed\n", what, name);
+        exit (1);
+}
+
+/* delivers count messages, returns deliveries/sec and the lookups/sec of
+ * names that are not in the full tmp/ in lookup_rate */
+static double
+bm_deliver (inode_t *root, long count, double *lookup_rate, double *bytes)
+{
+        nlc_conf_t  *conf = bm_state.nlc->private;
+        inode_t    **inodes = NULL;
+        inode_t     *tmp = NULL;
+        inode_t     *new = NULL;
+        char         name[64];
+        double       start = 0;
+        double       rate = 0;
+        int64_t      base = 0;
+        long         i = 0;
+        long         j = 0;
+
+        inodes = calloc (count, sizeof (*inodes));
+        if (!inodes)
+                bm_fail ("allocation", "inodes");
+
+        tmp = bm_create (root, "tmp", _gf_true);
+        new = bm_create (root, "new", _gf_true);
+        if (!tmp || !new)
+                bm_fail ("mkdir", "tmp and new");
+
+        base = GF_ATOMIC_GET (conf->current_cache_size);
+        start = bm_now ();
+
+        for (i = 0; i < count; i++) {
+                snprintf (name, sizeof (name), "%ld.M%ldP%d.host", 1500000000
+                          + i / 16, i, getpid ());
+                for (j = 0; j < bm_state.lookups; j++) {
+                        if (bm_lookup (tmp, name))
+                                bm_fail ("lookup", name);
+                }
+                inodes[i] = bm_create (tmp, name, _gf_false);
+                if (!inodes[i])
+                        bm_fail ("create", name);
+                if (bm_link (inodes[i], tmp, name, new, name))
+                        bm_fail ("link", name);
+                if (bm_unlink (inodes[i], tmp, name, _gf_false))
+                        bm_fail ("unlink", name);
+        }
+
+        rate = count / (bm_now () - start);
+        *bytes = (double)(GF_ATOMIC_GET (conf->current_cache_size) - base) /
+                 count;
+
+        start = bm_now ();
+        for (i = 0; i < bm_state.misses; i++) {
+                snprintf (name, sizeof (name), "absent.%ld", i);
+                if (bm_lookup (tmp, name))
+                        bm_fail ("lookup", name);
+        }
+        *lookup_rate = bm_state.misses / (bm_now () - start);
+
+        for (i = 0; i < count; i++) {
+                snprintf (name, sizeof (name), "%ld.M%ldP%d.host", 1500000000
+                          + i / 16, i, getpid ());
+                inode_unlink (inodes[i], new, name);
+                inode_unref (inodes[i]);
+        }
+        free (inodes);
+
+        /* drops the cache of both */
+        if (bm_unlink (tmp, root, "tmp", _gf_true) ||
+            bm_unlink (new, root, "new", _gf_true))
+                bm_fail ("rmdir", "tmp and new");
+        inode_unref (tmp);
+        inode_unref (new);
+
+        return rate;
+}
+
+static int
+bm_nlc (xlator_t *top, xlator_t *nlc)
+{
+        dict_t *options = NULL;
+        double  rate = 0;
+        double  lookup_rate = 0;
+        double  bytes = 0;
+        long    count = 0;
+        long    div = 0;
+
+        bm_state.top = top;
+        bm_state.nlc = nlc;
+
+        /* no limit but the one on the inodes, and no expiry during a run */
+        options = dict_new ();
+        if (!options ||
+            dict_set_str (options, "nl-cache-positive-entry", "on") ||
+            dict_set_str (options, "nl-cache-limit", "4GB") ||
+            dict_set_str (options, "nl-cache-timeout", "3600")) {
+                fprintf (stderr, "failed to set the options\n");
+                return -1;
+        }
+        if (bm_xlator_start (nlc, options)) {
+                fprintf (stderr, "failed to start nl-cache\n");
+                return -1;
+        }
+
+        printf ("%10s %15s %15s %15s\n", "messages", "deliveries/s",
+                "lookups/s", "bytes/message");
+
+        for (div = 100; div >= 1; div /= 10) {
+                count = bm_state.messages / div;
+                rate = bm_deliver (top->itable->root, count, &lookup_rate,
+                                   &bytes);
+                printf ("%10ld %15.0f %15.0f %15.1f\n", count, rate,
+                        lookup_rate, bytes);
+                fflush (stdout);
+        }
+
+        bm_xlator_stop (nlc);
+
+        return 0;
+}
+
+static int
+bm_nlc_opt (int opt, char *arg)
+{
+        switch (opt) {
+        case 'n':
+                bm_state.messages = atol (arg);
+                break;
+        case 'l':
+                bm_state.lookups = atol (arg);
+                break;
+        case 'm':
+                bm_state.misses = atol (arg);
+                break;
+        case -1:
+                if (bm_state.messages < 100 || bm_state.lookups < 0 ||
+                    bm_state.misses < 1)
+                        return -1;
+                break;
+        default:
+                return -1;
+        }
+
+        return 0;
+}
+
+struct bm_xlator bm_xlator = {
+        .name      = "nlc-bm",
+        .type      = "performance/nl-cache",
+        .api       = &xlator_api,
+        .optstring = "n:l:m:",
+        .usage     = "[-n messages] [-l lookups-per-create] "
+                     "[-m absent-lookups]",
+        .opt       = bm_nlc_opt,
+        .run       = bm_nlc,
+};
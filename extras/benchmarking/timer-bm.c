@@ -0,0 +1,208 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* timer-bm: measure the cost of gf_timer_call_after(), gf_timer_call_cancel()
+ * and of firing timers with a large number of outstanding timers.
+ *
+ *   make -C extras/benchmarking timer-bm
+ *   ./extras/benchmarking/timer-bm -n 100000
+ *
+ * insert - arm N timers due in 10s..1h (frame-timeout/ping-timer like)
+ * cancel - cancel all of them, in random order
+ * fire   - arm N timers due within the next 500ms and wait for all of them,
+ *          reporting how late the callbacks ran
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "xlator.h"
+#include "timer.h"
+#include "timespec.h"
+#include "mem-pool.h"
+#include "mem-types.h"
+
+struct bm_fire {
+        struct timespec   at;
+        gf_atomic_t      *fired;
+        gf_atomic_t      *late_sum;
+        gf_atomic_t      *late_max;
+};
+
+static double
+bm_now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bm_nop (void *data)
+{
+}
+
+static void
+bm_fired (void *data)
+{
+        struct bm_fire  *fire = data;
+        struct timespec  now = {0, };
+        int64_t          late = 0;
+        int64_t          max = 0;
+
+        timespec_now (&now);
+        late = TS (now) - TS (fire->at);
+
+        GF_ATOMIC_ADD (*fire->late_sum, late);
+        do {
+                max = GF_ATOMIC_GET (*fire->late_max);
+                if (late <= max)
+                        break;
+        } while (!GF_ATOMIC_CMP_SWAP (*fire->late_max, max, late));
+
+        GF_ATOMIC_INC (*fire->fired);
+}
+
+static struct timespec
+bm_delta (uint64_t ns)
+{
+        struct timespec delta = {0, };
+
+        delta.tv_sec = ns / 1000000000ULL;
+        delta.tv_nsec = ns % 1000000000ULL;
+
+        return delta;
+}
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-n outstanding-timers]\n", prog);
+        exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+        glusterfs_ctx_t  *ctx = NULL;
+        gf_timer_t      **timers = NULL;
+        struct bm_fire   *fires = NULL;
+        gf_atomic_t       fired;
+        gf_atomic_t       late_sum;
+        gf_atomic_t       late_max;
+        unsigned int      seed = 1;
+        double            start = 0;
+        double            elapsed = 0;
+        uint64_t          ns = 0;
+        long              count = 100000;
+        long              i = 0;
+        long              j = 0;
+        int               opt = 0;
+
+        while ((opt = getopt (argc, argv, "n:")) != -1) {
+                switch (opt) {
+                case 'n':
+                        count = atol (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                }
+        }
+
+        if (count < 1)
+                usage (argv[0]);
+
+        mem_pools_init_early ();
+        mem_pools_init_late ();
+
+        ctx = glusterfs_ctx_new ();
+        if (!ctx || glusterfs_globals_init (ctx)) {
+                fprintf (stderr, "failed to initialize glusterfs context\n");
+                return 1;
+        }
+        THIS->ctx = ctx;
+
+        if (xlator_mem_acct_init (THIS, gf_common_mt_end + 1)) {
+                fprintf (stderr, "failed to initialize memory accounting\n");
+                return 1;
+        }
+
+        timers = calloc (count, sizeof (*timers));
+        fires = calloc (count, sizeof (*fires));
+
+        /* warm up the registry and the timer thread */
+        gf_timer_call_cancel (ctx, gf_timer_call_after (ctx, bm_delta (0),
+                                                        bm_nop, NULL));
+
+        start = bm_now ();
+        for (i = 0; i < count; i++) {
+                ns = (10 + rand_r (&seed) % 3590) * 1000000000ULL +
+                     rand_r (&seed) % 1000000000ULL;
+                timers[i] = gf_timer_call_after (ctx, bm_delta (ns), bm_nop,
+                                                 NULL);
+        }
+        elapsed = bm_now () - start;
+        printf ("insert %8ld timers: %10.1f ns/op\n", count,
+                elapsed * 1e9 / count);
+
+        for (i = count - 1; i > 0; i--) {
+                gf_timer_t *tmp = NULL;
+
+                j = rand_r (&seed) % (i + 1);
+                tmp = timers[i];
+                timers[i] = timers[j];
+                timers[j] = tmp;
+        }
+
+        start = bm_now ();
+        for (i = 0; i < count; i++)
+                gf_timer_call_cancel (ctx, timers[i]);
+        elapsed = bm_now () - start;
+        printf ("cancel %8ld timers: %10.1f ns/op\n", count,
+                elapsed * 1e9 / count);
+
+        GF_ATOMIC_INIT (fired, 0);
+        GF_ATOMIC_INIT (late_sum, 0);
+        GF_ATOMIC_INIT (late_max, 0);
+
+        start = bm_now ();
+        for (i = 0; i < count; i++) {
+                ns = rand_r (&seed) % 500000000ULL;
+                fires[i].fired = &fired;
+                fires[i].late_sum = &late_sum;
+                fires[i].late_max = &late_max;
+                timespec_now (&fires[i].at);
+                fires[i].at.tv_nsec += ns;
+                fires[i].at.tv_sec += fires[i].at.tv_nsec / 1000000000L;
+                fires[i].at.tv_nsec %= 1000000000L;
+                gf_timer_call_after (ctx, bm_delta (ns), bm_fired, &fires[i]);
+        }
+        while (GF_ATOMIC_GET (fired) < count)
+                usleep (1000);
+        elapsed = bm_now () - start;
+        printf ("fire   %8ld timers: %10.1f ms total, lateness avg %.3f ms "
+                "max %.3f ms\n", count, elapsed * 1e3,
+                GF_ATOMIC_GET (late_sum) / 1e6 / count,
+                GF_ATOMIC_GET (late_max) / 1e6);
+
+        gf_timer_registry_destroy (ctx);
+
+        free (fires);
+        free (timers);
+
+        return 0;
+}
@@ -261,6 +261,10 @@ static struct argp_option gf_options[] = {
         {"attr-times-granularity", ARGP_ATTR_TIMES_GRANULARITY_KEY, "NS",
          OPTION_ARG_OPTIONAL, "declare supported granularity of file attribute"
          " times in nanoseconds"},
+        {"max-write", ARGP_FUSE_MAX_WRITE_KEY, "SIZE", 0,
+         "largest fuse READ and WRITE request [default: 1MB]"},
+        {"splice-read", ARGP_FUSE_SPLICE_READ_KEY, "BOOL",
+         OPTION_ARG_OPTIONAL, "splice fuse READ replies to the kernel"},
         {0, 0, 0, 0, "Miscellaneous Options:"},
         {0, }
 };
@@ -659,6 +663,24 @@ set_fuse_mount_options (glusterfs_ctx_t *ctx, dict_t *options)
                         goto err;
                 }
         }
+        if (cmd_args->fuse_max_write) {
+                ret = dict_set_uint64 (options, "max-write",
+                                       cmd_args->fuse_max_write);
+                if (ret < 0) {
+                        gf_msg ("glusterfsd", GF_LOG_ERROR, 0, glusterfsd_msg_4,
+                                "failed to set dict value for key max-write");
+                        goto err;
+                }
+        }
+        if (cmd_args->fuse_splice_read) {
+                ret = dict_set_static_ptr (options, "splice-read", "on");
+                if (ret < 0) {
+                        gf_msg ("glusterfsd", GF_LOG_ERROR, 0, glusterfsd_msg_4,
+                                "failed to set dict value for key "
+                                "splice-read");
+                        goto err;
+                }
+        }
 
 
         ret = 0;
@@ -1454,6 +1476,34 @@ no_oom_api:
 
                 break;
 
+        case ARGP_FUSE_MAX_WRITE_KEY:
+                if (gf_string2bytesize_uint64 (arg,
+                                               &cmd_args->fuse_max_write)) {
+                        argp_failure (state, -1, 0,
+                                      "unknown max-write option %s", arg);
+                } else if (cmd_args->fuse_max_write < 4 * GF_UNIT_KB ||
+                           cmd_args->fuse_max_write > GF_UNIT_MB) {
+                        argp_failure (state, -1, 0,
+                                      "Invalid max-write value %s. "
+                                      "Valid range: [\"4KB, 1MB\"]", arg);
+                }
+
+                break;
+
+        case ARGP_FUSE_SPLICE_READ_KEY:
+                if (!arg)
+                        arg = "yes";
+
+                if (gf_string2boolean (arg, &b) == 0) {
+                        cmd_args->fuse_splice_read = b;
+
+                        break;
+                }
+
+                argp_failure (state, -1, 0,
+                              "unknown splice read setting \"%s\"", arg);
+                break;
+
 	}
         return 0;
 }
@@ -1688,23 +1738,7 @@ glusterfs_ctx_defaults_init (glusterfs_ctx_t *ctx)
                 goto out;
         }
 
-        INIT_LIST_HEAD (&ctx->pool->all_frames);
-        LOCK_INIT (&ctx->pool->lock);
-
-        /* frame_mem_pool size 112 * 4k */
-        ctx->pool->frame_mem_pool = mem_pool_new (call_frame_t, 4096);
-        if (!ctx->pool->frame_mem_pool) {
-                gf_msg ("", GF_LOG_CRITICAL, 0, glusterfsd_msg_14,
-                        "ERROR: glusterfs frame pool creation failed");
-                goto out;
-        }
-        /* stack_mem_pool size 256 * 1024 */
-        ctx->pool->stack_mem_pool = mem_pool_new (call_stack_t, 1024);
-        if (!ctx->pool->stack_mem_pool) {
-                gf_msg ("", GF_LOG_CRITICAL, 0, glusterfsd_msg_14,
-                        "ERROR: glusterfs stack pool creation failed");
-                goto out;
-        }
+        call_pool_init (ctx->pool);
 
         ctx->stub_mem_pool = mem_pool_new (call_stub_t, 1024);
         if (!ctx->stub_mem_pool) {
@@ -1775,10 +1809,8 @@ glusterfs_ctx_defaults_init (glusterfs_ctx_t *ctx)
 out:
 
         if (ret && ctx) {
-                if (ctx->pool) {
-                        mem_pool_destroy (ctx->pool->frame_mem_pool);
-                        mem_pool_destroy (ctx->pool->stack_mem_pool);
-                }
+                if (ctx->pool)
+                        call_pool_fini (ctx->pool);
                 GF_FREE (ctx->pool);
                 mem_pool_destroy (ctx->stub_mem_pool);
                 mem_pool_destroy (ctx->dict_pool);
@@ -107,6 +107,8 @@ enum argp_option_keys {
         ARGP_PRINT_LOGDIR_KEY             = 185,
         ARGP_KERNEL_WRITEBACK_CACHE_KEY   = 186,
         ARGP_ATTR_TIMES_GRANULARITY_KEY   = 187,
+        ARGP_FUSE_MAX_WRITE_KEY           = 188,
+        ARGP_FUSE_SPLICE_READ_KEY         = 189,
 };
 
 struct _gfd_vol_top_priv {
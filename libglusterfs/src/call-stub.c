@@ -2129,6 +2129,49 @@ fop_namelink_cbk_stub (call_frame_t *frame,
         return stub;
 }
 
+call_stub_t *
+fop_copy_file_range_stub (call_frame_t *frame, fop_copy_file_range_t fn,
+                          fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                          off_t off_out, size_t len, uint32_t flags,
+                          dict_t *xdata)
+{
+        call_stub_t *stub = NULL;
+
+        GF_VALIDATE_OR_GOTO ("call-stub", frame, out);
+        GF_VALIDATE_OR_GOTO ("call-stub", fn, out);
+
+        stub = stub_new (frame, 1, GF_FOP_COPY_FILE_RANGE);
+        GF_VALIDATE_OR_GOTO ("call-stub", stub, out);
+
+        stub->fn.copy_file_range = fn;
+        args_copy_file_range_store (&stub->args, fd_in, off_in, fd_out,
+                                    off_out, len, flags, xdata);
+ out:
+        return stub;
+}
+
+call_stub_t *
+fop_copy_file_range_cbk_stub (call_frame_t *frame,
+                              fop_copy_file_range_cbk_t fn,
+                              int32_t op_ret, int32_t op_errno,
+                              struct iatt *stbuf, struct iatt *prebuf_dst,
+                              struct iatt *postbuf_dst, dict_t *xdata)
+{
+        call_stub_t *stub = NULL;
+
+        GF_VALIDATE_OR_GOTO ("call-stub", frame, out);
+
+        stub = stub_new (frame, 0, GF_FOP_COPY_FILE_RANGE);
+        GF_VALIDATE_OR_GOTO ("call-stub", stub, out);
+
+        stub->fn_cbk.copy_file_range = fn;
+        args_copy_file_range_cbk_store (&stub->args_cbk, op_ret, op_errno,
+                                        stbuf, prebuf_dst, postbuf_dst,
+                                        xdata);
+ out:
+        return stub;
+}
+
 void
 call_resume_wind (call_stub_t *stub)
 {
@@ -2396,6 +2439,15 @@ call_resume_wind (call_stub_t *stub)
                               stub->args.xdata);
                 break;
 
+        case GF_FOP_COPY_FILE_RANGE:
+                stub->fn.copy_file_range (stub->frame, stub->frame->this,
+                                          stub->args.fd, stub->args.offset,
+                                          stub->args.fd_dst,
+                                          stub->args.off_out,
+                                          stub->args.size, stub->args.flags,
+                                          stub->args.xdata);
+                break;
+
         default:
                 gf_msg_callingfn ("call-stub", GF_LOG_ERROR, EINVAL,
                                   LG_MSG_INVALID_ENTRY, "Invalid value of FOP"
@@ -2631,6 +2683,13 @@ call_resume_unwind (call_stub_t *stub)
                              stub->args_cbk.xdata);
                 break;
 
+        case GF_FOP_COPY_FILE_RANGE:
+                STUB_UNWIND (stub, copy_file_range, &stub->args_cbk.stat,
+                             &stub->args_cbk.prestat,
+                             &stub->args_cbk.poststat,
+                             stub->args_cbk.xdata);
+                break;
+
         default:
                 gf_msg_callingfn ("call-stub", GF_LOG_ERROR, EINVAL,
                                   LG_MSG_INVALID_ENTRY, "Invalid value of FOP"
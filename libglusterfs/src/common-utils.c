@@ -706,6 +706,7 @@ gf_print_trace (int32_t signum, glusterfs_ctx_t *ctx)
         char         msg[1024] = {0,};
         char         timestr[64] = {0,};
         call_stack_t *stack = NULL;
+        int           shard = 0;
 
         /* Now every gf_log call will just write to a buffer and when the
          * buffer becomes full, its written to the log-file. Suppose the process
@@ -721,9 +722,8 @@ gf_print_trace (int32_t signum, glusterfs_ctx_t *ctx)
         /* Pending frames, (if any), list them in order */
         gf_msg_plain_nomem (GF_LOG_ALERT, "pending frames:");
         {
-                /* FIXME: traversing stacks outside pool->lock */
-                list_for_each_entry (stack, &ctx->pool->all_frames,
-                                     all_frames) {
+                /* FIXME: traversing stacks outside the pool locks */
+                call_pool_for_each_stack (stack, ctx->pool, shard) {
                         if (stack->type == GF_OP_TYPE_FOP)
                                 sprintf (msg,"frame : type(%d) op(%s)",
                                          stack->type,
@@ -4811,6 +4811,7 @@ fop_enum_to_pri_string (glusterfs_fop_t fop)
         case GF_FOP_ZEROFILL:
         case GF_FOP_FALLOCATE:
         case GF_FOP_SEEK:
+        case GF_FOP_COPY_FILE_RANGE:
                 return "LOW";
 
         case GF_FOP_NULL:
@@ -496,6 +496,17 @@ args_icreate_store (default_args_t *args,
 int
 args_namelink_store (default_args_t *args, loc_t *loc, dict_t *xdata);
 
+int
+args_copy_file_range_store (default_args_t *args, fd_t *fd_in,
+                            off_t off_in, fd_t *fd_out, off_t off_out,
+                            size_t len, uint32_t flags, dict_t *xdata);
+
+int
+args_copy_file_range_cbk_store (default_args_cbk_t *args, int32_t op_ret,
+                                int32_t op_errno, struct iatt *stbuf,
+                                struct iatt *prebuf_dst,
+                                struct iatt *postbuf_dst, dict_t *xdata);
+
 void
 args_cbk_init (default_args_cbk_t *args_cbk);
 #endif /* _DEFAULT_ARGS_H */
@@ -11,7 +11,7 @@
 /* libglusterfs/src/defaults.c:
    This file contains functions, which are used to fill the 'fops', 'cbk'
    structures in the xlator structures, if they are not written. Here, all the
-   function calls are plainly forwared to the first child of the xlator, and
+   function calls are plainly forwarded to the first child of the xlator, and
    all the *_cbk function does plain STACK_UNWIND of the frame, and returns.
 
    This function also implements *_resume () functions, which does same
@@ -270,6 +270,14 @@ default_truncate_failure_cbk (call_frame_t *frame, int32_t op_errno)
 }
 
 
+int32_t
+default_copy_file_range_failure_cbk (call_frame_t *frame, int32_t op_errno)
+{
+	STACK_UNWIND_STRICT (copy_file_range, frame, -1, op_errno, NULL, NULL, NULL, NULL);
+	return 0;
+}
+
+
 int32_t
 default_getxattr_failure_cbk (call_frame_t *frame, int32_t op_errno)
 {
@@ -799,6 +807,19 @@ default_truncate_cbk_resume (call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 
+int32_t
+default_copy_file_range_cbk_resume (call_frame_t *frame, void *cookie, xlator_t *this,
+			   int32_t op_ret, int32_t op_errno, struct iatt * stbuf,
+	struct iatt * prebuf_dst,
+	struct iatt * postbuf_dst,
+	dict_t * xdata)
+{
+	STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno,
+			     stbuf, prebuf_dst, postbuf_dst, xdata);
+	return 0;
+}
+
+
 int32_t
 default_getxattr_cbk_resume (call_frame_t *frame, void *cookie, xlator_t *this,
 			   int32_t op_ret, int32_t op_errno, dict_t * dict,
@@ -1411,6 +1432,19 @@ default_truncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 
+int32_t
+default_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+		    int32_t op_ret, int32_t op_errno, struct iatt * stbuf,
+	struct iatt * prebuf_dst,
+	struct iatt * postbuf_dst,
+	dict_t * xdata)
+{
+	STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno,
+			     stbuf, prebuf_dst, postbuf_dst, xdata);
+	return 0;
+}
+
+
 int32_t
 default_getxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 		    int32_t op_ret, int32_t op_errno, dict_t * dict,
@@ -2059,6 +2093,22 @@ default_truncate_resume (call_frame_t *frame, xlator_t *this, loc_t * loc,
 }
 
 
+int32_t
+default_copy_file_range_resume (call_frame_t *frame, xlator_t *this, fd_t * fd_in,
+	off_t off_in,
+	fd_t * fd_out,
+	off_t off_out,
+	size_t len,
+	uint32_t flags,
+	dict_t * xdata)
+{
+	STACK_WIND (frame, default_copy_file_range_cbk,
+		    FIRST_CHILD(this), FIRST_CHILD(this)->fops->copy_file_range,
+		    fd_in, off_in, fd_out, off_out, len, flags, xdata);
+	return 0;
+}
+
+
 int32_t
 default_getxattr_resume (call_frame_t *frame, xlator_t *this, loc_t * loc,
 	const char * name,
@@ -2822,6 +2872,25 @@ default_truncate (
 }
 
 
+int32_t
+default_copy_file_range (
+	call_frame_t *frame,
+	xlator_t *this,
+	fd_t * fd_in,
+	off_t off_in,
+	fd_t * fd_out,
+	off_t off_out,
+	size_t len,
+	uint32_t flags,
+	dict_t * xdata)
+{
+	STACK_WIND_TAIL (frame,
+			 FIRST_CHILD(this), FIRST_CHILD(this)->fops->copy_file_range,
+			 fd_in, off_in, fd_out, off_out, len, flags, xdata);
+	return 0;
+}
+
+
 int32_t
 default_getxattr (
 	call_frame_t *frame,
@@ -3238,6 +3307,7 @@ struct xlator_fops _default_fops = {
         .put = default_put,
         .icreate = default_icreate,
         .namelink = default_namelink,
+        .copy_file_range = default_copy_file_range,
 };
 struct xlator_fops *default_fops = &_default_fops;
 
@@ -51,7 +51,9 @@ typedef struct {
         loc_t loc; /* @old in rename(), link() */
         loc_t loc2; /* @new in rename(), link() */
         fd_t *fd;
+        fd_t *fd_dst; /* @fd_out in copy_file_range() */
         off_t offset;
+        off_t off_out; /* @off_out in copy_file_range() */
         int mask;
         size_t size;
         mode_t mode;
@@ -365,6 +367,11 @@ int32_t default_icreate (call_frame_t *frame, xlator_t *this,
 int32_t default_namelink (call_frame_t *frame,
                           xlator_t *this, loc_t *loc, dict_t *xdata);
 
+int32_t default_copy_file_range (call_frame_t *frame, xlator_t *this,
+                                 fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                                 off_t off_out, size_t len, uint32_t flags,
+                                 dict_t *xdata);
+
 /* Resume */
 int32_t default_getspec_resume (call_frame_t *frame,
                                 xlator_t *this,
@@ -918,6 +925,13 @@ default_put_cbk_resume (call_frame_t *frame, void *cookie, xlator_t *this,
                         struct iatt *buf, struct iatt *preparent,
                         struct iatt *postparent, dict_t *xdata);
 
+int32_t
+default_copy_file_range_cbk_resume (call_frame_t *frame, void *cookie,
+                                    xlator_t *this, int32_t op_ret,
+                                    int32_t op_errno, struct iatt *stbuf,
+                                    struct iatt *prebuf_dst,
+                                    struct iatt *postbuf_dst, dict_t *xdata);
+
 int32_t
 default_icreate_resume (call_frame_t *frame, xlator_t *this,
                         loc_t *loc, mode_t mode, dict_t *xdata);
@@ -926,6 +940,12 @@ int32_t
 default_namelink_resume (call_frame_t *frame,
                          xlator_t *this, loc_t *loc, dict_t *xdata);
 
+int32_t
+default_copy_file_range_resume (call_frame_t *frame, xlator_t *this,
+                                fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                                off_t off_out, size_t len, uint32_t flags,
+                                dict_t *xdata);
+
 /* _CBK */
 int32_t
 default_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
@@ -1191,6 +1211,13 @@ default_namelink_cbk (call_frame_t *frame, void *cookie,
                       int32_t op_errno, struct iatt *prebuf,
                       struct iatt *postbuf, dict_t *xdata);
 
+int32_t
+default_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                             xlator_t *this, int32_t op_ret,
+                             int32_t op_errno, struct iatt *stbuf,
+                             struct iatt *prebuf_dst,
+                             struct iatt *postbuf_dst, dict_t *xdata);
+
 int32_t
 default_lookup_failure_cbk (call_frame_t *frame, int32_t op_errno);
 
@@ -1352,6 +1379,9 @@ default_icreate_failure_cbk (call_frame_t *frame, int32_t op_errno);
 int32_t
 default_namelink_failure_cbk (call_frame_t *frame, int32_t op_errno);
 
+int32_t
+default_copy_file_range_failure_cbk (call_frame_t *frame, int32_t op_errno);
+
 int32_t
 default_mem_acct_init (xlator_t *this);
 
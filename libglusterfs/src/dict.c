@@ -66,6 +66,318 @@ get_new_data ()
         return data;
 }
 
+/* marks a deleted slot of the index, probing continues past it */
+static data_pair_t dict_index_deleted;
+
+/**
+ * Well known keys that are set on a large share of the fops. Pairs for
+ * them point at these strings instead of copying the key.
+ */
+static char *dict_interned_keys[] = {
+        "gfid-req",
+        GF_XATTROP_INDEX_GFID,
+        GF_XATTROP_ENTRY_CHANGES_GFID,
+        GF_XATTROP_INDEX_COUNT,
+        GF_XATTROP_DIRTY_GFID,
+        GF_XATTROP_DIRTY_COUNT,
+        GF_XATTROP_ENTRY_IN_KEY,
+        GF_XATTROP_ENTRY_OUT_KEY,
+        GF_XATTROP_PURGE_INDEX,
+        GLUSTERFS_INTERNAL_FOP_KEY,
+        GLUSTERFS_OPEN_FD_COUNT,
+        GLUSTERFS_ACTIVE_FD_COUNT,
+        GLUSTERFS_INODELK_COUNT,
+        GLUSTERFS_ENTRYLK_COUNT,
+        GLUSTERFS_POSIXLK_COUNT,
+        GLUSTERFS_PARENT_ENTRYLK,
+        GLUSTERFS_INODELK_DOM_COUNT,
+        GF_REQUEST_LINK_COUNT_XDATA,
+        GF_GFIDLESS_LOOKUP,
+        GF_PREOP_PARENT_KEY,
+        GF_PREOP_CHECK_FAILED,
+        GF_CONTENT_KEY,
+        GET_ANCESTRY_PATH_KEY,
+        GET_ANCESTRY_DENTRY_KEY,
+        GLUSTERFS_VERSION_XCHG_KEY,
+        GLUSTERFS_DURABLE_OP,
+        DHT_IATT_IN_XDATA_KEY,
+        "link-count",
+        NULL
+};
+
+#define DICT_INTERN_SLOTS 128
+
+static struct {
+        char     *key;
+        uint32_t  len;
+        uint32_t  hash;
+} dict_intern_table[DICT_INTERN_SLOTS];
+
+static pthread_once_t dict_intern_once = PTHREAD_ONCE_INIT;
+
+static void
+dict_intern_init (void)
+{
+        uint32_t len  = 0;
+        uint32_t hash = 0;
+        uint32_t slot = 0;
+        int      i    = 0;
+
+        for (i = 0; dict_interned_keys[i]; i++) {
+                len = strlen (dict_interned_keys[i]);
+                hash = SuperFastHash (dict_interned_keys[i], len);
+
+                slot = hash & (DICT_INTERN_SLOTS - 1);
+                while (dict_intern_table[slot].key)
+                        slot = (slot + 1) & (DICT_INTERN_SLOTS - 1);
+
+                dict_intern_table[slot].key = dict_interned_keys[i];
+                dict_intern_table[slot].len = len;
+                dict_intern_table[slot].hash = hash;
+        }
+}
+
+static char *
+dict_intern_lookup (char *key, uint32_t len, uint32_t hash)
+{
+        uint32_t slot = hash & (DICT_INTERN_SLOTS - 1);
+
+        (void) pthread_once (&dict_intern_once, dict_intern_init);
+
+        while (dict_intern_table[slot].key) {
+                if ((dict_intern_table[slot].hash == hash) &&
+                    (dict_intern_table[slot].len == len) &&
+                    !memcmp (dict_intern_table[slot].key, key, len))
+                        return dict_intern_table[slot].key;
+
+                slot = (slot + 1) & (DICT_INTERN_SLOTS - 1);
+        }
+
+        return NULL;
+}
+
+static void
+dict_index_insert_slot (data_pair_t **index, uint32_t size, data_pair_t *pair)
+{
+        uint32_t slot = pair->key_hash & (size - 1);
+
+        while (index[slot])
+                slot = (slot + 1) & (size - 1);
+
+        index[slot] = pair;
+}
+
+/**
+ * (re)build the index of @this with room for @count pairs, dropping the
+ * deleted slots. Pairs are inserted oldest first so that of duplicate keys
+ * added with dict_add () the newest is the last one met while probing.
+ */
+static int
+dict_index_rebuild (dict_t *this, uint32_t count)
+{
+        data_pair_t **index = NULL;
+        data_pair_t  *pair  = NULL;
+        data_pair_t  *last  = NULL;
+        uint32_t      size  = DICT_INDEX_THRESHOLD * 2;
+
+        while (size < count * 2)
+                size <<= 1;
+
+        index = GF_CALLOC (size, sizeof (*index), gf_common_mt_dict_index);
+        if (!index)
+                return -1;
+
+        for (pair = this->members_list; pair; pair = pair->next)
+                last = pair;
+        for (pair = last; pair; pair = pair->prev)
+                dict_index_insert_slot (index, size, pair);
+
+        GF_FREE (this->index);
+        this->index = index;
+        this->index_size = size;
+        this->index_used = this->count;
+
+        return 0;
+}
+
+/* @pair is already linked into ->members_list */
+static void
+dict_index_add (dict_t *this, data_pair_t *pair)
+{
+        if (!this->index_size) {
+                if (this->count > DICT_INDEX_THRESHOLD)
+                        (void) dict_index_rebuild (this, this->count);
+                return;
+        }
+
+        if ((this->index_used + 1) * 4 > this->index_size * 3) {
+                if (dict_index_rebuild (this, this->count) == 0)
+                        return;
+
+                /* no memory to grow, go back to linear searches */
+                GF_FREE (this->index);
+                this->index = NULL;
+                this->index_size = 0;
+                return;
+        }
+
+        dict_index_insert_slot (this->index, this->index_size, pair);
+        this->index_used++;
+}
+
+static void
+dict_index_del (dict_t *this, data_pair_t *pair)
+{
+        uint32_t slot = 0;
+
+        if (!this->index_size)
+                return;
+
+        slot = pair->key_hash & (this->index_size - 1);
+        while (this->index[slot] != pair)
+                slot = (slot + 1) & (this->index_size - 1);
+
+        this->index[slot] = &dict_index_deleted;
+}
+
+static data_pair_t *
+dict_index_lookup (dict_t *this, char *key, uint32_t hash)
+{
+        data_pair_t *pair  = NULL;
+        data_pair_t *found = NULL;
+        uint32_t     slot  = hash & (this->index_size - 1);
+
+        while ((pair = this->index[slot]) != NULL) {
+                if ((pair != &dict_index_deleted) &&
+                    (hash == pair->key_hash) && !strcmp (pair->key, key))
+                        found = pair;
+
+                slot = (slot + 1) & (this->index_size - 1);
+        }
+
+        return found;
+}
+
+static data_pair_t *
+dict_pair_alloc (dict_t *this)
+{
+        int i = 0;
+
+        i = ffs (~this->free_pairs_used) - 1;
+        if ((i >= 0) && (i < DICT_INLINE_PAIRS)) {
+                this->free_pairs_used |= (1U << i);
+                return &this->free_pairs[i];
+        }
+
+        return mem_get0 (THIS->ctx->dict_pair_pool);
+}
+
+static void
+dict_pair_free (dict_t *this, data_pair_t *pair)
+{
+        if (pair->key_alloced)
+                GF_FREE (pair->key);
+
+        if ((pair >= &this->free_pairs[0]) &&
+            (pair < &this->free_pairs[DICT_INLINE_PAIRS]))
+                this->free_pairs_used &= ~(1U << (pair - this->free_pairs));
+        else
+                mem_put (pair);
+}
+
+/**
+ * keys are interned, copied into the key arena of the dict while there is
+ * room, and only allocated after that.
+ */
+static int
+dict_pair_set_key (dict_t *this, data_pair_t *pair, char *key,
+                   uint32_t keylen, uint32_t hash)
+{
+        pair->key_hash = hash;
+        pair->key_len = keylen;
+        pair->key_alloced = _gf_false;
+
+        pair->key = dict_intern_lookup (key, keylen, hash);
+        if (pair->key)
+                return 0;
+
+        if (this->key_arena_used + keylen + 1 <= DICT_KEY_ARENA_SIZE) {
+                pair->key = this->key_arena + this->key_arena_used;
+                this->key_arena_used += keylen + 1;
+        } else {
+                pair->key = GF_MALLOC (keylen + 1, gf_common_mt_char);
+                if (!pair->key)
+                        return -1;
+                pair->key_alloced = _gf_true;
+        }
+
+        memcpy (pair->key, key, keylen + 1);
+
+        return 0;
+}
+
+/* link a new pair for @key into @this, the caller holds this->lock */
+static data_pair_t *
+dict_add_pair_lk (dict_t *this, char *key, uint32_t keylen, uint32_t hash,
+                  data_t *value)
+{
+        data_pair_t *pair = NULL;
+
+        pair = dict_pair_alloc (this);
+        if (!pair)
+                return NULL;
+
+        if (dict_pair_set_key (this, pair, key, keylen, hash)) {
+                dict_pair_free (this, pair);
+                return NULL;
+        }
+
+        pair->value = data_ref (value);
+
+        pair->next = this->members_list;
+        pair->prev = NULL;
+        if (this->members_list)
+                this->members_list->prev = pair;
+        this->members_list = pair;
+        this->count++;
+
+        if (this->max_count < this->count)
+                this->max_count = this->count;
+
+        dict_index_add (this, pair);
+
+        return pair;
+}
+
+/* unlink and free @pair, the caller holds this->lock */
+static void
+dict_del_pair_lk (dict_t *this, data_pair_t *pair)
+{
+        dict_index_del (this, pair);
+
+        if (pair->prev)
+                pair->prev->next = pair->next;
+        else
+                this->members_list = pair->next;
+
+        if (pair->next)
+                pair->next->prev = pair->prev;
+
+        data_unref (pair->value);
+        dict_pair_free (this, pair);
+        this->count--;
+
+        /* no key lives in the arena anymore, and the index is all holes */
+        if (this->count == 0) {
+                this->key_arena_used = 0;
+                if (this->index_size) {
+                        memset (this->index, 0,
+                                this->index_size * sizeof (*this->index));
+                        this->index_used = 0;
+                }
+        }
+}
+
 dict_t *
 get_new_dict_full (int size_hint)
 {
@@ -75,34 +387,9 @@ get_new_dict_full (int size_hint)
                 return NULL;
         }
 
-        dict->hash_size = size_hint;
-        if (size_hint == 1) {
-                /*
-                 * This is the only case we ever see currently.  If we ever
-                 * need to support resizing the hash table, the resize function
-                 * will have to take into account the possibility that
-                 * "members" is not separately allocated (i.e. don't just call
-                 * realloc() blindly.
-                 */
-                dict->members = &dict->members_internal;
-        }
-        else {
-                /*
-                 * We actually need to allocate space for size_hint *pointers*
-                 * but we actually allocate space for one *structure*.  Since
-                 * a data_pair_t consists of five pointers, we're wasting four
-                 * pointers' worth for N=1, and will overrun what we allocated
-                 * for N>5.  If anybody ever starts using size_hint, we'll need
-                 * to fix this.
-                 */
-                GF_ASSERT (size_hint <=
-                           (sizeof(data_pair_t) / sizeof(data_pair_t *)));
-                dict->members = mem_get0 (THIS->ctx->dict_pair_pool);
-                if (!dict->members) {
-                        mem_put (dict);
-                        return NULL;
-                }
-        }
+        /* the dict still works if the index cannot be allocated */
+        if (size_hint > DICT_INDEX_THRESHOLD)
+                (void) dict_index_rebuild (dict, size_hint);
 
         LOCK_INIT (&dict->lock);
 
@@ -341,7 +628,6 @@ err_out:
 static data_pair_t *
 dict_lookup_common (dict_t *this, char *key, uint32_t hash)
 {
-        int hashval = 0;
         data_pair_t *pair;
 
         if (!this || !key) {
@@ -351,13 +637,10 @@ dict_lookup_common (dict_t *this, char *key, uint32_t hash)
                 return NULL;
         }
 
-        /* If the divisor is 1, the modulo is always 0,
-         * in such case avoid hash calculation.
-         */
-        if (this->hash_size != 1)
-                hashval = hash % this->hash_size;
+        if (this->index_size)
+                return dict_index_lookup (this, key, hash);
 
-        for (pair = this->members[hashval]; pair != NULL; pair = pair->hash_next) {
+        for (pair = this->members_list; pair != NULL; pair = pair->next) {
                 if (pair->key && (hash == pair->key_hash) &&
                     !strcmp (pair->key, key))
                         return pair;
@@ -397,11 +680,11 @@ dict_lookup (dict_t *this, char *key, data_t **data)
 static int32_t
 dict_set_lk (dict_t *this, char *key, data_t *value, gf_boolean_t replace)
 {
-        int hashval = 0;
         data_pair_t *pair;
         char key_free = 0;
         int ret = 0;
         uint32_t hash = 0;
+        uint32_t keylen = 0;
 
         if (!key) {
                 ret = gf_asprintf (&key, "ref:%p", value);
@@ -409,15 +692,11 @@ dict_set_lk (dict_t *this, char *key, data_t *value, gf_boolean_t replace)
                         return -1;
                 }
                 key_free = 1;
+                ret = 0;
         }
 
-        /* If the divisor is 1, the modulo is always 0,
-         * in such case avoid hash calculation.
-         */
-        hash = SuperFastHash (key, strlen (key));
-        if (this->hash_size != 1) {
-                hashval = (hash % this->hash_size);
-        }
+        keylen = strlen (key);
+        hash = SuperFastHash (key, keylen);
 
         /* Search for a existing key if 'replace' is asked for */
         if (replace) {
@@ -427,64 +706,19 @@ dict_set_lk (dict_t *this, char *key, data_t *value, gf_boolean_t replace)
                         data_t *unref_data = pair->value;
                         pair->value = data_ref (value);
                         data_unref (unref_data);
-                        if (key_free)
-                                GF_FREE (key);
                         /* Indicates duplicate key */
-                        return 0;
-                }
-        }
-
-        if (this->free_pair_in_use) {
-                pair = mem_get0 (THIS->ctx->dict_pair_pool);
-                if (!pair) {
-                        if (key_free)
-                                GF_FREE (key);
-                        return -1;
+                        goto out;
                 }
         }
-        else {
-                pair = &this->free_pair;
-                this->free_pair_in_use = _gf_true;
-        }
 
-        if (key_free) {
-                /* It's ours.  Use it. */
-                pair->key = key;
-                key_free = 0;
-        }
-        else {
-                pair->key = (char *) GF_CALLOC (1, strlen (key) + 1,
-                                                gf_common_mt_char);
-                if (!pair->key) {
-                        if (pair == &this->free_pair) {
-                                this->free_pair_in_use = _gf_false;
-                        }
-                        else {
-                                mem_put (pair);
-                        }
-                        return -1;
-                }
-                strcpy (pair->key, key);
-        }
-        pair->key_hash = hash;
-        pair->value = data_ref (value);
-
-        pair->hash_next = this->members[hashval];
-        this->members[hashval] = pair;
-
-        pair->next = this->members_list;
-        pair->prev = NULL;
-        if (this->members_list)
-                this->members_list->prev = pair;
-        this->members_list = pair;
-        this->count++;
+        if (!dict_add_pair_lk (this, key, keylen, hash, value))
+                ret = -1;
 
+ out:
         if (key_free)
                 GF_FREE (key);
 
-        if (this->max_count < this->count)
-                this->max_count = this->count;
-        return 0;
+        return ret;
 }
 
 int32_t
@@ -583,8 +817,8 @@ dict_key_count (dict_t *this)
 void
 dict_del (dict_t *this, char *key)
 {
-        int hashval = 0;
-        uint32_t hash = 0;
+        data_pair_t *pair = NULL;
+        uint32_t     hash = 0;
 
         if (!this || !key) {
                 gf_msg_callingfn ("dict", GF_LOG_WARNING, EINVAL,
@@ -592,50 +826,14 @@ dict_del (dict_t *this, char *key)
                 return;
         }
 
-        LOCK (&this->lock);
-
-        /* If the divisor is 1, the modulo is always 0,
-         * in such case avoid hash calculation.
-         */
         hash = SuperFastHash (key, strlen (key));
-        if (this->hash_size != 1)
-                hashval = hash % this->hash_size;
-
-        data_pair_t *pair = this->members[hashval];
-        data_pair_t *prev = NULL;
-
-        while (pair) {
-                if ((hash == pair->key_hash) && strcmp (pair->key, key) == 0) {
-                        if (prev)
-                                prev->hash_next = pair->hash_next;
-                        else
-                                this->members[hashval] = pair->hash_next;
-
-                        data_unref (pair->value);
-
-                        if (pair->prev)
-                                pair->prev->next = pair->next;
-                        else
-                                this->members_list = pair->next;
-
-                        if (pair->next)
-                                pair->next->prev = pair->prev;
-
-                        GF_FREE (pair->key);
-                        if (pair == &this->free_pair) {
-                                this->free_pair_in_use = _gf_false;
-                        }
-                        else {
-                                mem_put (pair);
-                        }
-                        this->count--;
-                        break;
-                }
 
-                prev = pair;
-                pair = pair->hash_next;
+        LOCK (&this->lock);
+        {
+                pair = dict_lookup_common (this, key, hash);
+                if (pair)
+                        dict_del_pair_lk (this, pair);
         }
-
         UNLOCK (&this->lock);
 
         return;
@@ -661,17 +859,12 @@ dict_destroy (dict_t *this)
         while (prev) {
                 pair = pair->next;
                 data_unref (prev->value);
-                GF_FREE (prev->key);
-                if (prev != &this->free_pair) {
-                        mem_put (prev);
-                }
+                dict_pair_free (this, prev);
                 total_pairs++;
                 prev = pair;
         }
 
-        if (this->members != &this->members_internal) {
-                mem_put (this->members);
-        }
+        GF_FREE (this->index);
 
         GF_FREE (this->extra_free);
         free (this->extra_stdfree);
@@ -1441,7 +1634,7 @@ dict_copy (dict_t *dict,
         }
 
         if (!new)
-                new = get_new_dict_full (dict->hash_size);
+                new = get_new_dict_full (dict->count);
 
         dict_foreach (dict, dict_copy_one, new);
 
@@ -2137,7 +2330,6 @@ _dict_modify_flag (dict_t *this, char *key, int flag, int op)
         uint32_t        hash            = 0;
         data_pair_t     *pair           = NULL;
         char            *ptr            = NULL;
-        int             hashval         = 0;
 
         if (!this || !key) {
                 gf_msg_callingfn ("dict", GF_LOG_WARNING, EINVAL,
@@ -2192,47 +2384,15 @@ _dict_modify_flag (dict_t *this, char *key, int flag, int op)
                         else
                                 BIT_CLEAR((unsigned char *)(data->data), flag);
 
-                        if (this->free_pair_in_use) {
-                                pair = mem_get0 (THIS->ctx->dict_pair_pool);
-                                if (!pair) {
-                                        gf_msg("dict", GF_LOG_ERROR, ENOMEM,
-                                               LG_MSG_NO_MEMORY,
-                                               "unable to allocate dict pair");
-                                        ret = -ENOMEM;
-                                        goto err;
-                                }
-                        } else {
-                                pair = &this->free_pair;
-                                this->free_pair_in_use = _gf_true;
-                        }
-
-                        pair->key = (char *)GF_CALLOC(1, strlen (key) + 1,
-                                                      gf_common_mt_char);
-                        if (!pair->key) {
+                        pair = dict_add_pair_lk (this, key, strlen (key),
+                                                 hash, data);
+                        if (!pair) {
                                 gf_msg("dict", GF_LOG_ERROR, ENOMEM,
                                        LG_MSG_NO_MEMORY,
                                        "unable to allocate dict pair");
                                 ret = -ENOMEM;
                                 goto err;
                         }
-                        strcpy (pair->key, key);
-                        pair->key_hash = hash;
-                        pair->value = data_ref (data);
-
-                        hashval = hash % this->hash_size;
-                        pair->hash_next = this->members[hashval];
-                        this->members[hashval] = pair;
-
-                        pair->next = this->members_list;
-                        pair->prev = NULL;
-                        if (this->members_list)
-                                this->members_list->prev = pair;
-                        this->members_list = pair;
-                        this->count++;
-
-
-                        if (this->max_count < this->count)
-                                this->max_count = this->count;
                 }
         }
 
@@ -2241,16 +2401,6 @@ _dict_modify_flag (dict_t *this, char *key, int flag, int op)
 
 err:
         UNLOCK (&this->lock);
-        if (pair) {
-                if (pair->key)
-                        free(pair->key);
-
-                if (pair == &this->free_pair) {
-                        this->free_pair_in_use = _gf_false;
-                } else {
-                        mem_put (pair);
-                }
-        }
 
         if (data)
                 data_destroy(data);
@@ -2887,7 +3037,7 @@ dict_serialized_length_lk (dict_t *this)
                         goto out;
                 }
 
-                len += strlen (pair->key) + 1  /* for '\0' */;
+                len += pair->key_len + 1  /* for '\0' */;
 
                 if (!pair->value) {
                         gf_msg ("dict", GF_LOG_ERROR, EINVAL,
@@ -2969,7 +3119,7 @@ dict_serialize_lk (dict_t *this, char *buf)
                         goto out;
                 }
 
-                keylen  = strlen (pair->key);
+                keylen  = pair->key_len;
                 netword = hton32 (keylen);
                 memcpy (buf, &netword, sizeof(netword));
                 buf += DICT_DATA_HDR_KEY_LEN;
@@ -3090,6 +3240,7 @@ dict_unserialize (char *orig_buf, int32_t size, dict_t **fill)
         int32_t  keylen  = 0;
         int32_t  vallen  = 0;
         int32_t  hostord = 0;
+        uint32_t hash    = 0;
 
         buf = orig_buf;
 
@@ -3136,8 +3287,22 @@ dict_unserialize (char *orig_buf, int32_t size, dict_t **fill)
                 goto out;
         }
 
-        /* count will be set by the dict_set's below */
-        (*fill)->count = 0;
+        /* every pair takes at least the two headers and the '\0' of the
+         * key, don't let a bogus count size the index */
+        if (count > size / (DICT_DATA_HDR_KEY_LEN +
+                            DICT_DATA_HDR_VAL_LEN + 1)) {
+                gf_msg_callingfn ("dict", GF_LOG_ERROR, 0,
+                                  LG_MSG_UNDERSIZED_BUF, "undersized buffer "
+                                  "passed for %d pairs (%d bytes)", count,
+                                  size);
+                goto out;
+        }
+
+        LOCK (&(*fill)->lock);
+
+        if ((count + (*fill)->count > DICT_INDEX_THRESHOLD) &&
+            !(*fill)->index_size)
+                (void) dict_index_rebuild (*fill, count + (*fill)->count);
 
         for (i = 0; i < count; i++) {
                 if ((buf + DICT_DATA_HDR_KEY_LEN) > (orig_buf + size)) {
@@ -3147,7 +3312,7 @@ dict_unserialize (char *orig_buf, int32_t size, dict_t **fill)
                                           "required (%lu)",
                                           (long)(orig_buf + size),
                                           (long)(buf + DICT_DATA_HDR_KEY_LEN));
-                        goto out;
+                        goto unlock;
                 }
                 memcpy (&hostord, buf, sizeof(hostord));
                 keylen = ntoh32 (hostord);
@@ -3160,20 +3325,22 @@ dict_unserialize (char *orig_buf, int32_t size, dict_t **fill)
                                           "required (%lu)",
                                           (long)(orig_buf + size),
                                           (long)(buf + DICT_DATA_HDR_VAL_LEN));
-                        goto out;
+                        goto unlock;
                 }
                 memcpy (&hostord, buf, sizeof(hostord));
                 vallen = ntoh32 (hostord);
                 buf += DICT_DATA_HDR_VAL_LEN;
 
-                if ((buf + keylen) > (orig_buf + size)) {
+                if ((keylen < 0) || (vallen < 0) ||
+                    ((buf + keylen) >= (orig_buf + size)) ||
+                    (buf[keylen] != '\0')) {
                         gf_msg_callingfn ("dict", GF_LOG_ERROR, 0,
                                           LG_MSG_UNDERSIZED_BUF,
                                           "undersized buffer passed. "
                                           "available (%lu) < required (%lu)",
                                           (long)(orig_buf + size),
                                           (long)(buf + keylen));
-                        goto out;
+                        goto unlock;
                 }
                 key = buf;
                 buf += keylen + 1;  /* for '\0' */
@@ -3185,13 +3352,13 @@ dict_unserialize (char *orig_buf, int32_t size, dict_t **fill)
                                           "available (%lu) < required (%lu)",
                                           (long)(orig_buf + size),
                                           (long)(buf + vallen));
-                        goto out;
+                        goto unlock;
                 }
                 value = get_new_data ();
 
                 if (!value) {
                         ret = -1;
-                        goto out;
+                        goto unlock;
                 }
                 value->len  = vallen;
                 value->data = memdup (buf, vallen);
@@ -3199,12 +3366,18 @@ dict_unserialize (char *orig_buf, int32_t size, dict_t **fill)
                 value->is_static = 0;
                 buf += vallen;
 
-                ret = dict_add (*fill, key, value);
-                if (ret < 0)
-                        goto out;
+                /* the key length is known, and so are the duplicates */
+                hash = SuperFastHash (key, keylen);
+                if (!dict_add_pair_lk (*fill, key, keylen, hash, value)) {
+                        data_destroy (value);
+                        ret = -1;
+                        goto unlock;
+                }
         }
 
         ret = 0;
+unlock:
+        UNLOCK (&(*fill)->lock);
 out:
         return ret;
 }
@@ -67,6 +67,15 @@ typedef struct _data_pair data_pair_t;
 #define DICT_FLAG_SET          1
 #define DICT_FLAG_CLEAR        0
 
+/* pairs and key bytes carved out of the dict itself before falling back to
+ * the pair mem-pool and GF_MALLOC */
+#define DICT_INLINE_PAIRS      4
+#define DICT_KEY_ARENA_SIZE    256
+
+/* dicts with more keys than this get an open addressing index, smaller ones
+ * are searched linearly comparing the key hashes */
+#define DICT_INDEX_THRESHOLD   16
+
 struct _data {
         unsigned char  is_static:1;
         unsigned char  is_const:1;
@@ -78,28 +87,33 @@ struct _data {
 };
 
 struct _data_pair {
-        struct _data_pair *hash_next;
         struct _data_pair *prev;
         struct _data_pair *next;
         data_t            *value;
         char              *key;
         uint32_t           key_hash;
+        uint32_t           key_len;
+        gf_boolean_t       key_alloced; /* neither interned nor in the arena */
 };
 
 struct _dict {
         unsigned char   is_static:1;
-        int32_t         hash_size;
         int32_t         count;
         gf_atomic_t     refcount;
-        data_pair_t   **members;
         data_pair_t    *members_list;
         char           *extra_free;
         char           *extra_stdfree;
         gf_lock_t       lock;
-        data_pair_t    *members_internal;
-        data_pair_t     free_pair;
-        gf_boolean_t    free_pair_in_use;
         uint64_t        max_count;
+
+        data_pair_t   **index;         /* open addressing, power of 2 slots */
+        uint32_t        index_size;    /* 0 while not indexed */
+        uint32_t        index_used;    /* live and deleted slots */
+
+        uint32_t        free_pairs_used;   /* bitmap of free_pairs */
+        uint32_t        key_arena_used;
+        data_pair_t     free_pairs[DICT_INLINE_PAIRS];
+        char            key_arena[DICT_KEY_ARENA_SIZE];
 };
 
 typedef gf_boolean_t (*dict_match_t) (dict_t *d, char *k, data_t *v,
@@ -77,6 +77,7 @@ const char *gf_fop_list[GF_FOP_MAXVALUE] = {
         [GF_FOP_PUT]         = "PUT",
         [GF_FOP_ICREATE]     = "ICREATE",
         [GF_FOP_NAMELINK]    = "NAMELINK",
+        [GF_FOP_COPY_FILE_RANGE] = "COPY_FILE_RANGE",
 };
 
 const char *gf_upcall_list[GF_UPCALL_FLAGS_MAXVALUE] = {
@@ -185,6 +185,13 @@
  */
 #define GF_INTERNAL_CTX_KEY  "glusterfs.internal-ctx"
 
+/* rchecksum xdata asking for the digests of the children of a node of a
+ * hash tree over the file, and the reply carrying them */
+#define GF_MERKLE_LEAF_SIZE  "glusterfs.merkle-leaf-size"
+#define GF_MERKLE_FANOUT     "glusterfs.merkle-fanout"
+#define GF_MERKLE_NODE_SIZE  "glusterfs.merkle-node-size"
+#define GF_MERKLE_DIGESTS    "glusterfs.merkle-digests"
+
 /*
  * Always append entries to end of the enum, do not delete entries.
  * Currently dict_set_flag allows to set up to 256 flag, if the enum
@@ -539,6 +546,10 @@ struct _cmd_args {
         /* FUSE writeback cache support */
         int                kernel_writeback_cache;
         uint32_t           attr_times_granularity;
+
+        /* FUSE request size and READ replies */
+        uint64_t           fuse_max_write;
+        int                fuse_splice_read;
 };
 typedef struct _cmd_args cmd_args_t;
 
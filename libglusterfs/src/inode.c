@@ -73,10 +73,29 @@ hash_gfid (uuid_t uuid, int mod)
 }
 
 
+static gf_lock_t *
+inode_hash_lock (inode_table_t *table, int hash)
+{
+        return &table->inode_hash_locks[hash % INODE_HASH_LOCK_STRIPES];
+}
+
+
+static gf_lock_t *
+name_hash_lock (inode_table_t *table, int hash)
+{
+        return &table->name_hash_locks[hash % INODE_HASH_LOCK_STRIPES];
+}
+
+
+static void
+__dentry_unhash (dentry_t *dentry);
+
+
 static void
 __dentry_hash (dentry_t *dentry)
 {
         inode_table_t   *table = NULL;
+        gf_lock_t       *lock = NULL;
         int              hash = 0;
 
         if (!dentry) {
@@ -85,12 +104,18 @@ __dentry_hash (dentry_t *dentry)
                 return;
         }
 
+        __dentry_unhash (dentry);
+
         table = dentry->inode->table;
         hash = hash_dentry (dentry->parent, dentry->name,
                             table->hashsize);
+        lock = name_hash_lock (table, hash);
 
-        list_del_init (&dentry->hash);
-        list_add (&dentry->hash, &table->name_hash[hash]);
+        LOCK (lock);
+        {
+                list_add (&dentry->hash, &table->name_hash[hash]);
+        }
+        UNLOCK (lock);
 }
 
 
@@ -110,13 +135,30 @@ __is_dentry_hashed (dentry_t *dentry)
 static void
 __dentry_unhash (dentry_t *dentry)
 {
+        inode_table_t   *table = NULL;
+        gf_lock_t       *lock = NULL;
+        int              hash = 0;
+
         if (!dentry) {
                 gf_msg_callingfn (THIS->name, GF_LOG_WARNING, 0,
                                   LG_MSG_DENTRY_NOT_FOUND, "dentry not found");
                 return;
         }
 
-        list_del_init (&dentry->hash);
+        /* hashing only happens under table->lock, which the caller holds */
+        if (list_empty (&dentry->hash))
+                return;
+
+        table = dentry->inode->table;
+        hash = hash_dentry (dentry->parent, dentry->name,
+                            table->hashsize);
+        lock = name_hash_lock (table, hash);
+
+        LOCK (lock);
+        {
+                list_del_init (&dentry->hash);
+        }
+        UNLOCK (lock);
 }
 
 
@@ -231,13 +273,24 @@ __is_dentry_cyclic (dentry_t *dentry)
 static void
 __inode_unhash (inode_t *inode)
 {
+        gf_lock_t *lock = NULL;
+
         if (!inode) {
                 gf_msg_callingfn (THIS->name, GF_LOG_WARNING, 0,
                                   LG_MSG_INODE_NOT_FOUND, "inode not found");
                 return;
         }
 
-        list_del_init (&inode->hash);
+        if (list_empty (&inode->hash))
+                return;
+
+        lock = inode_hash_lock (inode->table, hash_gfid (inode->gfid, 65536));
+
+        LOCK (lock);
+        {
+                list_del_init (&inode->hash);
+        }
+        UNLOCK (lock);
 }
 
 
@@ -258,6 +311,7 @@ static void
 __inode_hash (inode_t *inode)
 {
         inode_table_t *table = NULL;
+        gf_lock_t     *lock = NULL;
         int            hash = 0;
 
         if (!inode) {
@@ -266,11 +320,17 @@ __inode_hash (inode_t *inode)
                 return;
         }
 
+        __inode_unhash (inode);
+
         table = inode->table;
         hash = hash_gfid (inode->gfid, 65536);
+        lock = inode_hash_lock (table, hash);
 
-        list_del_init (&inode->hash);
-        list_add (&inode->hash, &table->inode_hash[hash]);
+        LOCK (lock);
+        {
+                list_add (&inode->hash, &table->inode_hash[hash]);
+        }
+        UNLOCK (lock);
 }
 
 
@@ -465,17 +525,27 @@ out:
 }
 
 
+static void
+__inode_ref_account (inode_t *inode, xlator_t *this, int32_t delta)
+{
+        int index = 0;
+
+        index = __inode_get_xl_index (inode, this);
+        if (index >= 0) {
+                inode->_ctx[index].xl_key = this;
+                GF_ATOMIC_ADD (inode->_ctx[index].ref, delta);
+        }
+}
+
+
 static inode_t *
 __inode_unref (inode_t *inode)
 {
-        int       index = 0;
-        xlator_t *this  = NULL;
+        uint32_t  ref   = 0;
 
         if (!inode)
                 return NULL;
 
-        this = THIS;
-
         /*
          * Root inode should always be in active list of inode table. So unrefs
          * on root inode are no-ops.
@@ -483,17 +553,13 @@ __inode_unref (inode_t *inode)
         if (__is_root_gfid(inode->gfid))
                 return inode;
 
-        GF_ASSERT (inode->ref);
+        GF_ASSERT (GF_ATOMIC_GET (inode->ref));
 
-        --inode->ref;
+        ref = GF_ATOMIC_DEC (inode->ref);
 
-        index = __inode_get_xl_index (inode, this);
-        if (index >= 0) {
-                inode->_ctx[index].xl_key = this;
-                inode->_ctx[index].ref--;
-        }
+        __inode_ref_account (inode, THIS, -1);
 
-        if (!inode->ref) {
+        if (!ref) {
                 inode->table->active_size--;
 
                 if (inode->nlookup)
@@ -509,15 +575,10 @@ __inode_unref (inode_t *inode)
 static inode_t *
 __inode_ref (inode_t *inode)
 {
-        int       index = 0;
-        xlator_t *this  = NULL;
-
         if (!inode)
                 return NULL;
 
-        this = THIS;
-
-        if (!inode->ref) {
+        if (!GF_ATOMIC_GET (inode->ref)) {
                 inode->table->lru_size--;
                 __inode_activate (inode);
         }
@@ -530,21 +591,66 @@ __inode_ref (inode_t *inode)
          * in inode table increases which is wrong. So just keep the ref
          * count as 1 always
          */
-        if (__is_root_gfid(inode->gfid) && inode->ref)
+        if (__is_root_gfid(inode->gfid) && GF_ATOMIC_GET (inode->ref))
                 return inode;
 
-        inode->ref++;
+        GF_ATOMIC_INC (inode->ref);
 
-        index = __inode_get_xl_index (inode, this);
-        if (index >= 0) {
-                inode->_ctx[index].xl_key = this;
-                inode->_ctx[index].ref++;
-        }
+        __inode_ref_account (inode, THIS, 1);
 
         return inode;
 }
 
 
+/* Take a reference without table->lock. This only succeeds if the inode is
+ * already active, as the 0 -> 1 transition moves it off the lru list. The
+ * caller must guarantee the inode cannot be freed meanwhile, either by
+ * holding a reference or a hash stripe lock under which the inode is found.
+ */
+static gf_boolean_t
+inode_try_ref (inode_t *inode)
+{
+        uint32_t ref = 0;
+
+        do {
+                ref = GF_ATOMIC_GET (inode->ref);
+                if (!ref)
+                        return _gf_false;
+
+                /* see __inode_ref() for why root stays at 1 */
+                if (__is_root_gfid (inode->gfid))
+                        return _gf_true;
+        } while (!GF_ATOMIC_CMP_SWAP (inode->ref, ref, ref + 1));
+
+        __inode_ref_account (inode, THIS, 1);
+
+        return _gf_true;
+}
+
+
+/* Drop a reference without table->lock, unless it is the last one: the
+ * 1 -> 0 transition passivates or retires the inode under table->lock.
+ */
+static gf_boolean_t
+inode_try_unref (inode_t *inode)
+{
+        uint32_t ref = 0;
+
+        if (__is_root_gfid (inode->gfid))
+                return _gf_true;
+
+        do {
+                ref = GF_ATOMIC_GET (inode->ref);
+                if (ref <= 1)
+                        return _gf_false;
+        } while (!GF_ATOMIC_CMP_SWAP (inode->ref, ref, ref - 1));
+
+        __inode_ref_account (inode, THIS, -1);
+
+        return _gf_true;
+}
+
+
 inode_t *
 inode_unref (inode_t *inode)
 {
@@ -553,6 +659,9 @@ inode_unref (inode_t *inode)
         if (!inode)
                 return NULL;
 
+        if (inode_try_unref (inode))
+                return inode;
+
         table = inode->table;
 
         pthread_mutex_lock (&table->lock);
@@ -575,6 +684,9 @@ inode_ref (inode_t *inode)
         if (!inode)
                 return NULL;
 
+        if (inode_try_ref (inode))
+                return inode;
+
         table = inode->table;
 
         pthread_mutex_lock (&table->lock);
@@ -645,6 +757,7 @@ __inode_create (inode_table_t *table)
         }
 
         newi->table = table;
+        GF_ATOMIC_INIT (newi->ref, 0);
 
         LOCK_INIT (&newi->lock);
 
@@ -710,17 +823,19 @@ inode_new (inode_table_t *table)
 static inode_t *
 __inode_ref_reduce_by_n (inode_t *inode, uint64_t nref)
 {
+        uint32_t ref = 0;
+
         if (!inode)
                 return NULL;
 
-        GF_ASSERT (inode->ref >= nref);
+        GF_ASSERT (GF_ATOMIC_GET (inode->ref) >= nref);
 
-        inode->ref -= nref;
+        if (nref)
+                ref = GF_ATOMIC_SUB (inode->ref, nref);
+        else
+                GF_ATOMIC_SWAP (inode->ref, 0);
 
-        if (!nref)
-                inode->ref = 0;
-
-        if (!inode->ref) {
+        if (!ref) {
                 inode->table->active_size--;
 
                 if (inode->nlookup)
@@ -790,6 +905,7 @@ inode_grep (inode_table_t *table, inode_t *parent, const char *name)
 {
         inode_t   *inode = NULL;
         dentry_t  *dentry = NULL;
+        gf_lock_t *lock = NULL;
 
         if (!table || !parent || !name) {
                 gf_msg_callingfn (THIS->name, GF_LOG_WARNING, EINVAL,
@@ -798,6 +914,25 @@ inode_grep (inode_table_t *table, inode_t *parent, const char *name)
                 return NULL;
         }
 
+        /* A hashed dentry keeps its inode allocated, so with the stripe held
+         * an already active inode can be referenced without table->lock. */
+        lock = name_hash_lock (table, hash_dentry (parent, name,
+                                                   table->hashsize));
+        LOCK (lock);
+        {
+                dentry = __dentry_grep (table, parent, name);
+
+                if (dentry)
+                        inode = dentry->inode;
+
+                if (inode && !inode_try_ref (inode))
+                        inode = NULL;
+        }
+        UNLOCK (lock);
+
+        if (!dentry || inode)
+                return inode;
+
         pthread_mutex_lock (&table->lock);
         {
                 dentry = __dentry_grep (table, parent, name);
@@ -863,6 +998,7 @@ inode_grep_for_gfid (inode_table_t *table, inode_t *parent, const char *name,
 {
         inode_t   *inode = NULL;
         dentry_t  *dentry = NULL;
+        gf_lock_t *lock = NULL;
         int        ret = -1;
 
         if (!table || !parent || !name) {
@@ -872,7 +1008,9 @@ inode_grep_for_gfid (inode_table_t *table, inode_t *parent, const char *name,
                 return ret;
         }
 
-        pthread_mutex_lock (&table->lock);
+        lock = name_hash_lock (table, hash_dentry (parent, name,
+                                                   table->hashsize));
+        LOCK (lock);
         {
                 dentry = __dentry_grep (table, parent, name);
 
@@ -885,7 +1023,7 @@ inode_grep_for_gfid (inode_table_t *table, inode_t *parent, const char *name,
                         ret = 0;
                 }
         }
-        pthread_mutex_unlock (&table->lock);
+        UNLOCK (lock);
 
         return ret;
 }
@@ -938,7 +1076,9 @@ out:
 inode_t *
 inode_find (inode_table_t *table, uuid_t gfid)
 {
-        inode_t   *inode = NULL;
+        inode_t      *inode = NULL;
+        gf_lock_t    *lock = NULL;
+        gf_boolean_t  found = _gf_false;
 
         if (!table) {
                 gf_msg_callingfn (THIS->name, GF_LOG_WARNING, 0,
@@ -947,6 +1087,21 @@ inode_find (inode_table_t *table, uuid_t gfid)
                 return NULL;
         }
 
+        lock = inode_hash_lock (table, hash_gfid (gfid, 65536));
+        LOCK (lock);
+        {
+                inode = __inode_find (table, gfid);
+                if (inode) {
+                        found = _gf_true;
+                        if (!inode_try_ref (inode))
+                                inode = NULL;
+                }
+        }
+        UNLOCK (lock);
+
+        if (!found || inode)
+                return inode;
+
         pthread_mutex_lock (&table->lock);
         {
                 inode = __inode_find (table, gfid);
@@ -1548,6 +1703,13 @@ inode_table_prune (inode_table_t *table)
         if (!table)
                 return -1;
 
+        /* Skip table->lock when there is nothing to do. An inode retired
+         * concurrently is purged by the prune its retirer runs right after
+         * dropping the lock. */
+        if ((!table->lru_limit || table->lru_size <= table->lru_limit)
+            && !table->purge_size)
+                return 0;
+
         INIT_LIST_HEAD (&purge);
 
         pthread_mutex_lock (&table->lock);
@@ -1652,6 +1814,18 @@ inode_table_new (size_t lru_limit, xlator_t *xl)
         if (!new->name_hash)
                 goto out;
 
+        new->inode_hash_locks = GF_CALLOC (INODE_HASH_LOCK_STRIPES,
+                                           sizeof (gf_lock_t),
+                                           gf_common_mt_inode_hash_lock);
+        if (!new->inode_hash_locks)
+                goto out;
+
+        new->name_hash_locks = GF_CALLOC (INODE_HASH_LOCK_STRIPES,
+                                          sizeof (gf_lock_t),
+                                          gf_common_mt_inode_hash_lock);
+        if (!new->name_hash_locks)
+                goto out;
+
         /* if number of fd open in one process is more than this,
            we may hit perf issues */
         new->fd_mem_pool = mem_pool_new (fd_t, 1024);
@@ -1668,6 +1842,11 @@ inode_table_new (size_t lru_limit, xlator_t *xl)
                 INIT_LIST_HEAD (&new->name_hash[i]);
         }
 
+        for (i = 0; i < INODE_HASH_LOCK_STRIPES; i++) {
+                LOCK_INIT (&new->inode_hash_locks[i]);
+                LOCK_INIT (&new->name_hash_locks[i]);
+        }
+
         INIT_LIST_HEAD (&new->active);
         INIT_LIST_HEAD (&new->lru);
         INIT_LIST_HEAD (&new->purge);
@@ -1688,6 +1867,8 @@ out:
                 if (new) {
                         GF_FREE (new->inode_hash);
                         GF_FREE (new->name_hash);
+                        GF_FREE (new->inode_hash_locks);
+                        GF_FREE (new->name_hash_locks);
                         if (new->dentry_pool)
                                 mem_pool_destroy (new->dentry_pool);
                         if (new->inode_pool)
@@ -1788,6 +1969,7 @@ void
 inode_table_destroy (inode_table_t *inode_table) {
 
         inode_t  *trav = NULL;
+        int       i    = 0;
 
         if (inode_table == NULL)
                 return;
@@ -1846,7 +2028,8 @@ inode_table_destroy (inode_table_t *inode_table) {
                                                   LG_MSG_REF_COUNT,
                                                   "Active inode(%p) with refcount"
                                                   "(%d) found during cleanup",
-                                                  trav, trav->ref);
+                                                  trav,
+                                                  GF_ATOMIC_GET (trav->ref));
                         __inode_forget (trav, 0);
                         __inode_ref_reduce_by_n (trav, 0);
                 }
@@ -1858,6 +2041,12 @@ inode_table_destroy (inode_table_t *inode_table) {
 
         GF_FREE (inode_table->inode_hash);
         GF_FREE (inode_table->name_hash);
+        for (i = 0; i < INODE_HASH_LOCK_STRIPES; i++) {
+                LOCK_DESTROY (&inode_table->inode_hash_locks[i]);
+                LOCK_DESTROY (&inode_table->name_hash_locks[i]);
+        }
+        GF_FREE (inode_table->inode_hash_locks);
+        GF_FREE (inode_table->name_hash_locks);
         if (inode_table->dentry_pool)
                 mem_pool_destroy (inode_table->dentry_pool);
         if (inode_table->inode_pool)
@@ -2350,7 +2539,7 @@ inode_dump (inode_t *inode, char *prefix)
                 gf_proc_dump_write("fd-count", "%u", inode->fd_count);
                 gf_proc_dump_write("active-fd-count", "%u",
                                    inode->active_fd_count);
-                gf_proc_dump_write("ref", "%u", inode->ref);
+                gf_proc_dump_write("ref", "%u", GF_ATOMIC_GET (inode->ref));
                 gf_proc_dump_write("ia_type", "%d", inode->ia_type);
                 if (inode->_ctx) {
                         inode_ctx = GF_CALLOC (inode->table->ctxcount,
@@ -2364,7 +2553,7 @@ inode_dump (inode_t *inode, char *prefix)
                              i++) {
                                 inode_ctx[i] = inode->_ctx[i];
                                 xl = inode_ctx[i].xl_key;
-                                ref = inode_ctx[i].ref;
+                                ref = GF_ATOMIC_GET (inode_ctx[i].ref);
                                 if (ref != 0 && xl) {
                                         gf_proc_dump_build_key (key,
                                                                 "ref_by_xl:",
@@ -2463,7 +2652,7 @@ inode_dump_to_dict (inode_t *inode, char *prefix, dict_t *dict)
 
         memset (key, 0, sizeof (key));
         snprintf (key, sizeof (key), "%s.ref", prefix);
-        ret = dict_set_uint32 (dict, key, inode->ref);
+        ret = dict_set_uint32 (dict, key, GF_ATOMIC_GET (inode->ref));
         if (ret)
                 goto out;
 
@@ -18,6 +18,7 @@
 #define LOOKUP_NOT_NEEDED 2
 
 #define DEFAULT_INODE_MEMPOOL_ENTRIES   32 * 1024
+#define INODE_HASH_LOCK_STRIPES         1024 /* locks over each hash table */
 #define INODE_PATH_FMT "<gfid:%s>"
 struct _inode_table;
 typedef struct _inode_table inode_table_t;
@@ -33,6 +34,20 @@ typedef struct _dentry dentry_t;
 #include "compat-uuid.h"
 #include "fd.h"
 
+/* Locking in the inode table:
+ *
+ * @lock protects the dentry tree, the active/lru/purge lists and any
+ * transition of an inode's refcount to or from zero.
+ *
+ * The buckets of @inode_hash and @name_hash are additionally covered by
+ * striped locks (@inode_hash_locks, @name_hash_locks). Hashing and unhashing
+ * is only done with both @lock and the stripe held, so readers can walk a
+ * bucket with either of them. inode_find() and inode_grep() use only the
+ * stripe, and take their reference lock-free when the inode is already
+ * active; they fall back to @lock otherwise.
+ *
+ * Lock order: @lock -> stripe -> inode->lock.
+ */
 struct _inode_table {
         pthread_mutex_t    lock;
         size_t             hashsize;    /* bucket size of inode hash and dentry hash */
@@ -42,6 +57,8 @@ struct _inode_table {
         uint32_t           lru_limit;   /* maximum LRU cache size */
         struct list_head  *inode_hash;  /* buckets for inode hash table */
         struct list_head  *name_hash;   /* buckets for dentry hash table */
+        gf_lock_t         *inode_hash_locks; /* lock stripes for inode_hash */
+        gf_lock_t         *name_hash_locks;  /* lock stripes for name_hash */
         struct list_head   active;      /* list of inodes currently active (in an fop) */
         uint32_t           active_size; /* count of inodes in active list */
         struct list_head   lru;         /* list of inodes recently used.
@@ -81,7 +98,7 @@ struct _inode_ctx {
                 uint64_t    value2;
                 void       *ptr2;
         };
-        int                 ref; /* This is for debugging inode ref leaks,
+        gf_atomic_int32_t   ref; /* This is for debugging inode ref leaks,
                                     basically helps in identifying the xlator
                                     causing th ref leak, it is printed in
                                     statedump */
@@ -94,7 +111,7 @@ struct _inode {
         uint64_t             nlookup;
         uint32_t             fd_count;      /* Open fd count */
         uint32_t             active_fd_count;      /* Active open fd count */
-        uint32_t             ref;           /* reference count on this inode */
+        gf_atomic_uint32_t   ref;           /* reference count on this inode */
         ia_type_t            ia_type;       /* what kind of file */
         struct list_head     fd_list;       /* list of open files on this inode */
         struct list_head     dentry_list;   /* list of directory entries for this inode */
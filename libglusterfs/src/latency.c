@@ -19,6 +19,145 @@
 #include "common-utils.h"
 #include "statedump.h"
 #include "libglusterfs-messages.h"
+#include "latency.h"
+
+static int
+gf_latency_hist_index (uint64_t usec)
+{
+        int msb = 0;
+        int shift = 0;
+
+        if (usec < (1ULL << GF_LATENCY_HIST_SUB_BITS))
+                return usec;
+
+        msb = 63 - __builtin_clzll (usec);
+        if (msb >= GF_LATENCY_HIST_MAX_BITS)
+                return GF_LATENCY_HIST_BUCKETS - 1;
+
+        shift = msb - GF_LATENCY_HIST_SUB_BITS + 1;
+
+        return (shift + 1) * GF_LATENCY_HIST_SUB_COUNT +
+               (usec >> shift) - GF_LATENCY_HIST_SUB_COUNT;
+}
+
+
+/* highest value that falls into bucket @index */
+static uint64_t
+gf_latency_hist_value (int index)
+{
+        int shift = 0;
+
+        if (index < (1 << GF_LATENCY_HIST_SUB_BITS))
+                return index;
+
+        shift = index / GF_LATENCY_HIST_SUB_COUNT - 1;
+
+        return (((uint64_t)(index % GF_LATENCY_HIST_SUB_COUNT +
+                            GF_LATENCY_HIST_SUB_COUNT + 1)) << shift) - 1;
+}
+
+
+static int
+gf_latency_hist_stripe (void)
+{
+        uint64_t self = (uintptr_t) pthread_self ();
+
+        /* thread ids are usually stack addresses a few MB apart, mix the
+         * bits before picking a stripe */
+        return ((self * 0x9e3779b97f4a7c15ULL) >> 32) %
+                GF_LATENCY_HIST_STRIPES;
+}
+
+
+gf_latency_hist_t *
+gf_latency_hist_get (gf_latency_hist_t **histp)
+{
+        gf_latency_hist_t *hist = NULL;
+        int                i = 0;
+        int                j = 0;
+
+        hist = *histp;
+        if (hist)
+                return hist;
+
+        hist = GF_MALLOC (sizeof (*hist), gf_common_mt_latency_hist);
+        if (!hist)
+                return NULL;
+
+        for (i = 0; i < GF_LATENCY_HIST_STRIPES; i++)
+                for (j = 0; j < GF_LATENCY_HIST_BUCKETS; j++)
+                        GF_ATOMIC_INIT (hist->counts[i][j], 0);
+
+        if (!__sync_bool_compare_and_swap (histp, NULL, hist)) {
+                GF_FREE (hist);
+                hist = *histp;
+        }
+
+        return hist;
+}
+
+
+void
+gf_latency_hist_add (gf_latency_hist_t *hist, uint64_t usec)
+{
+        GF_ATOMIC_INC (hist->counts[gf_latency_hist_stripe ()]
+                                   [gf_latency_hist_index (usec)]);
+}
+
+
+/* Adds the counts of @hist to @snap. With @reset the counts are taken out
+ * of @hist, so that updates racing with the merge end up in the next one
+ * instead of being lost. */
+void
+gf_latency_hist_merge (gf_latency_hist_t *hist, gf_latency_snap_t *snap,
+                       gf_boolean_t reset)
+{
+        uint64_t count = 0;
+        int      i = 0;
+        int      j = 0;
+
+        if (!hist)
+                return;
+
+        for (i = 0; i < GF_LATENCY_HIST_STRIPES; i++) {
+                for (j = 0; j < GF_LATENCY_HIST_BUCKETS; j++) {
+                        if (reset)
+                                count = GF_ATOMIC_SWAP (hist->counts[i][j], 0);
+                        else
+                                count = GF_ATOMIC_GET (hist->counts[i][j]);
+                        snap->buckets[j] += count;
+                        snap->count += count;
+                }
+        }
+}
+
+
+/* @percentile is in the 0-100 range, returns 0 for an empty snapshot */
+uint64_t
+gf_latency_snap_percentile (gf_latency_snap_t *snap, double percentile)
+{
+        uint64_t target = 0;
+        uint64_t seen = 0;
+        int      i = 0;
+
+        if (!snap->count)
+                return 0;
+
+        target = (uint64_t)(snap->count * percentile / 100.0 + 0.5);
+        if (target < 1)
+                target = 1;
+        if (target > snap->count)
+                target = snap->count;
+
+        for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++) {
+                seen += snap->buckets[i];
+                if (seen >= target)
+                        break;
+        }
+
+        return gf_latency_hist_value (i);
+}
+
 
 void
 gf_update_latency (call_frame_t *frame)
@@ -27,6 +166,7 @@ gf_update_latency (call_frame_t *frame)
         struct timespec *begin, *end;
 
         fop_latency_t *lat;
+        gf_latency_hist_t *hist;
 
         begin = &frame->begin;
         end   = &frame->end;
@@ -59,6 +199,11 @@ gf_update_latency (call_frame_t *frame)
 
         lat->total += elapsed;
         lat->count++;
+
+        hist = gf_latency_hist_get
+                (&frame->this->stats.interval.latency_hist[frame->op]);
+        if (hist)
+                gf_latency_hist_add (hist, elapsed / 1000);
 out:
         return;
 }
@@ -69,6 +214,7 @@ gf_proc_dump_latency_info (xlator_t *xl)
 {
         char key_prefix[GF_DUMP_MAX_BUF_LEN];
         char key[GF_DUMP_MAX_BUF_LEN];
+        gf_latency_snap_t snap;
         int i;
 
         snprintf (key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.latency", xl->name);
@@ -88,6 +234,21 @@ gf_proc_dump_latency_info (xlator_t *xl)
                 gf_proc_dump_write (key, "%.03f,%"PRId64",%.03f",
                                     (lat->total / lat->count), lat->count,
                                     lat->total);
+
+                memset (&snap, 0, sizeof (snap));
+                gf_latency_hist_merge (xl->stats.interval.latency_hist[i],
+                                       &snap, _gf_true);
+                if (!snap.count)
+                        continue;
+
+                gf_proc_dump_build_key (key, key_prefix, "%s.percentiles",
+                                        (char *)gf_fop_list[i]);
+                gf_proc_dump_write (key, "%"PRIu64",%"PRIu64",%"PRIu64
+                                    ",%"PRIu64,
+                                    gf_latency_snap_percentile (&snap, 50),
+                                    gf_latency_snap_percentile (&snap, 90),
+                                    gf_latency_snap_percentile (&snap, 99),
+                                    gf_latency_snap_percentile (&snap, 99.9));
         }
 
         memset (xl->stats.interval.latencies, 0,
@@ -12,6 +12,7 @@
 #define __LATENCY_H__
 
 #include "glusterfs.h"
+#include "atomic.h"
 
 typedef struct fop_latency {
         double min;           /* min time for the call (microseconds) */
@@ -20,4 +21,48 @@ typedef struct fop_latency {
         uint64_t count;
 } fop_latency_t;
 
+/* Log-linear (HDR style) latency histogram, in microseconds.
+ *
+ * Values below 2^GF_LATENCY_HIST_SUB_BITS get a bucket each, every power of
+ * two above that is split into GF_LATENCY_HIST_SUB_COUNT linear buckets, so
+ * the relative error of a reported percentile stays below 1/8 whatever the
+ * magnitude. Anything above 2^GF_LATENCY_HIST_MAX_BITS us (~19h) lands in
+ * the last bucket.
+ *
+ * Updates are a single relaxed atomic add into one of a few stripes picked
+ * by the calling thread, so concurrent fops on different threads rarely
+ * share a cache line. The stripes are only summed up when dumping.
+ */
+#define GF_LATENCY_HIST_SUB_BITS        4
+#define GF_LATENCY_HIST_SUB_COUNT       (1 << (GF_LATENCY_HIST_SUB_BITS - 1))
+#define GF_LATENCY_HIST_MAX_BITS        36
+#define GF_LATENCY_HIST_BUCKETS         ((GF_LATENCY_HIST_MAX_BITS -        \
+                                          GF_LATENCY_HIST_SUB_BITS + 2) *   \
+                                         GF_LATENCY_HIST_SUB_COUNT)
+#define GF_LATENCY_HIST_STRIPES         4
+
+typedef struct gf_latency_hist {
+        gf_atomic_uint64_t counts[GF_LATENCY_HIST_STRIPES]
+                                 [GF_LATENCY_HIST_BUCKETS];
+} gf_latency_hist_t;
+
+/* merged, point in time view of one or more histograms */
+typedef struct gf_latency_snap {
+        uint64_t count;
+        uint64_t buckets[GF_LATENCY_HIST_BUCKETS];
+} gf_latency_snap_t;
+
+gf_latency_hist_t *
+gf_latency_hist_get (gf_latency_hist_t **histp);
+
+void
+gf_latency_hist_add (gf_latency_hist_t *hist, uint64_t usec);
+
+void
+gf_latency_hist_merge (gf_latency_hist_t *hist, gf_latency_snap_t *snap,
+                       gf_boolean_t reset);
+
+uint64_t
+gf_latency_snap_percentile (gf_latency_snap_t *snap, double percentile);
+
 #endif /* __LATENCY_H__ */
@@ -2046,7 +2046,7 @@ _gf_msg (const char *domain, const char *file, const char *function,
         va_list          ap;
         xlator_t        *this = NULL;
         glusterfs_ctx_t *ctx = NULL;
-        char             callstr[GF_LOG_BACKTRACE_SIZE] = {0,};
+        char             callstr[GF_LOG_BACKTRACE_SIZE];
         int              passcallstr = 0;
         int              log_inited = 0;
 
@@ -2074,6 +2074,9 @@ _gf_msg (const char *domain, const char *file, const char *function,
                 goto out;
 
         if (trace) {
+                /* only zeroed here, gf_msg_trace () on every STACK_WIND
+                 * and STACK_UNWIND gets this far */
+                memset (callstr, 0, sizeof (callstr));
                 ret = _gf_msg_backtrace (GF_LOG_BACKTRACE_DEPTH, callstr,
                                          GF_LOG_BACKTRACE_SIZE);
                 if (ret >= 0)
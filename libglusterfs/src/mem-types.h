@@ -177,6 +177,9 @@ enum gf_common_mem_types_ {
         gf_common_volfile_t,
         gf_common_mt_mgmt_v3_lock_timer_t,
         gf_common_mt_server_cmdline_t,
+        gf_common_mt_inode_hash_lock,
+        gf_common_mt_latency_hist,
+        gf_common_mt_dict_index,
         gf_common_mt_end
 };
 #endif
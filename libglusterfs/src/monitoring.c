@@ -136,7 +136,7 @@ dump_call_stack_details (glusterfs_ctx_t *ctx, int fd)
         dprintf (fd, "total.stack.count %lu\n",
                  GF_ATOMIC_GET (ctx->pool->total_count));
         dprintf (fd, "total.stack.in-flight %lu\n",
-                 ctx->pool->cnt);
+                 GF_ATOMIC_GET (ctx->pool->cnt));
 }
 
 static inline void
@@ -68,6 +68,7 @@ enum gf_fop_procnum {
         GFS3_OP_ICREATE,
         GFS3_OP_NAMELINK,
         GFS3_OP_PUT,
+        GFS3_OP_COPY_FILE_RANGE,
         GFS3_OP_MAXVALUE,
 };
 
@@ -225,6 +226,7 @@ enum glusterd_friend_procnum {
         GLUSTERD_FRIEND_ADD,
         GLUSTERD_FRIEND_REMOVE,
         GLUSTERD_FRIEND_UPDATE,
+        GLUSTERD_FRIEND_VOLUME_SUMMARY,
         GLUSTERD_FRIEND_MAXVALUE,
 };
 
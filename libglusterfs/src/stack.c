@@ -12,6 +12,369 @@
 #include "stack.h"
 #include "libglusterfs-messages.h"
 
+/* Frames and stacks are allocated on every wind and every request, from
+ * whichever thread happens to run the fop. Each thread keeps a magazine of
+ * free objects of each kind and only goes to the shared depot, under its
+ * mutex, to refill an empty magazine or to drain a full one. The depot keeps
+ * at most STACK_CACHE_DEPOT_MAX objects, the rest go back to libc. A thread
+ * returns its magazines to the depot when it exits.
+ *
+ * The caches are process wide and backed by plain malloc, they do not go
+ * away with the call_pool (or the glfs instance) a frame was created for.
+ */
+#define STACK_CACHE_MAG_SIZE   64
+#define STACK_CACHE_DEPOT_MAX  (16 * 1024)
+
+typedef struct stack_cache_mag {
+        int     count;
+        void   *objs[STACK_CACHE_MAG_SIZE];
+} stack_cache_mag_t;
+
+typedef struct stack_cache {
+        stack_cache_mag_t       frames;
+        stack_cache_mag_t       stacks;
+} stack_cache_t;
+
+typedef struct stack_cache_depot {
+        const char             *name;
+        size_t                  size;
+        pthread_mutex_t         lock;
+        void                   *free;      /* linked through the first word */
+        int                     count;
+        gf_atomic_t             allocated; /* in use or cached anywhere */
+        gf_atomic_t             refills;
+} stack_cache_depot_t;
+
+static stack_cache_depot_t frame_depot = {
+        .name = "frame",
+        .size = sizeof (call_frame_t),
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static stack_cache_depot_t stack_depot = {
+        .name = "stack",
+        .size = sizeof (call_stack_t),
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+#if !defined(GF_DISABLE_MEMPOOL)
+static pthread_key_t  stack_cache_key;
+static pthread_once_t stack_cache_once = PTHREAD_ONCE_INIT;
+static int            stack_cache_key_ok;
+
+static void
+stack_cache_depot_put (stack_cache_depot_t *depot, stack_cache_mag_t *mag,
+                       int keep)
+{
+        void  *tofree = NULL;
+        void  *obj = NULL;
+
+        pthread_mutex_lock (&depot->lock);
+        {
+                while (mag->count > keep) {
+                        obj = mag->objs[--mag->count];
+                        if (depot->count < STACK_CACHE_DEPOT_MAX) {
+                                *(void **)obj = depot->free;
+                                depot->free = obj;
+                                depot->count++;
+                        } else {
+                                *(void **)obj = tofree;
+                                tofree = obj;
+                        }
+                }
+        }
+        pthread_mutex_unlock (&depot->lock);
+
+        while (tofree) {
+                obj = tofree;
+                tofree = *(void **)obj;
+                free (obj);
+                GF_ATOMIC_DEC (depot->allocated);
+        }
+}
+
+static void *
+stack_cache_depot_get (stack_cache_depot_t *depot, stack_cache_mag_t *mag)
+{
+        void  *obj = NULL;
+
+        pthread_mutex_lock (&depot->lock);
+        {
+                while (depot->free && mag->count < STACK_CACHE_MAG_SIZE / 2) {
+                        obj = depot->free;
+                        depot->free = *(void **)obj;
+                        depot->count--;
+                        mag->objs[mag->count++] = obj;
+                }
+        }
+        pthread_mutex_unlock (&depot->lock);
+
+        GF_ATOMIC_INC (depot->refills);
+        if (mag->count)
+                return mag->objs[--mag->count];
+
+        obj = malloc (depot->size);
+        if (obj)
+                GF_ATOMIC_INC (depot->allocated);
+
+        return obj;
+}
+
+static void
+stack_cache_destroy (void *data)
+{
+        stack_cache_t  *cache = data;
+
+        stack_cache_depot_put (&frame_depot, &cache->frames, 0);
+        stack_cache_depot_put (&stack_depot, &cache->stacks, 0);
+        free (cache);
+}
+
+static void
+stack_cache_init_once (void)
+{
+        GF_ATOMIC_INIT (frame_depot.allocated, 0);
+        GF_ATOMIC_INIT (frame_depot.refills, 0);
+        GF_ATOMIC_INIT (stack_depot.allocated, 0);
+        GF_ATOMIC_INIT (stack_depot.refills, 0);
+
+        if (pthread_key_create (&stack_cache_key, stack_cache_destroy) == 0)
+                stack_cache_key_ok = 1;
+}
+
+static stack_cache_t *
+stack_cache_get (void)
+{
+        stack_cache_t  *cache = NULL;
+
+        (void) pthread_once (&stack_cache_once, stack_cache_init_once);
+        if (!stack_cache_key_ok)
+                return NULL;
+
+        cache = pthread_getspecific (stack_cache_key);
+        if (cache)
+                return cache;
+
+        cache = calloc (1, sizeof (*cache));
+        if (!cache)
+                return NULL;
+
+        if (pthread_setspecific (stack_cache_key, cache) != 0) {
+                free (cache);
+                return NULL;
+        }
+
+        return cache;
+}
+
+/* for threads that could not get a cache, straight from/to the depot */
+static void *
+stack_cache_alloc_nocache (stack_cache_depot_t *depot)
+{
+        stack_cache_mag_t   tmp = {0, };
+        void               *obj = NULL;
+
+        obj = stack_cache_depot_get (depot, &tmp);
+        stack_cache_depot_put (depot, &tmp, 0);
+
+        return obj;
+}
+
+static void
+stack_cache_free_nocache (stack_cache_depot_t *depot, void *obj)
+{
+        stack_cache_mag_t   tmp = {0, };
+
+        tmp.objs[tmp.count++] = obj;
+        stack_cache_depot_put (depot, &tmp, 0);
+}
+
+#endif /* !GF_DISABLE_MEMPOOL */
+
+static void *
+stack_cache_alloc (stack_cache_depot_t *depot, size_t offset)
+{
+#if defined(GF_DISABLE_MEMPOOL)
+        return malloc (depot->size);
+#else
+        stack_cache_t      *cache = NULL;
+        stack_cache_mag_t  *mag = NULL;
+
+        cache = stack_cache_get ();
+        if (!cache)
+                return stack_cache_alloc_nocache (depot);
+
+        mag = (stack_cache_mag_t *)((char *)cache + offset);
+        if (mag->count)
+                return mag->objs[--mag->count];
+
+        return stack_cache_depot_get (depot, mag);
+#endif
+}
+
+static void
+stack_cache_free (stack_cache_depot_t *depot, size_t offset, void *obj)
+{
+#if defined(GF_DISABLE_MEMPOOL)
+        free (obj);
+#else
+        stack_cache_t      *cache = NULL;
+        stack_cache_mag_t  *mag = NULL;
+
+        cache = stack_cache_get ();
+        if (!cache) {
+                stack_cache_free_nocache (depot, obj);
+                return;
+        }
+
+        mag = (stack_cache_mag_t *)((char *)cache + offset);
+        if (mag->count == STACK_CACHE_MAG_SIZE)
+                stack_cache_depot_put (depot, mag, STACK_CACHE_MAG_SIZE / 2);
+
+        mag->objs[mag->count++] = obj;
+#endif
+}
+
+call_frame_t *
+frame_alloc (void)
+{
+        call_frame_t  *frame = NULL;
+
+        frame = stack_cache_alloc (&frame_depot,
+                                   offsetof (stack_cache_t, frames));
+        if (!frame)
+                return NULL;
+
+        frame->parent = NULL;
+        frame->local = NULL;
+        frame->ret = NULL;
+        frame->ref_count = 0;
+        frame->cookie = NULL;
+        frame->complete = _gf_false;
+        frame->op = 0;
+        frame->begin.tv_sec = frame->begin.tv_nsec = 0;
+        frame->end.tv_sec = frame->end.tv_nsec = 0;
+        frame->wind_from = NULL;
+        frame->wind_to = NULL;
+        frame->unwind_from = NULL;
+        frame->unwind_to = NULL;
+
+        return frame;
+}
+
+void
+frame_free (call_frame_t *frame)
+{
+        stack_cache_free (&frame_depot, offsetof (stack_cache_t, frames),
+                          frame);
+}
+
+call_stack_t *
+stack_alloc (void)
+{
+        call_stack_t  *stack = NULL;
+
+        stack = stack_cache_alloc (&stack_depot,
+                                   offsetof (stack_cache_t, stacks));
+        if (!stack)
+                return NULL;
+
+        INIT_LIST_HEAD (&stack->all_frames);
+        stack->pool = NULL;
+        stack->client = NULL;
+        stack->unique = 0;
+        stack->state = NULL;
+        stack->uid = 0;
+        stack->gid = 0;
+        stack->pid = 0;
+        stack->identifier[0] = '\0';
+        stack->ngrps = 0;
+        stack->groups_large = NULL;
+        stack->groups = NULL;
+        stack->lk_owner.len = 0;
+        stack->ctx = NULL;
+        INIT_LIST_HEAD (&stack->myframes);
+        stack->op = 0;
+        stack->type = 0;
+        stack->tv.tv_sec = stack->tv.tv_nsec = 0;
+        stack->err_xl = NULL;
+        stack->error = 0;
+        stack->flags = 0;
+        stack->ctime.tv_sec = stack->ctime.tv_nsec = 0;
+        stack->ns_info.hash = 0;
+        stack->ns_info.found = _gf_false;
+
+        return stack;
+}
+
+void
+stack_free (call_stack_t *stack)
+{
+        stack_cache_free (&stack_depot, offsetof (stack_cache_t, stacks),
+                          stack);
+}
+
+void
+call_pool_init (call_pool_t *pool)
+{
+        int  i = 0;
+
+        for (i = 0; i < CALL_POOL_SHARDS; i++) {
+                LOCK_INIT (&pool->shards[i].lock);
+                INIT_LIST_HEAD (&pool->shards[i].all_stacks);
+        }
+
+        GF_ATOMIC_INIT (pool->cnt, 0);
+        GF_ATOMIC_INIT (pool->total_count, 0);
+}
+
+void
+call_pool_fini (call_pool_t *pool)
+{
+        int  i = 0;
+
+        for (i = 0; i < CALL_POOL_SHARDS; i++)
+                LOCK_DESTROY (&pool->shards[i].lock);
+}
+
+void
+call_pool_lock (call_pool_t *pool)
+{
+        int  i = 0;
+
+        for (i = 0; i < CALL_POOL_SHARDS; i++)
+                LOCK (&pool->shards[i].lock);
+}
+
+int
+call_pool_trylock (call_pool_t *pool)
+{
+        int  i = 0;
+        int  ret = 0;
+
+        for (i = 0; i < CALL_POOL_SHARDS; i++) {
+                ret = TRY_LOCK (&pool->shards[i].lock);
+                if (ret)
+                        break;
+        }
+
+        if (ret) {
+                while (i--)
+                        UNLOCK (&pool->shards[i].lock);
+        }
+
+        return ret;
+}
+
+void
+call_pool_unlock (call_pool_t *pool)
+{
+        int  i = 0;
+
+        for (i = CALL_POOL_SHARDS - 1; i >= 0; i--)
+                UNLOCK (&pool->shards[i].lock);
+}
+
 call_frame_t *
 create_frame (xlator_t *xl, call_pool_t *pool)
 {
@@ -22,22 +385,19 @@ create_frame (xlator_t *xl, call_pool_t *pool)
                 return NULL;
         }
 
-        stack = mem_get0 (pool->stack_mem_pool);
+        stack = stack_alloc ();
         if (!stack)
                 return NULL;
 
-        INIT_LIST_HEAD (&stack->myframes);
-
-        frame = mem_get0 (pool->frame_mem_pool);
+        frame = frame_alloc ();
         if (!frame) {
-                mem_put (stack);
+                stack_free (stack);
                 return NULL;
         }
 
         frame->root = stack;
         frame->this = xl;
         LOCK_INIT (&frame->lock);
-        INIT_LIST_HEAD (&frame->frames);
         list_add (&frame->frames, &stack->myframes);
 
         stack->pool = pool;
@@ -49,16 +409,10 @@ create_frame (xlator_t *xl, call_pool_t *pool)
                         sizeof (stack->tv));
         }
 
-        LOCK (&pool->lock);
-        {
-                list_add (&stack->all_frames, &pool->all_frames);
-                pool->cnt++;
-        }
-        UNLOCK (&pool->lock);
-        GF_ATOMIC_INC (pool->total_count);
-
         LOCK_INIT (&stack->stack_lock);
 
+        call_pool_add_stack (pool, stack);
+
         return frame;
 }
 
@@ -207,19 +561,43 @@ gf_proc_dump_call_stack (call_stack_t *call_stack, const char *key_buf,...)
         }
 }
 
+static void
+gf_proc_dump_stack_cache (stack_cache_depot_t *depot)
+{
+        char  key[GF_DUMP_MAX_BUF_LEN];
+        int   cached = 0;
+
+        pthread_mutex_lock (&depot->lock);
+        {
+                cached = depot->count;
+        }
+        pthread_mutex_unlock (&depot->lock);
+
+        gf_proc_dump_build_key (key, "callpool", "%s_cache.allocated",
+                                depot->name);
+        gf_proc_dump_write (key, "%"PRId64, GF_ATOMIC_GET (depot->allocated));
+        gf_proc_dump_build_key (key, "callpool", "%s_cache.depot",
+                                depot->name);
+        gf_proc_dump_write (key, "%d", cached);
+        gf_proc_dump_build_key (key, "callpool", "%s_cache.refills",
+                                depot->name);
+        gf_proc_dump_write (key, "%"PRId64, GF_ATOMIC_GET (depot->refills));
+}
+
 void
 gf_proc_dump_pending_frames (call_pool_t *call_pool)
 {
 
         call_stack_t     *trav = NULL;
         int              i = 1;
+        int              shard = 0;
         int              ret = -1;
         gf_boolean_t     section_added = _gf_true;
 
         if (!call_pool)
                 return;
 
-        ret = TRY_LOCK (&(call_pool->lock));
+        ret = call_pool_trylock (call_pool);
         if (ret)
                 goto out;
 
@@ -227,15 +605,18 @@ gf_proc_dump_pending_frames (call_pool_t *call_pool)
         gf_proc_dump_add_section("global.callpool");
         section_added = _gf_true;
         gf_proc_dump_write("callpool_address","%p", call_pool);
-        gf_proc_dump_write("callpool.cnt","%d", call_pool->cnt);
+        gf_proc_dump_write("callpool.cnt","%"PRId64,
+                           GF_ATOMIC_GET (call_pool->cnt));
+        gf_proc_dump_stack_cache (&frame_depot);
+        gf_proc_dump_stack_cache (&stack_depot);
 
 
-        list_for_each_entry (trav, &call_pool->all_frames, all_frames) {
+        call_pool_for_each_stack (trav, call_pool, shard) {
                 gf_proc_dump_add_section("global.callpool.stack.%d",i);
                 gf_proc_dump_call_stack(trav, "global.callpool.stack.%d", i);
                 i++;
         }
-        UNLOCK (&(call_pool->lock));
+        call_pool_unlock (call_pool);
 
         ret = 0;
 out:
@@ -422,11 +803,12 @@ gf_proc_dump_pending_frames_to_dict (call_pool_t *call_pool, dict_t *dict)
         call_stack_t    *trav = NULL;
         char            key[GF_DUMP_MAX_BUF_LEN] = {0,};
         int             i = 0;
+        int             shard = 0;
 
         if (!call_pool || !dict)
                 return;
 
-        ret = TRY_LOCK (&call_pool->lock);
+        ret = call_pool_trylock (call_pool);
         if (ret) {
                 gf_msg (THIS->name, GF_LOG_WARNING, errno,
                         LG_MSG_LOCK_FAILURE, "Unable to dump call "
@@ -434,11 +816,12 @@ gf_proc_dump_pending_frames_to_dict (call_pool_t *call_pool, dict_t *dict)
                 return;
         }
 
-        ret = dict_set_int32 (dict, "callpool.count", call_pool->cnt);
+        ret = dict_set_int32 (dict, "callpool.count",
+                              GF_ATOMIC_GET (call_pool->cnt));
         if (ret)
                 goto out;
 
-        list_for_each_entry (trav, &call_pool->all_frames, all_frames) {
+        call_pool_for_each_stack (trav, call_pool, shard) {
                 memset (key, 0, sizeof (key));
                 snprintf (key, sizeof (key), "callpool.stack%d", i);
                 gf_proc_dump_call_stack_to_dict (trav, key, dict);
@@ -446,7 +829,7 @@ gf_proc_dump_pending_frames_to_dict (call_pool_t *call_pool, dict_t *dict)
         }
 
 out:
-        UNLOCK (&call_pool->lock);
+        call_pool_unlock (call_pool);
 
         return;
 }
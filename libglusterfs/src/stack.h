@@ -47,19 +47,21 @@ typedef int32_t (*ret_fn_t) (call_frame_t *frame,
                              int32_t op_errno,
                              ...);
 
+/* Stacks in flight are spread over CALL_POOL_SHARDS lists, picked by the
+ * address of the stack, so that creating and destroying stacks on different
+ * threads does not serialize on one lock. Walking all of them (statedump,
+ * meta) takes every shard lock in order. */
+#define CALL_POOL_SHARDS 16
+
+typedef struct call_pool_shard {
+        gf_lock_t                   lock;
+        struct list_head            all_stacks;
+} call_pool_shard_t;
+
 struct call_pool {
-        union {
-                struct list_head   all_frames;
-                struct {
-                        call_stack_t *next_call;
-                        call_stack_t *prev_call;
-                } all_stacks;
-        };
-        int64_t                     cnt;
+        call_pool_shard_t           shards[CALL_POOL_SHARDS];
+        gf_atomic_t                 cnt;
         gf_atomic_t                 total_count;
-        gf_lock_t                   lock;
-        struct mem_pool             *frame_mem_pool;
-        struct mem_pool             *stack_mem_pool;
 };
 
 struct _call_frame {
@@ -155,6 +157,52 @@ struct _call_stack {
 struct xlator_fops;
 void gf_update_latency (call_frame_t *frame);
 
+/* Frames and stacks come from per-thread caches (see stack.c). They are not
+ * zeroed as a whole: frame_alloc() resets everything but root, this, lock and
+ * frames, stack_alloc() everything but the identifier, group and lk-owner
+ * buffers, which are only read up to their length. */
+call_frame_t *frame_alloc (void);
+void frame_free (call_frame_t *frame);
+call_stack_t *stack_alloc (void);
+void stack_free (call_stack_t *stack);
+
+void call_pool_init (call_pool_t *pool);
+void call_pool_fini (call_pool_t *pool);
+void call_pool_lock (call_pool_t *pool);
+int call_pool_trylock (call_pool_t *pool);
+void call_pool_unlock (call_pool_t *pool);
+
+static inline call_pool_shard_t *
+call_pool_shard (call_pool_t *pool, call_stack_t *stack)
+{
+        uint64_t hash = (uintptr_t) stack;
+
+        /* the low bits are the same for all stacks, mix in the rest */
+        hash *= 0x9e3779b97f4a7c15ULL;
+
+        return &pool->shards[hash >> 60 & (CALL_POOL_SHARDS - 1)];
+}
+
+/* Walks every stack in flight, call with call_pool_lock() held. */
+#define call_pool_for_each_stack(stack, pool, idx)                      \
+        for (idx = 0; idx < CALL_POOL_SHARDS; idx++)                    \
+                list_for_each_entry (stack, &(pool)->shards[idx].all_stacks, \
+                                     all_frames)
+
+static inline void
+call_pool_add_stack (call_pool_t *pool, call_stack_t *stack)
+{
+        call_pool_shard_t *shard = call_pool_shard (pool, stack);
+
+        LOCK (&shard->lock);
+        {
+                list_add (&stack->all_frames, &shard->all_stacks);
+        }
+        UNLOCK (&shard->lock);
+        GF_ATOMIC_INC (pool->cnt);
+        GF_ATOMIC_INC (pool->total_count);
+}
+
 
 static inline void
 FRAME_DESTROY (call_frame_t *frame)
@@ -172,7 +220,7 @@ FRAME_DESTROY (call_frame_t *frame)
         }
 
         LOCK_DESTROY (&frame->lock);
-        mem_put (frame);
+        frame_free (frame);
 
         if (local)
                 mem_put (local);
@@ -182,15 +230,17 @@ FRAME_DESTROY (call_frame_t *frame)
 static inline void
 STACK_DESTROY (call_stack_t *stack)
 {
+        call_pool_shard_t *shard = NULL;
         call_frame_t *frame = NULL;
         call_frame_t *tmp = NULL;
 
-        LOCK (&stack->pool->lock);
+        shard = call_pool_shard (stack->pool, stack);
+        LOCK (&shard->lock);
         {
                 list_del_init (&stack->all_frames);
-                stack->pool->cnt--;
         }
-        UNLOCK (&stack->pool->lock);
+        UNLOCK (&shard->lock);
+        GF_ATOMIC_DEC (stack->pool->cnt);
 
         LOCK_DESTROY (&stack->stack_lock);
 
@@ -200,12 +250,13 @@ STACK_DESTROY (call_stack_t *stack)
 
 	GF_FREE (stack->groups_large);
 
-        mem_put (stack);
+        stack_free (stack);
 }
 
 static inline void
 STACK_RESET (call_stack_t *stack)
 {
+        call_pool_shard_t *shard = NULL;
         call_frame_t *frame = NULL;
         call_frame_t *tmp = NULL;
         call_frame_t *last = NULL;
@@ -213,18 +264,20 @@ STACK_RESET (call_stack_t *stack)
 
         INIT_LIST_HEAD (&toreset);
 
-        /* We acquire call_pool->lock only to remove the frames from this stack
-         * to preserve atomicity. This synchronizes across concurrent requests
-         * like statedump, STACK_DESTROY etc. */
+        /* We acquire the lock of the call_pool shard holding this stack only
+         * to remove the frames from this stack to preserve atomicity. This
+         * synchronizes across concurrent requests like statedump,
+         * STACK_DESTROY etc. */
 
-        LOCK (&stack->pool->lock);
+        shard = call_pool_shard (stack->pool, stack);
+        LOCK (&shard->lock);
         {
                 last = list_last_entry (&stack->myframes, call_frame_t, frames);
                 list_del_init (&last->frames);
                 list_splice_init (&stack->myframes, &toreset);
                 list_add (&last->frames, &stack->myframes);
         }
-        UNLOCK (&stack->pool->lock);
+        UNLOCK (&shard->lock);
 
         list_for_each_entry_safe (frame, tmp, &toreset, frames) {
                 FRAME_DESTROY (frame);
@@ -324,7 +377,7 @@ get_the_pt_fop(void *base_fop, int fop_idx)
                 xlator_t     *old_THIS = NULL;                          \
                 typeof(fn)    next_xl_fn = fn;                          \
                                                                         \
-                _new = mem_get0 (frame->root->pool->frame_mem_pool);    \
+                _new = frame_alloc ();                                  \
                 if (!_new) {                                            \
                         break;                                          \
                 }                                                       \
@@ -478,22 +531,19 @@ copy_frame (call_frame_t *frame)
                 return NULL;
         }
 
-        newstack = mem_get0 (frame->root->pool->stack_mem_pool);
+        newstack = stack_alloc ();
         if (newstack == NULL) {
                 return NULL;
         }
 
-        INIT_LIST_HEAD (&newstack->myframes);
-
-        newframe = mem_get0 (frame->root->pool->frame_mem_pool);
+        newframe = frame_alloc ();
         if (!newframe) {
-                mem_put (newstack);
+                stack_free (newstack);
                 return NULL;
         }
 
         newframe->this = frame->this;
         newframe->root = newstack;
-        INIT_LIST_HEAD (&newframe->frames);
         list_add (&newframe->frames, &newstack->myframes);
 
         oldstack = frame->root;
@@ -506,7 +556,8 @@ copy_frame (call_frame_t *frame)
         newstack->ctime = oldstack->ctime;
         newstack->flags = oldstack->flags;
 	if (call_stack_alloc_groups (newstack, oldstack->ngrps) != 0) {
-		mem_put (newstack);
+                frame_free (newframe);
+                stack_free (newstack);
 		return NULL;
 	}
         if (!oldstack->groups) {
@@ -525,7 +576,7 @@ copy_frame (call_frame_t *frame)
                 sizeof (gid_t) * oldstack->ngrps);
         newstack->unique = oldstack->unique;
         newstack->pool = oldstack->pool;
-        newstack->lk_owner = oldstack->lk_owner;
+        lk_owner_copy (&newstack->lk_owner, &oldstack->lk_owner);
         newstack->ctx = oldstack->ctx;
 
         if (newstack->ctx->measure_latency) {
@@ -537,13 +588,7 @@ copy_frame (call_frame_t *frame)
         LOCK_INIT (&newframe->lock);
         LOCK_INIT (&newstack->stack_lock);
 
-        LOCK (&oldstack->pool->lock);
-        {
-                list_add (&newstack->all_frames, &oldstack->all_frames);
-                newstack->pool->cnt++;
-        }
-        UNLOCK (&oldstack->pool->lock);
-        GF_ATOMIC_INC (newstack->pool->total_count);
+        call_pool_add_stack (newstack->pool, newstack);
 
         return newframe;
 }
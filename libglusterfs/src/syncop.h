@@ -150,6 +150,7 @@ struct syncargs {
         int                 op_errno;
         struct iatt         iatt1;
         struct iatt         iatt2;
+        struct iatt         iatt3;
         dict_t             *xattr;
         struct statvfs     statvfs_buf;
         struct iovec       *vector;
@@ -586,6 +587,19 @@ syncop_icreate (xlator_t *subvol, loc_t *loc, mode_t mode, dict_t *xdata_out);
 int
 syncop_namelink (xlator_t *subvol, loc_t *loc, dict_t *xdata_out);
 
+int
+syncop_copy_file_range (xlator_t *subvol, fd_t *fd_in, off_t off_in,
+                        fd_t *fd_out, off_t off_out, size_t len,
+                        uint32_t flags, struct iatt *stbuf,
+                        struct iatt *preiatt_dst, struct iatt *postiatt_dst,
+                        dict_t *xdata_in, dict_t **xdata_out);
+
+int
+syncop_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                            xlator_t *this, int op_ret, int op_errno,
+                            struct iatt *stbuf, struct iatt *prebuf_dst,
+                            struct iatt *postbuf_dst, dict_t *xdata);
+
 int
 syncop_entrylk (xlator_t *subvol, const char *volume, loc_t *loc,
                 const char *basename, entrylk_cmd cmd, entrylk_type type,
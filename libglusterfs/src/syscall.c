@@ -19,6 +19,9 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdarg.h>
+#ifdef GF_LINUX_HOST_OS
+#include <sys/syscall.h>
+#endif
 
 #define FS_ERROR_LOG(result)                                                   \
         do {                                                                   \
@@ -404,6 +407,24 @@ sys_pwrite (int fd, const void *buf, size_t count, off_t offset)
 }
 
 
+ssize_t
+sys_copy_file_range (int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+                     size_t len, unsigned int flags)
+{
+#if defined(HAVE_COPY_FILE_RANGE)
+        return FS_RET_CHECK(copy_file_range (fd_in, off_in, fd_out, off_out,
+                                             len, flags), errno);
+#elif defined(SYS_copy_file_range)
+        /* glibc < 2.27 has no wrapper but the kernel may have the call */
+        return FS_RET_CHECK(syscall (SYS_copy_file_range, fd_in, off_in,
+                                     fd_out, off_out, len, flags), errno);
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+}
+
+
 off_t
 sys_lseek (int fd, off_t offset, int whence)
 {
@@ -222,4 +222,8 @@ sys_pread(int fd, void *buf, size_t count, off_t offset);
 ssize_t
 sys_pwrite(int fd, const void *buf, size_t count, off_t offset);
 
+ssize_t
+sys_copy_file_range (int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+                     size_t len, unsigned int flags);
+
 #endif /* __SYSCALL_H__ */
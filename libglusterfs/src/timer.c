@@ -19,6 +19,154 @@
 static gf_timer_registry_t *
 gf_timer_registry_init (glusterfs_ctx_t *);
 
+
+/* the tick at which a timer expiring at @at is due, rounded up so that
+ * timers never fire early */
+static uint64_t
+gf_timer_tick (gf_timer_registry_t *reg, struct timespec *at)
+{
+        uint64_t ns = TS ((*at));
+
+        if (ns <= reg->start)
+                return 0;
+
+        return (ns - reg->start + GF_TIMER_TICK_NS - 1) / GF_TIMER_TICK_NS;
+}
+
+
+static void
+__gf_timer_enqueue (gf_timer_registry_t *reg, gf_timer_t *event)
+{
+        struct list_head *vec = NULL;
+        uint64_t          expires = event->expires;
+        uint64_t          idx = 0;
+        int               shift = 0;
+        int               i = 0;
+
+        if (expires < reg->tick)
+                expires = reg->tick;
+
+        idx = expires - reg->tick;
+
+        if (idx < GF_TIMER_ROOT_SIZE) {
+                vec = &reg->root[expires & GF_TIMER_ROOT_MASK];
+                goto add;
+        }
+
+        for (i = 0; i < GF_TIMER_LEVELS; i++) {
+                shift = GF_TIMER_ROOT_BITS + i * GF_TIMER_LEVEL_BITS;
+                if (idx < (1ULL << (shift + GF_TIMER_LEVEL_BITS)))
+                        break;
+        }
+
+        if (i == GF_TIMER_LEVELS) {
+                /* beyond the span of the wheel (~50 days): park it in the
+                 * farthest slot, it is placed again when cascaded */
+                i = GF_TIMER_LEVELS - 1;
+                shift = GF_TIMER_ROOT_BITS + i * GF_TIMER_LEVEL_BITS;
+                expires = reg->tick +
+                          (1ULL << (shift + GF_TIMER_LEVEL_BITS)) - 1;
+        }
+
+        vec = &reg->level[i][(expires >> shift) & GF_TIMER_LEVEL_MASK];
+add:
+        list_add_tail (&event->list, vec);
+}
+
+
+/* move the timers of a level slot down to where they now belong */
+static int
+__gf_timer_cascade (gf_timer_registry_t *reg, int level, int index)
+{
+        struct list_head  head;
+        gf_timer_t       *event = NULL;
+        gf_timer_t       *tmp = NULL;
+
+        INIT_LIST_HEAD (&head);
+        list_splice_init (&reg->level[level][index], &head);
+
+        list_for_each_entry_safe (event, tmp, &head, list) {
+                list_del (&event->list);
+                __gf_timer_enqueue (reg, event);
+        }
+
+        return index;
+}
+
+
+/* run the wheel up to and including tick @now, moving the timers that are
+ * due to @expired */
+static void
+__gf_timer_run (gf_timer_registry_t *reg, uint64_t now,
+                struct list_head *expired)
+{
+        gf_timer_t *event = NULL;
+        int         index = 0;
+        int         shift = 0;
+        int         i = 0;
+
+        while (reg->tick <= now) {
+                index = reg->tick & GF_TIMER_ROOT_MASK;
+
+                if (!index) {
+                        for (i = 0; i < GF_TIMER_LEVELS; i++) {
+                                shift = GF_TIMER_ROOT_BITS +
+                                        i * GF_TIMER_LEVEL_BITS;
+                                if (__gf_timer_cascade (reg, i,
+                                                        (reg->tick >> shift) &
+                                                        GF_TIMER_LEVEL_MASK))
+                                        break;
+                        }
+                }
+
+                list_for_each_entry (event, &reg->root[index], list) {
+                        event->fired = _gf_true;
+                        reg->count--;
+                }
+                list_append_init (&reg->root[index], expired);
+
+                reg->tick++;
+        }
+}
+
+
+/* the tick at which the timer thread needs to run next */
+static uint64_t
+__gf_timer_next (gf_timer_registry_t *reg)
+{
+        uint64_t tick = reg->tick;
+
+        if (!reg->count)
+                return tick + 1000000000ULL / GF_TIMER_TICK_NS;
+
+        /* a cascade is due on this very tick, the root slot it fills is
+         * still empty */
+        if (!(tick & GF_TIMER_ROOT_MASK))
+                return tick;
+
+        /* scan the root up to the next cascade */
+        do {
+                if (!list_empty (&reg->root[tick & GF_TIMER_ROOT_MASK]))
+                        break;
+                tick++;
+        } while (tick & GF_TIMER_ROOT_MASK);
+
+        return tick;
+}
+
+
+static void
+gf_timer_wake (gf_timer_registry_t *reg)
+{
+        pthread_mutex_lock (&reg->sleep_lock);
+        {
+                reg->woken = _gf_true;
+                pthread_cond_signal (&reg->sleep_cond);
+        }
+        pthread_mutex_unlock (&reg->sleep_lock);
+}
+
+
 gf_timer_t *
 gf_timer_call_after (glusterfs_ctx_t *ctx,
                      struct timespec delta,
@@ -27,8 +175,7 @@ gf_timer_call_after (glusterfs_ctx_t *ctx,
 {
         gf_timer_registry_t *reg = NULL;
         gf_timer_t *event = NULL;
-        gf_timer_t *trav = NULL;
-        uint64_t at = 0;
+        gf_boolean_t wake = _gf_false;
 
         if ((ctx == NULL) || (ctx->cleanup_started))
         {
@@ -46,25 +193,31 @@ gf_timer_call_after (glusterfs_ctx_t *ctx,
                 return NULL;
         }
 
-        event = GF_CALLOC (1, sizeof (*event), gf_common_mt_gf_timer_t);
+        event = mem_get0 (reg->timer_pool);
         if (!event) {
                 return NULL;
         }
         timespec_now (&event->at);
         timespec_adjust_delta (&event->at, delta);
-        at = TS (event->at);
+        event->expires = gf_timer_tick (reg, &event->at);
         event->callbk = callbk;
         event->data = data;
         event->xl = THIS;
         LOCK (&reg->lock);
         {
-                list_for_each_entry_reverse (trav, &reg->active, list) {
-                        if (TS (trav->at) < at)
-                                break;
+                __gf_timer_enqueue (reg, event);
+                reg->count++;
+                if (event->expires < reg->wakeup) {
+                        reg->wakeup = event->expires;
+                        wake = _gf_true;
                 }
-                list_add (&event->list, &trav->list);
         }
         UNLOCK (&reg->lock);
+
+        /* due before the timer thread wakes up on its own */
+        if (wake)
+                gf_timer_wake (reg);
+
         return event;
 }
 
@@ -111,12 +264,13 @@ gf_timer_call_cancel (glusterfs_ctx_t *ctx,
                 if (fired)
                         goto unlock;
                 list_del (&event->list);
+                reg->count--;
         }
 unlock:
         UNLOCK (&reg->lock);
 
         if (!fired) {
-                GF_FREE (event);
+                mem_put (event);
                 return 0;
         }
         return -1;
@@ -128,78 +282,73 @@ gf_timer_proc (void *data)
 {
         gf_timer_registry_t *reg = data;
         struct timespec sleepts;
+        struct timespec now_ts;
+        uint64_t    wakeup = 0;
+        struct list_head expired;
         gf_timer_t *event = NULL;
         gf_timer_t *tmp = NULL;
         xlator_t   *old_THIS = NULL;
+        uint64_t    next = 0;
+        uint64_t    now = 0;
+        int         i = 0;
+        int         j = 0;
 
-        while (!reg->fin) {
-                uint64_t now;
-                struct timespec now_ts;
+        INIT_LIST_HEAD (&expired);
 
+        while (!reg->fin) {
                 timespec_now (&now_ts);
                 now = TS (now_ts);
-                while (1) {
-                        uint64_t at;
-                        char need_cbk = 0;
-
-                        /*
-                         * This will be overridden with a shorter interval if
-                         * there's an event scheduled sooner. That makes the
-                         * system more responsive in most cases, but doesn't
-                         * include the case where a timer is added while we're
-                         * asleep. It's tempting to use pthread_cond_timedwait,
-                         * with the caveat that we'd be relying on system time
-                         * instead of monotonic time. That's a mess when the
-                         * system time is adjusted.  Another alternative might
-                         * be to use pthread_kill, but that will remain TBD for
-                         * now.
-                         */
-                        sleepts.tv_sec = 1;
-                        sleepts.tv_nsec = 0;
-
-                        LOCK (&reg->lock);
-                        {
-                                /*
-                                 * Using list_for_each and then always breaking
-                                 * after the first iteration might seem strange,
-                                 * but (unlike alternatives) is independent of
-                                 * the underlying list implementation.
-                                 */
-                                list_for_each_entry_safe (event,
-                                             tmp, &reg->active, list) {
-                                        at = TS (event->at);
-                                        if (now >= at) {
-                                                need_cbk = 1;
-                                                event->fired = _gf_true;
-                                                list_del (&event->list);
-                                        } else {
-                                                uint64_t diff = now - at;
-
-                                                if (diff < 1000000000) {
-                                                        sleepts.tv_sec = 0;
-                                                        sleepts.tv_nsec = diff;
-                                                }
-                                        }
-                                        break;
-                                }
+
+                LOCK (&reg->lock);
+                {
+                        __gf_timer_run (reg,
+                                        (now - reg->start) / GF_TIMER_TICK_NS,
+                                        &expired);
+                }
+                UNLOCK (&reg->lock);
+
+                list_for_each_entry_safe (event, tmp, &expired, list) {
+                        list_del (&event->list);
+                        old_THIS = NULL;
+                        if (event->xl) {
+                                old_THIS = THIS;
+                                THIS = event->xl;
                         }
-                        UNLOCK (&reg->lock);
-                        if (need_cbk) {
-                                old_THIS = NULL;
-                                if (event->xl) {
-                                        old_THIS = THIS;
-                                        THIS = event->xl;
-                                }
-                                event->callbk (event->data);
-                                GF_FREE (event);
-                                if (old_THIS) {
-                                        THIS = old_THIS;
-                                }
-                        } else {
-                                break;
+                        event->callbk (event->data);
+                        mem_put (event);
+                        if (old_THIS) {
+                                THIS = old_THIS;
+                        }
+                }
+
+                /*
+                 * Sleep until the next timer is due. gf_timer_call_after()
+                 * wakes us up earlier if it adds a timer that is due before
+                 * @wakeup. The condition variable uses the monotonic clock,
+                 * so adjusting the system time does not affect us.
+                 */
+                LOCK (&reg->lock);
+                {
+                        wakeup = __gf_timer_next (reg);
+                        reg->wakeup = wakeup;
+                }
+                UNLOCK (&reg->lock);
+
+                next = reg->start + wakeup * GF_TIMER_TICK_NS;
+                sleepts.tv_sec = next / 1000000000ULL;
+                sleepts.tv_nsec = next % 1000000000ULL;
+
+                pthread_mutex_lock (&reg->sleep_lock);
+                {
+                        while (!reg->woken && !reg->fin) {
+                                if (pthread_cond_timedwait (&reg->sleep_cond,
+                                                            &reg->sleep_lock,
+                                                            &sleepts))
+                                        break;
                         }
+                        reg->woken = _gf_false;
                 }
-                nanosleep (&sleepts, NULL);
+                pthread_mutex_unlock (&reg->sleep_lock);
         }
 
         LOCK (&reg->lock);
@@ -207,13 +356,23 @@ gf_timer_proc (void *data)
                 /* Do not call gf_timer_call_cancel(),
                  * it will lead to deadlock
                  */
-                list_for_each_entry_safe (event, tmp, &reg->active, list) {
+                for (i = 0; i < GF_TIMER_ROOT_SIZE; i++)
+                        list_splice_init (&reg->root[i], &expired);
+                for (i = 0; i < GF_TIMER_LEVELS; i++) {
+                        for (j = 0; j < GF_TIMER_LEVEL_SIZE; j++)
+                                list_splice_init (&reg->level[i][j],
+                                                  &expired);
+                }
+                list_for_each_entry_safe (event, tmp, &expired, list) {
                         list_del (&event->list);
-                        GF_FREE (event);
+                        mem_put (event);
                 }
+                reg->count = 0;
         }
         UNLOCK (&reg->lock);
         LOCK_DESTROY (&reg->lock);
+        pthread_cond_destroy (&reg->sleep_cond);
+        pthread_mutex_destroy (&reg->sleep_lock);
 
         return NULL;
 }
@@ -223,24 +382,59 @@ static gf_timer_registry_t *
 gf_timer_registry_init (glusterfs_ctx_t *ctx)
 {
         gf_timer_registry_t *reg = NULL;
+        struct mem_pool *pool = NULL;
+        pthread_condattr_t attr;
+        struct timespec now = {0, };
         int ret = -1;
+        int i = 0;
+        int j = 0;
+
+        LOCK (&ctx->lock);
+        {
+                reg = ctx->timer;
+        }
+        UNLOCK (&ctx->lock);
+        if (reg)
+                goto out;
+
+        /* mem_pool_new() takes ctx->lock itself */
+        pool = mem_pool_new_ctx (ctx, gf_timer_t, 4096);
+        if (!pool)
+                goto out;
 
         LOCK (&ctx->lock);
         {
                 reg = ctx->timer;
                 if (reg) {
                         UNLOCK (&ctx->lock);
+                        mem_pool_destroy (pool);
                         goto out;
                 }
                 reg = GF_CALLOC (1, sizeof (*reg),
                               gf_common_mt_gf_timer_registry_t);
                 if (!reg) {
                         UNLOCK (&ctx->lock);
+                        mem_pool_destroy (pool);
                         goto out;
                 }
-                ctx->timer = reg;
                 LOCK_INIT (&reg->lock);
-                INIT_LIST_HEAD (&reg->active);
+                pthread_mutex_init (&reg->sleep_lock, NULL);
+                pthread_condattr_init (&attr);
+#if !defined(GF_DARWIN_HOST_OS)
+                pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+#endif
+                pthread_cond_init (&reg->sleep_cond, &attr);
+                pthread_condattr_destroy (&attr);
+                reg->timer_pool = pool;
+                timespec_now (&now);
+                reg->start = TS (now);
+                for (i = 0; i < GF_TIMER_ROOT_SIZE; i++)
+                        INIT_LIST_HEAD (&reg->root[i]);
+                for (i = 0; i < GF_TIMER_LEVELS; i++) {
+                        for (j = 0; j < GF_TIMER_LEVEL_SIZE; j++)
+                                INIT_LIST_HEAD (&reg->level[i][j]);
+                }
+                ctx->timer = reg;
         }
         UNLOCK (&ctx->lock);
         ret = gf_thread_create (&reg->th, NULL, gf_timer_proc, reg, "timer");
@@ -276,6 +470,8 @@ gf_timer_registry_destroy (glusterfs_ctx_t *ctx)
 
         thr_id = reg->th;
         reg->fin = 1;
+        gf_timer_wake (reg);
         pthread_join (thr_id, NULL);
+        mem_pool_destroy (reg->timer_pool);
         GF_FREE (reg);
 }
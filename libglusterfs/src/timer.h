@@ -31,13 +31,40 @@ struct _gf_timer {
         void             *data;
         xlator_t         *xl;
 	gf_boolean_t      fired;
+        uint64_t          expires;  /* wheel tick the timer is due at */
 };
 
+/* Pending timers live in a hierarchical timing wheel with a resolution of
+ * GF_TIMER_TICK_NS: a root vector of 2^GF_TIMER_ROOT_BITS one-tick slots,
+ * followed by GF_TIMER_LEVELS vectors of 2^GF_TIMER_LEVEL_BITS slots, each
+ * slot of a level spanning a whole vector of the level below. Adding and
+ * cancelling a timer is O(1); timers in the upper levels are cascaded down
+ * whenever the vector below wraps around.
+ */
+#define GF_TIMER_TICK_NS        1000000ULL  /* 1ms */
+#define GF_TIMER_ROOT_BITS      8
+#define GF_TIMER_LEVEL_BITS     6
+#define GF_TIMER_LEVELS         4
+#define GF_TIMER_ROOT_SIZE      (1 << GF_TIMER_ROOT_BITS)
+#define GF_TIMER_LEVEL_SIZE     (1 << GF_TIMER_LEVEL_BITS)
+#define GF_TIMER_ROOT_MASK      (GF_TIMER_ROOT_SIZE - 1)
+#define GF_TIMER_LEVEL_MASK     (GF_TIMER_LEVEL_SIZE - 1)
+
 struct _gf_timer_registry {
         pthread_t        th;
         char             fin;
-        struct list_head active;
         gf_lock_t        lock;
+        struct mem_pool *timer_pool;    /* gf_timer_t objects */
+        uint64_t         start;         /* TS() of tick 0 */
+        uint64_t         tick;          /* next tick to be run */
+        uint64_t         count;         /* pending timers */
+        uint64_t         wakeup;        /* tick the timer thread sleeps
+                                           until */
+        pthread_mutex_t  sleep_lock;
+        pthread_cond_t   sleep_cond;    /* CLOCK_MONOTONIC based */
+        gf_boolean_t     woken;         /* under sleep_lock */
+        struct list_head root[GF_TIMER_ROOT_SIZE];
+        struct list_head level[GF_TIMER_LEVELS][GF_TIMER_LEVEL_SIZE];
 };
 
 typedef struct _gf_timer gf_timer_t;
@@ -113,6 +113,7 @@ fill_defaults (xlator_t *xl)
         SET_DEFAULT_FOP (getspec);
         SET_DEFAULT_FOP (icreate);
         SET_DEFAULT_FOP (namelink);
+        SET_DEFAULT_FOP (copy_file_range);
 
         if (!xl->cbks)
                 xl->cbks = &default_cbks;
@@ -889,10 +890,14 @@ xlator_members_free (xlator_t *xl)
 {
         volume_opt_list_t *vol_opt = NULL;
         volume_opt_list_t *tmp     = NULL;
+        int                i       = 0;
 
         if (!xl)
                 return 0;
 
+        for (i = 0; i < GF_FOP_MAXVALUE; i++)
+                GF_FREE (xl->stats.interval.latency_hist[i]);
+
         GF_FREE (xl->name);
         GF_FREE (xl->type);
         if (!(xl->ctx && xl->ctx->cmd_args.valgrind) && xl->dlhandle)
@@ -482,6 +482,14 @@ typedef int32_t (*fop_namelink_cbk_t) (call_frame_t *frame, void *cookie,
                                        int32_t op_errno, struct iatt *prebuf,
                                        struct iatt *postbuf, dict_t *xdata);
 
+typedef int32_t (*fop_copy_file_range_cbk_t) (call_frame_t *frame,
+                                              void *cookie, xlator_t *this,
+                                              int32_t op_ret, int32_t op_errno,
+                                              struct iatt *stbuf,
+                                              struct iatt *prebuf_dst,
+                                              struct iatt *postbuf_dst,
+                                              dict_t *xdata);
+
 typedef int32_t (*fop_lookup_t) (call_frame_t *frame,
                                  xlator_t *this,
                                  loc_t *loc,
@@ -754,6 +762,12 @@ typedef int32_t (*fop_icreate_t) (call_frame_t *frame, xlator_t *this,
 typedef int32_t (*fop_namelink_t) (call_frame_t *frame, xlator_t *this,
                                    loc_t *loc, dict_t *xdata);
 
+typedef int32_t (*fop_copy_file_range_t) (call_frame_t *frame, xlator_t *this,
+                                          fd_t *fd_in, off_t off_in,
+                                          fd_t *fd_out, off_t off_out,
+                                          size_t len, uint32_t flags,
+                                          dict_t *xdata);
+
 /* WARNING: make sure the list is in order with FOP definition in
    `rpc/xdr/src/glusterfs-fops.x`.
    If it is not in order, mainly the metrics related feature would be broken */
@@ -818,6 +832,7 @@ struct xlator_fops {
         fop_put_t            put;
         fop_icreate_t        icreate;
         fop_namelink_t       namelink;
+        fop_copy_file_range_t copy_file_range;
 
         /* these entries are used for a typechecking hack in STACK_WIND _only_ */
         /* make sure to add _cbk variables only after defining regular fops as
@@ -882,6 +897,7 @@ struct xlator_fops {
         fop_put_cbk_t            put_cbk;
         fop_icreate_cbk_t        icreate_cbk;
         fop_namelink_cbk_t       namelink_cbk;
+        fop_copy_file_range_cbk_t copy_file_range_cbk;
 };
 
 typedef int32_t (*cbk_forget_t) (xlator_t *this,
@@ -1001,6 +1017,8 @@ struct _xlator {
                 struct {
                         /* for latency measurement */
                         fop_latency_t latencies[GF_FOP_MAXVALUE];
+                        /* allocated on first use of the fop */
+                        gf_latency_hist_t *latency_hist[GF_FOP_MAXVALUE];
                         /* for latency measurement */
                         fop_metrics_t metrics[GF_FOP_MAXVALUE];
 
@@ -39,6 +39,9 @@
 #include <errno.h>
 #include <rpc/xdr.h>
 #include <sys/ioctl.h>
+#ifdef GF_SOCKET_ZEROCOPY
+#include <linux/errqueue.h>
+#endif
 #define GF_LOG_ERRNO(errno) ((errno == ENOTCONN) ? GF_LOG_DEBUG : GF_LOG_ERROR)
 #define SA(ptr) ((struct sockaddr *)ptr)
 
@@ -629,6 +632,34 @@ __does_socket_rwv_error_need_logging (socket_private_t *priv, int write)
         return _gf_true;
 }
 
+static ssize_t
+__socket_sendv (rpc_transport_t *this, struct iovec *vector, int count,
+                gf_boolean_t zerocopy)
+{
+        socket_private_t *priv = this->private;
+        ssize_t           ret = -1;
+#ifdef GF_SOCKET_ZEROCOPY
+        struct msghdr     msg = {0, };
+
+        if (zerocopy && priv->zc_enabled) {
+                msg.msg_iov = vector;
+                msg.msg_iovlen = count;
+                ret = sendmsg (priv->sock, &msg, MSG_ZEROCOPY);
+                if (ret > 0) {
+                        /* every send that took data gets the next id */
+                        priv->zc_next++;
+                        return ret;
+                }
+                /* ENOBUFS: out of optmem for pinning pages, just copy */
+                if (ret == 0 || errno != ENOBUFS)
+                        return ret;
+        }
+#endif
+        ret = sys_writev (priv->sock, vector, count);
+
+        return ret;
+}
+
 /*
  * return value:
  *   0 = success (completed)
@@ -639,10 +670,9 @@ __does_socket_rwv_error_need_logging (socket_private_t *priv, int write)
 static int
 __socket_rwv (rpc_transport_t *this, struct iovec *vector, int count,
               struct iovec **pending_vector, int *pending_count, size_t *bytes,
-              int write)
+              int write, gf_boolean_t zerocopy)
 {
         socket_private_t *priv = NULL;
-        int               sock = -1;
         int               ret = -1;
         struct iovec     *opvector = NULL;
         int               opcount = 0;
@@ -652,7 +682,6 @@ __socket_rwv (rpc_transport_t *this, struct iovec *vector, int count,
         GF_VALIDATE_OR_GOTO ("socket", this->private, out);
 
         priv = this->private;
-        sock = priv->sock;
 
         opvector = vector;
         opcount  = count;
@@ -684,7 +713,9 @@ __socket_rwv (rpc_transport_t *this, struct iovec *vector, int count,
                                 ret = ssl_write_one (this, opvector->iov_base,
                                                      opvector->iov_len);
                         } else {
-                                ret = sys_writev (sock, opvector, IOV_MIN(opcount));
+                                ret = __socket_sendv (this, opvector,
+                                                      IOV_MIN(opcount),
+                                                      zerocopy);
                         }
 
                         if (ret == 0 || (ret == -1 && errno == EAGAIN)) {
@@ -789,7 +820,8 @@ __socket_readv (rpc_transport_t *this, struct iovec *vector, int count,
         int ret = -1;
 
         ret = __socket_rwv (this, vector, count,
-                            pending_vector, pending_count, bytes, 0);
+                            pending_vector, pending_count, bytes, 0,
+                            _gf_false);
 
         return ret;
 }
@@ -797,12 +829,14 @@ __socket_readv (rpc_transport_t *this, struct iovec *vector, int count,
 
 static int
 __socket_writev (rpc_transport_t *this, struct iovec *vector, int count,
-                 struct iovec **pending_vector, int *pending_count)
+                 struct iovec **pending_vector, int *pending_count,
+                 size_t *bytes, gf_boolean_t zerocopy)
 {
         int ret = -1;
 
         ret = __socket_rwv (this, vector, count,
-                            pending_vector, pending_count, NULL, 1);
+                            pending_vector, pending_count, bytes, 1,
+                            zerocopy);
 
         return ret;
 }
@@ -964,6 +998,37 @@ __socket_nodelay (int fd)
 }
 
 
+/* Asks for MSG_ZEROCOPY sends on a connected socket. Unix sockets would
+ * just copy anyway, SSL encrypts into its own buffers. Loopback shows up
+ * as copied completions later and turns it off again. */
+static void
+__socket_zerocopy_enable (rpc_transport_t *this, int sa_family)
+{
+        socket_private_t *priv = this->private;
+#ifdef GF_SOCKET_ZEROCOPY
+        int               on = 1;
+
+        if (!priv->zerocopy || priv->use_ssl || sa_family == AF_UNIX)
+                return;
+
+        if (setsockopt (priv->sock, SOL_SOCKET, SO_ZEROCOPY, &on,
+                        sizeof (on)) == -1) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "SO_ZEROCOPY on %d failed (%s)", priv->sock,
+                        strerror (errno));
+                return;
+        }
+
+        priv->zc_enabled = _gf_true;
+#else
+        if (priv->zerocopy)
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "MSG_ZEROCOPY not supported, ignoring "
+                        "transport.socket.zerocopy");
+#endif
+}
+
+
 static int
 __socket_keepalive (int fd, int family, int keepaliveintvl,
                     int keepaliveidle, int keepalivecnt, int timeout)
@@ -1147,12 +1212,15 @@ socket_set_last_frag_header_size (uint32_t size, char *haddr)
 static struct ioq *
 __socket_ioq_new (rpc_transport_t *this, rpc_transport_msg_t *msg)
 {
+        socket_private_t *priv = NULL;
         struct ioq       *entry = NULL;
         int               count = 0;
         uint32_t          size  = 0;
 
         GF_VALIDATE_OR_GOTO ("socket", this, out);
 
+        priv = this->private;
+
         /* TODO: use mem-pool */
         entry = GF_CALLOC (1, sizeof (*entry), gf_common_mt_ioq);
         if (!entry)
@@ -1204,6 +1272,13 @@ __socket_ioq_new (rpc_transport_t *this, rpc_transport_msg_t *msg)
         if (msg->iobref != NULL)
                 entry->iobref = iobref_ref (msg->iobref);
 
+        /* only payloads that live in the iobref can stay pinned by the
+         * kernel after the write returns, the rest is tiny anyway */
+        if (priv->zerocopy && priv->zc_enabled && entry->iobref &&
+            iov_length (msg->progpayload, msg->progpayloadcount) >=
+            priv->zc_threshold)
+                entry->zerocopy = _gf_true;
+
         INIT_LIST_HEAD (&entry->list);
 
 out:
@@ -1244,27 +1319,240 @@ __socket_ioq_flush (rpc_transport_t *this)
                 __socket_ioq_entry_free (entry);
         }
 
+        while (!list_empty (&priv->zc_pending)) {
+                entry = list_first_entry (&priv->zc_pending, struct ioq, list);
+                __socket_ioq_entry_free (entry);
+        }
+
 out:
         return;
 }
 
 
+/* An entry that went out (partly) with MSG_ZEROCOPY may still be read by the
+ * kernel after the send returned. Keep it, and its iobref, until the kernel
+ * reports the send as completed. */
+static void
+__socket_ioq_entry_done (rpc_transport_t *this, struct ioq *entry)
+{
+        socket_private_t *priv = this->private;
+
+        if (entry->zc_sent && (int32_t)(entry->zc_id - priv->zc_done) >= 0) {
+                list_move_tail (&entry->list, &priv->zc_pending);
+                return;
+        }
+
+        __socket_ioq_entry_free (entry);
+}
+
+
+static int
+__socket_zerocopy_reap (rpc_transport_t *this)
+{
+        int                       reaped = 0;
+#ifdef GF_SOCKET_ZEROCOPY
+        socket_private_t         *priv = this->private;
+        struct ioq               *entry = NULL;
+        struct sock_extended_err *serr = NULL;
+        struct cmsghdr           *cm = NULL;
+        struct msghdr             msg = {0, };
+        char                      control[128];
+
+        for (;;) {
+                memset (&msg, 0, sizeof (msg));
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof (control);
+
+                if (recvmsg (priv->sock, &msg,
+                             MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+                        break;
+
+                for (cm = CMSG_FIRSTHDR (&msg); cm;
+                     cm = CMSG_NXTHDR (&msg, cm)) {
+                        if (!(cm->cmsg_level == SOL_IP &&
+                              cm->cmsg_type == IP_RECVERR) &&
+                            !(cm->cmsg_level == SOL_IPV6 &&
+                              cm->cmsg_type == IPV6_RECVERR))
+                                continue;
+
+                        serr = (struct sock_extended_err *)CMSG_DATA (cm);
+                        if (serr->ee_errno != 0 ||
+                            serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                                continue;
+
+                        /* ee_info..ee_data is the range of completed ids,
+                         * TCP completes them in order */
+                        if ((int32_t)(serr->ee_data + 1 - priv->zc_done) > 0)
+                                priv->zc_done = serr->ee_data + 1;
+                        reaped++;
+
+                        if ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) &&
+                            priv->zc_enabled) {
+                                /* e.g. loopback, or a device without
+                                 * scatter-gather: only extra work */
+                                priv->zc_copied++;
+                                priv->zc_enabled = _gf_false;
+                                gf_log (this->name, GF_LOG_INFO,
+                                        "kernel copied zerocopy sends on "
+                                        "socket %d, not using MSG_ZEROCOPY "
+                                        "on it any more", priv->sock);
+                        }
+                }
+        }
+
+        while (!list_empty (&priv->zc_pending)) {
+                entry = list_first_entry (&priv->zc_pending, struct ioq, list);
+                if ((int32_t)(entry->zc_id - priv->zc_done) >= 0)
+                        break;
+                __socket_ioq_entry_free (entry);
+        }
+
+        /* reconfigure turned zerocopy off, the kernel has given back all
+         * it still held */
+        if (!priv->zerocopy && priv->zc_next == priv->zc_done)
+                priv->zc_enabled = _gf_false;
+#endif
+        return reaped;
+}
+
+
+/* Before the ioq is freed on a dead connection: drop whatever the kernel
+ * still holds of zerocopy sends, the close itself can be deferred by the
+ * event layer. connect (AF_UNSPEC) disconnects the socket and purges its
+ * send queue right away. */
+static void
+__socket_zerocopy_abort (rpc_transport_t *this)
+{
+        socket_private_t *priv = this->private;
+        struct sockaddr   sa = {0, };
+
+        if (priv->zc_next == priv->zc_done || priv->sock == -1)
+                return;
+
+        sa.sa_family = AF_UNSPEC;
+        if (connect (priv->sock, &sa, sizeof (sa)) == -1)
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "could not purge zerocopy sends of socket %d (%s)",
+                        priv->sock, strerror (errno));
+
+        priv->zc_done = priv->zc_next;
+}
+
+
+/* how much of 'bytes' written from the head of the ioq belongs to entry */
+static size_t
+__socket_ioq_entry_advance (struct ioq *entry, size_t bytes)
+{
+        size_t  done = 0;
+        size_t  len = 0;
+
+        while (entry->pending_count &&
+               (done < bytes || !entry->pending_vector[0].iov_len)) {
+                len = entry->pending_vector[0].iov_len;
+                if (bytes - done >= len) {
+                        done += len;
+                        entry->pending_vector++;
+                        entry->pending_count--;
+                } else {
+                        entry->pending_vector[0].iov_base += (bytes - done);
+                        entry->pending_vector[0].iov_len -= (bytes - done);
+                        done = bytes;
+                }
+        }
+
+        return done;
+}
+
+
 static int
 __socket_ioq_churn_entry (rpc_transport_t *this, struct ioq *entry, int direct)
 {
+        socket_private_t *priv = this->private;
+        uint32_t          zc_next = priv->zc_next;
         int               ret = -1;
 
         ret = __socket_writev (this, entry->pending_vector,
                                entry->pending_count,
                                &entry->pending_vector,
-                               &entry->pending_count);
+                               &entry->pending_count,
+                               NULL, entry->zerocopy);
+
+        if (priv->zc_next != zc_next) {
+                entry->zc_sent = _gf_true;
+                entry->zc_id = priv->zc_next - 1;
+        }
 
         if (ret == 0) {
                 /* current entry was completely written */
                 GF_ASSERT (entry->pending_count == 0);
-                __socket_ioq_entry_free (entry);
+                __socket_ioq_entry_done (this, entry);
+        }
+
+        return ret;
+}
+
+
+/* Writes as many queued entries as fit in IOV_MAX vectors with one writev
+ * (or sendmsg) instead of one per entry. Replies queue up here whenever the
+ * socket buffer was full, so this is where the batching pays off. */
+static int
+__socket_ioq_churn_batch (rpc_transport_t *this)
+{
+        socket_private_t *priv = this->private;
+        struct ioq       *entry = NULL;
+        struct ioq       *tmp = NULL;
+        struct iovec     *pending = NULL;
+        int               pending_count = 0;
+        gf_boolean_t      zerocopy = _gf_false;
+        uint32_t          zc_next = priv->zc_next;
+        size_t            bytes = 0;
+        size_t            done = 0;
+        int               count = 0;
+        int               ret = -1;
+
+        if (!priv->out_vector) {
+                priv->out_vector = GF_CALLOC (IOV_MAX, sizeof (struct iovec),
+                                              gf_sock_mt_iovec);
+                if (!priv->out_vector)
+                        return __socket_ioq_churn_entry (this, priv->ioq_next,
+                                                         0);
+        }
+
+        list_for_each_entry (entry, &priv->ioq, list) {
+                if (count + entry->pending_count > IOV_MAX)
+                        break;
+                memcpy (&priv->out_vector[count], entry->pending_vector,
+                        entry->pending_count * sizeof (struct iovec));
+                count += entry->pending_count;
+                zerocopy |= entry->zerocopy;
         }
 
+        /* a single entry larger than IOV_MAX is written in pieces */
+        if (!count)
+                return __socket_ioq_churn_entry (this, priv->ioq_next, 0);
+
+        ret = __socket_writev (this, priv->out_vector, count, &pending,
+                               &pending_count, &bytes, zerocopy);
+
+        list_for_each_entry_safe (entry, tmp, &priv->ioq, list) {
+                done = __socket_ioq_entry_advance (entry, bytes);
+                bytes -= done;
+                if (done && priv->zc_next != zc_next) {
+                        entry->zc_sent = _gf_true;
+                        entry->zc_id = priv->zc_next - 1;
+                }
+                if (entry->pending_count)
+                        break;
+                __socket_ioq_entry_done (this, entry);
+        }
+
+        if (ret == -1)
+                return -1;
+
+        /* more queued than fitted in one batch: not done yet */
+        if (ret == 0 && !list_empty (&priv->ioq))
+                return 0;
+
         return ret;
 }
 
@@ -1285,7 +1573,11 @@ __socket_ioq_churn (rpc_transport_t *this)
                 /* pick next entry */
                 entry = priv->ioq_next;
 
-                ret = __socket_ioq_churn_entry (this, entry, 0);
+                /* SSL writes one vector at a time, nothing to batch */
+                if (!priv->use_ssl && entry->list.next != &priv->ioq)
+                        ret = __socket_ioq_churn_batch (this);
+                else
+                        ret = __socket_ioq_churn_entry (this, entry, 0);
 
                 if (ret != 0)
                         break;
@@ -1318,6 +1610,7 @@ socket_event_poll_err (rpc_transport_t *this, int gen, int idx)
         {
                 if ((priv->gen == gen) && (priv->idx == idx)
                     && (priv->sock != -1)) {
+                        __socket_zerocopy_abort (this);
                         __socket_ioq_flush (this);
                         __socket_reset (this);
                         socket_closed = _gf_true;
@@ -2951,6 +3244,15 @@ socket_event_handler (int fd, int idx, int gen, void *data,
         {
                 priv->idx = idx;
                 priv->gen = gen;
+
+                /* zerocopy completions come in on the error queue and
+                 * raise EPOLLERR on a healthy socket, also after zerocopy
+                 * was reconfigured off while sends were in flight */
+                if (poll_err &&
+                    (priv->zc_enabled || priv->zc_next != priv->zc_done) &&
+                    __socket_zerocopy_reap (this) > 0 &&
+                    !__socket_connect_finish (priv->sock))
+                        poll_err = 0;
         }
         pthread_mutex_unlock (&priv->out_lock);
         pthread_mutex_unlock (&priv->in_lock);
@@ -3184,6 +3486,10 @@ socket_server_event_handler (int fd, int idx, int gen, void *data,
                 new_priv->connected = 1;
                 new_priv->is_server = _gf_true;
 
+                new_priv->zerocopy = priv->zerocopy;
+                new_priv->zc_threshold = priv->zc_threshold;
+                __socket_zerocopy_enable (new_trans, new_sockaddr.ss_family);
+
                 /* set O_NONBLOCK for plain text as well as ssl connections */
                 if (!priv->bio) {
                         gf_log (this->name, GF_LOG_TRACE,
@@ -3489,6 +3795,8 @@ socket_connect (rpc_transport_t *this, int port)
                         }
                 }
 
+                __socket_zerocopy_enable (this, sa_family);
+
                 if (priv->keepalive && sa_family != AF_UNIX) {
                         ret = __socket_keepalive (priv->sock,
                                                   sa_family,
@@ -4093,6 +4401,7 @@ reconfigure (rpc_transport_t *this, dict_t *options)
         int               keepaliveidle  = GF_KEEPALIVE_TIME;
         int               keepaliveintvl = GF_KEEPALIVE_INTERVAL;
         int               keepalivecnt   = GF_KEEPALIVE_COUNT;
+        uint64_t          threshold      = 0;
 
         GF_VALIDATE_OR_GOTO ("socket", this, out);
         GF_VALIDATE_OR_GOTO ("socket", this->private, out);
@@ -4152,6 +4461,43 @@ reconfigure (rpc_transport_t *this, dict_t *options)
         gf_log (this->name, GF_LOG_DEBUG, "Reconfigued "
                 "transport.socket.keepalive-count=%d", priv->keepalivecnt);
 
+        /* turning it on takes effect on the next (re)connect */
+        optstr = NULL;
+        if (dict_get_str (options, "transport.socket.zerocopy",
+                          &optstr) == 0) {
+                if (gf_string2boolean (optstr, &tmp_bool) == -1) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "'transport.socket.zerocopy' takes only "
+                                "boolean options, not taking any action");
+                        ret = -1;
+                        goto out;
+                }
+                priv->zerocopy = tmp_bool;
+        } else
+                priv->zerocopy = 0;
+
+        /* turning it off stops new zerocopy sends right away, zc_enabled
+         * goes once the pending ones have completed (see the reap) */
+        pthread_mutex_lock (&priv->out_lock);
+        {
+                if (!priv->zerocopy && priv->zc_next == priv->zc_done)
+                        priv->zc_enabled = _gf_false;
+        }
+        pthread_mutex_unlock (&priv->out_lock);
+
+        optstr = NULL;
+        if (dict_get_str (options, "transport.socket.zerocopy-threshold",
+                          &optstr) == 0) {
+                if (gf_string2bytesize_uint64 (optstr, &threshold) != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "invalid number format: %s", optstr);
+                        ret = -1;
+                        goto out;
+                }
+                priv->zc_threshold = threshold;
+        } else
+                priv->zc_threshold = GF_SOCKET_ZEROCOPY_THRESHOLD;
+
         optstr = NULL;
         if (dict_get_str (options, "tcp-window-size",
                           &optstr) == 0) {
@@ -4569,6 +4915,7 @@ socket_init (rpc_transport_t *this)
         int               keepaliveidle  = GF_KEEPALIVE_TIME;
         int               keepaliveintvl = GF_KEEPALIVE_INTERVAL;
         int               keepalivecnt   = GF_KEEPALIVE_COUNT;
+        uint64_t          threshold      = 0;
         uint32_t          backlog = 0;
 
 
@@ -4601,6 +4948,8 @@ socket_init (rpc_transport_t *this)
         priv->ssl_connected = _gf_false;
         priv->windowsize = GF_DEFAULT_SOCKET_WINDOW_SIZE;
         INIT_LIST_HEAD (&priv->ioq);
+        INIT_LIST_HEAD (&priv->zc_pending);
+        priv->zc_threshold = GF_SOCKET_ZEROCOPY_THRESHOLD;
         pthread_mutex_init (&priv->notify.lock, NULL);
         pthread_cond_init (&priv->notify.cond, NULL);
 
@@ -4708,6 +5057,29 @@ socket_init (rpc_transport_t *this)
         }
         priv->backlog = backlog;
 
+        optstr = NULL;
+        if (dict_get_str (this->options, "transport.socket.zerocopy",
+                          &optstr) == 0) {
+                if (gf_string2boolean (optstr, &tmp_bool) == -1) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "'transport.socket.zerocopy' takes only "
+                                "boolean options, not taking any action");
+                        tmp_bool = 0;
+                }
+                priv->zerocopy = tmp_bool;
+        }
+
+        optstr = NULL;
+        if (dict_get_str (this->options, "transport.socket.zerocopy-threshold",
+                          &optstr) == 0) {
+                if (gf_string2bytesize_uint64 (optstr, &threshold) != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "invalid number format: %s", optstr);
+                        threshold = GF_SOCKET_ZEROCOPY_THRESHOLD;
+                }
+                priv->zc_threshold = threshold;
+        }
+
         optstr = NULL;
 
          /* Check if socket read failures are to be logged */
@@ -4757,6 +5129,7 @@ fini (rpc_transport_t *this)
                         pthread_mutex_lock (&priv->in_lock);
                         pthread_mutex_lock (&priv->out_lock);
                         {
+                                __socket_zerocopy_abort (this);
                                 __socket_ioq_flush (this);
                                 __socket_reset (this);
                         }
@@ -4766,6 +5139,8 @@ fini (rpc_transport_t *this)
                 gf_log (this->name, GF_LOG_TRACE,
                         "transport %p destroyed", this);
 
+                GF_FREE (priv->out_vector);
+
                 pthread_mutex_destroy (&priv->in_lock);
                 pthread_mutex_destroy (&priv->out_lock);
                 pthread_mutex_destroy (&priv->cond_lock);
@@ -4882,6 +5257,23 @@ struct volume_options options[] = {
         { .key   = {"transport.socket.read-fail-log"},
           .type  = GF_OPTION_TYPE_BOOL
         },
+        { .key   = {"transport.socket.zerocopy"},
+          .type  = GF_OPTION_TYPE_BOOL,
+          .op_version  = {GD_OP_VERSION_4_2_0},
+          .default_value = "off",
+          .description = "Send large replies and writes with MSG_ZEROCOPY, "
+                         "so the kernel transmits them straight from the "
+                         "io-buffers. Only for TCP without SSL, the "
+                         "buffers stay pinned until the kernel is done."
+        },
+        { .key   = {"transport.socket.zerocopy-threshold"},
+          .type  = GF_OPTION_TYPE_SIZET,
+          .op_version  = {GD_OP_VERSION_4_2_0},
+          .min   = 4 * GF_UNIT_KB,
+          .default_value = "64KB",
+          .description = "Payloads smaller than this are copied as usual, "
+                         "page pinning costs more than copying them."
+        },
         { .key   = {SSL_ENABLED_OPT},
           .type  = GF_OPTION_TYPE_BOOL
         },
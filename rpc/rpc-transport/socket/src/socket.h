@@ -54,6 +54,12 @@
 #define GF_KEEPALIVE_INTERVAL           (2)
 #define GF_KEEPALIVE_COUNT              (9)
 
+/* MSG_ZEROCOPY needs linux 4.14 and headers that know about it */
+#if defined(GF_LINUX_HOST_OS) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define GF_SOCKET_ZEROCOPY              1
+#endif
+#define GF_SOCKET_ZEROCOPY_THRESHOLD    (64 * GF_UNIT_KB)
+
 typedef enum {
         SP_STATE_NADA = 0,
         SP_STATE_COMPLETE,
@@ -114,6 +120,9 @@ struct ioq {
         struct iovec      *pending_vector;
         int                pending_count;
         struct iobref     *iobref;
+        gf_boolean_t       zerocopy;   /* payload worth a MSG_ZEROCOPY send */
+        gf_boolean_t       zc_sent;    /* some of it went out that way */
+        uint32_t           zc_id;      /* last zerocopy send it was part of */
 };
 
 typedef struct {
@@ -219,6 +228,16 @@ typedef struct {
                         struct ioq        *ioq_prev;
                 };
         };
+        struct iovec          *out_vector;  /* IOV_MAX, to coalesce the ioq */
+        /* MSG_ZEROCOPY: the kernel reports completed sends by id on the
+         * error queue, written entries wait on zc_pending until then */
+        gf_boolean_t           zerocopy;
+        gf_boolean_t           zc_enabled;
+        size_t                 zc_threshold;
+        uint32_t               zc_next;     /* id of the next zerocopy send */
+        uint32_t               zc_done;     /* ids below this have completed */
+        uint64_t               zc_copied;
+        struct list_head       zc_pending;
         struct gf_sock_incoming incoming;
         pthread_mutex_t        in_lock;
         pthread_mutex_t        out_lock;
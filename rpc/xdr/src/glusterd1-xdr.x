@@ -49,6 +49,14 @@ struct gd1_mgmt_friend_rsp {
         int     port;
 }  ;
 
+struct gd1_mgmt_friend_summary_rsp {
+        unsigned char  uuid[16];
+        string  hostname<>;
+        int     op_ret;
+        int     op_errno;
+        opaque  vols<>;
+}  ;
+
 struct gd1_mgmt_unfriend_req {
         unsigned char  uuid[16];
         string  hostname<>;
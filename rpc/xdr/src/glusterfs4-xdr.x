@@ -624,6 +624,18 @@ struct gfx_seek_rsp {
         u_quad_t  offset;
 };
 
+struct gfx_copy_file_range_req {
+        opaque       gfid1[16];
+        opaque       gfid2[16];
+        hyper        fd_in;
+        hyper        fd_out;
+        u_quad_t     off_in;
+        u_quad_t     off_out;
+        u_quad_t     size;
+        unsigned int flag;
+        gfx_dict     xdata;
+};
+
 
  struct gfx_setvolume_req {
         gfx_dict dict;
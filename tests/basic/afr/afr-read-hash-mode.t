@@ -53,4 +53,17 @@ TEST [ $count -eq 2 ]
 arbiter_reads=$($CLI volume top $V0 read brick $H0:$B0/${V0}2|grep FILE|awk '{print $1}')
 TEST [ -z $arbiter_reads ]
 
+# read-hash-mode=4: reads go to the data bricks only, and the latency of the
+# replies is tracked per brick.
+TEST $CLI volume set $V0 cluster.read-hash-mode 4
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "4" mount_get_option_value $M0 $V0-replicate-0 read-hash-mode
+TEST $CLI volume top $V0 clear
+TEST $CLI volume profile $V0 info clear
+TEST dd if=$M0/FILE of=/dev/null bs=1M
+count=`reads_brick_count`
+TEST [ $count -ge 1 ]
+arbiter_reads=$($CLI volume top $V0 read brick $H0:$B0/${V0}2|grep FILE|awk '{print $1}')
+TEST [ -z $arbiter_reads ]
+EXPECT_NOT "0" mount_get_option_value $M0 $V0-replicate-0 "read_latency\[0\]"
+
 cleanup;
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+#Tests data self-heal with the "merkle" algorithm, which finds the blocks to
+#heal by comparing hash trees of the file, and the digests kept on the bricks
+#with storage.merkle-cache.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 data-self-heal-algorithm merkle
+TEST $CLI volume set $V0 storage.merkle-cache on
+TEST $CLI volume set $V0 cluster.data-self-heal off
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=20
+TEST dd if=/dev/urandom of=$M0/small bs=64k count=1
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+#Change a few blocks in different subtrees and grow the file
+TEST dd if=/dev/urandom of=$M0/file bs=4k count=1 seek=1280 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/file bs=4k count=2 seek=4352 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=1 seek=20 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/small bs=4k count=1 seek=3 conv=notrunc
+file_md5sum=$(md5sum $M0/file | awk '{print $1}')
+small_md5sum=$(md5sum $M0/small | awk '{print $1}')
+
+#Let the mtimes settle so that the bricks keep the digests they compute
+sleep 3
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+
+EXPECT $file_md5sum echo $(md5sum $B0/${V0}0/file | awk '{print $1}')
+EXPECT $file_md5sum echo $(md5sum $B0/${V0}1/file | awk '{print $1}')
+EXPECT $small_md5sum echo $(md5sum $B0/${V0}0/small | awk '{print $1}')
+EXPECT $small_md5sum echo $(md5sum $B0/${V0}1/small | awk '{print $1}')
+
+#The source kept the digests of the file, removing it removes them
+gfid=$(gf_gfid_xattr_to_str $(gf_get_gfid_xattr $B0/${V0}1/file))
+TEST [ -f $B0/${V0}1/.glusterfs/merkle/$gfid ]
+TEST rm -f $M0/file
+TEST ! [ -e $B0/${V0}1/.glusterfs/merkle/$gfid ]
+
+TEST $CLI volume set $V0 data-self-heal-algorithm diff
+TEST umount $M0
+cleanup;
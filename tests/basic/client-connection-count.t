@@ -0,0 +1,55 @@
+#!/bin/bash
+#Test reads and writes over several connections per brick, and that the
+#data connections are bound again after the brick restarts.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function data_conns_ready {
+        local fpath=$(generate_mount_statedump $V0)
+        grep -c "^data_conn\.[0-9]*\.state=3" $fpath
+        cleanup_mount_statedump $V0
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 client.connection-count 4
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" data_conns_ready
+
+TEST dd if=/dev/urandom of=$B0/src bs=1M count=8
+md5=$(md5sum $B0/src | awk '{print $1}')
+
+for i in {1..4}; do
+        dd if=$B0/src of=$M0/file$i bs=128k 2>/dev/null &
+done
+wait
+for i in {1..4}; do
+        EXPECT "$md5" echo $(md5sum $M0/file$i | awk '{print $1}')
+        EXPECT "$md5" echo $(md5sum $B0/${V0}0/file$i | awk '{print $1}')
+done
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $PROCESS_DOWN_TIMEOUT "0" data_conns_ready
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" data_conns_ready
+
+TEST dd if=$B0/src of=$M0/file5 bs=128k
+EXPECT "$md5" echo $(md5sum $M0/file5 | awk '{print $1}')
+
+TEST rm -f $B0/src
+TEST force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
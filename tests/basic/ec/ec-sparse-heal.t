@@ -0,0 +1,90 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+#This test checks that data self-heal keeps the holes of sparse files, that
+#parallel heal windows heal the right data and that with heal-dirty-ranges a
+#degraded write to a big file only heals the regions it touched.
+
+function kb_on_brick {
+        du -k $B0/${V0}$1/$2 | cut -f1
+}
+
+function dirty_ranges {
+        getfattr -n trusted.ec.dirty-ranges -e hex --absolute-names \
+                 $B0/${V0}$1/$2 2>/dev/null | grep dirty-ranges | cut -f2 -d'='
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 disperse.self-heal-parallel-windows 4
+TEST $CLI volume set $V0 disperse.heal-dirty-ranges on
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+############ Sparse file created while brick0 is down ###########
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=1
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=1 seek=300 conv=notrunc
+TEST truncate -s 1G $M0/sparse
+md5=$(md5sum $M0/sparse | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+#the holes are not written to the healed brick
+TEST [ $(kb_on_brick 0 sparse) -lt 4096 ]
+EXPECT "$(stat -c %s $B0/${V0}1/sparse)" stat -c %s $B0/${V0}0/sparse
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+EXPECT "$md5" echo $(md5sum $M0/sparse | awk '{print $1}')
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+############ Degraded writes to a dense file ###########
+TEST dd if=/dev/urandom of=$M0/dense bs=1M count=256
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+TEST dd if=/dev/urandom of=$M0/dense bs=7000 count=1 seek=6000 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/dense bs=1M count=1 seek=200 conv=notrunc
+md5=$(md5sum $M0/dense | awk '{print $1}')
+
+#the writes are recorded in the dirty ranges of the good bricks only
+EXPECT "^0x" dirty_ranges 1 dense
+EXPECT "^$" dirty_ranges 0 dense
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+EXPECT "$md5" echo $(md5sum $M0/dense | awk '{print $1}')
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+TEST kill_brick $V0 $H0 $B0/${V0}2
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+EXPECT "$md5" echo $(md5sum $M0/dense | awk '{print $1}')
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+#the dirty ranges of all the bricks match after the heal
+EXPECT "$(dirty_ranges 1 dense)" dirty_ranges 0 dense
+EXPECT "$(dirty_ranges 1 dense)" dirty_ranges 2 dense
+
+cleanup
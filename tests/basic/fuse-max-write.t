@@ -0,0 +1,47 @@
+#!/bin/bash
+#Test fuse mounts with large READ/WRITE requests and spliced READ replies.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function fuse_priv_value {
+        local fpath=$(generate_mount_statedump $V0)
+        grep "^$1=" $fpath | cut -f2 -d'='
+        cleanup_mount_statedump $V0
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume start $V0
+
+TEST dd if=/dev/urandom of=$B0/src bs=1M count=8
+md5=$(md5sum $B0/src | awk '{print $1}')
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --max-write=1MB \
+          --splice-read=on $M0
+
+#kernels without FUSE_MAX_PAGES stay at 128KB
+EXPECT "^(1048576|131072)$" fuse_priv_value max_write
+EXPECT "1" fuse_priv_value splice_read
+
+TEST dd if=$B0/src of=$M0/file bs=1M
+TEST dd if=$B0/src of=$M0/file-direct bs=1M oflag=direct
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+EXPECT "$md5" echo $(dd if=$M0/file-direct bs=1M iflag=direct 2>/dev/null |
+                     md5sum | awk '{print $1}')
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --max-write=64KB $M0
+EXPECT "65536" fuse_priv_value max_write
+EXPECT "0" fuse_priv_value splice_read
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+TEST ! $GFS --volfile-id=$V0 --volfile-server=$H0 --max-write=2MB $M0
+
+TEST rm -f $B0/src
+cleanup;
@@ -0,0 +1,202 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <glusterfs/api/glfs.h>
+#include <glusterfs/api/glfs-handles.h>
+
+/* Writes 'size' bytes to 'src', copies them to 'dst' with
+ * glfs_copy_file_range () and reads 'dst' back. When the volume refuses the
+ * copy with EXDEV or EOPNOTSUPP it falls back to reading and writing the
+ * data, like a caller is expected to.
+ *
+ * Prints "copied" when the copy was done by glfs_copy_file_range (),
+ * "fallback <errno name>" when it fell back, and "BAD" when the data of 'dst'
+ * doesn't match.
+ */
+
+#define VALIDATE_AND_GOTO_LABEL_ON_ERROR(func, ret, label) do { \
+        if (ret < 0) {            \
+                fprintf (stderr, "%s : returned error %d (%s)\n", \
+                         func, ret, strerror (errno)); \
+                goto label; \
+        } \
+        } while (0)
+
+#define BUF_SIZE        (128 * 1024)
+
+static void
+fill (char *buf, size_t len, off_t off)
+{
+        size_t i = 0;
+
+        for (i = 0; i < len; i++)
+                buf[i] = (char) ((off + i) * 7 + (off + i) / 4093);
+}
+
+static int
+fallback (glfs_fd_t *in, off_t off_in, glfs_fd_t *out, off_t off_out,
+          size_t len)
+{
+        char   *buf = NULL;
+        ssize_t ret = 0;
+
+        buf = malloc (BUF_SIZE);
+        if (!buf)
+                return -1;
+
+        while (len > 0) {
+                ret = glfs_pread (in, buf, len < BUF_SIZE ? len : BUF_SIZE,
+                                  off_in, 0, NULL);
+                if (ret <= 0)
+                        break;
+                ret = glfs_pwrite (out, buf, ret, off_out, 0, NULL, NULL);
+                if (ret <= 0)
+                        break;
+                off_in += ret;
+                off_out += ret;
+                len -= ret;
+        }
+
+        free (buf);
+
+        return len ? -1 : 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+        int             ret = -1;
+        glfs_t         *fs = NULL;
+        glfs_fd_t      *fd_in = NULL;
+        glfs_fd_t      *fd_out = NULL;
+        char           *volname = NULL;
+        char           *logfile = NULL;
+        char           *src = NULL;
+        char           *dst = NULL;
+        char           *buf = NULL;
+        char           *ref = NULL;
+        size_t          size = 0;
+        size_t          len = 0;
+        off_t           off = 0;
+        off_t           off_in = 0;
+        off_t           off_out = 0;
+        ssize_t         copied = 0;
+        int             err = 0;
+
+        if (argc != 6) {
+                fprintf (stderr, "Usage: %s <volname> <logfile> <src> <dst> "
+                         "<size>\n", argv[0]);
+                return 1;
+        }
+
+        volname = argv[1];
+        logfile = argv[2];
+        src = argv[3];
+        dst = argv[4];
+        size = strtoull (argv[5], NULL, 0);
+
+        buf = malloc (BUF_SIZE);
+        ref = malloc (BUF_SIZE);
+        if (!buf || !ref)
+                goto out;
+
+        fs = glfs_new (volname);
+        if (!fs)
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_new", ret, out);
+
+        ret = glfs_set_volfile_server (fs, "tcp", "localhost", 24007);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_set_volfile_server", ret, out);
+
+        ret = glfs_set_logging (fs, logfile, 7);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_set_logging", ret, out);
+
+        ret = glfs_init (fs);
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_init", ret, out);
+
+        fd_in = glfs_creat (fs, src, O_RDWR | O_TRUNC, 0644);
+        if (fd_in == NULL) {
+                ret = -1;
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_creat", ret, out);
+        }
+
+        for (off = 0; off < size; off += len) {
+                len = size - off < BUF_SIZE ? size - off : BUF_SIZE;
+                fill (buf, len, off);
+                ret = glfs_pwrite (fd_in, buf, len, off, 0, NULL, NULL);
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_pwrite", ret, out);
+        }
+
+        /* closing the source flushes the delayed changelog of replicate,
+         * whose lock would make the copy fall back */
+        ret = glfs_close (fd_in);
+        fd_in = NULL;
+        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_close", ret, out);
+
+        fd_in = glfs_open (fs, src, O_RDONLY);
+        if (fd_in == NULL) {
+                ret = -1;
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_open", ret, out);
+        }
+
+        fd_out = glfs_creat (fs, dst, O_RDWR | O_TRUNC, 0644);
+        if (fd_out == NULL) {
+                ret = -1;
+                VALIDATE_AND_GOTO_LABEL_ON_ERROR ("glfs_creat", ret, out);
+        }
+
+        while (off_in < size) {
+                copied = glfs_copy_file_range (fd_in, &off_in, fd_out,
+                                               &off_out, size - off_in, 0,
+                                               NULL, NULL, NULL);
+                if (copied < 0) {
+                        err = errno;
+                        if ((err != EXDEV) && (err != EOPNOTSUPP)) {
+                                ret = -1;
+                                VALIDATE_AND_GOTO_LABEL_ON_ERROR
+                                        ("glfs_copy_file_range", ret, out);
+                        }
+                        ret = fallback (fd_in, off_in, fd_out, off_out,
+                                        size - off_in);
+                        VALIDATE_AND_GOTO_LABEL_ON_ERROR ("fallback", ret,
+                                                          out);
+                        break;
+                }
+                if (copied == 0) {
+                        ret = -1;
+                        fprintf (stderr, "glfs_copy_file_range : copied "
+                                 "nothing at %jd\n", (intmax_t) off_in);
+                        goto out;
+                }
+        }
+
+        for (off = 0; off < size; off += len) {
+                len = size - off < BUF_SIZE ? size - off : BUF_SIZE;
+                fill (ref, len, off);
+                ret = glfs_pread (fd_out, buf, len, off, 0, NULL);
+                if (ret != (int) len || memcmp (buf, ref, len)) {
+                        printf ("BAD\n");
+                        ret = -1;
+                        goto out;
+                }
+        }
+
+        if (err)
+                printf ("fallback %s\n", err == EXDEV ? "EXDEV" : "EOPNOTSUPP");
+        else
+                printf ("copied\n");
+        ret = 0;
+
+out:
+        if (fd_in != NULL)
+                glfs_close (fd_in);
+        if (fd_out != NULL)
+                glfs_close (fd_out);
+        if (fs)
+                (void) glfs_fini (fs);
+        free (buf);
+        free (ref);
+
+        return ret;
+}
@@ -0,0 +1,85 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+#This test checks that glfs_copy_file_range () copies the data on the bricks
+#of replicate volumes, and that disperse volumes, files on different dht
+#subvolumes and arbiter volumes refuse it with EXDEV, after which the
+#fallback to read and write copies the right data.
+
+function md5_on_brick {
+        md5sum $1 | awk '{print $1}'
+}
+
+#prints the names of the files among f0..f19 that live on brick $1 of $V0
+function files_on_brick {
+        local i
+        for i in {0..19}; do
+                if [ -f $B0/${V0}$1/f$i ]; then
+                        echo f$i
+                fi
+        done
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+logdir=`gluster --print-logdir`
+TEST build_tester $(dirname $0)/gfapi-copy-file-range.c -lgfapi
+tester=./$(dirname $0)/gfapi-copy-file-range
+size=$((9 * 1024 * 1024 + 4321))
+
+############ Replicate: the bricks copy ###########
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0..2}
+TEST $CLI volume start $V0
+EXPECT "^copied$" $tester $V0 $logdir/gfapi-copy-file-range.log src dst $size
+for i in {0..2}; do
+        EXPECT "$(md5_on_brick $B0/${V0}$i/src)" md5_on_brick $B0/${V0}$i/dst
+done
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+TEST rm -rf $B0/${V0}*
+
+############ Disperse: EXDEV and fallback ###########
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume start $V0
+EXPECT "^fallback EXDEV$" $tester $V0 $logdir/gfapi-copy-file-range.log \
+                          src dst $size
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+TEST rm -rf $B0/${V0}*
+
+############ Distribute: same subvolume copies, different ones EXDEV ###########
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..1}
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST touch $M0/f{0..19}
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+f0=$(files_on_brick 0 | head -1)
+f0b=$(files_on_brick 0 | tail -1)
+f1=$(files_on_brick 1 | head -1)
+TEST [ -n "$f0" -a -n "$f1" -a "$f0" != "$f0b" ]
+EXPECT "^copied$" $tester $V0 $logdir/gfapi-copy-file-range.log \
+                  $f0 $f0b $size
+EXPECT "^fallback EXDEV$" $tester $V0 $logdir/gfapi-copy-file-range.log \
+                          $f0 $f1 $size
+EXPECT "^fallback EXDEV$" $tester $V0 $logdir/gfapi-copy-file-range.log \
+                          $f1 $f0 $size
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+TEST rm -rf $B0/${V0}*
+
+############ Arbiter: EXDEV and fallback ###########
+TEST $CLI volume create $V0 replica 3 arbiter 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume start $V0
+EXPECT "^fallback EXDEV$" $tester $V0 $logdir/gfapi-copy-file-range.log \
+                          src dst $size
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup_tester $tester
+
+cleanup;
@@ -0,0 +1,67 @@
+#!/bin/bash
+#Tests the 2Q policy of io-cache: a scan of a file larger than the cache must
+#not push out the pages of a file read again, and data read through the
+#cache must stay correct when switching between policies.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function ioc_priv_value {
+        local fpath=$(generate_mount_statedump $V0)
+        grep -a "^$1=" $fpath | head -1 | cut -f2 -d'='
+        cleanup_mount_statedump $V0
+}
+
+function read_file {
+        drop_cache $M0
+        md5sum $M0/$1 | awk '{print $1}'
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.io-cache on
+TEST $CLI volume set $V0 performance.cache-size 8MB
+TEST $CLI volume set $V0 performance.cache-refresh-timeout 60
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume set $V0 performance.io-cache-policy 2q
+TEST ! $CLI volume set $V0 performance.io-cache-policy arc
+TEST $CLI volume start $V0
+
+TEST dd if=/dev/urandom of=$B0/${V0}0/hot bs=1M count=2
+TEST dd if=/dev/urandom of=$B0/${V0}0/scan bs=1M count=12
+hot_md5=$(md5sum $B0/${V0}0/hot | awk '{print $1}')
+scan_md5=$(md5sum $B0/${V0}0/scan | awk '{print $1}')
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+EXPECT "2q" ioc_priv_value cache_policy
+
+#The hot pages are pushed out of the first-access queue by the scan, and
+#taken back into the main queue when they are read again
+EXPECT "$hot_md5" read_file hot
+EXPECT "$scan_md5" read_file scan
+EXPECT "$hot_md5" read_file hot
+EXPECT "^[1-9][0-9]*$" ioc_priv_value ghost_hits
+EXPECT "^[1-9][0-9]*$" ioc_priv_value am_pages
+
+#Scans now go through the first-access queue only
+EXPECT "$scan_md5" read_file scan
+EXPECT "$hot_md5" read_file hot
+EXPECT "^[1-9][0-9]*$" ioc_priv_value hits
+
+TEST $CLI volume set $V0 performance.io-cache-policy lru
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "lru" ioc_priv_value cache_policy
+EXPECT "$scan_md5" read_file scan
+EXPECT "$hot_md5" read_file hot
+TEST $CLI volume set $V0 performance.io-cache-policy 2q
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "2q" ioc_priv_value cache_policy
+EXPECT "$scan_md5" read_file scan
+EXPECT "$hot_md5" read_file hot
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,50 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function iot_dump_value {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -A20 "performance/io-threads.$V0-io-threads" $fpath | \
+                grep "^$1=" | cut -f2 -d'='
+        rm -f $fpath
+}
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.iot-work-stealing on
+TEST $CLI volume set $V0 performance.io-thread-count 4
+TEST $CLI volume set $V0 diagnostics.stats-dump-interval 1
+TEST $CLI volume start $V0
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+EXPECT "1" iot_dump_value work_stealing
+
+# more parallel requests than threads, of every priority
+TEST mkdir $M0/dir
+for i in {1..8}; do
+        (dd if=/dev/urandom of=$M0/dir/file$i bs=64k count=64 2>/dev/null;
+         for j in {1..20}; do stat $M0/dir/file$i; done >/dev/null) &
+done
+wait
+for i in {1..8}; do
+        EXPECT "4194304" stat -c %s $M0/dir/file$i
+        TEST cmp $M0/dir/file$i $B0/${V0}0/dir/file$i
+done
+TEST [ $(ls $M0/dir | wc -l) -eq 8 ]
+
+# io-stats reads the queue sizes from io-threads, summed over the
+# per-thread queues
+sleep 2
+dump=${GLUSTERD_WORKDIR}/stats/glusterfsd__d_backends_${V0}0.dump
+TEST grep -q '\.HIGH\.queue_size": "[0-9]' $dump
+TEST grep -q '\.LEAST\.queue_size": "[0-9]' $dump
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+
+cleanup;
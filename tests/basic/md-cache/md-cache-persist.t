@@ -0,0 +1,63 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function persist_hits {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -A10 "md-cache.$V0-md-cache" $fpath | \
+                grep persist_hit_count | cut -f2 -d'='
+        rm -f $fpath
+}
+
+# the file of the mount on $1
+function persist_file {
+        echo $B0/mdc-persist.$(echo ${1#/} | tr / -)
+}
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}1
+TEST $CLI volume set $V0 performance.stat-prefetch on
+TEST $CLI volume set $V0 performance.cache-invalidation on
+TEST $CLI volume set $V0 features.cache-invalidation on
+TEST $CLI volume set $V0 performance.md-cache-timeout 600
+TEST $CLI volume set $V0 performance.xattr-cache-list "user.*"
+TEST $CLI volume set $V0 performance.md-cache-persist-file $B0/mdc-persist
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST mkdir $M0/dir
+for i in {1..10}; do
+        TEST touch $M0/dir/file$i
+        TEST setfattr -n user.tag -v value$i $M0/dir/file$i
+done
+
+# only entries whose ctime is a few seconds old are kept
+sleep 3
+TEST ls -l $M0/dir
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST [ -s $(persist_file $M0) ]
+
+# a restarted client gets the xattrs back from the file
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST stat $M0/dir/file1 $M0/dir/file2 $M0/dir/file3
+EXPECT "value1" getfattr --only-values -n user.tag $M0/dir/file1
+TEST [ $(persist_hits) -ge 3 ]
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+# a file changed since it was persisted is not taken from the file, and
+# a second mount on the same host keeps a file of its own
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M1
+TEST setfattr -n user.tag -v changed $M1/dir/file4
+EXPECT "changed" getfattr --only-values -n user.tag $M0/dir/file4
+EXPECT "value5" getfattr --only-values -n user.tag $M0/dir/file5
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST [ -s $(persist_file $M1) ]
+
+cleanup;
@@ -0,0 +1,73 @@
+#!/bin/bash
+#Tests the hashed and Bloom-filtered entry index of nl-cache: a directory
+#that collects many negative entries (deliveries to a mail spool) still
+#answers lookups correctly, names ruled out by the Bloom filter are counted,
+#and the index is accounted in the cache size.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function nlc_value {
+        local fpath=$(generate_mount_statedump $V0 $1)
+        grep -a "^$2" $fpath | cut -f2- -d'=' | sort -n | tail -1
+        cleanup_statedump $(get_mount_process_pid $V0 $1)
+}
+
+function nlc_ne_entries {
+        nlc_value $M0 "ne-index=" | cut -f2 -d'=' | cut -f1 -d',' |
+        sort -n | tail -1
+}
+
+function deliver {
+        local i
+        for i in $(seq 1 $2); do
+                touch $M0/spool/tmp/$1.$i || return 1
+                ln $M0/spool/tmp/$1.$i $M0/spool/new/$1.$i || return 1
+                rm -f $M0/spool/tmp/$1.$i || return 1
+        done
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 group nl-cache
+TEST $CLI volume set $V0 nl-cache-positive-entry on
+TEST $CLI volume set $V0 nl-cache-limit 16MB
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M1
+
+TEST mkdir -p $M0/spool/tmp $M0/spool/new
+TEST deliver msg 512
+
+#every name delivered is a negative entry of tmp, and served from there
+EXPECT "^512$" nlc_ne_entries
+TEST ! stat $M0/spool/tmp/msg.100
+TEST ! stat $M0/spool/tmp/absent
+EXPECT "^[1-9][0-9]*$" nlc_value $M0 negative_lookup_hit_count
+EXPECT "^[1-9][0-9]*$" nlc_value $M0 bloom_filter_hit_count
+TEST stat $M0/spool/new/msg.100
+TEST stat $M0/spool/new/msg.512
+
+#names cached as absent can be created again, here and on another client
+TEST touch $M0/spool/tmp/msg.100
+TEST stat $M0/spool/tmp/msg.100
+TEST touch $M1/spool/tmp/msg.200
+EXPECT_WITHIN $MDC_TIMEOUT "Y" path_exists $M0/spool/tmp/msg.200
+TEST rm -f $M0/spool/tmp/msg.100 $M0/spool/tmp/msg.200
+TEST ! stat $M0/spool/tmp/msg.100
+
+#the index is part of the cache that nl-cache-limit bounds
+TEST $CLI volume set $V0 nl-cache-limit 16KB
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "^16384$" nlc_value $M0 cache_limit
+TEST deliver more 512
+TEST [ $(nlc_value $M0 consumed_cache_size) -lt 32768 ]
+TEST [ $(nlc_ne_entries) -lt 512 ]
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+cleanup;
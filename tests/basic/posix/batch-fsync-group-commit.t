@@ -0,0 +1,49 @@
+#!/bin/bash
+#Test that fsyncs batched by the group-commit batch-fsync-mode complete with
+#the data on disk, and that the batches show up in the brick statedump.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{1,2};
+TEST $CLI volume set $V0 storage.batch-fsync-mode group-commit
+TEST $CLI volume set $V0 storage.batch-fsync-delay-usec 2000
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 --volfile-id $V0 $M0;
+
+TEST dd if=/dev/urandom of=$B0/src bs=1M count=4
+md5=$(md5sum $B0/src | awk '{print $1}')
+
+# parallel writers with an fsync after every block
+for i in {1..8}; do
+        dd if=$B0/src of=$M0/f$i bs=64k oflag=sync 2>/dev/null &
+done
+wait
+
+for i in {1..8}; do
+        EXPECT "$md5" echo $(md5sum $B0/${V0}1/f$i | awk '{print $1}')
+        EXPECT "$md5" echo $(md5sum $B0/${V0}2/f$i | awk '{print $1}')
+done
+
+statedump=$(generate_brick_statedump $V0 $H0 $B0/${V0}1)
+EXPECT_NOT "^0$" echo $(grep "^fsync_batches=" $statedump | cut -f2 -d'=')
+EXPECT "1" echo $(grep -c "^fsync_batch_size=" $statedump)
+
+# back to the per-transaction batching while mounted
+TEST $CLI volume set $V0 storage.batch-fsync-mode reverse-fsync
+TEST dd if=$B0/src of=$M0/g bs=128k conv=fsync
+EXPECT "$md5" echo $(md5sum $B0/${V0}1/g | awk '{print $1}')
+
+TEST rm -f $B0/src $statedump
+TEST force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
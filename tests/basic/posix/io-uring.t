@@ -0,0 +1,47 @@
+#!/bin/bash
+#Test data integrity of readv/writev/fsync/fallocate/discard through the
+#posix io_uring backend, and toggling it at run-time.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{1,2};
+TEST $CLI volume set $V0 storage.io-uring on
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume start $V0
+
+TEST glusterfs --entry-timeout=0 --attribute-timeout=0 -s $H0 --volfile-id $V0 $M0;
+
+TEST dd if=/dev/urandom of=$B0/src bs=1M count=8
+md5=$(md5sum $B0/src | awk '{print $1}')
+
+TEST dd if=$B0/src of=$M0/a bs=128k conv=fsync
+EXPECT "$md5" echo $(md5sum $M0/a | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $B0/${V0}1/a | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $B0/${V0}2/a | awk '{print $1}')
+
+TEST fallocate -l 16M $M0/b
+EXPECT "16777216" stat -c %s $B0/${V0}1/b
+TEST fallocate -p -o 0 -l 4M $M0/a
+EXPECT "8388608" stat -c %s $M0/a
+EXPECT "0" echo $(dd if=$M0/a bs=4M count=1 2>/dev/null | tr -d '\0' | wc -c)
+
+# switch back to synchronous IO while mounted
+TEST $CLI volume set $V0 storage.io-uring off
+TEST dd if=$B0/src of=$M0/c bs=128k conv=fsync
+EXPECT "$md5" echo $(md5sum $M0/c | awk '{print $1}')
+
+TEST rm -f $B0/src
+TEST force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,87 @@
+#!/bin/bash
+#Tests the adaptive read-ahead: sequential and strided reads on one fd are
+#found and read ahead of, and what is read is the data of the file, also
+#after it was written in the middle of a stream.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function ra_fd_value {
+        local fpath=$(generate_mount_statedump $V0)
+        grep -a "^$1" $fpath | head -1 | cut -f2- -d'='
+        cleanup_mount_statedump $V0
+}
+
+function ra_fd_count {
+        local fpath=$(generate_mount_statedump $V0)
+        grep -a "^$1" $fpath | cut -f2 -d'=' | awk '{s+=$1} END {print s+0}'
+        cleanup_mount_statedump $V0
+}
+
+#reads 64KB every 256KB on an open fd, from the brick with the same stride
+function strided_md5 {
+        local i
+        for i in $(seq 0 31); do
+                if [ "$1" == "fd" ]; then
+                        dd bs=64k count=1 skip=3 <&6 2>/dev/null
+                else
+                        dd if=$1 bs=64k count=1 skip=$((i * 4 + 3)) \
+                           2>/dev/null
+                fi
+        done | md5sum | awk '{print $1}'
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.read-ahead on
+TEST $CLI volume set $V0 performance.read-ahead-adaptive on
+TEST $CLI volume set $V0 performance.read-ahead-max-window 2MB
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --direct-io-mode=yes $M0
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=16
+EXPECT "1" ra_fd_value "adaptive=[01]$"
+
+#sequential, the pages read ahead are read by the next reads
+exec 5<$M0/file
+head_md5=$(dd if=$B0/${V0}0/file bs=64k count=32 2>/dev/null | md5sum |
+           awk '{print $1}')
+EXPECT "$head_md5" echo $(dd bs=64k count=32 <&5 2>/dev/null | md5sum |
+                          awk '{print $1}')
+EXPECT "^[1-9][0-9]*$" ra_fd_count prefetched-pages
+EXPECT "^[1-9][0-9]*$" ra_fd_count hit-pages
+EXPECT "sequential" echo $(ra_fd_value "stream\[" | grep -o sequential)
+
+#a write in the middle of the stream drops what was read ahead
+TEST dd if=/dev/urandom of=$M0/file bs=64k count=1 seek=40 conv=notrunc
+tail_md5=$(dd if=$B0/${V0}0/file bs=64k skip=32 2>/dev/null | md5sum |
+           awk '{print $1}')
+EXPECT "$tail_md5" echo $(dd bs=64k <&5 2>/dev/null | md5sum |
+                          awk '{print $1}')
+exec 5<&-
+
+#strided
+exec 6<$M0/file
+EXPECT "$(strided_md5 $B0/${V0}0/file)" strided_md5 fd
+EXPECT "stride=262144" echo $(ra_fd_value "stream\[" |
+                              grep -o "stride=[0-9]*")
+exec 6<&-
+
+#new fds go back to the fixed window
+TEST $CLI volume set $V0 performance.read-ahead-adaptive off
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" ra_fd_value "adaptive=[01]$"
+exec 5<$M0/file
+EXPECT "no" ra_fd_value "adaptive=[a-z]*$"
+EXPECT "$(md5sum $B0/${V0}0/file | awk '{print $1}')" \
+       echo $(dd bs=64k <&5 2>/dev/null | md5sum | awk '{print $1}')
+exec 5<&-
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,105 @@
+#!/bin/bash
+#Tests features.shard-size-write-back: the size of a sharded file that writes
+#grow is written to the bricks on fsync, close, truncate and at the timeout,
+#the writing client sees its own size meanwhile, and a client that dies loses
+#only the size growth since the last of those.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function size_on_brick {
+        local hex=$(getfattr -n trusted.glusterfs.shard.file-size -e hex \
+                    --absolute-names $B0/${V0}0/$1 2>/dev/null |
+                    grep file-size | cut -f2 -d'=' | cut -c3-18)
+        echo $((16#$hex))
+}
+
+function shard_value {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $fpath | cut -f2 -d'=' | tail -1
+        cleanup_statedump $(get_mount_process_pid $V0 $M0)
+}
+
+#appends $2 MB to $1, fsyncs if $3 is "fsync", appends $4 MB more, optionally
+#truncates to $5 MB, then touches $1.ready and keeps the file open
+function writer {
+        $PYTHON -c "
+import os, sys, time
+fd = os.open('$1', os.O_WRONLY | os.O_CREAT | os.O_APPEND)
+os.write(fd, b'a' * ($2 << 20))
+if '$3' == 'fsync':
+    os.fsync(fd)
+os.write(fd, b'b' * ($4 << 20))
+trunc = ${5:-0}
+if trunc:
+    os.ftruncate(fd, trunc << 20)
+open('$1.ready', 'w').close()
+time.sleep(600)
+" >/dev/null 2>&1 &
+        echo $!
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 features.shard on
+TEST $CLI volume set $V0 features.shard-block-size 4MB
+TEST $CLI volume set $V0 features.shard-size-write-back on
+TEST $CLI volume set $V0 features.shard-size-write-back-timeout 600
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+#fsync makes the size durable, later writes are seen by the writer only
+pid=$(writer $M0/vm 6 fsync 4)
+EXPECT_WITHIN 60 "Y" path_exists $M0/vm.ready
+EXPECT "6291456" size_on_brick vm
+EXPECT "10485760" stat -c %s $M0/vm
+EXPECT "^[1-9][0-9]*$" shard_value size-updates-deferred
+TEST [ $(shard_value size-updates-flushed) -lt \
+       $(shard_value size-updates-deferred) ]
+
+#a client that dies loses the size growth since the fsync, not the data
+gfid=$(get_gfid_string $M0/vm)
+TEST kill -9 $(get_mount_process_pid $V0 $M0)
+TEST kill -9 $pid
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST [ -f $B0/${V0}0/.shard/$gfid.2 ]
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+EXPECT "6291456" stat -c %s $M0/vm
+EXPECT "6291456" echo $(cat $M0/vm | wc -c)
+EXPECT "0" echo $(tr -d 'a' < $M0/vm | wc -c)
+
+#the timeout writes the size back while the file stays open
+TEST $CLI volume set $V0 features.shard-size-write-back-timeout 2
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "2" shard_value size-write-back-timeout
+TEST rm -f $M0/vm.ready
+pid=$(writer $M0/vm 2 none 2)
+EXPECT_WITHIN 60 "Y" path_exists $M0/vm.ready
+EXPECT_WITHIN 20 "10485760" size_on_brick vm
+TEST kill -9 $pid
+
+#close and truncate write it back at once
+TEST $CLI volume set $V0 features.shard-size-write-back-timeout 600
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "600" shard_value size-write-back-timeout
+TEST dd if=/dev/zero of=$M0/vm bs=1M count=1 oflag=append conv=notrunc
+EXPECT "11534336" size_on_brick vm
+TEST rm -f $M0/vm.ready
+pid=$(writer $M0/vm 1 none 1 5)
+EXPECT_WITHIN 60 "Y" path_exists $M0/vm.ready
+EXPECT "5242880" size_on_brick vm
+EXPECT "5242880" stat -c %s $M0/vm
+TEST kill -9 $pid
+
+#another client sees what was closed
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M1
+EXPECT "5242880" stat -c %s $M1/vm
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+cleanup;
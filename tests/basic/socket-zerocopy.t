@@ -0,0 +1,83 @@
+#!/bin/bash
+#Test that data written and read with MSG_ZEROCOPY enabled on the clients and
+#the bricks, and with enough writes in flight to make the sockets coalesce
+#queued replies, comes back intact, also when a brick restarts while writes
+#are in flight.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function md5_of {
+        md5sum $1 | awk '{print $1}'
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 client.zerocopy on
+TEST $CLI volume set $V0 server.zerocopy on
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 1
+
+TEST dd if=/dev/urandom of=$B0/src bs=1M count=64
+md5=$(md5_of $B0/src)
+
+############ Parallel large writes and reads ###########
+#the payloads are above the 64KB zerocopy threshold, and the parallel
+#streams fill the socket buffers so that queued entries get coalesced
+for i in {1..4}; do
+        dd if=$B0/src of=$M0/file$i bs=1M oflag=direct 2>/dev/null &
+done
+wait
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 1
+for i in {1..4}; do
+        EXPECT "$md5" md5_of $M0/file$i
+        EXPECT "$md5" md5_of $B0/${V0}0/file$i
+        EXPECT "$md5" md5_of $B0/${V0}1/file$i
+done
+
+############ Brick restart with writes in flight ###########
+TEST dd if=/dev/urandom of=$B0/big bs=1M count=256
+md5big=$(md5_of $B0/big)
+dd if=$B0/big of=$M0/restart bs=1M oflag=direct 2>/dev/null &
+dd_pid=$!
+TEST kill_brick $V0 $H0 $B0/${V0}1
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 1
+TEST wait $dd_pid
+
+TEST $CLI volume heal $V0 enable
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+EXPECT "$md5big" md5_of $M0/restart
+EXPECT "$md5big" md5_of $B0/${V0}0/restart
+EXPECT "$md5big" md5_of $B0/${V0}1/restart
+
+#the data of every file still reads back over the new connections
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 1
+for i in {1..4}; do
+        EXPECT "$md5" md5_of $M0/file$i
+done
+EXPECT "$md5big" md5_of $M0/restart
+
+TEST rm -f $B0/src $B0/big
+cleanup;
@@ -0,0 +1,52 @@
+#!/bin/bash
+
+## Sign with xxh64 and several signer threads, then scrub objects of
+## more than one read block.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function get_signature_type {
+        getfattr -n trusted.bit-rot.signature -e hex $1 2>/dev/null | \
+                grep "^trusted.bit-rot.signature=" | cut -d= -f2 | cut -c1-4
+}
+
+cleanup;
+
+TEST glusterd;
+TEST pidof glusterd;
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}1
+TEST $CLI volume start $V0
+
+TEST $CLI volume bitrot $V0 enable
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" get_bitd_count
+
+TEST $CLI volume set $V0 features.expiry-time 1
+TEST $CLI volume set $V0 features.signer-threads 8
+TEST $CLI volume set $V0 features.signature-type xxh64
+TEST ! $CLI volume set $V0 features.signature-type md5
+
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$M0/FILE1 bs=1M count=2
+TEST dd if=/dev/urandom of=$M0/FILE2 bs=1M count=2
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT '0x02' get_signature_type $B0/${V0}1/FILE1
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT '0x02' get_signature_type $B0/${V0}1/FILE2
+
+## objects signed earlier keep their type
+TEST $CLI volume set $V0 features.signature-type sha256
+TEST dd if=/dev/urandom of=$M0/FILE3 bs=1M count=2
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT '0x01' get_signature_type $B0/${V0}1/FILE3
+EXPECT '0x02' get_signature_type $B0/${V0}1/FILE1
+
+## corrupt the last block of FILE1 and FILE3
+TEST dd if=/dev/urandom of=$B0/${V0}1/FILE1 bs=1 count=16 seek=2000000 conv=notrunc
+TEST dd if=/dev/urandom of=$B0/${V0}1/FILE3 bs=1 count=16 seek=2000000 conv=notrunc
+
+TEST $CLI volume bitrot $V0 scrub ondemand
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT 'trusted.bit-rot.bad-file' check_for_xattr 'trusted.bit-rot.bad-file' "/$B0/${V0}1/FILE1"
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT 'trusted.bit-rot.bad-file' check_for_xattr 'trusted.bit-rot.bad-file' "/$B0/${V0}1/FILE3"
+EXPECT '' check_for_xattr 'trusted.bit-rot.bad-file' "/$B0/${V0}1/FILE2"
+
+cleanup;
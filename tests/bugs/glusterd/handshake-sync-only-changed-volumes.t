@@ -0,0 +1,60 @@
+#!/bin/bash
+
+# The handshake first exchanges a (version, cksum) summary of the volumes and
+# then only sends the volumes that differ. A node that was down must still
+# get every change made meanwhile, and keep the volumes that did not change.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../cluster.rc
+
+function check_peers {
+        $CLI_1 peer status | grep 'Peer in Cluster (Connected)' | wc -l
+}
+
+function get_option {
+        $1 volume get $2 $3 | grep "^$3 " | awk '{print $2}'
+}
+
+function volume_count {
+        $1 volume list | wc -l
+}
+
+function volume_status {
+        $1 volume info $2 | grep "^Status: " | sed 's/.*: //'
+}
+
+cleanup
+
+TEST launch_cluster 2
+TEST $CLI_1 peer probe $H2
+EXPECT_WITHIN $PROBE_TIMEOUT 1 check_peers
+
+for i in 1 2 3; do
+        TEST $CLI_1 volume create ${V0}_$i $H1:$B1/${V0}_$i $H2:$B2/${V0}_$i
+done
+EXPECT "3" volume_count $CLI_2
+
+TEST kill_glusterd 2
+
+# one volume changes, one is created, the others stay as they are
+TEST $CLI_1 volume set ${V0}_1 performance.write-behind off
+TEST $CLI_1 volume create $V1 $H1:$B1/$V1
+
+TEST start_glusterd 2
+EXPECT_WITHIN $PROBE_TIMEOUT 1 check_peers
+
+EXPECT_WITHIN $PROBE_TIMEOUT "off" get_option $CLI_2 ${V0}_1 \
+                                   performance.write-behind
+EXPECT_WITHIN $PROBE_TIMEOUT "4" volume_count $CLI_2
+EXPECT "on" get_option $CLI_2 ${V0}_2 performance.write-behind
+EXPECT "Created" volume_status $CLI_2 ${V0}_3
+
+# and the other way round, node 1 was down
+TEST kill_glusterd 1
+TEST $CLI_2 volume set ${V0}_3 performance.read-ahead off
+TEST start_glusterd 1
+EXPECT_WITHIN $PROBE_TIMEOUT 1 check_peers
+EXPECT_WITHIN $PROBE_TIMEOUT "off" get_option $CLI_1 ${V0}_3 \
+                                   performance.read-ahead
+
+cleanup
@@ -1673,8 +1673,59 @@ afr_least_pending_reads_child (afr_private_t *priv)
         return child;
 }
 
+/* The readable child with the lowest expected wait: its average read
+ * latency times the reads it already has in flight, penalized by its error
+ * rate. Children without a latency sample are tried first, and every
+ * AFR_READ_PROBE_INTERVAL-th read goes round robin, so that the average of
+ * a slow child follows when it recovers. */
 int
-afr_hash_child (afr_read_subvol_args_t *args, afr_private_t *priv)
+afr_lowest_latency_child (afr_private_t *priv, unsigned char *readable)
+{
+        int     i = 0;
+        int     child = -1;
+        int64_t probe = 0;
+        int64_t latency = 0;
+        int64_t errors = 0;
+        int64_t cost = 0;
+        int64_t best = INT64_MAX;
+
+        probe = GF_ATOMIC_INC (priv->read_probe);
+        if (probe % AFR_READ_PROBE_INTERVAL == 0) {
+                probe /= AFR_READ_PROBE_INTERVAL;
+                for (i = 0; i < priv->child_count; i++) {
+                        child = (probe + i) % priv->child_count;
+                        if (readable[child] &&
+                            !AFR_IS_ARBITER_BRICK (priv, child))
+                                return child;
+                }
+                return -1;
+        }
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (!readable[i] || AFR_IS_ARBITER_BRICK (priv, i))
+                        continue;
+
+                latency = GF_ATOMIC_GET (priv->read_latency[i]);
+                errors = GF_ATOMIC_GET (priv->read_errors[i]);
+                cost = latency * (GF_ATOMIC_GET (priv->pending_reads[i]) + 1);
+                cost += cost * errors / 128;
+                if (errors >= AFR_READ_ERRORS_UNHEALTHY)
+                        cost = INT64_MAX / 2 + errors;
+                else if (!latency)
+                        return i;
+
+                if (cost < best) {
+                        best = cost;
+                        child = i;
+                }
+        }
+
+        return child;
+}
+
+int
+afr_hash_child (afr_read_subvol_args_t *args, afr_private_t *priv,
+                unsigned char *readable)
 {
         uuid_t gfid_copy = {0,};
         pid_t pid;
@@ -1709,6 +1760,9 @@ afr_hash_child (afr_read_subvol_args_t *args, afr_private_t *priv)
         case 3:
                 child = afr_least_pending_reads_child (priv);
                 break;
+        case 4:
+                child = afr_lowest_latency_child (priv, readable);
+                break;
         }
 
         return child;
@@ -1738,7 +1792,7 @@ afr_read_subvol_select_by_policy (inode_t *inode, xlator_t *this,
         }
 
 	/* second preference - use hashed mode */
-        read_subvol = afr_hash_child (&local_args, priv);
+        read_subvol = afr_hash_child (&local_args, priv, readable);
 	if (read_subvol >= 0 && readable[read_subvol])
                 return read_subvol;
 
@@ -2116,6 +2170,14 @@ afr_local_cleanup (afr_local_t *local, xlator_t *this)
                         fd_unref (local->cont.open.fd);
         }
 
+        { /* copy_file_range */
+                if (local->cont.copy_file_range.lock_frame)
+                        afr_copy_file_range_src_unlock (this,
+                                      local->cont.copy_file_range.lock_frame);
+                if (local->cont.copy_file_range.fd_in)
+                        fd_unref (local->cont.copy_file_range.fd_in);
+        }
+
         { /* readdirp */
                 if (local->cont.readdir.dict)
                         dict_unref (local->cont.readdir.dict);
@@ -4881,6 +4943,10 @@ afr_priv_dump (xlator_t *this)
                 gf_proc_dump_write(key, "%s", priv->pending_key[i]);
                 sprintf (key, "pending_reads[%d]", i);
                 gf_proc_dump_write(key, "%"PRId64, GF_ATOMIC_GET(priv->pending_reads[i]));
+                sprintf (key, "read_latency[%d]", i);
+                gf_proc_dump_write(key, "%"PRId64, GF_ATOMIC_GET(priv->read_latency[i]));
+                sprintf (key, "read_errors[%d]", i);
+                gf_proc_dump_write(key, "%"PRId64, GF_ATOMIC_GET(priv->read_errors[i]));
                 sprintf (key, "child_latency[%d]", i);
                 gf_proc_dump_write(key, "%"PRId64, priv->child_latency[i]);
         }
@@ -5770,6 +5836,8 @@ afr_priv_destroy (afr_private_t *priv)
         }
 
         GF_FREE (priv->pending_reads);
+        GF_FREE (priv->read_latency);
+        GF_FREE (priv->read_errors);
         GF_FREE (priv->local);
         GF_FREE (priv->pending_key);
         GF_FREE (priv->children);
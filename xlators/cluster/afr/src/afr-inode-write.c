@@ -2323,6 +2323,371 @@ out:
 
 /* }}} */
 
+/* {{{ copy_file_range */
+
+/* The copy only counts when it was done in full on every brick that was
+ * up, the source being readable on all of them. Otherwise the replicas of
+ * the destination differ and the caller has to copy the data itself: a
+ * brick that failed is still marked for heal by the post-op, but what the
+ * caller writes next goes to all of them. */
+int
+afr_copy_file_range_unwind (call_frame_t *frame, xlator_t *this)
+{
+        afr_local_t    *local = NULL;
+        afr_private_t  *priv = NULL;
+        call_frame_t   *main_frame = NULL;
+        int             i = 0;
+
+        local = frame->local;
+        priv = this->private;
+
+        main_frame = afr_transaction_detach_fop_frame (frame);
+        if (!main_frame)
+                return 0;
+
+        for (i = 0; i < priv->child_count && local->op_ret >= 0; i++) {
+                if (!local->child_up[i])
+                        continue;
+                if (!local->replies[i].valid ||
+                    local->replies[i].op_ret != local->op_ret) {
+                        local->op_ret = -1;
+                        local->op_errno = EXDEV;
+                }
+        }
+
+        AFR_STACK_UNWIND (copy_file_range, main_frame, local->op_ret,
+                          local->op_errno, &local->cont.copy_file_range.stbuf,
+                          &local->cont.inode_wfop.prebuf,
+                          &local->cont.inode_wfop.postbuf, local->xdata_rsp);
+        return 0;
+}
+
+
+int
+afr_copy_file_range_wind_cbk (call_frame_t *frame, void *cookie,
+                              xlator_t *this, int32_t op_ret,
+                              int32_t op_errno, struct iatt *stbuf,
+                              struct iatt *prebuf_dst,
+                              struct iatt *postbuf_dst, dict_t *xdata)
+{
+        afr_local_t *local = NULL;
+
+        local = frame->local;
+
+        if (op_ret >= 0) {
+                LOCK (&frame->lock);
+                {
+                        local->cont.copy_file_range.stbuf = *stbuf;
+                }
+                UNLOCK (&frame->lock);
+        }
+
+        return __afr_inode_write_cbk (frame, cookie, this, op_ret, op_errno,
+                                      prebuf_dst, postbuf_dst, NULL, xdata);
+}
+
+
+static int32_t
+afr_copy_file_range_src_lock_cbk (call_frame_t *frame, void *cookie,
+                                  xlator_t *this, int32_t op_ret,
+                                  int32_t op_errno, dict_t *xdata)
+{
+        afr_private_t *priv = NULL;
+        afr_local_t *lock_local = NULL;
+        afr_local_t *local = NULL;
+        call_frame_t *transaction_frame = NULL;
+        int subvol = (long) cookie;
+
+        priv = this->private;
+        lock_local = frame->local;
+        transaction_frame = lock_local->transaction.frame;
+        local = transaction_frame->local;
+
+        lock_local->replies[subvol].valid = 1;
+        lock_local->replies[subvol].op_ret = op_ret;
+        lock_local->replies[subvol].op_errno = op_errno;
+
+        if (op_ret < 0)
+                return afr_copy_file_range_wind_cbk (transaction_frame,
+                                                     cookie, this, -1, EXDEV,
+                                                     NULL, NULL, NULL, NULL);
+
+        STACK_WIND_COOKIE (transaction_frame, afr_copy_file_range_wind_cbk,
+                           (void *) (long) subvol, priv->children[subvol],
+                           priv->children[subvol]->fops->copy_file_range,
+                           local->cont.copy_file_range.fd_in,
+                           local->cont.copy_file_range.off_in, local->fd,
+                           local->cont.copy_file_range.off_out,
+                           local->cont.copy_file_range.len,
+                           local->cont.copy_file_range.flags,
+                           local->xdata_req);
+        return 0;
+}
+
+
+/* The source range is read locked on each brick, with a lock owner of its
+ * own, once the transaction holds the lock on the destination. The lock is
+ * only tried: waiting for it while holding the destination lock could
+ * deadlock with a copy in the other direction, so a brick on which it can't
+ * be taken fails the copy with EXDEV.
+ */
+int
+afr_copy_file_range_wind (call_frame_t *frame, xlator_t *this, int subvol)
+{
+        afr_local_t *local = NULL;
+        afr_local_t *lock_local = NULL;
+        afr_private_t *priv = NULL;
+        call_frame_t *lock_frame = NULL;
+
+        local = frame->local;
+        priv = this->private;
+        lock_frame = local->cont.copy_file_range.lock_frame;
+
+        if (!lock_frame) {
+                STACK_WIND_COOKIE (frame, afr_copy_file_range_wind_cbk,
+                                   (void *) (long) subvol,
+                                   priv->children[subvol],
+                                   priv->children[subvol]->fops->copy_file_range,
+                                   local->cont.copy_file_range.fd_in,
+                                   local->cont.copy_file_range.off_in,
+                                   local->fd,
+                                   local->cont.copy_file_range.off_out,
+                                   local->cont.copy_file_range.len,
+                                   local->cont.copy_file_range.flags,
+                                   local->xdata_req);
+                return 0;
+        }
+
+        lock_local = lock_frame->local;
+        lock_local->transaction.frame = frame;
+
+        STACK_WIND_COOKIE (lock_frame, afr_copy_file_range_src_lock_cbk,
+                           (void *) (long) subvol, priv->children[subvol],
+                           priv->children[subvol]->fops->finodelk,
+                           this->name, lock_local->fd, F_SETLK,
+                           &lock_local->cont.inodelk.flock, NULL);
+        return 0;
+}
+
+
+static int32_t
+afr_copy_file_range_src_unlock_cbk (call_frame_t *frame, void *cookie,
+                                    xlator_t *this, int32_t op_ret,
+                                    int32_t op_errno, dict_t *xdata)
+{
+        afr_private_t *priv = NULL;
+        afr_local_t *local = NULL;
+        int child_index = (long) cookie;
+        int call_count = 0;
+
+        priv = this->private;
+        local = frame->local;
+
+        if (op_ret < 0 && op_errno != ENOTCONN && op_errno != EBADFD)
+                gf_msg (this->name, GF_LOG_ERROR, op_errno,
+                        AFR_MSG_UNLOCK_FAIL,
+                        "gfid=%s: unlock of the copy_file_range source "
+                        "failed on subvolume %s",
+                        uuid_utoa (local->fd->inode->gfid),
+                        priv->children[child_index]->name);
+
+        call_count = afr_frame_return (frame);
+        if (call_count == 0)
+                AFR_STACK_DESTROY (frame);
+
+        return 0;
+}
+
+/* Releases the read locks on the source range taken by
+ * afr_copy_file_range_wind () and destroys lock_frame. Called when the
+ * transaction on the destination is destroyed. */
+void
+afr_copy_file_range_src_unlock (xlator_t *this, call_frame_t *lock_frame)
+{
+        afr_private_t *priv = NULL;
+        afr_local_t *local = NULL;
+        struct gf_flock flock = {0,};
+        int call_count = 0;
+        int i = 0;
+
+        priv = this->private;
+        local = lock_frame->local;
+
+        for (i = 0; i < priv->child_count; i++)
+                if (local->replies[i].valid && local->replies[i].op_ret >= 0)
+                        call_count++;
+
+        if (call_count == 0) {
+                AFR_STACK_DESTROY (lock_frame);
+                return;
+        }
+
+        local->call_count = call_count;
+
+        flock = local->cont.inodelk.flock;
+        flock.l_type = F_UNLCK;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (!local->replies[i].valid || local->replies[i].op_ret < 0)
+                        continue;
+
+                STACK_WIND_COOKIE (lock_frame,
+                                   afr_copy_file_range_src_unlock_cbk,
+                                   (void *) (long) i, priv->children[i],
+                                   priv->children[i]->fops->finodelk,
+                                   this->name, local->fd, F_SETLK, &flock,
+                                   NULL);
+                if (!--call_count)
+                        break;
+        }
+}
+
+
+static int
+afr_copy_file_range_src_lock_init (call_frame_t *frame, xlator_t *this,
+                                   afr_local_t *local)
+{
+        afr_local_t *lock_local = NULL;
+        call_frame_t *lock_frame = NULL;
+        int op_errno = ENOMEM;
+
+        lock_frame = copy_frame (frame);
+        if (!lock_frame)
+                return -op_errno;
+
+        lock_local = AFR_FRAME_INIT (lock_frame, op_errno);
+        if (!lock_local) {
+                AFR_STACK_DESTROY (lock_frame);
+                return -op_errno;
+        }
+
+        afr_set_lk_owner (lock_frame, this, lock_frame->root);
+
+        lock_local->fd = fd_ref (local->cont.copy_file_range.fd_in);
+        lock_local->cont.inodelk.flock.l_type = F_RDLCK;
+        lock_local->cont.inodelk.flock.l_whence = SEEK_SET;
+        lock_local->cont.inodelk.flock.l_start =
+                local->cont.copy_file_range.off_in;
+        lock_local->cont.inodelk.flock.l_len = local->cont.copy_file_range.len;
+
+        local->cont.copy_file_range.lock_frame = lock_frame;
+
+        return 0;
+}
+
+/* Every brick copies its own replica of the source into its own replica of
+ * the destination, as a data transaction on the destination, while a read
+ * lock on the source range keeps it from changing under the copy. That is
+ * only correct when the source is good on all the bricks that are up, and
+ * when every brick has the data, so arbiter volumes and sources that need
+ * heal are left to the caller with EXDEV. A copy within a file widens the
+ * transaction to both ranges instead.
+ */
+int
+afr_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags, dict_t *xdata)
+{
+        afr_private_t *priv = NULL;
+        afr_local_t *local = NULL;
+        call_frame_t *transaction_frame = NULL;
+        unsigned char *readable = NULL;
+        int i = 0;
+        int ret = -1;
+        int op_errno = ENOMEM;
+
+        priv = this->private;
+
+        if (priv->arbiter_count || priv->thin_arbiter_count) {
+                op_errno = EXDEV;
+                goto out;
+        }
+
+        readable = alloca0 (priv->child_count);
+        ret = afr_inode_read_subvol_get (fd_in->inode, this, readable, NULL,
+                                         NULL);
+        if (ret < 0) {
+                op_errno = EXDEV;
+                goto out;
+        }
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (priv->child_up[i] && !readable[i]) {
+                        op_errno = EXDEV;
+                        goto out;
+                }
+        }
+
+        transaction_frame = copy_frame (frame);
+        if (!transaction_frame)
+                goto out;
+
+        local = AFR_FRAME_INIT (transaction_frame, op_errno);
+        if (!local)
+                goto out;
+
+        local->cont.copy_file_range.fd_in = fd_ref (fd_in);
+        local->cont.copy_file_range.off_in = off_in;
+        local->cont.copy_file_range.off_out = off_out;
+        local->cont.copy_file_range.len = len;
+        local->cont.copy_file_range.flags = flags;
+
+        local->fd = fd_ref (fd_out);
+        ret = afr_set_inode_local (this, local, fd_out->inode);
+        if (ret)
+                goto out;
+
+        if (xdata)
+                local->xdata_req = dict_copy_with_ref (xdata, NULL);
+        else
+                local->xdata_req = dict_new ();
+
+        if (!local->xdata_req)
+                goto out;
+
+        local->op = GF_FOP_COPY_FILE_RANGE;
+
+        local->transaction.wind   = afr_copy_file_range_wind;
+        local->transaction.unwind = afr_copy_file_range_unwind;
+
+        local->transaction.main_frame = frame;
+
+        if (fd_in->inode == fd_out->inode) {
+                local->transaction.start = min (off_in, off_out);
+                local->transaction.len = max (off_in, off_out) + len -
+                                         local->transaction.start;
+        } else {
+                local->transaction.start = off_out;
+                local->transaction.len = len;
+
+                ret = afr_copy_file_range_src_lock_init (frame, this, local);
+                if (ret < 0) {
+                        op_errno = -ret;
+                        goto out;
+                }
+        }
+
+        afr_fix_open (fd_in, this);
+        afr_fix_open (fd_out, this);
+
+        ret = afr_transaction (transaction_frame, this, AFR_DATA_TRANSACTION);
+        if (ret < 0) {
+                op_errno = -ret;
+                goto out;
+        }
+
+        return 0;
+out:
+        if (transaction_frame)
+                AFR_STACK_DESTROY (transaction_frame);
+
+        AFR_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                          NULL, NULL);
+        return 0;
+}
+
+/* }}} */
+
 int32_t
 afr_xattrop_wind_cbk (call_frame_t *frame, void *cookie,
                       xlator_t *this, int32_t op_ret, int32_t op_errno,
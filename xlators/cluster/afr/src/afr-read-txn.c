@@ -11,6 +11,7 @@
 #include "afr.h"
 #include "afr-transaction.h"
 #include "afr-messages.h"
+#include "timespec.h"
 
 void
 afr_pending_read_increment (afr_private_t *priv, int child_index)
@@ -30,6 +31,57 @@ afr_pending_read_decrement (afr_private_t *priv, int child_index)
         GF_ATOMIC_DEC(priv->pending_reads[child_index]);
 }
 
+static void
+afr_read_ewma_add (gf_atomic_t *avg, int64_t sample)
+{
+        int64_t cur = 0;
+
+        /* racing updates may lose a sample, which is fine for an average */
+        cur = GF_ATOMIC_GET (*avg);
+        GF_ATOMIC_ADD (*avg, (sample - cur) / (1 << AFR_READ_EWMA_SHIFT));
+}
+
+/* Accounts the read that @local had wound to local->read_subvol, when it
+ * was timed for read-hash-mode 4. Only successful reads give a latency
+ * sample, a brick that fails fast must not look fast. ENOENT and ESTALE
+ * say nothing about the brick. */
+void
+afr_read_latency_update (afr_private_t *priv, afr_local_t *local,
+                         int op_errno)
+{
+        struct timespec now = {0,};
+        struct timespec elapsed = {0,};
+        int64_t usec = 0;
+        int child = local->read_subvol;
+
+        if (child < 0 || child >= priv->child_count)
+                return;
+
+        if (!local->read_start.tv_sec && !local->read_start.tv_nsec)
+                return;
+
+        if (op_errno == ENOENT || op_errno == ESTALE)
+                goto out;
+
+        if (op_errno) {
+                afr_read_ewma_add (&priv->read_errors[child], 1024);
+                goto out;
+        }
+        afr_read_ewma_add (&priv->read_errors[child], 0);
+
+        timespec_now (&now);
+        timespec_sub (&local->read_start, &now, &elapsed);
+        usec = elapsed.tv_sec * 1000000 + elapsed.tv_nsec / 1000 + 1;
+
+        if (GF_ATOMIC_GET (priv->read_latency[child]) == 0)
+                GF_ATOMIC_ADD (priv->read_latency[child], usec);
+        else
+                afr_read_ewma_add (&priv->read_latency[child], usec);
+out:
+        local->read_start.tv_sec = 0;
+        local->read_start.tv_nsec = 0;
+}
+
 void
 afr_read_txn_wind (call_frame_t *frame, xlator_t *this, int subvol)
 {
@@ -39,9 +91,14 @@ afr_read_txn_wind (call_frame_t *frame, xlator_t *this, int subvol)
         local = frame->local;
         priv = this->private;
 
+        /* winding again means the previous attempt failed */
+        afr_read_latency_update (priv, local,
+                                 local->op_errno ? local->op_errno : EIO);
         afr_pending_read_decrement (priv, local->read_subvol);
         local->read_subvol = subvol;
         afr_pending_read_increment (priv, subvol);
+        if (priv->hash_mode == 4 && subvol >= 0)
+                timespec_now (&local->read_start);
         local->readfn (frame, this, subvol);
 }
 
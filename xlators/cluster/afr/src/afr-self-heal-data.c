@@ -19,8 +19,15 @@
 enum {
 	AFR_SELFHEAL_DATA_FULL = 0,
 	AFR_SELFHEAL_DATA_DIFF,
+        AFR_SELFHEAL_DATA_MERKLE,
 };
 
+/* The "merkle" algorithm asks the bricks for a hash tree of the file with
+ * one heal block per leaf and this many children per node. */
+#define AFR_MERKLE_FANOUT       64
+/* Bricks read everything below a node to answer for it */
+#define AFR_MERKLE_MAX_NODE     (1ULL << 30)
+
 
 #define HAS_HOLES(i) ((i->ia_blocks * 512) < (i->ia_size))
 static int
@@ -279,6 +286,240 @@ unlock:
 }
 
 
+static int
+afr_selfheal_data_range (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                         int source, unsigned char *healed_sinks, off_t offset,
+                         uint64_t len, size_t block, int type,
+                         struct afr_reply *replies)
+{
+        afr_private_t *priv = NULL;
+        off_t end = 0;
+        int ret = 0;
+
+        priv = this->private;
+        end = min (offset + len, replies[source].poststat.ia_size);
+
+        for (; offset < end; offset += block) {
+                if (AFR_COUNT (healed_sinks, priv->child_count) == 0)
+                        return -ENOTCONN;
+
+                ret = afr_selfheal_data_block (frame, this, fd, source,
+                                               healed_sinks, offset, block,
+                                               type, replies);
+                if (ret < 0)
+                        return ret;
+
+                AFR_STACK_RESET (frame);
+                if (frame->local == NULL)
+                        return -ENOTCONN;
+        }
+
+        return 0;
+}
+
+
+static int
+__merkle_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int op_ret, int op_errno, uint32_t weak, uint8_t *strong,
+              dict_t *xdata)
+{
+        afr_local_t *local = NULL;
+        int i = (long) cookie;
+
+        local = frame->local;
+
+        local->replies[i].valid = 1;
+        local->replies[i].op_ret = op_ret;
+        local->replies[i].op_errno = op_errno;
+        if (xdata)
+                local->replies[i].xdata = dict_ref (xdata);
+
+        syncbarrier_wake (&local->barrier);
+        return 0;
+}
+
+/*
+ * Compares the children of the node of @node bytes at @offset between the
+ * source and @sinks, and goes down into the children that differ on any of
+ * them. Leaves are healed like "diff" would, which checks them again under
+ * the lock. Bricks that don't know about the tree get "diff" for the whole
+ * node.
+ */
+static int
+afr_selfheal_data_merkle_node (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                               int source, unsigned char *healed_sinks,
+                               unsigned char *sinks, off_t offset,
+                               uint64_t node, size_t block,
+                               struct afr_reply *replies)
+{
+        afr_private_t *priv = NULL;
+        afr_local_t *local = NULL;
+        unsigned char *wind_subvols = NULL;
+        unsigned char *child_sinks = NULL;
+        dict_t **rsp = NULL;
+        dict_t *xdata = NULL;
+        gf_boolean_t fallback = _gf_false;
+        uint64_t child = 0;
+        void *src = NULL;
+        void *dst = NULL;
+        int src_len = 0;
+        int dst_len = 0;
+        int count = 0;
+        int ret = 0;
+        int c = 0;
+        int i = 0;
+
+        priv = this->private;
+        child = node / AFR_MERKLE_FANOUT;
+
+        wind_subvols = alloca0 (priv->child_count);
+        child_sinks = alloca0 (priv->child_count);
+        rsp = alloca0 (priv->child_count * sizeof (*rsp));
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (i == source || (sinks[i] && healed_sinks[i]))
+                        wind_subvols[i] = 1;
+        }
+        if (AFR_COUNT (wind_subvols, priv->child_count) < 2)
+                return 0;
+
+        xdata = dict_new ();
+        if (!xdata)
+                return -ENOMEM;
+        if (dict_set_uint64 (xdata, GF_MERKLE_LEAF_SIZE, block) ||
+            dict_set_uint32 (xdata, GF_MERKLE_FANOUT, AFR_MERKLE_FANOUT) ||
+            dict_set_uint64 (xdata, GF_MERKLE_NODE_SIZE, node)) {
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        AFR_ONLIST (wind_subvols, frame, __merkle_cbk, rchecksum, fd,
+                    offset, 0, xdata);
+
+        local = frame->local;
+        for (i = 0; i < priv->child_count; i++) {
+                if (!wind_subvols[i])
+                        continue;
+                if (!local->replies[i].valid || local->replies[i].op_ret) {
+                        if (i == source) {
+                                ret = local->replies[i].valid ?
+                                      -local->replies[i].op_errno : -ENOTCONN;
+                                goto out;
+                        }
+                        healed_sinks[i] = 0;
+                        continue;
+                }
+                if (!local->replies[i].xdata ||
+                    !dict_get (local->replies[i].xdata, GF_MERKLE_NODE_SIZE))
+                        fallback = _gf_true;
+                else
+                        rsp[i] = dict_ref (local->replies[i].xdata);
+        }
+
+        AFR_STACK_RESET (frame);
+        if (frame->local == NULL) {
+                ret = -ENOTCONN;
+                goto out;
+        }
+
+        if (fallback) {
+                ret = afr_selfheal_data_range (frame, this, fd, source,
+                                               healed_sinks, offset, node,
+                                               block, AFR_SELFHEAL_DATA_DIFF,
+                                               replies);
+                goto out;
+        }
+
+        if (dict_get_ptr_and_len (rsp[source], GF_MERKLE_DIGESTS, &src,
+                                  &src_len))
+                src_len = 0;
+        count = src_len / SHA256_DIGEST_LENGTH;
+
+        for (c = 0; c < count; c++) {
+                memset (child_sinks, 0, priv->child_count);
+                for (i = 0; i < priv->child_count; i++) {
+                        if (i == source || !rsp[i] || !healed_sinks[i])
+                                continue;
+                        if (dict_get_ptr_and_len (rsp[i], GF_MERKLE_DIGESTS,
+                                                  &dst, &dst_len) ||
+                            dst_len < (c + 1) * SHA256_DIGEST_LENGTH ||
+                            memcmp ((char *)src + c * SHA256_DIGEST_LENGTH,
+                                    (char *)dst + c * SHA256_DIGEST_LENGTH,
+                                    SHA256_DIGEST_LENGTH))
+                                child_sinks[i] = 1;
+                }
+                if (AFR_COUNT (child_sinks, priv->child_count) == 0)
+                        continue;
+
+                if (child == block)
+                        ret = afr_selfheal_data_range (frame, this, fd, source,
+                                                       healed_sinks,
+                                                       offset + c * child,
+                                                       child, block,
+                                                       AFR_SELFHEAL_DATA_DIFF,
+                                                       replies);
+                else
+                        ret = afr_selfheal_data_merkle_node (frame, this, fd,
+                                                             source,
+                                                             healed_sinks,
+                                                             child_sinks,
+                                                             offset +
+                                                             c * child,
+                                                             child, block,
+                                                             replies);
+                if (ret < 0)
+                        goto out;
+        }
+        ret = 0;
+out:
+        for (i = 0; i < priv->child_count; i++) {
+                if (rsp[i])
+                        dict_unref (rsp[i]);
+        }
+        dict_unref (xdata);
+        return ret;
+}
+
+static int
+afr_selfheal_data_merkle (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          int source, unsigned char *healed_sinks,
+                          size_t block, struct afr_reply *replies)
+{
+        afr_private_t *priv = NULL;
+        uint64_t size = 0;
+        uint64_t node = 0;
+        off_t offset = 0;
+        int ret = 0;
+
+        priv = this->private;
+        size = replies[source].poststat.ia_size;
+
+        /* the smallest node that covers the file, if it can be asked for */
+        for (node = block; node < size; node *= AFR_MERKLE_FANOUT) {
+                if (node * AFR_MERKLE_FANOUT > AFR_MERKLE_MAX_NODE)
+                        break;
+        }
+        if (node == block)
+                return afr_selfheal_data_range (frame, this, fd, source,
+                                                healed_sinks, 0, size, block,
+                                                AFR_SELFHEAL_DATA_DIFF,
+                                                replies);
+
+        for (offset = 0; offset < size; offset += node) {
+                if (AFR_COUNT (healed_sinks, priv->child_count) == 0)
+                        return -ENOTCONN;
+
+                ret = afr_selfheal_data_merkle_node (frame, this, fd, source,
+                                                     healed_sinks,
+                                                     healed_sinks, offset,
+                                                     node, block, replies);
+                if (ret < 0)
+                        return ret;
+        }
+
+        return 0;
+}
+
 
 static int
 afr_selfheal_data_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
@@ -327,6 +568,8 @@ afr_data_self_heal_type_get (afr_private_t *priv, unsigned char *healed_sinks,
                 type = AFR_SELFHEAL_DATA_FULL;
         } else if (strcmp (priv->data_self_heal_algorithm, "diff") == 0) {
                 type = AFR_SELFHEAL_DATA_DIFF;
+        } else if (strcmp (priv->data_self_heal_algorithm, "merkle") == 0) {
+                type = AFR_SELFHEAL_DATA_MERKLE;
         }
         return type;
 }
@@ -337,7 +580,6 @@ afr_selfheal_data_do (call_frame_t *frame, xlator_t *this, fd_t *fd,
 		      struct afr_reply *replies)
 {
 	afr_private_t *priv = NULL;
-	off_t off = 0;
 	size_t block = 0;
 	int type = AFR_SELFHEAL_DATA_FULL;
 	int ret = -1;
@@ -361,24 +603,16 @@ afr_selfheal_data_do (call_frame_t *frame, xlator_t *this, fd_t *fd,
                 goto out;
         }
 
-	for (off = 0; off < replies[source].poststat.ia_size; off += block) {
-                if (AFR_COUNT (healed_sinks, priv->child_count) == 0) {
-                        ret = -ENOTCONN;
-                        goto out;
-                }
-
-		ret = afr_selfheal_data_block (iter_frame, this, fd, source,
-					       healed_sinks, off, block, type,
-					       replies);
-		if (ret < 0)
-			goto out;
-
-		AFR_STACK_RESET (iter_frame);
-		if (iter_frame->local == NULL) {
-		        ret = -ENOTCONN;
-		        goto out;
-                }
-	}
+        if (type == AFR_SELFHEAL_DATA_MERKLE)
+                ret = afr_selfheal_data_merkle (iter_frame, this, fd, source,
+                                                healed_sinks, block, replies);
+        else
+                ret = afr_selfheal_data_range (iter_frame, this, fd, source,
+                                               healed_sinks, 0,
+                                               replies[source].poststat.ia_size,
+                                               block, type, replies);
+        if (ret < 0)
+                goto out;
 
 	ret = afr_selfheal_data_fsync (frame, this, fd, healed_sinks);
 
@@ -445,6 +445,16 @@ init (xlator_t *this)
 
         priv->pending_reads = GF_CALLOC (sizeof(*priv->pending_reads),
                                          priv->child_count, gf_afr_mt_atomic_t);
+        priv->read_latency = GF_CALLOC (sizeof(*priv->read_latency),
+                                        priv->child_count, gf_afr_mt_atomic_t);
+        priv->read_errors = GF_CALLOC (sizeof(*priv->read_errors),
+                                       priv->child_count, gf_afr_mt_atomic_t);
+        if (!priv->pending_reads || !priv->read_latency ||
+            !priv->read_errors) {
+                ret = -ENOMEM;
+                goto out;
+        }
+        GF_ATOMIC_INIT (priv->read_probe, 0);
 
         GF_OPTION_INIT ("read-hash-mode", priv->hash_mode, uint32, out);
 
@@ -662,6 +672,7 @@ struct xlator_fops fops = {
         .fallocate   = afr_fallocate,
         .discard     = afr_discard,
         .zerofill    = afr_zerofill,
+        .copy_file_range = afr_copy_file_range,
         .xattrop     = afr_xattrop,
         .fxattrop    = afr_fxattrop,
         .fsync       = afr_fsync,
@@ -725,7 +736,7 @@ struct volume_options options[] = {
         { .key = {"read-hash-mode" },
           .type = GF_OPTION_TYPE_INT,
           .min = 0,
-          .max = 3,
+          .max = 4,
           .default_value = "1",
           .op_version = {2},
           .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
@@ -737,7 +748,11 @@ struct volume_options options[] = {
                          "1 = hash by GFID of file (all clients use "
                                                     "same subvolume).\n"
                          "2 = hash by GFID of file and client PID.\n"
-                         "3 = brick having the least outstanding read requests."
+                         "3 = brick having the least outstanding read requests.\n"
+                         "4 = brick with the lowest recent read latency and "
+                                "error rate, weighted by its outstanding read "
+                                "requests; a small share of reads still goes "
+                                "to the other bricks to follow their latency."
         },
         { .key  = {"choose-local" },
           .type = GF_OPTION_TYPE_BOOL,
@@ -853,18 +868,24 @@ struct volume_options options[] = {
           .op_version = {1},
           .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
           .tags = {"replicate"},
-          .description   = "Select between \"full\", \"diff\". The "
+          .description   = "Select between \"full\", \"diff\" and "
+                           "\"merkle\". The "
                            "\"full\" algorithm copies the entire file from "
                            "source to sink. The \"diff\" algorithm copies to "
                            "sink only those blocks whose checksums don't match "
-                           "with those of source. If no option is configured "
+                           "with those of source. The \"merkle\" algorithm "
+                           "copies the same blocks as \"diff\" but finds "
+                           "them by comparing a hash tree of the file, "
+                           "descending only into the regions that differ, "
+                           "instead of asking for the checksum of every "
+                           "block. If no option is configured "
                            "the option is chosen dynamically as follows: "
                            "If the file does not exist on one of the sinks "
                            "or empty file exists or if the source file size is "
                            "about the same as page size the entire file will "
                            "be read and written i.e \"full\" algo, "
                            "otherwise \"diff\" algo is chosen.",
-          .value = { "diff", "full"}
+          .value = { "diff", "full", "merkle"}
         },
         { .key  = {"data-self-heal-window-size"},
           .type = GF_OPTION_TYPE_INT,
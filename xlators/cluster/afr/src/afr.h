@@ -39,6 +39,14 @@
 #define THIN_ARBITER_DOM1 "afr.ta.domain-1"
 
 #define AFR_HALO_MAX_LATENCY 99999
+
+/* read-hash-mode 4: one read in AFR_READ_PROBE_INTERVAL goes to the next
+ * readable child whatever its latency, children whose reads failed more
+ * than AFR_READ_ERRORS_UNHEALTHY / 1024 of the time are used last. */
+#define AFR_READ_PROBE_INTERVAL   32
+#define AFR_READ_ERRORS_UNHEALTHY 256
+#define AFR_READ_EWMA_SHIFT       3 /* new samples weigh 1/8 */
+
 typedef int (*afr_lock_cbk_t) (call_frame_t *frame, xlator_t *this);
 
 typedef int (*afr_read_txn_wind_t) (call_frame_t *frame, xlator_t *this, int subvol);
@@ -119,6 +127,10 @@ typedef struct _afr_private {
         int read_child;               /* read-subvolume */
         unsigned int hash_mode;       /* for when read_child is not set */
         gf_atomic_t *pending_reads; /*No. of pending read cbks per child.*/
+        gf_atomic_t *read_latency; /* read-hash-mode 4: average reply time
+                                      of the reads of each child, in usec */
+        gf_atomic_t *read_errors;  /* and of their failures, in 1/1024ths */
+        gf_atomic_t read_probe;    /* reads chosen by read-hash-mode 4 */
         int favorite_child;  /* subvolume to be preferred in resolving
                                          split-brain cases */
 
@@ -432,6 +444,7 @@ typedef struct _afr_local {
 	unsigned char *readable2; /*For rename transaction*/
 
         int read_subvol; /* Current read subvolume */
+        struct timespec read_start; /* when it was wound, read-hash-mode 4 */
 
 	afr_inode_refresh_cbk_t refreshfn;
 
@@ -662,6 +675,16 @@ typedef struct _afr_local {
                         struct iatt postbuf;
                 } zerofill;
 
+                struct {
+                        fd_t *fd_in;
+                        off_t off_in;
+                        off_t off_out;
+                        size_t len;
+                        uint32_t flags;
+                        struct iatt stbuf;
+                        call_frame_t *lock_frame;
+                } copy_file_range;
+
                 struct {
                         char *volume;
                         int32_t cmd;
@@ -989,8 +1012,11 @@ afr_cleanup_fd_ctx (xlator_t *this, fd_t *fd);
                         __this = frame->this;                   \
                         afr_handle_inconsistent_fop (frame, &__op_ret,\
                                                      &__op_errno);\
-                        if (__local && __local->is_read_txn) \
+                        if (__local && __local->is_read_txn) { \
+                                afr_read_latency_update (__this->private, \
+                                        __local, (__op_ret < 0) ? __op_errno : 0); \
                                 afr_pending_read_decrement (__this->private, __local->read_subvol); \
+                        }                                       \
                         frame->local = NULL;                    \
                 }                                               \
                                                                 \
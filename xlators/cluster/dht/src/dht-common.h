@@ -42,6 +42,10 @@
 #define DHT_LAYOUT_HASH_INVALID         1
 #define MAX_REBAL_THREADS               sysconf(_SC_NPROCESSORS_ONLN)
 
+/* Layouts with at least this many subvolumes get a sorted range index for
+ * dht_layout_search (), below that a linear scan is just as fast. */
+#define DHT_LAYOUT_INDEX_MIN_CNT     8
+
 #define DHT_DIR_STAT_BLOCKS          8
 #define DHT_DIR_STAT_SIZE            4096
 
@@ -71,6 +75,17 @@ typedef int (*dht_refresh_layout_unlock) (call_frame_t *frame, xlator_t *this,
 
 typedef int (*dht_refresh_layout_done_handle) (call_frame_t *frame);
 
+/* The non-empty ranges of a layout sorted by start, in three contiguous
+ * arrays carved out of one allocation, so that the hash lookup is a binary
+ * search over start[] instead of a scan of the whole list. pos[] maps back
+ * to the entry in layout->list. */
+struct dht_layout_index {
+        int                cnt;
+        uint32_t          *stop;
+        int               *pos;
+        uint32_t           start[];
+};
+
 struct dht_layout {
         int                spread_cnt;  /* layout spread count per directory,
                                            is controlled by 'setxattr()' with
@@ -95,6 +110,9 @@ struct dht_layout {
         int                type;
         gf_atomic_t        ref; /* use with dht_conf_t->layout_lock */
         uint32_t           search_unhashed;
+        /* built once by dht_layout_set (), NULL if the layout is small or
+         * its ranges overlap */
+        struct dht_layout_index *index;
         struct {
                 int        err;   /* 0 = normal
                                      -1 = dir exists and no xattr
@@ -864,6 +882,7 @@ dht_layout_t                            *dht_layout_get (xlator_t *this, inode_t
 dht_layout_t                            *dht_layout_for_subvol (xlator_t *this, xlator_t *subvol);
 xlator_t *dht_layout_search (xlator_t   *this, dht_layout_t *layout,
                              const char *name);
+int dht_layout_index (xlator_t *this, dht_layout_t *layout);
 int32_t
 dht_migration_get_dst_subvol(xlator_t *this, dht_local_t  *local);
 int32_t
@@ -1174,6 +1193,10 @@ int32_t dht_discard(call_frame_t *frame, xlator_t *this, fd_t *fd,
                     off_t offset, size_t len, dict_t *xdata);
 int32_t dht_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd,
                     off_t offset, off_t len, dict_t *xdata);
+int32_t dht_copy_file_range (call_frame_t *frame, xlator_t *this,
+                             fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                             off_t off_out, size_t len, uint32_t flags,
+                             dict_t *xdata);
 int32_t dht_ipc (call_frame_t *frame, xlator_t *this, int32_t op,
                  dict_t *xdata);
 
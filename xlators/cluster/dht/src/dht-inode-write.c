@@ -1492,3 +1492,106 @@ err:
 
         return 0;
 }
+
+
+int
+dht_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int op_ret, int op_errno, struct iatt *stbuf,
+                         struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                         dict_t *xdata)
+{
+        xlator_t     *prev = NULL;
+
+        prev = cookie;
+
+        if (op_ret == -1) {
+                gf_msg_debug (this->name, op_errno,
+                              "subvolume %s returned -1", prev->name);
+                /* the file was migrated away from under the fd, let the
+                 * caller copy through read and write which follow the
+                 * migration
+                 */
+                if (dht_inode_missing (op_errno) || op_errno == EBADF)
+                        op_errno = EXDEV;
+                goto out;
+        }
+
+        /* A file that is being migrated needs every write to reach the
+         * destination too, which only writev and friends know how to do.
+         * The data was copied to the source of the migration, failing the
+         * copy makes the caller write the same range again through the
+         * regular path.
+         */
+        if (IS_DHT_MIGRATION_PHASE1 (postbuf_dst) ||
+            IS_DHT_MIGRATION_PHASE2 (postbuf_dst) ||
+            IS_DHT_MIGRATION_PHASE2 (stbuf)) {
+                op_ret = -1;
+                op_errno = EXDEV;
+                goto out;
+        }
+
+        DHT_STRIP_PHASE1_FLAGS (stbuf);
+        DHT_STRIP_PHASE1_FLAGS (prebuf_dst);
+        DHT_STRIP_PHASE1_FLAGS (postbuf_dst);
+
+out:
+        DHT_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno, stbuf,
+                          prebuf_dst, postbuf_dst, xdata);
+        return 0;
+}
+
+/* Both files have to live on the same subvolume, the copy is then done
+ * there without the data ever reaching dht. Files on different subvolumes
+ * fail with EXDEV, as copy_file_range(2) does across file systems, so that
+ * the caller falls back to reading and writing.
+ */
+int
+dht_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags, dict_t *xdata)
+{
+        xlator_t     *subvol = NULL;
+        xlator_t     *subvol_out = NULL;
+        int           op_errno = -1;
+        dht_local_t  *local = NULL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd_in, err);
+        VALIDATE_OR_GOTO (fd_out, err);
+
+        local = dht_local_init (frame, NULL, fd_out,
+                                GF_FOP_COPY_FILE_RANGE);
+        if (!local) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        subvol_out = local->cached_subvol;
+        subvol = dht_subvol_get_cached (this, fd_in->inode);
+        if (!subvol || !subvol_out) {
+                gf_msg_debug (this->name, 0,
+                              "no cached subvolume for fd=%p",
+                              subvol ? fd_out : fd_in);
+                op_errno = EINVAL;
+                goto err;
+        }
+
+        if (subvol != subvol_out) {
+                op_errno = EXDEV;
+                goto err;
+        }
+
+        STACK_WIND_COOKIE (frame, dht_copy_file_range_cbk, subvol, subvol,
+                           subvol->fops->copy_file_range, fd_in, off_in,
+                           fd_out, off_out, len, flags, xdata);
+
+        return 0;
+
+err:
+        op_errno = (op_errno == -1) ? errno : op_errno;
+        DHT_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                          NULL, NULL);
+
+        return 0;
+}
@@ -23,6 +23,13 @@
 
 #define layout_size(cnt) (layout_base_size + (cnt * layout_entry_size))
 
+/* scratch entry used to sort the ranges of a layout for its index */
+struct dht_layout_range {
+        uint32_t start;
+        uint32_t stop;
+        int      pos;
+};
+
 dht_layout_t *
 dht_layout_new (xlator_t *this, int cnt)
 {
@@ -85,6 +92,8 @@ dht_layout_set (xlator_t *this, inode_t *inode, dht_layout_t *layout)
         if (!conf || !layout)
                 goto out;
 
+        dht_layout_index (this, layout);
+
         LOCK (&conf->layout_lock);
         {
                 oldret = dht_inode_ctx_layout_get (inode, this, &old_layout);
@@ -115,8 +124,10 @@ dht_layout_unref (xlator_t *this, dht_layout_t *layout)
 
         ref = GF_ATOMIC_DEC (layout->ref);
 
-        if (!ref)
+        if (!ref) {
+                GF_FREE (layout->index);
                 GF_FREE (layout);
+        }
 }
 
 
@@ -132,6 +143,128 @@ dht_layout_ref (xlator_t *this, dht_layout_t *layout)
 }
 
 
+static int
+dht_layout_range_cmp (const void *a, const void *b)
+{
+        const struct dht_layout_range *ra = a;
+        const struct dht_layout_range *rb = b;
+
+        if (ra->start != rb->start)
+                return (ra->start < rb->start) ? -1 : 1;
+
+        return ra->pos - rb->pos;
+}
+
+
+/* Builds the sorted range index of @layout unless it already has one. Only
+ * layouts whose non-empty ranges do not overlap are indexed, for the others
+ * the first matching entry in list order has to win, which is what the
+ * linear scan in dht_layout_search () does. Returns 0 if the layout ends up
+ * with an index. */
+int
+dht_layout_index (xlator_t *this, dht_layout_t *layout)
+{
+        struct dht_layout_index  *index = NULL;
+        struct dht_layout_range  *ranges = NULL;
+        int                       cnt = 0;
+        int                       i = 0;
+        int                       ret = -1;
+
+        if (layout->index)
+                return 0;
+
+        if (layout->cnt < DHT_LAYOUT_INDEX_MIN_CNT)
+                goto out;
+
+        ranges = GF_MALLOC (layout->cnt * sizeof (*ranges),
+                            gf_dht_mt_layout_index_t);
+        if (!ranges)
+                goto out;
+
+        for (i = 0; i < layout->cnt; i++) {
+                /* holes left by errored or new subvolumes */
+                if (!layout->list[i].start && !layout->list[i].stop)
+                        continue;
+                if (layout->list[i].start > layout->list[i].stop)
+                        continue;
+
+                ranges[cnt].start = layout->list[i].start;
+                ranges[cnt].stop = layout->list[i].stop;
+                ranges[cnt].pos = i;
+                cnt++;
+        }
+
+        if (!cnt)
+                goto out;
+
+        qsort (ranges, cnt, sizeof (*ranges), dht_layout_range_cmp);
+
+        for (i = 1; i < cnt; i++) {
+                if (ranges[i].start <= ranges[i - 1].stop)
+                        goto out;
+        }
+
+        index = GF_MALLOC (sizeof (*index) + cnt * (sizeof (index->start[0]) +
+                                                    sizeof (index->stop[0]) +
+                                                    sizeof (index->pos[0])),
+                           gf_dht_mt_layout_index_t);
+        if (!index)
+                goto out;
+
+        index->cnt = cnt;
+        index->stop = &index->start[cnt];
+        index->pos = (int *)&index->stop[cnt];
+        for (i = 0; i < cnt; i++) {
+                index->start[i] = ranges[i].start;
+                index->stop[i] = ranges[i].stop;
+                index->pos[i] = ranges[i].pos;
+        }
+
+        /* preset and readdirp layouts can be set on many inodes at once */
+        if (!__sync_bool_compare_and_swap (&layout->index, NULL, index))
+                GF_FREE (index);
+
+        ret = 0;
+out:
+        GF_FREE (ranges);
+
+        return ret;
+}
+
+
+static xlator_t *
+dht_layout_index_search (dht_layout_t *layout, uint32_t hash)
+{
+        struct dht_layout_index *index = layout->index;
+        const uint32_t          *base = NULL;
+        int                      n = 0;
+        int                      half = 0;
+        int                      i = 0;
+
+        base = index->start;
+        n = index->cnt;
+
+        /* last range starting at or before hash, without data dependent
+         * branches */
+        while (n > 1) {
+                half = n / 2;
+                base = (base[half] <= hash) ? base + half : base;
+                n -= half;
+        }
+
+        i = base - index->start;
+        if (index->start[i] > hash || index->stop[i] < hash)
+                return NULL;
+
+        /* the entries may have been rewritten since the index was built */
+        i = index->pos[i];
+        if (layout->list[i].start > hash || layout->list[i].stop < hash)
+                return NULL;
+
+        return layout->list[i].xlator;
+}
+
+
 xlator_t *
 dht_layout_search (xlator_t *this, dht_layout_t *layout, const char *name)
 {
@@ -149,6 +282,13 @@ dht_layout_search (xlator_t *this, dht_layout_t *layout, const char *name)
                 goto out;
         }
 
+        /* zeroed out entries are left out of the index but match hash 0,
+         * anything the index misses gets the full scan too */
+        if (layout->index && hash)
+                subvol = dht_layout_index_search (layout, hash);
+        if (subvol)
+                goto out;
+
         for (i = 0; i < layout->cnt; i++) {
                 if (layout->list[i].start <= hash
                     && layout->list[i].stop >= hash) {
@@ -40,6 +40,7 @@ enum gf_dht_mem_types_ {
         gf_tier_mt_qfile_array_t,
         gf_dht_ret_cache_t,
         gf_dht_nodeuuids_t,
+        gf_dht_mt_layout_index_t,
         gf_dht_mt_end
 };
 #endif
@@ -2026,6 +2026,7 @@ ec_lock_next_owner(ec_lock_link_t *link, ec_cbk_data_t *cbk,
     ec_lock_t *lock = link->lock;
     ec_fop_data_t *fop = link->fop;
     ec_inode_t *ctx = lock->ctx;
+    ec_t *ec = fop->xl->private;
 
     INIT_LIST_HEAD(&list);
 
@@ -2046,6 +2047,14 @@ ec_lock_next_owner(ec_lock_link_t *link, ec_cbk_data_t *cbk,
     if ((fop->error == 0) && (cbk != NULL) && (cbk->op_ret >= 0)) {
         if (link->update[0]) {
             ctx->post_version[0]++;
+            /* Remember which parts of the file the bricks that missed this
+             * write will need to heal. */
+            if (ec->heal_dirty_ranges &&
+                (lock->loc.inode->ia_type == IA_IFREG) &&
+                (ec->node_mask & ~(fop->good | fop->remaining))) {
+                lock->dirty_ranges |= ec_dirty_ranges_mask(link->fl_start,
+                                                           link->fl_end);
+            }
         }
         if (link->update[1]) {
             ctx->post_version[1]++;
@@ -2255,14 +2264,18 @@ ec_update_size_version(ec_lock_link_t *link, uint64_t *version,
     ec_fop_data_t *fop;
     ec_lock_t *lock;
     ec_inode_t *ctx;
+    ec_t *ec;
     dict_t *dict = NULL;
     uintptr_t   update_on = 0;
+    uint64_t ranges[EC_DIRTY_RANGES_LEN];
+    int32_t i;
 
     int32_t err = -ENOMEM;
 
     fop = link->fop;
     lock = link->lock;
     ctx = lock->ctx;
+    ec = fop->xl->private;
 
     ec_trace("UPDATE", fop, "version=%ld/%ld, size=%ld, dirty=%ld/%ld",
              version[0], version[1], size, dirty[0], dirty[1]);
@@ -2313,6 +2326,24 @@ ec_update_size_version(ec_lock_link_t *link, uint64_t *version,
 
     update_on = lock->good_mask | lock->healing;
 
+    /* A data transaction that some brick missed adds its versions and the
+     * regions it wrote to the dirty ranges of the bricks that got it, so that
+     * self-heal can rebuild only those regions. */
+    if (ec->heal_dirty_ranges && (version[0] != 0) &&
+        (lock->loc.inode->ia_type == IA_IFREG) &&
+        ((lock->dirty_ranges != 0) || (ec->node_mask & ~update_on))) {
+        ranges[0] = version[0];
+        for (i = 0; i < EC_DIRTY_RANGE_SLOTS; i++) {
+            ranges[i + 1] = (lock->dirty_ranges >> i) & 1;
+        }
+        err = ec_dict_set_array(dict, EC_XATTR_DIRTY_RANGES, ranges,
+                                EC_DIRTY_RANGES_LEN);
+        if (err != 0) {
+            goto out;
+        }
+    }
+    lock->dirty_ranges = 0;
+
     if (link->lock->fd == NULL) {
             ec_xattrop(fop->frame, fop->xl, update_on, EC_MINIMUM_MIN,
                        ec_update_size_version_done, link, &link->lock->loc,
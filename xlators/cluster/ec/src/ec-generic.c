@@ -1182,6 +1182,9 @@ ec_xattrop_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
                 ec_dict_del_array (xattr, EC_XATTR_DIRTY, dirty,
                                    EC_VERSION_SIZE);
+                /* Each brick counts its own dirty ranges, don't let them
+                 * make the answers differ. */
+                dict_del (xattr, EC_XATTR_DIRTY_RANGES);
                 link = fop->data;
                 if (link) {
                         /*Keep a note of if the dirty is already set or not*/
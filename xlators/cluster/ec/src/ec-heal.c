@@ -249,7 +249,7 @@ ec_heal_writev_cbk (call_frame_t *frame, void *cookie,
 
     gf_msg_debug (fop->xl->name, 0, "%s: write op_ret %d, op_errno %s"
             " at %"PRIu64, uuid_utoa (heal->fd->inode->gfid), op_ret,
-            strerror (op_errno), heal->offset);
+            strerror (op_errno), fop->offset);
 
     ec_heal_update(cookie, 0);
 
@@ -264,19 +264,25 @@ int32_t ec_heal_readv_cbk(call_frame_t * frame, void * cookie, xlator_t * this,
 {
     ec_fop_data_t * fop = cookie;
     ec_heal_t * heal = fop->data;
+    ec_t * ec = fop->xl->private;
+    uint64_t offset;
 
     ec_trace("READ_CBK", fop, "ret=%d, errno=%d", op_ret, op_errno);
 
     ec_heal_avoid(fop);
 
+    /* Heal windows are aligned to the stripe size, so the read has no head
+     * and its offset is the offset of the window in the fragments. */
+    offset = fop->offset * ec->fragments;
+
     if (op_ret > 0)
     {
         gf_msg_debug (fop->xl->name, 0, "%s: read succeeded, proceeding "
                 "to write at %"PRIu64, uuid_utoa (heal->fd->inode->gfid),
-                heal->offset);
+                offset);
         ec_writev(heal->fop->frame, heal->xl, heal->bad, EC_MINIMUM_ONE,
                   ec_heal_writev_cbk, heal, heal->fd, vector, count,
-                  heal->offset, 0, iobref, NULL);
+                  offset, 0, iobref, NULL);
     }
     else
     {
@@ -284,7 +290,7 @@ int32_t ec_heal_readv_cbk(call_frame_t * frame, void * cookie, xlator_t * this,
                 gf_msg_debug (fop->xl->name, 0, "%s: read failed %s, failing "
                         "to heal block at %"PRIu64,
                         uuid_utoa (heal->fd->inode->gfid), strerror (op_errno),
-                        heal->offset);
+                        offset);
                 heal->bad = 0;
         }
         heal->done = 1;
@@ -295,14 +301,21 @@ int32_t ec_heal_readv_cbk(call_frame_t * frame, void * cookie, xlator_t * this,
 
 void ec_heal_data_block(ec_heal_t *heal)
 {
+    uint32_t i;
+
     ec_trace("DATA", heal->fop, "good=%lX, bad=%lX", heal->good, heal->bad);
 
-    if ((heal->good != 0) && (heal->bad != 0) &&
-        (heal->iatt.ia_type == IA_IFREG))
-    {
+    /* All the windows are read and written in parallel under the same lock.
+     * The heal fop only moves to the unlock state once all of them are
+     * done. */
+    for (i = 0; i < heal->window_count; i++) {
+        if ((heal->good == 0) || (heal->bad == 0) ||
+            (heal->iatt.ia_type != IA_IFREG)) {
+            break;
+        }
         ec_readv(heal->fop->frame, heal->xl, heal->good, EC_MINIMUM_MIN,
-                 ec_heal_readv_cbk, heal, heal->fd, heal->size, heal->offset,
-                 0, NULL);
+                 ec_heal_readv_cbk, heal, heal->fd, heal->size,
+                 heal->windows[i], 0, NULL);
     }
 }
 
@@ -1723,9 +1736,9 @@ out:
 int
 __ec_heal_data_prepare (call_frame_t *frame, ec_t *ec, fd_t *fd,
                         unsigned char *locked_on, uint64_t *versions,
-                        uint64_t *dirty, uint64_t *size, unsigned char *sources,
-                        unsigned char *healed_sinks, unsigned char *trim,
-                        struct iatt *stbuf)
+                        uint64_t *dirty, uint64_t *size, uint64_t *ranges,
+                        unsigned char *sources, unsigned char *healed_sinks,
+                        unsigned char *trim, struct iatt *stbuf)
 {
         default_args_cbk_t *replies = NULL;
         default_args_cbk_t *fstat_replies = NULL;
@@ -1733,6 +1746,7 @@ __ec_heal_data_prepare (call_frame_t *frame, ec_t *ec, fd_t *fd,
         unsigned char      *fstat_output  = NULL;
         dict_t             *xattrs  = NULL;
         uint64_t           zero_array[2] = {0};
+        uint64_t           zero_ranges[EC_DIRTY_RANGES_LEN] = {0};
         int                source   = 0;
         int                ret      = 0;
         uint64_t           zero_value = 0;
@@ -1753,6 +1767,12 @@ __ec_heal_data_prepare (call_frame_t *frame, ec_t *ec, fd_t *fd,
                 ret = -ENOMEM;
                 goto out;
         }
+        if (ranges &&
+            dict_set_static_bin (xattrs, EC_XATTR_DIRTY_RANGES, zero_ranges,
+                                 sizeof (zero_ranges))) {
+                ret = -ENOMEM;
+                goto out;
+        }
 
         ret = cluster_fxattrop (ec->xl_list, locked_on, ec->nodes,
                                 replies, output, frame, ec->xl, fd,
@@ -1766,6 +1786,11 @@ __ec_heal_data_prepare (call_frame_t *frame, ec_t *ec, fd_t *fd,
                 replies[i].valid = output[i];
                 if (output[i])
                         replies[i].stat = fstat_replies[i].stat;
+                if (output[i] && ranges)
+                        ec_dict_get_array (replies[i].xattr,
+                                           EC_XATTR_DIRTY_RANGES,
+                                           &ranges[i * EC_DIRTY_RANGES_LEN],
+                                           EC_DIRTY_RANGES_LEN);
         }
 
         if (EC_COUNT (output, ec->nodes) <= ec->fragments) {
@@ -1992,13 +2017,159 @@ ec_sync_heal_block (call_frame_t *frame, xlator_t *this, ec_heal_t *heal)
         return 0;
 }
 
+/* Gets the extent of data of the fragments stored in the brick 'idx' that
+ * starts at or after the file offset 'offset', in file offsets aligned to the
+ * stripe size. If there's no more data, the extent is set beyond EOF. */
+static int
+ec_heal_data_extent (ec_t *ec, fd_t *fd, int idx, uint64_t offset,
+                     uint64_t *extent)
+{
+        off_t data = 0;
+        off_t hole = 0;
+        int   ret  = 0;
+
+        ret = syncop_seek (ec->xl_list[idx], fd, offset / ec->fragments,
+                           GF_SEEK_DATA, NULL, &data);
+        if (ret == -ENXIO) {
+                extent[0] = extent[1] = UINT64_MAX;
+                return 0;
+        }
+        if (ret < 0)
+                return ret;
+
+        ret = syncop_seek (ec->xl_list[idx], fd, data, GF_SEEK_HOLE, NULL,
+                           &hole);
+        if (ret < 0)
+                return ret;
+
+        data -= data % ec->fragment_size;
+        hole += ec->fragment_size - 1;
+        hole -= hole % ec->fragment_size;
+        extent[0] = (uint64_t)data * ec->fragments;
+        extent[1] = (uint64_t)hole * ec->fragments;
+
+        return 0;
+}
+
+/* Returns the offset of the next window to heal, at or after 'offset'.
+ *
+ * A window is skipped when none of its regions is in 'dirty' or when it only
+ * covers holes in the first source and in all the sinks. Holes in the sources
+ * are zeroes and a sink that has a hole there already reads zeroes, but data
+ * in a sink may be stale, so it is always healed. The last window is always
+ * healed, which gives the sinks the size of the sources.
+ *
+ * 'extents' caches the current data extent of each brick in 'check'. If the
+ * bricks can't tell where their data is, 'sparse' is cleared and the rest of
+ * the file is healed window by window. */
+static uint64_t
+ec_heal_next_window (ec_t *ec, ec_heal_t *heal, unsigned char *check,
+                     uint64_t *extents, gf_boolean_t *sparse,
+                     uint64_t dirty, uint64_t offset)
+{
+        uint64_t last = 0;
+        uint64_t next = 0;
+        int      ret  = 0;
+        int      i    = 0;
+
+        last = heal->total_size - 1;
+        last -= last % ec->stripe_size;
+
+        while (offset < last) {
+                /* Regions are tracked on the fragments, like the locks. */
+                if ((dirty != EC_DIRTY_RANGES_ALL) &&
+                    !(dirty & ec_dirty_ranges_mask (offset / ec->fragments,
+                                        (offset + heal->size - 1) /
+                                        ec->fragments))) {
+                        next = (offset + heal->size - 1) / ec->fragments;
+                        next += EC_DIRTY_RANGE_SIZE -
+                                next % EC_DIRTY_RANGE_SIZE;
+                        next *= ec->fragments;
+                        offset = next - next % ec->stripe_size;
+                        continue;
+                }
+
+                if (!*sparse)
+                        break;
+
+                next = UINT64_MAX;
+                for (i = 0; i < ec->nodes; i++) {
+                        if (!check[i])
+                                continue;
+                        if (extents[2 * i + 1] <= offset) {
+                                ret = ec_heal_data_extent (ec, heal->fd, i,
+                                                           offset,
+                                                           &extents[2 * i]);
+                                if (ret < 0) {
+                                        gf_msg_debug (ec->xl->name, 0,
+                                                "%s: seek failed %s, "
+                                                "healing holes too",
+                                                uuid_utoa (heal->fd->inode->gfid),
+                                                strerror (-ret));
+                                        *sparse = _gf_false;
+                                        return offset;
+                                }
+                        }
+                        next = min (next, max (extents[2 * i], offset));
+                }
+
+                if (next == offset)
+                        break;
+                offset = next;
+        }
+
+        return min (offset, last);
+}
+
+/* Returns the mask of dirty range slots that the sinks need to heal or
+ * EC_DIRTY_RANGES_ALL if some sink misses writes that were not recorded,
+ * which is the case of a replaced brick, or it is a sink for other reasons
+ * than missed writes. */
+static uint64_t
+ec_heal_dirty_ranges (ec_t *ec, uint64_t *versions, uint64_t *ranges,
+                      int source, unsigned char *healed_sinks)
+{
+        uint64_t *src   = &ranges[source * EC_DIRTY_RANGES_LEN];
+        uint64_t *sink  = NULL;
+        uint64_t  vmask = ~(1ULL << EC_SELFHEAL_BIT);
+        uint64_t  delta = 0;
+        uint64_t  mask  = 0;
+        int       i     = 0;
+        int       j     = 0;
+
+        for (i = 0; i < ec->nodes; i++) {
+                if (!healed_sinks[i])
+                        continue;
+
+                sink = &ranges[i * EC_DIRTY_RANGES_LEN];
+                delta = (versions[source] & vmask) - (versions[i] & vmask);
+                if ((delta == 0) || (delta != src[0] - sink[0]))
+                        return EC_DIRTY_RANGES_ALL;
+
+                for (j = 0; j < EC_DIRTY_RANGE_SLOTS; j++) {
+                        if (src[j + 1] != sink[j + 1])
+                                mask |= 1ULL << j;
+                }
+        }
+
+        return mask;
+}
+
 int
 ec_rebuild_data (call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
-                 unsigned char *sources, unsigned char *healed_sinks)
+                 unsigned char *sources, unsigned char *healed_sinks,
+                 uint64_t dirty)
 {
         ec_heal_t        *heal = NULL;
         int              ret = 0;
         syncbarrier_t    barrier;
+        unsigned char    *check = NULL;
+        uint64_t         *extents = NULL;
+        gf_boolean_t     sparse = _gf_true;
+        uint64_t         offset = 0;
+        uint64_t         healed = 0;
+        uint32_t         windows = 0;
+        int              i = 0;
 
         if (syncbarrier_init (&barrier))
                 return -ENOMEM;
@@ -2020,8 +2191,21 @@ ec_rebuild_data (call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
         heal->iatt.ia_type = IA_IFREG;
         LOCK_INIT(&heal->lock);
 
-        for (heal->offset = 0; (heal->offset < size) && !heal->done;
-                                                   heal->offset += heal->size) {
+        windows = ec->self_heal_parallel_windows;
+        heal->windows = alloca0 (windows * sizeof (*heal->windows));
+
+        /* Holes are looked for in the first source and in all the sinks. */
+        check = alloca0 (ec->nodes);
+        extents = alloca0 (2 * ec->nodes * sizeof (*extents));
+        memcpy (check, healed_sinks, ec->nodes);
+        for (i = 0; i < ec->nodes; i++) {
+                if (sources[i]) {
+                        check[i] = 1;
+                        break;
+                }
+        }
+
+        while ((offset < size) && !heal->done) {
                 /* We immediately abort any heal if a shutdown request has been
                  * received to avoid delays. The healing of this file will be
                  * restarted by another SHD or other client that accesses the
@@ -2033,17 +2217,31 @@ ec_rebuild_data (call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
                         break;
                 }
 
+                for (heal->window_count = 0;
+                     (heal->window_count < windows) && (offset < size);
+                     heal->window_count++) {
+                        offset = ec_heal_next_window (ec, heal, check, extents,
+                                                      &sparse, dirty, offset);
+                        heal->windows[heal->window_count] = offset;
+                        offset += heal->size;
+                }
+                heal->offset = heal->windows[0];
+                healed += heal->window_count * heal->size;
+
                 gf_msg_debug (ec->xl->name, 0, "%s: sources: %d, sinks: "
-                        "%d, offset: %"PRIu64" bsize: %"PRIu64,
+                        "%d, offset: %"PRIu64" bsize: %"PRIu64" windows: %u",
                         uuid_utoa (fd->inode->gfid),
                         EC_COUNT (sources, ec->nodes),
                         EC_COUNT (healed_sinks, ec->nodes), heal->offset,
-                        heal->size);
+                        heal->size, heal->window_count);
                 ret = ec_sync_heal_block (frame, ec->xl, heal);
                 if (ret < 0)
                         break;
 
         }
+        gf_msg_debug (ec->xl->name, 0, "%s: healed %"PRIu64" of %"PRIu64
+                      " bytes", uuid_utoa (fd->inode->gfid),
+                      min (healed, size), size);
         memset (healed_sinks, 0, ec->nodes);
         ec_mask_to_char_array (heal->bad, healed_sinks, ec->nodes);
         fd_unref (heal->fd);
@@ -2098,12 +2296,16 @@ out:
 int
 ec_data_undo_pending (call_frame_t *frame, ec_t *ec, fd_t *fd, dict_t *xattr,
                       uint64_t *versions, uint64_t *dirty, uint64_t *size,
-                      int source, gf_boolean_t erase_dirty, int idx)
+                      uint64_t *ranges, int source, gf_boolean_t erase_dirty,
+                      int idx)
 {
         uint64_t versions_xattr[2] = {0};
         uint64_t dirty_xattr[2]    = {0};
         uint64_t allzero[2]        = {0};
         uint64_t size_xattr        = 0;
+        uint64_t ranges_xattr[EC_DIRTY_RANGES_LEN] = {0};
+        gf_boolean_t has_ranges    = _gf_false;
+        int      i                 = 0;
         int      ret               = 0;
 
         versions_xattr[EC_DATA_TXN] = hton64(versions[source] - versions[idx]);
@@ -2128,9 +2330,28 @@ ec_data_undo_pending (call_frame_t *frame, ec_t *ec, fd_t *fd, dict_t *xattr,
                         goto out;
         }
 
+        /* The dirty ranges of the sink become those of the source, so that
+         * the next heal only sees the writes missed after this one. */
+        for (i = 0; ranges && (i < EC_DIRTY_RANGES_LEN); i++) {
+                ranges_xattr[i] = ranges[source * EC_DIRTY_RANGES_LEN + i] -
+                                  ranges[idx * EC_DIRTY_RANGES_LEN + i];
+                if (ranges_xattr[i])
+                        has_ranges = _gf_true;
+                ranges_xattr[i] = hton64 (ranges_xattr[i]);
+        }
+        if (has_ranges) {
+                ret = dict_set_static_bin (xattr, EC_XATTR_DIRTY_RANGES,
+                                           ranges_xattr,
+                                           sizeof (ranges_xattr));
+                if (ret < 0)
+                        goto out;
+        } else {
+                dict_del (xattr, EC_XATTR_DIRTY_RANGES);
+        }
+
         if ((memcmp (versions_xattr, allzero, sizeof (allzero)) == 0) &&
             (memcmp (dirty_xattr, allzero, sizeof (allzero)) == 0) &&
-             (size_xattr == 0)) {
+             (size_xattr == 0) && !has_ranges) {
                 ret = 0;
                 goto out;
         }
@@ -2144,7 +2365,8 @@ out:
 int
 __ec_fd_data_adjust_versions (call_frame_t *frame, ec_t *ec, fd_t *fd,
                             unsigned char *sources, unsigned char *healed_sinks,
-                            uint64_t *versions, uint64_t *dirty, uint64_t *size)
+                            uint64_t *versions, uint64_t *dirty, uint64_t *size,
+                            uint64_t *ranges)
 {
         dict_t                     *xattr            = NULL;
         int                        i                 = 0;
@@ -2181,7 +2403,8 @@ __ec_fd_data_adjust_versions (call_frame_t *frame, ec_t *ec, fd_t *fd,
                 if (healed_sinks[i]) {
                         ret = ec_data_undo_pending (frame, ec, fd, xattr,
                                                     versions, dirty, size,
-                                                    source, erase_dirty, i);
+                                                    ranges, source,
+                                                    erase_dirty, i);
                         if (ret < 0)
                                 goto out;
                 }
@@ -2195,7 +2418,8 @@ __ec_fd_data_adjust_versions (call_frame_t *frame, ec_t *ec, fd_t *fd,
                 if (sources[i]) {
                         ret = ec_data_undo_pending (frame, ec, fd, xattr,
                                                     versions, dirty, size,
-                                                    source, erase_dirty, i);
+                                                    ranges, source,
+                                                    erase_dirty, i);
                         if (ret < 0)
                                 continue;
                 }
@@ -2212,7 +2436,7 @@ ec_restore_time_and_adjust_versions (call_frame_t *frame, ec_t *ec, fd_t *fd,
                                      unsigned char *sources,
                                      unsigned char *healed_sinks,
                                      uint64_t *versions, uint64_t *dirty,
-                                     uint64_t *size)
+                                     uint64_t *size, uint64_t *ranges)
 {
         unsigned char      *locked_on           = NULL;
         unsigned char      *participants        = NULL;
@@ -2259,7 +2483,8 @@ ec_restore_time_and_adjust_versions (call_frame_t *frame, ec_t *ec, fd_t *fd,
 
                 ret = __ec_heal_data_prepare (frame, ec, fd, locked_on,
                                               postsh_versions, postsh_dirty,
-                                              postsh_size, postsh_sources,
+                                              postsh_size, NULL,
+                                              postsh_sources,
                                               postsh_healed_sinks, postsh_trim,
                                               &source_buf);
                 if (ret < 0)
@@ -2278,7 +2503,8 @@ ec_restore_time_and_adjust_versions (call_frame_t *frame, ec_t *ec, fd_t *fd,
                         goto unlock;
                 }
                 ret = __ec_fd_data_adjust_versions (frame, ec, fd, sources,
-                                           healed_sinks, versions, dirty, size);
+                                           healed_sinks, versions, dirty, size,
+                                           ranges);
         }
 unlock:
         cluster_uninodelk (ec->xl_list, locked_on, ec->nodes, replies, output,
@@ -2297,6 +2523,8 @@ __ec_heal_data (call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
         uint64_t           *versions     = NULL;
         uint64_t           *dirty        = NULL;
         uint64_t           *size         = NULL;
+        uint64_t           *ranges       = NULL;
+        uint64_t           dirty_ranges  = EC_DIRTY_RANGES_ALL;
         unsigned char      *trim         = NULL;
         default_args_cbk_t *replies      = NULL;
         int                ret           = 0;
@@ -2308,6 +2536,8 @@ __ec_heal_data (call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
         versions     = alloca0 (ec->nodes * sizeof (*versions));
         dirty        = alloca0 (ec->nodes * sizeof (*dirty));
         size         = alloca0 (ec->nodes * sizeof (*size));
+        ranges       = alloca0 (ec->nodes * EC_DIRTY_RANGES_LEN *
+                                sizeof (*ranges));
 
         EC_REPLIES_ALLOC (replies, ec->nodes);
         ret = cluster_inodelk (ec->xl_list, heal_on, ec->nodes, replies,
@@ -2323,19 +2553,25 @@ __ec_heal_data (call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
                 }
 
                 ret = __ec_heal_data_prepare (frame, ec, fd, locked_on,
-                                              versions, dirty, size, sources,
-                                              healed_sinks, trim, NULL);
+                                              versions, dirty, size, ranges,
+                                              sources, healed_sinks, trim,
+                                              NULL);
                 if (ret < 0)
                         goto unlock;
 
                 if (EC_COUNT(healed_sinks, ec->nodes) == 0) {
                         ret = __ec_fd_data_adjust_versions (frame, ec, fd,
                                                             sources,
-                                        healed_sinks, versions, dirty, size);
+                                        healed_sinks, versions, dirty, size,
+                                        ranges);
                         goto unlock;
                 }
 
                 source = ret;
+                if (ec->heal_dirty_ranges)
+                        dirty_ranges = ec_heal_dirty_ranges (ec, versions,
+                                                             ranges, source,
+                                                             healed_sinks);
                 ret = __ec_heal_mark_sinks (frame, ec, fd, versions,
                                             healed_sinks);
                 if (ret < 0)
@@ -2359,13 +2595,13 @@ unlock:
                 EC_COUNT (healed_sinks, ec->nodes));
 
         ret = ec_rebuild_data (frame, ec, fd, size[source], sources,
-                               healed_sinks);
+                               healed_sinks, dirty_ranges);
         if (ret < 0)
                 goto out;
 
         ret = ec_restore_time_and_adjust_versions (frame, ec, fd, sources,
                                                    healed_sinks, versions,
-                                                   dirty, size);
+                                                   dirty, size, ranges);
 out:
         cluster_replies_wipe (replies, ec->nodes);
         return ret;
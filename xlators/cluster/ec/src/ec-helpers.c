@@ -262,6 +262,28 @@ ec_dict_del_array (dict_t *dict, char *key, uint64_t value[], int32_t size)
 }
 
 
+/* Returns the mask of EC_XATTR_DIRTY_RANGES slots that cover the bytes from
+ * fl_start to fl_end, both included. */
+uint64_t
+ec_dirty_ranges_mask (off_t fl_start, off_t fl_end)
+{
+        uint64_t first = fl_start / EC_DIRTY_RANGE_SIZE;
+        uint64_t last  = fl_end / EC_DIRTY_RANGE_SIZE;
+        uint64_t mask  = 0;
+
+        if (fl_end < fl_start)
+                last = first;
+
+        if (last - first >= EC_DIRTY_RANGE_SLOTS - 1)
+                return EC_DIRTY_RANGES_ALL;
+
+        for (; first <= last; first++)
+                mask |= 1ULL << (first % EC_DIRTY_RANGE_SLOTS);
+
+        return mask;
+}
+
+
 int32_t ec_dict_set_number(dict_t * dict, char * key, uint64_t value)
 {
     int        ret = -1;
@@ -35,6 +35,7 @@ int32_t ec_dict_get_array (dict_t *dict, char *key, uint64_t value[],
 
 int32_t ec_dict_del_array(dict_t *dict, char *key,
                           uint64_t *value, int32_t size);
+uint64_t ec_dirty_ranges_mask(off_t fl_start, off_t fl_end);
 int32_t ec_dict_set_number(dict_t * dict, char * key, uint64_t value);
 int32_t ec_dict_del_number(dict_t * dict, char * key, uint64_t * value);
 int32_t ec_dict_set_config(dict_t * dict, char * key, ec_config_t * config);
@@ -276,6 +276,8 @@ struct _ec_lock {
     uintptr_t          mask;
     uintptr_t          good_mask;
     uintptr_t          healing;
+    uint64_t           dirty_ranges; /* Slots written while some brick
+                                        missed the write */
     uint32_t           refs_owners;  /* Refs for fops owning the lock */
     uint32_t           refs_pending; /* Refs assigned to fops being prepared */
     uint32_t           waiting_flags; /*Track xattrop/dirty marking*/
@@ -589,6 +591,8 @@ struct _ec_heal {
     uint64_t          offset;
     uint64_t          size;
     uint64_t          total_size;
+    uint64_t         *windows;     /* Offsets healed by one heal block */
+    uint32_t          window_count;
     uint64_t          version[2];
     uint64_t          raw_size;
 };
@@ -669,6 +673,8 @@ struct _ec {
     uint32_t           background_heals;
     uint32_t           heal_wait_qlen;
     uint32_t           self_heal_window_size; /* max size of read/writes */
+    uint32_t           self_heal_parallel_windows;
+    gf_boolean_t       heal_dirty_ranges;
     uint32_t           eager_lock_timeout;
     uint32_t           other_eager_lock_timeout;
     struct list_head   pending_fops;
@@ -282,6 +282,11 @@ reconfigure (xlator_t *this, dict_t *options)
                           uint32, failed);
         GF_OPTION_RECONF ("self-heal-window-size", ec->self_heal_window_size,
                           options, uint32, failed);
+        GF_OPTION_RECONF ("self-heal-parallel-windows",
+                          ec->self_heal_parallel_windows, options, uint32,
+                          failed);
+        GF_OPTION_RECONF ("heal-dirty-ranges", ec->heal_dirty_ranges,
+                          options, bool, failed);
         GF_OPTION_RECONF ("heal-timeout", ec->shd.timeout, options,
                           int32, failed);
         ec_configure_background_heal_opts (ec, background_heals,
@@ -727,6 +732,9 @@ init (xlator_t *this)
     GF_OPTION_INIT ("heal-wait-qlength", ec->heal_wait_qlen, uint32, failed);
     GF_OPTION_INIT ("self-heal-window-size", ec->self_heal_window_size, uint32,
                     failed);
+    GF_OPTION_INIT ("self-heal-parallel-windows",
+                    ec->self_heal_parallel_windows, uint32, failed);
+    GF_OPTION_INIT ("heal-dirty-ranges", ec->heal_dirty_ranges, bool, failed);
     ec_configure_background_heal_opts (ec, ec->background_heals,
                                        ec->heal_wait_qlen);
     GF_OPTION_INIT ("read-policy", read_policy, str, failed);
@@ -1306,6 +1314,18 @@ int32_t ec_gf_seek(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     return 0;
 }
 
+int32_t ec_gf_copy_file_range(call_frame_t *frame, xlator_t *this,
+                              fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                              off_t off_out, size_t len, uint32_t flags,
+                              dict_t *xdata)
+{
+    /* Bricks only hold fragments, the data needs to be encoded again for
+     * the new offset. Let the caller copy it through readv/writev. */
+    default_copy_file_range_failure_cbk(frame, EXDEV);
+
+    return 0;
+}
+
 int32_t ec_gf_ipc(call_frame_t *frame, xlator_t *this, int32_t op,
                   dict_t *xdata)
 {
@@ -1382,6 +1402,9 @@ int32_t ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heal-wait-qlength", "%d", ec->heal_wait_qlen);
     gf_proc_dump_write("self-heal-window-size", "%"PRIu32,
                        ec->self_heal_window_size);
+    gf_proc_dump_write("self-heal-parallel-windows", "%"PRIu32,
+                       ec->self_heal_parallel_windows);
+    gf_proc_dump_write("heal-dirty-ranges", "%d", ec->heal_dirty_ranges);
     gf_proc_dump_write("healers", "%d", ec->healers);
     gf_proc_dump_write("heal-waiters", "%d", ec->heal_waiters);
     gf_proc_dump_write("read-policy", "%s", ec_read_policies[ec->read_policy]);
@@ -1455,7 +1478,8 @@ struct xlator_fops fops =
     .discard      = ec_gf_discard,
     .zerofill     = ec_gf_zerofill,
     .seek         = ec_gf_seek,
-    .ipc          = ec_gf_ipc
+    .ipc          = ec_gf_ipc,
+    .copy_file_range = ec_gf_copy_file_range
 };
 
 struct xlator_cbks cbks =
@@ -1618,7 +1642,7 @@ struct volume_options options[] =
     {
         .key = { "cpu-extensions" },
         .type = GF_OPTION_TYPE_STR,
-        .value = { "none", "auto", "x64", "sse", "avx" },
+        .value = { "none", "auto", "x64", "sse", "avx", "avx512" },
         .default_value = "auto",
         .op_version = {GD_OP_VERSION_3_9_0},
         .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
@@ -1637,6 +1661,29 @@ struct volume_options options[] =
       .description = "Maximum number blocks(128KB) per file for which "
                      "self-heal process would be applied simultaneously."
     },
+    { .key  = {"self-heal-parallel-windows"},
+      .type = GF_OPTION_TYPE_INT,
+      .min  = 1,
+      .max  = 16,
+      .default_value = "1",
+      .op_version = {GD_OP_VERSION_4_2_0},
+      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+      .tags = {"disperse"},
+      .description = "Number of windows of self-heal-window-size blocks "
+                     "that self-heal reads and writes in parallel for a file "
+                     "while it holds the lock."
+    },
+    { .key  = {"heal-dirty-ranges"},
+      .type = GF_OPTION_TYPE_BOOL,
+      .default_value = "off",
+      .op_version = {GD_OP_VERSION_4_2_0},
+      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+      .tags = {"disperse"},
+      .description = "Record which regions of a file are written while some "
+                     "brick is missing the writes, and let self-heal rebuild "
+                     "only those regions when all the writes a brick missed "
+                     "were recorded. Otherwise the whole file is healed."
+    },
     { .key = {"optimistic-change-log"},
       .type = GF_OPTION_TYPE_BOOL,
       .default_value = "on",
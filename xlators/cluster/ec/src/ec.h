@@ -19,10 +19,21 @@
 #define EC_XATTR_VERSION EC_XATTR_PREFIX"version"
 #define EC_XATTR_HEAL    EC_XATTR_PREFIX"heal"
 #define EC_XATTR_DIRTY   EC_XATTR_PREFIX"dirty"
+#define EC_XATTR_DIRTY_RANGES EC_XATTR_PREFIX"dirty-ranges"
 #define EC_STRIPE_CACHE_MAX_SIZE    10
 #define EC_VERSION_SIZE 2
 #define EC_SHD_INODE_LRU_LIMIT          10
 
+/* Writes that do not reach all bricks are recorded per region of the file in
+ * EC_XATTR_DIRTY_RANGES: the first counter adds up the data versions of the
+ * transactions that recorded something and each of the following ones counts
+ * the writes to the regions that map to it, (offset / region size) modulo the
+ * number of slots. Offsets are those of the fragments, as in the locks. */
+#define EC_DIRTY_RANGE_SLOTS  64
+#define EC_DIRTY_RANGE_SIZE   (16 * GF_UNIT_MB)
+#define EC_DIRTY_RANGES_LEN   (EC_DIRTY_RANGE_SLOTS + 1)
+#define EC_DIRTY_RANGES_ALL   (~0ULL)
+
 #define EC_MAX_FRAGMENTS EC_METHOD_MAX_FRAGMENTS
 /* The maximum number of nodes is derived from the maximum allowed fragments
  * using the rule that redundancy cannot be equal or greater than the number
@@ -4273,6 +4273,17 @@ err:
         return 0;
 }
 
+int32_t
+stripe_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                        off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                        uint32_t flags, dict_t *xdata)
+{
+        /* the stripes of the two files do not line up in general, leave
+         * the copy to the caller */
+        default_copy_file_range_failure_cbk (frame, EXDEV);
+        return 0;
+}
+
 int32_t
 stripe_seek (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
              gf_seek_what_t what, dict_t *xdata)
@@ -5739,6 +5750,7 @@ struct xlator_fops fops = {
 	.discard	= stripe_discard,
         .zerofill       = stripe_zerofill,
         .seek           = stripe_seek,
+        .copy_file_range = stripe_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
@@ -110,11 +110,24 @@ typedef struct _ios_sample_buf_t {
 } ios_sample_buf_t;
 
 
+/* tail latencies reported next to min/avg/max, filled in from the
+ * histograms in ios_conf when dumping */
+#define IOS_LAT_PERCENTILE_MAX 4
+
+static const double ios_lat_percentiles[IOS_LAT_PERCENTILE_MAX] = {
+        50, 90, 99, 99.9
+};
+
+static const char *ios_lat_percentile_names[IOS_LAT_PERCENTILE_MAX] = {
+        "p50", "p90", "p99", "p999"
+};
+
 struct ios_lat {
         double      min;
         double      max;
         double      avg;
         uint64_t    total;
+        uint64_t    percentiles[IOS_LAT_PERCENTILE_MAX];
 };
 
 struct ios_global_stats {
@@ -145,6 +158,9 @@ struct ios_conf {
         struct ios_global_stats   cumulative;
         uint64_t                  increment;
         struct ios_global_stats   incremental;
+        /* per fop, allocated when the fop is first measured */
+        gf_latency_hist_t        *cumulative_hist[GF_FOP_MAXVALUE];
+        gf_latency_hist_t        *incremental_hist[GF_FOP_MAXVALUE];
         gf_boolean_t              dump_fd_stats;
         gf_boolean_t              count_fop_hits;
         gf_boolean_t              measure_latency;
@@ -782,6 +798,7 @@ io_stats_dump_global_to_json_logfp (xlator_t *this,
 {
         int                   i = 0;
         int                   j = 0;
+        int                   k = 0;
         struct ios_conf       *conf = NULL;
         char                  *key_prefix = NULL;
         char                  *str_prefix = NULL;
@@ -905,6 +922,14 @@ io_stats_dump_global_to_json_logfp (xlator_t *this,
                 ios_log (this, logfp,
                         "\"%s.%s.fop.%s.latency_max_usec\": \"%0.2lf\",",
                         key_prefix, str_prefix, lc_fop_name, fop_lat_max);
+                for (k = 0; k < IOS_LAT_PERCENTILE_MAX; k++) {
+                        ios_log (this, logfp,
+                                "\"%s.%s.fop.%s.latency_%s_usec\": "
+                                "\"%"PRIu64"\",", key_prefix, str_prefix,
+                                lc_fop_name, ios_lat_percentile_names[k],
+                                fop_hits ? stats->latency[i].percentiles[k]
+                                         : 0);
+                }
 
                 fop_ave_usec_sum += fop_lat_ave;
                 weighted_fop_ave_usec_sum += fop_hits * fop_lat_ave;
@@ -1247,6 +1272,7 @@ io_stats_dump_global_to_logfp (xlator_t *this, struct ios_global_stats *stats,
         int                   i = 0;
         int                   per_line = 0;
         int                   index = 0;
+        int                   pct_header = 0;
         struct ios_stat_head *list_head = NULL;
         struct ios_conf      *conf = NULL;
         char                  timestr[256] = {0, };
@@ -1351,6 +1377,29 @@ io_stats_dump_global_to_logfp (xlator_t *this, struct ios_global_stats *stats,
                                  fop_hits, "0", "0", "0");
         }
 
+        for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+                if (!GF_ATOMIC_GET (stats->fop_hits[i]) ||
+                    !stats->latency[i].avg)
+                        continue;
+
+                if (!pct_header) {
+                        ios_log (this, logfp, "\n%-13s %14s %14s %14s %14s",
+                                 "Fop", "P50-Latency", "P90-Latency",
+                                 "P99-Latency", "P99.9-Latency");
+                        ios_log (this, logfp, "%-13s %14s %14s %14s %14s",
+                                 "---", "-----------", "-----------",
+                                 "-----------", "-------------");
+                        pct_header = 1;
+                }
+
+                ios_log (this, logfp, "%-13s %11"PRIu64" us %11"PRIu64" us "
+                         "%11"PRIu64" us %11"PRIu64" us", gf_fop_list[i],
+                         stats->latency[i].percentiles[0],
+                         stats->latency[i].percentiles[1],
+                         stats->latency[i].percentiles[2],
+                         stats->latency[i].percentiles[3]);
+        }
+
         ios_log (this, logfp, "------ ----- ----- ----- ----- ----- ----- ----- "
                  " ----- ----- ----- -----\n");
 
@@ -1420,6 +1469,7 @@ io_stats_dump_global_to_dict (xlator_t *this, struct ios_global_stats *stats,
         char            key[256] = {0};
         uint64_t        sec = 0;
         int             i = 0;
+        int             j = 0;
         uint64_t        count = 0;
         uint64_t        fop_hits = 0;
 
@@ -1536,6 +1586,20 @@ io_stats_dump_global_to_dict (xlator_t *this, struct ios_global_stats *stats,
                                 interval, stats->latency[i].max);
                         goto out;
                 }
+                for (j = 0; j < IOS_LAT_PERCENTILE_MAX; j++) {
+                        snprintf (key, sizeof (key), "%d-%d-%slatency",
+                                  interval, i, ios_lat_percentile_names[j]);
+                        ret = dict_set_uint64 (dict, key,
+                                        stats->latency[i].percentiles[j]);
+                        if (ret) {
+                                gf_log (this->name, GF_LOG_ERROR, "failed to "
+                                        "set %s %slatency(%d) with %"PRIu64,
+                                        gf_fop_list[i],
+                                        ios_lat_percentile_names[j], interval,
+                                        stats->latency[i].percentiles[j]);
+                                goto out;
+                        }
+                }
         }
         for (i = 0; i < GF_UPCALL_FLAGS_MAXVALUE; i++) {
                 fop_hits = GF_ATOMIC_GET (stats->upcall_hits[i]);
@@ -1617,6 +1681,25 @@ ios_dump_args_init (struct ios_dump_args *args, ios_dump_type_t type,
         return ret;
 }
 
+static void
+ios_latency_percentiles (gf_latency_hist_t **hists,
+                         struct ios_global_stats *stats, gf_boolean_t reset)
+{
+        gf_latency_snap_t snap;
+        int               i = 0;
+        int               j = 0;
+
+        for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+                memset (&snap, 0, sizeof (snap));
+                gf_latency_hist_merge (hists[i], &snap, reset);
+
+                for (j = 0; j < IOS_LAT_PERCENTILE_MAX; j++)
+                        stats->latency[i].percentiles[j] =
+                                gf_latency_snap_percentile
+                                        (&snap, ios_lat_percentiles[j]);
+        }
+}
+
 static void
 ios_global_stats_clear (struct ios_global_stats *stats, struct timeval *now)
 {
@@ -1666,6 +1749,16 @@ io_stats_dump (xlator_t *this, struct ios_dump_args *args,
         }
         UNLOCK (&conf->lock);
 
+        if (op == GF_CLI_INFO_ALL ||
+            op == GF_CLI_INFO_CUMULATIVE)
+                ios_latency_percentiles (conf->cumulative_hist, &cumulative,
+                                         _gf_false);
+
+        if (op == GF_CLI_INFO_ALL ||
+            op == GF_CLI_INFO_INCREMENTAL)
+                ios_latency_percentiles (conf->incremental_hist, &incremental,
+                                         !is_peek);
+
         if (op == GF_CLI_INFO_ALL ||
             op == GF_CLI_INFO_CUMULATIVE)
                 io_stats_dump_global (this, &cumulative, &now, -1, args);
@@ -1820,6 +1913,7 @@ update_ios_latency (struct ios_conf *conf, call_frame_t *frame,
 {
         double elapsed;
         struct timespec *begin, *end;
+        gf_latency_hist_t *hist;
 
         begin = &frame->begin;
         end   = &frame->end;
@@ -1829,6 +1923,14 @@ update_ios_latency (struct ios_conf *conf, call_frame_t *frame,
 
         update_ios_latency_stats (&conf->cumulative, elapsed, op);
         update_ios_latency_stats (&conf->incremental, elapsed, op);
+
+        hist = gf_latency_hist_get (&conf->cumulative_hist[op]);
+        if (hist)
+                gf_latency_hist_add (hist, elapsed);
+        hist = gf_latency_hist_get (&conf->incremental_hist[op]);
+        if (hist)
+                gf_latency_hist_add (hist, elapsed);
+
         collect_ios_latency_sample (conf, op, elapsed, frame);
 
         return 0;
@@ -2550,6 +2652,19 @@ io_stats_zerofill_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         return 0;
 }
 
+int
+io_stats_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                              xlator_t *this, int32_t op_ret,
+                              int32_t op_errno, struct iatt *stbuf,
+                              struct iatt *prebuf_dst,
+                              struct iatt *postbuf_dst, dict_t *xdata)
+{
+        UPDATE_PROFILE_STATS (frame, COPY_FILE_RANGE);
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno, stbuf,
+                             prebuf_dst, postbuf_dst, xdata);
+        return 0;
+}
+
 int32_t
 io_stats_ipc_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                   int32_t op_ret, int32_t op_errno, dict_t *xdata)
@@ -3515,6 +3630,20 @@ io_stats_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         return 0;
 }
 
+int
+io_stats_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                          off_t off_in, fd_t *fd_out, off_t off_out,
+                          size_t len, uint32_t flags, dict_t *xdata)
+{
+        START_FOP_LATENCY (frame);
+
+        STACK_WIND (frame, io_stats_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+
+        return 0;
+}
+
 int32_t
 io_stats_ipc (call_frame_t *frame, xlator_t *this, int32_t op, dict_t *xdata)
 {
@@ -3968,9 +4097,16 @@ mem_acct_init (xlator_t *this)
 void
 ios_conf_destroy (struct ios_conf *conf)
 {
+        int i = 0;
+
         if (!conf)
                 return;
 
+        for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+                GF_FREE (conf->cumulative_hist[i]);
+                GF_FREE (conf->incremental_hist[i]);
+        }
+
         ios_destroy_top_stats (conf);
         _ios_destroy_dump_thread (conf);
         ios_destroy_sample_buf (conf->ios_sample_buf);
@@ -4353,6 +4489,7 @@ struct xlator_fops fops = {
 	.fallocate   = io_stats_fallocate,
 	.discard     = io_stats_discard,
         .zerofill    = io_stats_zerofill,
+        .copy_file_range = io_stats_copy_file_range,
         .ipc         = io_stats_ipc,
         .rchecksum   = io_stats_rchecksum,
         .seek        = io_stats_seek,
@@ -78,7 +78,9 @@ GLFS_MSGID(BITROT_BITD,
         BRB_MSG_ZERO_TIMEOUT_BUG,
         BRB_MSG_BAD_OBJ_READDIR_FAIL,
         BRB_MSG_SSM_FAILED,
-        BRB_MSG_SCRUB_WAIT_FAILED
+        BRB_MSG_SCRUB_WAIT_FAILED,
+        BRB_MSG_SCALING_SIGNER,
+        BRB_MSG_UNKNOWN_SIGNATURE_TYPE
 );
 
 #endif /* !_BITROT_BITD_MESSAGES_H_ */
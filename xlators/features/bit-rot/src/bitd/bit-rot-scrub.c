@@ -144,7 +144,8 @@ static int32_t
 bitd_signature_staleness (xlator_t *this,
                           br_child_t *child, fd_t *fd,
                           int *stale, unsigned long *version,
-                          br_scrub_stats_t *scrub_stat, gf_boolean_t skip_stat)
+                          int8_t *signtype, br_scrub_stats_t *scrub_stat,
+                          gf_boolean_t skip_stat)
 {
         int32_t ret = -1;
         dict_t *xattr = NULL;
@@ -163,6 +164,7 @@ bitd_signature_staleness (xlator_t *this,
          */
         *stale = signptr->stale ? 1 : 0;
         *version = signptr->version;
+        *signtype = signptr->signaturetype;
 
         dict_unref (xattr);
 
@@ -177,11 +179,12 @@ bitd_signature_staleness (xlator_t *this,
  * An object is skipped if:
  *  - it's already marked corrupted
  *  - has stale signature
+ *  - is signed with a hash this scrubber does not know
  */
 int32_t
 bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
                               fd_t *fd, unsigned long *version,
-                              br_scrub_stats_t *scrub_stat,
+                              int8_t *signtype, br_scrub_stats_t *scrub_stat,
                               gf_boolean_t skip_stat)
 {
         int     stale = 0;
@@ -195,7 +198,7 @@ bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
         }
 
         ret = bitd_signature_staleness (this, child, fd, &stale, version,
-                                        scrub_stat, skip_stat);
+                                        signtype, scrub_stat, skip_stat);
         if (!ret && stale) {
                 if (!skip_stat)
                         br_inc_unsigned_file_count (scrub_stat);
@@ -205,6 +208,14 @@ bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
                 ret = -1;
         }
 
+        if (!ret && !br_hash_length (*signtype)) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        BRB_MSG_UNKNOWN_SIGNATURE_TYPE, "Object [GFID: %s] is "
+                        "signed with unknown signature type %d, skipping..",
+                        uuid_utoa (fd->inode->gfid), *signtype);
+                ret = -1;
+        }
+
  out:
         return ret;
 }
@@ -227,8 +238,8 @@ bitd_compare_ckum (xlator_t *this,
         GF_VALIDATE_OR_GOTO (this->name, md, out);
         GF_VALIDATE_OR_GOTO (this->name, entry, out);
 
-        if (strncmp
-            (sign->signature, (char *) md, strlen (sign->signature)) == 0) {
+        if ((sign->signaturelen == br_hash_length (sign->signaturetype)) &&
+            (memcmp (sign->signature, md, sign->signaturelen) == 0)) {
                 gf_msg_debug (this->name, 0, "%s [GFID: %s | Brick: %s] "
                               "matches calculated checksum", loc->path,
                               uuid_utoa (linked_inode->gfid),
@@ -279,9 +290,8 @@ bitd_compare_ckum (xlator_t *this,
 /**
  * "The Scrubber"
  *
- * Perform signature validation for a given object with the assumption
- * that the signature is SHA256 (because signer as of now _always_
- * signs with SHA256).
+ * Perform signature validation for a given object, hashing it with the
+ * signature type the signer recorded in the object's signature.
  */
 int
 br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
@@ -297,6 +307,7 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
         inode_t               *linked_inode  = NULL;
         br_isignature_out_t   *sign          = NULL;
         unsigned long          signedversion = 0;
+        int8_t                 signtype      = 0;
         gf_dirent_t           *entry         = NULL;
         br_private_t          *priv          = NULL;
         loc_t                 *parent        = NULL;
@@ -384,17 +395,18 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
          *  - signature staleness
          */
         ret = bitd_scrub_pre_compute_check (this, child, fd, &signedversion,
-                                            &priv->scrub_stat, skip_stat);
+                                            &signtype, &priv->scrub_stat,
+                                            skip_stat);
         if (ret)
                 goto unrefd; /* skip this object */
 
         /* if all's good, proceed to calculate the hash */
-        md = GF_CALLOC (SHA256_DIGEST_LENGTH, sizeof (*md),
+        md = GF_CALLOC (BR_HASH_MAX_LENGTH, sizeof (*md),
                         gf_common_mt_char);
         if (!md)
                 goto unrefd;
 
-        ret = br_calculate_obj_checksum (md, child, fd, &iatt);
+        ret = br_calculate_obj_checksum (md, child, fd, &iatt, signtype);
         if (ret) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_CALC_ERROR,
                         "error calculating hash for object [GFID: %s]",
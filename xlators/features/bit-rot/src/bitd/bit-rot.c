@@ -267,76 +267,207 @@ out:
         return ret;
 }
 
+size_t
+br_hash_length (int8_t type)
+{
+        switch (type) {
+        case BR_SIGNATURE_TYPE_SHA256:
+                return SHA256_DIGEST_LENGTH;
+        case BR_SIGNATURE_TYPE_XXH64:
+                return sizeof (GF_XXH64_canonical_t);
+        default:
+                return 0;
+        }
+}
+
+static int32_t
+br_hash_init (br_hash_ctx_t *hash, int8_t type)
+{
+        hash->type = type;
+
+        switch (type) {
+        case BR_SIGNATURE_TYPE_SHA256:
+                SHA256_Init (&hash->sha256);
+                return 0;
+        case BR_SIGNATURE_TYPE_XXH64:
+                hash->xxh64 = GF_XXH64_createState ();
+                if (!hash->xxh64)
+                        return -1;
+                (void) GF_XXH64_reset (hash->xxh64, 0);
+                return 0;
+        default:
+                return -1;
+        }
+}
+
+static void
+br_hash_update (br_hash_ctx_t *hash, const void *buf, size_t len)
+{
+        if (hash->type == BR_SIGNATURE_TYPE_XXH64)
+                (void) GF_XXH64_update (hash->xxh64, buf, len);
+        else
+                SHA256_Update (&hash->sha256, buf, len);
+}
+
+static void
+br_hash_final (br_hash_ctx_t *hash, unsigned char *md)
+{
+        GF_XXH64_canonical_t canonical;
+
+        if (hash->type == BR_SIGNATURE_TYPE_XXH64) {
+                GF_XXH64_canonicalFromHash
+                        (&canonical, GF_XXH64_digest (hash->xxh64));
+                memcpy (md, canonical.digest, sizeof (canonical.digest));
+        } else {
+                SHA256_Final (md, &hash->sha256);
+        }
+}
+
+static void
+br_hash_fini (br_hash_ctx_t *hash)
+{
+        if (hash->xxh64)
+                (void) GF_XXH64_freeState (hash->xxh64);
+        hash->xxh64 = NULL;
+}
+
 /**
- * read 128k block from the object @object from the offset @offset
- * and return the buffer.
+ * a block of the object being checksummed. reads are wound without
+ * waiting so that the next block is fetched from the brick while the
+ * current one is hashed.
  */
+struct br_read_block {
+        pthread_mutex_t  lock;
+        pthread_cond_t   cond;
+        gf_boolean_t     pending;       /* read is in flight */
+
+        int32_t          op_ret;
+        int32_t          op_errno;
+        struct iovec    *vector;
+        int              count;
+        struct iobref   *iobref;
+};
+
 static int32_t
-br_object_read_block_and_sign (xlator_t *this, fd_t *fd, br_child_t *child,
-                               off_t offset, size_t size, SHA256_CTX *sha256)
+br_object_read_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                    int32_t count, struct iatt *stbuf, struct iobref *iobref,
+                    dict_t *xdata)
 {
-        int32_t        ret    = -1;
-        tbf_t      *tbf    = NULL;
-        struct iovec  *iovec  = NULL;
-        struct iobref *iobref = NULL;
-        br_private_t  *priv   = NULL;
-        int            count  = 0;
-        int            i      = 0;
+        struct br_read_block *block = cookie;
+
+        if (op_ret > 0) {
+                block->vector = iov_dup (vector, count);
+                if (!block->vector) {
+                        op_ret = -1;
+                        op_errno = ENOMEM;
+                } else {
+                        block->count = count;
+                        if (iobref)
+                                block->iobref = iobref_ref (iobref);
+                }
+        }
 
-        GF_VALIDATE_OR_GOTO ("bit-rot", this, out);
-        GF_VALIDATE_OR_GOTO (this->name, fd, out);
-        GF_VALIDATE_OR_GOTO (this->name, fd->inode, out);
-        GF_VALIDATE_OR_GOTO (this->name, child, out);
-        GF_VALIDATE_OR_GOTO (this->name, this->private, out);
+        STACK_DESTROY (frame->root);
 
-        priv = this->private;
+        pthread_mutex_lock (&block->lock);
+        {
+                block->op_ret = op_ret;
+                block->op_errno = op_errno;
+                block->pending = _gf_false;
+                pthread_cond_signal (&block->cond);
+        }
+        pthread_mutex_unlock (&block->lock);
 
-        GF_VALIDATE_OR_GOTO (this->name, priv->tbf, out);
-        tbf = priv->tbf;
+        return 0;
+}
 
-        ret = syncop_readv (child->xl, fd,
-                            size, offset, 0, &iovec, &count, &iobref, NULL,
-                            NULL, NULL);
+static int32_t
+br_object_read_start (xlator_t *this, br_child_t *child, fd_t *fd,
+                      off_t offset, size_t size, struct br_read_block *block)
+{
+        call_frame_t *frame = NULL;
 
-        if (ret < 0) {
-                gf_msg (this->name, GF_LOG_ERROR, errno, BRB_MSG_READV_FAILED,
-                        "readv on %s failed", uuid_utoa (fd->inode->gfid));
-                ret = -1;
-                goto out;
-        }
+        frame = syncop_create_frame (this);
+        if (!frame)
+                return -1;
 
-        if (ret == 0)
-                goto out;
+        block->pending = _gf_true;
+        block->op_ret = -1;
+        block->op_errno = 0;
 
-        for (i = 0; i < count; i++) {
-                TBF_THROTTLE_BEGIN (tbf, TBF_OP_HASH, iovec[i].iov_len);
-                {
-                        SHA256_Update (sha256, (const unsigned char *)
-                                       (iovec[i].iov_base), iovec[i].iov_len);
-                }
-                TBF_THROTTLE_BEGIN (tbf, TBF_OP_HASH, iovec[i].iov_len);
+        STACK_WIND_COOKIE (frame, br_object_read_cbk, block, child->xl,
+                           child->xl->fops->readv, fd, size, offset, 0, NULL);
+
+        return 0;
+}
+
+static int32_t
+br_object_read_wait (struct br_read_block *block)
+{
+        pthread_mutex_lock (&block->lock);
+        {
+                while (block->pending)
+                        pthread_cond_wait (&block->cond, &block->lock);
         }
+        pthread_mutex_unlock (&block->lock);
 
- out:
-        if (iovec)
-                GF_FREE (iovec);
+        errno = block->op_errno;
+        return block->op_ret;
+}
 
-        if (iobref)
-                iobref_unref (iobref);
+static void
+br_object_read_release (struct br_read_block *block)
+{
+        GF_FREE (block->vector);
+        block->vector = NULL;
+        block->count = 0;
 
-        return ret;
+        if (block->iobref)
+                iobref_unref (block->iobref);
+        block->iobref = NULL;
 }
 
-int32_t
-br_calculate_obj_checksum (unsigned char *md,
-                           br_child_t *child, fd_t *fd, struct iatt *iatt)
+/**
+ * feed a block that was read from the object to the running checksum.
+ */
+static void
+br_object_hash_block (xlator_t *this, br_hash_ctx_t *hash,
+                      struct br_read_block *block)
 {
-        int32_t   ret    = -1;
-        off_t     offset = 0;
-        size_t    block  = BR_HASH_CALC_READ_SIZE;
-        xlator_t *this   = NULL;
+        br_private_t *priv = this->private;
+        int           i    = 0;
+
+        for (i = 0; i < block->count; i++) {
+                TBF_THROTTLE_BEGIN (priv->tbf, TBF_OP_HASH,
+                                    block->vector[i].iov_len);
+                {
+                        br_hash_update (hash, block->vector[i].iov_base,
+                                        block->vector[i].iov_len);
+                }
+                TBF_THROTTLE_END (priv->tbf, TBF_OP_HASH,
+                                  block->vector[i].iov_len);
+        }
+}
 
-        SHA256_CTX       sha256;
+/**
+ * Checksum the object in 128k blocks, always keeping the read of the next
+ * block in flight while the current one is hashed. Cancellation is held
+ * off as the in flight read refers to this thread's stack; scrubbers being
+ * scaled down exit once the object is done.
+ */
+int32_t
+br_calculate_obj_checksum (unsigned char *md, br_child_t *child,
+                           fd_t *fd, struct iatt *iatt, int8_t hashtype)
+{
+        int32_t              ret         = -1;
+        off_t                offset      = 0;
+        size_t               block       = BR_HASH_CALC_READ_SIZE;
+        xlator_t            *this        = NULL;
+        br_hash_ctx_t        hash        = {0, };
+        struct br_read_block blocks[2];
+        int                  cur         = 0;
+        int                  cancelstate = 0;
 
         GF_VALIDATE_OR_GOTO ("bit-rot", child, out);
         GF_VALIDATE_OR_GOTO ("bit-rot", iatt, out);
@@ -344,16 +475,37 @@ br_calculate_obj_checksum (unsigned char *md,
 
         this = child->this;
 
-        SHA256_Init (&sha256);
+        GF_VALIDATE_OR_GOTO (this->name, this->private, out);
 
-        while (1) {
-                ret = br_object_read_block_and_sign (this, fd, child,
-                                                     offset, block, &sha256);
+        ret = br_hash_init (&hash, hashtype);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        BRB_MSG_UNKNOWN_SIGNATURE_TYPE, "cannot checksum "
+                        "object %s with signature type %d",
+                        uuid_utoa (fd->inode->gfid), hashtype);
+                goto out;
+        }
+
+        memset (blocks, 0, sizeof (blocks));
+        for (cur = 0; cur < 2; cur++) {
+                pthread_mutex_init (&blocks[cur].lock, NULL);
+                pthread_cond_init (&blocks[cur].cond, NULL);
+        }
+
+        (void) pthread_setcancelstate (PTHREAD_CANCEL_DISABLE, &cancelstate);
+
+        cur = 0;
+        ret = br_object_read_start (this, child, fd, offset, block,
+                                    &blocks[cur]);
+
+        while (ret == 0) {
+                ret = br_object_read_wait (&blocks[cur]);
                 if (ret < 0) {
-                        gf_msg (this->name, GF_LOG_ERROR, 0,
-                                BRB_MSG_BLOCK_READ_FAILED, "reading block with "
-                                "offset %lu of object %s failed", offset,
-                                uuid_utoa (fd->inode->gfid));
+                        gf_msg (this->name, GF_LOG_ERROR, errno,
+                                BRB_MSG_BLOCK_READ_FAILED, "reading block "
+                                "with offset %lu of object %s failed",
+                                offset, uuid_utoa (fd->inode->gfid));
+                        ret = -1;
                         break;
                 }
 
@@ -361,20 +513,39 @@ br_calculate_obj_checksum (unsigned char *md,
                         break;
 
                 offset += ret;
+
+                ret = br_object_read_start (this, child, fd, offset, block,
+                                            &blocks[!cur]);
+
+                br_object_hash_block (this, &hash, &blocks[cur]);
+                br_object_read_release (&blocks[cur]);
+
+                cur = !cur;
         }
 
+        br_object_read_release (&blocks[cur]);
+
+        (void) pthread_setcancelstate (cancelstate, NULL);
+
         if (ret == 0)
-                SHA256_Final (md, &sha256);
+                br_hash_final (&hash, md);
+
+        for (cur = 0; cur < 2; cur++) {
+                pthread_mutex_destroy (&blocks[cur].lock);
+                pthread_cond_destroy (&blocks[cur].cond);
+        }
 
  out:
+        br_hash_fini (&hash);
         return ret;
 }
 
 static int32_t
-br_object_checksum (unsigned char *md,
-                    br_object_t *object, fd_t *fd, struct iatt *iatt)
+br_object_checksum (unsigned char *md, br_object_t *object, fd_t *fd,
+                    struct iatt *iatt, int8_t hashtype)
 {
-        return br_calculate_obj_checksum (md, object->child, fd,  iatt);
+        return br_calculate_obj_checksum (md, object->child, fd, iatt,
+                                          hashtype);
 }
 
 static int32_t
@@ -386,14 +557,21 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
         dict_t          *xattr         = NULL;
         unsigned char   *md            = NULL;
         br_isignature_t *sign          = NULL;
+        br_private_t    *priv          = NULL;
+        int8_t           hashtype      = 0;
+        size_t           hashlen       = 0;
 
         GF_VALIDATE_OR_GOTO ("bit-rot", object, out);
         GF_VALIDATE_OR_GOTO ("bit-rot", linked_inode, out);
         GF_VALIDATE_OR_GOTO ("bit-rot", fd, out);
 
         this = object->this;
+        priv = this->private;
+
+        hashtype = priv->signature_type;
+        hashlen = br_hash_length (hashtype);
 
-        md = GF_CALLOC (SHA256_DIGEST_LENGTH, sizeof (*md), gf_common_mt_char);
+        md = GF_CALLOC (BR_HASH_MAX_LENGTH, sizeof (*md), gf_common_mt_char);
         if (!md) {
                 gf_msg (this->name, GF_LOG_ERROR, ENOMEM, BRB_MSG_NO_MEMORY,
                         "failed to allocate memory for saving hash of the "
@@ -401,7 +579,7 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
                 goto out;
         }
 
-        ret = br_object_checksum (md, object, fd, iatt);
+        ret = br_object_checksum (md, object, fd, iatt, hashtype);
         if (ret) {
                 gf_msg (this->name, GF_LOG_ERROR, 0,
                         BRB_MSG_CALC_CHECKSUM_FAILED, "calculating checksum "
@@ -410,8 +588,7 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
                 goto free_signature;
         }
 
-        sign = br_prepare_signature (md, SHA256_DIGEST_LENGTH,
-                                     BR_SIGNATURE_TYPE_SHA256, object);
+        sign = br_prepare_signature (md, hashlen, hashtype, object);
         if (!sign) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_GET_SIGN_FAILED,
                         "failed to get the signature for the object %s",
@@ -421,7 +598,7 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
 
         xattr = dict_for_key_value
                 (GLUSTERFS_SET_OBJECT_SIGNATURE,
-                 (void *)sign, signature_size (SHA256_DIGEST_LENGTH), _gf_true);
+                 (void *)sign, signature_size (hashlen), _gf_true);
 
         if (!xattr) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_SET_SIGN_FAILED,
@@ -629,6 +806,14 @@ static int32_t br_sign_object (br_object_t *object)
         return ret;
 }
 
+static void
+br_lock_cleaner (void *arg)
+{
+        pthread_mutex_t *mutex = arg;
+
+        pthread_mutex_unlock (mutex);
+}
+
 static br_object_t *__br_pick_object (br_private_t *priv)
 {
         br_object_t *object = NULL;
@@ -661,18 +846,29 @@ br_process_object (void *arg)
         THIS = this;
 
         for (;;) {
+                /**
+                 * workers are cancelled when "signer-threads" is lowered,
+                 * which is only allowed while waiting for an object.
+                 */
+                pthread_cleanup_push (br_lock_cleaner, &priv->lock);
                 pthread_mutex_lock (&priv->lock);
                 {
                         object = __br_pick_object (priv);
                 }
                 pthread_mutex_unlock (&priv->lock);
+                pthread_cleanup_pop (0);
 
-                ret = br_sign_object (object);
-                if (ret && !br_object_sign_softerror (-ret))
-                        gf_msg (this->name, GF_LOG_ERROR, 0,
-                                BRB_MSG_SIGN_FAILED, "SIGNING FAILURE [%s]",
-                                uuid_utoa (object->gfid));
-                GF_FREE (object);
+                _mask_cancellation ();
+                {
+                        ret = br_sign_object (object);
+                        if (ret && !br_object_sign_softerror (-ret))
+                                gf_msg (this->name, GF_LOG_ERROR, 0,
+                                        BRB_MSG_SIGN_FAILED,
+                                        "SIGNING FAILURE [%s]",
+                                        uuid_utoa (object->gfid));
+                        GF_FREE (object);
+                }
+                _unmask_cancellation ();
         }
 
         return NULL;
@@ -1724,24 +1920,69 @@ br_fini_signer (xlator_t *this, br_private_t *priv)
 {
         int i = 0;
 
-        for (; i < BR_WORKERS; i++) {
+        for (; i < priv->obj_queue->nr_workers; i++) {
                 (void) gf_thread_cleanup_xint (priv->obj_queue->workers[i]);
         }
 
         pthread_cond_destroy (&priv->object_cond);
 }
 
+/**
+ * grow or shrink the pool of signer threads to @nr_workers. new threads
+ * pick up queued objects right away, threads going away finish the object
+ * they are signing before exiting.
+ */
+static int32_t
+br_scale_signer (xlator_t *this, br_private_t *priv, int nr_workers)
+{
+        int32_t             ret       = 0;
+        br_obj_n_workers_t *obj_queue = priv->obj_queue;
+
+        if (obj_queue->nr_workers == nr_workers)
+                return 0;
+
+        gf_msg (this->name, GF_LOG_INFO, 0, BRB_MSG_SCALING_SIGNER,
+                "Scaling signer threads [%d => %d]",
+                obj_queue->nr_workers, nr_workers);
+
+        while (obj_queue->nr_workers < nr_workers) {
+                ret = gf_thread_create
+                        (&obj_queue->workers[obj_queue->nr_workers], NULL,
+                         br_process_object, this, "brpobj");
+                if (ret != 0) {
+                        gf_msg (this->name, GF_LOG_ERROR, -ret,
+                                BRB_MSG_SPAWN_FAILED, "thread creation"
+                                " failed");
+                        return -1;
+                }
+                obj_queue->nr_workers++;
+        }
+
+        while (obj_queue->nr_workers > nr_workers) {
+                obj_queue->nr_workers--;
+                (void) gf_thread_cleanup_xint
+                        (obj_queue->workers[obj_queue->nr_workers]);
+        }
+
+        return 0;
+}
+
 static int32_t
 br_init_signer (xlator_t *this, br_private_t *priv)
 {
-        int i = 0;
         int32_t ret = -1;
+        int nr_workers = 0;
 
         /* initialize gfchangelog xlator context */
         ret = gf_changelog_init (this);
         if (ret)
                 goto out;
 
+        GF_OPTION_INIT ("signer-threads", nr_workers, int32, out);
+
+        /* until br_signer_handle_options () has parsed "signature-type" */
+        priv->signature_type = BR_SIGNATURE_TYPE_SHA256;
+
         pthread_cond_init (&priv->object_cond, NULL);
 
         priv->obj_queue = GF_CALLOC (1, sizeof (*priv->obj_queue),
@@ -1750,24 +1991,14 @@ br_init_signer (xlator_t *this, br_private_t *priv)
                 goto cleanup_cond;
         INIT_LIST_HEAD (&priv->obj_queue->objects);
 
-        for (i = 0; i < BR_WORKERS; i++) {
-                ret = gf_thread_create (&priv->obj_queue->workers[i], NULL,
-                                        br_process_object, this, "brpobj");
-                if (ret != 0) {
-                        gf_msg (this->name, GF_LOG_ERROR, -ret,
-                                BRB_MSG_SPAWN_FAILED, "thread creation"
-                                " failed");
-                        ret = -1;
-                        goto cleanup_threads;
-                }
-        }
+        ret = br_scale_signer (this, priv, nr_workers);
+        if (ret)
+                goto cleanup_threads;
 
         return 0;
 
  cleanup_threads:
-        for (i--; i >= 0; i--) {
-                (void) gf_thread_cleanup_xint (priv->obj_queue->workers[i]);
-        }
+        (void) br_scale_signer (this, priv, 0);
 
         GF_FREE (priv->obj_queue);
 
@@ -1836,15 +2067,49 @@ br_rate_limit_signer (xlator_t *this, int child_count, int numbricks)
         return priv->tbf ? 0 : -1;
 }
 
+static int8_t
+br_signature_type_from_str (char *str)
+{
+        if (strcasecmp (str, "sha256") == 0)
+                return BR_SIGNATURE_TYPE_SHA256;
+        if (strcasecmp (str, "xxh64") == 0)
+                return BR_SIGNATURE_TYPE_XXH64;
+
+        return BR_SIGNATURE_TYPE_VOID;
+}
+
 static int32_t
 br_signer_handle_options (xlator_t *this, br_private_t *priv, dict_t *options)
 {
-        if (options)
+        char *signtype   = NULL;
+        int   nr_workers = 0;
+
+        if (options) {
                 GF_OPTION_RECONF ("expiry-time", priv->expiry_time,
                                   options, uint32, error_return);
-        else
+                GF_OPTION_RECONF ("signature-type", signtype,
+                                  options, str, error_return);
+                GF_OPTION_RECONF ("signer-threads", nr_workers,
+                                  options, int32, error_return);
+        } else {
                 GF_OPTION_INIT ("expiry-time", priv->expiry_time,
                                 uint32, error_return);
+                GF_OPTION_INIT ("signature-type", signtype,
+                                str, error_return);
+                GF_OPTION_INIT ("signer-threads", nr_workers,
+                                int32, error_return);
+        }
+
+        priv->signature_type = br_signature_type_from_str (signtype);
+        if (!br_is_signature_type_valid (priv->signature_type)) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        BRB_MSG_UNKNOWN_SIGNATURE_TYPE,
+                        "unknown signature type %s", signtype);
+                goto error_return;
+        }
+
+        if (br_scale_signer (this, priv, nr_workers))
+                goto error_return;
 
         return 0;
 
@@ -2153,6 +2418,28 @@ struct volume_options options[] = {
           .description = "Waiting time for an object on which it waits "
                          "before it is signed",
         },
+        { .key = {"signer-threads"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 1,
+          .max = BR_MAX_WORKERS,
+          .default_value = "4",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE,
+          .description = "Number of threads signing objects. Each of them "
+                         "checksums one object at a time.",
+        },
+        { .key = {"signature-type"},
+          .type = GF_OPTION_TYPE_STR,
+          .value = {"sha256", "xxh64"},
+          .default_value = "sha256",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE,
+          .description = "Hash used to sign objects. xxh64 is a lot cheaper "
+                         "to compute but is not cryptographically secure, it "
+                         "only detects accidental corruption. Objects keep "
+                         "the type they were signed with until re-signed, "
+                         "the scrubber verifies each with its own type.",
+        },
         { .key = {"brick-count"},
           .type = GF_OPTION_TYPE_STR,
           .description = "Total number of bricks for the current node for "
@@ -29,12 +29,17 @@
 #include "bit-rot-scrub-status.h"
 
 #include <openssl/sha.h>
+#include "xxhash.h"
 
 /**
- * TODO: make this configurable. As a best practice, set this to the
- * number of processor cores.
+ * default number of signer threads, tunable with "signer-threads". As a
+ * best practice, set this to the number of processor cores.
  */
 #define BR_WORKERS 4
+#define BR_MAX_WORKERS 64
+
+/* largest digest of all supported signature types (SHA256) */
+#define BR_HASH_MAX_LENGTH SHA256_DIGEST_LENGTH
 
 typedef enum scrub_throttle {
         BR_SCRUB_THROTTLE_VOID       = -1,
@@ -111,11 +116,19 @@ struct br_obj_n_workers {
         struct list_head objects;         /* queue of objects expired from the
                                              timer wheel and ready to be picked
                                              up for signing */
-        pthread_t workers[BR_WORKERS];    /* Threads which pick up the objects
-                                             from the above queue and start
-                                             signing each object */
+        pthread_t workers[BR_MAX_WORKERS]; /* Threads which pick up the
+                                              objects from the above queue
+                                              and start signing each object */
+        int nr_workers;                    /* number of running workers */
 };
 
+/* running checksum of an object, for any of the signature types */
+typedef struct br_hash_ctx {
+        int8_t            type;
+        SHA256_CTX        sha256;
+        GF_XXH64_state_t *xxh64;
+} br_hash_ctx_t;
+
 struct br_scrubber {
         xlator_t *this;
 
@@ -209,6 +222,8 @@ struct br_private {
 
         uint32_t expiry_time;              /* objects "wait" time */
 
+        int8_t signature_type;             /* hash used to sign objects */
+
         tbf_t *tbf;                    /* token bucket filter */
 
         gf_boolean_t iamscrubber;         /* function as a fs scrubber */
@@ -245,9 +260,12 @@ br_log_object (xlator_t *, char *, uuid_t, int32_t);
 void
 br_log_object_path (xlator_t *, char *, const char *, int32_t);
 
+size_t
+br_hash_length (int8_t);
+
 int32_t
 br_calculate_obj_checksum (unsigned char *,
-                           br_child_t *, fd_t *, struct iatt *);
+                           br_child_t *, fd_t *, struct iatt *, int8_t);
 
 int32_t
 br_prepare_loc (xlator_t *, br_child_t *, loc_t *, gf_dirent_t *, loc_t *);
@@ -121,7 +121,8 @@ typedef enum {
         BR_SIGNATURE_TYPE_VOID   = -1,   /* object is not signed       */
         BR_SIGNATURE_TYPE_ZERO   = 0,    /* min boundary               */
         BR_SIGNATURE_TYPE_SHA256 = 1,    /* signed with SHA256         */
-        BR_SIGNATURE_TYPE_MAX    = 2,    /* max boundary               */
+        BR_SIGNATURE_TYPE_XXH64  = 2,    /* signed with xxHash64       */
+        BR_SIGNATURE_TYPE_MAX    = 3,    /* max boundary               */
 } br_signature_type;
 
 /* BitRot stub start time (virtual xattr) */
@@ -2075,6 +2075,143 @@ br_stub_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         return 0;
 }
 
+int32_t
+br_stub_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                             xlator_t *this, int32_t op_ret, int32_t op_errno,
+                             struct iatt *stbuf, struct iatt *prebuf_dst,
+                             struct iatt *postbuf_dst, dict_t *xdata)
+{
+        int32_t            ret   = 0;
+        br_stub_local_t   *local = NULL;
+
+        local = frame->local;
+        frame->local = NULL;
+
+        if (op_ret < 0)
+                goto unwind;
+
+        ret = br_stub_mark_inode_modified (this, local);
+        if (ret) {
+                op_ret = -1;
+                op_errno = EINVAL;
+        }
+
+unwind:
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno, stbuf,
+                             prebuf_dst, postbuf_dst, xdata);
+
+        br_stub_cleanup_local (local);
+        br_stub_dealloc_local (local);
+
+        return 0;
+}
+
+int32_t
+br_stub_copy_file_range_resume (call_frame_t *frame, xlator_t *this,
+                                fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                                off_t off_out, size_t len, uint32_t flags,
+                                dict_t *xdata)
+{
+        STACK_WIND (frame, br_stub_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+        return 0;
+}
+
+/**
+ * The destination is versioned exactly like for writev(), a bad source
+ * object is refused like for readv().
+ */
+int32_t
+br_stub_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                         off_t off_in, fd_t *fd_out, off_t off_out,
+                         size_t len, uint32_t flags, dict_t *xdata)
+{
+        call_stub_t                 *stub        = NULL;
+        int32_t                      op_ret      = -1;
+        int32_t                      op_errno    = EINVAL;
+        gf_boolean_t                 inc_version = _gf_false;
+        gf_boolean_t                 modified    = _gf_false;
+        br_stub_inode_ctx_t         *ctx         = NULL;
+        int32_t                      ret         = -1;
+        fop_copy_file_range_cbk_t    cbk = default_copy_file_range_cbk;
+        br_stub_local_t             *local       = NULL;
+        br_stub_private_t           *priv        = NULL;
+
+        GF_VALIDATE_OR_GOTO ("bit-rot-stub", this, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, this->private, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, frame, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, fd_in, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, fd_out, unwind);
+
+        priv = this->private;
+        if (!priv->do_versioning)
+                goto wind;
+
+        ret = br_stub_check_bad_object (this, fd_in->inode, &op_ret,
+                                        &op_errno);
+        if (ret)
+                goto unwind;
+
+        ret = br_stub_need_versioning (this, fd_out, &inc_version, &modified,
+                                       &ctx);
+        if (ret)
+                goto unwind;
+
+        ret = br_stub_check_bad_object (this, fd_out->inode, &op_ret,
+                                        &op_errno);
+        if (ret)
+                goto unwind;
+
+        if (!inc_version && modified)
+                goto wind;
+
+        ret = br_stub_versioning_prep (frame, this, fd_out, ctx);
+        if (ret)
+                goto unwind;
+
+        local = frame->local;
+        if (!inc_version) {
+                br_stub_fill_local (local, NULL, fd_out, fd_out->inode,
+                                    fd_out->inode->gfid,
+                                    BR_STUB_NO_VERSIONING, 0);
+                cbk = br_stub_copy_file_range_cbk;
+                goto wind;
+        }
+
+        stub = fop_copy_file_range_stub (frame,
+                                         br_stub_copy_file_range_resume,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags, xdata);
+        if (!stub) {
+                gf_msg (this->name, GF_LOG_ERROR, 0, BRS_MSG_STUB_ALLOC_FAILED,
+                        "failed to allocate stub for copy_file_range fop "
+                        "(gfid: %s), unwinding",
+                        uuid_utoa (fd_out->inode->gfid));
+                goto cleanup_local;
+        }
+
+        /* Perform Versioning */
+        return br_stub_perform_incversioning (this, frame, stub, fd_out, ctx);
+
+ wind:
+        STACK_WIND (frame, cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+        return 0;
+
+ cleanup_local:
+        br_stub_cleanup_local (local);
+        br_stub_dealloc_local (local);
+
+ unwind:
+        frame->local = NULL;
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno, NULL,
+                             NULL, NULL, NULL);
+
+        return 0;
+}
+
 int32_t
 br_stub_ftruncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                        int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
@@ -3487,6 +3624,7 @@ struct xlator_fops fops = {
         .fgetxattr = br_stub_fgetxattr,
         .fsetxattr = br_stub_fsetxattr,
         .writev    = br_stub_writev,
+        .copy_file_range = br_stub_copy_file_range,
         .truncate  = br_stub_truncate,
         .ftruncate = br_stub_ftruncate,
         .mknod     = br_stub_mknod,
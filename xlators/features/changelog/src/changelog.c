@@ -1869,6 +1869,62 @@ changelog_writev (call_frame_t *frame,
         return 0;
 }
 
+/* copy_file_range() */
+
+int32_t
+changelog_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                               xlator_t *this, int32_t op_ret,
+                               int32_t op_errno, struct iatt *stbuf,
+                               struct iatt *prebuf_dst,
+                               struct iatt *postbuf_dst, dict_t *xdata)
+{
+        changelog_priv_t  *priv  = NULL;
+        changelog_local_t *local = NULL;
+
+        priv  = this->private;
+        local = frame->local;
+
+        CHANGELOG_COND_GOTO (priv, ((op_ret <= 0) || !local), unwind);
+
+        changelog_update (this, priv, local, CHANGELOG_TYPE_DATA);
+
+ unwind:
+        changelog_dec_fop_cnt (this, priv, local);
+        CHANGELOG_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno,
+                                stbuf, prebuf_dst, postbuf_dst, xdata);
+        return 0;
+}
+
+int32_t
+changelog_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                           off_t off_in, fd_t *fd_out, off_t off_out,
+                           size_t len, uint32_t flags, dict_t *xdata)
+{
+        changelog_priv_t *priv = NULL;
+
+        priv = this->private;
+        CHANGELOG_NOT_ACTIVE_THEN_GOTO (frame, priv, wind);
+
+        CHANGELOG_INIT (this, frame->local,
+                        fd_out->inode, fd_out->inode->gfid, 0);
+        LOCK(&priv->c_snap_lock);
+        {
+                if (priv->c_snap_fd != -1 &&
+                    priv->barrier_enabled == _gf_true) {
+                        changelog_snap_handle_ascii_change (this,
+                              &( ((changelog_local_t *)(frame->local))->cld));
+                }
+        }
+        UNLOCK(&priv->c_snap_lock);
+
+ wind:
+        changelog_color_fop_and_inc_cnt (this, priv, frame->local);
+        STACK_WIND (frame, changelog_copy_file_range_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+        return 0;
+}
+
 /* }}} */
 
 /* open, release and other beasts */
@@ -2934,6 +2990,7 @@ struct xlator_fops fops = {
         .create       = changelog_create,
         .symlink      = changelog_symlink,
         .writev       = changelog_writev,
+        .copy_file_range = changelog_copy_file_range,
         .truncate     = changelog_truncate,
         .ftruncate    = changelog_ftruncate,
         .link         = changelog_link,
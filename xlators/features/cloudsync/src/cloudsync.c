@@ -1570,6 +1570,20 @@ cs_resume_postprocess (xlator_t *this, call_frame_t *frame, inode_t *inode)
 out:
         return ret;
 }
+
+
+/* The data of a file may only be in the remote store, the bricks can not
+ * copy it. Make the caller read it through cloudsync. */
+int32_t
+cs_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+        default_copy_file_range_failure_cbk (frame, EXDEV);
+        return 0;
+}
+
+
 int32_t
 cs_fdctx_to_dict (xlator_t *this,
         fd_t *fd,
@@ -1683,6 +1697,7 @@ struct xlator_fops cs_fops = {
         .open                 = cs_open,
         .fstat                = cs_fstat,
         .zerofill             = cs_zerofill,
+        .copy_file_range      = cs_copy_file_range,
 };
 
 struct xlator_cbks cs_cbks = {
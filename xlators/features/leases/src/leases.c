@@ -859,6 +859,58 @@ err:
         return 0;
 }
 
+int32_t
+leases_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iatt *stbuf, struct iatt *prebuf_dst,
+                            struct iatt *postbuf_dst, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno, stbuf,
+                             prebuf_dst, postbuf_dst, xdata);
+
+        return 0;
+}
+
+int
+leases_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                        off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                        uint32_t flags, dict_t *xdata)
+{
+        uint32_t         fop_flags       = 0;
+        char            *lease_id        = NULL;
+        int              ret             = 0;
+
+        EXIT_IF_LEASES_OFF (this, out);
+
+        GET_LEASE_ID (xdata, lease_id, frame->root->client->client_uid);
+        GET_FLAGS (frame->root->op, fd_out->flags);
+
+        ret = check_lease_conflict (frame, fd_out->inode, lease_id, fop_flags);
+        if (ret < 0)
+                goto err;
+        else if (ret == BLOCK_FOP)
+                goto block;
+        else if (ret == WIND_FOP)
+                goto out;
+
+block:
+        LEASE_BLOCK_FOP (fd_out->inode, copy_file_range, frame, this,
+                         fd_in, off_in, fd_out, off_out, len, flags, xdata);
+        return 0;
+
+out:
+        STACK_WIND (frame, leases_copy_file_range_cbk,
+                    FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+        return 0;
+
+err:
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, errno, NULL, NULL,
+                             NULL, NULL);
+        return 0;
+}
+
 int
 leases_flush_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
               int32_t op_ret, int32_t op_errno, dict_t *xdata)
@@ -1139,6 +1191,7 @@ struct xlator_fops fops = {
         .ftruncate   = leases_ftruncate,
         .writev      = leases_writev,
         .zerofill    = leases_zerofill,
+        .copy_file_range = leases_copy_file_range,
         .fallocate   = leases_fallocate,
         .discard     = leases_discard,
         .lk          = leases_lk,
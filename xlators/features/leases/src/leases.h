@@ -64,7 +64,7 @@ do {                                                                           \
             fop == GF_FOP_WRITE || fop == GF_FOP_FALLOCATE ||                  \
             fop == GF_FOP_DISCARD || fop == GF_FOP_ZEROFILL ||                 \
             fop == GF_FOP_SETATTR || fop == GF_FOP_FSETATTR ||                 \
-            fop == GF_FOP_LINK)                                                \
+            fop == GF_FOP_LINK || fop == GF_FOP_COPY_FILE_RANGE)               \
                 fop_flags = DATA_MODIFY_FOP;                                   \
                                                                                \
         if (!(fd_flags & (O_NONBLOCK | O_NDELAY)))                             \
@@ -4974,6 +4974,205 @@ off:
         return 0;
 }
 
+int32_t
+quota_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                           int32_t op_ret, int32_t op_errno,
+                           struct iatt *stbuf, struct iatt *prebuf_dst,
+                           struct iatt *postbuf_dst, dict_t *xdata)
+{
+        int32_t                  ret            = 0;
+        uint64_t                 ctx_int        = 0;
+        quota_inode_ctx_t       *ctx            = NULL;
+        quota_local_t           *local          = NULL;
+
+        local = frame->local;
+
+        if ((op_ret < 0) || (local == NULL)) {
+                goto out;
+        }
+
+        ret = inode_ctx_get (local->loc.inode, this, &ctx_int);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        Q_MSG_INODE_CTX_GET_FAILED,
+                        "%s: failed to get the context", local->loc.path);
+                goto out;
+        }
+
+        ctx = (quota_inode_ctx_t *)(unsigned long) ctx_int;
+
+        if (ctx == NULL) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        Q_MSG_INODE_CTX_GET_FAILED,
+                        "quota context not set in %s (gfid:%s)",
+                        local->loc.path, uuid_utoa (local->loc.inode->gfid));
+                goto out;
+        }
+
+        LOCK (&ctx->lock);
+        {
+                ctx->buf = *postbuf_dst;
+        }
+        UNLOCK (&ctx->lock);
+
+out:
+        QUOTA_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno, stbuf,
+                            prebuf_dst, postbuf_dst, xdata);
+
+        return 0;
+}
+
+
+int32_t
+quota_copy_file_range_helper (call_frame_t *frame, xlator_t *this,
+                              fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                              off_t off_out, size_t len, uint32_t flags,
+                              dict_t *xdata)
+{
+        quota_local_t *local    = NULL;
+        int32_t        op_errno = EINVAL;
+
+        local = frame->local;
+
+        GF_VALIDATE_OR_GOTO ("quota", local, unwind);
+
+        if (local->op_ret == -1) {
+                op_errno = local->op_errno;
+                if (op_errno == ENOENT || op_errno == ESTALE) {
+                        /* see quota_fallocate_helper () */
+                        gf_msg_debug (this->name, 0, "quota enforcer failed "
+                                      "with ENOENT/ESTALE on %s, cannot check "
+                                      "quota limits and allowing "
+                                      "copy_file_range",
+                                      uuid_utoa (fd_out->inode->gfid));
+                } else {
+                        goto unwind;
+                }
+        }
+
+        STACK_WIND (frame, quota_copy_file_range_cbk,
+                    FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+        return 0;
+
+unwind:
+        QUOTA_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                            NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+quota_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                       off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                       uint32_t flags, dict_t *xdata)
+{
+        int32_t            op_errno    = EINVAL;
+        int32_t            parents     = 0;
+        int32_t            fail_count  = 0;
+        quota_local_t     *local       = NULL;
+        quota_inode_ctx_t *ctx         = NULL;
+        quota_priv_t      *priv        = NULL;
+        quota_dentry_t    *dentry      = NULL;
+        quota_dentry_t    *tmp         = NULL;
+        call_stub_t       *stub        = NULL;
+        struct list_head   head        = {0, };
+        inode_t           *par_inode   = NULL;
+
+        priv = this->private;
+        GF_VALIDATE_OR_GOTO (this->name, priv, unwind);
+
+        WIND_IF_QUOTAOFF (priv->is_quota_on, off);
+
+        INIT_LIST_HEAD (&head);
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO ("quota", this, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, fd_out, unwind);
+
+        local = quota_local_new ();
+        if (local == NULL) {
+                goto unwind;
+        }
+
+        frame->local = local;
+        local->loc.inode = inode_ref (fd_out->inode);
+
+        (void) quota_inode_ctx_get (fd_out->inode, this, &ctx, 0);
+        if (ctx == NULL) {
+                gf_msg_debug (this->name, 0, "quota context is NULL on inode"
+                              " (%s). If quota is not enabled recently and "
+                              "crawler has finished crawling, its an error",
+                              uuid_utoa (local->loc.inode->gfid));
+        }
+
+        stub = fop_copy_file_range_stub (frame, quota_copy_file_range_helper,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags, xdata);
+        if (stub == NULL) {
+                op_errno = ENOMEM;
+                goto unwind;
+        }
+
+        parents = quota_add_parents_from_ctx (ctx, &head);
+
+        /* like writev, assume the whole range is new data */
+        local->delta = len;
+        local->object_delta = 0;
+        local->stub = stub;
+        local->link_count = parents;
+
+        if (parents == 0) {
+                local->link_count = 1;
+                quota_check_limit (frame, fd_out->inode, this);
+        } else {
+                list_for_each_entry_safe (dentry, tmp, &head, next) {
+                        par_inode = do_quota_check_limit (frame,
+                                                          fd_out->inode,
+                                                          this, dentry,
+                                                          _gf_false);
+                        if (par_inode == NULL) {
+                                /* remove stale entry from inode_ctx */
+                                quota_dentry_del (ctx, dentry->name,
+                                                  dentry->par);
+                                parents--;
+                                fail_count++;
+                        } else {
+                                inode_unref (par_inode);
+                        }
+                        __quota_dentry_free (dentry);
+                }
+
+                if (parents == 0) {
+                        LOCK (&local->lock);
+                        {
+                                local->link_count++;
+                        }
+                        UNLOCK (&local->lock);
+                        quota_check_limit (frame, fd_out->inode, this);
+                }
+
+                while (fail_count != 0) {
+                        quota_link_count_decrement (frame);
+                        fail_count--;
+                }
+        }
+
+        return 0;
+
+unwind:
+        QUOTA_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                            NULL, NULL);
+        return 0;
+
+off:
+        STACK_WIND_TAIL (frame, FIRST_CHILD(this),
+                         FIRST_CHILD(this)->fops->copy_file_range, fd_in,
+                         off_in, fd_out, off_out, len, flags, xdata);
+        return 0;
+}
+
 void
 quota_log_helper (char **usage_str, int64_t cur_size, inode_t *inode,
                   char **path, struct timeval *cur_time)
@@ -5322,6 +5521,7 @@ struct xlator_fops fops = {
         .fremovexattr = quota_fremovexattr,
         .readdirp     = quota_readdirp,
 	.fallocate    = quota_fallocate,
+        .copy_file_range = quota_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
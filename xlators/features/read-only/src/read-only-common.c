@@ -210,6 +210,22 @@ ro_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
         return 0;
 }
 
+int32_t
+ro_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+        if (is_readonly_or_worm_enabled (frame, this))
+                STACK_UNWIND_STRICT (copy_file_range, frame, -1, EROFS, NULL,
+                                     NULL, NULL, xdata);
+        else
+                STACK_WIND_TAIL (frame, FIRST_CHILD (this),
+                                 FIRST_CHILD(this)->fops->copy_file_range,
+                                 fd_in, off_in, fd_out, off_out, len, flags,
+                                 xdata);
+        return 0;
+}
+
 
 int
 ro_mknod (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
@@ -117,6 +117,7 @@ struct xlator_fops fops = {
         .fentrylk    = ro_fentrylk,
         .lk          = ro_lk,
         .fallocate   = ro_fallocate,
+        .copy_file_range = ro_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
@@ -448,6 +448,42 @@ out:
         return 0;
 }
 
+static int32_t
+worm_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                      off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                      uint32_t flags, dict_t *xdata)
+{
+        read_only_priv_t *priv            =       NULL;
+        int op_errno                      =       EROFS;
+
+        priv = this->private;
+        GF_ASSERT (priv);
+        if (!priv->worm_file || (frame->root->pid < 0)) {
+                op_errno = 0;
+                goto out;
+        }
+        if (is_wormfile (this, _gf_true, fd_out)) {
+                op_errno = 0;
+                goto out;
+        }
+        op_errno = gf_worm_state_transition (this, _gf_true, fd_out,
+                                             GF_FOP_WRITE);
+
+out:
+        if (op_errno) {
+                if (op_errno < 0)
+                        op_errno = EROFS;
+                STACK_UNWIND_STRICT (copy_file_range, frame, -1, op_errno,
+                                     NULL, NULL, NULL, NULL);
+        }
+        else
+                STACK_WIND_TAIL (frame, FIRST_CHILD (this),
+                                 FIRST_CHILD (this)->fops->copy_file_range,
+                                 fd_in, off_in, fd_out, off_out, len, flags,
+                                 xdata);
+        return 0;
+}
+
 static int32_t
 worm_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                  int32_t op_ret, int32_t op_errno, fd_t *fd,
@@ -610,6 +646,7 @@ struct xlator_fops fops = {
         .unlink      = worm_unlink,
         .truncate    = worm_truncate,
         .ftruncate   = worm_ftruncate,
+        .copy_file_range = worm_copy_file_range,
         .create      = worm_create,
 
         .rmdir       = ro_rmdir,
@@ -15,6 +15,7 @@
 #include "byte-order.h"
 #include "defaults.h"
 #include "statedump.h"
+#include "upcall-utils.h"
 
 static gf_boolean_t
 __is_shard_dir (uuid_t gfid)
@@ -77,6 +78,7 @@ __shard_inode_ctx_get (inode_t *inode, xlator_t *this, shard_inode_ctx_t **ctx)
 
         INIT_LIST_HEAD (&ctx_p->ilist);
         INIT_LIST_HEAD (&ctx_p->to_fsync_list);
+        INIT_LIST_HEAD (&ctx_p->wb_waitq);
 
         ret = __inode_ctx_set (inode, this, (uint64_t *)&ctx_p);
         if (ret < 0) {
@@ -852,6 +854,10 @@ shard_common_failure_unwind (glusterfs_fop_t fop, call_frame_t *frame,
         case GF_FOP_SEEK:
                 SHARD_STACK_UNWIND (seek, frame, op_ret, op_errno, 0, NULL);
                 break;
+        case GF_FOP_COPY_FILE_RANGE:
+                SHARD_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno,
+                                    NULL, NULL, NULL, NULL);
+                break;
         default:
                 gf_msg (THIS->name, GF_LOG_WARNING, 0, SHARD_MSG_INVALID_FOP,
                         "Invalid fop id = %d", fop);
@@ -1045,6 +1051,436 @@ out:
         return 0;
 }
 
+/* Size write-back ("shard-size-write-back").
+ *
+ * With write-back, writes (and fallocate, zerofill, discard) on a sharded
+ * file do not wind an xattrop on the base file to add their size and block
+ * count deltas to its size xattr. The deltas are added to the size in the
+ * inode ctx of the base file, which the fop unwinds, and also accumulated in
+ * ctx->wb_size and ctx->wb_blocks. They are written to the bricks, with one
+ * xattrop, by the first of:
+ *   - fsync or flush of the file, which unwind only after the xattrop
+ *     succeeded,
+ *   - the expiry of "shard-size-write-back-timeout" seconds after the first
+ *     deferred delta,
+ *   - a cache invalidation or lease recall upcall on the file, which means
+ *     another client is looking at it,
+ *   - any other size xattrop of the file (truncate), which carries them.
+ *
+ * While a file has deltas pending or in flight, the size and block count in
+ * its inode ctx are those of this client and replace what lookup, stat,
+ * readdirp and setattr read from the bricks.
+ *
+ * Crash consistency: the data of a write is on the bricks when it unwinds,
+ * but the size xattr may lag behind it. A client that dies loses at most the
+ * size growth of the writes since its last successful fsync, flush or
+ * timeout; the file then reads as of that size, with the bytes beyond it
+ * present in the shards but not visible, exactly as if the writes had been
+ * in flight when the client died without write-back. A successful fsync or
+ * close makes the size durable.
+ */
+
+static gf_boolean_t
+shard_size_wb_is_pending (shard_inode_ctx_t *ctx)
+{
+        return (ctx->wb_size || ctx->wb_blocks || ctx->wb_inflight);
+}
+
+/* If @inode has size updates of this client that the bricks may not have
+ * seen yet, replaces the size and block count in @stbuf, which were read from
+ * the bricks, with those in the inode ctx.
+ */
+int
+shard_inode_ctx_adjust_size (inode_t *inode, xlator_t *this,
+                             struct iatt *stbuf)
+{
+        int                 ret      = -1;
+        uint64_t            ctx_uint = 0;
+        shard_inode_ctx_t  *ctx      = NULL;
+
+        if (!inode)
+                return ret;
+
+        LOCK (&inode->lock);
+        {
+                ret = __inode_ctx_get (inode, this, &ctx_uint);
+                if (ret < 0)
+                        goto unlock;
+
+                ctx = (shard_inode_ctx_t *) ctx_uint;
+                if (shard_size_wb_is_pending (ctx)) {
+                        stbuf->ia_size = ctx->stat.ia_size;
+                        stbuf->ia_blocks = ctx->stat.ia_blocks;
+                }
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        return ret;
+}
+
+gf_boolean_t
+shard_inode_ctx_has_pending_size (inode_t *inode, xlator_t *this)
+{
+        uint64_t            ctx_uint = 0;
+        gf_boolean_t        pending  = _gf_false;
+        shard_inode_ctx_t  *ctx      = NULL;
+
+        LOCK (&inode->lock);
+        {
+                if (__inode_ctx_get (inode, this, &ctx_uint) == 0) {
+                        ctx = (shard_inode_ctx_t *) ctx_uint;
+                        pending = shard_size_wb_is_pending (ctx);
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        return pending;
+}
+
+/* Cancels the timer of @ctx. Returns the frame the timer would have flushed
+ * with, which the caller destroys, or NULL if the timer fired meanwhile; its
+ * callback then finds the deltas taken.
+ */
+static call_frame_t *
+__shard_size_wb_disarm (xlator_t *this, shard_inode_ctx_t *ctx)
+{
+        call_frame_t *frame = NULL;
+
+        if (!ctx->wb_timer)
+                return NULL;
+
+        if (gf_timer_call_cancel (this->ctx, ctx->wb_timer) == 0)
+                frame = ctx->wb_frame;
+
+        ctx->wb_timer = NULL;
+        ctx->wb_frame = NULL;
+
+        return frame;
+}
+
+int
+shard_size_wb_flush_done (call_frame_t *frame, xlator_t *this)
+{
+        SHARD_STACK_DESTROY (frame);
+        return 0;
+}
+
+int
+shard_update_file_size (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                        loc_t *loc,
+                        shard_post_update_size_fop_handler_t handler);
+
+static void
+shard_size_wb_fire (call_frame_t *frame)
+{
+        xlator_t           *this     = NULL;
+        inode_t            *inode    = NULL;
+        uint64_t            ctx_uint = 0;
+        shard_local_t      *local    = NULL;
+        shard_inode_ctx_t  *ctx      = NULL;
+
+        this = frame->this;
+        local = frame->local;
+        inode = local->loc.inode;
+
+        LOCK (&inode->lock);
+        {
+                if (__inode_ctx_get (inode, this, &ctx_uint) == 0) {
+                        ctx = (shard_inode_ctx_t *) ctx_uint;
+                        if (ctx->wb_frame == frame) {
+                                ctx->wb_timer = NULL;
+                                ctx->wb_frame = NULL;
+                        }
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        shard_update_file_size (frame, this, NULL, &local->loc,
+                                shard_size_wb_flush_done);
+}
+
+static void
+shard_size_wb_timeout (void *data)
+{
+        call_frame_t *frame = data;
+
+        THIS = frame->this;
+        shard_size_wb_fire (frame);
+}
+
+/* Arms the timer that flushes the deltas pending on @inode, unless it is
+ * armed already. The frame it flushes with holds a ref on the inode, so that
+ * the deltas are not forgotten with it.
+ */
+static void
+shard_size_wb_arm (xlator_t *this, inode_t *inode)
+{
+        int                 ret      = -1;
+        uint64_t            ctx_uint = 0;
+        struct timespec     delay    = {0,};
+        call_frame_t       *frame    = NULL;
+        shard_local_t      *local    = NULL;
+        shard_inode_ctx_t  *ctx      = NULL;
+        shard_priv_t       *priv     = NULL;
+
+        priv = this->private;
+
+        frame = create_frame (this, this->ctx->pool);
+        if (!frame)
+                goto out;
+
+        local = mem_get0 (this->local_pool);
+        if (!local)
+                goto out;
+
+        frame->local = local;
+        local->fop = GF_FOP_XATTROP;
+        local->loc.inode = inode_ref (inode);
+        gf_uuid_copy (local->loc.gfid, inode->gfid);
+
+        delay.tv_sec = priv->size_write_back_timeout;
+
+        LOCK (&inode->lock);
+        {
+                if (__inode_ctx_get (inode, this, &ctx_uint) < 0)
+                        goto unlock;
+
+                ctx = (shard_inode_ctx_t *) ctx_uint;
+                if (ctx->wb_timer || (!ctx->wb_size && !ctx->wb_blocks)) {
+                        ret = 0;
+                        goto unlock;
+                }
+
+                ctx->wb_timer = gf_timer_call_after (this->ctx, delay,
+                                                     shard_size_wb_timeout,
+                                                     frame);
+                if (!ctx->wb_timer)
+                        goto unlock;
+
+                ctx->wb_frame = frame;
+                frame = NULL;
+                ret = 0;
+        }
+unlock:
+        UNLOCK (&inode->lock);
+out:
+        if (ret)
+                gf_msg (this->name, GF_LOG_WARNING, ENOMEM,
+                        SHARD_MSG_MEMALLOC_FAILED, "Failed to arm the size "
+                        "write-back timer of %s; size updates wait for the "
+                        "next fsync or flush", uuid_utoa (inode->gfid));
+        if (frame)
+                SHARD_STACK_DESTROY (frame);
+}
+
+/* Defers the size and block count deltas of an inode write to @inode to the
+ * next flush of its size.
+ */
+static void
+shard_size_wb_defer (call_frame_t *frame, xlator_t *this, inode_t *inode)
+{
+        gf_boolean_t        arm   = _gf_false;
+        shard_local_t      *local = NULL;
+        shard_inode_ctx_t  *ctx   = NULL;
+        shard_priv_t       *priv  = NULL;
+
+        local = frame->local;
+        priv = this->private;
+
+        LOCK (&inode->lock);
+        {
+                if (__shard_inode_ctx_get (inode, this, &ctx))
+                        goto unlock;
+
+                ctx->wb_size += local->delta_size + local->hole_size;
+                ctx->wb_blocks += local->delta_blocks;
+                ctx->stat.ia_blocks += local->delta_blocks;
+                local->postbuf.ia_blocks = ctx->stat.ia_blocks;
+
+                arm = (!ctx->wb_timer && (ctx->wb_size || ctx->wb_blocks));
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        if (arm)
+                shard_size_wb_arm (this, inode);
+
+        GF_ATOMIC_INC (priv->size_updates_deferred);
+}
+
+/* Adds the deltas pending on @inode to the size xattrop about to be wound
+ * for @local, which then becomes responsible for them.
+ */
+static void
+shard_size_wb_take (xlator_t *this, inode_t *inode, shard_local_t *local)
+{
+        uint64_t            ctx_uint = 0;
+        call_frame_t       *timer    = NULL;
+        shard_inode_ctx_t  *ctx      = NULL;
+        shard_priv_t       *priv     = NULL;
+
+        priv = this->private;
+
+        LOCK (&inode->lock);
+        {
+                if (__inode_ctx_get (inode, this, &ctx_uint) < 0)
+                        goto unlock;
+
+                ctx = (shard_inode_ctx_t *) ctx_uint;
+                if (!priv->size_write_back && !shard_size_wb_is_pending (ctx))
+                        goto unlock;
+
+                local->wb_size = ctx->wb_size;
+                local->wb_blocks = ctx->wb_blocks;
+                ctx->wb_size = 0;
+                ctx->wb_blocks = 0;
+                timer = __shard_size_wb_disarm (this, ctx);
+
+                if ((local->delta_size + local->hole_size + local->wb_size
+                     == 0) && (local->delta_blocks + local->wb_blocks == 0))
+                        goto unlock;
+
+                ctx->wb_inflight++;
+                local->wb_tracked = _gf_true;
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        if (timer)
+                SHARD_STACK_DESTROY (timer);
+}
+
+int
+shard_size_wb_flush (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     shard_post_update_size_fop_handler_t handler);
+
+/* Accounts the completion of the size xattrop of @local. On failure the
+ * deltas it carried are pending again. Otherwise, the size in the inode ctx
+ * follows what the fop changed, and @local->postbuf, which holds what the
+ * bricks returned, is made what this client knows.
+ */
+static void
+shard_size_wb_put (xlator_t *this, inode_t *inode, shard_local_t *local,
+                   int32_t op_ret)
+{
+        gf_boolean_t        arm    = _gf_false;
+        shard_local_t      *waiter = NULL;
+        shard_local_t      *tmp    = NULL;
+        shard_inode_ctx_t  *ctx    = NULL;
+        struct list_head    waitq;
+
+        if (!local->wb_tracked)
+                return;
+
+        local->wb_tracked = _gf_false;
+        INIT_LIST_HEAD (&waitq);
+
+        LOCK (&inode->lock);
+        {
+                if (__shard_inode_ctx_get (inode, this, &ctx))
+                        goto unlock;
+
+                ctx->wb_inflight--;
+                if (op_ret < 0) {
+                        ctx->wb_size += local->wb_size;
+                        ctx->wb_blocks += local->wb_blocks;
+                        arm = (!ctx->wb_timer &&
+                               (ctx->wb_size || ctx->wb_blocks));
+                } else if (!shard_size_wb_is_pending (ctx)) {
+                        ctx->stat.ia_size = local->postbuf.ia_size;
+                        ctx->stat.ia_blocks = local->postbuf.ia_blocks;
+                } else {
+                        if ((local->fop == GF_FOP_TRUNCATE) ||
+                            (local->fop == GF_FOP_FTRUNCATE))
+                                ctx->stat.ia_size = local->offset;
+                        ctx->stat.ia_blocks += local->delta_blocks;
+                        local->postbuf.ia_size = ctx->stat.ia_size;
+                        local->postbuf.ia_blocks = ctx->stat.ia_blocks;
+                }
+
+                if (!ctx->wb_inflight)
+                        list_splice_init (&ctx->wb_waitq, &waitq);
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        if (arm)
+                shard_size_wb_arm (this, inode);
+
+        if ((op_ret >= 0) && (local->wb_size || local->wb_blocks))
+                GF_ATOMIC_INC (((shard_priv_t *)this->private)->
+                               size_updates_flushed);
+
+        list_for_each_entry_safe (waiter, tmp, &waitq, wb_list) {
+                list_del_init (&waiter->wb_list);
+                shard_size_wb_flush (waiter->wb_waiter, this, waiter->fd,
+                                     waiter->post_update_size_handler);
+        }
+}
+
+/* Makes the size of the file open on @fd durable on the bricks before
+ * calling @handler: flushes the deltas pending on it, or waits for the
+ * xattrops in flight that carry them.
+ */
+int
+shard_size_wb_flush (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     shard_post_update_size_fop_handler_t handler)
+{
+        uint64_t            ctx_uint = 0;
+        gf_boolean_t        wait     = _gf_false;
+        inode_t            *inode    = NULL;
+        shard_local_t      *local    = NULL;
+        shard_inode_ctx_t  *ctx      = NULL;
+
+        local = frame->local;
+        inode = fd->inode;
+
+        LOCK (&inode->lock);
+        {
+                if (__inode_ctx_get (inode, this, &ctx_uint) < 0)
+                        goto unlock;
+
+                ctx = (shard_inode_ctx_t *) ctx_uint;
+                if (!ctx->wb_size && !ctx->wb_blocks && ctx->wb_inflight) {
+                        local->post_update_size_handler = handler;
+                        local->wb_waiter = frame;
+                        list_add_tail (&local->wb_list, &ctx->wb_waitq);
+                        wait = _gf_true;
+                }
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        if (wait)
+                return 0;
+
+        return shard_update_file_size (frame, this, fd, NULL, handler);
+}
+
+/* Flushes the deltas pending on @inode now rather than at the expiry of its
+ * timer.
+ */
+static void
+shard_size_wb_expedite (xlator_t *this, inode_t *inode)
+{
+        uint64_t            ctx_uint = 0;
+        call_frame_t       *frame    = NULL;
+        shard_inode_ctx_t  *ctx      = NULL;
+
+        LOCK (&inode->lock);
+        {
+                if (__inode_ctx_get (inode, this, &ctx_uint) == 0) {
+                        ctx = (shard_inode_ctx_t *) ctx_uint;
+                        frame = __shard_size_wb_disarm (this, ctx);
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        if (frame)
+                shard_size_wb_fire (frame);
+}
+
 int
 shard_update_file_size_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                             int32_t op_ret, int32_t op_errno, dict_t *dict,
@@ -1075,6 +1511,7 @@ shard_update_file_size_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 goto err;
         }
 err:
+        shard_size_wb_put (this, inode, local, local->op_ret);
         local->post_update_size_handler (frame, this);
         return 0;
 }
@@ -1133,15 +1570,19 @@ shard_update_file_size (call_frame_t *frame, xlator_t *this, fd_t *fd,
         else
                 inode = loc->inode;
 
+        shard_size_wb_take (this, inode, local);
+
         /* If both size and block count have not changed, then skip the xattrop.
          */
-        if ((local->delta_size + local->hole_size == 0) &&
-            (local->delta_blocks == 0)) {
+        if ((local->delta_size + local->hole_size + local->wb_size == 0) &&
+            (local->delta_blocks + local->wb_blocks == 0)) {
                 goto out;
         }
 
-        ret = shard_set_size_attrs (local->delta_size + local->hole_size,
-                                    local->delta_blocks, &size_attr);
+        ret = shard_set_size_attrs (local->delta_size + local->hole_size +
+                                    local->wb_size,
+                                    local->delta_blocks + local->wb_blocks,
+                                    &size_attr);
         if (ret) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, SHARD_MSG_SIZE_SET_FAILED,
                         "Failed to set size attrs for %s",
@@ -1180,6 +1621,7 @@ shard_update_file_size (call_frame_t *frame, xlator_t *this, fd_t *fd,
 out:
         if (xattr_req)
                 dict_unref (xattr_req);
+        shard_size_wb_put (this, inode, local, local->op_ret);
         handler (frame, this);
         return 0;
 
@@ -1493,8 +1935,10 @@ shard_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
          */
 
         if (dict_get (xdata, GF_XATTR_SHARD_FILE_SIZE) &&
-            frame->root->pid != GF_CLIENT_PID_GSYNCD)
+            frame->root->pid != GF_CLIENT_PID_GSYNCD) {
                 shard_modify_size_and_block_count (buf, xdata);
+                shard_inode_ctx_adjust_size (inode, this, buf);
+        }
 
         /* If this was a fresh lookup, there are two possibilities:
          * 1) If the file is sharded (indicated by the presence of block size
@@ -1622,6 +2066,7 @@ shard_lookup_base_file_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 local->op_errno = EINVAL;
                 goto unwind;
         }
+        shard_inode_ctx_adjust_size (inode, this, &local->prebuf);
 
         if (shard_inode_ctx_get_all (inode, this, &ctx))
                 mask = SHARD_ALL_MASK;
@@ -1757,6 +2202,7 @@ shard_common_stat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         else
                 inode = local->fd->inode;
 
+        shard_inode_ctx_adjust_size (inode, this, &local->prebuf);
         shard_inode_ctx_invalidate (inode, this, &local->prebuf);
 
 unwind:
@@ -5196,9 +5642,11 @@ shard_common_inode_write_do_cbk (call_frame_t *frame, void *cookie,
         int             call_count = 0;
         fd_t           *anon_fd    = cookie;
         shard_local_t  *local      = NULL;
+        shard_priv_t   *priv       = NULL;
         glusterfs_fop_t fop        = 0;
 
         local = frame->local;
+        priv = this->private;
         fop = local->fop;
 
         LOCK (&frame->lock);
@@ -5237,6 +5685,13 @@ shard_common_inode_write_do_cbk (call_frame_t *frame, void *cookie,
                         local->hole_size = 0;
                         if (xdata)
                                 local->xattr_rsp = dict_ref (xdata);
+                        if (priv->size_write_back) {
+                                shard_size_wb_defer (frame, this,
+                                                     local->fd->inode);
+                                shard_common_inode_write_post_update_size_handler
+                                                                 (frame, this);
+                                return 0;
+                        }
                         shard_update_file_size (frame, this, local->fd, NULL,
                              shard_common_inode_write_post_update_size_handler);
                 }
@@ -5679,10 +6134,53 @@ shard_flush_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 int
-shard_flush (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+shard_post_update_size_flush_handler (call_frame_t *frame, xlator_t *this)
 {
+        shard_local_t *local = NULL;
+
+        local = frame->local;
+
+        if (local->op_ret < 0) {
+                SHARD_STACK_UNWIND (flush, frame, local->op_ret,
+                                    local->op_errno, NULL);
+                return 0;
+        }
+
         STACK_WIND (frame, shard_flush_cbk, FIRST_CHILD(this),
-                    FIRST_CHILD(this)->fops->flush, fd, xdata);
+                    FIRST_CHILD(this)->fops->flush, local->fd,
+                    local->xattr_req);
+        return 0;
+}
+
+int
+shard_flush (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+        shard_local_t *local = NULL;
+
+        if (!shard_inode_ctx_has_pending_size (fd->inode, this)) {
+                STACK_WIND (frame, shard_flush_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->flush, fd, xdata);
+                return 0;
+        }
+
+        /* Closing the file makes its size durable, so that the next open,
+         * from any client, finds it.
+         */
+        local = mem_get0 (this->local_pool);
+        if (!local)
+                goto err;
+
+        frame->local = local;
+        local->fd = fd_ref (fd);
+        local->fop = GF_FOP_FLUSH;
+        if (xdata)
+                local->xattr_req = dict_ref (xdata);
+
+        shard_size_wb_flush (frame, this, fd,
+                             shard_post_update_size_flush_handler);
+        return 0;
+err:
+        SHARD_STACK_UNWIND (flush, frame, -1, ENOMEM, NULL);
         return 0;
 }
 
@@ -5883,6 +6381,24 @@ shard_post_lookup_fsync_handler (call_frame_t *frame, xlator_t *this)
         return 0;
 }
 
+int
+shard_post_update_size_fsync_handler (call_frame_t *frame, xlator_t *this)
+{
+        shard_local_t *local = NULL;
+
+        local = frame->local;
+
+        if (local->op_ret < 0) {
+                shard_common_failure_unwind (GF_FOP_FSYNC, frame, local->op_ret,
+                                             local->op_errno);
+                return 0;
+        }
+
+        shard_lookup_base_file (frame, this, &local->loc,
+                                shard_post_lookup_fsync_handler);
+        return 0;
+}
+
 int
 shard_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
              dict_t *xdata)
@@ -5926,8 +6442,8 @@ shard_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
         local->loc.inode = inode_ref (fd->inode);
         gf_uuid_copy (local->loc.gfid, fd->inode->gfid);
 
-        shard_lookup_base_file (frame, this, &local->loc,
-                                shard_post_lookup_fsync_handler);
+        shard_size_wb_flush (frame, this, fd,
+                             shard_post_update_size_fsync_handler);
         return 0;
 err:
         shard_common_failure_unwind (GF_FOP_FSYNC, frame, -1, ENOMEM);
@@ -5960,9 +6476,12 @@ shard_readdir_past_dot_shard_cbk (call_frame_t *frame, void *cookie,
                 if (IA_ISDIR (entry->d_stat.ia_type))
                         continue;
 
-                if (dict_get (entry->dict, GF_XATTR_SHARD_FILE_SIZE))
+                if (dict_get (entry->dict, GF_XATTR_SHARD_FILE_SIZE)) {
                         shard_modify_size_and_block_count (&entry->d_stat,
                                                            entry->dict);
+                        shard_inode_ctx_adjust_size (entry->inode, this,
+                                                     &entry->d_stat);
+                }
                 if (!entry->inode)
                         continue;
 
@@ -6021,9 +6540,12 @@ shard_readdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         continue;
 
                 if (dict_get (entry->dict, GF_XATTR_SHARD_FILE_SIZE) &&
-                    frame->root->pid != GF_CLIENT_PID_GSYNCD)
+                    frame->root->pid != GF_CLIENT_PID_GSYNCD) {
                         shard_modify_size_and_block_count (&entry->d_stat,
                                                            entry->dict);
+                        shard_inode_ctx_adjust_size (entry->inode, this,
+                                                     &entry->d_stat);
+                }
 
                 if (!entry->inode)
                         continue;
@@ -6350,6 +6872,9 @@ shard_common_setattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 local->op_errno = EINVAL;
                 goto unwind;
         }
+        shard_inode_ctx_adjust_size ((local->fd) ? local->fd->inode
+                                                 : local->loc.inode, this,
+                                     &local->prebuf);
         if (xdata)
                 local->xattr_rsp = dict_ref (xdata);
         local->postbuf = *postbuf;
@@ -6635,6 +7160,20 @@ shard_seek (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         return 0;
 }
 
+int32_t
+shard_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                       off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                       uint32_t flags, dict_t *xdata)
+{
+        /* Only the first block lives in the base file, the copy would have
+         * to be split up over the shards of both files. Let the caller
+         * fall back to readv and writev.
+         */
+        shard_common_failure_unwind (GF_FOP_COPY_FILE_RANGE, frame, -1,
+                                     EXDEV);
+        return 0;
+}
+
 int32_t
 mem_acct_init (xlator_t *this)
 {
@@ -6690,6 +7229,15 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("shard-lru-limit", priv->lru_limit, uint64, out);
 
+        GF_OPTION_INIT ("shard-size-write-back", priv->size_write_back, bool,
+                        out);
+
+        GF_OPTION_INIT ("shard-size-write-back-timeout",
+                        priv->size_write_back_timeout, time, out);
+
+        GF_ATOMIC_INIT (priv->size_updates_deferred, 0);
+        GF_ATOMIC_INIT (priv->size_updates_flushed, 0);
+
         this->local_pool = mem_pool_new (shard_local_t, 128);
         if (!this->local_pool) {
                 ret = -1;
@@ -6747,12 +7295,54 @@ reconfigure (xlator_t *this, dict_t *options)
 
         GF_OPTION_RECONF ("shard-deletion-rate", priv->deletion_rate, options,
                           uint32, out);
+
+        GF_OPTION_RECONF ("shard-size-write-back", priv->size_write_back,
+                          options, bool, out);
+
+        GF_OPTION_RECONF ("shard-size-write-back-timeout",
+                          priv->size_write_back_timeout, options, time, out);
         ret = 0;
 
 out:
         return ret;
 }
 
+int
+notify (xlator_t *this, int32_t event, void *data, ...)
+{
+        inode_t           *inode   = NULL;
+        inode_table_t     *itable  = NULL;
+        struct gf_upcall  *up_data = NULL;
+
+        if (event != GF_EVENT_UPCALL)
+                goto out;
+
+        /* Another client is looking at a file whose size this client has
+         * not written back yet (or holds a lease on it that is recalled):
+         * write it back now.
+         */
+        up_data = data;
+        if ((up_data->event_type != GF_UPCALL_CACHE_INVALIDATION) &&
+            (up_data->event_type != GF_UPCALL_RECALL_LEASE))
+                goto out;
+
+        if (!this->graph || !this->graph->top)
+                goto out;
+
+        itable = ((xlator_t *)this->graph->top)->itable;
+        if (!itable)
+                goto out;
+
+        inode = inode_find (itable, up_data->gfid);
+        if (!inode)
+                goto out;
+
+        shard_size_wb_expedite (this, inode);
+        inode_unref (inode);
+out:
+        return default_notify (this, event, data);
+}
+
 int
 shard_forget (xlator_t *this, inode_t *inode)
 {
@@ -6810,6 +7400,13 @@ shard_priv_dump (xlator_t *this)
         gf_proc_dump_write ("inode-count", "%d", priv->inode_count);
         gf_proc_dump_write ("ilist_head", "%p", &priv->ilist_head);
         gf_proc_dump_write ("lru-max-limit", "%d", priv->lru_limit);
+        gf_proc_dump_write ("size-write-back", "%d", priv->size_write_back);
+        gf_proc_dump_write ("size-write-back-timeout", "%u",
+                            priv->size_write_back_timeout);
+        gf_proc_dump_write ("size-updates-deferred", "%"PRIu64,
+                            GF_ATOMIC_GET (priv->size_updates_deferred));
+        gf_proc_dump_write ("size-updates-flushed", "%"PRIu64,
+                            GF_ATOMIC_GET (priv->size_updates_flushed));
 
         GF_FREE (str);
 
@@ -6852,6 +7449,7 @@ struct xlator_fops fops = {
         .unlink      = shard_unlink,
         .rename      = shard_rename,
         .seek        = shard_seek,
+        .copy_file_range = shard_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
@@ -6902,5 +7500,32 @@ struct volume_options options[] = {
                           "amount of memory consumed by these inodes and their "
                           "internal metadata",
         },
+        {  .key = {"shard-size-write-back"},
+           .type = GF_OPTION_TYPE_BOOL,
+           .op_version = {GD_OP_VERSION_4_2_0},
+           .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+           .tags = {"shard"},
+           .default_value = "off",
+           .description = "Defer the updates of the size and block count of "
+                          "a sharded file that writes make, and write them "
+                          "to the bricks with a single xattrop on fsync, "
+                          "close, after shard-size-write-back-timeout "
+                          "seconds, or when another client accesses the file. "
+                          "A client that crashes loses the size growth of "
+                          "the writes since the last of these, but not "
+                          "their data",
+        },
+        {  .key = {"shard-size-write-back-timeout"},
+           .type = GF_OPTION_TYPE_TIME,
+           .op_version = {GD_OP_VERSION_4_2_0},
+           .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+           .tags = {"shard"},
+           .default_value = "5",
+           .min = 1,
+           .max = 600,
+           .description = "The number of seconds the size updates deferred "
+                          "by shard-size-write-back can wait before they are "
+                          "written to the bricks",
+        },
         { .key = {NULL} },
 };
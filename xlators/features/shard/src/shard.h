@@ -16,6 +16,7 @@
 #include "compat-errno.h"
 #include "shard-messages.h"
 #include "syncop.h"
+#include "timer.h"
 
 #define GF_SHARD_DIR ".shard"
 #define GF_SHARD_REMOVE_ME_DIR ".remove_me"
@@ -215,6 +216,10 @@ typedef struct shard_priv {
         uint32_t deletion_rate;
         shard_first_lookup_state_t first_lookup;
         uint64_t lru_limit;
+        gf_boolean_t size_write_back;
+        uint32_t size_write_back_timeout;
+        gf_atomic_t size_updates_deferred;
+        gf_atomic_t size_updates_flushed;
 } shard_priv_t;
 
 typedef struct {
@@ -313,6 +318,11 @@ typedef struct shard_local {
         uint32_t deletion_rate;
         gf_boolean_t cleanup_required;
         uuid_t base_gfid;
+        int64_t wb_size;
+        int64_t wb_blocks;
+        gf_boolean_t wb_tracked;
+        struct list_head wb_list;
+        call_frame_t *wb_waiter;
 } shard_local_t;
 
 typedef struct shard_inode_ctx {
@@ -332,6 +342,18 @@ typedef struct shard_inode_ctx {
         inode_t *inode;
         int fsync_count;
         inode_t *base_inode;
+        /* Size and block count deltas of the base file that writes have
+         * added to @stat but that are not yet in its size xattr on the
+         * bricks, the size xattrops in flight, and the timer that flushes
+         * the deltas (see "shard-size-write-back"). fsync and flush wait in
+         * @wb_waitq for the xattrops in flight.
+         */
+        int64_t wb_size;
+        int64_t wb_blocks;
+        int wb_inflight;
+        gf_timer_t *wb_timer;
+        call_frame_t *wb_frame;
+        struct list_head wb_waitq;
 } shard_inode_ctx_t;
 
 typedef enum {
@@ -1607,6 +1607,67 @@ err:
         return 0;
 }
 
+static int32_t
+up_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                        struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                        dict_t *xdata)
+{
+        client_t         *client        = NULL;
+        uint32_t         flags          = 0;
+        upcall_local_t   *local         = NULL;
+
+        EXIT_IF_UPCALL_OFF (this, out);
+
+        client = frame->root->client;
+        local = frame->local;
+
+        if ((op_ret < 0) || !local) {
+                goto out;
+        }
+        flags = UP_WRITE_FLAGS;
+        upcall_cache_invalidate (frame, this, client, local->inode, flags,
+                                 postbuf_dst, NULL, NULL, NULL);
+
+out:
+        UPCALL_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno, stbuf,
+                             prebuf_dst, postbuf_dst, xdata);
+
+        return 0;
+}
+
+static int
+up_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+        int32_t          op_errno        = -1;
+        upcall_local_t   *local          = NULL;
+
+        EXIT_IF_UPCALL_OFF (this, out);
+
+        local = upcall_local_init (frame, this, NULL, NULL, fd_out->inode,
+                                   NULL);
+        if (!local) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+out:
+        STACK_WIND (frame, up_copy_file_range_cbk,
+                    FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+
+        return 0;
+
+err:
+        UPCALL_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL,
+                             NULL, NULL, NULL);
+
+        return 0;
+}
+
 
 static int32_t
 up_seek_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
@@ -2552,6 +2613,7 @@ struct xlator_fops fops = {
         .ftruncate   = up_ftruncate,
         .writev      = up_writev,
         .zerofill    = up_zerofill,
+        .copy_file_range = up_copy_file_range,
         .fallocate   = up_fallocate,
         .discard     = up_discard,
 
@@ -348,6 +348,38 @@ gf_utime_truncate (call_frame_t *frame, xlator_t *this,
 }
 
 
+int32_t
+gf_utime_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno,
+                    struct iatt * stbuf,
+	struct iatt * prebuf_dst,
+	struct iatt * postbuf_dst,
+	dict_t * xdata)
+{
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno, stbuf, prebuf_dst, postbuf_dst, xdata);
+        return 0;
+}
+
+
+int32_t
+gf_utime_copy_file_range (call_frame_t *frame, xlator_t *this,
+                fd_t * fd_in,
+	off_t off_in,
+	fd_t * fd_out,
+	off_t off_out,
+	size_t len,
+	uint32_t flags,
+	dict_t * xdata)
+{
+        gl_timespec_get(&frame->root->ctime);
+
+        (void) utime_update_attribute_flags(frame, GF_FOP_WRITE);
+        STACK_WIND (frame, gf_utime_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in, fd_out, off_out, len, flags, xdata);
+        return 0;
+}
+
+
 int32_t
 gf_utime_symlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                      int32_t op_ret, int32_t op_errno,
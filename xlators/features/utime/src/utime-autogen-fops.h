@@ -111,6 +111,17 @@ gf_utime_truncate (call_frame_t *frame, xlator_t *this,
 	dict_t * xdata);
 
 
+int32_t
+gf_utime_copy_file_range (call_frame_t *frame, xlator_t *this,
+                fd_t * fd_in,
+	off_t off_in,
+	fd_t * fd_out,
+	off_t off_out,
+	size_t len,
+	uint32_t flags,
+	dict_t * xdata);
+
+
 int32_t
 gf_utime_symlink (call_frame_t *frame, xlator_t *this,
                 const char * linkpath,
@@ -92,7 +92,7 @@ utime_ops = ['fallocate', 'zerofill', 'opendir', 'mknod', 'mkdir',
              'ftruncate', 'create', 'open', 'removexattr', 'fremovexattr']
 
 utime_read_op = ['readv']
-utime_write_op = ['writev']
+utime_write_op = ['writev', 'copy_file_range']
 utime_setattr_ops = ['setattr', 'fsetattr']
 
 def gen_defaults():
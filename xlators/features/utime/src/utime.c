@@ -203,6 +203,7 @@ struct xlator_fops fops = {
         .fsetattr             = gf_utime_fsetattr,
         .opendir              = gf_utime_opendir,
         .removexattr          = gf_utime_removexattr,
+        .copy_file_range      = gf_utime_copy_file_range,
 };
 struct xlator_cbks cbks = {
         .invalidate           = gf_utime_invalidate,
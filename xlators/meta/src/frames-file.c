@@ -24,16 +24,21 @@ frames_file_fill (xlator_t *this, inode_t *file, strfd_t *strfd)
         call_frame_t *frame = NULL;
         int i = 0;
         int j = 1;
+        int shard = 0;
+        int count = 0;
 
         if (!this || !file || !strfd)
                 return -1;
 
         pool = this->ctx->pool;
 
-        LOCK (&pool->lock);
+        call_pool_lock (pool);
         {
+                /* pool->cnt is only updated after a shard is unlocked */
+                call_pool_for_each_stack (stack, pool, shard)
+                        count++;
                 strprintf (strfd, "{ \n\t\"Stack\": [\n");
-                list_for_each_entry (stack, &pool->all_frames, all_frames) {
+                call_pool_for_each_stack (stack, pool, shard) {
                         strprintf (strfd, "\t   {\n");
                         strprintf (strfd, "\t\t\"Number\": %d,\n", ++i);
                         strprintf (strfd, "\t\t\"Frame\": [\n");
@@ -86,17 +91,17 @@ frames_file_fill (xlator_t *this, inode_t *file, strfd_t *strfd)
                                         stack->gid);
                         strprintf (strfd, "\t\t\"LK_owner\": \"%s\"\n",
                                         lkowner_utoa (&stack->lk_owner));
-                        if (i == (int)pool->cnt)
+                        if (i == count)
                                 strprintf (strfd, "\t   }\n");
                         else
                                 strprintf (strfd, "\t   },\n");
                 }
                 strprintf (strfd, "\t],\n");
                 strprintf (strfd, "\t\"Call_Count\": %d\n",
-                                (int)pool->cnt);
+                                count);
                 strprintf (strfd, "}");
         }
-        UNLOCK (&pool->lock);
+        call_pool_unlock (pool);
 
         return strfd->size;
 }
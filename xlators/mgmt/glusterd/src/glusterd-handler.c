@@ -2641,6 +2641,155 @@ glusterd_handle_incoming_unfriend_req (rpcsvc_request_t *req)
 
 }
 
+/* A peer sends the (version, cksum) of its volumes before the friend add.
+ * Answer with the volumes we need from it, so that the friend add carries
+ * only those. A checksum conflict is flagged and lets the peer send
+ * everything, the friend add then rejects it the usual way. */
+int
+__glusterd_handle_friend_volume_summary (rpcsvc_request_t *req)
+{
+        int32_t                      ret = -1;
+        gd1_mgmt_friend_req          friend_req = {{0},};
+        gd1_mgmt_friend_summary_rsp  rsp = {{0},};
+        glusterd_peerinfo_t         *peerinfo = NULL;
+        dict_t                      *peer_data = NULL;
+        dict_t                      *needed = NULL;
+        char                        *peername = NULL;
+        char                        *volname = NULL;
+        char                         key[GD_VOLUME_NAME_MAX + 16] = {0,};
+        int32_t                      count = 0;
+        int32_t                      need_count = 0;
+        int32_t                      status = 0;
+        int32_t                      i = 0;
+        xlator_t                    *this = NULL;
+
+        this = THIS;
+        GF_ASSERT (this);
+        GF_ASSERT (req);
+
+        ret = xdr_to_generic (req->msg[0], &friend_req,
+                              (xdrproc_t)xdr_gd1_mgmt_friend_req);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        GD_MSG_REQ_DECODE_FAIL, "Failed to decode "
+                        "volume summary received from friend");
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        gf_msg_debug (this->name, 0, "Received volume summary from uuid: %s",
+                      uuid_utoa (friend_req.uuid));
+
+        gf_uuid_copy (rsp.uuid, MY_UUID);
+        rsp.hostname = friend_req.hostname;
+        rsp.op_ret = -1;
+
+        rcu_read_lock ();
+        peerinfo = glusterd_peerinfo_find (friend_req.uuid, NULL);
+        if (peerinfo)
+                peername = gf_strdup (peerinfo->hostname);
+        rcu_read_unlock ();
+
+        if (!peername) {
+                /* not a friend yet, the friend add validates it */
+                rsp.op_errno = ENOENT;
+                goto reply;
+        }
+
+        peer_data = dict_new ();
+        needed = dict_new ();
+        if (!peer_data || !needed) {
+                rsp.op_errno = ENOMEM;
+                goto reply;
+        }
+
+        ret = dict_unserialize (friend_req.vols.vols_val,
+                                friend_req.vols.vols_len, &peer_data);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        GD_MSG_DICT_UNSERIALIZE_FAIL,
+                        "failed to unserialize the volume summary of %s",
+                        peername);
+                rsp.op_errno = EINVAL;
+                goto reply;
+        }
+
+        ret = dict_get_int32 (peer_data, "count", &count);
+        if (ret) {
+                rsp.op_errno = EINVAL;
+                goto reply;
+        }
+
+        for (i = 1; i <= count; i++) {
+                ret = glusterd_compare_friend_volume (peer_data, i, &status,
+                                                      peername);
+                if (ret) {
+                        rsp.op_errno = EINVAL;
+                        goto reply;
+                }
+
+                if (status == GLUSTERD_VOL_COMP_RJT) {
+                        ret = dict_set_int32 (needed, "conflict", 1);
+                        break;
+                }
+
+                if (status != GLUSTERD_VOL_COMP_UPDATE_REQ)
+                        continue;
+
+                snprintf (key, sizeof (key), "volume%d.name", i);
+                ret = dict_get_str (peer_data, key, &volname);
+                if (ret)
+                        break;
+
+                snprintf (key, sizeof (key), "need.%s", volname);
+                ret = dict_set_int32 (needed, key, 1);
+                if (ret)
+                        break;
+                need_count++;
+        }
+
+        if (!ret)
+                ret = dict_set_int32 (needed, "count", need_count);
+        if (!ret)
+                ret = dict_allocate_and_serialize (needed, &rsp.vols.vols_val,
+                                                   &rsp.vols.vols_len);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        GD_MSG_VOL_SUMMARY_FAIL,
+                        "failed to build the volume summary reply for %s",
+                        peername);
+                rsp.op_errno = ENOMEM;
+                goto reply;
+        }
+
+        gf_msg_debug (this->name, 0, "%d of %d volumes of %s need an update",
+                      need_count, count, peername);
+        rsp.op_ret = 0;
+        rsp.op_errno = 0;
+
+reply:
+        ret = glusterd_submit_reply (req, &rsp, NULL, 0, NULL,
+                               (xdrproc_t)xdr_gd1_mgmt_friend_summary_rsp);
+out:
+        if (peer_data)
+                dict_unref (peer_data);
+        if (needed)
+                dict_unref (needed);
+        GF_FREE (rsp.vols.vols_val);
+        GF_FREE (peername);
+        free (friend_req.hostname);//malloced by xdr
+        free (friend_req.vols.vols_val);//malloced by xdr
+
+        return ret;
+}
+
+int
+glusterd_handle_friend_volume_summary (rpcsvc_request_t *req)
+{
+        return glusterd_big_locked_handler (req,
+                                    __glusterd_handle_friend_volume_summary);
+}
+
 int
 glusterd_handle_friend_update_delete (dict_t *dict)
 {
@@ -6482,6 +6631,7 @@ rpcsvc_actor_t gd_svc_peer_actors[GLUSTERD_FRIEND_MAXVALUE] = {
         [GLUSTERD_FRIEND_ADD]     = { "FRIEND_ADD",    GLUSTERD_FRIEND_ADD,    glusterd_handle_incoming_friend_req,   NULL, 0, DRC_NA},
         [GLUSTERD_FRIEND_REMOVE]  = { "FRIEND_REMOVE", GLUSTERD_FRIEND_REMOVE, glusterd_handle_incoming_unfriend_req, NULL, 0, DRC_NA},
         [GLUSTERD_FRIEND_UPDATE]  = { "FRIEND_UPDATE", GLUSTERD_FRIEND_UPDATE, glusterd_handle_friend_update,         NULL, 0, DRC_NA},
+        [GLUSTERD_FRIEND_VOLUME_SUMMARY] = { "FRIEND_VOLUME_SUMMARY", GLUSTERD_FRIEND_VOLUME_SUMMARY, glusterd_handle_friend_volume_summary, NULL, 0, DRC_NA},
 };
 
 struct rpcsvc_program gd_svc_peer_prog = {
@@ -637,7 +637,8 @@ GLFS_MSGID(GLUSTERD,
         GD_MSG_PORTS_EXHAUSTED,
         GD_MSG_CHANGELOG_GET_FAIL,
         GD_MSG_MANAGER_FUNCTION_FAILED,
-        GD_MSG_DAEMON_LOG_LEVEL_VOL_OPT_VALIDATE_FAIL
+        GD_MSG_DAEMON_LOG_LEVEL_VOL_OPT_VALIDATE_FAIL,
+        GD_MSG_VOL_SUMMARY_FAIL
 );
 
 #endif /* !_GLUSTERD_MESSAGES_H_ */
@@ -1531,47 +1531,25 @@ out:
 }
 
 
-int32_t
-glusterd_rpc_friend_add (call_frame_t *frame, xlator_t *this,
-                         void *data)
+/* Sends the friend add to @peerinfo. Only the volumes listed in @needed are
+ * exported, NULL exports all of them. Called with the rcu read lock held. */
+static int32_t
+glusterd_friend_add_submit (call_frame_t *frame, xlator_t *this,
+                            glusterd_peerinfo_t *peerinfo, dict_t *needed)
 {
         gd1_mgmt_friend_req         req       = {{0},};
         int                         ret       = 0;
-        glusterd_peerinfo_t        *peerinfo  = NULL;
         glusterd_conf_t            *priv      = NULL;
-        glusterd_friend_sm_event_t *event     = NULL;
         dict_t                     *peer_data = NULL;
 
-
-        if (!frame || !this || !data) {
-                ret = -1;
-                goto out;
-        }
-
-        event = data;
         priv = this->private;
-
         GF_ASSERT (priv);
 
-        rcu_read_lock ();
-
-        peerinfo = glusterd_peerinfo_find (event->peerid, event->peername);
-        if (!peerinfo) {
-                rcu_read_unlock ();
-                ret = -1;
-                gf_msg (this->name, GF_LOG_ERROR, 0,
-                        GD_MSG_PEER_NOT_FOUND, "Could not find peer %s(%s)",
-                        event->peername, uuid_utoa (event->peerid));
-                goto out;
-        }
-
         gf_uuid_copy (req.uuid, MY_UUID);
         req.hostname = gf_strdup (peerinfo->hostname);
         req.port = peerinfo->port;
 
-        rcu_read_unlock ();
-
-        ret = glusterd_add_volumes_to_export_dict (&peer_data);
+        ret = glusterd_add_volumes_to_export_dict (&peer_data, needed);
         if (ret) {
                 gf_msg (this->name, GF_LOG_ERROR, 0,
                         GD_MSG_DICT_SET_FAILED,
@@ -1628,6 +1606,183 @@ out:
         if (peer_data)
                 dict_unref (peer_data);
 
+        return ret;
+}
+
+int32_t
+__glusterd_friend_volume_summary_cbk (struct rpc_req *req, struct iovec *iov,
+                                      int count, void *myframe)
+{
+        gd1_mgmt_friend_summary_rsp  rsp = {{0},};
+        int                          ret = -1;
+        int32_t                      conflict = 0;
+        int32_t                      need_count = -1;
+        glusterd_peerinfo_t         *peerinfo = NULL;
+        glusterd_probe_ctx_t        *ctx = NULL;
+        call_frame_t                *frame = NULL;
+        dict_t                      *needed = NULL;
+        xlator_t                    *this = NULL;
+
+        this = THIS;
+        frame = myframe;
+
+        if (-1 == req->rpc_status)
+                goto out;
+
+        ret = xdr_to_generic (*iov, &rsp,
+                              (xdrproc_t)xdr_gd1_mgmt_friend_summary_rsp);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, errno,
+                        GD_MSG_RES_DECODE_FAIL, "error");
+                goto out;
+        }
+
+        if (rsp.op_ret == 0 && rsp.vols.vols_len) {
+                needed = dict_new ();
+                if (needed &&
+                    dict_unserialize (rsp.vols.vols_val, rsp.vols.vols_len,
+                                      &needed) == 0 &&
+                    dict_get_int32 (needed, "count", &need_count) == 0 &&
+                    dict_get_int32 (needed, "conflict", &conflict) != 0)
+                        conflict = 0;
+        }
+
+        /* send everything when the peer could not tell what it needs or
+         * found a conflict, the friend add deals with it as before */
+        if (need_count < 0 || conflict) {
+                if (needed)
+                        dict_unref (needed);
+                needed = NULL;
+        }
+
+        gf_msg_debug (this->name, 0, "Peer %s needs %d volumes%s",
+                      uuid_utoa (rsp.uuid), need_count,
+                      conflict ? " (conflict)" : "");
+
+        rcu_read_lock ();
+
+        peerinfo = glusterd_peerinfo_find (rsp.uuid, rsp.hostname);
+        if (peerinfo == NULL) {
+                ret = -1;
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        GD_MSG_RESP_FROM_UNKNOWN_PEER,
+                        "received volume summary response from"
+                        " unknown peer uuid: %s", uuid_utoa (rsp.uuid));
+        } else {
+                ret = glusterd_friend_add_submit (frame, this, peerinfo,
+                                                  needed);
+        }
+
+        rcu_read_unlock ();
+
+out:
+        if (ret) {
+                /* fail the probe the way a failed friend add does */
+                ctx = frame->local;
+                frame->local = NULL;
+
+                if (ctx && ctx->req)
+                        glusterd_xfer_cli_probe_resp (ctx->req, -1, EINVAL,
+                                                      NULL, ctx->hostname,
+                                                      ctx->port, ctx->dict);
+                if (ctx)
+                        glusterd_destroy_probe_ctx (ctx);
+                GLUSTERD_STACK_DESTROY (frame);
+        }
+
+        if (needed)
+                dict_unref (needed);
+        free (rsp.hostname);//malloced by xdr
+        free (rsp.vols.vols_val);//malloced by xdr
+        return ret;
+}
+
+int32_t
+glusterd_friend_volume_summary_cbk (struct rpc_req *req, struct iovec *iov,
+                                    int count, void *myframe)
+{
+        return glusterd_big_locked_cbk (req, iov, count, myframe,
+                                        __glusterd_friend_volume_summary_cbk);
+}
+
+int32_t
+glusterd_rpc_friend_add (call_frame_t *frame, xlator_t *this,
+                         void *data)
+{
+        gd1_mgmt_friend_req         req       = {{0},};
+        int                         ret       = 0;
+        glusterd_peerinfo_t        *peerinfo  = NULL;
+        glusterd_conf_t            *priv      = NULL;
+        glusterd_friend_sm_event_t *event     = NULL;
+        dict_t                     *summary   = NULL;
+
+
+        if (!frame || !this || !data) {
+                ret = -1;
+                goto out;
+        }
+
+        event = data;
+        priv = this->private;
+
+        GF_ASSERT (priv);
+
+        rcu_read_lock ();
+
+        peerinfo = glusterd_peerinfo_find (event->peerid, event->peername);
+        if (!peerinfo) {
+                rcu_read_unlock ();
+                ret = -1;
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        GD_MSG_PEER_NOT_FOUND, "Could not find peer %s(%s)",
+                        event->peername, uuid_utoa (event->peerid));
+                goto out;
+        }
+
+        /* Older peers get all the volumes right away. Newer ones first get
+         * a summary of them and the friend add is sent from the callback,
+         * with the volumes they asked for. */
+        if (priv->op_version < GD_OP_VERSION_4_2_0) {
+                ret = glusterd_friend_add_submit (frame, this, peerinfo, NULL);
+                rcu_read_unlock ();
+                goto out;
+        }
+
+        gf_uuid_copy (req.uuid, MY_UUID);
+        req.hostname = gf_strdup (peerinfo->hostname);
+        req.port = peerinfo->port;
+
+        ret = glusterd_add_volumes_summary_to_export_dict (&summary);
+        if (!ret)
+                ret = dict_allocate_and_serialize (summary,
+                                                   &req.vols.vols_val,
+                                                   &req.vols.vols_len);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        GD_MSG_VOL_SUMMARY_FAIL,
+                        "Unable to build the volume summary for %s, sending "
+                        "all volumes", peerinfo->hostname);
+                ret = glusterd_friend_add_submit (frame, this, peerinfo, NULL);
+                rcu_read_unlock ();
+                goto out;
+        }
+
+        ret = glusterd_submit_request (peerinfo->rpc, &req, frame,
+                                       peerinfo->peer,
+                                       GLUSTERD_FRIEND_VOLUME_SUMMARY,
+                                       NULL, this,
+                                       glusterd_friend_volume_summary_cbk,
+                                       (xdrproc_t)xdr_gd1_mgmt_friend_req);
+
+        rcu_read_unlock ();
+
+out:
+        GF_FREE (req.vols.vols_val);
+        GF_FREE (req.hostname);
+
+        if (summary)
+                dict_unref (summary);
+
         gf_msg_debug (this ? this->name : "glusterd", 0,
                       "Returning %d", ret);
         return ret;
@@ -3362,8 +3362,80 @@ out:
         return ret;
 }
 
+/* Adds only what glusterd_compare_friend_volume () looks at: the name,
+ * version and checksum of every volume and of its quota configuration. A
+ * peer compares this summary first and asks for the volumes it is missing,
+ * so that a handshake does not carry the whole volume list every time. */
 int32_t
-glusterd_add_volumes_to_export_dict (dict_t **peer_data)
+glusterd_add_volumes_summary_to_export_dict (dict_t **peer_data)
+{
+        int32_t                 ret = -1;
+        dict_t                  *dict = NULL;
+        glusterd_conf_t         *priv = NULL;
+        glusterd_volinfo_t      *volinfo = NULL;
+        int32_t                 count = 0;
+        char                    key[64] = {0,};
+        xlator_t               *this = NULL;
+
+        this = THIS;
+        GF_ASSERT (this);
+        priv = this->private;
+        GF_ASSERT (priv);
+
+        dict = dict_new ();
+        if (!dict)
+                goto out;
+
+        cds_list_for_each_entry (volinfo, &priv->volumes, vol_list) {
+                count++;
+                snprintf (key, sizeof (key), "volume%d.name", count);
+                ret = dict_set_dynstr_with_alloc (dict, key,
+                                                  volinfo->volname);
+                if (ret)
+                        goto out;
+
+                snprintf (key, sizeof (key), "volume%d.version", count);
+                ret = dict_set_int32 (dict, key, volinfo->version);
+                if (ret)
+                        goto out;
+
+                snprintf (key, sizeof (key), "volume%d.ckusm", count);
+                ret = dict_set_int64 (dict, key, volinfo->cksum);
+                if (ret)
+                        goto out;
+
+                if (!glusterd_is_volume_quota_enabled (volinfo))
+                        continue;
+
+                snprintf (key, sizeof (key), "volume%d.quota-version", count);
+                ret = dict_set_uint32 (dict, key,
+                                       volinfo->quota_conf_version);
+                if (ret)
+                        goto out;
+
+                snprintf (key, sizeof (key), "volume%d.quota-cksum", count);
+                ret = dict_set_uint32 (dict, key, volinfo->quota_conf_cksum);
+                if (ret)
+                        goto out;
+        }
+
+        ret = dict_set_int32 (dict, "count", count);
+        if (ret)
+                goto out;
+
+        *peer_data = dict;
+out:
+        if (ret && dict)
+                dict_unref (dict);
+
+        gf_msg_trace (this->name, 0, "Returning %d", ret);
+        return ret;
+}
+
+/* @needed is the reply of a peer to the volume summary, only the volumes it
+ * lists are added. NULL adds every volume. */
+int32_t
+glusterd_add_volumes_to_export_dict (dict_t **peer_data, dict_t *needed)
 {
         int32_t                 ret = -1;
         dict_t                  *dict = NULL;
@@ -3371,6 +3443,7 @@ glusterd_add_volumes_to_export_dict (dict_t **peer_data)
         glusterd_volinfo_t      *volinfo = NULL;
         int32_t                 count = 0;
         glusterd_dict_ctx_t     ctx            = {0};
+        char                    key[GD_VOLUME_NAME_MAX + 16] = {0,};
         xlator_t               *this = NULL;
 
         this = THIS;
@@ -3383,6 +3456,12 @@ glusterd_add_volumes_to_export_dict (dict_t **peer_data)
                 goto out;
 
         cds_list_for_each_entry (volinfo, &priv->volumes, vol_list) {
+                if (needed) {
+                        snprintf (key, sizeof (key), "need.%s",
+                                  volinfo->volname);
+                        if (!dict_get (needed, key))
+                                continue;
+                }
                 count++;
                 ret = glusterd_add_volume_to_dict (volinfo, dict, count,
                                                    "volume");
@@ -224,7 +224,14 @@ glusterd_volume_brickinfo_get_by_brick (char *brick,
                                         gf_boolean_t construct_real_path);
 
 int32_t
-glusterd_add_volumes_to_export_dict (dict_t **peer_data);
+glusterd_add_volumes_to_export_dict (dict_t **peer_data, dict_t *needed);
+
+int32_t
+glusterd_add_volumes_summary_to_export_dict (dict_t **peer_data);
+
+int32_t
+glusterd_compare_friend_volume (dict_t *peer_data, int32_t count,
+                                int32_t *status, char *hostname);
 
 int32_t
 glusterd_compare_friend_data (dict_t *peer_data, int32_t *status,
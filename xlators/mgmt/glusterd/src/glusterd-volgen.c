@@ -4788,6 +4788,13 @@ bitrot_option_handler (volgen_graph_t *graph, struct volopt_map_entry *vme,
                         return -1;
         }
 
+        if (!strcmp (vme->option, "signer-threads") ||
+            !strcmp (vme->option, "signature-type")) {
+                ret = xlator_set_option (xl, vme->option, vme->value);
+                if (ret)
+                        return -1;
+        }
+
         return ret;
 }
 
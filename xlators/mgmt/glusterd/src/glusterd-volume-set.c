@@ -1720,6 +1720,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 1,
           .flags      = VOLOPT_FLAG_CLIENT_OPT
         },
+        { .key        = "performance.io-cache-policy",
+          .voltype    = "performance/io-cache",
+          .option     = "cache-policy",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
         { .key        = "performance.cache-size",
           .voltype    = "performance/io-cache",
           .op_version = 1,
@@ -1767,6 +1773,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .option      = "pass-through",
           .op_version  = GD_OP_VERSION_4_1_0
         },
+        { .key         = "performance.iot-work-stealing",
+          .voltype     = "performance/io-threads",
+          .option      = "work-stealing",
+          .op_version  = GD_OP_VERSION_4_2_0
+        },
 
         /* Other perf xlators' options */
         { .key         = "performance.io-cache-pass-through",
@@ -1906,6 +1917,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .option     = "pass-through",
           .op_version = GD_OP_VERSION_4_1_0,
         },
+        { .key        = "performance.read-ahead-adaptive",
+          .voltype    = "performance/read-ahead",
+          .option     = "adaptive",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "performance.read-ahead-max-window",
+          .voltype    = "performance/read-ahead",
+          .option     = "max-window",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
         { .key        = "performance.readdir-ahead-pass-through",
           .voltype    = "performance/readdir-ahead",
           .option     = "pass-through",
@@ -1966,6 +1989,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .description = "A comma separated list of xattrs that shall be "
                          "cached by md-cache. The only wildcard allowed is '*'"
         },
+        { .key        = "performance.md-cache-persist-file",
+          .voltype    = "performance/md-cache",
+          .option     = "md-cache-persist-file",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "performance.md-cache-persist-entries",
+          .voltype    = "performance/md-cache",
+          .option     = "md-cache-persist-entries",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
         { .key        = "performance.nl-cache-pass-through",
           .voltype    = "performance/nl-cache",
           .option     = "pass-through",
@@ -2040,6 +2075,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "protocol/client",
           .op_version  = GD_OP_VERSION_3_7_0,
         },
+        { .key         = "client.connection-count",
+          .voltype     = "protocol/client",
+          .op_version  = GD_OP_VERSION_4_2_0,
+        },
         { .key         = "client.tcp-user-timeout",
           .voltype     = "protocol/client",
           .option      = "transport.tcp-user-timeout",
@@ -2068,6 +2107,13 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .value       = "9",
           .flags       = VOLOPT_FLAG_CLIENT_OPT
         },
+        { .key         = "client.zerocopy",
+          .voltype     = "protocol/client",
+          .option      = "transport.socket.zerocopy",
+          .op_version  = GD_OP_VERSION_4_2_0,
+          .value       = "off",
+          .flags       = VOLOPT_FLAG_CLIENT_OPT
+        },
 
         /* Server xlator options */
         { .key         = "network.tcp-window-size",
@@ -2194,6 +2240,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version  = GD_OP_VERSION_3_10_2,
           .value       = "9",
         },
+        { .key         = "server.zerocopy",
+          .voltype     = "protocol/server",
+          .option      = "transport.socket.zerocopy",
+          .op_version  = GD_OP_VERSION_4_2_0,
+          .value       = "off",
+        },
         { .key         = "transport.listen-backlog",
           .voltype     = "protocol/server",
           .option      = "transport.listen-backlog",
@@ -2914,6 +2966,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "storage/posix",
           .op_version  = 1
         },
+        { .key         = "storage.io-uring",
+          .voltype     = "storage/posix",
+          .op_version  = GD_OP_VERSION_4_2_0
+        },
         { .key         = "storage.batch-fsync-mode",
           .voltype     = "storage/posix",
           .op_version  = 3
@@ -3006,6 +3062,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "storage/posix",
           .op_version  = GD_OP_VERSION_4_1_0,
         },
+        { .option      = "merkle-cache",
+          .key         = "storage.merkle-cache",
+          .voltype     = "storage/posix",
+          .op_version  = GD_OP_VERSION_4_2_0,
+        },
         { .key         = "storage.bd-aio",
           .voltype     = "storage/bd",
           .op_version  = 3
@@ -3466,6 +3527,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = GD_OP_VERSION_4_2_0,
           .flags      = VOLOPT_FLAG_CLIENT_OPT
         },
+        { .key        = "features.shard-size-write-back",
+          .voltype    = "features/shard",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "features.shard-size-write-back-timeout",
+          .voltype    = "features/shard",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
         { .key        = "features.scrub-throttle",
           .voltype    = "features/bit-rot",
           .value      = "lazy",
@@ -3494,6 +3565,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = GD_OP_VERSION_3_7_0,
           .type       = NO_DOC,
         },
+        { .key        = "features.signer-threads",
+          .voltype    = "features/bit-rot",
+          .option     = "signer-threads",
+          .op_version = GD_OP_VERSION_4_2_0,
+        },
+        { .key        = "features.signature-type",
+          .voltype    = "features/bit-rot",
+          .option     = "signature-type",
+          .op_version = GD_OP_VERSION_4_2_0,
+        },
         /* Upcall translator options */
         { .key         = "features.cache-invalidation",
           .voltype     = "features/upcall",
@@ -3820,6 +3901,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = GD_OP_VERSION_3_13_0,
           .flags      = VOLOPT_FLAG_CLIENT_OPT
         },
+        { .key        = "disperse.self-heal-parallel-windows",
+          .voltype    = "cluster/disperse",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "disperse.heal-dirty-ranges",
+          .voltype    = "cluster/disperse",
+          .op_version = GD_OP_VERSION_4_2_0,
+          .flags      = VOLOPT_FLAG_CLIENT_OPT
+        },
         { .key         = "features.sdfs",
           .voltype     = "features/sdfs",
           .value       = "on",
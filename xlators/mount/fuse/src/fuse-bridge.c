@@ -300,6 +300,128 @@ send_fuse_data (xlator_t *this, fuse_in_header_t *finh, void *data, size_t size)
         return ret;
 }
 
+#ifdef GF_LINUX_HOST_OS
+/*
+ * READ replies can go through a pipe: vmsplice() the header and the iobufs
+ * into it and splice() the lot into /dev/fuse. Every thread sending replies
+ * gets its own pipe, sized for a full READ; pipe[2] is its capacity.
+ */
+static void
+fuse_splice_pipe_destroy (void *data)
+{
+        int *pipefd = data;
+
+        sys_close (pipefd[0]);
+        sys_close (pipefd[1]);
+        GF_FREE (pipefd);
+}
+
+static int *
+fuse_splice_pipe_get (fuse_private_t *priv)
+{
+        int  *pipefd = NULL;
+        long  page   = sysconf (_SC_PAGESIZE);
+
+        pipefd = pthread_getspecific (priv->splice_pipe_key);
+        if (pipefd)
+                return pipefd;
+
+        pipefd = GF_CALLOC (3, sizeof (*pipefd), gf_fuse_mt_splice_pipe);
+        if (!pipefd)
+                return NULL;
+
+        if (pipe (pipefd) < 0) {
+                gf_log ("glusterfs-fuse", GF_LOG_WARNING,
+                        "failed to create splice pipe (%s)", strerror (errno));
+                GF_FREE (pipefd);
+                return NULL;
+        }
+
+        /* the header and a READ reply starting at any page offset */
+        (void) fcntl (pipefd[1], F_SETPIPE_SZ, priv->max_write + 2 * page);
+        pipefd[2] = fcntl (pipefd[1], F_GETPIPE_SZ);
+
+        if (pipefd[2] < 0 ||
+            pthread_setspecific (priv->splice_pipe_key, pipefd) != 0) {
+                fuse_splice_pipe_destroy (pipefd);
+                return NULL;
+        }
+
+        return pipefd;
+}
+
+static void
+fuse_splice_pipe_drop (fuse_private_t *priv, int *pipefd)
+{
+        pthread_setspecific (priv->splice_pipe_key, NULL);
+        fuse_splice_pipe_destroy (pipefd);
+}
+
+/*
+ * Same as send_fuse_iov (), falling back to it whenever the reply does not
+ * fit in the pipe or splicing is not possible.
+ */
+static int
+send_fuse_iov_splice (xlator_t *this, fuse_in_header_t *finh,
+                      struct iovec *iov_out, int count)
+{
+        fuse_private_t         *priv   = this->private;
+        struct fuse_out_header *fouh   = NULL;
+        int                    *pipefd = NULL;
+        long                    page   = sysconf (_SC_PAGESIZE);
+        long                    bufs   = 0;
+        ssize_t                 res    = 0;
+        int                     i      = 0;
+
+        if (!priv->splice_read)
+                return send_fuse_iov (this, finh, iov_out, count);
+
+        fouh = iov_out[0].iov_base;
+        iov_out[0].iov_len = sizeof (*fouh);
+        fouh->len = 0;
+        for (i = 0; i < count; i++) {
+                fouh->len += iov_out[i].iov_len;
+                /* vmsplice uses a pipe buffer per page touched */
+                bufs += ((uintptr_t)iov_out[i].iov_base % page +
+                         iov_out[i].iov_len + page - 1) / page;
+        }
+        fouh->unique = finh->unique;
+
+        pipefd = fuse_splice_pipe_get (priv);
+        if (!pipefd || bufs > pipefd[2] / page)
+                return send_fuse_iov (this, finh, iov_out, count);
+
+        res = vmsplice (pipefd[1], iov_out, count, SPLICE_F_NONBLOCK);
+        if (res != fouh->len) {
+                /* whatever got in would be sent with the next reply */
+                fuse_splice_pipe_drop (priv, pipefd);
+                return send_fuse_iov (this, finh, iov_out, count);
+        }
+
+        res = splice (pipefd[0], NULL, priv->fd, NULL, fouh->len,
+                      SPLICE_F_MOVE);
+        gf_log ("glusterfs-fuse", GF_LOG_TRACE, "splice() result %zd/%d %s",
+                res, fouh->len, res == -1 ? strerror (errno) : "");
+
+        if (res == -1 && errno == EINVAL) {
+                /* /dev/fuse can't be spliced to, nothing was sent */
+                gf_log ("glusterfs-fuse", GF_LOG_WARNING, "splice to fuse "
+                        "device failed, sending READ replies with writev");
+                priv->splice_read = _gf_false;
+                fuse_splice_pipe_drop (priv, pipefd);
+                return send_fuse_iov (this, finh, iov_out, count);
+        }
+
+        /* the pipe may still hold (part of) the reply */
+        if (res != fouh->len)
+                fuse_splice_pipe_drop (priv, pipefd);
+
+        return check_and_dump_fuse_W (priv, iov_out, count, res);
+}
+#else
+#define send_fuse_iov_splice send_fuse_iov
+#endif
+
 #define send_fuse_obj(this, finh, obj) \
         send_fuse_data (this, finh, obj, sizeof (*(obj)))
 
@@ -2396,7 +2518,7 @@ fuse_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         fouh.error = 0;
                         iov_out[0].iov_base = &fouh;
                         memcpy (iov_out + 1, vector, count * sizeof (*iov_out));
-                        send_fuse_iov (this, finh, iov_out, count + 1);
+                        send_fuse_iov_splice (this, finh, iov_out, count + 1);
                         GF_FREE (iov_out);
                 } else
                         send_fuse_err (this, finh, ENOMEM);
@@ -4151,6 +4273,7 @@ fuse_init (xlator_t *this, fuse_in_header_t *finh, void *msg,
         struct fuse_init_out  fino      = {0,};
         fuse_private_t       *priv      = NULL;
         size_t                size      = 0;
+        long                  page      = 0;
         int                   ret       = 0;
 #if FUSE_KERNEL_MINOR_VERSION >= 9
         pthread_t             messenger;
@@ -4180,9 +4303,21 @@ fuse_init (xlator_t *this, fuse_in_header_t *finh, void *msg,
 
         fino.major = FUSE_KERNEL_VERSION;
         fino.minor = FUSE_KERNEL_MINOR_VERSION;
-        fino.max_readahead = 1 << 17;
-        fino.max_write = 1 << 17;
         fino.flags = FUSE_ASYNC_READ | FUSE_POSIX_LOCKS;
+
+        /* Without FUSE_MAX_PAGES the kernel splits READ and WRITE at 32
+         * pages no matter what max_write says, ask for enough pages to
+         * carry max-write instead. */
+        if (fini->minor >= 6 /* fuse_init_in has flags */ &&
+            fini->flags & FUSE_MAX_PAGES) {
+                page = sysconf (_SC_PAGESIZE);
+                fino.flags |= FUSE_MAX_PAGES;
+                fino.max_pages = (priv->max_write + page - 1) / page;
+        } else if (priv->max_write > FUSE_DEFAULT_MAX_WRITE) {
+                priv->max_write = FUSE_DEFAULT_MAX_WRITE;
+        }
+        fino.max_readahead = priv->max_write;
+        fino.max_write = priv->max_write;
 #if FUSE_KERNEL_MINOR_VERSION >= 17
 	if (fini->minor >= 17)
 		fino.flags |= FUSE_FLOCK_LOCKS;
@@ -4309,9 +4444,9 @@ fuse_init (xlator_t *this, fuse_in_header_t *finh, void *msg,
         if (ret == 0)
                 gf_log ("glusterfs-fuse", GF_LOG_INFO,
                         "FUSE inited with protocol versions:"
-                        " glusterfs %d.%d kernel %d.%d",
+                        " glusterfs %d.%d kernel %d.%d, max_write %"PRIu64,
                         FUSE_KERNEL_VERSION, FUSE_KERNEL_MINOR_VERSION,
-                        fini->major, fini->minor);
+                        fini->major, fini->minor, priv->max_write);
         else {
                 gf_log ("glusterfs-fuse", GF_LOG_ERROR,
                         "FUSE init failed (%s)", strerror (ret));
@@ -5016,8 +5151,6 @@ fuse_thread_proc (void *data)
         THIS = this;
 
         iov_in[0].iov_len = sizeof (*finh) + sizeof (struct fuse_write_in);
-        iov_in[1].iov_len = ((struct iobuf_pool *)this->ctx->iobuf_pool)
-                              ->default_page_size;
         priv->msg0_len_p = &iov_in[0].iov_len;
 
         for (;;) {
@@ -5070,11 +5203,12 @@ fuse_thread_proc (void *data)
                 if (priv->init_recvd)
                         fuse_graph_sync (this);
 
-                /* TODO: This place should always get maximum supported buffer
-                   size from 'fuse', which is as of today 128KB. If we bring in
-                   support for higher block sizes support, then we should be
-                   changing this one too */
-                iobuf = iobuf_get (this->ctx->iobuf_pool);
+                /* The payload of a WRITE goes in here, so it has to
+                   take max_write. That is settled by INIT, which is
+                   handled by this thread, so it can't change during a
+                   readv. */
+                iov_in[1].iov_len = priv->max_write;
+                iobuf = iobuf_get2 (this->ctx->iobuf_pool, priv->max_write);
 
                 /* Add extra 128 byte to the first iov so that it can
                  * accommodate "ordinary" non-write requests. It's not
@@ -5283,6 +5417,8 @@ fuse_priv_dump (xlator_t  *this)
         gf_proc_dump_write("reverse_thread_started", "%d",
                            (int)private->reverse_fuse_thread_started);
         gf_proc_dump_write("use_readdirp", "%d", private->use_readdirp);
+        gf_proc_dump_write("max_write", "%"PRIu64, private->max_write);
+        gf_proc_dump_write("splice_read", "%d", (int)private->splice_read);
 
         return 0;
 }
@@ -5820,6 +5956,21 @@ init (xlator_t *this_xl)
         GF_OPTION_INIT("attr-times-granularity", priv->attr_times_granularity,
 	               int32, cleanup_exit);
 
+        GF_OPTION_INIT ("max-write", priv->max_write, size_uint64,
+                        cleanup_exit);
+        GF_OPTION_INIT ("splice-read", priv->splice_read, bool, cleanup_exit);
+#ifdef GF_LINUX_HOST_OS
+        if (priv->splice_read &&
+            pthread_key_create (&priv->splice_pipe_key,
+                                fuse_splice_pipe_destroy) != 0) {
+                gf_log (this_xl->name, GF_LOG_WARNING, "failed to create "
+                        "splice pipe key, READ replies use writev");
+                priv->splice_read = _gf_false;
+        }
+#else
+        priv->splice_read = _gf_false;
+#endif
+
         /* user has set only background-qlen, not congestion-threshold,
            use the fuse kernel driver formula to set congestion. ie, 75% */
         if (dict_get (this_xl->options, "background-qlen") &&
@@ -6155,5 +6306,21 @@ struct volume_options options[] = {
           .max = 1000000000,
           .description = "Supported granularity of file attribute times.",
         },
+        { .key = {"max-write"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .default_value = "1MB",
+          .min = 4 * GF_UNIT_KB,
+          .max = 1 * GF_UNIT_MB,
+          .description = "Largest READ and WRITE the kernel sends, and the "
+          "readahead of the mount. Above 128KB this needs a kernel that "
+          "supports FUSE_MAX_PAGES (4.20 and newer), older ones stay at "
+          "128KB.",
+        },
+        { .key = {"splice-read"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "false",
+          .description = "Send READ replies to the kernel with vmsplice and "
+          "splice through a pipe instead of writev.",
+        },
         { .key = {NULL} },
 };
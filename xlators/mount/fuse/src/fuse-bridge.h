@@ -151,6 +151,14 @@ struct fuse_private {
         /* Writeback cache support */
         gf_boolean_t         kernel_writeback_cache;
         int                  attr_times_granularity;
+
+        /* largest READ/WRITE payload, lowered to FUSE_DEFAULT_MAX_WRITE
+           at INIT if the kernel can't take more pages per request */
+        uint64_t             max_write;
+
+        /* send READ replies through a per thread pipe */
+        gf_boolean_t         splice_read;
+        pthread_key_t        splice_pipe_key;
 };
 typedef struct fuse_private fuse_private_t;
 
@@ -175,6 +183,9 @@ typedef struct fuse_graph_switch_args fuse_graph_switch_args_t;
 
 #define FUSE_EVENT_HISTORY_SIZE 1024
 
+/* what the kernel accepts without FUSE_MAX_PAGES (32 pages) */
+#define FUSE_DEFAULT_MAX_WRITE (128 * GF_UNIT_KB)
+
 #define _FH_TO_FD(fh) ((fd_t *)(uintptr_t)(fh))
 
 #define FH_TO_FD(fh) ((_FH_TO_FD (fh))?(fd_ref (_FH_TO_FD (fh))):((fd_t *) 0))
@@ -24,6 +24,7 @@ enum gf_fuse_mem_types_ {
 	gf_fuse_mt_gids_t,
         gf_fuse_mt_invalidate_node_t,
         gf_fuse_mt_pthread_t,
+        gf_fuse_mt_splice_pipe,
         gf_fuse_mt_end
 };
 #endif
@@ -534,6 +534,15 @@ ioc_get_priority (ioc_table_t *table, const char *path)
         return priority;
 }
 
+static int32_t
+ioc_policy_from_str (const char *policy)
+{
+        if (policy && strcmp (policy, "2q") == 0)
+                return IOC_POLICY_2Q;
+
+        return IOC_POLICY_LRU;
+}
+
 /*
  * ioc_open_cbk - open callback for io cache
  *
@@ -971,7 +980,14 @@ ioc_dispatch_requests (call_frame_t *frame, ioc_inode_t *ioc_inode, fd_t *fd,
                         trav_size = min (((offset+size) - local_offset),
                                          table->page_size);
 
-                        if (!trav) {
+                        if (trav) {
+                                ioc_inode->hits++;
+                                GF_ATOMIC_INC (table->hits);
+                                __ioc_page_access (trav);
+                        } else {
+                                ioc_inode->misses++;
+                                GF_ATOMIC_INC (table->misses);
+
                                 /* page not in cache, we need to generate page
                                  * fault
                                  */
@@ -1183,12 +1199,15 @@ ioc_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
 
         weight = ioc_inode->weight;
 
-        ioc_table_lock (ioc_inode->table);
-        {
-                list_move_tail (&ioc_inode->inode_lru,
-                                &ioc_inode->table->inode_lru[weight]);
+        /* the 2Q queues order pages by themselves */
+        if (table->policy != IOC_POLICY_2Q) {
+                ioc_table_lock (ioc_inode->table);
+                {
+                        list_move_tail (&ioc_inode->inode_lru,
+                                        &ioc_inode->table->inode_lru[weight]);
+                }
+                ioc_table_unlock (ioc_inode->table);
         }
-        ioc_table_unlock (ioc_inode->table);
 
         ioc_dispatch_requests (frame, ioc_inode, fd, offset, size);
         return 0;
@@ -1494,6 +1513,35 @@ ioc_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
        return 0;
 }
 
+static int32_t
+ioc_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                         struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                         dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno, stbuf,
+                             prebuf_dst, postbuf_dst, xdata);
+        return 0;
+}
+
+static int32_t
+ioc_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags, dict_t *xdata)
+{
+        uint64_t ioc_inode = 0;
+
+        inode_ctx_get (fd_out->inode, this, &ioc_inode);
+
+        if (ioc_inode)
+                ioc_inode_flush ((ioc_inode_t *)(long)ioc_inode);
+
+        STACK_WIND (frame, ioc_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+        return 0;
+}
+
 
 int32_t
 ioc_get_priority_list (const char *opt_str, struct list_head *first)
@@ -1657,6 +1705,7 @@ reconfigure (xlator_t *this, dict_t *options)
         ioc_table_t *table             = NULL;
         int          ret               = -1;
         uint64_t      cache_size_new    = 0;
+        char        *policy            = NULL;
         if (!this || !this->private)
                 goto out;
 
@@ -1670,6 +1719,11 @@ reconfigure (xlator_t *this, dict_t *options)
                 GF_OPTION_RECONF ("cache-timeout", table->cache_timeout,
                                   options, int32, unlock);
 
+                /* before the size checks, which give up on the rest */
+                GF_OPTION_RECONF ("cache-policy", policy, options, str,
+                                  unlock);
+                table->policy = ioc_policy_from_str (policy);
+
                 data = dict_get (options, "priority");
                 if (data) {
                         char *option_list = data_to_str (data);
@@ -1713,6 +1767,7 @@ reconfigure (xlator_t *this, dict_t *options)
                         goto unlock;
                 }
                 table->cache_size = cache_size_new;
+                ioc_shards_resize (table);
 
                 ret = 0;
         }
@@ -1738,6 +1793,7 @@ init (xlator_t *this)
         glusterfs_ctx_t *ctx               = NULL;
         data_t          *data              = 0;
         uint32_t         num_pages         = 0;
+        char            *policy            = NULL;
 
         xl_options = this->options;
 
@@ -1775,6 +1831,9 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("max-file-size", table->max_file_size, size_uint64, out);
 
+        GF_OPTION_INIT ("cache-policy", policy, str, out);
+        table->policy = ioc_policy_from_str (policy);
+
         if  (!check_cache_size_ok (this, table->cache_size)) {
                 ret = -1;
                 goto out;
@@ -1828,7 +1887,15 @@ init (xlator_t *this)
                 goto out;
         }
 
+        if (ioc_shards_init (table)) {
+                gf_msg (this->name, GF_LOG_ERROR, ENOMEM,
+                        IO_CACHE_MSG_NO_MEMORY,
+                        "failed to allocate the page replacement shards");
+                goto out;
+        }
+
         pthread_mutex_init (&table->table_lock, NULL);
+        pthread_mutex_init (&table->prune_lock, NULL);
         this->private = table;
 
         num_pages = (table->cache_size / table->page_size)
@@ -1850,6 +1917,7 @@ init (xlator_t *this)
 out:
         if (ret == -1) {
                 if (table != NULL) {
+                        ioc_shards_fini (table);
                         GF_FREE (table->inode_lru);
                         GF_FREE (table);
                 }
@@ -2009,6 +2077,11 @@ ioc_inode_dump (xlator_t *this, inode_t *inode)
                 __inode_path (ioc_inode->inode, NULL, &path);
 
                 gf_proc_dump_write ("inode.weight", "%d", ioc_inode->weight);
+                gf_proc_dump_write ("inode.hits", "%"PRIu64, ioc_inode->hits);
+                gf_proc_dump_write ("inode.misses", "%"PRIu64,
+                                    ioc_inode->misses);
+                gf_proc_dump_write ("inode.ghost_hits", "%"PRIu64,
+                                    ioc_inode->ghost_hits);
 
                 if (path) {
                         gf_proc_dump_write ("path", "%s", path);
@@ -2041,6 +2114,9 @@ ioc_priv_dump (xlator_t *this)
         char         key_prefix[GF_DUMP_MAX_BUF_LEN] = {0, };
         int          ret                             = -1;
         gf_boolean_t add_section                     = _gf_false;
+        uint64_t     a1in                            = 0;
+        uint64_t     am                              = 0;
+        int          i                               = 0;
 
         if (!this || !this->private)
                 goto out;
@@ -2062,6 +2138,22 @@ ioc_priv_dump (xlator_t *this)
                 gf_proc_dump_write ("cache_timeout", "%u", priv->cache_timeout);
                 gf_proc_dump_write ("min-file-size", "%u", priv->min_file_size);
                 gf_proc_dump_write ("max-file-size", "%u", priv->max_file_size);
+                gf_proc_dump_write ("cache_policy", "%s",
+                                    priv->policy == IOC_POLICY_2Q ? "2q" :
+                                    "lru");
+                gf_proc_dump_write ("hits", "%"PRIu64,
+                                    GF_ATOMIC_GET (priv->hits));
+                gf_proc_dump_write ("misses", "%"PRIu64,
+                                    GF_ATOMIC_GET (priv->misses));
+                gf_proc_dump_write ("ghost_hits", "%"PRIu64,
+                                    GF_ATOMIC_GET (priv->ghost_hits));
+                /* read without the shard locks */
+                for (i = 0; i < IOC_SHARD_COUNT; i++) {
+                        a1in += priv->shards[i].a1in_count;
+                        am += priv->shards[i].am_count;
+                }
+                gf_proc_dump_write ("a1in_pages", "%"PRIu64, a1in);
+                gf_proc_dump_write ("am_pages", "%"PRIu64, am);
         }
         pthread_mutex_unlock (&priv->table_lock);
 out:
@@ -2118,6 +2210,8 @@ fini (xlator_t *this)
 
         GF_ASSERT (list_empty (&table->inodes));
         */
+        ioc_shards_fini (table);
+        pthread_mutex_destroy (&table->prune_lock);
         pthread_mutex_destroy (&table->table_lock);
         GF_FREE (table);
 
@@ -2140,6 +2234,7 @@ struct xlator_fops fops = {
         .readdirp    = ioc_readdirp,
 	.discard     = ioc_discard,
         .zerofill    = ioc_zerofill,
+        .copy_file_range = ioc_copy_file_range,
 };
 
 
@@ -2209,5 +2304,20 @@ struct volume_options options[] = {
           .tags = {"io-cache"},
           .description = "Enable/Disable io cache translator"
         },
+        { .key  = {"cache-policy"},
+          .type = GF_OPTION_TYPE_STR,
+          .default_value = "lru",
+          .value = {"lru", "2q"},
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+          .tags = {"io-cache"},
+          .description = "How pages are chosen for eviction. \"lru\" "
+          "evicts the least recently used pages of the files of the lowest "
+          "priority first. \"2q\" keeps the pages that are read again "
+          "apart from those read once, so that a large sequential read does "
+          "not push the working set of other applications out of the "
+          "cache. With \"2q\" the priorities only decide which files are "
+          "cached at all."
+        },
         { .key = {NULL} },
 };
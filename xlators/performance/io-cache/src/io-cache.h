@@ -29,12 +29,26 @@
 #define IOC_PAGE_SIZE    (1024 * 128)   /* 128KB */
 #define IOC_CACHE_SIZE   (32 * 1024 * 1024)
 #define IOC_PAGE_TABLE_BUCKET_COUNT 1
+#define IOC_SHARD_COUNT  16             /* power of 2 */
+#define IOC_EVICT_TRIES  32             /* pages looked at per eviction */
 
 struct ioc_table;
 struct ioc_local;
 struct ioc_page;
 struct ioc_inode;
 
+enum ioc_policy {
+        IOC_POLICY_LRU = 0,
+        IOC_POLICY_2Q,
+};
+
+/* which queue of its shard a page is on, with cache-policy 2q */
+enum ioc_queue {
+        IOC_QUEUE_NONE = 0,
+        IOC_QUEUE_A1IN,
+        IOC_QUEUE_AM,
+};
+
 struct ioc_priority {
         struct list_head list;
         char             *pattern;
@@ -114,8 +128,42 @@ struct ioc_page {
         pthread_mutex_t     page_lock;
         int32_t             op_errno;
         char                stale;
+        char                queue;      /* enum ioc_queue */
+        struct list_head    page_q;     /* on the queue of its shard */
+        uint64_t            key;        /* hash of gfid and offset */
 };
 
+/* A page evicted from a1in, remembered by its key only */
+struct ioc_ghost {
+        struct list_head  hash;
+        uint64_t          key;          /* 0 if the slot is free */
+};
+
+/*
+ * 2Q page replacement. A page read for the first time goes to a1in, a FIFO,
+ * and stays there whatever the reads that follow: those come from the same
+ * sequential read more often than not. When it is pushed out of a1in its
+ * key is remembered on the ghost ring, and a page faulted again while its
+ * ghost is still there has proven to be reused and goes to am, an LRU. a1in
+ * is kept to a quarter of the pages of a shard, so that a scan only ever
+ * replaces a1in pages and the reused pages in am stay cached.
+ *
+ * Pages are spread over the shards by file and offset. Lock order is
+ * inode_lock, then the shard lock; pruning takes a shard lock first and so
+ * only trylocks the inode of the page it evicts.
+ */
+struct ioc_shard {
+        pthread_mutex_t   lock;
+        struct list_head  a1in;         /* oldest first */
+        struct list_head  am;           /* least recently used first */
+        uint32_t          a1in_count;
+        uint32_t          am_count;
+        struct ioc_ghost *ghosts;       /* ring, oldest at ghost_next */
+        struct list_head *ghost_hash;   /* ghost_max buckets */
+        uint32_t          ghost_max;
+        uint32_t          ghost_next;
+} __attribute__ ((aligned (64)));
+
 struct ioc_cache {
         rbthash_table_t  *page_table;
         struct list_head  page_lru;
@@ -146,6 +194,9 @@ struct ioc_inode {
                                              * on each read
                                              */
         inode_t               *inode;
+        uint64_t               hits;        /* under inode_lock */
+        uint64_t               misses;
+        uint64_t               ghost_hits;
 };
 
 struct ioc_table {
@@ -165,6 +216,14 @@ struct ioc_table {
         int32_t          cache_timeout;
         int32_t          max_pri;
         struct mem_pool  *mem_pool;
+
+        int32_t           policy;       /* enum ioc_policy */
+        struct ioc_shard *shards;       /* IOC_SHARD_COUNT */
+        pthread_mutex_t   prune_lock;
+        gf_atomic_t       prune_shard;
+        gf_atomic_t       hits;
+        gf_atomic_t       misses;
+        gf_atomic_t       ghost_hits;
 };
 
 typedef struct ioc_table ioc_table_t;
@@ -329,4 +388,16 @@ ioc_prune (ioc_table_t *table);
 int32_t
 ioc_need_prune (ioc_table_t *table);
 
+void
+__ioc_page_access (ioc_page_t *page);
+
+int
+ioc_shards_init (ioc_table_t *table);
+
+int
+ioc_shards_resize (ioc_table_t *table);
+
+void
+ioc_shards_fini (ioc_table_t *table);
+
 #endif /* __IO_CACHE_H */
@@ -31,6 +31,159 @@ out:
 }
 
 
+static uint64_t
+ioc_page_key (ioc_inode_t *ioc_inode, off_t offset)
+{
+        uint64_t gfid[2] = {0, };
+        uint64_t key     = 0;
+
+        memcpy (gfid, ioc_inode->inode->gfid, sizeof (gfid));
+
+        key = gfid[0] ^ gfid[1] ^ ((uint64_t)offset * 0x9e3779b97f4a7c15ULL);
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+
+        return key ? key : 1;
+}
+
+
+static struct ioc_shard *
+ioc_page_shard (ioc_page_t *page)
+{
+        return &page->inode->table->shards[page->key & (IOC_SHARD_COUNT - 1)];
+}
+
+
+static gf_boolean_t
+__ioc_ghost_take (struct ioc_shard *shard, uint64_t key)
+{
+        struct ioc_ghost *ghost = NULL;
+
+        if (!shard->ghost_max)
+                return _gf_false;
+
+        list_for_each_entry (ghost, &shard->ghost_hash[(key >> 32) %
+                                                       shard->ghost_max],
+                             hash) {
+                if (ghost->key == key) {
+                        list_del_init (&ghost->hash);
+                        ghost->key = 0;
+                        return _gf_true;
+                }
+        }
+
+        return _gf_false;
+}
+
+
+static void
+__ioc_ghost_add (struct ioc_shard *shard, uint64_t key)
+{
+        struct ioc_ghost *ghost = NULL;
+
+        if (!shard->ghost_max)
+                return;
+
+        /* forget the oldest ghost, the ring is full once it has wrapped */
+        ghost = &shard->ghosts[shard->ghost_next];
+        shard->ghost_next = (shard->ghost_next + 1) % shard->ghost_max;
+        if (ghost->key)
+                list_del (&ghost->hash);
+
+        ghost->key = key;
+        list_add (&ghost->hash,
+                  &shard->ghost_hash[(key >> 32) % shard->ghost_max]);
+}
+
+
+static void
+__ioc_page_unqueue (struct ioc_shard *shard, ioc_page_t *page)
+{
+        list_del_init (&page->page_q);
+
+        if (page->queue == IOC_QUEUE_AM)
+                shard->am_count--;
+        else
+                shard->a1in_count--;
+
+        page->queue = IOC_QUEUE_NONE;
+}
+
+
+/*
+ * ioc_page_enqueue - put a new page on a1in, or on am if its ghost says it
+ *                    was evicted from a1in not long ago. returns whether it
+ *                    had a ghost.
+ *
+ * inode_lock of the page is held.
+ */
+static gf_boolean_t
+ioc_page_enqueue (ioc_page_t *page)
+{
+        struct ioc_shard *shard = NULL;
+        gf_boolean_t      ghost = _gf_false;
+
+        shard = ioc_page_shard (page);
+
+        pthread_mutex_lock (&shard->lock);
+        {
+                ghost = __ioc_ghost_take (shard, page->key);
+                if (ghost) {
+                        page->queue = IOC_QUEUE_AM;
+                        list_add_tail (&page->page_q, &shard->am);
+                        shard->am_count++;
+                } else {
+                        page->queue = IOC_QUEUE_A1IN;
+                        list_add_tail (&page->page_q, &shard->a1in);
+                        shard->a1in_count++;
+                }
+        }
+        pthread_mutex_unlock (&shard->lock);
+
+        return ghost;
+}
+
+
+static void
+ioc_page_unqueue (ioc_page_t *page)
+{
+        struct ioc_shard *shard = NULL;
+
+        shard = ioc_page_shard (page);
+
+        pthread_mutex_lock (&shard->lock);
+        {
+                __ioc_page_unqueue (shard, page);
+        }
+        pthread_mutex_unlock (&shard->lock);
+}
+
+
+/*
+ * __ioc_page_access - a read found this page in the cache. only pages on am
+ *                     move, a1in is a FIFO.
+ *
+ * inode_lock of the page is held.
+ */
+void
+__ioc_page_access (ioc_page_t *page)
+{
+        struct ioc_shard *shard = NULL;
+
+        if (page->queue != IOC_QUEUE_AM)
+                return;
+
+        shard = ioc_page_shard (page);
+
+        pthread_mutex_lock (&shard->lock);
+        {
+                list_move_tail (&page->page_q, &shard->am);
+        }
+        pthread_mutex_unlock (&shard->lock);
+}
+
+
 ioc_page_t *
 __ioc_page_get (ioc_inode_t *ioc_inode, off_t offset)
 {
@@ -102,6 +255,8 @@ __ioc_page_destroy (ioc_page_t *page)
                 rbthash_remove (page->inode->cache.page_table, &page->offset,
                                 sizeof (page->offset));
                 list_del (&page->page_lru);
+                if (page->queue != IOC_QUEUE_NONE)
+                        ioc_page_unqueue (page);
 
                 gf_msg_trace (page->inode->table->xl->name, 0,
                               "destroying page = %p, offset = %"PRId64" "
@@ -186,6 +341,105 @@ __ioc_inode_prune (ioc_inode_t *curr, uint64_t *size_pruned,
 out:
         return 0;
 }
+/* Evicts the first page of @queue that nobody uses, returns its size or -1. */
+static int64_t
+__ioc_shard_evict (struct ioc_shard *shard, struct list_head *queue)
+{
+        ioc_page_t  *page      = NULL;
+        ioc_inode_t *ioc_inode = NULL;
+        int64_t      ret       = -1;
+        int          tries     = 0;
+
+        list_for_each_entry (page, queue, page_q) {
+                if (tries++ == IOC_EVICT_TRIES)
+                        break;
+
+                ioc_inode = page->inode;
+                if (pthread_mutex_trylock (&ioc_inode->inode_lock))
+                        continue;
+
+                if (page->ready && !page->waitq) {
+                        if (page->queue == IOC_QUEUE_A1IN)
+                                __ioc_ghost_add (shard, page->key);
+                        __ioc_page_unqueue (shard, page);
+                        ret = __ioc_page_destroy (page);
+                }
+                pthread_mutex_unlock (&ioc_inode->inode_lock);
+
+                if (ret != -1)
+                        break;
+        }
+
+        return ret;
+}
+
+/*
+ * ioc_prune_2q - evict pages through the 2Q queues, a page from each shard
+ *                in turn, until the cache fits. returns 0 if it could not
+ *                get there.
+ */
+static int
+ioc_prune_2q (ioc_table_t *table)
+{
+        struct ioc_shard *shard         = NULL;
+        struct list_head *queue         = NULL;
+        int64_t           size_to_prune = 0;
+        int64_t           size_pruned   = 0;
+        int64_t           ret           = 0;
+        uint32_t          idle          = 0;
+
+        /* somebody else is at it */
+        if (pthread_mutex_trylock (&table->prune_lock))
+                return 1;
+
+        ioc_table_lock (table);
+        {
+                size_to_prune = table->cache_used - table->cache_size;
+        }
+        ioc_table_unlock (table);
+
+        while (size_pruned < size_to_prune && idle < IOC_SHARD_COUNT) {
+                shard = &table->shards[GF_ATOMIC_INC (table->prune_shard) &
+                                       (IOC_SHARD_COUNT - 1)];
+
+                pthread_mutex_lock (&shard->lock);
+                {
+                        if (shard->a1in_count * 4 >
+                            shard->a1in_count + shard->am_count)
+                                queue = &shard->a1in;
+                        else
+                                queue = &shard->am;
+
+                        ret = __ioc_shard_evict (shard, queue);
+                        if (ret == -1)
+                                ret = __ioc_shard_evict (shard,
+                                                         queue == &shard->am ?
+                                                         &shard->a1in :
+                                                         &shard->am);
+                }
+                pthread_mutex_unlock (&shard->lock);
+
+                if (ret == -1) {
+                        idle++;
+                } else {
+                        idle = 0;
+                        size_pruned += ret;
+                }
+        }
+
+        if (size_pruned) {
+                ioc_table_lock (table);
+                {
+                        table->cache_used -= size_pruned;
+                }
+                ioc_table_unlock (table);
+        }
+
+        pthread_mutex_unlock (&table->prune_lock);
+
+        return size_pruned >= size_to_prune;
+}
+
 /*
  * ioc_prune - prune the cache. we have a limit to the number of pages we
  *             can have in-memory.
@@ -203,6 +457,11 @@ ioc_prune (ioc_table_t *table)
 
         GF_VALIDATE_OR_GOTO ("io-cache", table, out);
 
+        /* pages cached before cache-policy was set to 2q are not on any
+         * queue, the walk below gets them */
+        if (table->policy == IOC_POLICY_2Q && ioc_prune_2q (table))
+                goto out;
+
         ioc_table_lock (table);
         {
                 size_to_prune = table->cache_used - table->cache_size;
@@ -272,12 +531,21 @@ __ioc_page_create (ioc_inode_t *ioc_inode, off_t offset)
         newpage->offset = rounded_offset;
         newpage->inode = ioc_inode;
         pthread_mutex_init (&newpage->page_lock, NULL);
+        INIT_LIST_HEAD (&newpage->page_q);
 
         rbthash_insert (ioc_inode->cache.page_table, newpage, &rounded_offset,
                         sizeof (rounded_offset));
 
         list_add_tail (&newpage->page_lru, &ioc_inode->cache.page_lru);
 
+        if (table->policy == IOC_POLICY_2Q) {
+                newpage->key = ioc_page_key (ioc_inode, rounded_offset);
+                if (ioc_page_enqueue (newpage)) {
+                        ioc_inode->ghost_hits++;
+                        GF_ATOMIC_INC (table->ghost_hits);
+                }
+        }
+
         page = newpage;
 
         gf_msg_trace ("io-cache", 0,
@@ -1051,3 +1319,108 @@ ioc_page_error (ioc_page_t *page, int32_t op_ret, int32_t op_errno)
 out:
         return waitq;
 }
+
+/*
+ * ioc_shards_resize - size the ghost rings after the cache: ghosts of half
+ *                     as many pages as the cache holds. ghosts are lost.
+ */
+int
+ioc_shards_resize (ioc_table_t *table)
+{
+        struct ioc_shard *shard          = NULL;
+        struct ioc_ghost *ghosts         = NULL;
+        struct ioc_ghost *old_ghosts     = NULL;
+        struct list_head *ghost_hash     = NULL;
+        struct list_head *old_ghost_hash = NULL;
+        uint32_t          ghost_max      = 0;
+        uint32_t          i              = 0;
+        uint32_t          j              = 0;
+        int               ret            = 0;
+
+        ghost_max = max (table->cache_size / table->page_size / 2 /
+                         IOC_SHARD_COUNT, 16);
+
+        for (i = 0; i < IOC_SHARD_COUNT; i++) {
+                shard = &table->shards[i];
+                if (shard->ghost_max == ghost_max)
+                        continue;
+
+                ghosts = GF_CALLOC (ghost_max, sizeof (*ghosts),
+                                    gf_ioc_mt_ioc_ghost_t);
+                ghost_hash = GF_CALLOC (ghost_max, sizeof (*ghost_hash),
+                                        gf_ioc_mt_list_head);
+                if (!ghosts || !ghost_hash) {
+                        GF_FREE (ghosts);
+                        GF_FREE (ghost_hash);
+                        ret = -1;
+                        continue;
+                }
+                for (j = 0; j < ghost_max; j++)
+                        INIT_LIST_HEAD (&ghost_hash[j]);
+
+                pthread_mutex_lock (&shard->lock);
+                {
+                        old_ghosts = shard->ghosts;
+                        old_ghost_hash = shard->ghost_hash;
+                        shard->ghosts = ghosts;
+                        shard->ghost_hash = ghost_hash;
+                        shard->ghost_max = ghost_max;
+                        shard->ghost_next = 0;
+                }
+                pthread_mutex_unlock (&shard->lock);
+
+                GF_FREE (old_ghosts);
+                GF_FREE (old_ghost_hash);
+        }
+
+        return ret;
+}
+
+int
+ioc_shards_init (ioc_table_t *table)
+{
+        struct ioc_shard *shard = NULL;
+        uint32_t          i     = 0;
+
+        table->shards = GF_CALLOC (IOC_SHARD_COUNT, sizeof (*table->shards),
+                                   gf_ioc_mt_ioc_shard_t);
+        if (!table->shards)
+                return -1;
+
+        for (i = 0; i < IOC_SHARD_COUNT; i++) {
+                shard = &table->shards[i];
+                pthread_mutex_init (&shard->lock, NULL);
+                INIT_LIST_HEAD (&shard->a1in);
+                INIT_LIST_HEAD (&shard->am);
+        }
+
+        GF_ATOMIC_INIT (table->prune_shard, 0);
+        GF_ATOMIC_INIT (table->hits, 0);
+        GF_ATOMIC_INIT (table->misses, 0);
+        GF_ATOMIC_INIT (table->ghost_hits, 0);
+
+        if (ioc_shards_resize (table)) {
+                ioc_shards_fini (table);
+                return -1;
+        }
+
+        return 0;
+}
+
+void
+ioc_shards_fini (ioc_table_t *table)
+{
+        uint32_t i = 0;
+
+        if (!table->shards)
+                return;
+
+        for (i = 0; i < IOC_SHARD_COUNT; i++) {
+                pthread_mutex_destroy (&table->shards[i].lock);
+                GF_FREE (table->shards[i].ghosts);
+                GF_FREE (table->shards[i].ghost_hash);
+        }
+
+        GF_FREE (table->shards);
+        table->shards = NULL;
+}
@@ -159,6 +159,18 @@ __iot_enqueue (iot_conf_t *conf, call_stub_t *stub, int pri)
         conf->queue_sizes[pri]++;
 }
 
+static void
+iot_run_stub (xlator_t *this, call_stub_t *stub)
+{
+        if (stub->poison) {
+                gf_log (this->name, GF_LOG_INFO,
+                        "Dropping poisoned request %p.", stub);
+                call_stub_destroy (stub);
+        } else {
+                call_resume (stub);
+        }
+}
+
 void *
 iot_worker (void *data)
 {
@@ -222,15 +234,8 @@ iot_worker (void *data)
                 }
                 pthread_mutex_unlock (&conf->mutex);
 
-                if (stub) { /* guard against spurious wakeups */
-                        if (stub->poison) {
-                                gf_log (this->name, GF_LOG_INFO,
-                                        "Dropping poisoned request %p.", stub);
-                                call_stub_destroy (stub);
-                        } else {
-                                        call_resume (stub);
-                        }
-                }
+                if (stub) /* guard against spurious wakeups */
+                        iot_run_stub (this, stub);
                 stub = NULL;
 
                 if (bye)
@@ -240,11 +245,514 @@ iot_worker (void *data)
         return NULL;
 }
 
+/*
+ * Work-stealing scheduler.
+ *
+ * Every worker has its own queue (one list per priority) and its own
+ * condition variable. Producers spread requests over the queues, and a
+ * worker takes from its own queue first and steals from the others when
+ * that is empty, so the single conf->mutex is only taken to start or stop
+ * threads.
+ *
+ * idle_state counts the sleeping workers and, in units of
+ * IOT_WS_SEARCHING, the workers that are about to look at the queues.
+ * A producer queues first and then looks at idle_state; a worker going
+ * to sleep announces itself in idle_state first and then looks at the
+ * queues once more. Both are read-modify-writes of the same word, so one
+ * of the two always sees the other: either the producer wakes a sleeper
+ * or the worker finds the request. While someone is searching producers
+ * wake nobody, which keeps a burst of requests from waking every thread.
+ *
+ * Priorities are served by weighted credits: a worker takes up to
+ * iot_ws_weights[pri] requests of a priority before it has to give the
+ * lower ones a go, and refills its credits when nothing it still has
+ * credits for is queued.
+ */
+
+static const int32_t iot_ws_weights[GF_FOP_PRI_MAX] = {
+        [GF_FOP_PRI_HI]         = 8,
+        [GF_FOP_PRI_NORMAL]     = 4,
+        [GF_FOP_PRI_LO]         = 2,
+        [GF_FOP_PRI_LEAST]      = 1,
+};
+
+static __thread uint32_t iot_ws_cursor;
+
+void *iot_ws_worker (void *arg);
+
+static void
+iot_ws_credits_refill (iot_worker_t *worker)
+{
+        int     i;
+
+        for (i = 0; i < GF_FOP_PRI_MAX; i++)
+                worker->credits[i] = iot_ws_weights[i];
+}
+
+static gf_boolean_t
+iot_ws_ac_get (iot_conf_t *conf, int pri)
+{
+        int64_t active;
+
+        do {
+                active = GF_ATOMIC_GET (conf->ws_active[pri]);
+                if (active >= conf->ac_iot_limit[pri])
+                        return _gf_false;
+        } while (!GF_ATOMIC_CMP_SWAP (conf->ws_active[pri], active,
+                                      active + 1));
+
+        return _gf_true;
+}
+
+/* Counts are read without the queue lock to skip empty queues cheaply;
+ * the lock is taken before anything is removed. */
+static call_stub_t *
+iot_ws_pop (iot_conf_t *conf, iot_worker_t *worker, int pri)
+{
+        iot_queue_t     *queue = NULL;
+        call_stub_t     *stub  = NULL;
+        int              i     = 0;
+
+        for (i = 0; i < IOT_MAX_THREADS; i++) {
+                queue = &conf->queues[(worker->idx + i) % IOT_MAX_THREADS];
+                if (!queue->count[pri])
+                        continue;
+
+                pthread_mutex_lock (&queue->lock);
+                {
+                        if (!list_empty (&queue->reqs[pri])) {
+                                stub = list_first_entry (&queue->reqs[pri],
+                                                         call_stub_t, list);
+                                list_del_init (&stub->list);
+                                queue->count[pri]--;
+                        }
+                }
+                pthread_mutex_unlock (&queue->lock);
+
+                if (stub) {
+                        if (i)
+                                GF_ATOMIC_INC (conf->ws_steals);
+                        conf->queue_marked[pri] = _gf_false;
+                        break;
+                }
+        }
+
+        return stub;
+}
+
+static call_stub_t *
+iot_ws_next (iot_conf_t *conf, iot_worker_t *worker, int *pri)
+{
+        call_stub_t     *stub  = NULL;
+        int              round = 0;
+        int              i     = 0;
+
+        for (round = 0; round < 2; round++) {
+                for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+                        if (round == 0 && worker->credits[i] <= 0)
+                                continue;
+                        if (!iot_ws_ac_get (conf, i))
+                                continue;
+
+                        stub = iot_ws_pop (conf, worker, i);
+                        if (stub) {
+                                worker->credits[i]--;
+                                *pri = i;
+                                return stub;
+                        }
+                        GF_ATOMIC_DEC (conf->ws_active[i]);
+                }
+                iot_ws_credits_refill (worker);
+        }
+
+        return NULL;
+}
+
+static gf_boolean_t
+iot_ws_runnable (iot_conf_t *conf)
+{
+        int     i = 0;
+        int     j = 0;
+
+        for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+                if (GF_ATOMIC_GET (conf->ws_active[i]) >=
+                    conf->ac_iot_limit[i])
+                        continue;
+                for (j = 0; j < IOT_MAX_THREADS; j++) {
+                        if (conf->queues[j].count[i])
+                                return _gf_true;
+                }
+        }
+
+        return _gf_false;
+}
+
+static int
+iot_ws_spawn (iot_conf_t *conf)
+{
+        iot_worker_t    *worker = NULL;
+        pthread_t        thread;
+        char             thread_name[GF_THREAD_NAMEMAX] = {0,};
+        int              ret = -1;
+        int              i = 0;
+
+        /* all threads busy is the common case under load, don't take the
+         * mutex for it */
+        if (conf->curr_count >= conf->max_count)
+                return -1;
+
+        pthread_mutex_lock (&conf->mutex);
+        {
+                if (conf->down || conf->curr_count >= conf->max_count)
+                        goto unlock;
+
+                for (i = 0; i < IOT_MAX_THREADS; i++) {
+                        if (!conf->workers[i].used) {
+                                worker = &conf->workers[i];
+                                break;
+                        }
+                }
+                if (!worker)
+                        goto unlock;
+
+                worker->used = _gf_true;
+                worker->searching = _gf_true;
+                worker->woken = _gf_false;
+                iot_ws_credits_refill (worker);
+                GF_ATOMIC_ADD (conf->idle_state, IOT_WS_SEARCHING);
+
+                snprintf (thread_name, sizeof(thread_name),
+                          "iotwr%03hx", (worker->idx & 0x3ff));
+                ret = gf_thread_create (&thread, &conf->w_attr, iot_ws_worker,
+                                        worker, thread_name);
+                if (ret == 0) {
+                        conf->curr_count++;
+                        gf_msg_debug (conf->this->name, 0,
+                                      "scaled threads to %d",
+                                      conf->curr_count);
+                } else {
+                        worker->used = _gf_false;
+                        GF_ATOMIC_SUB (conf->idle_state, IOT_WS_SEARCHING);
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&conf->mutex);
+
+        return ret;
+}
+
+/* Wake the worker that went to sleep last, or start a new one if nobody
+ * is asleep. */
+static void
+iot_ws_notify (iot_conf_t *conf)
+{
+        iot_worker_t    *worker = NULL;
+
+        pthread_mutex_lock (&conf->idle_lock);
+        {
+                if (!list_empty (&conf->idle_workers)) {
+                        worker = list_first_entry (&conf->idle_workers,
+                                                   iot_worker_t, idle);
+                        list_del_init (&worker->idle);
+                        worker->searching = _gf_true;
+                        GF_ATOMIC_ADD (conf->idle_state, IOT_WS_SEARCHING - 1);
+                }
+        }
+        pthread_mutex_unlock (&conf->idle_lock);
+
+        if (!worker) {
+                iot_ws_spawn (conf);
+                return;
+        }
+
+        pthread_mutex_lock (&worker->lock);
+        {
+                worker->woken = _gf_true;
+                pthread_cond_signal (&worker->cond);
+        }
+        pthread_mutex_unlock (&worker->lock);
+
+        GF_ATOMIC_INC (conf->ws_wakeups);
+}
+
+static int
+iot_ws_schedule (iot_conf_t *conf, call_stub_t *stub, int pri)
+{
+        iot_queue_t     *queue = NULL;
+        int64_t          state = 0;
+
+        queue = &conf->queues[iot_ws_cursor++ % conf->max_count];
+
+        pthread_mutex_lock (&queue->lock);
+        {
+                list_add_tail (&stub->list, &queue->reqs[pri]);
+                queue->count[pri]++;
+        }
+        pthread_mutex_unlock (&queue->lock);
+
+        state = GF_ATOMIC_FETCH_ADD (conf->idle_state, 0);
+        if (state < IOT_WS_SEARCHING)
+                iot_ws_notify (conf);
+
+        return 0;
+}
+
+/* A worker that found something to do stops searching. If it was the last
+ * one looking and more is queued, somebody else has to take over. */
+static void
+iot_ws_found (iot_conf_t *conf, iot_worker_t *worker)
+{
+        int64_t state = 0;
+
+        if (!worker->searching)
+                return;
+
+        worker->searching = _gf_false;
+        state = GF_ATOMIC_FETCH_SUB (conf->idle_state, IOT_WS_SEARCHING);
+        if (state < 2 * IOT_WS_SEARCHING && iot_ws_runnable (conf))
+                iot_ws_notify (conf);
+}
+
+/* Once a worker has given up its slot, the slot can be handed to a new
+ * thread at any time, so the old one must not look at it again. */
+static void
+iot_ws_exit (iot_conf_t *conf, iot_worker_t *worker)
+{
+        if (worker->searching) {
+                worker->searching = _gf_false;
+                GF_ATOMIC_SUB (conf->idle_state, IOT_WS_SEARCHING);
+        }
+
+        pthread_mutex_lock (&conf->mutex);
+        {
+                worker->used = _gf_false;
+                conf->curr_count--;
+                if (conf->curr_count == 0)
+                        pthread_cond_broadcast (&conf->cond);
+        }
+        pthread_mutex_unlock (&conf->mutex);
+}
+
+static gf_boolean_t
+iot_ws_retire (iot_conf_t *conf, iot_worker_t *worker)
+{
+        gf_boolean_t    bye = _gf_false;
+
+        pthread_mutex_lock (&conf->mutex);
+        pthread_mutex_lock (&conf->idle_lock);
+        {
+                if (!list_empty (&worker->idle) &&
+                    (conf->down || conf->curr_count > IOT_MIN_THREADS)) {
+                        list_del_init (&worker->idle);
+                        GF_ATOMIC_DEC (conf->idle_state);
+                        bye = _gf_true;
+                }
+        }
+        pthread_mutex_unlock (&conf->idle_lock);
+
+        if (bye) {
+                worker->used = _gf_false;
+                conf->curr_count--;
+                if (conf->curr_count == 0)
+                        pthread_cond_broadcast (&conf->cond);
+                gf_msg_debug (conf->this->name, 0,
+                              "terminated. conf->curr_count=%d",
+                              conf->curr_count);
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
+        return bye;
+}
+
+/* Returns _gf_true when the worker has given up its slot and must exit. */
+static gf_boolean_t
+iot_ws_sleep (iot_conf_t *conf, iot_worker_t *worker)
+{
+        struct timespec sleep_till = {0, };
+        gf_boolean_t    woken      = _gf_false;
+        gf_boolean_t    bye        = _gf_false;
+        int             ret        = 0;
+
+        pthread_mutex_lock (&worker->lock);
+        worker->woken = _gf_false;
+        pthread_mutex_unlock (&worker->lock);
+
+        pthread_mutex_lock (&conf->idle_lock);
+        {
+                bye = conf->down;
+                if (!bye) {
+                        list_add (&worker->idle, &conf->idle_workers);
+                        GF_ATOMIC_ADD (conf->idle_state, worker->searching ?
+                                       1 - IOT_WS_SEARCHING : 1);
+                        worker->searching = _gf_false;
+                }
+        }
+        pthread_mutex_unlock (&conf->idle_lock);
+
+        if (bye) {
+                iot_ws_exit (conf, worker);
+                return _gf_true;
+        }
+
+        if (iot_ws_runnable (conf)) {
+                pthread_mutex_lock (&conf->idle_lock);
+                {
+                        if (!list_empty (&worker->idle)) {
+                                list_del_init (&worker->idle);
+                                worker->searching = _gf_true;
+                                GF_ATOMIC_ADD (conf->idle_state,
+                                               IOT_WS_SEARCHING - 1);
+                        }
+                }
+                pthread_mutex_unlock (&conf->idle_lock);
+                return _gf_false;
+        }
+
+        for (;;) {
+                clock_gettime (CLOCK_REALTIME_COARSE, &sleep_till);
+                sleep_till.tv_sec += conf->idle_time;
+
+                pthread_mutex_lock (&worker->lock);
+                {
+                        ret = 0;
+                        while (!worker->woken && ret != ETIMEDOUT)
+                                ret = pthread_cond_timedwait (&worker->cond,
+                                                              &worker->lock,
+                                                              &sleep_till);
+                        woken = worker->woken;
+                }
+                pthread_mutex_unlock (&worker->lock);
+
+                if (woken)
+                        return _gf_false;
+
+                if (iot_ws_retire (conf, worker))
+                        return _gf_true;
+
+                /* Either woken after all, or one of the last threads. */
+                pthread_mutex_lock (&conf->idle_lock);
+                woken = list_empty (&worker->idle);
+                pthread_mutex_unlock (&conf->idle_lock);
+                if (woken)
+                        return _gf_false;
+        }
+}
+
+void *
+iot_ws_worker (void *data)
+{
+        iot_worker_t    *worker = data;
+        iot_conf_t      *conf   = worker->conf;
+        xlator_t        *this   = conf->this;
+        call_stub_t     *stub   = NULL;
+        int              pri    = -1;
+
+        THIS = this;
+
+        for (;;) {
+                stub = iot_ws_next (conf, worker, &pri);
+                if (stub) {
+                        iot_ws_found (conf, worker);
+                        iot_run_stub (this, stub);
+                        GF_ATOMIC_DEC (conf->ws_active[pri]);
+                        continue;
+                }
+
+                if (iot_ws_sleep (conf, worker))
+                        break;
+        }
+
+        return NULL;
+}
+
+static void
+iot_ws_queued (iot_conf_t *conf, int *queued)
+{
+        int     i = 0;
+        int     j = 0;
+
+        for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+                queued[i] = 0;
+                for (j = 0; j < IOT_MAX_THREADS; j++)
+                        queued[i] += conf->queues[j].count[i];
+        }
+}
+
+static int
+iot_ws_init (iot_conf_t *conf)
+{
+        int     i = 0;
+        int     j = 0;
+
+        conf->queues = GF_CALLOC (IOT_MAX_THREADS, sizeof (*conf->queues),
+                                  gf_iot_mt_queue_t);
+        conf->workers = GF_CALLOC (IOT_MAX_THREADS, sizeof (*conf->workers),
+                                   gf_iot_mt_worker_t);
+        if (!conf->queues || !conf->workers) {
+                GF_FREE (conf->queues);
+                GF_FREE (conf->workers);
+                conf->queues = NULL;
+                conf->workers = NULL;
+                return -1;
+        }
+
+        for (i = 0; i < IOT_MAX_THREADS; i++) {
+                pthread_mutex_init (&conf->queues[i].lock, NULL);
+                for (j = 0; j < GF_FOP_PRI_MAX; j++)
+                        INIT_LIST_HEAD (&conf->queues[i].reqs[j]);
+
+                conf->workers[i].conf = conf;
+                conf->workers[i].idx = i;
+                INIT_LIST_HEAD (&conf->workers[i].idle);
+                pthread_mutex_init (&conf->workers[i].lock, NULL);
+                pthread_cond_init (&conf->workers[i].cond, NULL);
+        }
+
+        pthread_mutex_init (&conf->idle_lock, NULL);
+        INIT_LIST_HEAD (&conf->idle_workers);
+        GF_ATOMIC_INIT (conf->idle_state, 0);
+        GF_ATOMIC_INIT (conf->ws_steals, 0);
+        GF_ATOMIC_INIT (conf->ws_wakeups, 0);
+        for (i = 0; i < GF_FOP_PRI_MAX; i++)
+                GF_ATOMIC_INIT (conf->ws_active[i], 0);
+
+        return iot_ws_spawn (conf);
+}
+
+static void
+iot_ws_fini (iot_conf_t *conf)
+{
+        int     i = 0;
+
+        if (conf->workers) {
+                for (i = 0; i < IOT_MAX_THREADS; i++) {
+                        pthread_mutex_destroy (&conf->workers[i].lock);
+                        pthread_cond_destroy (&conf->workers[i].cond);
+                }
+                pthread_mutex_destroy (&conf->idle_lock);
+        }
+        if (conf->queues) {
+                for (i = 0; i < IOT_MAX_THREADS; i++)
+                        pthread_mutex_destroy (&conf->queues[i].lock);
+        }
+
+        GF_FREE (conf->queues);
+        GF_FREE (conf->workers);
+        conf->queues = NULL;
+        conf->workers = NULL;
+}
+
 int
 do_iot_schedule (iot_conf_t *conf, call_stub_t *stub, int pri)
 {
         int   ret = 0;
 
+        if (conf->work_stealing) {
+                if (pri < 0 || pri >= GF_FOP_PRI_MAX)
+                        pri = GF_FOP_PRI_MAX-1;
+                return iot_ws_schedule (conf, stub, pri);
+        }
+
         pthread_mutex_lock (&conf->mutex);
         {
                 __iot_enqueue (conf, stub, pri);
@@ -355,6 +863,7 @@ iot_schedule (call_frame_t *frame, xlator_t *this, call_stub_t *stub)
         case GF_FOP_DISCARD:
         case GF_FOP_ZEROFILL:
         case GF_FOP_SEEK:
+        case GF_FOP_COPY_FILE_RANGE:
                 pri = GF_FOP_PRI_LO;
                 break;
 
@@ -604,6 +1113,7 @@ iot_getxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
         iot_conf_t *conf = NULL;
         dict_t     *depths = NULL;
         int i = 0;
+        int queued[GF_FOP_PRI_MAX] = { 0, };
         int32_t op_ret = 0;
         int32_t op_errno = 0;
 
@@ -621,10 +1131,18 @@ iot_getxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
                         goto unwind_special_getxattr;
                 }
 
+                /* queue_sizes stays 0 with the per-thread queues */
+                pthread_mutex_lock (&conf->mutex);
+                if (conf->work_stealing)
+                        iot_ws_queued (conf, queued);
+                else
+                        memcpy (queued, conf->queue_sizes, sizeof (queued));
+                pthread_mutex_unlock (&conf->mutex);
+
                 for (i = 0; i < GF_FOP_PRI_MAX; i++) {
                         if (dict_set_int32 (depths,
                                             (char *)fop_pri_to_string (i),
-                                            conf->queue_sizes[i]) != 0) {
+                                            queued[i]) != 0) {
                                 dict_unref (depths);
                                 depths = NULL;
                                 goto unwind_special_getxattr;
@@ -808,6 +1326,16 @@ iot_setactivelk (call_frame_t *frame, xlator_t *this, loc_t *loc,
         return 0;
 }
 
+int
+iot_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags, dict_t *xdata)
+{
+        IOT_FOP (copy_file_range, frame, this, fd_in, off_in, fd_out,
+                 off_out, len, flags, xdata);
+        return 0;
+}
+
 int
 __iot_workers_scale (iot_conf_t *conf)
 {
@@ -960,6 +1488,13 @@ iot_priv_dump (xlator_t *this)
                            conf->ac_iot_limit[GF_FOP_PRI_LO]);
         gf_proc_dump_write("least_priority_threads", "%d",
                            conf->ac_iot_limit[GF_FOP_PRI_LEAST]);
+        gf_proc_dump_write("work_stealing", "%d", conf->work_stealing);
+        if (conf->work_stealing) {
+                gf_proc_dump_write("steals", "%"PRId64,
+                                   GF_ATOMIC_GET (conf->ws_steals));
+                gf_proc_dump_write("wakeups", "%"PRId64,
+                                   GF_ATOMIC_GET (conf->ws_wakeups));
+        }
 
         return 0;
 }
@@ -1050,11 +1585,16 @@ iot_watchdog (void *arg)
         int             i;
         int             bad_times[GF_FOP_PRI_MAX] = { 0, };
         threshold_t     thresholds[GF_FOP_PRI_MAX] = { { 0, } };
+        int             queued[GF_FOP_PRI_MAX] = { 0, };
 
         for (;;) {
                 sleep (max (priv->watchdog_secs/5, 1));
                 pthread_setcancelstate (PTHREAD_CANCEL_DISABLE, NULL);
                 pthread_mutex_lock (&priv->mutex);
+                if (priv->work_stealing)
+                        iot_ws_queued (priv, queued);
+                else
+                        memcpy (queued, priv->queue_sizes, sizeof (queued));
                 for (i = 0; i < GF_FOP_PRI_MAX; ++i) {
                         if (priv->queue_marked[i]) {
                                 if (++bad_times[i] >= 5) {
@@ -1071,7 +1611,7 @@ iot_watchdog (void *arg)
                         } else {
                                 bad_times[i] = 0;
                         }
-                        priv->queue_marked[i] = (priv->queue_sizes[i] > 0);
+                        priv->queue_marked[i] = (queued[i] > 0);
                 }
                 pthread_mutex_unlock (&priv->mutex);
                 pthread_setcancelstate (PTHREAD_CANCEL_ENABLE, NULL);
@@ -1248,6 +1788,8 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("pass-through", this->pass_through, bool, out);
 
+        GF_OPTION_INIT ("work-stealing", conf->work_stealing, bool, out);
+
         conf->this = this;
 
         for (i = 0; i < GF_FOP_PRI_MAX; i++) {
@@ -1256,7 +1798,10 @@ init (xlator_t *this)
                 INIT_LIST_HEAD (&conf->no_client[i].reqs);
         }
 
-	ret = iot_workers_scale (conf);
+        if (conf->work_stealing)
+                ret = iot_ws_init (conf);
+        else
+                ret = iot_workers_scale (conf);
 
         if (ret == -1) {
                 gf_msg (this->name, GF_LOG_ERROR, 0,
@@ -1275,8 +1820,10 @@ init (xlator_t *this)
 
         ret = 0;
 out:
-        if (ret)
+        if (ret && conf) {
+                iot_ws_fini (conf);
                 GF_FREE (conf);
+        }
 
 	return ret;
 }
@@ -1289,6 +1836,21 @@ iot_exit_threads (iot_conf_t *conf)
                 conf->down = _gf_true;
                 /*Let all the threads know that xl is going down*/
                 pthread_cond_broadcast (&conf->cond);
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
+        if (conf->work_stealing) {
+                pthread_mutex_lock (&conf->idle_lock);
+                while (!list_empty (&conf->idle_workers)) {
+                        pthread_mutex_unlock (&conf->idle_lock);
+                        iot_ws_notify (conf);
+                        pthread_mutex_lock (&conf->idle_lock);
+                }
+                pthread_mutex_unlock (&conf->idle_lock);
+        }
+
+        pthread_mutex_lock (&conf->mutex);
+        {
                 while (conf->curr_count)/*Wait for threads to exit*/
                         pthread_cond_wait (&conf->cond, &conf->mutex);
         }
@@ -1327,6 +1889,8 @@ fini (xlator_t *this)
 
         stop_iot_watchdog (this);
 
+        iot_ws_fini (conf);
+
 	GF_FREE (conf);
 
 	this->private = NULL;
@@ -1345,6 +1909,32 @@ iot_client_destroy (xlator_t *this, client_t *client)
 	return 0;
 }
 
+static void
+iot_ws_poison (xlator_t *this, iot_conf_t *conf, client_t *client)
+{
+        iot_queue_t     *queue = NULL;
+        call_stub_t     *curr  = NULL;
+        int              i     = 0;
+        int              j     = 0;
+
+        for (j = 0; j < IOT_MAX_THREADS; j++) {
+                queue = &conf->queues[j];
+                pthread_mutex_lock (&queue->lock);
+                for (i = 0; i < GF_FOP_PRI_MAX; i++) {
+                        list_for_each_entry (curr, &queue->reqs[i], list) {
+                                if (curr->frame->root->client != client)
+                                        continue;
+                                gf_log (this->name, GF_LOG_INFO,
+                                        "poisoning %s fop at %p for client %s",
+                                        gf_fop_list[curr->fop], curr,
+                                        client->client_uid);
+                                curr->poison = _gf_true;
+                        }
+                }
+                pthread_mutex_unlock (&queue->lock);
+        }
+}
+
 static int
 iot_disconnect_cbk (xlator_t *this, client_t *client)
 {
@@ -1358,6 +1948,11 @@ iot_disconnect_cbk (xlator_t *this, client_t *client)
                 goto out;
         }
 
+        if (conf->work_stealing) {
+                iot_ws_poison (this, conf, client);
+                goto out;
+        }
+
         pthread_mutex_lock (&conf->mutex);
         for (i = 0; i < GF_FOP_PRI_MAX; i++) {
                 ctx = &conf->no_client[i];
@@ -1432,6 +2027,7 @@ struct xlator_fops fops = {
         .getactivelk = iot_getactivelk,
         .setactivelk = iot_setactivelk,
         .put         = iot_put,
+        .copy_file_range = iot_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
@@ -1540,6 +2136,17 @@ struct volume_options options[] = {
           .tags = {"io-threads"},
           .description = "Enable/Disable io threads translator"
         },
+        { .key  = {"work-stealing"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+          .tags = {"io-threads"},
+          .description = "Give every thread its own request queue and let "
+                         "idle threads steal from the others, instead of "
+                         "sharing one queue under one lock. Takes effect "
+                         "when the translator is restarted."
+        },
         { .key  = {NULL},
         },
 };
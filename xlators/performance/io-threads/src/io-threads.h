@@ -43,6 +43,30 @@ typedef struct {
         struct list_head        reqs;
 } iot_client_ctx_t;
 
+/* One queue per worker for the work-stealing scheduler. Padded to a cache
+ * line so that workers taking from their own queues don't share lines. */
+typedef struct {
+        pthread_mutex_t         lock;
+        struct list_head        reqs[GF_FOP_PRI_MAX];
+        int32_t                 count[GF_FOP_PRI_MAX];
+} __attribute__ ((aligned (64))) iot_queue_t;
+
+typedef struct {
+        struct iot_conf        *conf;
+        int32_t                 idx;            /* of its own queue */
+        gf_boolean_t            used;
+        gf_boolean_t            searching;
+        gf_boolean_t            woken;
+        struct list_head        idle;           /* on conf->idle_workers */
+        pthread_mutex_t         lock;
+        pthread_cond_t          cond;
+        int32_t                 credits[GF_FOP_PRI_MAX];
+} iot_worker_t;
+
+/* idle_state counts sleeping workers, plus this for every worker that is
+ * looking for work */
+#define IOT_WS_SEARCHING        0x10000
+
 struct iot_conf {
         pthread_mutex_t      mutex;
         pthread_cond_t       cond;
@@ -80,6 +104,17 @@ struct iot_conf {
         pthread_t           watchdog_thread;
         gf_boolean_t        queue_marked[GF_FOP_PRI_MAX];
         gf_boolean_t        cleanup_disconnected_reqs;
+
+        /* work-stealing scheduler, used instead of the lists above */
+        gf_boolean_t        work_stealing;
+        iot_queue_t        *queues;             /* IOT_MAX_THREADS */
+        iot_worker_t       *workers;            /* IOT_MAX_THREADS */
+        pthread_mutex_t     idle_lock;
+        struct list_head    idle_workers;
+        gf_atomic_t         idle_state;
+        gf_atomic_t         ws_active[GF_FOP_PRI_MAX];
+        gf_atomic_t         ws_steals;
+        gf_atomic_t         ws_wakeups;
 };
 
 typedef struct iot_conf iot_conf_t;
@@ -0,0 +1,385 @@
+/*
+  Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* The on-disk tier of md-cache.
+ *
+ * A file of fixed size slots, mapped shared, that remembers the xattrs
+ * md-cache loaded for <parent gfid, name> (or <gfid, ""> for nameless
+ * lookups) together with the gfid and ctime they were read at. Slots are
+ * direct mapped by a hash of the key, so a store simply overwrites whatever
+ * was there. Every slot carries a checksum of its contents: a slot torn by
+ * a crash, or written by an older layout, just reads as empty.
+ *
+ * Nothing here is trusted on its own. A lookup still goes to the bricks,
+ * and the persisted xattrs are only used if the reply has the same gfid
+ * and ctime, as any xattr change on the brick moves the ctime.
+ */
+
+#include <sys/mman.h>
+#include <sys/file.h>
+
+#include "md-cache-persist.h"
+#include "md-cache-mem-types.h"
+#include "md-cache-messages.h"
+#include "hashfn.h"
+#include "locking.h"
+#include "syscall.h"
+
+#define MDC_PERSIST_MAGIC        0x4d444350     /* "MDCP" */
+#define MDC_PERSIST_VERSION      1
+#define MDC_PERSIST_HDR_SIZE     4096
+#define MDC_PERSIST_SLOT_SIZE    512
+#define MDC_PERSIST_XATTR_MAX    (MDC_PERSIST_SLOT_SIZE - 64)
+#define MDC_PERSIST_LOCKS        64
+
+/* With coarse timestamps an xattr change can leave the ctime as it was if
+ * it comes within the same tick as the previous change. Only persist what
+ * has been stable for a while. */
+#define MDC_PERSIST_SETTLE       2
+
+#define MDC_PERSIST_VALID        0x1
+
+struct mdc_persist_header {
+        uint32_t        magic;
+        uint32_t        version;
+        uint32_t        slot_size;
+        uint32_t        nslots;
+        char            volume[256];
+};
+
+struct mdc_persist_slot {
+        uint32_t        csum;   /* of everything after it, up to xattr_len */
+        uint32_t        flags;
+        uint32_t        keys;   /* hash of the xattr keys md-cache loads */
+        uint32_t        name_hash;
+        unsigned char   pargfid[16];
+        unsigned char   gfid[16];
+        uint32_t        ctime;
+        uint32_t        ctime_nsec;
+        int32_t         xattr_len;
+        uint32_t        pad;
+        char            xattr[MDC_PERSIST_XATTR_MAX];
+};
+
+struct mdc_persist {
+        int                        fd;
+        void                      *map;
+        size_t                     size;
+        uint32_t                   nslots;
+        struct mdc_persist_slot   *slots;
+        gf_lock_t                  locks[MDC_PERSIST_LOCKS];
+};
+
+
+static uint32_t
+mdc_persist_csum (struct mdc_persist_slot *slot)
+{
+        return gf_dm_hashfn ((char *)slot + sizeof (slot->csum),
+                             offsetof (struct mdc_persist_slot, xattr) -
+                             sizeof (slot->csum) + slot->xattr_len);
+}
+
+
+static uint32_t
+mdc_persist_index (struct mdc_persist *persist, uuid_t pargfid,
+                   const char *name, uint32_t *name_hash)
+{
+        *name_hash = gf_dm_hashfn (name, strlen (name));
+
+        return (*name_hash ^ gf_dm_hashfn ((char *)pargfid, 16)) %
+                persist->nslots;
+}
+
+
+static int
+mdc_persist_format (xlator_t *this, struct mdc_persist *persist)
+{
+        struct mdc_persist_header *hdr = NULL;
+        int                        ret = -1;
+
+        /* truncating to 0 first gives back zeroed (empty) slots */
+        ret = sys_ftruncate (persist->fd, 0);
+        if (ret == 0)
+                ret = sys_ftruncate (persist->fd, persist->size);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        MD_CACHE_MSG_PERSIST_FAILED, "could not size the "
+                        "metadata cache file to %zu bytes", persist->size);
+                return -1;
+        }
+
+        hdr = persist->map;
+        hdr->magic = MDC_PERSIST_MAGIC;
+        hdr->version = MDC_PERSIST_VERSION;
+        hdr->slot_size = MDC_PERSIST_SLOT_SIZE;
+        hdr->nslots = persist->nslots;
+        snprintf (hdr->volume, sizeof (hdr->volume), "%s", this->name);
+
+        return 0;
+}
+
+
+struct mdc_persist *
+mdc_persist_open (xlator_t *this, const char *path, uint32_t nslots)
+{
+        struct mdc_persist        *persist = NULL;
+        struct mdc_persist_header *hdr = NULL;
+        struct stat                st = {0, };
+        int                        i = 0;
+
+        persist = GF_CALLOC (1, sizeof (*persist), gf_mdc_mt_mdc_persist_t);
+        if (!persist)
+                return NULL;
+
+        persist->fd = -1;
+        persist->map = MAP_FAILED;
+        persist->nslots = nslots;
+        persist->size = MDC_PERSIST_HDR_SIZE +
+                        (size_t)nslots * MDC_PERSIST_SLOT_SIZE;
+
+        persist->fd = sys_open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (persist->fd < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        MD_CACHE_MSG_PERSIST_FAILED, "could not open the "
+                        "metadata cache file %s", path);
+                goto err;
+        }
+
+        /* slots are only locked within this process */
+        if (flock (persist->fd, LOCK_EX | LOCK_NB)) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        MD_CACHE_MSG_PERSIST_FAILED, "metadata cache file %s "
+                        "is in use by another client", path);
+                goto err;
+        }
+
+        if (sys_fstat (persist->fd, &st))
+                goto err;
+
+        if (st.st_size < persist->size &&
+            sys_ftruncate (persist->fd, persist->size)) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        MD_CACHE_MSG_PERSIST_FAILED, "could not size the "
+                        "metadata cache file %s", path);
+                goto err;
+        }
+
+        persist->map = mmap (NULL, persist->size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED, persist->fd, 0);
+        if (persist->map == MAP_FAILED) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        MD_CACHE_MSG_PERSIST_FAILED, "could not map the "
+                        "metadata cache file %s", path);
+                goto err;
+        }
+        persist->slots = (void *)((char *)persist->map + MDC_PERSIST_HDR_SIZE);
+
+        hdr = persist->map;
+        if (st.st_size != persist->size || hdr->magic != MDC_PERSIST_MAGIC ||
+            hdr->version != MDC_PERSIST_VERSION ||
+            hdr->slot_size != MDC_PERSIST_SLOT_SIZE ||
+            hdr->nslots != nslots ||
+            strncmp (hdr->volume, this->name, sizeof (hdr->volume))) {
+                gf_msg (this->name, GF_LOG_INFO, 0,
+                        MD_CACHE_MSG_PERSIST_FAILED, "metadata cache file %s "
+                        "is new or was made for a different volume or size, "
+                        "starting with an empty cache", path);
+                if (mdc_persist_format (this, persist))
+                        goto err;
+        }
+
+        for (i = 0; i < MDC_PERSIST_LOCKS; i++)
+                LOCK_INIT (&persist->locks[i]);
+
+        return persist;
+err:
+        if (persist->map != MAP_FAILED)
+                munmap (persist->map, persist->size);
+        if (persist->fd >= 0)
+                sys_close (persist->fd);
+        GF_FREE (persist);
+        return NULL;
+}
+
+
+void
+mdc_persist_close (struct mdc_persist *persist)
+{
+        int i = 0;
+
+        if (!persist)
+                return;
+
+        for (i = 0; i < MDC_PERSIST_LOCKS; i++)
+                LOCK_DESTROY (&persist->locks[i]);
+
+        /* the page cache writes the mapping back on its own, this only
+         * makes a clean shutdown leave a complete file behind */
+        msync (persist->map, persist->size, MS_ASYNC);
+        munmap (persist->map, persist->size);
+        sys_close (persist->fd);
+        GF_FREE (persist);
+}
+
+
+/* Returns the slot the entry went to, or -1 if it was not persisted. */
+int32_t
+mdc_persist_store (struct mdc_persist *persist, uint32_t keys,
+                   uuid_t pargfid, const char *name, struct iatt *stbuf,
+                   dict_t *xattr)
+{
+        struct mdc_persist_slot *slot = NULL;
+        gf_lock_t               *lock = NULL;
+        char                    *buf = NULL;
+        u_int                    len = 0;
+        uint32_t                 name_hash = 0;
+        uint32_t                 idx = 0;
+
+        if (stbuf->ia_ctime + MDC_PERSIST_SETTLE > time (NULL))
+                return -1;
+
+        if (xattr && dict_allocate_and_serialize (xattr, &buf, &len))
+                return -1;
+
+        if (len > MDC_PERSIST_XATTR_MAX) {
+                GF_FREE (buf);
+                return -1;
+        }
+
+        idx = mdc_persist_index (persist, pargfid, name, &name_hash);
+        slot = &persist->slots[idx];
+        lock = &persist->locks[idx % MDC_PERSIST_LOCKS];
+
+        LOCK (lock);
+        {
+                slot->flags = MDC_PERSIST_VALID;
+                slot->keys = keys;
+                slot->name_hash = name_hash;
+                memcpy (slot->pargfid, pargfid, 16);
+                memcpy (slot->gfid, stbuf->ia_gfid, 16);
+                slot->ctime = stbuf->ia_ctime;
+                slot->ctime_nsec = stbuf->ia_ctime_nsec;
+                slot->xattr_len = len;
+                if (len)
+                        memcpy (slot->xattr, buf, len);
+                slot->csum = mdc_persist_csum (slot);
+        }
+        UNLOCK (lock);
+
+        GF_FREE (buf);
+
+        return idx;
+}
+
+
+int
+mdc_persist_find (struct mdc_persist *persist, uint32_t keys,
+                  uuid_t pargfid, const char *name,
+                  struct mdc_persist_entry *entry)
+{
+        struct mdc_persist_slot *slot = NULL;
+        gf_lock_t               *lock = NULL;
+        uint32_t                 name_hash = 0;
+        uint32_t                 idx = 0;
+        int                      ret = -1;
+
+        idx = mdc_persist_index (persist, pargfid, name, &name_hash);
+        slot = &persist->slots[idx];
+        lock = &persist->locks[idx % MDC_PERSIST_LOCKS];
+
+        LOCK (lock);
+        {
+                if (!(slot->flags & MDC_PERSIST_VALID) || slot->keys != keys ||
+                    slot->name_hash != name_hash ||
+                    memcmp (slot->pargfid, pargfid, 16))
+                        goto unlock;
+
+                if (slot->xattr_len < 0 ||
+                    slot->xattr_len > MDC_PERSIST_XATTR_MAX ||
+                    slot->csum != mdc_persist_csum (slot))
+                        goto unlock;
+
+                if (slot->xattr_len) {
+                        entry->xattr = GF_MALLOC (slot->xattr_len,
+                                                  gf_common_mt_char);
+                        if (!entry->xattr)
+                                goto unlock;
+                        memcpy (entry->xattr, slot->xattr, slot->xattr_len);
+                }
+
+                memcpy (entry->gfid, slot->gfid, 16);
+                entry->ctime = slot->ctime;
+                entry->ctime_nsec = slot->ctime_nsec;
+                entry->xattr_len = slot->xattr_len;
+                entry->slot = idx;
+                ret = 0;
+        }
+unlock:
+        UNLOCK (lock);
+
+        return ret;
+}
+
+
+/* The persisted xattrs if the lookup reply in @stbuf is of the same
+ * file, unchanged since they were stored. An empty dict means none of
+ * the keys md-cache loads were set. */
+dict_t *
+mdc_persist_entry_xattr (struct mdc_persist_entry *entry, struct iatt *stbuf)
+{
+        dict_t *xattr = NULL;
+
+        if (gf_uuid_compare (entry->gfid, stbuf->ia_gfid) ||
+            entry->ctime != stbuf->ia_ctime ||
+            entry->ctime_nsec != stbuf->ia_ctime_nsec)
+                return NULL;
+
+        xattr = dict_new ();
+        if (!xattr)
+                return NULL;
+
+        if (entry->xattr_len &&
+            dict_unserialize (entry->xattr, entry->xattr_len, &xattr)) {
+                dict_unref (xattr);
+                return NULL;
+        }
+
+        return xattr;
+}
+
+
+void
+mdc_persist_entry_wipe (struct mdc_persist_entry *entry)
+{
+        GF_FREE (entry->xattr);
+        entry->xattr = NULL;
+}
+
+
+void
+mdc_persist_drop (struct mdc_persist *persist, int32_t idx, uuid_t gfid)
+{
+        struct mdc_persist_slot *slot = NULL;
+        gf_lock_t               *lock = NULL;
+
+        if (idx < 0 || idx >= persist->nslots)
+                return;
+
+        slot = &persist->slots[idx];
+        lock = &persist->locks[idx % MDC_PERSIST_LOCKS];
+
+        LOCK (lock);
+        {
+                /* the slot may hold another entry by now */
+                if (memcmp (slot->gfid, gfid, 16) == 0)
+                        slot->flags = 0;
+        }
+        UNLOCK (lock);
+}
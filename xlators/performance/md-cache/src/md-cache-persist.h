@@ -0,0 +1,58 @@
+/*
+  Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __MD_CACHE_PERSIST_H__
+#define __MD_CACHE_PERSIST_H__
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "dict.h"
+#include "iatt.h"
+
+/* What a persisted lookup of <pargfid, name> found, copied out of the
+ * mapping so the slot can change while the lookup is in flight. The
+ * xattrs are only good if the reply still has this gfid and ctime. */
+struct mdc_persist_entry {
+        uuid_t    gfid;
+        uint32_t  ctime;
+        uint32_t  ctime_nsec;
+        int32_t   xattr_len;
+        char     *xattr;        /* serialized dict, NULL for "none set" */
+        int32_t   slot;
+};
+
+struct mdc_persist;
+
+struct mdc_persist *
+mdc_persist_open (xlator_t *this, const char *path, uint32_t nslots);
+
+void
+mdc_persist_close (struct mdc_persist *persist);
+
+int32_t
+mdc_persist_store (struct mdc_persist *persist, uint32_t keys,
+                   uuid_t pargfid, const char *name, struct iatt *stbuf,
+                   dict_t *xattr);
+
+int
+mdc_persist_find (struct mdc_persist *persist, uint32_t keys,
+                  uuid_t pargfid, const char *name,
+                  struct mdc_persist_entry *entry);
+
+dict_t *
+mdc_persist_entry_xattr (struct mdc_persist_entry *entry, struct iatt *stbuf);
+
+void
+mdc_persist_entry_wipe (struct mdc_persist_entry *entry);
+
+void
+mdc_persist_drop (struct mdc_persist *persist, int32_t idx, uuid_t gfid);
+
+#endif /* __MD_CACHE_PERSIST_H__ */
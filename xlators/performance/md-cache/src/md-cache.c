@@ -23,8 +23,10 @@
 #include <assert.h>
 #include <sys/time.h>
 #include "md-cache-messages.h"
+#include "md-cache-persist.h"
 #include "statedump.h"
 #include "atomic.h"
+#include "hashfn.h"
 
 /* TODO:
    - cache symlink() link names and nuke symlink-cache
@@ -58,6 +60,10 @@ struct mdc_statistics {
         gf_atomic_t xattr_invals; /* No. of invalidates received from upcall */
         gf_atomic_t need_lookup; /* No. of lookups issued, because other
                                     xlators requested for explicit lookup */
+        gf_atomic_t persist_hit; /* No. of lookups whose xattrs came from
+                                    the on-disk cache */
+        gf_atomic_t persist_miss; /* No. of lookups that found a persisted
+                                     entry, but of a changed file */
 };
 
 
@@ -77,6 +83,8 @@ struct mdc_conf {
         gf_boolean_t cache_statfs;
         struct mdc_statfs_cache statfs_cache;
         char *mdc_xattr_str;
+        uint32_t mdc_xattr_keys; /* hash of mdc_xattr_str */
+        struct mdc_persist *persist;
 };
 
 
@@ -115,6 +123,7 @@ struct md_cache {
 	time_t        ia_time;
 	time_t        xa_time;
         gf_boolean_t  need_lookup;
+        int32_t       persist_slot;
         gf_lock_t     lock;
 };
 
@@ -126,6 +135,8 @@ struct mdc_local {
         char   *linkname;
 	char   *key;
         dict_t *xattr;
+        gf_boolean_t persisted;
+        struct mdc_persist_entry persist;
 };
 
 
@@ -227,6 +238,8 @@ mdc_local_wipe (xlator_t *this, mdc_local_t *local)
         if (local->xattr)
                 dict_unref (local->xattr);
 
+        mdc_persist_entry_wipe (&local->persist);
+
         GF_FREE (local);
         return;
 }
@@ -278,6 +291,7 @@ mdc_inode_prep (xlator_t *this, inode_t *inode)
                 }
 
                 LOCK_INIT (&mdc->lock);
+                mdc->persist_slot = -1;
 
                 ret = __mdc_inode_ctx_set (this, inode, mdc);
                 if (ret) {
@@ -1085,6 +1099,142 @@ out:
         return 0;
 }
 
+/* Persisted entries are keyed by <parent gfid, name>, or by the gfid and an
+ * empty name for nameless lookups. */
+static int
+mdc_persist_key (loc_t *loc, unsigned char **pargfid, const char **name)
+{
+        if (loc->name && loc->parent) {
+                *pargfid = loc->parent->gfid;
+                *name = loc->name;
+        } else if (loc->name && !gf_uuid_is_null (loc->pargfid)) {
+                *pargfid = loc->pargfid;
+                *name = loc->name;
+        } else if (!gf_uuid_is_null (loc->gfid)) {
+                *pargfid = loc->gfid;
+                *name = "";
+        } else if (loc->inode && !gf_uuid_is_null (loc->inode->gfid)) {
+                *pargfid = loc->inode->gfid;
+                *name = "";
+        } else {
+                return -1;
+        }
+
+        return 0;
+}
+
+
+static void
+mdc_inode_persist (xlator_t *this, inode_t *inode, unsigned char *pargfid,
+                   const char *name, struct iatt *stbuf)
+{
+        struct mdc_conf *conf  = this->private;
+        struct md_cache *mdc   = NULL;
+        dict_t          *xattr = NULL;
+        int32_t          slot  = -1;
+
+        if (!conf->persist || !conf->mdc_xattr_str)
+                return;
+
+        /* only what md-cache itself would serve */
+        if (mdc_inode_xatt_get (this, inode, &xattr) != 0)
+                return;
+
+        slot = mdc_persist_store (conf->persist, conf->mdc_xattr_keys,
+                                  pargfid, name, stbuf, xattr);
+        if (slot >= 0 && mdc_inode_ctx_get (this, inode, &mdc) == 0) {
+                LOCK (&mdc->lock);
+                {
+                        mdc->persist_slot = slot;
+                }
+                UNLOCK (&mdc->lock);
+        }
+
+        if (xattr)
+                dict_unref (xattr);
+}
+
+
+static void
+mdc_inode_persist_drop (xlator_t *this, inode_t *inode)
+{
+        struct mdc_conf *conf = this->private;
+        struct md_cache *mdc  = NULL;
+        int32_t          slot = -1;
+
+        if (!conf->persist || mdc_inode_ctx_get (this, inode, &mdc) != 0)
+                return;
+
+        LOCK (&mdc->lock);
+        {
+                slot = mdc->persist_slot;
+                mdc->persist_slot = -1;
+        }
+        UNLOCK (&mdc->lock);
+
+        mdc_persist_drop (conf->persist, slot, inode->gfid);
+}
+
+
+/* Looks the entry up in the on-disk cache before winding the lookup. On a
+ * hit the xattr keys are not asked for, the lookup callback takes them from
+ * the persisted entry instead if the file did not change since. */
+static gf_boolean_t
+mdc_persist_lookup (xlator_t *this, mdc_local_t *local)
+{
+        struct mdc_conf *conf    = this->private;
+        unsigned char   *pargfid = NULL;
+        const char      *name    = NULL;
+
+        if (!conf->persist || !conf->mdc_xattr_str)
+                return _gf_false;
+
+        if (mdc_persist_key (&local->loc, &pargfid, &name))
+                return _gf_false;
+
+        if (mdc_persist_find (conf->persist, conf->mdc_xattr_keys, pargfid,
+                              name, &local->persist))
+                return _gf_false;
+
+        local->persisted = _gf_true;
+        return _gf_true;
+}
+
+
+static void
+mdc_inode_xatt_restore (xlator_t *this, mdc_local_t *local,
+                        struct iatt *stbuf)
+{
+        struct mdc_conf *conf  = this->private;
+        struct md_cache *mdc   = NULL;
+        dict_t          *xattr = NULL;
+
+        xattr = mdc_persist_entry_xattr (&local->persist, stbuf);
+        if (!xattr) {
+                /* the file changed, xattrs have to come from the brick
+                 * again; dropping the entry lets the next lookup load and
+                 * persist them */
+                GF_ATOMIC_INC (conf->mdc_counter.persist_miss);
+                mdc_inode_xatt_invalidate (this, local->loc.inode);
+                mdc_persist_drop (conf->persist, local->persist.slot,
+                                  local->persist.gfid);
+                return;
+        }
+
+        GF_ATOMIC_INC (conf->mdc_counter.persist_hit);
+        mdc_inode_xatt_set (this, local->loc.inode, xattr);
+        dict_unref (xattr);
+
+        if (mdc_inode_ctx_get (this, local->loc.inode, &mdc) == 0) {
+                LOCK (&mdc->lock);
+                {
+                        mdc->persist_slot = local->persist.slot;
+                }
+                UNLOCK (&mdc->lock);
+        }
+}
+
+
 int
 mdc_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 int32_t       op_ret,	int32_t op_errno, inode_t *inode,
@@ -1092,6 +1242,8 @@ mdc_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 {
         mdc_local_t     *local = NULL;
         struct mdc_conf *conf  = this->private;
+        unsigned char   *pargfid = NULL;
+        const char      *name  = NULL;
 
         local = frame->local;
 
@@ -1123,7 +1275,15 @@ mdc_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
         if (local->loc.inode) {
                 mdc_inode_iatt_set (this, local->loc.inode, stbuf);
-                mdc_inode_xatt_set (this, local->loc.inode, dict);
+                if (local->persisted) {
+                        mdc_inode_xatt_restore (this, local, stbuf);
+                } else {
+                        mdc_inode_xatt_set (this, local->loc.inode, dict);
+                        if (mdc_persist_key (&local->loc, &pargfid,
+                                             &name) == 0)
+                                mdc_inode_persist (this, local->loc.inode,
+                                                   pargfid, name, stbuf);
+                }
         }
 out:
         MDC_STACK_UNWIND (lookup, frame, op_ret, op_errno, inode, stbuf,
@@ -1193,7 +1353,7 @@ mdc_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
 uncached:
 	if (!xdata)
 		xdata = xattr_alloc = dict_new ();
-	if (xdata)
+	if (xdata && !(local && mdc_persist_lookup (this, local)))
 		mdc_load_reqs (this, xdata);
 
         STACK_WIND (frame, mdc_lookup_cbk, FIRST_CHILD (this),
@@ -2639,6 +2799,11 @@ mdc_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 			continue;
                 mdc_inode_iatt_set (this, entry->inode, &entry->d_stat);
                 mdc_inode_xatt_set (this, entry->inode, entry->dict);
+                if (strcmp (entry->d_name, ".") &&
+                    strcmp (entry->d_name, ".."))
+                        mdc_inode_persist (this, entry->inode,
+                                           local->fd->inode->gfid,
+                                           entry->d_name, &entry->d_stat);
         }
 
 unwind:
@@ -2864,6 +3029,51 @@ int mdc_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         return 0;
 }
 
+int
+mdc_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                         struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                         dict_t *xdata)
+{
+        mdc_local_t  *local = NULL;
+
+        local = frame->local;
+        if (!local)
+                goto out;
+
+        if (op_ret < 0) {
+                if ((op_errno == ENOENT) || (op_errno == ESTALE))
+                        mdc_inode_iatt_invalidate (this, local->fd->inode);
+                goto out;
+        }
+
+        mdc_inode_iatt_set_validate (this, local->fd->inode, prebuf_dst,
+                                     postbuf_dst, _gf_true);
+
+out:
+        MDC_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno, stbuf,
+                          prebuf_dst, postbuf_dst, xdata);
+
+        return 0;
+}
+
+int
+mdc_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags, dict_t *xdata)
+{
+        mdc_local_t *local;
+
+        local = mdc_local_get (frame);
+        local->fd = fd_ref (fd_out);
+
+        STACK_WIND (frame, mdc_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+
+        return 0;
+}
+
 int32_t
 mdc_readlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                   int32_t op_ret, int32_t op_errno, const char *path,
@@ -3023,6 +3233,12 @@ mdc_priv_dump (xlator_t *this)
                            GF_ATOMIC_GET(conf->mdc_counter.stat_invals));
         gf_proc_dump_write("xattr_invalidations_received", "%"PRId64,
                            GF_ATOMIC_GET(conf->mdc_counter.xattr_invals));
+        if (conf->persist) {
+                gf_proc_dump_write("persist_hit_count", "%"PRId64,
+                                   GF_ATOMIC_GET(conf->mdc_counter.persist_hit));
+                gf_proc_dump_write("persist_miss_count", "%"PRId64,
+                                   GF_ATOMIC_GET(conf->mdc_counter.persist_miss));
+        }
 
         return 0;
 }
@@ -3055,6 +3271,10 @@ mdc_dump_metrics (xlator_t *this, int fd)
         dprintf (fd, "%s.xattr_cache_invalidations_received %"PRId64"\n",
                  this->name,
                  GF_ATOMIC_GET(conf->mdc_counter.xattr_invals));
+        dprintf (fd, "%s.persist_cache_hit_count %"PRId64"\n", this->name,
+                 GF_ATOMIC_GET(conf->mdc_counter.persist_hit));
+        dprintf (fd, "%s.persist_cache_miss_count %"PRId64"\n", this->name,
+                 GF_ATOMIC_GET(conf->mdc_counter.persist_miss));
 out:
         return 0;
 }
@@ -3142,6 +3362,9 @@ mdc_xattr_list_populate (struct mdc_conf *conf, char *tmp_str)
                  * lock contention
                  */
                 conf->mdc_xattr_str = mdc_xattr_str;
+                /* tells persisted entries loaded with other keys apart */
+                conf->mdc_xattr_keys = gf_dm_hashfn (mdc_xattr_str,
+                                                     strlen (mdc_xattr_str));
         }
         UNLOCK (&conf->lock);
 
@@ -3206,6 +3429,7 @@ mdc_invalidate (xlator_t *this, void *data)
             (UP_NLINK | UP_RENAME_FLAGS | UP_FORGET | UP_INVAL_ATTR)) {
                 mdc_inode_iatt_invalidate (this, inode);
                 mdc_inode_xatt_invalidate (this, inode);
+                mdc_inode_persist_drop (this, inode);
                 GF_ATOMIC_INC (conf->mdc_counter.stat_invals);
                 goto out;
         }
@@ -3222,6 +3446,9 @@ mdc_invalidate (xlator_t *this, void *data)
                 GF_ATOMIC_INC (conf->mdc_counter.stat_invals);
         }
 
+        if (up_ci->flags & (UP_XATTR | UP_XATTR_RM))
+                mdc_inode_persist_drop (this, inode);
+
         if (up_ci->flags & UP_XATTR) {
                 if (up_ci->dict)
                         ret = mdc_inode_xatt_update (this, inode, up_ci->dict);
@@ -3421,6 +3648,39 @@ out:
 	return 0;
 }
 
+/* The volume option names the same file on every client, so each mount
+ * keeps its own file, named after its mount point the way the log files
+ * are: <file>.<mount point with '/' as '-'>. Processes without a mount
+ * point have nothing that outlives them to name a file after and do not
+ * persist. */
+static char *
+mdc_persist_path (xlator_t *this, const char *file)
+{
+        char *mount_point = this->ctx->cmd_args.mount_point;
+        char *path = NULL;
+        char *suffix = NULL;
+
+        if (!mount_point) {
+                gf_msg (this->name, GF_LOG_INFO, 0,
+                        MD_CACHE_MSG_PERSIST_FAILED, "not a mount, "
+                        "md-cache-persist-file is only used by mounts");
+                return NULL;
+        }
+
+        while (*mount_point == '/')
+                mount_point++;
+
+        if (gf_asprintf (&path, "%s.%s", file, mount_point) < 0)
+                return NULL;
+
+        for (suffix = path + strlen (file) + 1; *suffix; suffix++) {
+                if (*suffix == '/')
+                        *suffix = '-';
+        }
+
+        return path;
+}
+
 int32_t
 mdc_mem_acct_init (xlator_t *this)
 {
@@ -3436,6 +3696,9 @@ mdc_init (xlator_t *this)
 	struct mdc_conf *conf = NULL;
         int    timeout = 0;
         char *tmp_str = NULL;
+        char *persist_file = NULL;
+        char *persist_path = NULL;
+        uint32_t persist_entries = 0;
 
 	conf = GF_CALLOC (sizeof (*conf), 1, gf_mdc_mt_mdc_conf_t);
 	if (!conf) {
@@ -3475,6 +3738,18 @@ mdc_init (xlator_t *this)
         GF_OPTION_INIT("xattr-cache-list", tmp_str, str, out);
         mdc_xattr_list_populate (conf, tmp_str);
 
+        GF_OPTION_INIT ("md-cache-persist-entries", persist_entries, uint32,
+                        out);
+        GF_OPTION_INIT ("md-cache-persist-file", persist_file, path, out);
+        if (persist_file)
+                persist_path = mdc_persist_path (this, persist_file);
+        /* a cache that can't be opened only costs the warm start */
+        if (persist_path) {
+                conf->persist = mdc_persist_open (this, persist_path,
+                                                  persist_entries);
+                GF_FREE (persist_path);
+        }
+
         time (&conf->last_child_down);
         /* initialize gf_atomic_t counters */
         GF_ATOMIC_INIT (conf->mdc_counter.stat_hit, 0);
@@ -3486,6 +3761,8 @@ mdc_init (xlator_t *this)
         GF_ATOMIC_INIT (conf->mdc_counter.stat_invals, 0);
         GF_ATOMIC_INIT (conf->mdc_counter.xattr_invals, 0);
         GF_ATOMIC_INIT (conf->mdc_counter.need_lookup, 0);
+        GF_ATOMIC_INIT (conf->mdc_counter.persist_hit, 0);
+        GF_ATOMIC_INIT (conf->mdc_counter.persist_miss, 0);
 
         /* If timeout is greater than 60s (default before the patch that added
          * cache invalidation support was added) then, cache invalidation
@@ -3556,6 +3833,11 @@ mdc_notify (xlator_t *this, int event, void *data, ...)
 void
 mdc_fini (xlator_t *this)
 {
+        struct mdc_conf *conf = this->private;
+
+        if (conf)
+                mdc_persist_close (conf->persist);
+
         GF_FREE (this->private);
 }
 
@@ -3592,6 +3874,7 @@ struct xlator_fops mdc_fops = {
 	.fallocate   = mdc_fallocate,
 	.discard     = mdc_discard,
         .zerofill    = mdc_zerofill,
+        .copy_file_range = mdc_copy_file_range,
         .statfs      = mdc_statfs,
         .readlink    = mdc_readlink,
         .fsyncdir    = mdc_fsyncdir,
@@ -3705,6 +3988,32 @@ struct volume_options mdc_options[] = {
           .tags = {"md-cache"},
           .description = "Enable/Disable md cache translator"
         },
+        { .key = {"md-cache-persist-file"},
+          .type = GF_OPTION_TYPE_PATH,
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+          .tags = {"md-cache"},
+          .description = "Keep the cached xattrs of looked up files in a "
+                         "file on the client as well, so that a restarted "
+                         "client does not have to fetch them from the bricks "
+                         "again for files that did not change. Every mount "
+                         "uses its own file, this path followed by its mount "
+                         "point with '/' replaced by '-' (/var/cache/mdc and "
+                         "/mnt/vol give /var/cache/mdc.mnt-vol). Only used "
+                         "by mounts, from the next mount on."
+        },
+        { .key = {"md-cache-persist-entries"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 1024,
+          .max = 16777216,
+          .default_value = "65536",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+          .tags = {"md-cache"},
+          .description = "Number of entries the md-cache-persist-file holds, "
+                         "512 bytes each. Changing it starts with an empty "
+                         "file."
+        },
         { .key = {NULL} },
 };
 
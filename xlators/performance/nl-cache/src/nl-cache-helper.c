@@ -35,21 +35,27 @@
  *
  *   Data structures to store cache?
  *      The cache of any directory is stored in the inode_ctx of the directory.
- *      Negative entries are stored as list of strings.
- *             Search - O(n)
- *             Add    - O(1)
- *             Delete - O(n) - as it has to be searched before deleting
+ *      Negative entries are stored as list of strings, indexed by a hash
+ *      table of the names (nlc_index_t).
+ *             Search - O(1)
+ *             Add    - O(1) - amortized, the index doubles when full
+ *             Delete - O(1)
  *      Positive entries are stored as a list, each list node has a pointer
  *          to the inode of the positive entry or the name of the entry.
  *          Since the client side inode table already will have inodes for
  *          positive entries, we just take a ref of that inode and store as
  *          positive entry cache. In cases like hardlinks and readdirp where
- *          inode is NULL, we store the names.
- *          Name Search - O(n)
+ *          inode is NULL, we store the names, which are indexed like the
+ *          negative entries.
+ *          Name Search - O(1)
  *          Inode Search - O(1) - Actually complexity of inode_find()
  *          Name/inode Add - O(1)
- *          Name Delete - O(n)
+ *          Name Delete - O(1)
  *          Inode Delete - O(1)
+ *      Each index has a Bloom filter of the names, so that a name that is
+ *      not cached, the common case of a create in a large directory, is
+ *      mostly answered without walking a hash chain. The buckets and the
+ *      filter are accounted in the cache size of the directory.
  *
  * Locking order:
  *
@@ -66,7 +72,8 @@ int __nlc_inode_ctx_timer_start (xlator_t *this, inode_t *inode, nlc_ctx_t *nlc_
 int __nlc_add_to_lru (xlator_t *this, inode_t *inode, nlc_ctx_t *nlc_ctx);
 void nlc_remove_from_lru (xlator_t *this, inode_t *inode);
 void __nlc_inode_ctx_timer_delete (xlator_t *this, nlc_ctx_t *nlc_ctx);
-gf_boolean_t __nlc_search_ne (nlc_ctx_t *nlc_ctx, const char *name);
+gf_boolean_t __nlc_search_ne (xlator_t *this, nlc_ctx_t *nlc_ctx,
+                              const char *name);
 void __nlc_free_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_pe_t *pe);
 void __nlc_free_ne (xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_ne_t *ne);
 
@@ -205,6 +212,236 @@ nlc_inode_ctx_get (xlator_t *this, inode_t *inode, nlc_ctx_t **nlc_ctx_p,
 }
 
 
+/* FNV-1a of the name folded to lower case */
+static uint64_t
+nlc_name_hash (const char *name)
+{
+        uint64_t hval = 14695981039346656037ULL;
+
+        for (; *name; name++) {
+                hval ^= (unsigned char) tolower (*name);
+                hval *= 1099511628211ULL;
+        }
+
+        return hval;
+}
+
+
+static size_t
+nlc_index_size (nlc_index_t *index)
+{
+        return index->nbuckets * sizeof (*index->buckets) +
+               index->bloom_bits / 8;
+}
+
+
+/* The bucket is taken from the low bits of the hash, the bits of the
+ * filter from the high ones */
+static void
+__nlc_bloom_add (nlc_index_t *index, uint64_t hval)
+{
+        uint32_t h1  = hval >> 32;
+        uint32_t h2  = (uint32_t) hval | 1;
+        uint32_t bit = 0;
+        int      i   = 0;
+
+        for (i = 0; i < NLC_BLOOM_HASHES; i++) {
+                bit = (h1 + i * h2) & (index->bloom_bits - 1);
+                index->bloom[bit / 64] |= 1ULL << (bit % 64);
+        }
+}
+
+
+static gf_boolean_t
+__nlc_bloom_test (nlc_index_t *index, uint64_t hval)
+{
+        uint32_t h1  = hval >> 32;
+        uint32_t h2  = (uint32_t) hval | 1;
+        uint32_t bit = 0;
+        int      i   = 0;
+
+        for (i = 0; i < NLC_BLOOM_HASHES; i++) {
+                bit = (h1 + i * h2) & (index->bloom_bits - 1);
+                if (!(index->bloom[bit / 64] & (1ULL << (bit % 64))))
+                        return _gf_false;
+        }
+
+        return _gf_true;
+}
+
+
+static void
+__nlc_bloom_rebuild (nlc_index_t *index)
+{
+        nlc_hnode_t *hnode = NULL;
+        uint32_t     i     = 0;
+
+        memset (index->bloom, 0, index->bloom_bits / 8);
+        for (i = 0; i < index->nbuckets; i++) {
+                list_for_each_entry (hnode, &index->buckets[i], list) {
+                        __nlc_bloom_add (index, hnode->hval);
+                }
+        }
+        index->stale = 0;
+}
+
+
+static int
+__nlc_index_resize (xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_index_t *index,
+                    uint32_t nbuckets)
+{
+        nlc_conf_t        *conf       = NULL;
+        struct list_head  *buckets    = NULL;
+        uint64_t          *bloom      = NULL;
+        nlc_hnode_t       *hnode      = NULL;
+        nlc_hnode_t       *tmp        = NULL;
+        size_t             old_size   = 0;
+        uint32_t           bloom_bits = 0;
+        uint32_t           i          = 0;
+        int                ret        = -1;
+
+        conf = this->private;
+
+        bloom_bits = nbuckets * NLC_BLOOM_BITS_PER_BUCKET;
+
+        buckets = GF_CALLOC (nbuckets, sizeof (*buckets),
+                             gf_nlc_mt_nlc_index_t);
+        if (!buckets)
+                goto out;
+
+        bloom = GF_CALLOC (bloom_bits / 64, sizeof (*bloom),
+                           gf_nlc_mt_nlc_index_t);
+        if (!bloom)
+                goto out;
+
+        for (i = 0; i < nbuckets; i++)
+                INIT_LIST_HEAD (&buckets[i]);
+
+        for (i = 0; i < index->nbuckets; i++) {
+                list_for_each_entry_safe (hnode, tmp, &index->buckets[i],
+                                          list) {
+                        list_move (&hnode->list,
+                                   &buckets[hnode->hval & (nbuckets - 1)]);
+                }
+        }
+
+        old_size = nlc_index_size (index);
+        GF_FREE (index->buckets);
+        GF_FREE (index->bloom);
+
+        index->buckets = buckets;
+        index->nbuckets = nbuckets;
+        index->bloom = bloom;
+        index->bloom_bits = bloom_bits;
+        __nlc_bloom_rebuild (index);
+
+        nlc_ctx->cache_size += nlc_index_size (index) - old_size;
+        GF_ATOMIC_ADD (conf->current_cache_size,
+                       nlc_index_size (index) - old_size);
+
+        ret = 0;
+out:
+        if (ret < 0) {
+                GF_FREE (buckets);
+                GF_FREE (bloom);
+        }
+
+        return ret;
+}
+
+
+static int
+__nlc_index_add (xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_index_t *index,
+                 nlc_hnode_t *hnode, const char *name)
+{
+        int ret = 0;
+
+        if (index->count >= index->nbuckets) {
+                ret = __nlc_index_resize (this, nlc_ctx, index,
+                                          index->nbuckets ?
+                                          index->nbuckets * 2 :
+                                          NLC_INDEX_MIN_BUCKETS);
+                /* a full index still works, with longer chains */
+                if (ret < 0 && !index->nbuckets)
+                        goto out;
+        }
+
+        hnode->hval = nlc_name_hash (name);
+        hnode->name = name;
+        list_add (&hnode->list,
+                  &index->buckets[hnode->hval & (index->nbuckets - 1)]);
+        index->count++;
+        __nlc_bloom_add (index, hnode->hval);
+
+        ret = 0;
+out:
+        return ret;
+}
+
+
+static void
+__nlc_index_del (nlc_index_t *index, nlc_hnode_t *hnode)
+{
+        list_del_init (&hnode->list);
+        index->count--;
+
+        /* keeps the filter at more than 5 bits per name */
+        if (++index->stale > index->nbuckets / 2)
+                __nlc_bloom_rebuild (index);
+}
+
+
+static nlc_hnode_t *
+__nlc_index_find (xlator_t *this, nlc_index_t *index, const char *name,
+                  gf_boolean_t case_insensitive)
+{
+        nlc_conf_t  *conf  = NULL;
+        nlc_hnode_t *hnode = NULL;
+        uint64_t     hval  = 0;
+
+        if (!index->count)
+                goto out;
+
+        hval = nlc_name_hash (name);
+        if (!__nlc_bloom_test (index, hval)) {
+                conf = this->private;
+                GF_ATOMIC_INC (conf->nlc_counter.bloom_hit);
+                goto out;
+        }
+
+        list_for_each_entry (hnode, &index->buckets[hval & (index->nbuckets -
+                                                            1)], list) {
+                if (hnode->hval != hval)
+                        continue;
+                if (case_insensitive ? !strcasecmp (hnode->name, name) :
+                                       !strcmp (hnode->name, name))
+                        return hnode;
+        }
+out:
+        return NULL;
+}
+
+
+static void
+__nlc_index_free (xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_index_t *index)
+{
+        nlc_conf_t *conf = NULL;
+        size_t      size = 0;
+
+        conf = this->private;
+
+        GF_ASSERT (index->count == 0);
+
+        size = nlc_index_size (index);
+        nlc_ctx->cache_size -= size;
+        GF_ATOMIC_SUB (conf->current_cache_size, size);
+
+        GF_FREE (index->buckets);
+        GF_FREE (index->bloom);
+        memset (index, 0, sizeof (*index));
+}
+
+
 static void
 __nlc_inode_clear_entries (xlator_t *this, nlc_ctx_t *nlc_ctx)
 {
@@ -226,6 +463,9 @@ __nlc_inode_clear_entries (xlator_t *this, nlc_ctx_t *nlc_ctx)
                         __nlc_free_ne (this, nlc_ctx, ne);
                 }
 
+        __nlc_index_free (this, nlc_ctx, &nlc_ctx->pe_index);
+        __nlc_index_free (this, nlc_ctx, &nlc_ctx->ne_index);
+
         nlc_ctx->cache_time = 0;
         nlc_ctx->state = 0;
         GF_ASSERT (nlc_ctx->cache_size == sizeof (*nlc_ctx));
@@ -666,6 +906,8 @@ __nlc_free_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_pe_t *pe)
                 inode_unref (pe->inode);
         }
         list_del (&pe->list);
+        if (!list_empty (&pe->hnode.list))
+                __nlc_index_del (&nlc_ctx->pe_index, &pe->hnode);
 
         nlc_ctx->cache_size -= sizeof (*pe) + sizeof (pe->name);
         GF_ATOMIC_SUB (conf->current_cache_size,
@@ -690,6 +932,7 @@ __nlc_free_ne (xlator_t *this, nlc_ctx_t *nlc_ctx, nlc_ne_t *ne)
         conf = this->private;
 
         list_del (&ne->list);
+        __nlc_index_del (&nlc_ctx->ne_index, &ne->hnode);
         GF_FREE (ne->name);
         GF_FREE (ne);
 
@@ -731,7 +974,7 @@ __nlc_del_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
               const char *name, gf_boolean_t multilink)
 {
         nlc_pe_t         *pe     = NULL;
-        nlc_pe_t         *tmp    = NULL;
+        nlc_hnode_t      *hnode  = NULL;
         gf_boolean_t     found  = _gf_false;
         uint64_t         pe_int = 0;
 
@@ -743,11 +986,12 @@ __nlc_del_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
 
         /* If there are hardlinks first search names, followed by inodes */
         if (multilink) {
-                list_for_each_entry_safe (pe, tmp, &nlc_ctx->pe, list) {
-                        if (pe->name && (strcmp (pe->name, name) == 0)) {
-                                found = _gf_true;
-                                goto out;
-                        }
+                hnode = __nlc_index_find (this, &nlc_ctx->pe_index, name,
+                                          _gf_false);
+                if (hnode) {
+                        pe = list_entry (hnode, nlc_pe_t, hnode);
+                        found = _gf_true;
+                        goto out;
                 }
                 inode_ctx_reset1 (entry_ino, this, &pe_int);
                 if (pe_int) {
@@ -766,12 +1010,10 @@ __nlc_del_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
         }
 
 name_search:
-        list_for_each_entry_safe (pe, tmp, &nlc_ctx->pe, list) {
-                if (pe->name && (strcmp (pe->name, name) == 0)) {
-                        found = _gf_true;
-                        break;
-                        /* TODO: can there be duplicates? */
-                }
+        hnode = __nlc_index_find (this, &nlc_ctx->pe_index, name, _gf_false);
+        if (hnode) {
+                pe = list_entry (hnode, nlc_pe_t, hnode);
+                found = _gf_true;
         }
 
 out:
@@ -785,18 +1027,15 @@ out:
 static void
 __nlc_del_ne (xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name)
 {
-        nlc_ne_t  *ne     = NULL;
-        nlc_ne_t  *tmp    = NULL;
+        nlc_hnode_t *hnode = NULL;
 
         if (!IS_NE_VALID (nlc_ctx->state))
                 goto out;
 
-        list_for_each_entry_safe (ne, tmp, &nlc_ctx->ne, list) {
-                if (strcmp (ne->name, name) == 0) {
-                        __nlc_free_ne (this, nlc_ctx, ne);
-                        break;
-                }
-        }
+        hnode = __nlc_index_find (this, &nlc_ctx->ne_index, name, _gf_false);
+        if (hnode)
+                __nlc_free_ne (this, nlc_ctx,
+                               list_entry (hnode, nlc_ne_t, hnode));
 out:
         return;
 }
@@ -813,15 +1052,19 @@ __nlc_add_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
 
         conf = this->private;
 
-        /* TODO: There can be no duplicate entries, as it is added only
-        during create. In case there arises duplicate entries, search PE
-        found = __nlc_search (entries, name, _gf_false);
-        can use bit vector to have simple search than sequential search */
+        /* There can be no duplicate entries with an inode, as they are
+         * added only during create. A name, added by link, is looked up
+         * in the index before adding it. */
+        if (!entry_ino && name &&
+            __nlc_index_find (this, &nlc_ctx->pe_index, name, _gf_false))
+                goto out;
 
         pe = GF_CALLOC (sizeof (*pe), 1, gf_nlc_mt_nlc_pe_t);
         if (!pe)
                 goto out;
 
+        INIT_LIST_HEAD (&pe->hnode.list);
+
         if (entry_ino) {
                 pe->inode = inode_ref (entry_ino);
                 nlc_inode_ctx_set (this, entry_ino, NULL, pe);
@@ -829,6 +1072,11 @@ __nlc_add_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, inode_t *entry_ino,
                 pe->name = gf_strdup (name);
                 if (!pe->name)
                         goto out;
+                if (__nlc_index_add (this, nlc_ctx, &nlc_ctx->pe_index,
+                                     &pe->hnode, pe->name) < 0) {
+                        GF_FREE (pe->name);
+                        goto out;
+                }
         }
 
         list_add (&pe->list, &nlc_ctx->pe);
@@ -860,9 +1108,8 @@ __nlc_add_ne (xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name)
 
         conf = this->private;
 
-        /* TODO: search ne before adding to get rid of duplicate entries
-        found = __nlc_search (entries, name, _gf_false);
-        can use bit vector to have faster search than sequential search */
+        /* The callers search ne before adding, to get rid of duplicate
+         * entries */
 
         ne = GF_CALLOC (sizeof (*ne), 1, gf_nlc_mt_nlc_ne_t);
         if (!ne)
@@ -872,6 +1119,12 @@ __nlc_add_ne (xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name)
         if (!ne->name)
                 goto out;
 
+        if (__nlc_index_add (this, nlc_ctx, &nlc_ctx->ne_index, &ne->hnode,
+                             ne->name) < 0) {
+                GF_FREE (ne->name);
+                goto out;
+        }
+
         list_add (&ne->list, &nlc_ctx->ne);
 
         nlc_ctx->cache_size += sizeof (*ne) + sizeof (ne->name);
@@ -906,7 +1159,7 @@ nlc_dir_add_ne (xlator_t *this, inode_t *inode, const char *name)
                 /* There is one possibility where we need to search before
                  * adding NE: when there are two parallel lookups on a non
                  * existent file */
-                if (!__nlc_search_ne (nlc_ctx, name)) {
+                if (!__nlc_search_ne (this, nlc_ctx, name)) {
                         __nlc_add_ne (this, nlc_ctx, name);
                         __nlc_set_dir_state (nlc_ctx, NLC_NE_VALID);
                 }
@@ -939,7 +1192,8 @@ nlc_dir_remove_pe (xlator_t *this, inode_t *parent, inode_t *entry_ino,
                         goto unlock;
 
                 __nlc_del_pe (this, nlc_ctx, entry_ino, name, multilink);
-                __nlc_add_ne (this, nlc_ctx, name);
+                if (!__nlc_search_ne (this, nlc_ctx, name))
+                        __nlc_add_ne (this, nlc_ctx, name);
                 __nlc_set_dir_state (nlc_ctx, NLC_NE_VALID);
         }
 unlock:
@@ -979,74 +1233,49 @@ out:
 
 
 gf_boolean_t
-__nlc_search_ne (nlc_ctx_t *nlc_ctx, const char *name)
+__nlc_search_ne (xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name)
 {
         gf_boolean_t  found = _gf_false;
-        nlc_ne_t     *ne    = NULL;
-        nlc_ne_t     *tmp   = NULL;
 
         if (!IS_NE_VALID (nlc_ctx->state))
                 goto out;
 
-        list_for_each_entry_safe (ne, tmp, &nlc_ctx->ne, list) {
-                if (strcmp (ne->name, name) == 0) {
-                        found = _gf_true;
-                        break;
-                }
-        }
+        if (__nlc_index_find (this, &nlc_ctx->ne_index, name, _gf_false))
+                found = _gf_true;
 out:
         return found;
 }
 
 
 static gf_boolean_t
-__nlc_search_pe (nlc_ctx_t *nlc_ctx, const char *name)
+__nlc_search_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name)
 {
         gf_boolean_t   found = _gf_false;
-        nlc_pe_t      *pe    = NULL;
-        nlc_pe_t      *tmp   = NULL;
 
         if (!IS_PE_VALID (nlc_ctx->state))
                 goto out;
 
-        list_for_each_entry_safe (pe, tmp, &nlc_ctx->pe, list) {
-               if (pe->name && (strcmp (pe->name, name) == 0)) {
-                        found = _gf_true;
-                        break;
-               }
-        }
+        if (__nlc_index_find (this, &nlc_ctx->pe_index, name, _gf_false))
+                found = _gf_true;
 out:
         return found;
 }
 
 
 static char *
-__nlc_get_pe (nlc_ctx_t *nlc_ctx, const char *name, gf_boolean_t case_insensitive)
+__nlc_get_pe (xlator_t *this, nlc_ctx_t *nlc_ctx, const char *name,
+              gf_boolean_t case_insensitive)
 {
         char          *found = NULL;
-        nlc_pe_t      *pe    = NULL;
-        nlc_pe_t      *tmp   = NULL;
+        nlc_hnode_t   *hnode = NULL;
 
         if (!IS_PE_VALID (nlc_ctx->state))
                 goto out;
 
-        if (case_insensitive) {
-                list_for_each_entry_safe (pe, tmp, &nlc_ctx->pe, list) {
-                        if (pe->name &&
-                            (strcasecmp (pe->name, name) == 0)) {
-                                found = pe->name;
-                                break;
-                        }
-                }
-        } else {
-                list_for_each_entry_safe (pe, tmp, &nlc_ctx->pe, list) {
-                        if (pe->name &&
-                            (strcmp (pe->name, name) == 0)) {
-                                found = pe->name;
-                                break;
-                        }
-               }
-        }
+        hnode = __nlc_index_find (this, &nlc_ctx->pe_index, name,
+                                  case_insensitive);
+        if (hnode)
+                found = list_entry (hnode, nlc_pe_t, hnode)->name;
 out:
         return found;
 }
@@ -1077,12 +1306,12 @@ nlc_is_negative_lookup (xlator_t *this, loc_t *loc)
                 if (!__nlc_is_cache_valid (this, nlc_ctx))
                         goto unlock;
 
-                if (__nlc_search_ne (nlc_ctx, loc->name)) {
+                if (__nlc_search_ne (this, nlc_ctx, loc->name)) {
                         neg_entry = _gf_true;
                         goto unlock;
                 }
                 if ((nlc_ctx->state & NLC_PE_FULL) &&
-                    !__nlc_search_pe (nlc_ctx, loc->name)) {
+                    !__nlc_search_pe (this, nlc_ctx, loc->name)) {
                         neg_entry = _gf_true;
                         goto unlock;
                 }
@@ -1129,7 +1358,7 @@ nlc_get_real_file_name (xlator_t *this, loc_t *loc, const char *fname,
                 if (!__nlc_is_cache_valid (this, nlc_ctx))
                         goto unlock;
 
-                found_file = __nlc_get_pe (nlc_ctx, fname, _gf_true);
+                found_file = __nlc_get_pe (this, nlc_ctx, fname, _gf_true);
                 if (found_file) {
                         ret = dict_set_dynstr (dict, GF_XATTR_GET_REAL_FILENAME_KEY,
                                                gf_strdup (found_file));
@@ -1195,6 +1424,16 @@ nlc_dump_inodectx (xlator_t *this, inode_t *inode)
                 gf_proc_dump_write ("cache-time", "%lld", nlc_ctx->cache_time);
                 gf_proc_dump_write ("cache-size", "%zu", nlc_ctx->cache_size);
                 gf_proc_dump_write ("refd-inodes", "%"PRIu64, nlc_ctx->refd_inodes);
+                gf_proc_dump_write ("pe-index", "entries=%u,buckets=%u,"
+                                    "bloom-bits=%u",
+                                    nlc_ctx->pe_index.count,
+                                    nlc_ctx->pe_index.nbuckets,
+                                    nlc_ctx->pe_index.bloom_bits);
+                gf_proc_dump_write ("ne-index", "entries=%u,buckets=%u,"
+                                    "bloom-bits=%u",
+                                    nlc_ctx->ne_index.count,
+                                    nlc_ctx->ne_index.nbuckets,
+                                    nlc_ctx->ne_index.bloom_bits);
 
                 if (IS_PE_VALID (nlc_ctx->state))
                         list_for_each_entry_safe (pe, tmp, &nlc_ctx->pe, list) {
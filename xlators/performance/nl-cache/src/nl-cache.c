@@ -633,6 +633,8 @@ nlc_priv_dump (xlator_t *this)
                            GF_ATOMIC_GET(conf->nlc_counter.ne_inode_cnt));
         gf_proc_dump_write("dentry_invalidations_recieved", "%"PRId64,
                            GF_ATOMIC_GET(conf->nlc_counter.nlc_invals));
+        gf_proc_dump_write("bloom_filter_hit_count", "%"PRId64,
+                           GF_ATOMIC_GET(conf->nlc_counter.bloom_hit));
         gf_proc_dump_write("cache_limit", "%"PRIu64,
                            conf->cache_size);
         gf_proc_dump_write("consumed_cache_size", "%"PRId64,
@@ -670,6 +672,8 @@ nlc_dump_metrics (xlator_t *this, int fd)
                  this->name, GF_ATOMIC_GET(conf->nlc_counter.ne_inode_cnt));
         dprintf (fd, "%s.dentry_invalidations_recieved %"PRId64"\n",
                  this->name, GF_ATOMIC_GET(conf->nlc_counter.nlc_invals));
+        dprintf (fd, "%s.bloom_filter_hit_count %"PRId64"\n", this->name,
+                 GF_ATOMIC_GET(conf->nlc_counter.bloom_hit));
         dprintf (fd, "%s.cache_limit %"PRIu64"\n", this->name,
                  conf->cache_size);
         dprintf (fd, "%s.consumed_cache_size %"PRId64"\n", this->name,
@@ -767,6 +771,7 @@ nlc_init (xlator_t *this)
         GF_ATOMIC_INIT (conf->nlc_counter.pe_inode_cnt, 0);
         GF_ATOMIC_INIT (conf->nlc_counter.ne_inode_cnt, 0);
         GF_ATOMIC_INIT (conf->nlc_counter.nlc_invals, 0);
+        GF_ATOMIC_INIT (conf->nlc_counter.bloom_hit, 0);
 
         INIT_LIST_HEAD (&conf->lru);
         time (&conf->last_child_down);
@@ -47,19 +47,51 @@ enum nlc_cache_clear_reason {
         NLC_LRU_PRUNE,
 };
 
+/* Initial number of buckets of an entry index, it doubles whenever it holds
+ * more entries than buckets */
+#define NLC_INDEX_MIN_BUCKETS 16
+/* Bits of the Bloom filter of an index per bucket, and bits set per name */
+#define NLC_BLOOM_BITS_PER_BUCKET 8
+#define NLC_BLOOM_HASHES 4
+
+/* Link of a named entry into the name index of its directory */
+struct nlc_hnode {
+        struct list_head  list;  /* chain of a bucket */
+        uint64_t          hval;
+        const char       *name;
+};
+typedef struct nlc_hnode nlc_hnode_t;
+
 struct nlc_ne {
         struct list_head  list;
+        nlc_hnode_t       hnode;
         char             *name;
 };
 typedef struct nlc_ne nlc_ne_t;
 
 struct nlc_pe {
         struct list_head  list;
+        nlc_hnode_t       hnode; /* unused for the pe that hold an inode */
         inode_t          *inode;
         char             *name;
 };
 typedef struct nlc_pe nlc_pe_t;
 
+/* Name index of the positive or negative entries of a directory. The hash
+ * of a name is case insensitive, so that get_real_filename can use it. The
+ * Bloom filter answers "definitely not present" without walking a chain;
+ * names removed from the index stay in it until it is rebuilt, which is
+ * done when the index grows or when they outnumber the names present. */
+struct nlc_index {
+        struct list_head *buckets;
+        uint32_t          nbuckets;  /* power of two, 0 until first add */
+        uint32_t          count;
+        uint32_t          stale;     /* names removed since last rebuild */
+        uint64_t         *bloom;
+        uint32_t          bloom_bits;
+};
+typedef struct nlc_index nlc_index_t;
+
 struct nlc_timer_data {
         inode_t          *inode;
         xlator_t         *this;
@@ -75,6 +107,8 @@ typedef struct nlc_lru_node nlc_lru_node_t;
 struct nlc_ctx {
         struct list_head         pe;   /* list of positive entries */
         struct list_head         ne;   /* list of negative entries */
+        nlc_index_t              pe_index;
+        nlc_index_t              ne_index;
         uint64_t                 state;
         time_t                   cache_time;
         struct gf_tw_timer_list *timer;
@@ -106,6 +140,7 @@ struct nlc_statistics {
         gf_atomic_t pe_inode_cnt;
         gf_atomic_t ne_inode_cnt;
         gf_atomic_t nlc_invals; /* No. of invalidates received from upcall*/
+        gf_atomic_t bloom_hit; /* No. of names the Bloom filters ruled out */
 };
 
 struct nlc_conf {
@@ -761,6 +761,53 @@ err:
 }
 
 
+/* both fds need to be opened, the destination is opened once the source is */
+int
+ob_copy_file_range_out (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                        off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                        uint32_t flags, dict_t *xdata)
+{
+        call_stub_t *stub;
+
+        stub = fop_copy_file_range_stub (frame,
+                                         default_copy_file_range_resume,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags, xdata);
+        if (!stub)
+                goto err;
+
+        open_and_resume (this, fd_out, stub);
+
+        return 0;
+err:
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, ENOMEM, NULL, NULL,
+                             NULL, NULL);
+        return 0;
+}
+
+int
+ob_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+        call_stub_t *stub;
+
+        stub = fop_copy_file_range_stub (frame, ob_copy_file_range_out,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags, xdata);
+        if (!stub)
+                goto err;
+
+        open_and_resume (this, fd_in, stub);
+
+        return 0;
+err:
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, ENOMEM, NULL, NULL,
+                             NULL, NULL);
+        return 0;
+}
+
+
 int
 ob_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc, int xflags,
 	   dict_t *xdata)
@@ -1061,6 +1108,7 @@ struct xlator_fops fops = {
 	.fallocate   = ob_fallocate,
 	.discard     = ob_discard,
         .zerofill    = ob_zerofill,
+        .copy_file_range = ob_copy_file_range,
 	.unlink      = ob_unlink,
 	.rename      = ob_rename,
 	.lk          = ob_lk,
@@ -774,6 +774,20 @@ qr_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         return 0;
 }
 
+static int
+qr_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+        qr_inode_prune (this, fd_out->inode, frame->root->unique);
+
+        STACK_WIND (frame, default_copy_file_range_cbk,
+                    FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+        return 0;
+}
+
 int
 qr_open (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
 	 fd_t *fd, dict_t *xdata)
@@ -1362,7 +1376,8 @@ struct xlator_fops qr_fops = {
         .ftruncate   = qr_ftruncate,
         .fallocate   = qr_fallocate,
         .discard     = qr_discard,
-        .zerofill    = qr_zerofill
+        .zerofill    = qr_zerofill,
+        .copy_file_range = qr_copy_file_range,
 };
 
 struct xlator_cbks qr_cbks = {
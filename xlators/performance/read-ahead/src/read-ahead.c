@@ -77,6 +77,7 @@ ra_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         file->fd = fd;
         file->page_count = conf->page_count;
         file->page_size = conf->page_size;
+        file->adaptive = conf->adaptive;
         pthread_mutex_init (&file->file_lock, NULL);
 
         if (!file->disabled) {
@@ -155,6 +156,7 @@ ra_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         file->fd = fd;
         file->page_count = conf->page_count;
         file->page_size = conf->page_size;
+        file->adaptive = conf->adaptive;
         pthread_mutex_init (&file->file_lock, NULL);
 
         ret = fd_ctx_set (fd, this, (uint64_t)(long)file);
@@ -240,6 +242,9 @@ flush_region (call_frame_t *frame, ra_file_t *file, off_t offset, off_t size,
                         }
                         trav = next;
                 }
+
+                if (file->adaptive)
+                        __ra_streams_invalidate (file, offset);
         }
         ra_file_unlock (file);
 }
@@ -392,6 +397,11 @@ dispatch_requests (call_frame_t *frame, ra_file_t *file)
                                 }
                                 fault = 1;
                                 need_atime_update = 0;
+                                local->miss_pages++;
+                        } else if (trav->ready) {
+                                local->hit_pages++;
+                        } else {
+                                local->wait_pages++;
                         }
                         trav->dirty = 0;
 
@@ -508,7 +518,8 @@ ra_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                 }
         }
 
-        if (!expected_offset) {
+        /* with the adaptive read-ahead, pages are dropped per stream */
+        if (!expected_offset && !file->adaptive) {
                 flush_region (frame, file, 0, file->pages.prev->offset + 1, 0);
         }
 
@@ -532,9 +543,14 @@ ra_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 
         dispatch_requests (frame, file);
 
-        flush_region (frame, file, 0, floor (offset, file->page_size), 0);
+        if (file->adaptive) {
+                ra_stream_read_ahead (frame, file);
+        } else {
+                flush_region (frame, file, 0, floor (offset, file->page_size),
+                              0);
 
-        read_ahead (frame, file);
+                read_ahead (frame, file);
+        }
 
         ra_frame_return (frame);
 
@@ -847,6 +863,11 @@ ra_fdctx_dump (xlator_t *this, fd_t *fd)
         gf_proc_dump_write ("next-expected-offset-for-sequential-reads",
                             "%"PRId64, file->offset);
 
+        gf_proc_dump_write ("adaptive", "%s", file->adaptive ? "yes" : "no");
+
+        if (file->adaptive)
+                ra_streams_dump (file);
+
         for (page = file->pages.next; page != &file->pages;
              page = page->next) {
                 sprintf (key, "page[%d]", i);
@@ -1055,6 +1076,61 @@ unwind:
         return 0;
 }
 
+int
+ra_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                        struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                        dict_t *xdata)
+{
+        GF_ASSERT (frame);
+
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno, stbuf,
+                             prebuf_dst, postbuf_dst, xdata);
+        return 0;
+}
+
+static int
+ra_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+        ra_file_t *file    = NULL;
+        fd_t      *iter_fd = NULL;
+        inode_t   *inode   = NULL;
+        uint64_t  tmp_file = 0;
+        int32_t   op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd_out, unwind);
+
+        inode = fd_out->inode;
+
+        LOCK (&inode->lock);
+        {
+                list_for_each_entry (iter_fd, &inode->fd_list, inode_list) {
+                        tmp_file = 0;
+                        fd_ctx_get (iter_fd, this, &tmp_file);
+                        file = (ra_file_t *)(long)tmp_file;
+                        if (!file)
+                                continue;
+
+                        flush_region (frame, file, off_out, len, 1);
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        STACK_WIND (frame, ra_copy_file_range_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags, xdata);
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                             NULL, NULL);
+        return 0;
+}
+
 int
 ra_priv_dump (xlator_t *this)
 {
@@ -1089,6 +1165,9 @@ ra_priv_dump (xlator_t *this)
                 gf_proc_dump_write ("page_count", "%d", conf->page_count);
                 gf_proc_dump_write ("force_atime_update", "%d",
                                     conf->force_atime_update);
+                gf_proc_dump_write ("adaptive", "%d", conf->adaptive);
+                gf_proc_dump_write ("max_window", "%"PRIu64,
+                                    conf->max_window);
         }
         pthread_mutex_unlock (&conf->conf_lock);
 
@@ -1145,6 +1224,11 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("pass-through", this->pass_through, options, bool,
                           out);
 
+        GF_OPTION_RECONF ("adaptive", conf->adaptive, options, bool, out);
+
+        GF_OPTION_RECONF ("max-window", conf->max_window, options,
+                          size_uint64, out);
+
         ret = 0;
  out:
         return ret;
@@ -1187,6 +1271,10 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("pass-through", this->pass_through, bool, out);
 
+        GF_OPTION_INIT ("adaptive", conf->adaptive, bool, out);
+
+        GF_OPTION_INIT ("max-window", conf->max_window, size_uint64, out);
+
         conf->files.next = &conf->files;
         conf->files.prev = &conf->files;
 
@@ -1258,6 +1346,7 @@ struct xlator_fops fops = {
         .fstat       = ra_fstat,
 	.discard     = ra_discard,
         .zerofill    = ra_zerofill,
+        .copy_file_range = ra_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
@@ -1303,5 +1392,29 @@ struct volume_options options[] = {
           .tags = {"read-ahead"},
           .description = "Enable/Disable read ahead translator"
         },
+        { .key  = {"adaptive"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+          .tags = {"read-ahead"},
+          .description = "Detect up to 8 sequential or strided streams of "
+                         "reads per fd, and read ahead of each with a window "
+                         "that grows while reads wait for their pages and "
+                         "shrinks when pages read ahead are not used. "
+                         "page-count is not used then. Applies to files "
+                         "opened after it is set."
+        },
+        { .key  = {"max-window"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 4096,
+          .max  = 64 * GF_UNIT_MB,
+          .default_value = "8MB",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+          .tags = {"read-ahead"},
+          .description = "Largest window of the adaptive read-ahead, per "
+                         "stream. It is at least one page."
+        },
         { .key = {NULL} },
 };
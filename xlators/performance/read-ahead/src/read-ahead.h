@@ -26,6 +26,16 @@ struct ra_file;
 struct ra_waitq;
 
 
+/* Streams tracked per fd by the adaptive read-ahead, and how many reads
+ * of the fd a stream may go without a match before it is dropped */
+#define RA_MAX_STREAMS          8
+#define RA_STREAM_IDLE          32
+
+/* most pages faulted ahead for one read, the rest of the window is filled
+ * on the next reads */
+#define RA_MAX_FAULTS           64
+
+
 struct ra_waitq {
         struct ra_waitq *next;
         void            *data;
@@ -55,6 +65,10 @@ struct ra_local {
         fd_t             *fd;
         int32_t           wait_count;
         pthread_mutex_t   local_lock;
+        /* pages of a read found ready, in transit and not there */
+        uint32_t          hit_pages;
+        uint32_t          wait_pages;
+        uint32_t          miss_pages;
 };
 
 
@@ -75,6 +89,39 @@ struct ra_page {
 };
 
 
+/*
+ * One access pattern of an fd for the adaptive read-ahead: reads of any size
+ * each starting where the last one ended (sequential), or reads of one size
+ * a fixed distance apart (strided). The window is how much is read ahead of
+ * the last read, in bytes of pages. It doubles when a read had to wait for
+ * or fault in its pages, i.e. the consumer is faster than what is in flight,
+ * and halves when pages read ahead were dropped unread.
+ */
+struct ra_stream {
+        off_t              last;        /* offset of the last read */
+        size_t             size;        /* and its size */
+        off_t              stride;
+        gf_boolean_t       sequential;
+        uint32_t           seq;         /* reads that matched the pattern */
+        uint64_t           window;
+        off_t              ra_next;     /* pages below are read ahead */
+        uint64_t           tick;        /* of the last read, 0 if unused */
+};
+
+
+struct ra_stats {
+        uint64_t           reads;
+        uint64_t           hit_pages;
+        uint64_t           wait_pages;
+        uint64_t           miss_pages;
+        uint64_t           prefetched_pages;
+        uint64_t           wasted_pages;
+        uint64_t           window_grows;
+        uint64_t           window_shrinks;
+        uint64_t           streams;
+};
+
+
 struct ra_file {
         struct ra_file    *next;
         struct ra_file    *prev;
@@ -90,6 +137,11 @@ struct ra_file {
         struct iatt        stbuf;
         uint64_t           page_size;
         uint32_t           page_count;
+        /* adaptive read-ahead, under file_lock */
+        gf_boolean_t       adaptive;
+        struct ra_stream   streams[RA_MAX_STREAMS];
+        uint64_t           ticks;
+        struct ra_stats    stats;
 };
 
 
@@ -100,6 +152,8 @@ struct ra_conf {
         struct ra_file    files;
         gf_boolean_t      force_atime_update;
         pthread_mutex_t   conf_lock;
+        gf_boolean_t      adaptive;     /* for fds opened from now on */
+        uint64_t          max_window;
 };
 
 
@@ -149,6 +203,15 @@ ra_frame_fill (ra_page_t *page,
 void
 ra_file_destroy (ra_file_t *file);
 
+void
+ra_stream_read_ahead (call_frame_t *frame, ra_file_t *file);
+
+void
+__ra_streams_invalidate (ra_file_t *file, off_t offset);
+
+void
+ra_streams_dump (ra_file_t *file);
+
 static inline void
 ra_file_lock (ra_file_t *file)
 {
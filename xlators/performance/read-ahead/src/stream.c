@@ -0,0 +1,401 @@
+/*
+  Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+  Adaptive read-ahead (option "adaptive"): every read of an fd is matched
+  against up to RA_MAX_STREAMS streams, see struct ra_stream. A stream
+  reads ahead once it has seen two sequential reads or three reads with the
+  same stride, so random reads never fetch more than they asked for. Pages
+  a stream has read past are dropped, as are the pages of a stream that has
+  not been used for RA_STREAM_IDLE reads of the fd.
+*/
+
+#include "glusterfs.h"
+#include "logging.h"
+#include "xlator.h"
+#include "statedump.h"
+#include "read-ahead.h"
+#include "read-ahead-messages.h"
+
+static off_t
+ra_stream_end (ra_file_t *file, struct ra_stream *stream)
+{
+        return max (stream->ra_next,
+                    roof (stream->last + stream->size, file->page_size));
+}
+
+
+/* pages a stream is reading or has read ahead */
+static gf_boolean_t
+__ra_stream_covers (ra_file_t *file, off_t offset)
+{
+        struct ra_stream *stream = NULL;
+        int               i      = 0;
+
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+                stream = &file->streams[i];
+                if (!stream->tick)
+                        continue;
+
+                if (offset >= floor (stream->last, file->page_size) &&
+                    offset < ra_stream_end (file, stream))
+                        return _gf_true;
+        }
+
+        return _gf_false;
+}
+
+
+/* drops the pages in [start, end) that no stream still needs, returns how
+ * many of them were read ahead and never read */
+static uint32_t
+ra_stream_flush (ra_file_t *file, off_t start, off_t end)
+{
+        ra_page_t *trav   = NULL;
+        ra_page_t *next   = NULL;
+        uint32_t   wasted = 0;
+
+        if (start >= end)
+                return 0;
+
+        ra_file_lock (file);
+        {
+                trav = file->pages.next;
+                while (trav != &file->pages && trav->offset < end) {
+                        next = trav->next;
+                        if (trav->offset >= start && !trav->waitq &&
+                            !__ra_stream_covers (file, trav->offset)) {
+                                if (trav->dirty)
+                                        wasted++;
+                                ra_page_purge (trav);
+                        }
+                        trav = next;
+                }
+
+                file->stats.wasted_pages += wasted;
+        }
+        ra_file_unlock (file);
+
+        return wasted;
+}
+
+
+/* pages from offset on were dropped, read them ahead again */
+void
+__ra_streams_invalidate (ra_file_t *file, off_t offset)
+{
+        struct ra_stream *stream = NULL;
+        int               i      = 0;
+
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+                stream = &file->streams[i];
+                if (stream->ra_next > offset)
+                        stream->ra_next = floor (offset, file->page_size);
+        }
+}
+
+
+static struct ra_stream *
+__ra_stream_new (ra_file_t *file, off_t offset, size_t size,
+                 uint64_t max_window, off_t drop[][2], int *drops)
+{
+        struct ra_stream *stream = NULL;
+        struct ra_stream *trav   = NULL;
+        int               i      = 0;
+
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+                trav = &file->streams[i];
+                if (!trav->tick) {
+                        stream = trav;
+                        break;
+                }
+                if (!stream || trav->tick < stream->tick)
+                        stream = trav;
+        }
+
+        if (stream->tick) {
+                drop[*drops][0] = floor (stream->last, file->page_size);
+                drop[*drops][1] = ra_stream_end (file, stream);
+                (*drops)++;
+        }
+
+        memset (stream, 0, sizeof (*stream));
+        stream->window = min (max (roof (size * 4, file->page_size),
+                                   file->page_size), max_window);
+        file->stats.streams++;
+
+        return stream;
+}
+
+
+/* the stream the read at offset belongs to, a new one if none. Returns the
+ * offset of the last read of the stream in prev, -1 for a new stream. */
+static struct ra_stream *
+__ra_stream_match (ra_file_t *file, off_t offset, size_t size,
+                   uint64_t max_window, off_t *prev, off_t drop[][2],
+                   int *drops)
+{
+        struct ra_stream *stream    = NULL;
+        struct ra_stream *candidate = NULL;
+        struct ra_stream *trav      = NULL;
+        off_t             expected  = 0;
+        off_t             distance  = 0;
+        off_t             best      = 0;
+        int               i         = 0;
+
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+                trav = &file->streams[i];
+                if (!trav->tick)
+                        continue;
+
+                if (file->ticks - trav->tick > RA_STREAM_IDLE) {
+                        drop[*drops][0] = floor (trav->last, file->page_size);
+                        drop[*drops][1] = ra_stream_end (file, trav);
+                        (*drops)++;
+                        trav->tick = 0;
+                        continue;
+                }
+
+                if (trav->seq) {
+                        expected = trav->last + (trav->sequential ?
+                                                 trav->size : trav->stride);
+                        if (offset == expected) {
+                                stream = trav;
+                                break;
+                        }
+                        continue;
+                }
+
+                /* one read seen, this one may start a pattern. A sequential
+                 * one wins, else the shortest stride. */
+                distance = offset - trav->last;
+                if (distance < (off_t)trav->size || distance > max_window)
+                        continue;
+                if (!candidate || distance < best) {
+                        candidate = trav;
+                        best = distance;
+                }
+        }
+
+        if (stream) {
+                stream->seq++;
+        } else if (candidate) {
+                stream = candidate;
+                stream->seq = 1;
+                stream->sequential = (best == (off_t)stream->size);
+                stream->stride = best;
+        } else {
+                stream = __ra_stream_new (file, offset, size, max_window,
+                                          drop, drops);
+        }
+
+        *prev = stream->tick ? stream->last : -1;
+
+        stream->last = offset;
+        stream->size = size;
+        stream->tick = file->ticks;
+
+        return stream;
+}
+
+
+static int
+__ra_stream_fault (ra_file_t *file, off_t offset, off_t *faults, int *nfaults)
+{
+        ra_page_t *page = NULL;
+
+        page = ra_page_get (file, offset);
+        if (page)
+                return 0;
+
+        page = ra_page_create (file, offset);
+        if (!page)
+                return -1;
+
+        page->dirty = 1;
+        faults[(*nfaults)++] = offset;
+
+        return 0;
+}
+
+
+/* creates the pages the stream should read ahead now, up to RA_MAX_FAULTS,
+ * and returns their offsets */
+static int
+__ra_stream_plan (ra_file_t *file, struct ra_stream *stream, off_t *faults)
+{
+        uint64_t  page_size = file->page_size;
+        off_t     cap       = 0;
+        off_t     offset    = 0;
+        off_t     first     = 0;
+        off_t     last      = 0;
+        off_t     page      = 0;
+        off_t     pos       = 0;
+        uint64_t  ahead     = 0;
+        int       nfaults   = 0;
+
+        /* the size is known once a read came back, reads past it are only
+         * sent by the application */
+        cap = file->stbuf.ia_size ? file->stbuf.ia_size : INT64_MAX;
+
+        if (stream->sequential) {
+                offset = stream->last + stream->size;
+                page = max (stream->ra_next, floor (offset, page_size));
+                last = min (roof (offset + stream->window, page_size), cap);
+
+                for (; page < last && nfaults < RA_MAX_FAULTS;
+                     page += page_size) {
+                        if (__ra_stream_fault (file, page, faults, &nfaults))
+                                break;
+                }
+                stream->ra_next = max (stream->ra_next, page);
+
+                return nfaults;
+        }
+
+        pos = stream->ra_next;
+        for (offset = stream->last + stream->stride;
+             ahead < stream->window && offset < cap &&
+             nfaults < RA_MAX_FAULTS;
+             offset += stream->stride) {
+                first = floor (offset, page_size);
+                last = min (roof (offset + stream->size, page_size), cap);
+                ahead += last - first;
+
+                for (page = max (first, pos);
+                     page < last && nfaults < RA_MAX_FAULTS;
+                     page += page_size) {
+                        if (__ra_stream_fault (file, page, faults, &nfaults))
+                                goto out;
+                }
+                pos = max (pos, page);
+        }
+out:
+        stream->ra_next = max (pos, page);
+
+        return nfaults;
+}
+
+
+void
+ra_stream_read_ahead (call_frame_t *frame, ra_file_t *file)
+{
+        ra_local_t       *local      = NULL;
+        ra_conf_t        *conf       = NULL;
+        struct ra_stream *stream     = NULL;
+        off_t             drop[RA_MAX_STREAMS][2];
+        off_t             faults[RA_MAX_FAULTS];
+        off_t             prev       = -1;
+        off_t             offset     = 0;
+        uint64_t          max_window = 0;
+        uint32_t          wasted     = 0;
+        int               drops      = 0;
+        int               nfaults    = 0;
+        int               i          = 0;
+
+        local = frame->local;
+        conf = file->conf;
+        offset = local->offset;
+        max_window = max (conf->max_window, file->page_size);
+
+        ra_file_lock (file);
+        {
+                file->ticks++;
+                file->stats.reads++;
+                file->stats.hit_pages += local->hit_pages;
+                file->stats.wait_pages += local->wait_pages;
+                file->stats.miss_pages += local->miss_pages;
+
+                stream = __ra_stream_match (file, offset, local->size,
+                                            max_window, &prev, drop, &drops);
+
+                if (stream->seq < (stream->sequential ? 1 : 2))
+                        goto unlock;
+
+                /* the pages were not there in time: the window does not
+                 * cover the time a read takes at this rate */
+                if ((local->wait_pages || local->miss_pages) &&
+                    stream->window < max_window) {
+                        stream->window = min (stream->window * 2, max_window);
+                        file->stats.window_grows++;
+                }
+                stream->window = min (stream->window, max_window);
+
+                nfaults = __ra_stream_plan (file, stream, faults);
+                file->stats.prefetched_pages += nfaults;
+        }
+unlock:
+        ra_file_unlock (file);
+
+        for (i = 0; i < nfaults; i++) {
+                gf_msg_trace (frame->this->name, 0,
+                              "RA at offset=%"PRId64, faults[i]);
+                ra_page_fault (file, frame, faults[i]);
+        }
+
+        /* pages the stream has read past */
+        if (prev >= 0 && offset > prev) {
+                wasted = ra_stream_flush (file, floor (prev, file->page_size),
+                                          floor (offset, file->page_size));
+                if (wasted) {
+                        ra_file_lock (file);
+                        {
+                                if (stream->window > file->page_size) {
+                                        stream->window = max (stream->window
+                                                              / 2,
+                                                              file->page_size);
+                                        file->stats.window_shrinks++;
+                                }
+                        }
+                        ra_file_unlock (file);
+                }
+        }
+
+        for (i = 0; i < drops; i++)
+                ra_stream_flush (file, drop[i][0], drop[i][1]);
+}
+
+
+void
+ra_streams_dump (ra_file_t *file)
+{
+        struct ra_stream *stream = NULL;
+        char              key[GF_DUMP_MAX_BUF_LEN];
+        int               i      = 0;
+
+        gf_proc_dump_write ("reads", "%"PRIu64, file->stats.reads);
+        gf_proc_dump_write ("hit-pages", "%"PRIu64, file->stats.hit_pages);
+        gf_proc_dump_write ("wait-pages", "%"PRIu64, file->stats.wait_pages);
+        gf_proc_dump_write ("miss-pages", "%"PRIu64, file->stats.miss_pages);
+        gf_proc_dump_write ("prefetched-pages", "%"PRIu64,
+                            file->stats.prefetched_pages);
+        gf_proc_dump_write ("wasted-pages", "%"PRIu64,
+                            file->stats.wasted_pages);
+        gf_proc_dump_write ("window-grows", "%"PRIu64,
+                            file->stats.window_grows);
+        gf_proc_dump_write ("window-shrinks", "%"PRIu64,
+                            file->stats.window_shrinks);
+        gf_proc_dump_write ("streams", "%"PRIu64, file->stats.streams);
+
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+                stream = &file->streams[i];
+                if (!stream->tick)
+                        continue;
+
+                snprintf (key, sizeof (key), "stream[%d]", i);
+                gf_proc_dump_write (key, "offset=%"PRId64",size=%"
+                                    GF_PRI_SIZET",%s=%"PRId64",matched=%u,"
+                                    "window=%"PRIu64, stream->last,
+                                    stream->size, stream->sequential ?
+                                    "sequential" : "stride",
+                                    stream->sequential ? 0 : stream->stride,
+                                    stream->seq, stream->window);
+        }
+}
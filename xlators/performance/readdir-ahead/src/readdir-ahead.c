@@ -720,6 +720,38 @@ rda_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         return 0;
 }
 
+static int32_t
+rda_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                         struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                         dict_t *xdata)
+{
+        struct rda_local *local       = NULL;
+        struct iatt       postbuf_out = {0,};
+
+        if (op_ret < 0)
+                goto unwind;
+
+        local = frame->local;
+        rda_inode_ctx_update_iatts (local->inode, this, postbuf_dst,
+                                    &postbuf_out);
+unwind:
+        RDA_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno, stbuf,
+                          prebuf_dst, &postbuf_out, xdata);
+        return 0;
+}
+
+static int32_t
+rda_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags, dict_t *xdata)
+{
+        RDA_COMMON_MODIFICATION_FOP (copy_file_range, frame, this,
+                                     fd_out->inode, xdata, fd_in, off_in,
+                                     fd_out, off_out, len, flags);
+        return 0;
+}
+
 static int32_t
 rda_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
@@ -1207,6 +1239,7 @@ struct xlator_fops fops = {
         .fallocate      = rda_fallocate,
         .discard        = rda_discard,
         .zerofill       = rda_zerofill,
+        .copy_file_range = rda_copy_file_range,
         /* metadata write */
         /* TODO: Invalidate stats in (f)setxattr
         .setxattr       = rda_setxattr,
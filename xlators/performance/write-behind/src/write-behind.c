@@ -2719,6 +2719,104 @@ noqueue:
 }
 
 
+int32_t
+wb_copy_file_range_helper (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                           off_t off_in, fd_t *fd_out, off_t off_out,
+                           size_t len, uint32_t flags, dict_t *xdata)
+{
+        STACK_WIND_TAIL (frame, FIRST_CHILD(this),
+                         FIRST_CHILD(this)->fops->copy_file_range, fd_in,
+                         off_in, fd_out, off_out, len, flags, xdata);
+        return 0;
+}
+
+/* second step, order the copy after the cached writes to the destination */
+int32_t
+wb_copy_file_range_out (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                        off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                        uint32_t flags, dict_t *xdata)
+{
+        wb_inode_t   *wb_inode     = NULL;
+        call_stub_t  *stub         = NULL;
+
+        wb_inode = wb_inode_ctx_get (this, fd_out->inode);
+        if (!wb_inode)
+                goto noqueue;
+
+        stub = fop_copy_file_range_stub (frame, wb_copy_file_range_helper,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags, xdata);
+        if (!stub)
+                goto unwind;
+
+        if (!wb_enqueue (wb_inode, stub))
+                goto unwind;
+
+        wb_process_queue (wb_inode);
+
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, ENOMEM, NULL, NULL,
+                             NULL, NULL);
+
+        if (stub)
+                call_stub_destroy (stub);
+        return 0;
+
+noqueue:
+        STACK_WIND_TAIL (frame, FIRST_CHILD(this),
+                         FIRST_CHILD(this)->fops->copy_file_range, fd_in,
+                         off_in, fd_out, off_out, len, flags, xdata);
+        return 0;
+}
+
+/* The copy happens below us, so the cached writes to both the source and
+ * the destination have to reach the bricks first. The copy is queued on the
+ * source, and once it is picked from there, on the destination.
+ */
+int32_t
+wb_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+        wb_inode_t   *wb_inode     = NULL;
+        call_stub_t  *stub         = NULL;
+
+        if (fd_in->inode == fd_out->inode)
+                goto out;
+
+        wb_inode = wb_inode_ctx_get (this, fd_in->inode);
+        if (!wb_inode)
+                goto out;
+
+        stub = fop_copy_file_range_stub (frame, wb_copy_file_range_out,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags, xdata);
+        if (!stub)
+                goto unwind;
+
+        if (!wb_enqueue (wb_inode, stub))
+                goto unwind;
+
+        wb_process_queue (wb_inode);
+
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, ENOMEM, NULL, NULL,
+                             NULL, NULL);
+
+        if (stub)
+                call_stub_destroy (stub);
+        return 0;
+
+out:
+        return wb_copy_file_range_out (frame, this, fd_in, off_in, fd_out,
+                                       off_out, len, flags, xdata);
+}
+
+
 int
 wb_forget (xlator_t *this, inode_t *inode)
 {
@@ -3074,6 +3172,7 @@ struct xlator_fops fops = {
         .fallocate   = wb_fallocate,
         .discard     = wb_discard,
         .zerofill    = wb_zerofill,
+        .copy_file_range = wb_copy_file_range,
 };
 
 
@@ -3567,6 +3567,39 @@ out:
         return -op_errno;
 }
 
+int
+client_pre_copy_file_range_v2 (xlator_t *this,
+                               gfx_copy_file_range_req *req, fd_t *fd_in,
+                               off_t off_in, fd_t *fd_out, off_t off_out,
+                               size_t size, int32_t flags, dict_t *xdata)
+{
+        int                op_errno    = ESTALE;
+        int64_t            remote_fd_in  = -1;
+        int64_t            remote_fd_out = -1;
+
+        CLIENT_GET_REMOTE_FD (this, fd_in, DEFAULT_REMOTE_FD,
+                              remote_fd_in, op_errno, out);
+
+        CLIENT_GET_REMOTE_FD (this, fd_out, DEFAULT_REMOTE_FD,
+                              remote_fd_out, op_errno, out);
+
+        req->size = size;
+        req->off_in = off_in;
+        req->off_out = off_out;
+        req->fd_in = remote_fd_in;
+        req->fd_out = remote_fd_out;
+        req->flag = flags;
+
+        memcpy (req->gfid1, fd_in->inode->gfid, 16);
+        memcpy (req->gfid2, fd_out->inode->gfid, 16);
+
+        dict_to_xdr (xdata, &req->xdata);
+
+        return 0;
+out:
+        return -op_errno;
+}
+
 int
 client_post_create_v2 (xlator_t *this, gfx_create_rsp *rsp,
                        struct iatt *stbuf, struct iatt *preparent,
@@ -614,6 +614,12 @@ client_pre_put_v2 (xlator_t *this, gfx_put_req *req, loc_t *loc, mode_t mode,
                    mode_t umask, int32_t flags, size_t size, off_t offset,
                    dict_t *xattr, dict_t *xdata);
 
+int
+client_pre_copy_file_range_v2 (xlator_t *this,
+                               gfx_copy_file_range_req *req, fd_t *fd_in,
+                               off_t off_in, fd_t *fd_out, off_t off_out,
+                               size_t size, int32_t flags, dict_t *xdata);
+
 int
 client_post_readv_v2 (xlator_t *this, gfx_read_rsp *rsp, struct iobref **iobref,
                       struct iobref *rsp_iobref, struct iatt *stat,
@@ -1178,6 +1178,21 @@ client_setvolume_cbk (struct rpc_req *req, struct iovec *iov, int count, void *m
         op_ret = 0;
         conf->connected = 1;
 
+        if (conf->connection_count > 1) {
+                ret = dict_get_str (this->options, "process-uuid",
+                                    &process_uuid);
+                if (!ret) {
+                        pthread_mutex_lock (&conf->lock);
+                        {
+                                GF_FREE (conf->process_uuid);
+                                conf->process_uuid = gf_strdup (process_uuid);
+                        }
+                        pthread_mutex_unlock (&conf->lock);
+
+                        client_data_conns_start (this);
+                }
+        }
+
         client_post_handshake (frame, frame->this);
 out:
         if (auth_fail) {
@@ -1387,6 +1402,174 @@ fail:
         return ret;
 }
 
+static int
+client_data_setvolume_cbk (struct rpc_req *req, struct iovec *iov, int count,
+                           void *myframe)
+{
+        call_frame_t     *frame    = NULL;
+        xlator_t         *this     = NULL;
+        clnt_conf_t      *conf     = NULL;
+        clnt_conn_t      *conn     = NULL;
+        clnt_conn_state_t state    = CLNT_CONN_DOWN;
+        gf_setvolume_rsp  rsp      = {0,};
+        int               op_ret   = -1;
+        int               op_errno = ENOTCONN;
+        int               ret      = 0;
+
+        frame = myframe;
+        this  = frame->this;
+        conf  = this->private;
+        conn  = frame->cookie;
+
+        if (-1 == req->rpc_status)
+                goto out;
+
+        ret = xdr_to_generic (*iov, &rsp, (xdrproc_t)xdr_gf_setvolume_rsp);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, EINVAL,
+                        PC_MSG_XDR_DECODING_FAILED, "XDR decoding failed");
+                op_errno = EINVAL;
+                goto out;
+        }
+
+        op_ret   = rsp.op_ret;
+        op_errno = gf_error_to_errno (rsp.op_errno);
+
+out:
+        pthread_mutex_lock (&conf->lock);
+        {
+                /* the connection can have gone down in between, it is
+                 * bound again when it comes back */
+                state = conn->state;
+                if (state == CLNT_CONN_BINDING)
+                        conn->state = (op_ret == 0) ? CLNT_CONN_READY
+                                                    : CLNT_CONN_CONNECTED;
+        }
+        pthread_mutex_unlock (&conf->lock);
+
+        if (state != CLNT_CONN_BINDING) {
+                gf_msg_debug (this->name, 0, "data connection %d went down "
+                              "during SETVOLUME", conn->index);
+        } else if (op_ret == 0) {
+                gf_msg (this->name, GF_LOG_INFO, 0,
+                        PC_MSG_DATA_CONN_CONNECTED, "data connection %d to "
+                        "%s is bound to the brick", conn->index,
+                        conn->rpc->conn.name);
+        } else {
+                gf_msg (this->name, GF_LOG_WARNING, op_errno,
+                        PC_MSG_DATA_CONN_FAILED, "SETVOLUME on data "
+                        "connection %d failed, reconnecting", conn->index);
+                rpc_transport_disconnect (conn->rpc->conn.trans, _gf_false);
+        }
+
+        free (rsp.dict.dict_val);
+
+        STACK_DESTROY (frame->root);
+
+        return 0;
+}
+
+/* Binds a connected data connection to the brick with the process-uuid of
+ * the main connection. Does nothing if the main connection is not bound or
+ * the data connection is not waiting to be bound.
+ */
+int
+client_data_setvolume (xlator_t *this, clnt_conn_t *conn)
+{
+        gf_setvolume_req  req          = {{0,},};
+        call_frame_t     *fr           = NULL;
+        clnt_conf_t      *conf         = NULL;
+        dict_t           *options      = NULL;
+        char             *process_uuid = NULL;
+        int               ret          = -1;
+
+        conf = this->private;
+
+        pthread_mutex_lock (&conf->lock);
+        {
+                if (conf->process_uuid &&
+                    (conn->state == CLNT_CONN_CONNECTED)) {
+                        process_uuid = gf_strdup (conf->process_uuid);
+                        if (process_uuid)
+                                conn->state = CLNT_CONN_BINDING;
+                }
+        }
+        pthread_mutex_unlock (&conf->lock);
+
+        if (!process_uuid)
+                return 0;
+
+        /* this->options holds everything the main connection sent, only
+         * the process-uuid differs while that one is being reconnected */
+        options = dict_copy_with_ref (this->options, NULL);
+        if (!options)
+                goto fail;
+
+        ret = dict_set_dynstr (options, "process-uuid", process_uuid);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, 0, PC_MSG_DICT_SET_FAILED,
+                        "failed to set process-uuid(%s) in handshake msg",
+                        process_uuid);
+                GF_FREE (process_uuid);
+                goto fail;
+        }
+
+        ret = dict_serialized_length (options);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, 0, PC_MSG_DICT_ERROR,
+                        "failed to get serialized length of dict");
+                ret = -1;
+                goto fail;
+        }
+        req.dict.dict_len = ret;
+        req.dict.dict_val = GF_CALLOC (1, req.dict.dict_len,
+                                       gf_client_mt_clnt_req_buf_t);
+        if (!req.dict.dict_val) {
+                ret = -1;
+                goto fail;
+        }
+
+        ret = dict_serialize (options, req.dict.dict_val);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        PC_MSG_DICT_SERIALIZE_FAIL, "failed to serialize "
+                        "dictionary");
+                goto fail;
+        }
+
+        fr = create_frame (this, this->ctx->pool);
+        if (!fr) {
+                ret = -1;
+                goto fail;
+        }
+        fr->cookie = conn;
+
+        /* on failure the callback is called and resets the state */
+        ret = client_submit_request_on (this, conn->rpc, &req, fr,
+                                        conf->handshake, GF_HNDSK_SETVOLUME,
+                                        client_data_setvolume_cbk, NULL,
+                                        NULL, 0, NULL, 0, NULL,
+                                        (xdrproc_t)xdr_gf_setvolume_req);
+        GF_FREE (req.dict.dict_val);
+        dict_unref (options);
+
+        return ret;
+
+fail:
+        pthread_mutex_lock (&conf->lock);
+        {
+                if (conn->state == CLNT_CONN_BINDING)
+                        conn->state = CLNT_CONN_CONNECTED;
+        }
+        pthread_mutex_unlock (&conf->lock);
+
+        GF_FREE (req.dict.dict_val);
+        if (options)
+                dict_unref (options);
+
+        return ret;
+}
+
 int
 select_server_supported_programs (xlator_t *this, gf_prog_detail *prog)
 {
@@ -23,6 +23,7 @@ enum gf_client_mem_types_ {
         gf_client_mt_clnt_args_t,
         gf_client_mt_compound_req_t,
         gf_client_mt_clnt_lock_request_t,
+        gf_client_mt_clnt_conn_t,
         gf_client_mt_end,
 };
 #endif /* __CLIENT_MEM_TYPES_H__ */
@@ -91,7 +91,9 @@ GLFS_MSGID(PC,
         PC_MSG_GFID_NULL,
         PC_MSG_RECALL_LEASE_FAIL,
         PC_MSG_INODELK_CONTENTION_FAIL,
-        PC_MSG_ENTRYLK_CONTENTION_FAIL
+        PC_MSG_ENTRYLK_CONTENTION_FAIL,
+        PC_MSG_DATA_CONN_CONNECTED,
+        PC_MSG_DATA_CONN_FAILED
 );
 
 #endif /* !_PC_MESSAGES_H__ */
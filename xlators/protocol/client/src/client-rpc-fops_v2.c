@@ -5720,6 +5720,104 @@ unwind:
         return 0;
 }
 
+int
+client4_0_copy_file_range_cbk (struct rpc_req *req, struct iovec *iov,
+                               int count, void *myframe)
+{
+        call_frame_t         *frame       = NULL;
+        gfx_common_3iatt_rsp  rsp         = {0,};
+        struct iatt           stbuf       = {0,};
+        struct iatt           prestat     = {0,};
+        struct iatt           poststat    = {0,};
+        int                   ret         = 0;
+        xlator_t             *this        = NULL;
+        dict_t               *xdata       = NULL;
+
+        this = THIS;
+
+        frame = myframe;
+
+        if (-1 == req->rpc_status) {
+                rsp.op_ret   = -1;
+                rsp.op_errno = ENOTCONN;
+                goto out;
+        }
+        ret = xdr_to_generic (*iov, &rsp, (xdrproc_t)xdr_gfx_common_3iatt_rsp);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, EINVAL,
+                        PC_MSG_XDR_DECODING_FAILED, "XDR decoding failed");
+                rsp.op_ret   = -1;
+                rsp.op_errno = EINVAL;
+                goto out;
+        }
+
+        ret = client_post_common_3iatt (this, &rsp, &stbuf, &prestat,
+                                        &poststat, &xdata);
+        if (ret < 0)
+                goto out;
+
+out:
+        if (rsp.op_ret == -1) {
+                gf_msg (this->name, GF_LOG_WARNING,
+                        gf_error_to_errno (rsp.op_errno),
+                        PC_MSG_REMOTE_OP_FAILED,
+                        "remote operation failed");
+        }
+        CLIENT_STACK_UNWIND (copy_file_range, frame, rsp.op_ret,
+                             gf_error_to_errno (rsp.op_errno), &stbuf,
+                             &prestat, &poststat, xdata);
+
+        if (xdata)
+                dict_unref (xdata);
+
+        return 0;
+}
+
+int32_t
+client4_0_copy_file_range (call_frame_t *frame, xlator_t *this, void *data)
+{
+        clnt_args_t             *args     = NULL;
+        clnt_conf_t             *conf     = NULL;
+        gfx_copy_file_range_req  req      = {{0},};
+        int                      op_errno = ESTALE;
+        int                      ret      = 0;
+
+        if (!frame || !this || !data)
+                goto unwind;
+
+        args = data;
+        conf = this->private;
+
+        ret = client_pre_copy_file_range_v2 (this, &req, args->fd,
+                                             args->offset, args->fd_out,
+                                             args->off_out, args->size,
+                                             args->flags, args->xdata);
+        if (ret) {
+                op_errno = -ret;
+                goto unwind;
+        }
+
+        ret = client_submit_request (this, &req, frame, conf->fops,
+                                     GFS3_OP_COPY_FILE_RANGE,
+                                     client4_0_copy_file_range_cbk, NULL,
+                                     NULL, 0, NULL, 0, NULL,
+                                     (xdrproc_t)xdr_gfx_copy_file_range_req);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_WARNING, 0, PC_MSG_FOP_SEND_FAILED,
+                        "failed to send the fop");
+        }
+
+        GF_FREE (req.xdata.pairs.pairs_val);
+
+        return 0;
+unwind:
+        CLIENT_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                             NULL, NULL);
+        GF_FREE (req.xdata.pairs.pairs_val);
+
+        return 0;
+}
+
 int32_t
 client4_0_fsetattr (call_frame_t *frame, xlator_t *this, void *data)
 {
@@ -6079,6 +6177,7 @@ char *clnt4_0_fop_names[GFS3_OP_MAXVALUE] = {
         [GFS3_OP_COMPOUND]    = "COMPOUND",
         [GFS3_OP_ICREATE]     = "ICREATE",
         [GFS3_OP_NAMELINK]    = "NAMELINK",
+        [GFS3_OP_COPY_FILE_RANGE] = "COPY_FILE_RANGE",
 };
 
 rpc_clnt_procedure_t clnt4_0_fop_actors[GF_FOP_MAXVALUE] = {
@@ -6138,6 +6237,8 @@ rpc_clnt_procedure_t clnt4_0_fop_actors[GF_FOP_MAXVALUE] = {
         [GF_FOP_COMPOUND]     = { "COMPOUND",     client4_0_compound },
         [GF_FOP_ICREATE]      = { "ICREATE",      client4_0_icreate },
         [GF_FOP_NAMELINK]     = { "NAMELINK",     client4_0_namelink },
+        [GF_FOP_COPY_FILE_RANGE] = { "COPY_FILE_RANGE",
+                                     client4_0_copy_file_range },
 };
 
 
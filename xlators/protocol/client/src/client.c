@@ -44,6 +44,10 @@ client_fini_complete (xlator_t *this)
 
         clnt_conf_t *conf = this->private;
 
+        /* called once for the main and for every data connection */
+        if (GF_ATOMIC_DEC (conf->rpc_count) > 0)
+                return 0;
+
         if (!conf->destroy)
                 return 0;
 
@@ -51,6 +55,8 @@ client_fini_complete (xlator_t *this)
 
         pthread_spin_destroy (&conf->fd_lock);
         pthread_mutex_destroy (&conf->lock);
+        GF_FREE (conf->process_uuid);
+        GF_FREE (conf->data_conns);
         GF_FREE (conf);
 
 out:
@@ -126,6 +132,43 @@ client_type_to_gf_type (short l_type)
         return gf_type;
 }
 
+/* Requests that carry a data payload in either direction are spread over
+ * the data connections, by the gfid of the fd so that the requests of one
+ * file stay in order on one connection. Everything else, and bulk requests
+ * when no data connection is ready, go over the main connection so that
+ * small metadata fops do not queue up behind large reads and writes.
+ */
+static struct rpc_clnt *
+client_pick_rpc (clnt_conf_t *conf, rpc_clnt_prog_t *prog,
+                 call_frame_t *frame, gf_boolean_t bulk)
+{
+        clnt_local_t *local = NULL;
+        clnt_conn_t  *conn  = NULL;
+        uint32_t      hash  = 0;
+        int           count = 0;
+        int           i     = 0;
+
+        count = conf->connection_count - 1;
+        if (!bulk || (count <= 0) || (prog != conf->fops))
+                return conf->rpc;
+
+        local = frame->local;
+        if (local && local->fd && local->fd->inode)
+                memcpy (&hash, &local->fd->inode->gfid[12], sizeof (hash));
+        else
+                hash = GF_ATOMIC_INC (conf->data_conn_next);
+
+        /* state is read without the lock, a connection that just went
+         * down fails the request with ENOTCONN like the main one would */
+        for (i = 0; i < count; i++) {
+                conn = &conf->data_conns[(hash + i) % count];
+                if (conn->state == CLNT_CONN_READY)
+                        return conn->rpc;
+        }
+
+        return conf->rpc;
+}
+
 int
 client_submit_request (xlator_t *this, void *req, call_frame_t *frame,
                        rpc_clnt_prog_t *prog, int procnum, fop_cbk_fn_t cbkfn,
@@ -133,6 +176,30 @@ client_submit_request (xlator_t *this, void *req, call_frame_t *frame,
                        int payloadcnt, struct iovec *rsp_payload,
                        int rsp_payload_count, struct iobref *rsp_iobref,
                        xdrproc_t xdrproc)
+{
+        struct rpc_clnt *rpc = NULL;
+
+        /* arguments are validated by client_submit_request_on () */
+        if (this && this->private && prog && frame)
+                rpc = client_pick_rpc (this->private, prog, frame,
+                                       (payloadcnt > 0) ||
+                                       (rsp_payload_count > 0));
+
+        return client_submit_request_on (this, rpc, req, frame, prog,
+                                         procnum, cbkfn, iobref, payload,
+                                         payloadcnt, rsp_payload,
+                                         rsp_payload_count, rsp_iobref,
+                                         xdrproc);
+}
+
+int
+client_submit_request_on (xlator_t *this, struct rpc_clnt *rpc, void *req,
+                          call_frame_t *frame, rpc_clnt_prog_t *prog,
+                          int procnum, fop_cbk_fn_t cbkfn,
+                          struct iobref *iobref,  struct iovec *payload,
+                          int payloadcnt, struct iovec *rsp_payload,
+                          int rsp_payload_count, struct iobref *rsp_iobref,
+                          xdrproc_t xdrproc)
 {
         int             ret        = -1;
         clnt_conf_t    *conf       = NULL;
@@ -148,6 +215,8 @@ client_submit_request (xlator_t *this, void *req, call_frame_t *frame,
         GF_VALIDATE_OR_GOTO (this->name, frame, out);
 
         conf = this->private;
+        if (!rpc)
+                rpc = conf->rpc;
 
         /* If 'setvolume' is not successful, we should not send frames to
            server, mean time we should be able to send 'DUMP' and 'SETVOLUME'
@@ -220,7 +289,7 @@ client_submit_request (xlator_t *this, void *req, call_frame_t *frame,
         }
 
         /* Send the msg */
-        ret = rpc_clnt_submit (conf->rpc, prog, procnum, cbkfn, &iov, count,
+        ret = rpc_clnt_submit (rpc, prog, procnum, cbkfn, &iov, count,
                                payload, payloadcnt, new_iobref, frame,
                                payload, payloadcnt, rsp_payload,
                                rsp_payload_count, rsp_iobref);
@@ -2174,6 +2243,44 @@ out:
         return 0;
 }
 
+int32_t
+client_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                        off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                        uint32_t flags, dict_t *xdata)
+{
+        int          ret      = -1;
+        int          op_errno = ENOTCONN;
+        clnt_conf_t *conf     = NULL;
+        rpc_clnt_procedure_t *proc = NULL;
+        clnt_args_t  args = {0,};
+
+        conf = this->private;
+        if (!conf || !conf->fops)
+                goto out;
+
+        args.fd = fd_in;
+        args.fd_out = fd_out;
+        args.offset = off_in;
+        args.off_out = off_out;
+        args.size = len;
+        args.flags = flags;
+        args.xdata = xdata;
+
+        /* servers speaking the 3.x protocol have no copy_file_range, the
+         * caller can fall back to reading and writing the data */
+        proc = &conf->fops->proctable[GF_FOP_COPY_FILE_RANGE];
+        if (proc->fn)
+                ret = proc->fn (frame, this, &args);
+        else
+                op_errno = EOPNOTSUPP;
+out:
+        if (ret)
+                STACK_UNWIND_STRICT (copy_file_range, frame, -1, op_errno,
+                                     NULL, NULL, NULL, NULL);
+
+        return 0;
+}
+
 int
 client_mark_fd_bad (xlator_t *this)
 {
@@ -2288,6 +2395,11 @@ client_rpc_notify (struct rpc_clnt *rpc, void *mydata, rpc_clnt_event_t event,
                 conf->can_log_disconnect = 0;
                 conf->skip_notify = 0;
 
+                /* the data connections are bound to the server side
+                 * client_t of this connection, drop them so that the
+                 * server can clean it up */
+                client_data_conns_stop (this);
+
                 if (conf->quick_reconnect) {
                         conf->quick_reconnect = 0;
                         rpc_clnt_cleanup_and_start (rpc);
@@ -2312,6 +2424,126 @@ out:
 }
 
 
+static int
+client_data_rpc_notify (struct rpc_clnt *rpc, void *mydata,
+                        rpc_clnt_event_t event, void *data)
+{
+        clnt_conn_t *conn = NULL;
+        xlator_t    *this = NULL;
+        clnt_conf_t *conf = NULL;
+
+        conn = mydata;
+        this = conn->this;
+        conf = this->private;
+        if (!conf)
+                goto out;
+
+        switch (event) {
+        case RPC_CLNT_CONNECT:
+                gf_msg_debug (this->name, 0, "data connection %d: got "
+                              "RPC_CLNT_CONNECT", conn->index);
+
+                pthread_mutex_lock (&conf->lock);
+                {
+                        conn->state = CLNT_CONN_CONNECTED;
+                }
+                pthread_mutex_unlock (&conf->lock);
+
+                /* does nothing when the main connection is not bound yet,
+                 * client_data_conns_start () binds it later */
+                client_data_setvolume (this, conn);
+                break;
+
+        case RPC_CLNT_DISCONNECT:
+                gf_msg_debug (this->name, 0, "data connection %d: got "
+                              "RPC_CLNT_DISCONNECT", conn->index);
+
+                pthread_mutex_lock (&conf->lock);
+                {
+                        conn->state = CLNT_CONN_DOWN;
+                }
+                pthread_mutex_unlock (&conf->lock);
+                break;
+
+        case RPC_CLNT_DESTROY:
+                client_fini_complete (this);
+                break;
+
+        default:
+                break;
+        }
+
+out:
+        return 0;
+}
+
+/* Called once the main connection is bound to the brick: point the data
+ * connections at the brick port found through the portmapper and connect
+ * them, or bind the ones that are already connected.
+ */
+void
+client_data_conns_start (xlator_t *this)
+{
+        clnt_conf_t            *conf   = NULL;
+        clnt_conn_t            *conn   = NULL;
+        struct rpc_clnt_config  config = {0, };
+        gf_boolean_t            start  = _gf_false;
+        int                     i      = 0;
+
+        conf = this->private;
+
+        config.remote_port = conf->rpc->conn.config.remote_port;
+
+        for (i = 0; i < conf->connection_count - 1; i++) {
+                conn = &conf->data_conns[i];
+
+                conn->rpc->auth_value = conf->rpc->auth_value;
+                rpc_clnt_reconfig (conn->rpc, &config);
+
+                pthread_mutex_lock (&conf->lock);
+                {
+                        start = !conn->started;
+                        conn->started = _gf_true;
+                }
+                pthread_mutex_unlock (&conf->lock);
+
+                if (start)
+                        rpc_clnt_start (conn->rpc);
+                else
+                        client_data_setvolume (this, conn);
+        }
+}
+
+/* The main connection went down: take the data connections out of use
+ * right away and disconnect them until it is bound again.
+ */
+void
+client_data_conns_stop (xlator_t *this)
+{
+        clnt_conf_t *conf = NULL;
+        int          i    = 0;
+
+        conf = this->private;
+
+        if (conf->connection_count <= 1)
+                return;
+
+        pthread_mutex_lock (&conf->lock);
+        {
+                GF_FREE (conf->process_uuid);
+                conf->process_uuid = NULL;
+
+                for (i = 0; i < conf->connection_count - 1; i++) {
+                        conf->data_conns[i].state = CLNT_CONN_DOWN;
+                        conf->data_conns[i].started = _gf_false;
+                }
+        }
+        pthread_mutex_unlock (&conf->lock);
+
+        for (i = 0; i < conf->connection_count - 1; i++)
+                rpc_clnt_disable (conf->data_conns[i].rpc);
+}
+
 int
 notify (xlator_t *this, int32_t event, void *data, ...)
 {
@@ -2344,6 +2576,7 @@ notify (xlator_t *this, int32_t event, void *data, ...)
                 pthread_mutex_unlock (&conf->lock);
 
                 rpc_clnt_disable (conf->rpc);
+                client_data_conns_stop (this);
                 break;
 
         default:
@@ -2421,6 +2654,9 @@ build_client_config (xlator_t *this, clnt_conf_t *conf)
 
         GF_OPTION_INIT ("send-gids", conf->send_gids, bool, out);
 
+        GF_OPTION_INIT ("connection-count", conf->connection_count, int32,
+                        out);
+
         conf->client_id = glusterfs_leaf_position(this);
 
         ret = client_check_remote_host (this, this->options);
@@ -2481,6 +2717,77 @@ out:
         return ret;
 }
 
+static int
+client_init_data_rpcs (xlator_t *this)
+{
+        clnt_conf_t *conf               = NULL;
+        clnt_conn_t *conn               = NULL;
+        char         name[NAME_MAX + 1] = {0, };
+        int          ret                = -1;
+        int          i                  = 0;
+
+        conf = this->private;
+
+        GF_ATOMIC_INIT (conf->data_conn_next, 0);
+
+        if (conf->connection_count <= 1) {
+                ret = 0;
+                goto out;
+        }
+
+        conf->data_conns = GF_CALLOC (conf->connection_count - 1,
+                                      sizeof (*conf->data_conns),
+                                      gf_client_mt_clnt_conn_t);
+        if (!conf->data_conns)
+                goto out;
+
+        for (i = 0; i < conf->connection_count - 1; i++) {
+                conn = &conf->data_conns[i];
+                conn->this = this;
+                conn->index = i + 1;
+                conn->state = CLNT_CONN_DOWN;
+
+                snprintf (name, sizeof (name), "%s-%d", this->name,
+                          conn->index);
+
+                conn->rpc = rpc_clnt_new (this->options, this, name, 0);
+                if (!conn->rpc) {
+                        gf_msg (this->name, GF_LOG_ERROR, 0,
+                                PC_MSG_RPC_INIT_FAILED, "failed to "
+                                "initialize RPC of data connection %d",
+                                conn->index);
+                        goto out;
+                }
+                GF_ATOMIC_INC (conf->rpc_count);
+
+                ret = rpc_clnt_register_notify (conn->rpc,
+                                                client_data_rpc_notify,
+                                                conn);
+                if (ret) {
+                        gf_msg (this->name, GF_LOG_ERROR, 0,
+                                PC_MSG_RPC_NOTIFY_FAILED, "failed to "
+                                "register notify");
+                        goto out;
+                }
+
+                /* the server sends upcalls over any of the connections
+                 * bound to the client_t */
+                ret = rpcclnt_cbk_program_register (conn->rpc,
+                                                    &gluster_cbk_prog,
+                                                    this);
+                if (ret) {
+                        gf_msg (this->name, GF_LOG_ERROR, 0,
+                                PC_MSG_RPC_CBK_FAILED, "failed to register "
+                                "callback program");
+                        goto out;
+                }
+        }
+
+        ret = 0;
+out:
+        return ret;
+}
+
 int
 client_init_rpc (xlator_t *this)
 {
@@ -2497,6 +2804,8 @@ client_init_rpc (xlator_t *this)
                 goto out;
         }
 
+        GF_ATOMIC_INIT (conf->rpc_count, 1);
+
         conf->rpc = rpc_clnt_new (this->options, this, this->name, 0);
         if (!conf->rpc) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, PC_MSG_RPC_INIT_FAILED,
@@ -2522,6 +2831,10 @@ client_init_rpc (xlator_t *this)
                 goto out;
         }
 
+        ret = client_init_data_rpcs (this);
+        if (ret)
+                goto out;
+
         ret = 0;
 
         gf_msg_debug (this->name, 0, "client init successful");
@@ -2693,12 +3006,20 @@ void
 fini (xlator_t *this)
 {
         clnt_conf_t *conf = NULL;
+        int          i    = 0;
 
         conf = this->private;
         if (!conf)
                 return;
 
         conf->destroy = 1;
+        for (i = 0; conf->data_conns && i < conf->connection_count - 1; i++) {
+                if (!conf->data_conns[i].rpc)
+                        continue;
+                rpc_clnt_connection_cleanup (&conf->data_conns[i].rpc->conn);
+                rpc_clnt_unref (conf->data_conns[i].rpc);
+        }
+
         if (conf->rpc) {
                 /* cleanup the saved-frames before last unref */
                 rpc_clnt_connection_cleanup (&conf->rpc->conn);
@@ -2810,6 +3131,24 @@ client_priv_dump (xlator_t *this)
                 gf_proc_dump_write("msgs_sent", "%"PRIu64,
                                     conn->msgcnt);
         }
+
+        gf_proc_dump_write ("connection_count", "%d", conf->connection_count);
+        for (i = 0; i < conf->connection_count - 1; i++) {
+                conn = &conf->data_conns[i].rpc->conn;
+                sprintf (key, "data_conn.%d.state",
+                         conf->data_conns[i].index);
+                gf_proc_dump_write (key, "%d", conf->data_conns[i].state);
+                if (!conn->trans)
+                        continue;
+                sprintf (key, "data_conn.%d.total_bytes_read",
+                         conf->data_conns[i].index);
+                gf_proc_dump_write (key, "%"PRIu64,
+                                    conn->trans->total_bytes_read);
+                sprintf (key, "data_conn.%d.total_bytes_written",
+                         conf->data_conns[i].index);
+                gf_proc_dump_write (key, "%"PRIu64,
+                                    conn->trans->total_bytes_write);
+        }
         pthread_mutex_unlock(&conf->lock);
 
         return 0;
@@ -2894,6 +3233,7 @@ struct xlator_fops fops = {
         .icreate      = client_icreate,
         .namelink     = client_namelink,
         .put          = client_put,
+        .copy_file_range = client_copy_file_range,
 };
 
 
@@ -2989,6 +3329,19 @@ struct volume_options options[] = {
           .op_version = {GD_OP_VERSION_3_7_0},
           .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC
         },
+        { .key   = {"connection-count"},
+          .type  = GF_OPTION_TYPE_INT,
+          .min   = 1,
+          .max   = 16,
+          .default_value = "1",
+          .description = "Number of TCP connections to open to the brick. "
+                         "With more than one, reads and writes are spread "
+                         "over the additional connections by file while "
+                         "the first one carries the metadata operations. "
+                         "Takes effect when the client is (re)started.",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC
+        },
         { .key   = {NULL} },
 };
 
@@ -181,6 +181,28 @@ struct clnt_options {
         int   ping_timeout;
 };
 
+typedef enum {
+        CLNT_CONN_DOWN = 0,     /* transport is not connected */
+        CLNT_CONN_CONNECTED,    /* connected, not bound to the brick yet */
+        CLNT_CONN_BINDING,      /* SETVOLUME sent */
+        CLNT_CONN_READY,        /* bound, fops can be sent over it */
+} clnt_conn_state_t;
+
+/* An additional connection to the brick (see option 'connection-count').
+ * It sends SETVOLUME with the process-uuid of the main connection, so the
+ * server binds it to the same client_t and fds, locks and leases obtained
+ * through one connection are valid on all of them. Only bulk data fops are
+ * sent over these, everything else stays on clnt_conf_t->rpc.
+ */
+typedef struct clnt_conn {
+        struct rpc_clnt       *rpc;
+        xlator_t              *this;
+        int                    index;
+        clnt_conn_state_t      state;   /* protected by clnt_conf_t->lock */
+        gf_boolean_t           started; /* rpc_clnt_start () was called, and
+                                           not undone by rpc_clnt_disable () */
+} clnt_conn_t;
+
 typedef struct clnt_conf {
         struct rpc_clnt       *rpc;
         struct clnt_options    opt;
@@ -239,6 +261,18 @@ typedef struct clnt_conf {
                                                     * up, disconnects can be
                                                     * logged
                                                     */
+
+        int                    connection_count; /* main connection plus
+                                                    data connections */
+        clnt_conn_t           *data_conns;       /* connection_count - 1 */
+        char                  *process_uuid;     /* process-uuid the main
+                                                    connection is bound
+                                                    with, NULL when it is
+                                                    not connected */
+        gf_atomic_t            data_conn_next;   /* round robin for requests
+                                                    without an fd */
+        gf_atomic_t            rpc_count;        /* rpc_clnts not destroyed
+                                                    yet */
 } clnt_conf_t;
 
 typedef struct _client_fd_ctx {
@@ -292,6 +326,7 @@ typedef struct client_local {
 typedef struct client_args {
         loc_t              *loc;
         fd_t               *fd;
+        fd_t               *fd_out; /* @fd_out in copy_file_range */
         const char         *linkname;
         struct iobref      *iobref;
         struct iovec       *vector;
@@ -304,6 +339,7 @@ typedef struct client_args {
         const char         *volume;
         const char         *basename;
         off_t               offset;
+        off_t               off_out; /* @off_out in copy_file_range */
         int32_t             mask;
         int32_t             cmd;
         size_t              size;
@@ -341,6 +377,14 @@ int client_submit_request (xlator_t *this, void *req,
                            struct iovec *rsp_payload, int rsp_count,
                            struct iobref *rsp_iobref, xdrproc_t xdrproc);
 
+int client_submit_request_on (xlator_t *this, struct rpc_clnt *rpc, void *req,
+                              call_frame_t *frame, rpc_clnt_prog_t *prog,
+                              int procnum, fop_cbk_fn_t cbk,
+                              struct iobref *iobref,
+                              struct iovec *rsphdr, int rsphdr_count,
+                              struct iovec *rsp_payload, int rsp_count,
+                              struct iobref *rsp_iobref, xdrproc_t xdrproc);
+
 int
 client_submit_compound_request (xlator_t *this, void *req, call_frame_t *frame,
                        rpc_clnt_prog_t *prog, int procnum, fop_cbk_fn_t cbkfn,
@@ -373,6 +417,10 @@ int32_t client_type_to_gf_type (short l_type);
 
 int client_mark_fd_bad (xlator_t *this);
 
+int client_data_setvolume (xlator_t *this, clnt_conn_t *conn);
+void client_data_conns_start (xlator_t *this);
+void client_data_conns_stop (xlator_t *this);
+
 int client_fd_lk_list_empty (fd_lk_ctx_t *lk_ctx, gf_boolean_t use_try_lock);
 void client_default_reopen_done (clnt_fd_ctx_t *fdctx, int64_t rfd,
                                  xlator_t *this);
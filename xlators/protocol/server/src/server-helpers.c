@@ -182,6 +182,11 @@ free_state (server_state_t *state)
                 state->fd = NULL;
         }
 
+        if (state->fd_out) {
+                fd_unref (state->fd_out);
+                state->fd_out = NULL;
+        }
+
         if (state->params) {
                 dict_unref (state->params);
                 state->params = NULL;
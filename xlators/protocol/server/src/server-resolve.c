@@ -471,6 +471,9 @@ resolve_anonfd_simple (call_frame_t *frame)
 
         if (frame->root->op == GF_FOP_READ || frame->root->op == GF_FOP_WRITE)
                 state->fd = fd_anonymous_with_flags (inode, state->flags);
+        else if (resolve == &state->resolve2)
+                /* copy_file_range is the only fop resolving two fds */
+                state->fd_out = fd_anonymous (inode);
         else
                 state->fd = fd_anonymous (inode);
 out:
@@ -541,6 +544,21 @@ server_resolve_fd (call_frame_t *frame)
                 return 0;
         }
 
+        if (resolve == &state->resolve2) {
+                /* copy_file_range is the only fop resolving two fds */
+                state->fd_out = gf_fd_fdptr_get (serv_ctx->fdtable, fd_no);
+                if (!state->fd_out) {
+                        gf_msg ("", GF_LOG_INFO, EBADF, PS_MSG_FD_NOT_FOUND,
+                                "fd not found in context");
+                        resolve->op_ret   = -1;
+                        resolve->op_errno = EBADF;
+                }
+
+                server_resolve_all (frame);
+
+                return 0;
+        }
+
         state->fd = gf_fd_fdptr_get (serv_ctx->fdtable, fd_no);
 
         if (!state->fd) {
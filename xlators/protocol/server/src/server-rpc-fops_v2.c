@@ -2066,6 +2066,53 @@ out:
         return 0;
 }
 
+int
+server4_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                             xlator_t *this, int32_t op_ret,
+                             int32_t op_errno, struct iatt *stbuf,
+                             struct iatt *prebuf_dst,
+                             struct iatt *postbuf_dst, dict_t *xdata)
+{
+        gfx_common_3iatt_rsp rsp   = {0,};
+        server_state_t      *state = NULL;
+        rpcsvc_request_t    *req   = NULL;
+
+        dict_to_xdr (xdata, &rsp.xdata);
+
+        if (op_ret < 0) {
+                state  = CALL_STATE (frame);
+                gf_msg (this->name,
+                        fop_log_level (GF_FOP_COPY_FILE_RANGE, op_errno),
+                        op_errno, PS_MSG_WRITE_INFO,
+                        "%"PRId64": COPY_FILE_RANGE %"PRId64" (%s) -> "
+                        "%"PRId64" (%s), client: %s, error-xlator: %s",
+                        frame->root->unique, state->resolve.fd_no,
+                        uuid_utoa (state->resolve.gfid),
+                        state->resolve2.fd_no,
+                        uuid_utoa (state->resolve2.gfid),
+                        STACK_CLIENT_NAME (frame->root),
+                        STACK_ERR_XL_NAME (frame->root));
+                goto out;
+        }
+
+        /* the source goes in @stat, the destination in the other two */
+        gfx_stat_from_iattx (&rsp.stat, stbuf);
+        gfx_stat_from_iattx (&rsp.preparent, prebuf_dst);
+        gfx_stat_from_iattx (&rsp.postparent, postbuf_dst);
+
+out:
+        rsp.op_ret    = op_ret;
+        rsp.op_errno  = gf_errno_to_error (op_errno);
+
+        req = frame->local;
+        server_submit_reply (frame, req, &rsp, NULL, 0, NULL,
+                             (xdrproc_t)xdr_gfx_common_3iatt_rsp);
+
+        GF_FREE (rsp.xdata.pairs.pairs_val);
+
+        return 0;
+}
+
 int
 server4_icreate_cbk (call_frame_t *frame,
                     void *cookie, xlator_t *this,
@@ -3400,6 +3447,35 @@ server4_namelink_resume (call_frame_t *frame, xlator_t *bound_xl)
         return 0;
 }
 
+int
+server4_copy_file_range_resume (call_frame_t *frame, xlator_t *bound_xl)
+{
+        server_state_t *state = NULL;
+
+        state = CALL_STATE (frame);
+
+        if (state->resolve.op_ret != 0)
+                goto err;
+
+        if (state->resolve2.op_ret != 0) {
+                state->resolve.op_ret   = state->resolve2.op_ret;
+                state->resolve.op_errno = state->resolve2.op_errno;
+                goto err;
+        }
+
+        STACK_WIND (frame, server4_copy_file_range_cbk,
+                    bound_xl, bound_xl->fops->copy_file_range,
+                    state->fd, state->offset, state->fd_out, state->off_out,
+                    state->size, state->flags, state->xdata);
+        return 0;
+err:
+        server4_copy_file_range_cbk (frame, NULL, frame->this,
+                                     state->resolve.op_ret,
+                                     state->resolve.op_errno, NULL, NULL,
+                                     NULL, NULL);
+        return 0;
+}
+
 int
 server4_icreate_resume (call_frame_t *frame, xlator_t *bound_xl)
 {
@@ -5621,6 +5697,48 @@ out:
 
 }
 
+int
+server4_0_copy_file_range (rpcsvc_request_t *req)
+{
+        server_state_t          *state    = NULL;
+        call_frame_t            *frame    = NULL;
+        gfx_copy_file_range_req  args     = {{0,},};
+        int                      ret      = -1;
+        int                      op_errno = 0;
+
+        if (!req)
+                return ret;
+
+        ret = rpc_receive_common (req, &frame, &state, NULL, &args,
+                                  xdr_gfx_copy_file_range_req,
+                                  GF_FOP_COPY_FILE_RANGE);
+        if (ret != 0)
+                goto out;
+
+        state->resolve.type  = RESOLVE_MUST;
+        state->resolve.fd_no = args.fd_in;
+        memcpy (state->resolve.gfid, args.gfid1, 16);
+
+        state->resolve2.type  = RESOLVE_MUST;
+        state->resolve2.fd_no = args.fd_out;
+        memcpy (state->resolve2.gfid, args.gfid2, 16);
+
+        state->offset  = args.off_in;
+        state->off_out = args.off_out;
+        state->size    = args.size;
+        state->flags   = args.flag;
+
+        xdr_to_dict (&args.xdata, &state->xdata);
+
+        ret = 0;
+        resolve_and_resume (frame, server4_copy_file_range_resume);
+out:
+        if (op_errno)
+                SERVER_REQ_SET_ERROR (req, ret);
+
+        return ret;
+}
+
 int
 server4_0_icreate (rpcsvc_request_t *req)
 {
@@ -6042,6 +6160,7 @@ rpcsvc_actor_t glusterfs4_0_fop_actors[] = {
         [GFS3_OP_COMPOUND]     = {"COMPOUND",     GFS3_OP_COMPOUND,     server4_0_compound,     NULL, 0, DRC_NA},
         [GFS3_OP_ICREATE]  = {"ICREATE",      GFS3_OP_ICREATE,      server4_0_icreate,  NULL, 0, DRC_NA},
         [GFS3_OP_NAMELINK]     = {"NAMELINK",     GFS3_OP_NAMELINK,     server4_0_namelink,     NULL, 0, DRC_NA},
+        [GFS3_OP_COPY_FILE_RANGE] = {"COPY_FILE_RANGE", GFS3_OP_COPY_FILE_RANGE, server4_0_copy_file_range, NULL, 0, DRC_NA},
 };
 
 
@@ -185,6 +185,7 @@ struct _server_state {
         int               valid;
 
         fd_t             *fd;
+        fd_t             *fd_out; /* destination of copy_file_range */
         dict_t           *params;
         int32_t           flags;
         int               wbflags;
@@ -195,6 +196,7 @@ struct _server_state {
 
         size_t            size;
         off_t             offset;
+        off_t             off_out; /* destination of copy_file_range */
         mode_t            mode;
         dev_t             dev;
         size_t            nr_count;
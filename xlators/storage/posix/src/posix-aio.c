@@ -180,6 +180,11 @@ posix_aio_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
 
         priv = this->private;
 
+        /* io_uring takes precedence when both are enabled */
+        if (posix_io_uring_readv (frame, this, fd, size, offset, flags,
+                                  xdata) == 0)
+                return 0;
+
         ret = posix_fd_ctx_get (fd, this, &pfd, &op_errno);
         if (ret < 0) {
                 gf_msg (this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
@@ -344,6 +349,11 @@ posix_aio_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         VALIDATE_OR_GOTO (fd, err);
 
         priv = this->private;
+
+        if (posix_io_uring_writev (frame, this, fd, iov, count, offset, flags,
+                                   iobref, xdata) == 0)
+                return 0;
+
         DISK_SPACE_CHECK_AND_GOTO (frame, priv, xdata, op_errno, op_errno, err);
 
         ret = posix_fd_ctx_get (fd, this, &pfd, &op_errno);
@@ -59,6 +59,7 @@
 #include "posix-messages.h"
 #include "events.h"
 #include "posix-gfid-path.h"
+#include "posix-merkle.h"
 #include "compat-uuid.h"
 
 extern char *marker_xattrs[];
@@ -106,6 +107,25 @@ extern char *marker_xattrs[];
 #endif
 
 
+/* "<lower bound>:<count>" for every non-empty log2 bucket */
+static void
+posix_priv_dump_hist (const char *key, uint64_t *hist)
+{
+        char buf[POSIX_FSYNC_HIST_BUCKETS * 32] = {0, };
+        int  len = 0;
+        int  i = 0;
+
+        for (i = 0; i < POSIX_FSYNC_HIST_BUCKETS; i++) {
+                if (!hist[i])
+                        continue;
+                len += snprintf (buf + len, sizeof (buf) - len,
+                                 "%s%lu:%"PRIu64, len ? " " : "",
+                                 i ? (1UL << (i - 1)) : 0UL, hist[i]);
+        }
+
+        gf_proc_dump_write ((char *)key, "%s", buf);
+}
+
 int32_t
 posix_priv (xlator_t *this)
 {
@@ -130,6 +150,20 @@ posix_priv (xlator_t *this)
         gf_proc_dump_write("max_write", "%d", priv->write_value);
         gf_proc_dump_write("nr_files", "%ld", priv->nr_files);
 
+        if (priv->batch_fsync_mode == BATCH_GROUP_COMMIT ||
+            priv->fsync_batches) {
+                gf_proc_dump_write ("fsync_batches", "%"PRIu64,
+                                    priv->fsync_batches);
+                gf_proc_dump_write ("fsync_interval_usec", "%"PRIu64,
+                                    priv->fsync_interval_usec);
+                gf_proc_dump_write ("fsync_batch_latency_usec", "%"PRIu64,
+                                    priv->fsync_latency_usec);
+                posix_priv_dump_hist ("fsync_batch_size",
+                                      priv->fsync_batch_hist);
+                posix_priv_dump_hist ("fsync_wait_usec",
+                                      priv->fsync_wait_hist);
+        }
+
         return 0;
 }
 
@@ -237,6 +271,8 @@ set_batch_fsync_mode (struct posix_private *priv, const char *str)
                 priv->batch_fsync_mode = BATCH_SYNCFS_REVERSE_FSYNC;
         else if (strcmp (str, "reverse-fsync") == 0)
                 priv->batch_fsync_mode = BATCH_REVERSE_FSYNC;
+        else if (strcmp (str, "group-commit") == 0)
+                priv->batch_fsync_mode = BATCH_GROUP_COMMIT;
         else
                 return -1;
 
@@ -326,6 +362,12 @@ posix_reconfigure (xlator_t *this, dict_t *options)
         else
                 posix_aio_off (this);
 
+        GF_OPTION_RECONF ("io-uring", priv->io_uring_configured,
+                          options, bool, out);
+
+        if (priv->io_uring_configured)
+                posix_io_uring_on (this);
+
         GF_OPTION_RECONF ("update-link-count-parent", priv->update_pgfid_nlinks,
                           options, bool, out);
 
@@ -393,6 +435,9 @@ posix_reconfigure (xlator_t *this, dict_t *options)
 
         GF_OPTION_RECONF ("ctime", priv->ctime, options, bool, out);
 
+        GF_OPTION_RECONF ("merkle-cache", priv->merkle_cache, options, bool,
+                          out);
+
         ret = 0;
 out:
         return ret;
@@ -535,6 +580,7 @@ posix_init (xlator_t *this)
         int32_t               gid           = -1;
         char                 *batch_fsync_mode_str;
         char                 *gfid2path_sep = NULL;
+        char                 *merkle_path   = NULL;
         int                  force_create  = -1;
         int                  force_directory = -1;
         int                  create_mask  = -1;
@@ -960,6 +1006,8 @@ posix_init (xlator_t *this)
 
         _private->aio_init_done = _gf_false;
         _private->aio_capable = _gf_false;
+        _private->io_uring_init_done = _gf_false;
+        _private->io_uring_capable = _gf_false;
 
         GF_OPTION_INIT ("brick-uid", uid, int32, out);
         GF_OPTION_INIT ("brick-gid", gid, int32, out);
@@ -979,6 +1027,11 @@ posix_init (xlator_t *this)
                 }
         }
 
+        GF_OPTION_INIT ("io-uring", _private->io_uring_configured, bool, out);
+
+        if (_private->io_uring_configured)
+                posix_io_uring_on (this);
+
         GF_OPTION_INIT ("node-uuid-pathinfo",
                         _private->node_uuid_pathinfo, bool, out);
         if (_private->node_uuid_pathinfo &&
@@ -1087,6 +1140,16 @@ posix_init (xlator_t *this)
                         bool, out);
 
         GF_OPTION_INIT ("ctime", _private->ctime, bool, out);
+
+        GF_OPTION_INIT ("merkle-cache", _private->merkle_cache, bool, out);
+
+        /* left over from when the cache was on, still to be cleaned up */
+        if (gf_asprintf (&merkle_path, "%s/%s", _private->base_path,
+                         POSIX_MERKLE_PATH) > 0) {
+                if (sys_lstat (merkle_path, &buf) == 0)
+                        _private->merkle_cache_present = _gf_true;
+                GF_FREE (merkle_path);
+        }
 out:
         if (ret) {
                 if (_private) {
@@ -1130,6 +1193,7 @@ posix_fini (xlator_t *this)
                 (void) gf_thread_cleanup_xint (priv->fsyncer);
                 priv->fsyncer = 0;
         }
+        posix_io_uring_fini (this);
         /*unlock brick dir*/
         if (priv->mount_lock)
                 (void) sys_closedir (priv->mount_lock);
@@ -1183,6 +1247,17 @@ struct volume_options options[] = {
           .op_version = {1},
           .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC
         },
+        {
+          .key  = {"io-uring"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Submit readv, writev, fsync, fallocate and discard "
+                         "through an io_uring, completions are processed by "
+                         "a dedicated thread instead of the io-threads "
+                         "workers",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC
+        },
         {
           .key = {"brick-uid"},
           .type = GF_OPTION_TYPE_INT,
@@ -1256,7 +1331,12 @@ struct volume_options options[] = {
           " of fsyncs and fsync() each file in the batch in reverse order.\n"
           " in reverse order.\n"
           "\t- reverse-fsync: Perform fsync() of each file in the batch in"
-          " reverse order.",
+          " reverse order.\n"
+          "\t- group-commit: Batch all fsyncs, not only those of replicated"
+          " transactions. Waits for more fsyncs only while they arrive"
+          " faster than the device syncs a batch, up to half a batch sync"
+          " time or batch-fsync-delay-usec. Writeback of all files in the"
+          " batch is started together, then each file is fsync()ed once.",
           .op_version = {3},
           .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC
         },
@@ -1264,7 +1344,7 @@ struct volume_options options[] = {
           .type = GF_OPTION_TYPE_INT,
           .default_value = "0",
           .description = "Num of usecs to wait for aggregating fsync"
-          " requests",
+          " requests. With group-commit, the most it waits.",
           .op_version = {3},
           .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC
         },
@@ -1399,5 +1479,16 @@ struct volume_options options[] = {
                          "distribute set. The time attributes stored at the backend are "
                          "not considered "
         },
+        { .key = {"merkle-cache"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .op_version = {GD_OP_VERSION_4_2_0},
+          .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+          .tags = {"posix"},
+          .description = "Keep the digests self-heal asks for when it "
+                         "compares a file as a hash tree in .glusterfs/merkle "
+                         "so that only the regions that differ are read "
+                         "again by the next heal of the file."
+        },
         { .key  = {NULL} }
 };
@@ -24,6 +24,7 @@
 #include "syscall.h"
 #include "posix-messages.h"
 #include "posix-metadata.h"
+#include "posix-merkle.h"
 
 #include "compat-errno.h"
 
@@ -927,6 +928,9 @@ posix_handle_unset_gfid (xlator_t *this, uuid_t gfid)
                         P_MSG_HANDLE_DELETE, "unlink %s failed ", path);
         }
 
+        if (S_ISREG (stat.st_mode))
+                posix_merkle_cache_unlink (this, gfid);
+
 out:
         return ret;
 }
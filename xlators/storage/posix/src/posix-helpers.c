@@ -51,6 +51,7 @@
 #include "statedump.h"
 #include "locking.h"
 #include "timer.h"
+#include "timespec.h"
 #include "glusterfs3-xdr.h"
 #include "hashfn.h"
 #include "glusterfs-acl.h"
@@ -2431,6 +2432,207 @@ posix_fsyncer_syncfs (xlator_t *this, struct list_head *head)
 }
 
 
+uint64_t
+posix_fsync_now_usec (void)
+{
+        struct timespec ts = {0, };
+
+        timespec_now (&ts);
+
+        return TS (ts) / 1000;
+}
+
+
+static int
+posix_fsync_hist_bucket (uint64_t value)
+{
+        int bucket = 0;
+
+        while (value && bucket < POSIX_FSYNC_HIST_BUCKETS - 1) {
+                value >>= 1;
+                bucket++;
+        }
+
+        return bucket;
+}
+
+
+/* Waiting only pays off when more fsyncs are expected before a sync of the
+ * batch would be done anyway, a lone fsync goes out right away. */
+static uint64_t
+posix_fsync_window (struct posix_private *priv)
+{
+        uint64_t window = 0;
+
+        if (!priv->fsync_latency_usec ||
+            priv->fsync_interval_usec >= priv->fsync_latency_usec)
+                return 0;
+
+        window = priv->fsync_latency_usec / 2;
+        if (priv->batch_fsync_delay_usec &&
+            window > priv->batch_fsync_delay_usec)
+                window = priv->batch_fsync_delay_usec;
+
+        return window;
+}
+
+
+static int
+posix_fsyncer_pick_group (xlator_t *this, struct list_head *head,
+                          uint64_t *waited)
+{
+        struct posix_private *priv = NULL;
+        struct timespec       deadline = {0, };
+        uint64_t              start = 0;
+        uint64_t              window = 0;
+        int                   target = 0;
+        int                   count = 0;
+
+        priv = this->private;
+        pthread_mutex_lock (&priv->fsync_mutex);
+        {
+                while (list_empty (&priv->fsyncs))
+                        pthread_cond_wait (&priv->fsync_cond,
+                                           &priv->fsync_mutex);
+
+                start = posix_fsync_now_usec ();
+                window = posix_fsync_window (priv);
+                if (window) {
+                        /* the batch we expect to gather in the window */
+                        target = 1 + window /
+                                 max (priv->fsync_interval_usec, 1);
+
+                        clock_gettime (CLOCK_REALTIME, &deadline);
+                        deadline.tv_nsec += window * 1000;
+                        deadline.tv_sec += deadline.tv_nsec / GIGA;
+                        deadline.tv_nsec %= GIGA;
+
+                        while (priv->fsync_queue_count < target) {
+                                if (pthread_cond_timedwait (&priv->fsync_cond,
+                                                            &priv->fsync_mutex,
+                                                            &deadline) ==
+                                    ETIMEDOUT)
+                                        break;
+                        }
+                }
+                *waited = posix_fsync_now_usec () - start;
+
+                count = priv->fsync_queue_count;
+                priv->fsync_queue_count = 0;
+                list_splice_init (&priv->fsyncs, head);
+        }
+        pthread_mutex_unlock (&priv->fsync_mutex);
+
+        return count;
+}
+
+
+/* stub->args_cbk.op_ret while the batch is processed */
+#define POSIX_FSYNC_PENDING 1
+
+static void
+posix_fsyncer_group (xlator_t *this, struct list_head *head, int count,
+                     uint64_t waited)
+{
+        struct posix_private *priv = NULL;
+        struct posix_fd      *pfd = NULL;
+        call_stub_t          *stub = NULL;
+        call_stub_t          *tmp = NULL;
+        call_stub_t          *same = NULL;
+        uint64_t              start = 0;
+        uint64_t              elapsed = 0;
+        int                   datasync = 0;
+        int                   op_errno = 0;
+        int                   ret = -1;
+
+        priv = this->private;
+        start = posix_fsync_now_usec ();
+
+        /* start writeback of every file in the batch before waiting on any
+         * of them, so the device gets all of it at once and the journal
+         * commits that the fsyncs below wait for are shared */
+        list_for_each_entry (stub, head, list) {
+                ret = posix_fd_ctx_get (stub->args.fd, this, &pfd, &op_errno);
+                if (ret < 0) {
+                        gf_msg (this->name, GF_LOG_ERROR, op_errno,
+                                P_MSG_GET_FDCTX_FAILED,
+                                "could not get fdctx for fd(%s)",
+                                uuid_utoa (stub->args.fd->inode->gfid));
+                        stub->args_cbk.op_ret = -1;
+                        stub->args_cbk.op_errno = op_errno;
+                        continue;
+                }
+
+                stub->args_cbk.op_ret = POSIX_FSYNC_PENDING;
+                posix_fdstat (this, stub->args.fd->inode, pfd->fd,
+                              &stub->args_cbk.prestat);
+#if defined(GF_LINUX_HOST_OS) && defined(SYNC_FILE_RANGE_WRITE)
+                if (count > 1)
+                        sync_file_range (pfd->fd, 0, 0,
+                                         SYNC_FILE_RANGE_WRITE);
+#endif
+        }
+
+        /* one fsync per inode: all requests for it in this batch came in
+         * before it started, so it covers every one of them */
+        list_for_each_entry (stub, head, list) {
+                if (stub->args_cbk.op_ret != POSIX_FSYNC_PENDING)
+                        continue;
+
+                datasync = stub->args.datasync;
+                for (same = list_entry (stub->list.next, call_stub_t, list);
+                     &same->list != head;
+                     same = list_entry (same->list.next, call_stub_t, list)) {
+                        if (same->args_cbk.op_ret == POSIX_FSYNC_PENDING &&
+                            same->args.fd->inode == stub->args.fd->inode &&
+                            !same->args.datasync)
+                                datasync = 0;
+                }
+
+                posix_fd_ctx_get (stub->args.fd, this, &pfd, NULL);
+                if (datasync)
+                        ret = sys_fdatasync (pfd->fd);
+                else
+                        ret = sys_fsync (pfd->fd);
+                op_errno = (ret == 0) ? 0 : errno;
+                if (ret) {
+                        gf_msg (this->name, GF_LOG_ERROR, op_errno,
+                                P_MSG_FSTAT_FAILED,
+                                "could not fsync fd(%s)",
+                                uuid_utoa (stub->args.fd->inode->gfid));
+                }
+
+                for (same = stub; &same->list != head;
+                     same = list_entry (same->list.next, call_stub_t, list)) {
+                        if (same->args_cbk.op_ret != POSIX_FSYNC_PENDING ||
+                            same->args.fd->inode != stub->args.fd->inode)
+                                continue;
+                        same->args_cbk.op_ret = ret;
+                        same->args_cbk.op_errno = op_errno;
+                        if (ret == 0 &&
+                            posix_fd_ctx_get (same->args.fd, this, &pfd,
+                                              NULL) == 0)
+                                posix_fdstat (this, same->args.fd->inode,
+                                              pfd->fd,
+                                              &same->args_cbk.poststat);
+                }
+        }
+
+        elapsed = posix_fsync_now_usec () - start;
+
+        priv->fsync_latency_usec = priv->fsync_latency_usec ?
+                (priv->fsync_latency_usec * 7 + elapsed) / 8 : elapsed;
+        priv->fsync_batches++;
+        priv->fsync_batch_hist[posix_fsync_hist_bucket (count)]++;
+        priv->fsync_wait_hist[posix_fsync_hist_bucket (waited)]++;
+
+        list_for_each_entry_safe (stub, tmp, head, list) {
+                call_unwind_error (stub, stub->args_cbk.op_ret,
+                                   stub->args_cbk.op_errno);
+        }
+}
+
+
 void *
 posix_fsyncer (void *d)
 {
@@ -2440,6 +2642,7 @@ posix_fsyncer (void *d)
         call_stub_t *tmp = NULL;
         struct list_head list;
         int count = 0;
+        uint64_t waited = 0;
         gf_boolean_t do_fsync = _gf_true;
 
         priv = this->private;
@@ -2447,6 +2650,16 @@ posix_fsyncer (void *d)
         for (;;) {
                 INIT_LIST_HEAD (&list);
 
+                if (priv->batch_fsync_mode == BATCH_GROUP_COMMIT) {
+                        count = posix_fsyncer_pick_group (this, &list,
+                                                          &waited);
+                        gf_msg_debug (this->name, 0,
+                                      "picked %d fsyncs after %"PRIu64
+                                      " usec", count, waited);
+                        posix_fsyncer_group (this, &list, count, waited);
+                        continue;
+                }
+
                 count = posix_fsyncer_pick (this, &list);
 
                 usleep (priv->batch_fsync_delay_usec);
@@ -2457,6 +2670,7 @@ posix_fsyncer (void *d)
                 switch (priv->batch_fsync_mode) {
                 case BATCH_NONE:
                 case BATCH_REVERSE_FSYNC:
+                case BATCH_GROUP_COMMIT:
                         break;
                 case BATCH_SYNCFS:
                 case BATCH_SYNCFS_SINGLE_FSYNC:
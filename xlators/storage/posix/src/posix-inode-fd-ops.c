@@ -60,6 +60,7 @@
 #include "posix-metadata.h"
 #include "events.h"
 #include "posix-gfid-path.h"
+#include "posix-merkle.h"
 #include "compat-uuid.h"
 
 extern char *marker_xattrs[];
@@ -951,6 +952,12 @@ posix_glfallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t keep_si
         struct iatt statpre = {0,};
         struct iatt statpost = {0,};
 
+        posix_merkle_cache_invalidate (this, fd->inode);
+
+        if (posix_io_uring_fallocate (frame, this, fd, keep_size, offset, len,
+                                      xdata) == 0)
+                return 0;
+
 #ifdef FALLOC_FL_KEEP_SIZE
         if (keep_size)
                 flags = FALLOC_FL_KEEP_SIZE;
@@ -983,6 +990,11 @@ posix_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         struct iatt statpre = {0,};
         struct iatt statpost = {0,};
 
+        posix_merkle_cache_invalidate (this, fd->inode);
+
+        if (posix_io_uring_discard (frame, this, fd, offset, len, xdata) == 0)
+                return 0;
+
         ret = posix_do_fallocate (frame, this, fd, flags, offset, len,
                                   &statpre, &statpost, xdata, &rsp_xdata);
         if (ret < 0)
@@ -1016,6 +1028,8 @@ posix_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         priv = this->private;
         DISK_SPACE_CHECK_AND_GOTO (frame, priv, xdata, op_ret, op_errno, out);
 
+        posix_merkle_cache_invalidate (this, fd->inode);
+
         ret = posix_do_zerofill (frame, this, fd, offset, len,
                                  &statpre, &statpost, xdata, &rsp_xdata);
         if (ret < 0) {
@@ -1127,6 +1141,167 @@ out:
 }
 #endif
 
+int32_t
+posix_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                       off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                       uint32_t flags, dict_t *xdata)
+{
+        int32_t                op_ret    = -1;
+        int32_t                op_errno  = 0;
+        ssize_t                ret       = -1;
+        struct posix_private  *priv      = NULL;
+        struct posix_fd       *pfd_in    = NULL;
+        struct posix_fd       *pfd_out   = NULL;
+        struct iatt            stbuf     = {0,};
+        struct iatt            preop     = {0,};
+        struct iatt            postop    = {0,};
+        gf_boolean_t           locked    = _gf_false;
+        posix_inode_ctx_t     *ctx       = NULL;
+        dict_t                *rsp_xdata = NULL;
+        size_t                 copied    = 0;
+        off_t                  pos_in    = off_in;
+        off_t                  pos_out   = off_out;
+
+        DECLARE_OLD_FS_ID_VAR;
+
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd_in, out);
+        VALIDATE_OR_GOTO (fd_out, out);
+        VALIDATE_OR_GOTO (this->private, out);
+
+        priv = this->private;
+
+        DISK_SPACE_CHECK_AND_GOTO (frame, priv, xdata, op_ret, op_errno, out);
+
+        ret = posix_fd_ctx_get (fd_in, this, &pfd_in, &op_errno);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
+                        "pfd is NULL from fd=%p", fd_in);
+                goto out;
+        }
+
+        ret = posix_fd_ctx_get (fd_out, this, &pfd_out, &op_errno);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
+                        "pfd is NULL from fd=%p", fd_out);
+                goto out;
+        }
+
+        ret = posix_check_internal_writes (this, fd_out, pfd_out->fd, xdata);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, 0, 0,
+                        "possible overwrite from internal client, fd=%p",
+                        fd_out);
+                op_errno = EBUSY;
+                goto out;
+        }
+
+        ret = posix_inode_ctx_get_all (fd_out->inode, this, &ctx);
+        if (ret < 0) {
+                op_errno = ENOMEM;
+                goto out;
+        }
+
+        /* same as writev, keep the size changes between the pre and post
+         * stat of the destination to this copy
+         */
+        if (xdata && dict_get (xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC)) {
+                locked = _gf_true;
+                pthread_mutex_lock (&ctx->write_atomic_lock);
+        }
+
+        ret = posix_fdstat (this, fd_in->inode, pfd_in->fd, &stbuf);
+        if (ret == -1) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_ERROR, errno, P_MSG_FSTAT_FAILED,
+                        "copy_file_range (fstat) failed on fd=%p", fd_in);
+                goto out;
+        }
+
+        ret = posix_fdstat (this, fd_out->inode, pfd_out->fd, &preop);
+        if (ret == -1) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_ERROR, errno, P_MSG_FSTAT_FAILED,
+                        "pre-operation fstat failed on fd=%p", fd_out);
+                goto out;
+        }
+
+        posix_merkle_cache_invalidate (this, fd_out->inode);
+
+        /* The kernel may copy less than asked for (and does so at the
+         * latest when a filesystem falls back to splicing through the page
+         * cache), loop until the source is exhausted or the request is
+         * complete.
+         */
+        while (copied < len) {
+                ret = sys_copy_file_range (pfd_in->fd, &pos_in, pfd_out->fd,
+                                           &pos_out, len - copied, flags);
+                if (ret <= 0)
+                        break;
+                copied += ret;
+        }
+
+        if (ret < 0 && copied == 0) {
+                op_errno = errno;
+                /* let the caller fall back to read and write */
+                if (op_errno == ENOSYS)
+                        op_errno = EOPNOTSUPP;
+                gf_msg (this->name, fop_log_level (GF_FOP_COPY_FILE_RANGE,
+                        op_errno), op_errno, P_MSG_COPY_FILE_RANGE_FAILED,
+                        "copy_file_range failed from %s offset: %jd to %s "
+                        "offset: %jd, len: %zu",
+                        uuid_utoa (fd_in->inode->gfid), (intmax_t)off_in,
+                        uuid_utoa (fd_out->inode->gfid), (intmax_t)off_out,
+                        len);
+                goto out;
+        }
+
+        ret = posix_fdstat (this, fd_out->inode, pfd_out->fd, &postop);
+        if (ret == -1) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_ERROR, errno, P_MSG_FSTAT_FAILED,
+                        "post-operation fstat failed on fd=%p", fd_out);
+                goto out;
+        }
+
+        posix_set_ctime (frame, this, NULL, pfd_out->fd, fd_out->inode,
+                         &postop);
+
+        if (locked) {
+                pthread_mutex_unlock (&ctx->write_atomic_lock);
+                locked = _gf_false;
+        }
+
+        rsp_xdata = _fill_writev_xdata (fd_out, xdata, this, 0);
+
+        op_ret = copied;
+
+        LOCK (&priv->lock);
+        {
+                priv->write_value    += op_ret;
+        }
+        UNLOCK (&priv->lock);
+
+out:
+        if (locked) {
+                pthread_mutex_unlock (&ctx->write_atomic_lock);
+                locked = _gf_false;
+        }
+
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno,
+                             &stbuf, &preop, &postop, rsp_xdata);
+
+        if (rsp_xdata)
+                dict_unref (rsp_xdata);
+
+        return 0;
+}
+
 int32_t
 posix_opendir (call_frame_t *frame, xlator_t *this,
                loc_t *loc, fd_t *fd, dict_t *xdata)
@@ -1337,6 +1512,8 @@ posix_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
                 }
         }
 
+        posix_merkle_cache_invalidate (this, loc->inode);
+
         op_ret = sys_truncate (real_path, offset);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -1485,6 +1662,10 @@ posix_readv (call_frame_t *frame, xlator_t *this,
         priv = this->private;
         VALIDATE_OR_GOTO (priv, out);
 
+        if (posix_io_uring_readv (frame, this, fd, size, offset, flags,
+                                  xdata) == 0)
+                return 0;
+
         ret = posix_fd_ctx_get (fd, this, &pfd, &op_errno);
         if (ret < 0) {
                 gf_msg (this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
@@ -1752,6 +1933,13 @@ posix_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         priv = this->private;
 
         VALIDATE_OR_GOTO (priv, out);
+
+        posix_merkle_cache_invalidate (this, fd->inode);
+
+        if (posix_io_uring_writev (frame, this, fd, vector, count, offset,
+                                   flags, iobref, xdata) == 0)
+                return 0;
+
         DISK_SPACE_CHECK_AND_GOTO (frame, priv, xdata, op_ret, op_errno, out);
 
         ret = posix_fd_ctx_get (fd, this, &pfd, &op_errno);
@@ -2063,6 +2251,8 @@ posix_batch_fsync (call_frame_t *frame, xlator_t *this,
 {
         call_stub_t *stub = NULL;
         struct posix_private *priv = NULL;
+        uint64_t now = 0;
+        uint64_t interval = 0;
 
         priv = this->private;
 
@@ -2072,8 +2262,20 @@ posix_batch_fsync (call_frame_t *frame, xlator_t *this,
                 return 0;
         }
 
+        now = posix_fsync_now_usec ();
+
         pthread_mutex_lock (&priv->fsync_mutex);
         {
+                /* a long idle period counts as one second, so the average
+                 * recovers quickly when a burst starts */
+                if (priv->fsync_last_arrival) {
+                        interval = min (now - priv->fsync_last_arrival,
+                                        (uint64_t)1000000);
+                        priv->fsync_interval_usec =
+                                (priv->fsync_interval_usec * 7 + interval) / 8;
+                }
+                priv->fsync_last_arrival = now;
+
                 list_add_tail (&stub->list, &priv->fsyncs);
                 priv->fsync_queue_count++;
                 pthread_cond_signal (&priv->fsync_cond);
@@ -2103,6 +2305,9 @@ posix_fsync (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (fd, out);
 
+        if (posix_io_uring_fsync (frame, this, fd, datasync, xdata) == 0)
+                return 0;
+
         SET_FS_ID (frame->root->uid, frame->root->gid);
 
 #ifdef GF_DARWIN_HOST_OS
@@ -2113,7 +2318,9 @@ posix_fsync (call_frame_t *frame, xlator_t *this,
 
         priv = this->private;
 
-        if (priv->batch_fsync_mode && xdata && dict_get (xdata, "batch-fsync")) {
+        if (priv->batch_fsync_mode == BATCH_GROUP_COMMIT ||
+            (priv->batch_fsync_mode && xdata &&
+             dict_get (xdata, "batch-fsync"))) {
                 posix_batch_fsync (frame, this, fd, datasync, xdata);
                 return 0;
         }
@@ -2322,6 +2529,8 @@ posix_setxattr (call_frame_t *frame, xlator_t *this,
                         goto unlock;
                 }
 
+                posix_merkle_cache_invalidate (this, loc->inode);
+
                 ret = sys_truncate (real_path, 0);
                 if (ret) {
                         gf_log ("POSIX", GF_LOG_ERROR, "truncate failed - %s"
@@ -4610,6 +4819,8 @@ posix_ftruncate (call_frame_t *frame, xlator_t *this,
                 }
         }
 
+        posix_merkle_cache_invalidate (this, fd->inode);
+
         op_ret = sys_ftruncate (_fd, offset);
 
         if (op_ret == -1) {
@@ -5283,6 +5494,21 @@ posix_rchecksum (call_frame_t *frame, xlator_t *this,
                         op_errno = EIO;
                         goto out;
 	        }
+
+                if (dict_get (xdata, GF_MERKLE_NODE_SIZE)) {
+                        ret = posix_merkle_rchecksum (this, fd, pfd, _fd,
+                                                      offset, xdata,
+                                                      rsp_xdata,
+                                                      strong_checksum);
+                        if (ret) {
+                                op_ret = -1;
+                                op_errno = -ret;
+                                goto out;
+                        }
+                        checksum = strong_checksum;
+                        op_ret = 0;
+                        goto out;
+                }
         }
 
         LOCK (&fd->lock);
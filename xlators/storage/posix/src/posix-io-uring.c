@@ -0,0 +1,1245 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#include "xlator.h"
+#include "glusterfs.h"
+#include "posix.h"
+#include "posix-messages.h"
+#include "posix-metadata.h"
+#include "posix-aio.h"
+#include "posix-io-uring.h"
+#include "syscall.h"
+#include <sys/uio.h>
+
+#ifdef HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define ALIGN_SIZE 4096
+
+#ifndef RWF_SYNC
+#define RWF_SYNC 0x00000004
+#endif
+
+/*
+ * readv, writev, fsync, fallocate and discard are handed to an io_uring
+ * instead of being executed by the io-threads worker. Any worker can queue
+ * requests, the first one that finds no submission in progress hands all
+ * of them to the kernel with a single io_uring_enter (). Completions are
+ * reaped in batches by a dedicated ring thread which finishes the fop
+ * (post-op stat, ctime update) and unwinds it.
+ *
+ * The posix fops call the posix_io_uring_* variants first and carry on
+ * synchronously when they decline the request. The fops table is shared by
+ * all the bricks of a multiplexed process, so it is never modified here.
+ *
+ * Requests that need the prestat, write and poststat to be atomic with
+ * respect to other writes (append detection, shard's update-atomic) keep
+ * using the synchronous fops, a mutex can't be held across threads.
+ */
+
+struct posix_io_uring {
+        xlator_t             *this;
+        int                   fd;
+        pthread_t             thread;
+
+        /* number of threads queueing requests, protected by priv->lock */
+        uint32_t              users;
+
+        /* protects the submission queue tail and the counters below */
+        pthread_mutex_t       lock;
+        gf_boolean_t          submitting;
+        uint32_t              pending;
+        uint32_t              inflight;
+        gf_boolean_t          stopping;
+
+        gf_boolean_t          ops[IORING_OP_LAST];
+
+        void                 *sq_ring;
+        size_t                sq_ring_size;
+        uint32_t             *sq_head;
+        uint32_t             *sq_tail;
+        uint32_t              sq_mask;
+        uint32_t              sq_entries;
+        uint32_t             *sq_array;
+        struct io_uring_sqe  *sqes;
+        size_t                sqes_size;
+
+        void                 *cq_ring;
+        size_t                cq_ring_size;
+        uint32_t             *cq_head;
+        uint32_t             *cq_tail;
+        uint32_t              cq_mask;
+        uint32_t              cq_entries;
+        struct io_uring_cqe  *cqes;
+};
+
+struct posix_io_uring_cb {
+        call_frame_t    *frame;
+        fd_t            *fd;
+        int              _fd;
+        glusterfs_fop_t  op;
+        off_t            offset;
+        size_t           size;
+        struct iobuf    *iobuf;
+        struct iobref   *iobref;
+        dict_t          *xdata;
+        dict_t          *rsp_xdata;
+        struct iatt      prebuf;
+        int              count;
+        struct iovec     vector[];
+};
+
+
+static struct posix_io_uring_cb *
+posix_io_uring_cb_new (call_frame_t *frame, fd_t *fd, int _fd,
+                       glusterfs_fop_t op, int count)
+{
+        struct posix_io_uring_cb *cb = NULL;
+
+        cb = GF_CALLOC (1, sizeof (*cb) + count * sizeof (struct iovec),
+                        gf_posix_mt_io_uring_cb);
+        if (!cb)
+                return NULL;
+
+        cb->frame = frame;
+        cb->fd = fd_ref (fd);
+        cb->_fd = _fd;
+        cb->op = op;
+        cb->count = count;
+
+        return cb;
+}
+
+
+static void
+posix_io_uring_cb_free (struct posix_io_uring_cb *cb)
+{
+        if (cb->iobuf)
+                iobuf_unref (cb->iobuf);
+        if (cb->iobref)
+                iobref_unref (cb->iobref);
+        if (cb->xdata)
+                dict_unref (cb->xdata);
+        if (cb->rsp_xdata)
+                dict_unref (cb->rsp_xdata);
+        if (cb->fd)
+                fd_unref (cb->fd);
+
+        GF_FREE (cb);
+}
+
+
+static void
+posix_io_uring_readv_complete (struct posix_io_uring_cb *cb, int res)
+{
+        call_frame_t         *frame = cb->frame;
+        xlator_t             *this = frame->this;
+        struct posix_private *priv = this->private;
+        struct iobref        *iobref = NULL;
+        struct iovec          iov = {0,};
+        struct iatt           postbuf = {0,};
+        int                   op_ret = -1;
+        int                   op_errno = 0;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_msg (this->name, GF_LOG_ERROR, op_errno, P_MSG_READ_FAILED,
+                        "read failed on gfid=%s, fd=%p, offset=%"PRIu64" "
+                        "size=%"GF_PRI_SIZET, uuid_utoa (cb->fd->inode->gfid),
+                        cb->fd, cb->offset, cb->size);
+                goto out;
+        }
+
+        if (posix_fdstat (this, cb->fd->inode, cb->_fd, &postbuf) != 0) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
+                        "fstat failed on fd=%p", cb->fd);
+                goto out;
+        }
+
+        posix_set_ctime (frame, this, NULL, cb->_fd, cb->fd->inode, &postbuf);
+
+        iobref = iobref_new ();
+        if (!iobref) {
+                op_errno = ENOMEM;
+                goto out;
+        }
+        iobref_add (iobref, cb->iobuf);
+
+        iov.iov_base = iobuf_ptr (cb->iobuf);
+        iov.iov_len = res;
+
+        /* Hack to notify higher layers of EOF. */
+        if (!postbuf.ia_size || (cb->offset + iov.iov_len) >= postbuf.ia_size)
+                op_errno = ENOENT;
+
+        LOCK (&priv->lock);
+        {
+                priv->read_value += res;
+        }
+        UNLOCK (&priv->lock);
+
+        op_ret = res;
+
+out:
+        STACK_UNWIND_STRICT (readv, frame, op_ret, op_errno, &iov, 1,
+                             &postbuf, iobref, cb->rsp_xdata);
+
+        if (iobref)
+                iobref_unref (iobref);
+}
+
+
+static void
+posix_io_uring_writev_complete (struct posix_io_uring_cb *cb, int res)
+{
+        call_frame_t         *frame = cb->frame;
+        xlator_t             *this = frame->this;
+        struct posix_private *priv = this->private;
+        struct iatt           postbuf = {0,};
+        dict_t               *rsp_xdata = NULL;
+        int                   op_ret = -1;
+        int                   op_errno = 0;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_msg (this->name, GF_LOG_ERROR, op_errno, P_MSG_WRITE_FAILED,
+                        "write failed: offset %"PRIu64, cb->offset);
+                goto out;
+        }
+
+        rsp_xdata = _fill_writev_xdata (cb->fd, cb->xdata, this, 0);
+
+        if (posix_fdstat (this, cb->fd->inode, cb->_fd, &postbuf) != 0) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
+                        "post-operation fstat failed on fd=%p", cb->fd);
+                goto out;
+        }
+
+        posix_set_ctime (frame, this, NULL, cb->_fd, cb->fd->inode, &postbuf);
+
+        LOCK (&priv->lock);
+        {
+                priv->write_value += res;
+        }
+        UNLOCK (&priv->lock);
+
+        op_ret = res;
+
+out:
+        STACK_UNWIND_STRICT (writev, frame, op_ret, op_errno, &cb->prebuf,
+                             &postbuf, rsp_xdata);
+
+        if (rsp_xdata)
+                dict_unref (rsp_xdata);
+}
+
+
+static void
+posix_io_uring_fsync_complete (struct posix_io_uring_cb *cb, int res)
+{
+        call_frame_t *frame = cb->frame;
+        xlator_t     *this = frame->this;
+        struct iatt   postbuf = {0,};
+        int           op_ret = -1;
+        int           op_errno = 0;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_msg (this->name, GF_LOG_ERROR, op_errno, P_MSG_FSYNC_FAILED,
+                        "fsync on fd=%p failed", cb->fd);
+                goto out;
+        }
+
+        if (posix_fdstat (this, cb->fd->inode, cb->_fd, &postbuf) != 0) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_WARNING, op_errno,
+                        P_MSG_FSTAT_FAILED,
+                        "post-operation fstat failed on fd=%p", cb->fd);
+                goto out;
+        }
+
+        op_ret = 0;
+
+out:
+        STACK_UNWIND_STRICT (fsync, frame, op_ret, op_errno, &cb->prebuf,
+                             &postbuf, NULL);
+}
+
+
+static void
+posix_io_uring_fallocate_complete (struct posix_io_uring_cb *cb, int res)
+{
+        call_frame_t *frame = cb->frame;
+        xlator_t     *this = frame->this;
+        struct iatt   postbuf = {0,};
+        int           op_ret = -1;
+        int           op_errno = 0;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_msg (this->name, GF_LOG_ERROR, op_errno,
+                        P_MSG_FALLOCATE_FAILED,
+                        "fallocate failed on %s offset: %jd, len:%zu",
+                        uuid_utoa (cb->fd->inode->gfid), cb->offset, cb->size);
+                goto out;
+        }
+
+        if (posix_fdstat (this, cb->fd->inode, cb->_fd, &postbuf) != 0) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
+                        "fallocate (fstat) failed on fd=%p", cb->fd);
+                goto out;
+        }
+
+        posix_set_ctime (frame, this, NULL, cb->_fd, cb->fd->inode, &postbuf);
+
+        op_ret = 0;
+
+out:
+        if (cb->op == GF_FOP_DISCARD)
+                STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno,
+                                     &cb->prebuf, &postbuf, cb->rsp_xdata);
+        else
+                STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno,
+                                     &cb->prebuf, &postbuf, cb->rsp_xdata);
+}
+
+
+static void
+posix_io_uring_complete (struct posix_io_uring_cb *cb, int res)
+{
+        switch (cb->op) {
+        case GF_FOP_READ:
+                posix_io_uring_readv_complete (cb, res);
+                break;
+        case GF_FOP_WRITE:
+                posix_io_uring_writev_complete (cb, res);
+                break;
+        case GF_FOP_FSYNC:
+                posix_io_uring_fsync_complete (cb, res);
+                break;
+        case GF_FOP_FALLOCATE:
+        case GF_FOP_DISCARD:
+                posix_io_uring_fallocate_complete (cb, res);
+                break;
+        default:
+                gf_msg (THIS->name, GF_LOG_ERROR, 0, P_MSG_UNKNOWN_OP,
+                        "unknown op %d found in io_uring cb", cb->op);
+                break;
+        }
+
+        posix_io_uring_cb_free (cb);
+}
+
+
+/* Executes the request described by sqe synchronously, used when the ring
+ * is full. */
+static int
+posix_io_uring_sync (struct io_uring_sqe *sqe)
+{
+        int ret = -1;
+
+        switch (sqe->opcode) {
+        case IORING_OP_READV:
+                ret = preadv (sqe->fd, (struct iovec *)(uintptr_t)sqe->addr,
+                              sqe->len, sqe->off);
+                break;
+        case IORING_OP_WRITEV:
+                ret = pwritev (sqe->fd, (struct iovec *)(uintptr_t)sqe->addr,
+                               sqe->len, sqe->off);
+                if ((ret >= 0) && sqe->rw_flags && (sys_fsync (sqe->fd) != 0))
+                        ret = -1;
+                break;
+        case IORING_OP_FSYNC:
+                if (sqe->fsync_flags & IORING_FSYNC_DATASYNC)
+                        ret = sys_fdatasync (sqe->fd);
+                else
+                        ret = sys_fsync (sqe->fd);
+                break;
+        case IORING_OP_FALLOCATE:
+                ret = sys_fallocate (sqe->fd, sqe->len, sqe->off, sqe->addr);
+                break;
+        default:
+                errno = EOPNOTSUPP;
+                break;
+        }
+
+        return (ret < 0) ? -errno : ret;
+}
+
+
+/* Takes back the requests that the kernel hasn't consumed from the
+ * submission queue and executes them synchronously. Called with the ring
+ * lock held by the submitting thread, which drops it while it executes
+ * each request. */
+static void
+posix_io_uring_unqueue (struct posix_io_uring *uring)
+{
+        struct io_uring_sqe sqe = {0,};
+        uint32_t            tail = 0;
+
+        for (;;) {
+                tail = *uring->sq_tail;
+                if (tail == __atomic_load_n (uring->sq_head, __ATOMIC_ACQUIRE))
+                        break;
+
+                tail--;
+                sqe = uring->sqes[uring->sq_array[tail & uring->sq_mask]];
+                __atomic_store_n (uring->sq_tail, tail, __ATOMIC_RELEASE);
+                uring->inflight--;
+
+                /* the wake-up nop of fini has no callback */
+                if (!sqe.user_data)
+                        continue;
+
+                pthread_mutex_unlock (&uring->lock);
+                posix_io_uring_complete ((void *)(uintptr_t)sqe.user_data,
+                                         posix_io_uring_sync (&sqe));
+                pthread_mutex_lock (&uring->lock);
+        }
+
+        uring->pending = 0;
+}
+
+
+/* Queues sqe in the ring. When no other thread is submitting, this one
+ * hands all queued requests to the kernel, including the ones other
+ * threads add while it's inside io_uring_enter (). */
+static int
+posix_io_uring_queue (struct posix_io_uring *uring, struct io_uring_sqe *sqe)
+{
+        uint32_t tail = 0;
+        uint32_t head = 0;
+        uint32_t idx = 0;
+        uint32_t count = 0;
+        int      ret = 0;
+
+        pthread_mutex_lock (&uring->lock);
+
+        tail = *uring->sq_tail;
+        head = __atomic_load_n (uring->sq_head, __ATOMIC_ACQUIRE);
+        if ((tail - head >= uring->sq_entries) ||
+            (uring->inflight >= uring->cq_entries) || uring->stopping) {
+                pthread_mutex_unlock (&uring->lock);
+                return -EAGAIN;
+        }
+
+        idx = tail & uring->sq_mask;
+        uring->sqes[idx] = *sqe;
+        uring->sq_array[idx] = idx;
+        __atomic_store_n (uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        uring->pending++;
+        uring->inflight++;
+
+        if (uring->submitting)
+                goto unlock;
+
+        uring->submitting = _gf_true;
+        while (uring->pending > 0) {
+                count = uring->pending;
+                uring->pending = 0;
+
+                pthread_mutex_unlock (&uring->lock);
+                ret = syscall (__NR_io_uring_enter, uring->fd, count, 0, 0,
+                               NULL, 0);
+                if (ret < 0) {
+                        ret = -errno;
+                        if ((ret == -EINTR) || (ret == -EAGAIN) ||
+                            (ret == -EBUSY)) {
+                                sched_yield ();
+                                ret = 0;
+                        }
+                }
+                pthread_mutex_lock (&uring->lock);
+
+                if (ret < 0) {
+                        gf_msg (THIS->name, GF_LOG_ERROR, -ret,
+                                P_MSG_IO_SUBMIT_FAILED,
+                                "io_uring_enter() failed, executing the "
+                                "queued requests synchronously");
+                        posix_io_uring_unqueue (uring);
+                        continue;
+                }
+
+                /* whatever the kernel didn't take is submitted again */
+                if (ret < count)
+                        uring->pending += count - ret;
+        }
+        uring->submitting = _gf_false;
+
+unlock:
+        pthread_mutex_unlock (&uring->lock);
+
+        return 0;
+}
+
+
+static gf_boolean_t
+posix_io_uring_enabled (struct posix_private *priv)
+{
+        return priv->io_uring_configured && priv->io_uring_capable;
+}
+
+
+/* Queues the request in the ring of the brick, or executes it right away
+ * when the ring is gone, doesn't support the operation or is full. */
+static int
+posix_io_uring_submit (xlator_t *this, struct posix_io_uring_cb *cb,
+                       struct io_uring_sqe *sqe)
+{
+        struct posix_private  *priv = this->private;
+        struct posix_io_uring *uring = NULL;
+
+        sqe->user_data = (uintptr_t)cb;
+
+        LOCK (&priv->lock);
+        {
+                uring = priv->io_uring;
+                if (uring)
+                        uring->users++;
+        }
+        UNLOCK (&priv->lock);
+
+        if (!uring || !uring->ops[sqe->opcode] ||
+            (posix_io_uring_queue (uring, sqe) != 0))
+                posix_io_uring_complete (cb, posix_io_uring_sync (sqe));
+
+        if (uring) {
+                LOCK (&priv->lock);
+                {
+                        uring->users--;
+                }
+                UNLOCK (&priv->lock);
+        }
+
+        return 0;
+}
+
+
+void *
+posix_io_uring_thread (void *data)
+{
+        xlator_t                 *this = NULL;
+        struct posix_io_uring    *uring = NULL;
+        struct posix_io_uring_cb *cbs[POSIX_IO_URING_MAX_REAP];
+        int                       res[POSIX_IO_URING_MAX_REAP];
+        struct io_uring_cqe      *cqe = NULL;
+        uint32_t                  head = 0;
+        uint32_t                  tail = 0;
+        int                       count = 0;
+        int                       ret = 0;
+        int                       i = 0;
+        gf_boolean_t              done = _gf_false;
+
+        uring = data;
+        this = uring->this;
+        THIS = this;
+
+        while (!done) {
+                head = *uring->cq_head;
+                tail = __atomic_load_n (uring->cq_tail, __ATOMIC_ACQUIRE);
+                if (head == tail) {
+                        ret = syscall (__NR_io_uring_enter, uring->fd, 0, 1,
+                                       IORING_ENTER_GETEVENTS, NULL, 0);
+                        if ((ret < 0) && (errno != EINTR)) {
+                                gf_msg (this->name, GF_LOG_ERROR, errno,
+                                        P_MSG_IO_GETEVENTS_FAILED,
+                                        "io_uring_enter() failed");
+                                if (errno == EBADF)
+                                        break;
+                        }
+                        continue;
+                }
+
+                /* copy the completions out so that the kernel can reuse
+                 * their slots while the fops are being finished */
+                for (count = 0; (head != tail) &&
+                                (count < POSIX_IO_URING_MAX_REAP); count++) {
+                        cqe = &uring->cqes[head & uring->cq_mask];
+                        cbs[count] = (void *)(uintptr_t)cqe->user_data;
+                        res[count] = cqe->res;
+                        head++;
+                }
+                __atomic_store_n (uring->cq_head, head, __ATOMIC_RELEASE);
+
+                pthread_mutex_lock (&uring->lock);
+                {
+                        uring->inflight -= count;
+                        if (uring->stopping && (uring->inflight == 0))
+                                done = _gf_true;
+                }
+                pthread_mutex_unlock (&uring->lock);
+
+                for (i = 0; i < count; i++) {
+                        if (cbs[i])
+                                posix_io_uring_complete (cbs[i], res[i]);
+                }
+        }
+
+        return NULL;
+}
+
+
+int
+posix_io_uring_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      size_t size, off_t offset, uint32_t flags, dict_t *xdata)
+{
+        int32_t                   op_errno = EINVAL;
+        int                       _fd = -1;
+        struct iobuf             *iobuf = NULL;
+        struct posix_fd          *pfd = NULL;
+        struct iatt               preop = {0,};
+        dict_t                   *rsp_xdata = NULL;
+        struct posix_io_uring_cb *cb = NULL;
+        struct io_uring_sqe       sqe = {0,};
+        int                       ret = -1;
+
+        if (!posix_io_uring_enabled (this->private))
+                return -1;
+
+        ret = posix_fd_ctx_get (fd, this, &pfd, &op_errno);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
+                        "pfd is NULL from fd=%p", fd);
+                goto err;
+        }
+        _fd = pfd->fd;
+
+        if (!size) {
+                op_errno = EINVAL;
+                gf_msg (this->name, GF_LOG_WARNING, op_errno,
+                        P_MSG_INVALID_ARGUMENT, "size=%"GF_PRI_SIZET, size);
+                goto err;
+        }
+
+        iobuf = iobuf_get_page_aligned (this->ctx->iobuf_pool, size,
+                                        ALIGN_SIZE);
+        if (!iobuf) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        if (xdata) {
+                if (posix_fdstat (this, fd->inode, _fd, &preop) == -1) {
+                        op_errno = errno;
+                        gf_msg (this->name, GF_LOG_ERROR, errno,
+                                P_MSG_FSTAT_FAILED,
+                                "pre-operation fstat failed on fd=%p", fd);
+                        goto err;
+                }
+                if (posix_cs_maintenance (this, fd, NULL, &_fd, &preop, NULL,
+                                          xdata, &rsp_xdata, _gf_false) < 0) {
+                        gf_msg (this->name, GF_LOG_ERROR, 0, 0,
+                                "file state check failed, fd %p", fd);
+                        op_errno = EIO;
+                        goto err;
+                }
+        }
+
+        cb = posix_io_uring_cb_new (frame, fd, _fd, GF_FOP_READ, 1);
+        if (!cb) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+        cb->iobuf = iobuf;
+        cb->rsp_xdata = rsp_xdata;
+        cb->offset = offset;
+        cb->size = size;
+        cb->vector[0].iov_base = iobuf_ptr (iobuf);
+        cb->vector[0].iov_len = size;
+
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = _fd;
+        sqe.addr = (uintptr_t)cb->vector;
+        sqe.len = 1;
+        sqe.off = offset;
+
+        return posix_io_uring_submit (this, cb, &sqe);
+
+err:
+        STACK_UNWIND_STRICT (readv, frame, -1, op_errno, NULL, 0, NULL, NULL,
+                             rsp_xdata);
+        if (iobuf)
+                iobuf_unref (iobuf);
+        if (rsp_xdata)
+                dict_unref (rsp_xdata);
+
+        return 0;
+}
+
+
+int
+posix_io_uring_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       struct iovec *vector, int32_t count, off_t offset,
+                       uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+        int32_t                   op_errno = 0;
+        int                       _fd = -1;
+        struct posix_private     *priv = NULL;
+        struct posix_fd          *pfd = NULL;
+        dict_t                   *rsp_xdata = NULL;
+        struct posix_io_uring_cb *cb = NULL;
+        struct io_uring_sqe       sqe = {0,};
+        int                       ret = -1;
+
+        priv = this->private;
+        if (!posix_io_uring_enabled (priv))
+                return -1;
+
+        /* O_DIRECT writes may need bounce buffers, and the atomic variants
+         * must hold the inode's write lock from the prestat to the
+         * poststat. */
+        if (xdata && (dict_get (xdata, GLUSTERFS_WRITE_IS_APPEND) ||
+                      dict_get (xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC)))
+                return -1;
+
+        ret = posix_fd_ctx_get (fd, this, &pfd, &op_errno);
+        if ((ret == 0) && (pfd->flags & O_DIRECT))
+                return -1;
+
+        DISK_SPACE_CHECK_AND_GOTO (frame, priv, xdata, op_errno, op_errno, err);
+
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
+                        "pfd is NULL from fd=%p", fd);
+                goto err;
+        }
+        _fd = pfd->fd;
+
+        if (posix_check_internal_writes (this, fd, _fd, xdata) < 0) {
+                gf_msg (this->name, GF_LOG_ERROR, 0, 0,
+                        "possible overwrite from internal client, fd=%p", fd);
+                op_errno = EBUSY;
+                goto err;
+        }
+
+        cb = posix_io_uring_cb_new (frame, fd, _fd, GF_FOP_WRITE, count);
+        if (!cb) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        if (posix_fdstat (this, fd->inode, _fd, &cb->prebuf) == -1) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_ERROR, errno, P_MSG_FSTAT_FAILED,
+                        "pre-operation fstat failed on fd=%p", fd);
+                goto err;
+        }
+
+        if (xdata) {
+                if (posix_cs_maintenance (this, fd, NULL, &_fd, &cb->prebuf,
+                                          NULL, xdata, &rsp_xdata,
+                                          _gf_false) < 0) {
+                        gf_msg (this->name, GF_LOG_ERROR, 0, 0,
+                                "file state check failed, fd %p", fd);
+                        op_errno = EIO;
+                        goto err;
+                }
+                cb->_fd = _fd;
+                cb->xdata = dict_ref (xdata);
+        }
+
+        memcpy (cb->vector, vector, count * sizeof (*vector));
+        cb->iobref = iobref_ref (iobref);
+        cb->offset = offset;
+        cb->size = iov_length (vector, count);
+
+        sqe.opcode = IORING_OP_WRITEV;
+        sqe.fd = _fd;
+        sqe.addr = (uintptr_t)cb->vector;
+        sqe.len = count;
+        sqe.off = offset;
+        if (flags & (O_SYNC|O_DSYNC))
+                sqe.rw_flags = RWF_SYNC;
+
+        if (rsp_xdata)
+                dict_unref (rsp_xdata);
+
+        return posix_io_uring_submit (this, cb, &sqe);
+
+err:
+        STACK_UNWIND_STRICT (writev, frame, -1, op_errno, NULL, NULL,
+                             rsp_xdata);
+        if (rsp_xdata)
+                dict_unref (rsp_xdata);
+        if (cb)
+                posix_io_uring_cb_free (cb);
+
+        return 0;
+}
+
+
+int
+posix_io_uring_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      int32_t datasync, dict_t *xdata)
+{
+        int32_t                   op_errno = 0;
+        struct posix_private     *priv = NULL;
+        struct posix_fd          *pfd = NULL;
+        struct posix_io_uring_cb *cb = NULL;
+        struct io_uring_sqe       sqe = {0,};
+        int                       ret = -1;
+
+        priv = this->private;
+        if (!posix_io_uring_enabled (priv))
+                return -1;
+
+        if (priv->batch_fsync_mode == BATCH_GROUP_COMMIT ||
+            (priv->batch_fsync_mode && xdata &&
+             dict_get (xdata, "batch-fsync")))
+                return -1;
+
+        ret = posix_fd_ctx_get (fd, this, &pfd, &op_errno);
+        if (ret < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
+                        "pfd not found in fd's ctx");
+                goto err;
+        }
+
+        cb = posix_io_uring_cb_new (frame, fd, pfd->fd, GF_FOP_FSYNC, 0);
+        if (!cb) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        if (posix_fdstat (this, fd->inode, pfd->fd, &cb->prebuf) == -1) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_WARNING, errno, P_MSG_FSTAT_FAILED,
+                        "pre-operation fstat failed on fd=%p", fd);
+                goto err;
+        }
+
+        sqe.opcode = IORING_OP_FSYNC;
+        sqe.fd = pfd->fd;
+        if (datasync)
+                sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+
+        return posix_io_uring_submit (this, cb, &sqe);
+
+err:
+        STACK_UNWIND_STRICT (fsync, frame, -1, op_errno, NULL, NULL, NULL);
+        if (cb)
+                posix_io_uring_cb_free (cb);
+
+        return 0;
+}
+
+
+static int
+posix_io_uring_do_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                             glusterfs_fop_t op, int32_t flags, off_t offset,
+                             size_t len, dict_t *xdata)
+{
+        int32_t                   op_errno = 0;
+        struct posix_private     *priv = NULL;
+        struct posix_fd          *pfd = NULL;
+        dict_t                   *rsp_xdata = NULL;
+        struct posix_io_uring_cb *cb = NULL;
+        struct io_uring_sqe       sqe = {0,};
+        int                       _fd = -1;
+        int                       ret = -1;
+
+        priv = this->private;
+
+        /* see posix_do_fallocate () */
+        if (priv->disk_reserve)
+                posix_disk_space_check (this);
+
+        DISK_SPACE_CHECK_AND_GOTO (frame, priv, xdata, op_errno, op_errno, err);
+
+        ret = posix_fd_ctx_get (fd, this, &pfd, &op_errno);
+        if (ret < 0) {
+                gf_msg_debug (this->name, 0, "pfd is NULL from fd=%p", fd);
+                goto err;
+        }
+        _fd = pfd->fd;
+
+        cb = posix_io_uring_cb_new (frame, fd, _fd, op, 0);
+        if (!cb) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        if (posix_fdstat (this, fd->inode, _fd, &cb->prebuf) == -1) {
+                op_errno = errno;
+                gf_msg (this->name, GF_LOG_ERROR, errno, P_MSG_FSTAT_FAILED,
+                        "fallocate (fstat) failed on fd=%p", fd);
+                goto err;
+        }
+
+        if (xdata) {
+                if (posix_cs_maintenance (this, fd, NULL, &_fd, &cb->prebuf,
+                                          NULL, xdata, &rsp_xdata,
+                                          _gf_false) < 0) {
+                        gf_msg (this->name, GF_LOG_ERROR, 0, 0,
+                                "file state check failed, fd %p", fd);
+                        op_errno = EIO;
+                        goto err;
+                }
+                cb->_fd = _fd;
+                cb->rsp_xdata = rsp_xdata;
+                rsp_xdata = NULL;
+        }
+
+        cb->offset = offset;
+        cb->size = len;
+
+        sqe.opcode = IORING_OP_FALLOCATE;
+        sqe.fd = _fd;
+        sqe.off = offset;
+        sqe.addr = len;
+        sqe.len = flags;
+
+        return posix_io_uring_submit (this, cb, &sqe);
+
+err:
+        if (op == GF_FOP_DISCARD)
+                STACK_UNWIND_STRICT (discard, frame, -1, op_errno, NULL, NULL,
+                                     rsp_xdata);
+        else
+                STACK_UNWIND_STRICT (fallocate, frame, -1, op_errno, NULL,
+                                     NULL, rsp_xdata);
+        if (rsp_xdata)
+                dict_unref (rsp_xdata);
+        if (cb)
+                posix_io_uring_cb_free (cb);
+
+        return 0;
+}
+
+
+int32_t
+posix_io_uring_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          int32_t keep_size, off_t offset, size_t len,
+                          dict_t *xdata)
+{
+        if (!posix_io_uring_enabled (this->private) ||
+            (xdata && dict_get (xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC)))
+                return -1;
+
+        return posix_io_uring_do_fallocate (frame, this, fd, GF_FOP_FALLOCATE,
+                                            keep_size ? FALLOC_FL_KEEP_SIZE
+                                                      : 0,
+                                            offset, len, xdata);
+}
+
+
+int32_t
+posix_io_uring_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                        off_t offset, size_t len, dict_t *xdata)
+{
+        if (!posix_io_uring_enabled (this->private) ||
+            (xdata && dict_get (xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC)))
+                return -1;
+
+        return posix_io_uring_do_fallocate (frame, this, fd, GF_FOP_DISCARD,
+                                            FALLOC_FL_KEEP_SIZE |
+                                            FALLOC_FL_PUNCH_HOLE,
+                                            offset, len, xdata);
+}
+
+
+static void
+posix_io_uring_destroy (struct posix_io_uring *uring)
+{
+        if (uring->sqes)
+                munmap (uring->sqes, uring->sqes_size);
+        if (uring->cq_ring && (uring->cq_ring != uring->sq_ring))
+                munmap (uring->cq_ring, uring->cq_ring_size);
+        if (uring->sq_ring)
+                munmap (uring->sq_ring, uring->sq_ring_size);
+        if (uring->fd >= 0)
+                sys_close (uring->fd);
+
+        pthread_mutex_destroy (&uring->lock);
+        GF_FREE (uring);
+}
+
+
+static void
+posix_io_uring_probe (xlator_t *this, struct posix_io_uring *uring)
+{
+        struct io_uring_probe *probe = NULL;
+        int                    ret = 0;
+        int                    i = 0;
+
+        /* kernels without IORING_REGISTER_PROBE (before 5.6) have no
+         * IORING_OP_FALLOCATE either */
+        uring->ops[IORING_OP_READV] = _gf_true;
+        uring->ops[IORING_OP_WRITEV] = _gf_true;
+        uring->ops[IORING_OP_FSYNC] = _gf_true;
+
+        probe = GF_CALLOC (1, sizeof (*probe) +
+                           IORING_OP_LAST * sizeof (struct io_uring_probe_op),
+                           gf_posix_mt_io_uring);
+        if (!probe)
+                return;
+
+        ret = syscall (__NR_io_uring_register, uring->fd,
+                       IORING_REGISTER_PROBE, probe, IORING_OP_LAST);
+        if (ret == 0) {
+                for (i = 0; (i < probe->ops_len) && (i < IORING_OP_LAST);
+                     i++)
+                        uring->ops[i] = !!(probe->ops[i].flags &
+                                           IO_URING_OP_SUPPORTED);
+        }
+
+        GF_FREE (probe);
+}
+
+
+static int
+posix_io_uring_init (xlator_t *this)
+{
+        struct posix_private   *priv = NULL;
+        struct posix_io_uring  *uring = NULL;
+        struct io_uring_params  params = {0,};
+        void                   *ptr = NULL;
+        int                     ret = -1;
+
+        priv = this->private;
+
+        uring = GF_CALLOC (1, sizeof (*uring), gf_posix_mt_io_uring);
+        if (!uring)
+                goto out;
+        uring->fd = -1;
+        pthread_mutex_init (&uring->lock, NULL);
+
+        uring->fd = syscall (__NR_io_uring_setup, POSIX_IO_URING_ENTRIES,
+                             &params);
+        if (uring->fd < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        P_MSG_IO_URING_UNAVAILABLE,
+                        "io_uring not available at run-time."
+                        " Continuing with synchronous IO");
+                goto out;
+        }
+
+        uring->sq_ring_size = params.sq_off.array +
+                              params.sq_entries * sizeof (uint32_t);
+        uring->cq_ring_size = params.cq_off.cqes +
+                              params.cq_entries * sizeof (struct io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                if (uring->cq_ring_size > uring->sq_ring_size)
+                        uring->sq_ring_size = uring->cq_ring_size;
+                uring->cq_ring_size = uring->sq_ring_size;
+        }
+
+        ptr = mmap (NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+        if (ptr == MAP_FAILED)
+                goto mmap_failed;
+        uring->sq_ring = ptr;
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                uring->cq_ring = uring->sq_ring;
+        } else {
+                ptr = mmap (NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, uring->fd,
+                            IORING_OFF_CQ_RING);
+                if (ptr == MAP_FAILED)
+                        goto mmap_failed;
+                uring->cq_ring = ptr;
+        }
+
+        uring->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+        ptr = mmap (NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+        if (ptr == MAP_FAILED)
+                goto mmap_failed;
+        uring->sqes = ptr;
+
+        ptr = uring->sq_ring;
+        uring->sq_head = ptr + params.sq_off.head;
+        uring->sq_tail = ptr + params.sq_off.tail;
+        uring->sq_mask = *(uint32_t *)(ptr + params.sq_off.ring_mask);
+        uring->sq_entries = *(uint32_t *)(ptr + params.sq_off.ring_entries);
+        uring->sq_array = ptr + params.sq_off.array;
+
+        ptr = uring->cq_ring;
+        uring->cq_head = ptr + params.cq_off.head;
+        uring->cq_tail = ptr + params.cq_off.tail;
+        uring->cq_mask = *(uint32_t *)(ptr + params.cq_off.ring_mask);
+        uring->cq_entries = *(uint32_t *)(ptr + params.cq_off.ring_entries);
+        uring->cqes = ptr + params.cq_off.cqes;
+
+        posix_io_uring_probe (this, uring);
+
+        uring->this = this;
+        ret = gf_thread_create (&uring->thread, NULL, posix_io_uring_thread,
+                                uring, "posixuring");
+        if (ret != 0)
+                goto out;
+
+        LOCK (&priv->lock);
+        {
+                priv->io_uring = uring;
+        }
+        UNLOCK (&priv->lock);
+
+        return 0;
+
+mmap_failed:
+        gf_msg (this->name, GF_LOG_WARNING, errno, P_MSG_IO_URING_UNAVAILABLE,
+                "mapping the io_uring failed. Continuing with synchronous IO");
+out:
+        if (uring)
+                posix_io_uring_destroy (uring);
+
+        return -1;
+}
+
+
+int
+posix_io_uring_on (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        if (!priv->io_uring_init_done) {
+                priv->io_uring_capable = (posix_io_uring_init (this) == 0);
+                priv->io_uring_init_done = _gf_true;
+        }
+
+        return 0;
+}
+
+
+void
+posix_io_uring_fini (xlator_t *this)
+{
+        struct posix_private  *priv = NULL;
+        struct posix_io_uring *uring = NULL;
+        struct io_uring_sqe    sqe = {0,};
+        uint32_t               tail = 0;
+        uint32_t               count = 0;
+
+        priv = this->private;
+
+        /* New requests are executed synchronously from now on. Wait for the
+         * threads that are queueing requests in the ring to be done. */
+        LOCK (&priv->lock);
+        {
+                uring = priv->io_uring;
+                priv->io_uring = NULL;
+                priv->io_uring_capable = _gf_false;
+        }
+        UNLOCK (&priv->lock);
+
+        if (!uring)
+                return;
+
+        for (;;) {
+                LOCK (&priv->lock);
+                {
+                        count = uring->users;
+                }
+                UNLOCK (&priv->lock);
+                if (count == 0)
+                        break;
+                sched_yield ();
+        }
+
+        /* A nop without callback wakes up the ring thread, which exits once
+         * everything in flight has completed. */
+        pthread_mutex_lock (&uring->lock);
+        {
+                uring->stopping = _gf_true;
+                uring->inflight++;
+
+                sqe.opcode = IORING_OP_NOP;
+                tail = *uring->sq_tail;
+                uring->sqes[tail & uring->sq_mask] = sqe;
+                uring->sq_array[tail & uring->sq_mask] = tail & uring->sq_mask;
+                __atomic_store_n (uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+                uring->pending++;
+                while (uring->submitting) {
+                        pthread_mutex_unlock (&uring->lock);
+                        sched_yield ();
+                        pthread_mutex_lock (&uring->lock);
+                }
+                count = uring->pending;
+                uring->pending = 0;
+        }
+        pthread_mutex_unlock (&uring->lock);
+
+        while ((syscall (__NR_io_uring_enter, uring->fd, count, 0, 0, NULL,
+                         0) < 0) && ((errno == EINTR) || (errno == EAGAIN)))
+                sched_yield ();
+
+        pthread_join (uring->thread, NULL);
+
+        priv->io_uring_init_done = _gf_false;
+
+        posix_io_uring_destroy (uring);
+}
+
+
+#else
+
+
+int
+posix_io_uring_on (xlator_t *this)
+{
+        gf_msg (this->name, GF_LOG_INFO, 0, P_MSG_IO_URING_UNAVAILABLE,
+                "io_uring not available at build-time."
+                " Continuing with synchronous IO");
+        return 0;
+}
+
+int
+posix_io_uring_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      size_t size, off_t offset, uint32_t flags, dict_t *xdata)
+{
+        return -1;
+}
+
+int
+posix_io_uring_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       struct iovec *vector, int32_t count, off_t offset,
+                       uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+        return -1;
+}
+
+int
+posix_io_uring_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      int32_t datasync, dict_t *xdata)
+{
+        return -1;
+}
+
+int32_t
+posix_io_uring_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          int32_t keep_size, off_t offset, size_t len,
+                          dict_t *xdata)
+{
+        return -1;
+}
+
+int32_t
+posix_io_uring_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                        off_t offset, size_t len, dict_t *xdata)
+{
+        return -1;
+}
+
+void
+posix_io_uring_fini (xlator_t *this)
+{
+        return;
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _POSIX_IO_URING_H
+#define _POSIX_IO_URING_H
+
+#include "xlator.h"
+#include "glusterfs.h"
+
+/* Number of submission queue entries of the ring. The completion queue is
+ * twice as large and also bounds the number of requests in flight, when the
+ * ring is full requests are executed synchronously by the calling thread. */
+#define POSIX_IO_URING_ENTRIES 256
+
+/* Maximum number of completions reaped before they are processed */
+#define POSIX_IO_URING_MAX_REAP 32
+
+
+int posix_io_uring_on (xlator_t *this);
+void posix_io_uring_fini (xlator_t *this);
+
+/* Called first by the posix fops of the same name. They return 0 when the
+ * fop has been taken over and -1, without unwinding, when the caller has to
+ * execute it itself (io_uring disabled, or a request that needs the
+ * synchronous path). */
+int posix_io_uring_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          size_t size, off_t offset, uint32_t flags,
+                          dict_t *xdata);
+int posix_io_uring_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                           struct iovec *vector, int32_t count, off_t offset,
+                           uint32_t flags, struct iobref *iobref,
+                           dict_t *xdata);
+int posix_io_uring_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          int32_t datasync, dict_t *xdata);
+int32_t posix_io_uring_fallocate (call_frame_t *frame, xlator_t *this,
+                                  fd_t *fd, int32_t keep_size, off_t offset,
+                                  size_t len, dict_t *xdata);
+int32_t posix_io_uring_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                                off_t offset, size_t len, dict_t *xdata);
+
+#endif /* !_POSIX_IO_URING_H */
@@ -23,6 +23,8 @@ enum gf_posix_mem_types_ {
 	gf_posix_mt_paiocb,
         gf_posix_mt_inode_ctx_t,
         gf_posix_mt_mdata_attr,
+        gf_posix_mt_io_uring,
+        gf_posix_mt_io_uring_cb,
         gf_posix_mt_end
 };
 #endif
@@ -0,0 +1,485 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Hash tree of a file, for self-heal to find the blocks that differ
+ * without a round trip per block.
+ *
+ * The tree is fixed by the leaf size and the fanout the client asks for:
+ * a leaf is the SHA256 of <leaf size> bytes of the file, and a node at
+ * level k covers leaf * fanout^k bytes and is the SHA256 of the digests
+ * of its children. Only children that start before EOF exist, so two
+ * files with the same content have the same tree whatever their size.
+ *
+ * An rchecksum with GF_MERKLE_NODE_SIZE in xdata returns the digests of
+ * the children of the node of that size at the given offset in
+ * GF_MERKLE_DIGESTS, and the digest of the node itself as the strong
+ * checksum.
+ *
+ * Answering for a big node means reading everything below it. With
+ * storage.merkle-cache on, the digests of the level above the leaves are
+ * kept in a file under .glusterfs/merkle, so only the leaves of the nodes
+ * that differ have to be read again. The cache is removed by every fop
+ * that changes the data of the file and with its gfid handle, and is only
+ * used while the size, the inode number and the ctime of the file are the
+ * ones it was built with. Unlike the mtime, the ctime can't be set back by
+ * a client.
+ */
+
+#include <openssl/sha.h>
+#include <sys/file.h>
+
+#include "posix.h"
+#include "posix-merkle.h"
+#include "posix-messages.h"
+#include "syscall.h"
+
+#define POSIX_MERKLE_MAGIC        0x474d4b32    /* "GMK2" */
+#define POSIX_MERKLE_HEADER_SIZE  64
+#define POSIX_MERKLE_DIGEST_SIZE  SHA256_DIGEST_LENGTH
+#define POSIX_MERKLE_ENTRY_SIZE   (1 + POSIX_MERKLE_DIGEST_SIZE)
+#define POSIX_MERKLE_READ_SIZE    (128 * 1024)
+#define POSIX_MERKLE_MAX_FANOUT   1024
+
+struct posix_merkle_header {
+        uint32_t        magic;
+        uint32_t        digest_size;
+        uint64_t        leaf_size;
+        uint32_t        fanout;
+        uint32_t        pad;
+        uint64_t        size;
+        uint64_t        ino;
+        int64_t         ctime;
+        int64_t         ctime_nsec;
+};
+
+struct posix_merkle {
+        xlator_t        *this;
+        fd_t            *fd;
+        struct posix_fd *pfd;
+        int              _fd;
+        char            *buf;
+        uint64_t         leaf_size;
+        uint32_t         fanout;
+        struct stat      stbuf;
+};
+
+static ssize_t
+posix_merkle_pread (struct posix_merkle *mk, size_t len, off_t offset)
+{
+        struct posix_private *priv = mk->this->private;
+        ssize_t               ret  = 0;
+
+        LOCK (&mk->fd->lock);
+        {
+                if (priv->aio_capable && priv->aio_init_done)
+                        __posix_fd_set_odirect (mk->fd, mk->pfd, 0, offset,
+                                                len);
+
+                ret = sys_pread (mk->_fd, mk->buf, len, offset);
+        }
+        UNLOCK (&mk->fd->lock);
+
+        return ret;
+}
+
+static int
+posix_merkle_leaf (struct posix_merkle *mk, off_t offset,
+                   unsigned char *digest)
+{
+        SHA256_CTX      ctx;
+        off_t           end = 0;
+        ssize_t         ret = 0;
+
+        end = min (offset + mk->leaf_size, mk->stbuf.st_size);
+
+        SHA256_Init (&ctx);
+        while (offset < end) {
+                ret = posix_merkle_pread (mk, min (end - offset,
+                                                   POSIX_MERKLE_READ_SIZE),
+                                          offset);
+                if (ret < 0)
+                        return -errno;
+                if (ret == 0)
+                        break;
+
+                SHA256_Update (&ctx, mk->buf, ret);
+                offset += ret;
+        }
+        SHA256_Final (digest, &ctx);
+
+        return 0;
+}
+
+/* Replaces the digests of <count> nodes by those of their parents. */
+static uint64_t
+posix_merkle_fold (struct posix_merkle *mk, unsigned char *digests,
+                   uint64_t count)
+{
+        unsigned char   parent[POSIX_MERKLE_DIGEST_SIZE];
+        uint64_t        i = 0;
+        uint64_t        n = 0;
+
+        for (i = 0; i < count; i += mk->fanout, n++) {
+                SHA256 (digests + i * POSIX_MERKLE_DIGEST_SIZE,
+                        min (mk->fanout, count - i) * POSIX_MERKLE_DIGEST_SIZE,
+                        parent);
+                memcpy (digests + n * POSIX_MERKLE_DIGEST_SIZE, parent,
+                        POSIX_MERKLE_DIGEST_SIZE);
+        }
+
+        return n;
+}
+
+/* Digests of <count> nodes of <leaf size> * fanout bytes from <offset>. */
+static int
+posix_merkle_level1 (struct posix_merkle *mk, off_t offset, uint64_t count,
+                     unsigned char *digests)
+{
+        unsigned char   *leaves = NULL;
+        off_t            leaf   = 0;
+        uint64_t         i      = 0;
+        uint32_t         j      = 0;
+        int              ret    = 0;
+
+        leaves = GF_MALLOC (mk->fanout * POSIX_MERKLE_DIGEST_SIZE,
+                            gf_posix_mt_char);
+        if (!leaves)
+                return -ENOMEM;
+
+        for (i = 0; i < count; i++) {
+                leaf = offset + i * mk->leaf_size * mk->fanout;
+                for (j = 0; j < mk->fanout && leaf < mk->stbuf.st_size;
+                     j++, leaf += mk->leaf_size) {
+                        ret = posix_merkle_leaf (mk, leaf, leaves +
+                                                 j * POSIX_MERKLE_DIGEST_SIZE);
+                        if (ret)
+                                goto out;
+                }
+                SHA256 (leaves, j * POSIX_MERKLE_DIGEST_SIZE,
+                        digests + i * POSIX_MERKLE_DIGEST_SIZE);
+        }
+out:
+        GF_FREE (leaves);
+        return ret;
+}
+
+static int
+posix_merkle_cache_open (struct posix_merkle *mk, gf_boolean_t create)
+{
+        struct posix_private *priv = mk->this->private;
+        char                 *path = NULL;
+        char                 *dir  = NULL;
+        int                   fd   = -1;
+
+        if (gf_asprintf (&path, "%s/%s/%s", priv->base_path,
+                         POSIX_MERKLE_PATH, uuid_utoa (mk->fd->inode->gfid)) < 0)
+                return -1;
+
+        fd = sys_open (path, create ? O_RDWR | O_CREAT : O_RDONLY, 0600);
+        if (fd < 0 && errno == ENOENT && create) {
+                if (gf_asprintf (&dir, "%s/%s", priv->base_path,
+                                 POSIX_MERKLE_PATH) > 0) {
+                        if (sys_mkdir (dir, 0700) == 0 || errno == EEXIST)
+                                fd = sys_open (path, O_RDWR | O_CREAT, 0600);
+                        GF_FREE (dir);
+                }
+        }
+        if (fd >= 0 && create)
+                priv->merkle_cache_present = _gf_true;
+        else if (fd < 0 && (create || errno != ENOENT))
+                gf_msg (mk->this->name, GF_LOG_WARNING, errno,
+                        P_MSG_MERKLE_CACHE_FAILED, "open of %s failed", path);
+
+        GF_FREE (path);
+        return fd;
+}
+
+static void
+posix_merkle_cache_mark (xlator_t *this, inode_t *inode)
+{
+        posix_inode_ctx_t *ctx = NULL;
+
+        if (posix_inode_ctx_get_all (inode, this, &ctx) == 0)
+                ctx->merkle_cache = POSIX_MERKLE_CACHE_PRESENT;
+}
+
+static gf_boolean_t
+posix_merkle_cache_matches (struct posix_merkle *mk,
+                            struct posix_merkle_header *header)
+{
+        return header->magic == POSIX_MERKLE_MAGIC &&
+               header->digest_size == POSIX_MERKLE_DIGEST_SIZE &&
+               header->leaf_size == mk->leaf_size &&
+               header->fanout == mk->fanout &&
+               header->size == mk->stbuf.st_size &&
+               header->ino == mk->stbuf.st_ino &&
+               header->ctime == mk->stbuf.st_ctim.tv_sec &&
+               header->ctime_nsec == mk->stbuf.st_ctim.tv_nsec;
+}
+
+static int
+posix_merkle_cache_get (struct posix_merkle *mk, uint64_t first,
+                        uint64_t count, unsigned char *digests)
+{
+        struct posix_merkle_header  header  = {0, };
+        unsigned char              *entries = NULL;
+        size_t                      len     = count * POSIX_MERKLE_ENTRY_SIZE;
+        uint64_t                    i       = 0;
+        int                         fd      = -1;
+        int                         ret     = -1;
+
+        fd = posix_merkle_cache_open (mk, _gf_false);
+        if (fd < 0)
+                return -1;
+
+        entries = GF_MALLOC (len, gf_posix_mt_char);
+        if (!entries)
+                goto out;
+
+        flock (fd, LOCK_SH);
+        if (sys_pread (fd, &header, sizeof (header), 0) != sizeof (header) ||
+            !posix_merkle_cache_matches (mk, &header) ||
+            sys_pread (fd, entries, len, POSIX_MERKLE_HEADER_SIZE +
+                       first * POSIX_MERKLE_ENTRY_SIZE) != len) {
+                flock (fd, LOCK_UN);
+                goto out;
+        }
+        flock (fd, LOCK_UN);
+
+        for (i = 0; i < count; i++) {
+                if (!entries[i * POSIX_MERKLE_ENTRY_SIZE])
+                        goto out;
+                memcpy (digests + i * POSIX_MERKLE_DIGEST_SIZE,
+                        entries + i * POSIX_MERKLE_ENTRY_SIZE + 1,
+                        POSIX_MERKLE_DIGEST_SIZE);
+        }
+        ret = 0;
+out:
+        GF_FREE (entries);
+        sys_close (fd);
+        return ret;
+}
+
+static void
+posix_merkle_cache_put (struct posix_merkle *mk, uint64_t first,
+                        uint64_t count, unsigned char *digests)
+{
+        struct posix_merkle_header  header  = {0, };
+        unsigned char              *entries = NULL;
+        size_t                      len     = count * POSIX_MERKLE_ENTRY_SIZE;
+        uint64_t                    i       = 0;
+        int                         fd      = -1;
+
+        /* a write in the same clock tick would not change the ctime */
+        if (time (NULL) - mk->stbuf.st_ctim.tv_sec < POSIX_MERKLE_SETTLE)
+                return;
+
+        entries = GF_MALLOC (len, gf_posix_mt_char);
+        if (!entries)
+                return;
+        for (i = 0; i < count; i++) {
+                entries[i * POSIX_MERKLE_ENTRY_SIZE] = 1;
+                memcpy (entries + i * POSIX_MERKLE_ENTRY_SIZE + 1,
+                        digests + i * POSIX_MERKLE_DIGEST_SIZE,
+                        POSIX_MERKLE_DIGEST_SIZE);
+        }
+
+        fd = posix_merkle_cache_open (mk, _gf_true);
+        if (fd < 0)
+                goto out;
+
+        flock (fd, LOCK_EX);
+        if (sys_pread (fd, &header, sizeof (header), 0) != sizeof (header) ||
+            !posix_merkle_cache_matches (mk, &header)) {
+                /* built for another version of the file, start over */
+                memset (&header, 0, sizeof (header));
+                header.magic = POSIX_MERKLE_MAGIC;
+                header.digest_size = POSIX_MERKLE_DIGEST_SIZE;
+                header.leaf_size = mk->leaf_size;
+                header.fanout = mk->fanout;
+                header.size = mk->stbuf.st_size;
+                header.ino = mk->stbuf.st_ino;
+                header.ctime = mk->stbuf.st_ctim.tv_sec;
+                header.ctime_nsec = mk->stbuf.st_ctim.tv_nsec;
+                if (sys_ftruncate (fd, 0) ||
+                    sys_pwrite (fd, &header, sizeof (header), 0) !=
+                    sizeof (header))
+                        goto unlock;
+        }
+        if (sys_pwrite (fd, entries, len, POSIX_MERKLE_HEADER_SIZE +
+                        first * POSIX_MERKLE_ENTRY_SIZE) != len)
+                gf_msg (mk->this->name, GF_LOG_WARNING, errno,
+                        P_MSG_MERKLE_CACHE_FAILED,
+                        "write to the hash tree cache of %s failed",
+                        uuid_utoa (mk->fd->inode->gfid));
+        /* once the file is written; a write that raced with us and still
+         * found no cache moves the ctime the file is keyed with */
+        posix_merkle_cache_mark (mk->this, mk->fd->inode);
+unlock:
+        flock (fd, LOCK_UN);
+        sys_close (fd);
+out:
+        GF_FREE (entries);
+}
+
+int
+posix_merkle_rchecksum (xlator_t *this, fd_t *fd, struct posix_fd *pfd,
+                        int _fd, off_t offset, dict_t *xdata,
+                        dict_t *rsp_xdata, unsigned char *digest)
+{
+        struct posix_private *priv      = this->private;
+        struct posix_merkle   mk        = {0, };
+        unsigned char        *digests   = NULL;
+        char                 *alloc_buf = NULL;
+        uint64_t              node      = 0;
+        uint64_t              child     = 0;
+        uint64_t              level1    = 0;
+        uint64_t              size      = 0;
+        uint64_t              count     = 0;
+        uint64_t              i         = 0;
+        off_t                 end       = 0;
+        int                   ret       = 0;
+
+        if (dict_get_uint64 (xdata, GF_MERKLE_LEAF_SIZE, &mk.leaf_size) ||
+            dict_get_uint32 (xdata, GF_MERKLE_FANOUT, &mk.fanout) ||
+            dict_get_uint64 (xdata, GF_MERKLE_NODE_SIZE, &node))
+                return -EINVAL;
+
+        if (!mk.leaf_size || mk.fanout < 2 ||
+            mk.fanout > POSIX_MERKLE_MAX_FANOUT || offset < 0)
+                return -EINVAL;
+
+        /* only nodes of the tree above the leaves */
+        for (size = mk.leaf_size; size < node; size *= mk.fanout) {
+                if (size > UINT64_MAX / mk.fanout)
+                        return -EINVAL;
+        }
+        if (size != node || node == mk.leaf_size || offset % node)
+                return -EINVAL;
+
+        mk.this = this;
+        mk.fd = fd;
+        mk.pfd = pfd;
+        mk._fd = _fd;
+        if (sys_fstat (_fd, &mk.stbuf))
+                return -errno;
+
+        alloc_buf = _page_aligned_alloc (POSIX_MERKLE_READ_SIZE, &mk.buf);
+        if (!alloc_buf)
+                return -ENOMEM;
+
+        child = node / mk.fanout;
+        level1 = mk.leaf_size * mk.fanout;
+        end = min (offset + node, mk.stbuf.st_size);
+
+        if (offset < end) {
+                size = (child == mk.leaf_size) ? child : level1;
+                count = (end - offset + size - 1) / size;
+                digests = GF_MALLOC (count * POSIX_MERKLE_DIGEST_SIZE,
+                                     gf_posix_mt_char);
+                if (!digests) {
+                        ret = -ENOMEM;
+                        goto out;
+                }
+        }
+
+        if (count && child == mk.leaf_size) {
+                for (i = 0; i < count; i++) {
+                        ret = posix_merkle_leaf (&mk, offset + i * child,
+                                                 digests + i *
+                                                 POSIX_MERKLE_DIGEST_SIZE);
+                        if (ret)
+                                goto out;
+                }
+        } else if (count) {
+                if (!priv->merkle_cache ||
+                    posix_merkle_cache_get (&mk, offset / level1, count,
+                                            digests)) {
+                        ret = posix_merkle_level1 (&mk, offset, count,
+                                                   digests);
+                        if (ret)
+                                goto out;
+                        if (priv->merkle_cache)
+                                posix_merkle_cache_put (&mk, offset / level1,
+                                                        count, digests);
+                }
+                for (size = level1; size < child; size *= mk.fanout)
+                        count = posix_merkle_fold (&mk, digests, count);
+        }
+
+        SHA256 (digests ? digests : (unsigned char *)"",
+                count * POSIX_MERKLE_DIGEST_SIZE, digest);
+
+        ret = dict_set_uint64 (rsp_xdata, GF_MERKLE_NODE_SIZE, node);
+        if (ret)
+                goto out;
+        if (count) {
+                ret = dict_set_bin (rsp_xdata, GF_MERKLE_DIGESTS, digests,
+                                    count * POSIX_MERKLE_DIGEST_SIZE);
+                if (ret)
+                        goto out;
+                digests = NULL;
+        }
+out:
+        GF_FREE (digests);
+        GF_FREE (alloc_buf);
+        return ret;
+}
+
+void
+posix_merkle_cache_unlink (xlator_t *this, uuid_t gfid)
+{
+        struct posix_private *priv = this->private;
+        char                 *path = NULL;
+
+        if (!priv->merkle_cache_present)
+                return;
+
+        if (gf_asprintf (&path, "%s/%s/%s", priv->base_path,
+                         POSIX_MERKLE_PATH, uuid_utoa (gfid)) < 0)
+                return;
+
+        if (sys_unlink (path) && errno != ENOENT)
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        P_MSG_MERKLE_CACHE_FAILED, "unlink of %s failed",
+                        path);
+        GF_FREE (path);
+}
+
+/* Called by the fops that change the data of a file, before they do: the
+ * digests are of the old data. Only the first write after the cache was
+ * built, or after the brick started, pays for the unlink. */
+void
+posix_merkle_cache_invalidate (xlator_t *this, inode_t *inode)
+{
+        struct posix_private *priv   = this->private;
+        posix_inode_ctx_t    *ctx    = NULL;
+        int                   cached = POSIX_MERKLE_CACHE_UNKNOWN;
+        int                   ret    = -1;
+
+        if (!priv->merkle_cache_present || !inode)
+                return;
+
+        LOCK (&inode->lock);
+        {
+                ret = __posix_inode_ctx_get_all (inode, this, &ctx);
+                if (ret == 0) {
+                        cached = ctx->merkle_cache;
+                        ctx->merkle_cache = POSIX_MERKLE_CACHE_ABSENT;
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        if (ret == 0 && cached == POSIX_MERKLE_CACHE_ABSENT)
+                return;
+
+        posix_merkle_cache_unlink (this, inode->gfid);
+}
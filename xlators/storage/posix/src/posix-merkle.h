@@ -0,0 +1,39 @@
+/*
+   Copyright (c) 2018 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _POSIX_MERKLE_H
+#define _POSIX_MERKLE_H
+
+#include "xlator.h"
+#include "glusterfs.h"
+
+/* Digests of the first level above the leaves are kept in
+ * .glusterfs/merkle/<gfid> when storage.merkle-cache is on */
+#define POSIX_MERKLE_PATH GF_HIDDEN_PATH"/merkle"
+
+/* Files changed this recently (in seconds) are not cached, their ctime may
+ * not move on the next write */
+#define POSIX_MERKLE_SETTLE 2
+
+/* whether the inode has a cache file, in posix_inode_ctx_t */
+enum {
+        POSIX_MERKLE_CACHE_UNKNOWN = 0,
+        POSIX_MERKLE_CACHE_ABSENT,
+        POSIX_MERKLE_CACHE_PRESENT,
+};
+
+struct posix_fd;
+
+int posix_merkle_rchecksum (xlator_t *this, fd_t *fd, struct posix_fd *pfd,
+                            int _fd, off_t offset, dict_t *xdata,
+                            dict_t *rsp_xdata, unsigned char *digest);
+void posix_merkle_cache_unlink (xlator_t *this, uuid_t gfid);
+void posix_merkle_cache_invalidate (xlator_t *this, inode_t *inode);
+
+#endif /* !_POSIX_MERKLE_H */
@@ -141,7 +141,10 @@ GLFS_MSGID(POSIX,
         P_MSG_FETCHMDATA_FAILED,
         P_MSG_GETMDATA_FAILED,
         P_MSG_SETMDATA_FAILED,
-        P_MSG_FRESHFILE
+        P_MSG_FRESHFILE,
+        P_MSG_IO_URING_UNAVAILABLE,
+        P_MSG_COPY_FILE_RANGE_FAILED,
+        P_MSG_MERKLE_CACHE_FAILED
 );
 
 #endif /* !_GLUSTERD_MESSAGES_H_ */
@@ -80,6 +80,7 @@ struct xlator_fops fops = {
 #endif
         .lease       = posix_lease,
         .put         = posix_put,
+        .copy_file_range = posix_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
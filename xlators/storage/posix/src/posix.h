@@ -44,6 +44,8 @@
 #include "posix-aio.h"
 #endif
 
+#include "posix-io-uring.h"
+
 #define VECTOR_SIZE 64 * 1024 /* vector size 64KB*/
 #define MAX_NO_VECT 1024
 
@@ -62,6 +64,9 @@
                                                + SLEN(GF_HIDDEN_PATH) + SLEN("/") \
                                                + SLEN("00/")            \
                                                + SLEN("00/") + SLEN(UUID0_STR) + 1) /* '\0' */;
+/* log2 buckets of the group-commit batch size and wait time histograms */
+#define POSIX_FSYNC_HIST_BUCKETS 20
+
 #define GF_UNLINK_TRUE 0x0000000000000001
 #define GF_UNLINK_FALSE 0x0000000000000000
 
@@ -203,6 +208,11 @@ struct posix_private {
         pthread_t       aiothread;
 #endif
 
+        gf_boolean_t    io_uring_configured;
+        gf_boolean_t    io_uring_init_done;
+        gf_boolean_t    io_uring_capable;
+        struct posix_io_uring *io_uring;
+
         /* node-uuid in pathinfo xattr */
         gf_boolean_t  node_uuid_pathinfo;
 
@@ -217,10 +227,20 @@ struct posix_private {
 		BATCH_SYNCFS,
 		BATCH_SYNCFS_SINGLE_FSYNC,
 		BATCH_REVERSE_FSYNC,
-		BATCH_SYNCFS_REVERSE_FSYNC
+		BATCH_SYNCFS_REVERSE_FSYNC,
+		BATCH_GROUP_COMMIT
 	}               batch_fsync_mode;
 
 	uint32_t        batch_fsync_delay_usec;
+
+        /* group-commit: the batching window follows how fast fsyncs come
+         * in and how long the device takes to sync a batch */
+        uint64_t        fsync_last_arrival;     /* usec */
+        uint64_t        fsync_interval_usec;    /* ewma of inter-arrival */
+        uint64_t        fsync_latency_usec;     /* ewma of batch sync time */
+        uint64_t        fsync_batches;
+        uint64_t        fsync_batch_hist[POSIX_FSYNC_HIST_BUCKETS];
+        uint64_t        fsync_wait_hist[POSIX_FSYNC_HIST_BUCKETS];
         gf_boolean_t    update_pgfid_nlinks;
         gf_boolean_t    gfid2path;
         char            gfid2path_sep[8];
@@ -263,6 +283,10 @@ struct posix_private {
 
         gf_boolean_t fips_mode_rchecksum;
         gf_boolean_t ctime;
+
+        /* keep hash tree digests in .glusterfs/merkle */
+        gf_boolean_t merkle_cache;
+        gf_boolean_t merkle_cache_present;
 };
 
 typedef struct {
@@ -286,6 +310,7 @@ typedef struct {
         pthread_mutex_t xattrop_lock;
         pthread_mutex_t write_atomic_lock;
         pthread_mutex_t pgfid_lock;
+        int          merkle_cache; /* POSIX_MERKLE_CACHE_* */
 } posix_inode_ctx_t;
 
 #define POSIX_BASE_PATH(this) (((struct posix_private *)this->private)->base_path)
@@ -366,6 +391,7 @@ void posix_spawn_health_check_thread (xlator_t *this);
 void posix_spawn_disk_space_check_thread (xlator_t *this);
 
 void *posix_fsyncer (void *);
+uint64_t posix_fsync_now_usec (void);
 int
 posix_get_ancestry (xlator_t *this, inode_t *leaf_inode,
                     gf_dirent_t *head, char **path, int type, int32_t *op_errno,
@@ -495,6 +521,11 @@ int32_t
 posix_seek (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
             gf_seek_what_t what, dict_t *xdata);
 
+int32_t
+posix_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                       off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                       uint32_t flags, dict_t *xdata);
+
 int32_t
 posix_opendir (call_frame_t *frame, xlator_t *this,
                loc_t *loc, fd_t *fd, dict_t *xdata);
@@ -524,6 +555,9 @@ posix_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
               struct iovec *vector, int32_t count, off_t offset,
               uint32_t flags, struct iobref *iobref, dict_t *xdata);
 
+dict_t*
+_fill_writev_xdata (fd_t *fd, dict_t *xdata, xlator_t *this, int is_append);
+
 int32_t
 posix_statfs (call_frame_t *frame, xlator_t *this,
               loc_t *loc, dict_t *xdata);
@@ -633,6 +667,9 @@ int32_t
 posix_readdirp (call_frame_t *frame, xlator_t *this,
                 fd_t *fd, size_t size, off_t off, dict_t *dict);
 
+char *
+_page_aligned_alloc (size_t size, char **aligned_buf);
+
 int32_t
 posix_rchecksum (call_frame_t *frame, xlator_t *this,
                  fd_t *fd, off_t offset, int32_t len, dict_t *xdata);